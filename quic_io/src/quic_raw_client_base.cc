@@ -29,7 +29,8 @@ QuicRawClientBase::QuicRawClientBase(
                      helper,
                      alarm_factory,
                      std::move(network_helper),
-                     std::move(proof_verifier)) {}
+                     std::move(proof_verifier)),
+      session_visitor_(nullptr) {}
 
 QuicRawClientBase::~QuicRawClientBase() {
   // If we own something. We need to explicitly kill
@@ -57,9 +58,12 @@ void QuicRawClientBase::OnData(QuicRawStream* stream, char* data, size_t len) {
 std::unique_ptr<QuicSession> QuicRawClientBase::CreateQuicClientSession(
     const quic::ParsedQuicVersionVector& supported_versions,
     QuicConnection* connection) {
-  return QuicMakeUnique<QuicRawClientSession>(
-      connection, nullptr, *config(), supported_versions, server_id(),
-      crypto_config());
+  std::unique_ptr<QuicRawClientSession> session =
+      QuicMakeUnique<QuicRawClientSession>(connection, nullptr, *config(),
+                                           supported_versions, server_id(),
+                                           crypto_config());
+  session->set_visitor(session_visitor_);
+  return std::move(session);
 }
 
 
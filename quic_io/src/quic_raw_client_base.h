@@ -61,6 +61,11 @@ class QuicRawClientBase : public QuicClientBase,
   // QuicRawClientSession.
   QuicRawClientSession* client_session();
 
+  // Set on every session created by this client. Not owned.
+  void set_session_visitor(QuicRawClientSession::Visitor* visitor) {
+    session_visitor_ = visitor;
+  }
+
  protected:
   int GetNumSentClientHellosFromSession() override;
   int GetNumReceivedServerConfigUpdatesFromSession() override;
@@ -71,7 +76,7 @@ class QuicRawClientBase : public QuicClientBase,
       QuicConnection* connection) override;
 
  private:
-
+  QuicRawClientSession::Visitor* session_visitor_;
 };
 
 }  // namespace quic
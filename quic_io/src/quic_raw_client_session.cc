@@ -24,7 +24,9 @@ QuicRawClientSession::QuicRawClientSession(
     : QuicSession(connection, visitor, config, supported_versions),
       server_id_(server_id),
       crypto_config_(crypto_config),
-      respect_goaway_(false) {}
+      respect_goaway_(false),
+      receive_window_tuner_(this),
+      visitor_(nullptr) {}
 
 QuicRawClientSession::~QuicRawClientSession() = default;
 
@@ -94,8 +96,10 @@ QuicRawClientSession::CreateOutgoingUnidirectionalStream() {
 std::unique_ptr<QuicRawStream>
 QuicRawClientSession::CreateClientStream() {
     //GetNextOutgoingBidirectionalStreamId
-  return QuicMakeUnique<QuicRawStream>(
+  std::unique_ptr<QuicRawStream> stream = QuicMakeUnique<QuicRawStream>(
       GetNextOutgoingStreamId(), this, BIDIRECTIONAL);
+  stream->set_receive_window_tuner(&receive_window_tuner_);
+  return stream;
 }
 
 QuicCryptoClientStreamBase* QuicRawClientSession::GetMutableCryptoStream() {
@@ -158,6 +162,7 @@ QuicRawStream* QuicRawClientSession::CreateIncomingStream(QuicStreamId id) {
   }
   QuicRawStream* stream =
       new QuicRawStream(id, this, READ_UNIDIRECTIONAL);
+  stream->set_receive_window_tuner(&receive_window_tuner_);
   ActivateStream(QuicWrapUnique(stream));
   return stream;
 }
@@ -170,6 +175,12 @@ QuicRawClientSession::CreateQuicCryptoStream() {
       this);
 }
 
+void QuicRawClientSession::SetMaxReceiveWindows(
+    QuicByteCount max_stream_window,
+    QuicByteCount max_session_window) {
+  receive_window_tuner_.SetMaxWindows(max_stream_window, max_session_window);
+}
+
 void QuicRawClientSession::OnConfigNegotiated() {
   QuicSession::OnConfigNegotiated();
 }
@@ -177,6 +188,18 @@ void QuicRawClientSession::OnConfigNegotiated() {
 void QuicRawClientSession::OnCryptoHandshakeEvent(
     CryptoHandshakeEvent event) {
   QuicSession::OnCryptoHandshakeEvent(event);
+  if (visitor_) {
+    visitor_->OnHandshakeProgress(this);
+  }
+}
+
+void QuicRawClientSession::OnConnectionClosed(QuicErrorCode error,
+                                              const std::string& error_details,
+                                              ConnectionCloseSource source) {
+  QuicSession::OnConnectionClosed(error, error_details, source);
+  if (visitor_) {
+    visitor_->OnHandshakeProgress(this);
+  }
 }
 
 }  // namespace quic
@@ -9,6 +9,7 @@
 #include "net/third_party/quic/core/quic_crypto_client_stream.h"
 #include "net/third_party/quic/core/quic_packets.h"
 
+#include "net/tools/quic/raw/quic_raw_receive_window_tuner.h"
 #include "net/tools/quic/raw/quic_raw_stream.h"
 
 
@@ -21,6 +22,22 @@ class QuicRawClientSession
     : public QuicSession,
       public QuicCryptoClientStream::ProofHandler {
  public:
+  // Visitor receives callbacks from the QuicRawClientSession.
+  class Visitor {
+   public:
+    Visitor() {}
+    Visitor(const Visitor&) = delete;
+    Visitor& operator=(const Visitor&) = delete;
+
+    // Called when a crypto handshake event happens, or the connection is
+    // closed, so the owner could check the progress of the handshake without
+    // polling. The session must not be destroyed in this callback.
+    virtual void OnHandshakeProgress(QuicRawClientSession* session) = 0;
+
+   protected:
+    virtual ~Visitor() {}
+  };
+
   // Takes ownership of |connection|. Caller retains ownership of
   // |promised_by_url|.
   QuicRawClientSession(QuicConnection* connection,
@@ -41,6 +58,12 @@ class QuicRawClientSession
   // Override base class to set FEC policy before any data is sent by client.
   void OnCryptoHandshakeEvent(CryptoHandshakeEvent event) override;
 
+  void OnConnectionClosed(QuicErrorCode error,
+                          const std::string& error_details,
+                          ConnectionCloseSource source) override;
+
+  void set_visitor(Visitor* visitor) { visitor_ = visitor; }
+
   // QuicSession methods:
   QuicRawStream* CreateOutgoingBidirectionalStream();
   QuicRawStream* CreateOutgoingUnidirectionalStream();
@@ -68,6 +91,10 @@ class QuicRawClientSession
 
   bool IsConnected() { return connection()->connected(); }
 
+  // See QuicRawReceiveWindowTuner. Zero caps keep initial windows.
+  void SetMaxReceiveWindows(QuicByteCount max_stream_window,
+                            QuicByteCount max_session_window);
+
  protected:
   // QuicSession methods:
   QuicRawStream* CreateIncomingStream(QuicStreamId id) override;
@@ -101,6 +128,9 @@ class QuicRawClientSession
   // If this is set to false, the client will ignore server GOAWAYs and allow
   // the creation of streams regardless of the high chance they will fail.
   bool respect_goaway_;
+  // Set on all streams created by this session.
+  QuicRawReceiveWindowTuner receive_window_tuner_;
+  Visitor* visitor_;
 };
 
 }  // namespace quic
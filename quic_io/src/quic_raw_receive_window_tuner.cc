@@ -0,0 +1,96 @@
+#include "net/tools/quic/raw/quic_raw_receive_window_tuner.h"
+
+#include <limits>
+
+#include "net/third_party/quic/core/congestion_control/rtt_stats.h"
+#include "net/third_party/quic/core/quic_connection.h"
+#include "net/third_party/quic/core/quic_flow_controller.h"
+
+namespace quic {
+
+QuicRawReceiveWindowTuner::QuicRawReceiveWindowTuner(QuicSession* session)
+    : session_(session), max_stream_window_(0), max_session_window_(0) {
+  DCHECK(session_);
+}
+
+QuicRawReceiveWindowTuner::~QuicRawReceiveWindowTuner() = default;
+
+void QuicRawReceiveWindowTuner::SetMaxWindows(
+    QuicByteCount max_stream_window,
+    QuicByteCount max_session_window) {
+  max_stream_window_ = max_stream_window;
+  max_session_window_ = max_session_window;
+}
+
+void QuicRawReceiveWindowTuner::OnBytesConsumed(QuicStream* stream,
+                                                QuicByteCount bytes) {
+  if (bytes == 0) {
+    return;
+  }
+  if (max_stream_window_ > 0) {
+    Tune(stream->flow_controller(), &stream_periods_[stream->id()], bytes,
+         max_stream_window_);
+  }
+  if (max_session_window_ > 0) {
+    Tune(session_->flow_controller(), &session_period_, bytes,
+         max_session_window_);
+  }
+}
+
+void QuicRawReceiveWindowTuner::OnStreamClosed(QuicStreamId id) {
+  stream_periods_.erase(id);
+}
+
+// static
+bool QuicRawReceiveWindowTuner::ShouldGrow(QuicByteCount window,
+                                           QuicByteCount consumed,
+                                           QuicTime::Delta elapsed,
+                                           QuicTime::Delta rtt,
+                                           QuicByteCount max_window) {
+  if (window == 0 || window > max_window / 2 || rtt.IsZero() ||
+      elapsed < rtt) {
+    return false;
+  }
+  // Bytes consumed per RTT. A reader falling behind leaves data in the
+  // sequencer, so it consumes less than what the window allows.
+  const double consumed_per_rtt = static_cast<double>(consumed) *
+                                  rtt.ToMicroseconds() /
+                                  elapsed.ToMicroseconds();
+  return consumed_per_rtt * 2 >= window;
+}
+
+void QuicRawReceiveWindowTuner::Tune(QuicFlowController* flow_controller,
+                                     Period* period,
+                                     QuicByteCount bytes,
+                                     QuicByteCount max_window) {
+  if (!flow_controller || flow_controller->auto_tune_receive_window()) {
+    // QUIC tunes it.
+    return;
+  }
+  QuicConnection* connection = session_->connection();
+  const QuicTime now = connection->clock()->ApproximateNow();
+  if (!period->start.IsInitialized()) {
+    period->start = now;
+  }
+  period->consumed += bytes;
+  const QuicTime::Delta rtt =
+      connection->sent_packet_manager().GetRttStats()->smoothed_rtt();
+  const QuicTime::Delta elapsed = now - period->start;
+  if (rtt.IsZero() || elapsed < rtt) {
+    return;
+  }
+  const QuicByteCount window = flow_controller->receive_window_size();
+  const bool grow =
+      ShouldGrow(window, period->consumed, elapsed, rtt, max_window);
+  period->start = now;
+  period->consumed = 0;
+  if (grow) {
+    // EnsureWindowAtLeast() returns early unless it's asked for more than the
+    // flow controller's limit, so it's asked for the most. It then doubles the
+    // window up to that limit and sends a WINDOW_UPDATE with the new offset.
+    flow_controller->EnsureWindowAtLeast(
+        std::numeric_limits<QuicByteCount>::max());
+  }
+}
+
+}  // namespace quic
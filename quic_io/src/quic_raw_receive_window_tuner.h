@@ -0,0 +1,63 @@
+#ifndef NET_TOOLS_QUIC_RAW_QUIC_RAW_RECEIVE_WINDOW_TUNER_H_
+#define NET_TOOLS_QUIC_RAW_QUIC_RAW_RECEIVE_WINDOW_TUNER_H_
+
+#include <unordered_map>
+
+#include "net/third_party/quic/core/quic_session.h"
+#include "net/third_party/quic/core/quic_stream.h"
+#include "net/third_party/quic/core/quic_time.h"
+
+namespace quic {
+
+// Grows receive windows of a QUIC session which QUIC doesn't auto-tune, which
+// are windows of clients. Consumption of each stream, and of the session, is
+// measured over periods of at least one smoothed RTT. A window is doubled if
+// its reader consumed half of it or more in a period: the reader keeps up, and
+// RTT * rate reaches the window, so the window rather than the path bounds
+// throughput. Windows never grow beyond their caps, nor beyond QUIC's limits
+// of 16 MB per stream and 24 MB per session. Must be used on the session's
+// thread.
+class QuicRawReceiveWindowTuner {
+ public:
+  explicit QuicRawReceiveWindowTuner(QuicSession* session);
+  QuicRawReceiveWindowTuner(const QuicRawReceiveWindowTuner&) = delete;
+  QuicRawReceiveWindowTuner& operator=(const QuicRawReceiveWindowTuner&) =
+      delete;
+  ~QuicRawReceiveWindowTuner();
+
+  // Zero caps disable tuning of that kind of windows, which is the default.
+  void SetMaxWindows(QuicByteCount max_stream_window,
+                     QuicByteCount max_session_window);
+  // Called after the reader of `stream` consumes `bytes`.
+  void OnBytesConsumed(QuicStream* stream, QuicByteCount bytes);
+  void OnStreamClosed(QuicStreamId id);
+
+  // Returns true if `window` should be doubled after `consumed` bytes are
+  // consumed in one period of `elapsed`, which is at least `rtt`.
+  static bool ShouldGrow(QuicByteCount window,
+                         QuicByteCount consumed,
+                         QuicTime::Delta elapsed,
+                         QuicTime::Delta rtt,
+                         QuicByteCount max_window);
+
+ private:
+  struct Period {
+    QuicTime start = QuicTime::Zero();
+    QuicByteCount consumed = 0;
+  };
+
+  void Tune(QuicFlowController* flow_controller,
+            Period* period,
+            QuicByteCount bytes,
+            QuicByteCount max_window);
+
+  QuicSession* session_;
+  QuicByteCount max_stream_window_;
+  QuicByteCount max_session_window_;
+  std::unordered_map<QuicStreamId, Period> stream_periods_;
+  Period session_period_;
+};
+
+}  // namespace quic
+
+#endif  // NET_TOOLS_QUIC_RAW_QUIC_RAW_RECEIVE_WINDOW_TUNER_H_
@@ -110,12 +110,14 @@ bool QuicRawServerSession::ShouldCreateIncomingStream(QuicStreamId id) {
 
 bool QuicRawServerSession::ShouldCreateOutgoingBidirectionalStream() {
   if (!connection()->connected()) {
-    QUIC_BUG
+    // Reachable from the application, which may race with connection close.
+    QUIC_DLOG(INFO)
         << "ShouldCreateOutgoingBidirectionalStream called when disconnected";
     return false;
   }
   if (!crypto_stream_->encryption_established()) {
-    QUIC_BUG << "Encryption not established so no outgoing stream created.";
+    QUIC_DLOG(INFO)
+        << "Encryption not established so no outgoing stream created.";
     return false;
   }
 
@@ -135,12 +137,14 @@ bool QuicRawServerSession::ShouldCreateOutgoingBidirectionalStream() {
 
 bool QuicRawServerSession::ShouldCreateOutgoingUnidirectionalStream() {
   if (!connection()->connected()) {
-    QUIC_BUG
+    // Reachable from the application, which may race with connection close.
+    QUIC_DLOG(INFO)
         << "ShouldCreateOutgoingUnidirectionalStream called when disconnected";
     return false;
   }
   if (!crypto_stream_->encryption_established()) {
-    QUIC_BUG << "Encryption not established so no outgoing stream created.";
+    QUIC_DLOG(INFO)
+        << "Encryption not established so no outgoing stream created.";
     return false;
   }
 
@@ -192,8 +196,14 @@ QuicRawStream* QuicRawServerSession::CreateIncomingStream(QuicStreamId id) {
 
 QuicRawStream*
 QuicRawServerSession::CreateOutgoingBidirectionalStream() {
-  DCHECK(false);
-  return nullptr;
+  if (!ShouldCreateOutgoingBidirectionalStream()) {
+    return nullptr;
+  }
+
+  QuicRawStream* stream = new QuicRawStream(
+      GetNextOutgoingStreamId(), this, BIDIRECTIONAL);
+  ActivateStream(QuicWrapUnique(stream));
+  return stream;
 }
 
 QuicRawStream*
@@ -63,6 +63,11 @@ class QUIC_EXPORT_PRIVATE QuicRawServerSession
 
   void set_visitor(Visitor* visitor) { visitor_ = visitor; }
 
+  // Opens a server initiated stream. Returns nullptr if the stream can't be
+  // created, e.g.: encryption is not established yet.
+  virtual QuicRawStream* CreateOutgoingBidirectionalStream();
+  virtual QuicRawStream* CreateOutgoingUnidirectionalStream();
+
  protected:
   // QuicSession methods(override them with return type of QuicSpdyStream*):
   QuicCryptoServerStreamBase* GetMutableCryptoStream() override;
@@ -80,8 +85,6 @@ class QUIC_EXPORT_PRIVATE QuicRawServerSession
   // make sure that all data streams are QuicSpdyStreams.
   QuicRawStream* CreateIncomingStream(QuicStreamId id) override;
   // QuicRawStream* CreateIncomingStream(PendingStream pending) override;
-  virtual QuicRawStream* CreateOutgoingBidirectionalStream();
-  virtual QuicRawStream* CreateOutgoingUnidirectionalStream();
 
   // If an incoming stream can be created, return true.
   virtual bool ShouldCreateIncomingStream(QuicStreamId id);
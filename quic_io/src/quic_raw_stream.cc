@@ -18,7 +18,8 @@ QuicRawStream::QuicRawStream(
     QuicSession* session,
     StreamType type)
     : QuicStream(id, session, /*is_static=*/false, type),
-      visitor_(nullptr) {
+      visitor_(nullptr),
+      receive_window_tuner_(nullptr) {
 
 }
 
@@ -26,17 +27,25 @@ QuicRawStream::~QuicRawStream() {}
 
 void QuicRawStream::OnDataAvailable() {
   while (sequencer()->HasBytesToRead()) {
-    struct iovec iov;
-    if (sequencer()->GetReadableRegions(&iov, 1) == 0) {
+    struct iovec iovs[kMaxRegionsPerRead];
+    int count = sequencer()->GetReadableRegions(iovs, kMaxRegionsPerRead);
+    if (count <= 0) {
       // No more data to read.
       break;
     }
-    QUIC_DVLOG(1) << "Stream " << id() << " processed " << iov.iov_len
-                  << " bytes.";
+    size_t bytes_read = 0;
+    for (int i = 0; i < count; i++) {
+      bytes_read += iovs[i].iov_len;
+    }
+    QUIC_DVLOG(1) << "Stream " << id() << " processed " << bytes_read
+                  << " bytes in " << count << " regions.";
     if (visitor()) {
-      visitor()->OnData(this, static_cast<char*>(iov.iov_base), iov.iov_len);
+      visitor()->OnDataRegions(this, iovs, count);
+    }
+    sequencer()->MarkConsumed(bytes_read);
+    if (receive_window_tuner_) {
+      receive_window_tuner_->OnBytesConsumed(this, bytes_read);
     }
-    sequencer()->MarkConsumed(iov.iov_len);
   }
   if (!sequencer()->IsClosed()) {
     sequencer()->SetUnblocked();
@@ -52,4 +61,14 @@ void QuicRawStream::OnDataAvailable() {
   }
 }
 
+void QuicRawStream::OnClose() {
+  QuicStream::OnClose();
+  if (receive_window_tuner_) {
+    receive_window_tuner_->OnStreamClosed(id());
+  }
+  if (visitor()) {
+    visitor()->OnClose(this);
+  }
+}
+
 }  // namespace quic
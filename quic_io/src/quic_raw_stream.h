@@ -5,14 +5,20 @@
 #ifndef NET_TOOLS_QUIC_RAW_QUIC_RAW_STREAM_H_
 #define NET_TOOLS_QUIC_RAW_QUIC_RAW_STREAM_H_
 
+#include <sys/uio.h>
+
 #include "base/macros.h"
 #include "net/third_party/quic/core/quic_stream.h"
 #include "net/third_party/quic/core/quic_session.h"
+#include "net/tools/quic/raw/quic_raw_receive_window_tuner.h"
 
 namespace quic {
 
 class QUIC_EXPORT_PRIVATE QuicRawStream : public QuicStream {
  public:
+  // Max number of regions passed to Visitor::OnDataRegions() by one call.
+  static const size_t kMaxRegionsPerRead = 64;
+
   // Visitor receives callbacks from the stream.
   class QUIC_EXPORT_PRIVATE Visitor {
    public:
@@ -23,6 +29,17 @@ class QUIC_EXPORT_PRIVATE QuicRawStream : public QuicStream {
     // Called when the stream is closed.
     virtual void OnClose(QuicRawStream* stream) = 0;
     virtual void OnData(QuicRawStream* stream, char* data, size_t len) = 0;
+    // Called with readable regions of a single OnDataAvailable() pass, up to
+    // kMaxRegionsPerRead at a time. Regions are consumed after the call.
+    // Calls OnData() for each region by default.
+    virtual void OnDataRegions(QuicRawStream* stream,
+                               const struct iovec* regions,
+                               size_t count) {
+      for (size_t i = 0; i < count; i++) {
+        OnData(stream, static_cast<char*>(regions[i].iov_base),
+               regions[i].iov_len);
+      }
+    }
 
    protected:
     virtual ~Visitor() {}
@@ -39,7 +56,16 @@ class QUIC_EXPORT_PRIVATE QuicRawStream : public QuicStream {
   // data (or a FIN) to be read.
   void OnDataAvailable() override;
 
+  // QuicStream implementation called by the session when the stream is
+  // closed in both directions. Notifies the visitor.
+  void OnClose() override;
+
   void set_visitor(Visitor* visitor) { visitor_ = visitor; }
+  // Reports data consumed from this stream to `tuner`, which could be
+  // nullptr, and it must outlive this stream.
+  void set_receive_window_tuner(QuicRawReceiveWindowTuner* tuner) {
+    receive_window_tuner_ = tuner;
+  }
 
   // Returns true if the sequencer has delivered the FIN, and no more body bytes
   // will be available.
@@ -50,6 +76,7 @@ class QUIC_EXPORT_PRIVATE QuicRawStream : public QuicStream {
 
  private:
   Visitor* visitor_;
+  QuicRawReceiveWindowTuner* receive_window_tuner_;
 };
 
 }  // namespace quic
@@ -1,15 +1,22 @@
 
 #include "net/tools/quic/raw/wrapper/quic_raw_lib.h"
 
+#include <algorithm>
+#include <atomic>
 #include <iostream>
 #include <thread>
 #include <string>
+#include <vector>
 
 #include "base/at_exit.h"
+#include "base/callback_helpers.h"
+#include "base/memory/weak_ptr.h"
 #include "base/run_loop.h"
+#include "base/single_thread_task_runner.h"
 #include "base/message_loop/message_loop.h"
 #include "base/task/post_task.h"
 #include "base/task/task_scheduler/task_scheduler.h"
+#include "net/base/address_list.h"
 #include "net/base/net_errors.h"
 #include "net/base/privacy_mode.h"
 #include "net/cert/cert_verifier.h"
@@ -18,6 +25,7 @@
 #include "net/cert/multi_log_ct_verifier.h"
 #include "net/http/transport_security_state.h"
 #include "net/quic/crypto/proof_verifier_chromium.h"
+#include "net/third_party/quic/core/quic_crypto_client_stream.h"
 #include "net/third_party/quic/core/quic_error_codes.h"
 #include "net/third_party/quic/core/quic_packets.h"
 #include "net/third_party/quic/core/quic_server_id.h"
@@ -28,6 +36,8 @@
 #include "net/tools/quic/synchronous_host_resolver.h"
 
 #include "base/strings/string_number_conversions.h"
+#include "base/synchronization/waitable_event.h"
+#include "base/threading/thread.h"
 #include "net/base/ip_address.h"
 #include "net/base/ip_endpoint.h"
 #include "net/quic/crypto/proof_source_chromium.h"
@@ -39,6 +49,8 @@
 #include "net/tools/quic/raw/quic_raw_server.h"
 #include "net/tools/quic/raw/quic_raw_dispatcher.h"
 #include "net/tools/quic/raw/quic_raw_server_session.h"
+#include "net/tools/quic/raw/wrapper/quic_raw_send_queue.h"
+#include "net/tools/quic/raw/wrapper/quic_raw_stats.h"
 
 namespace net {
 
@@ -120,50 +132,155 @@ class FakeProofVerifier : public quic::ProofVerifier {
   }
 };
 
+// A buffer holding a copy of a region read from a stream.
+class RQuicBufferImpl : public RQuicBuffer {
+ public:
+  RQuicBufferImpl(const char* data, uint32_t len)
+      : data_(data, len), ref_count_(1) {}
+
+  // Implement RQuicBuffer
+  const char* data() const override { return data_.data(); }
+  uint32_t size() const override { return data_.size(); }
+  void addRef() override {
+    ref_count_.fetch_add(1, std::memory_order_relaxed);
+  }
+  void release() override {
+    if (ref_count_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      delete this;
+    }
+  }
+
+ private:
+  ~RQuicBufferImpl() override {}
+
+  const std::string data_;
+  std::atomic<int> ref_count_;
+};
+
+// Delivers `regions` to `listener` as ref-counted buffers.
+void DeliverDataBatch(RQuicListener* listener,
+                      uint32_t session_id,
+                      uint32_t stream_id,
+                      const struct iovec* regions,
+                      size_t count) {
+  std::vector<RQuicBuffer*> buffers;
+  buffers.reserve(count);
+  for (size_t i = 0; i < count; i++) {
+    buffers.push_back(
+        new RQuicBufferImpl(static_cast<const char*>(regions[i].iov_base),
+                            regions[i].iov_len));
+  }
+  listener->onDataBatch(session_id, stream_id, buffers.data(), buffers.size());
+  for (RQuicBuffer* buffer : buffers) {
+    buffer->release();
+  }
+}
+
+const uint32_t kMaxClientThreadCount = 64;
+// Interval of refreshing statistics snapshots.
+const int64_t kStatsRefreshIntervalMs = 100;
+
+// Runs clients on a small pool of IO threads.
+class RQuicClientContextImpl : public RQuicClientContextInterface {
+ public:
+  explicit RQuicClientContextImpl(uint32_t thread_count) : next_thread_{0} {
+    thread_count = std::max<uint32_t>(
+        1, std::min<uint32_t>(thread_count, kMaxClientThreadCount));
+    for (uint32_t i = 0; i < thread_count; i++) {
+      std::unique_ptr<base::Thread> thread(
+          new base::Thread("raw_quic_client_io_" + base::UintToString(i)));
+      CHECK(thread->StartWithOptions(
+          base::Thread::Options(base::MessageLoop::TYPE_IO, 0)));
+      threads_.push_back(std::move(thread));
+    }
+  }
+
+  // Stops all threads. Clients must be destroyed before the context.
+  ~RQuicClientContextImpl() override {}
+
+  // Returns the IO thread of a new client. Threads are assigned round robin.
+  scoped_refptr<base::SingleThreadTaskRunner> NextTaskRunner() {
+    uint32_t index = next_thread_.fetch_add(1, std::memory_order_relaxed);
+    return threads_[index % threads_.size()]->task_runner();
+  }
+
+ private:
+  std::vector<std::unique_ptr<base::Thread>> threads_;
+  std::atomic<uint32_t> next_thread_;
+};
+
 // RawClient Implementation
 class RawClientImpl : public RQuicClientInterface,
+                      public quic::QuicRawClientSession::Visitor,
                       public quic::QuicRawStream::Visitor {
  public:
-  RawClientImpl()
+  // Runs on an IO thread of `context`. If `context` is nullptr, the client
+  // creates a context with a dedicated thread.
+  explicit RawClientImpl(RQuicClientContextImpl* context)
       : stream_{nullptr},
         session_{nullptr},
-        mtx_{},
-        message_loop_{nullptr},
-        run_loop_{nullptr},
-        client_thread_{nullptr},
-        listener_{nullptr} {}
+        context_{context},
+        started_{false},
+        connect_attempts_{0},
+        max_stream_receive_window_{0},
+        max_session_receive_window_{0},
+        running_{false},
+        closed_{base::WaitableEvent::ResetPolicy::MANUAL,
+                base::WaitableEvent::InitialState::NOT_SIGNALED},
+        listener_{nullptr},
+        weak_factory_{this} {}
 
   ~RawClientImpl() override {
     stop();
     waitForClose();
+    if (task_runner_ && !task_runner_->BelongsToCurrentThread()) {
+      // Tasks bound to this client may still be queued behind the one closing
+      // the connection, e.g. redundant stop() calls. Waits until they run.
+      base::WaitableEvent flushed(
+          base::WaitableEvent::ResetPolicy::MANUAL,
+          base::WaitableEvent::InitialState::NOT_SIGNALED);
+      if (task_runner_->PostTask(FROM_HERE,
+              base::BindOnce(&base::WaitableEvent::Signal,
+                  base::Unretained(&flushed)))) {
+        flushed.Wait();
+      }
+    }
+    own_context_.reset();
   }
 
   // Implement RQuicClientInterface
   bool start(const char* host, int port) override {
-    if (!client_thread_) {
-      std::string s_host(host);
-      client_thread_.reset(
-          new std::thread(&RawClientImpl::InitAndRun, this, s_host, port));
-      return true;
+    if (started_) {
+      return false;
     }
-    return false;
+    started_ = true;
+    if (!context_) {
+      own_context_.reset(new RQuicClientContextImpl(1));
+      context_ = own_context_.get();
+    }
+    task_runner_ = context_->NextTaskRunner();
+    // Enqueue() runs on any thread, so the weak pointer is created before
+    // `weak_factory_` is bound to `task_runner_`.
+    weak_this_ = weak_factory_.GetWeakPtr();
+    task_runner_->PostTask(FROM_HERE,
+        base::BindOnce(&RawClientImpl::ConnectOnCurrentThread,
+            base::Unretained(this), std::string(host), port));
+    return true;
   }
 
   // Implement RQuicClientInterface
   void stop() override {
-    {
-      std::unique_lock<std::mutex> lck(mtx_);
-      if (message_loop_) {
-        message_loop_->task_runner()->PostTask(FROM_HERE, run_loop_->QuitClosure());
-      }
+    if (task_runner_) {
+      task_runner_->PostTask(FROM_HERE,
+          base::BindOnce(&RawClientImpl::DisconnectOnCurrentThread,
+              base::Unretained(this)));
     }
   }
 
   // Implement RQuicClientInterface
   void waitForClose() override {
-    if (client_thread_) {
-      client_thread_->join();
-      client_thread_.reset();
+    if (started_) {
+      closed_.Wait();
     }
   }
 
@@ -176,12 +293,21 @@ class RawClientImpl : public RQuicClientInterface,
 
   // Implement RQuicClientInterface
   void send(uint32_t stream_id, const char* data, uint32_t len) override {
-    std::unique_lock<std::mutex> lck(mtx_);
-    if (message_loop_) {
-      std::string s_data(data, len);
-      message_loop_->task_runner()->PostTask(FROM_HERE,
-          base::BindOnce(&RawClientImpl::SendOnStream,
-              base::Unretained(this), stream_id, s_data, false));
+    if (running_.load(std::memory_order_acquire)) {
+      Enqueue(std::make_unique<RQuicSendRequest>(0, stream_id, data, len));
+    }
+  }
+
+  // Implement RQuicClientInterface
+  void send(uint32_t stream_id,
+            char* data,
+            uint32_t len,
+            RQuicReleaseCallback release,
+            void* context) override {
+    std::unique_ptr<RQuicSendRequest> request(
+        new RQuicSendRequest(0, stream_id, data, len, release, context));
+    if (running_.load(std::memory_order_acquire)) {
+      Enqueue(std::move(request));
     }
   }
 
@@ -190,8 +316,36 @@ class RawClientImpl : public RQuicClientInterface,
     listener_ = listener;
   }
 
+  // Implement RQuicClientInterface
+  void setMaxReceiveWindows(uint32_t max_stream_window,
+                            uint32_t max_session_window) override {
+    max_stream_receive_window_ = max_stream_window;
+    max_session_receive_window_ = max_session_window;
+  }
+
+  // Implement RQuicClientInterface
+  bool getStats(RQuicConnectionStats* stats) override {
+    return stats && stats_.Get(0, stats);
+  }
+
+  // Implement quic::QuicRawClientSession::Visitor
+  void OnHandshakeProgress(quic::QuicRawClientSession* session) override {
+    if (!client_ || session_) {
+      // Disconnecting, or the handshake is already done.
+      return;
+    }
+    // A new attempt destroys the session, so it's not started by this
+    // callback.
+    task_runner_->PostTask(FROM_HERE,
+        base::BindOnce(&RawClientImpl::WaitForHandshakeOnCurrentThread,
+            weak_factory_.GetWeakPtr()));
+  }
+
   // Implement quic::QuicRawStream::Visitor
   void OnClose(quic::QuicRawStream* stream) override {
+    if (listener_) {
+      listener_->onStreamClosed(0, stream->id());
+    }
     if (stream == stream_) {
       stream_ = nullptr;
     }
@@ -202,6 +356,15 @@ class RawClientImpl : public RQuicClientInterface,
       listener_->onData(0, stream->id(), data, len);
     }
   }
+  void OnDataRegions(quic::QuicRawStream* stream,
+                     const struct iovec* regions,
+                     size_t count) override {
+    if (listener_ && listener_->wantsDataBatch()) {
+      DeliverDataBatch(listener_, 0, stream->id(), regions, count);
+      return;
+    }
+    quic::QuicRawStream::Visitor::OnDataRegions(stream, regions, count);
+  }
  private:
   std::unique_ptr<quic::ProofVerifier> CreateProofVerifier() {
     std::unique_ptr<quic::ProofVerifier> proof_verifier;
@@ -223,66 +386,163 @@ class RawClientImpl : public RQuicClientInterface,
     return proof_verifier;
   }
 
-  void InitAndRun(std::string host, int port) {
-    base::MessageLoopForIO message_loop;
-    base::RunLoop run_loop;
-
-    // Determine IP address to connect to from supplied hostname.
+  // Resolves `host` on a worker thread if it's not an IP address, because
+  // the resolver blocks, and other clients share the IO thread.
+  void ConnectOnCurrentThread(std::string host, int port) {
     quic::QuicIpAddress ip_addr;
+    if (ip_addr.FromString(host)) {
+      ConnectToAddressOnCurrentThread(ip_addr, port);
+      return;
+    }
+    base::PostTaskWithTraitsAndReplyWithResult(FROM_HERE,
+        {base::MayBlock(), base::WithBaseSyncPrimitives(),
+         base::TaskPriority::USER_BLOCKING},
+        base::BindOnce(&RawClientImpl::ResolveHost, host),
+        base::BindOnce(&RawClientImpl::OnHostResolvedOnCurrentThread,
+            weak_factory_.GetWeakPtr(), port));
+  }
 
-    GURL url("https://www.example.org");
-    
-    if (!ip_addr.FromString(host)) {
-      net::AddressList addresses;
-      int rv = net::SynchronousHostResolver::Resolve(host, &addresses);
-      if (rv != net::OK) {
-        LOG(ERROR) << "Unable to resolve '" << host
-                   << "' : " << net::ErrorToShortString(rv);
-        return;
-      }
-      ip_addr =
-          quic::QuicIpAddress(quic::QuicIpAddressImpl(addresses[0].address()));
+  // Runs on a worker thread. Returns an empty list on failure.
+  static net::AddressList ResolveHost(const std::string& host) {
+    net::AddressList addresses;
+    int rv = net::SynchronousHostResolver::Resolve(host, &addresses);
+    if (rv != net::OK) {
+      LOG(ERROR) << "Unable to resolve '" << host
+                 << "' : " << net::ErrorToShortString(rv);
+      return net::AddressList();
+    }
+    return addresses;
+  }
+
+  void OnHostResolvedOnCurrentThread(int port, net::AddressList addresses) {
+    if (addresses.empty()) {
+      closed_.Signal();
+      return;
     }
+    ConnectToAddressOnCurrentThread(
+        quic::QuicIpAddress(quic::QuicIpAddressImpl(addresses[0].address())),
+        port);
+  }
+
+  void ConnectToAddressOnCurrentThread(quic::QuicIpAddress ip_addr, int port) {
+    GURL url("https://www.example.org");
 
     quic::QuicServerId server_id(url.host(), url.EffectiveIntPort(),
                                  net::PRIVACY_MODE_DISABLED);
     quic::ParsedQuicVersionVector versions = quic::CurrentSupportedVersions();
 
-    net::QuicRawClient client(quic::QuicSocketAddress(ip_addr, port),
-                                server_id, versions, CreateProofVerifier());
+    client_.reset(new net::QuicRawClient(quic::QuicSocketAddress(ip_addr, port),
+                                         server_id, versions,
+                                         CreateProofVerifier()));
 
-    client.set_initial_max_packet_length(quic::kDefaultMaxPacketSize);
-    if (!client.Initialize()) {
+    client_->set_initial_max_packet_length(quic::kDefaultMaxPacketSize);
+    client_->set_session_visitor(this);
+    if (!client_->Initialize()) {
       std::cerr << "Failed to initialize client." << std::endl;
+      DisconnectOnCurrentThread();
+      return;
+    }
+    // QuicClientBase::Connect() spins a nested loop until the handshake is
+    // done, which would stall other clients sharing the thread. The session
+    // reports the progress of the handshake instead.
+    connect_attempts_ = 1;
+    client_->StartConnect();
+    WaitForHandshakeOnCurrentThread();
+  }
+
+  // Checks the state of the handshake. If it's still in progress, it runs
+  // again when the session reports progress.
+  void WaitForHandshakeOnCurrentThread() {
+    if (!client_ || session_) {
+      // Disconnected by stop(), or already done.
+      return;
+    }
+    if (client_->EncryptionBeingEstablished()) {
       return;
     }
-    if (!client.Connect()) {
-      std::cerr << "Failed to connect." << std::endl;
+    if (!client_->connected()) {
+      // Same as QuicClientBase::Connect(), e.g.: after version negotiation.
+      if (connect_attempts_ > quic::QuicCryptoClientStream::kMaxClientHellos) {
+        std::cerr << "Failed to connect." << std::endl;
+        DisconnectOnCurrentThread();
+        return;
+      }
+      connect_attempts_++;
+      client_->StartConnect();
+      WaitForHandshakeOnCurrentThread();
       return;
     }
 
-    session_ = client.client_session();
+    session_ = client_->client_session();
+    session_->SetMaxReceiveWindows(max_stream_receive_window_,
+                                   max_session_receive_window_);
     stream_ = session_->CreateOutgoingBidirectionalStream();
     stream_->set_visitor(this);
 
-    {
-      std::unique_lock<std::mutex> lck(mtx_);
-      message_loop_ = &message_loop;
-      run_loop_ = &run_loop;
-    }
+    running_.store(true, std::memory_order_release);
+    RefreshStatsOnCurrentThread();
     if (listener_) {
       listener_->onReady();
     }
-    // cout << "get port:" << client.SocketPort() << endl;
-    run_loop_->Run();
-    {
-      std::unique_lock<std::mutex> lck(mtx_);
-      message_loop_ = nullptr;
-      run_loop_ = nullptr;
+  }
+
+  // Takes a statistics snapshot, and schedules the next one.
+  void RefreshStatsOnCurrentThread() {
+    if (!session_) {
+      return;
+    }
+    RQuicConnectionStats stats;
+    FillConnectionStats(session_, &stats);
+    stats_.Update(0, stats);
+    task_runner_->PostDelayedTask(FROM_HERE,
+        base::BindOnce(&RawClientImpl::RefreshStatsOnCurrentThread,
+            weak_factory_.GetWeakPtr()),
+        base::TimeDelta::FromMilliseconds(kStatsRefreshIntervalMs));
+  }
+
+  // Closes the connection. Other clients on the same thread keep running.
+  void DisconnectOnCurrentThread() {
+    if (closed_.IsSignaled()) {
+      return;
+    }
+    running_.store(false, std::memory_order_release);
+    // Cancels the refresh of statistics, which could outlive this client.
+    weak_factory_.InvalidateWeakPtrs();
+    stats_.Clear();
+    stream_ = nullptr;
+    session_ = nullptr;
+    client_.reset();
+    // Releases buffers of requests which are not sent.
+    send_queue_.PopAll();
+    closed_.Signal();
+  }
+
+  // Queues `request`, and wakes up the IO thread if the queue was empty.
+  void Enqueue(std::unique_ptr<RQuicSendRequest> request) {
+    if (send_queue_.Push(std::move(request))) {
+      task_runner_->PostTask(FROM_HERE,
+          base::BindOnce(&RawClientImpl::DrainSendQueue, weak_this_));
+    }
+  }
+
+  // Sends all queued requests. Requests queued after the connection is closed
+  // are dropped.
+  void DrainSendQueue() {
+    if (!session_) {
+      send_queue_.PopAll();
+      return;
+    }
+    for (const auto& request : send_queue_.PopAll()) {
+      SendOnStream(request->stream_id(),
+                   quic::QuicStringPiece(request->data(), request->len()),
+                   request->fin());
     }
   }
 
-  void SendOnStream(uint32_t stream_id, const std::string& data, bool fin) {
+  void SendOnStream(uint32_t stream_id, quic::QuicStringPiece data, bool fin) {
+    if (!session_) {
+      return;
+    }
     quic::QuicStream* stream = session_->GetOrCreateStream(stream_id);
     if (stream) {
       stream->WriteOrBufferData(data, fin, nullptr);
@@ -292,11 +552,30 @@ class RawClientImpl : public RQuicClientInterface,
   }
   quic::QuicRawStream* stream_;
   quic::QuicRawClientSession* session_;
-  std::mutex mtx_;
-  base::MessageLoopForIO* message_loop_;
-  base::RunLoop* run_loop_;
-  std::unique_ptr<std::thread> client_thread_;
+  // Created when the client has no shared context.
+  std::unique_ptr<RQuicClientContextImpl> own_context_;
+  RQuicClientContextImpl* context_;
+  bool started_;
+  // The IO thread assigned by `context_` in start().
+  scoped_refptr<base::SingleThreadTaskRunner> task_runner_;
+  // Created, used and destroyed on `task_runner_`.
+  std::unique_ptr<net::QuicRawClient> client_;
+  int connect_attempts_;
+  // Set before start(), read on `task_runner_`.
+  uint32_t max_stream_receive_window_;
+  uint32_t max_session_receive_window_;
+  std::atomic<bool> running_;
+  // Signaled when the connection is closed, or fails to be established.
+  base::WaitableEvent closed_;
+  RQuicSendQueue send_queue_;
   RQuicListener* listener_;
+  // Refreshed on `task_runner_`, read by getStats() on any thread.
+  RQuicStatsTable stats_;
+  // Created in start(), copied by Enqueue() on any thread, and dereferenced on
+  // `task_runner_`.
+  base::WeakPtr<RawClientImpl> weak_this_;
+  // Only used on `task_runner_`.
+  base::WeakPtrFactory<RawClientImpl> weak_factory_;
 };
 
 
@@ -312,6 +591,7 @@ class RawServerImpl : public RQuicServerInterface,
         mtx_{},
         message_loop_{nullptr},
         run_loop_{nullptr},
+        running_{false},
         server_thread_{nullptr},
         listener_{nullptr},
         server_port_{0},
@@ -368,12 +648,56 @@ class RawServerImpl : public RQuicServerInterface,
   void send(uint32_t session_id,
             uint32_t stream_id,
             const char* data, uint32_t len) override {
-    std::unique_lock<std::mutex> lck(mtx_);
-    if (message_loop_) {
-      std::string s_data(data);
-      message_loop_->task_runner()->PostTask(FROM_HERE,
-          base::BindOnce(&RawServerImpl::SendOnSession,
-              base::Unretained(this), session_id, stream_id, s_data, false));
+    if (running_.load(std::memory_order_acquire)) {
+      Enqueue(std::make_unique<RQuicSendRequest>(session_id, stream_id, data,
+                                                 len));
+    }
+  }
+
+  // Implement RQuicServerInterface
+  void send(uint32_t session_id,
+            uint32_t stream_id,
+            char* data,
+            uint32_t len,
+            RQuicReleaseCallback release,
+            void* context) override {
+    std::unique_ptr<RQuicSendRequest> request(new RQuicSendRequest(
+        session_id, stream_id, data, len, release, context));
+    if (running_.load(std::memory_order_acquire)) {
+      Enqueue(std::move(request));
+    }
+  }
+
+  // Implement RQuicServerInterface
+  bool createStream(uint32_t session_id, uint32_t* stream_id) override {
+    if (!stream_id || !running_.load(std::memory_order_acquire)) {
+      return false;
+    }
+    if (task_runner_->BelongsToCurrentThread()) {
+      return CreateStreamOnCurrentThread(session_id, stream_id);
+    }
+    base::WaitableEvent done(base::WaitableEvent::ResetPolicy::AUTOMATIC,
+                             base::WaitableEvent::InitialState::NOT_SIGNALED);
+    bool created = false;
+    // `done` is signaled when the task runs, or when it's dropped because the
+    // loop has quit.
+    task_runner_->PostTask(FROM_HERE,
+        base::BindOnce(&RawServerImpl::CreateStreamAndSignal,
+            base::Unretained(this), session_id, stream_id, &created,
+            base::ScopedClosureRunner(base::BindOnce(
+                &base::WaitableEvent::Signal, base::Unretained(&done)))));
+    done.Wait();
+    return created;
+  }
+
+  // Implement RQuicServerInterface
+  void closeStream(uint32_t session_id, uint32_t stream_id) override {
+    if (running_.load(std::memory_order_acquire)) {
+      // Queued with data, so the FIN is sent after data passed to send().
+      std::unique_ptr<RQuicSendRequest> request(
+          new RQuicSendRequest(session_id, stream_id, "", 0));
+      request->set_fin(true);
+      Enqueue(std::move(request));
     }
   }
 
@@ -382,10 +706,18 @@ class RawServerImpl : public RQuicServerInterface,
     listener_ = listener;
   }
 
+  // Implement RQuicServerInterface
+  bool getStats(uint32_t session_id, RQuicConnectionStats* stats) override {
+    return stats && stats_.Get(session_id, stats);
+  }
+
   // Implement quic::QuicRawDispatcher::Visitor
   void OnSessionCreated(quic::QuicRawServerSession* session) override {
     session_ids_[session] = next_session_id_;
     session_ptrs_[next_session_id_] = session;
+    RQuicConnectionStats stats;
+    FillConnectionStats(session, &stats);
+    stats_.Update(next_session_id_, stats);
     next_session_id_++;
     session->set_visitor(this);
   }
@@ -394,6 +726,7 @@ class RawServerImpl : public RQuicServerInterface,
       uint32_t session_id = session_ids_[session];
       session_ids_.erase(session);
       session_ptrs_.erase(session_id);
+      stats_.Remove(session_id);
     }
   }
 
@@ -410,11 +743,17 @@ class RawServerImpl : public RQuicServerInterface,
     if (!stream_) {
       stream_ = stream;
     }
+    if (listener_ && session_ids_.count(session) > 0) {
+      listener_->onStreamOpened(session_ids_[session], stream->id());
+    }
   }
 
   // Implement quic::QuicRawStream::Visitor
   void OnClose(quic::QuicRawStream* stream) override {
     if (stream_sessions_.count(stream)) {
+      if (listener_) {
+        listener_->onStreamClosed(stream_sessions_[stream], stream->id());
+      }
       stream_sessions_.erase(stream);
     } else {
       cerr << "No mapping session for closing stream" << endl;
@@ -429,6 +768,16 @@ class RawServerImpl : public RQuicServerInterface,
       listener_->onData(session_id, stream->id(), data, len);
     }
   }
+  void OnDataRegions(quic::QuicRawStream* stream,
+                     const struct iovec* regions,
+                     size_t count) override {
+    if (listener_ && listener_->wantsDataBatch()) {
+      DeliverDataBatch(listener_, stream_sessions_[stream], stream->id(),
+                       regions, count);
+      return;
+    }
+    quic::QuicRawStream::Visitor::OnDataRegions(stream, regions, count);
+  }
 
  private:
   std::unique_ptr<quic::ProofSource> CreateProofSource() {
@@ -473,19 +822,89 @@ class RawServerImpl : public RQuicServerInterface,
       message_loop_ = &message_loop;
       run_loop_ = &run_loop;
     }
+    // Kept after the loop quits, since senders post to it without a lock.
+    task_runner_ = message_loop.task_runner();
+    running_.store(true, std::memory_order_release);
+    ScheduleStatsRefresh();
     if (listener_) {
       listener_->onReady();
     }
     run_loop_->Run();
+    running_.store(false, std::memory_order_release);
+    stats_.Clear();
     {
       std::unique_lock<std::mutex> lck(mtx_);
       message_loop_ = nullptr;
       run_loop_ = nullptr;
     }
+    // Releases buffers of requests which are not sent.
+    send_queue_.PopAll();
+  }
+
+  // Queues `request`, and wakes up the IO thread if the queue was empty.
+  void Enqueue(std::unique_ptr<RQuicSendRequest> request) {
+    if (send_queue_.Push(std::move(request))) {
+      task_runner_->PostTask(FROM_HERE,
+          base::BindOnce(&RawServerImpl::DrainSendQueue,
+              base::Unretained(this)));
+    }
+  }
+
+  // Sends all queued requests.
+  void DrainSendQueue() {
+    for (const auto& request : send_queue_.PopAll()) {
+      SendOnSession(request->session_id(), request->stream_id(),
+                    quic::QuicStringPiece(request->data(), request->len()),
+                    request->fin());
+    }
+  }
+
+  // Pending refreshes are dropped with the message loop when the server
+  // stops.
+  void ScheduleStatsRefresh() {
+    task_runner_->PostDelayedTask(FROM_HERE,
+        base::BindOnce(&RawServerImpl::RefreshStatsOnCurrentThread,
+            base::Unretained(this)),
+        base::TimeDelta::FromMilliseconds(kStatsRefreshIntervalMs));
+  }
+
+  // Takes statistics snapshots of all sessions.
+  void RefreshStatsOnCurrentThread() {
+    RQuicConnectionStats stats;
+    for (const auto& entry : session_ptrs_) {
+      FillConnectionStats(entry.second, &stats);
+      stats_.Update(entry.first, stats);
+    }
+    ScheduleStatsRefresh();
+  }
+
+  bool CreateStreamOnCurrentThread(uint32_t session_id, uint32_t* stream_id) {
+    if (session_ptrs_.count(session_id) == 0) {
+      return false;
+    }
+    quic::QuicRawStream* stream =
+        session_ptrs_[session_id]->CreateOutgoingBidirectionalStream();
+    if (!stream) {
+      return false;
+    }
+    stream_sessions_[stream] = session_id;
+    stream->set_visitor(this);
+    *stream_id = stream->id();
+    if (listener_) {
+      listener_->onStreamOpened(session_id, stream->id());
+    }
+    return true;
+  }
+
+  void CreateStreamAndSignal(uint32_t session_id,
+                             uint32_t* stream_id,
+                             bool* created,
+                             base::ScopedClosureRunner signal) {
+    *created = CreateStreamOnCurrentThread(session_id, stream_id);
   }
 
   void SendOnSession(uint32_t session_id, uint32_t stream_id,
-                     const std::string& data, bool fin) {
+                     quic::QuicStringPiece data, bool fin) {
     if (session_ptrs_.count(session_id) > 0) {
       quic::QuicStream* stream =
           session_ptrs_[session_id]->GetOrCreateStream(stream_id);
@@ -502,6 +921,10 @@ class RawServerImpl : public RQuicServerInterface,
   std::mutex mtx_;
   base::MessageLoopForIO* message_loop_;
   base::RunLoop* run_loop_;
+  // Set on the IO thread before `running_` becomes true.
+  scoped_refptr<base::SingleThreadTaskRunner> task_runner_;
+  std::atomic<bool> running_;
+  RQuicSendQueue send_queue_;
   std::unique_ptr<std::thread> server_thread_;
   RQuicListener* listener_;
   int server_port_;
@@ -510,6 +933,8 @@ class RawServerImpl : public RQuicServerInterface,
   std::unordered_map<quic::QuicRawServerSession*, uint32_t> session_ids_;
   std::unordered_map<uint32_t, quic::QuicRawServerSession*> session_ptrs_;
   std::unordered_map<quic::QuicRawStream*, uint32_t> stream_sessions_;
+  // Refreshed on the IO thread, read by getStats() on any thread.
+  RQuicStatsTable stats_;
 };
 
 bool raw_factory_intialized = false;
@@ -525,7 +950,21 @@ void initialize() {
 
 RQuicClientInterface* RQuicFactory::createQuicClient() {
   initialize();
-  RQuicClientInterface* client = new RawClientImpl();
+  RQuicClientInterface* client = new RawClientImpl(nullptr);
+  return client;
+}
+
+RQuicClientContextInterface* RQuicFactory::createQuicClientContext(
+    uint32_t thread_count) {
+  initialize();
+  return new RQuicClientContextImpl(thread_count);
+}
+
+RQuicClientInterface* RQuicFactory::createQuicClient(
+    RQuicClientContextInterface* context) {
+  initialize();
+  RQuicClientInterface* client =
+      new RawClientImpl(static_cast<RQuicClientContextImpl*>(context));
   return client;
 }
 
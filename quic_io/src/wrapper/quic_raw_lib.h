@@ -5,15 +5,71 @@
 
 namespace net {
 
+// Called when the library no longer needs a buffer passed to send() with a
+// release callback. It may be called on any thread.
+typedef void (*RQuicReleaseCallback)(char* data, uint32_t len, void* context);
+
+// Received data which could be kept after the callback delivering it. It's
+// reference counted, addRef() and release() may be called on any thread.
+class RQuicBuffer {
+ public:
+  virtual const char* data() const = 0;
+  virtual uint32_t size() const = 0;
+  virtual void addRef() = 0;
+  // Destroys the buffer when the last reference is released.
+  virtual void release() = 0;
+
+ protected:
+  virtual ~RQuicBuffer() {}
+};
+
+// Statistics of a connection, as of a snapshot which the IO thread refreshes
+// periodically.
+struct RQuicConnectionStats {
+  uint64_t smoothed_rtt_us;
+  uint64_t min_rtt_us;
+  uint64_t latest_rtt_us;
+  // Estimated by the congestion controller, in bits per second.
+  uint64_t bandwidth_estimate_bps;
+  // In bytes.
+  uint64_t congestion_window;
+  uint64_t bytes_in_flight;
+  uint64_t bytes_sent;
+  uint64_t bytes_received;
+  uint64_t packets_sent;
+  uint64_t packets_received;
+  uint64_t packets_lost;
+  uint64_t packets_retransmitted;
+  // Open streams in both directions.
+  uint32_t stream_count;
+  // Time since the snapshot was taken, in milliseconds.
+  uint64_t age_ms;
+};
+
 class RQuicListener {
  public:
   RQuicListener() {}
   virtual ~RQuicListener() {}
   virtual void onReady() = 0;
-  // The session_id will not be used for client
+  // The session_id will not be used for client. `data` is only valid during
+  // the call.
   virtual void onData(uint32_t session_id,
                       uint32_t stream_id,
                       char* data, uint32_t len) = 0;
+  // Returns true to receive data with onDataBatch() instead of onData().
+  virtual bool wantsDataBatch() { return false; }
+  // Called with all regions read from a stream by one read pass. The library
+  // holds a reference of each buffer during the call, call addRef() to keep
+  // a buffer after it returns. A retained buffer could be sent without a copy
+  // by passing its data to send() along with a release callback.
+  virtual void onDataBatch(uint32_t session_id,
+                           uint32_t stream_id,
+                           RQuicBuffer* const* buffers,
+                           uint32_t count) {}
+  // Called when a stream is opened by the peer, or by createStream().
+  virtual void onStreamOpened(uint32_t session_id, uint32_t stream_id) {}
+  // Called when a stream is closed in both directions.
+  virtual void onStreamClosed(uint32_t session_id, uint32_t stream_id) {}
 };
 
 class RQuicClientInterface {
@@ -26,7 +82,26 @@ class RQuicClientInterface {
   virtual void send(const char* data, uint32_t len) = 0;
   // Send data on specified stream
   virtual void send(uint32_t stream_id, const char* data, uint32_t len) = 0;
+  // Send data on specified stream without copying it. The library takes the
+  // ownership of `data` and calls `release` once it's no longer needed.
+  virtual void send(uint32_t stream_id,
+                    char* data,
+                    uint32_t len,
+                    RQuicReleaseCallback release,
+                    void* context) = 0;
   virtual void setListener(RQuicListener* listener) = 0;
+  // Caps of receive windows of each stream and of the session, in bytes.
+  // While the reader keeps up and RTT*rate exceeds a window, the window is
+  // doubled as long as it stays within its cap, so high-BDP paths reach full
+  // throughput and other connections keep small windows. QUIC's limits of
+  // 16 MB per stream and 24 MB per session bound larger caps. 0, the default,
+  // keeps QUIC's initial window. Must be called before start().
+  virtual void setMaxReceiveWindows(uint32_t max_stream_window,
+                                    uint32_t max_session_window) = 0;
+  // Copies the latest statistics snapshot of the connection to `stats`
+  // without waiting for the IO thread. Returns false if the client is not
+  // connected.
+  virtual bool getStats(RQuicConnectionStats* stats) = 0;
 };
 
 class RQuicServerInterface {
@@ -41,13 +116,48 @@ class RQuicServerInterface {
   virtual void send(uint32_t session_id,
                     uint32_t stream_id,
                     const char* data, uint32_t len) = 0;
+  // Send data on specified session, stream without copying it. The library
+  // takes the ownership of `data` and calls `release` once it's no longer
+  // needed.
+  virtual void send(uint32_t session_id,
+                    uint32_t stream_id,
+                    char* data,
+                    uint32_t len,
+                    RQuicReleaseCallback release,
+                    void* context) = 0;
+  // Opens a bidirectional stream on `session_id`, e.g.: one for each media
+  // track, so a lost packet only blocks its own track. Returns false if the
+  // stream can't be created. Otherwise, the new stream ID is stored in
+  // `stream_id`, and onStreamOpened() is called before it returns.
+  virtual bool createStream(uint32_t session_id, uint32_t* stream_id) = 0;
+  // Closes the stream for writing after data already passed to send().
+  virtual void closeStream(uint32_t session_id, uint32_t stream_id) = 0;
   virtual int getServerPort() = 0;
   virtual void setListener(RQuicListener* listener) = 0;
+  // Copies the latest statistics snapshot of `session_id` to `stats` without
+  // waiting for the IO thread. Returns false if there is no such session.
+  virtual bool getStats(uint32_t session_id, RQuicConnectionStats* stats) = 0;
+};
+
+// A pool of IO threads shared by clients. Running many clients on a few
+// threads saves memory and context switches compared with a thread per
+// client. It must outlive clients using it.
+class RQuicClientContextInterface {
+ public:
+  virtual ~RQuicClientContextInterface() {}
 };
 
 class RQuicFactory {
  public:
+  // Creates a client running on its own IO thread.
   static RQuicClientInterface* createQuicClient();
+  // Creates a context with `thread_count` IO threads, at least 1.
+  static RQuicClientContextInterface* createQuicClientContext(
+      uint32_t thread_count);
+  // Creates a client running on an IO thread of `context`. Clients are
+  // assigned to threads round robin.
+  static RQuicClientInterface* createQuicClient(
+      RQuicClientContextInterface* context);
   static RQuicServerInterface* createQuicServer(
       const char* cert_file, const char* key_file);
 };
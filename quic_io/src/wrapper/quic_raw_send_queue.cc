@@ -0,0 +1,72 @@
+#include "net/tools/quic/raw/wrapper/quic_raw_send_queue.h"
+
+#include <algorithm>
+
+namespace net {
+
+RQuicSendRequest::RQuicSendRequest(uint32_t session_id,
+                                   uint32_t stream_id,
+                                   const char* data,
+                                   uint32_t len)
+    : session_id_(session_id),
+      stream_id_(stream_id),
+      copy_(data, len),
+      data_(&copy_[0]),
+      len_(len),
+      release_(nullptr),
+      release_context_(nullptr),
+      fin_(false),
+      next_(nullptr) {}
+
+RQuicSendRequest::RQuicSendRequest(uint32_t session_id,
+                                   uint32_t stream_id,
+                                   char* data,
+                                   uint32_t len,
+                                   RQuicReleaseCallback release,
+                                   void* context)
+    : session_id_(session_id),
+      stream_id_(stream_id),
+      data_(data),
+      len_(len),
+      release_(release),
+      release_context_(context),
+      fin_(false),
+      next_(nullptr) {}
+
+RQuicSendRequest::~RQuicSendRequest() {
+  if (release_) {
+    release_(data_, len_, release_context_);
+  }
+}
+
+RQuicSendQueue::RQuicSendQueue() : head_(nullptr) {}
+
+RQuicSendQueue::~RQuicSendQueue() {
+  PopAll();
+}
+
+bool RQuicSendQueue::Push(std::unique_ptr<RQuicSendRequest> request) {
+  RQuicSendRequest* node = request.release();
+  RQuicSendRequest* head = head_.load(std::memory_order_relaxed);
+  do {
+    node->next_ = head;
+  } while (!head_.compare_exchange_weak(head, node, std::memory_order_release,
+                                        std::memory_order_relaxed));
+  return head == nullptr;
+}
+
+std::vector<std::unique_ptr<RQuicSendRequest>> RQuicSendQueue::PopAll() {
+  std::vector<std::unique_ptr<RQuicSendRequest>> requests;
+  RQuicSendRequest* node = head_.exchange(nullptr, std::memory_order_acquire);
+  while (node) {
+    RQuicSendRequest* next = node->next_;
+    node->next_ = nullptr;
+    requests.emplace_back(node);
+    node = next;
+  }
+  // Nodes are linked from the newest one.
+  std::reverse(requests.begin(), requests.end());
+  return requests;
+}
+
+}  // namespace net
@@ -0,0 +1,85 @@
+#ifndef NET_TOOLS_QUIC_RAW_WRAPPER_QUIC_RAW_SEND_QUEUE_H_
+#define NET_TOOLS_QUIC_RAW_WRAPPER_QUIC_RAW_SEND_QUEUE_H_
+
+#include <stdint.h>
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "net/tools/quic/raw/wrapper/quic_raw_lib.h"
+
+namespace net {
+
+// Data to be sent on a stream. It either owns a copy of the data, or a buffer
+// passed by the application which is released when the request is destroyed.
+class RQuicSendRequest {
+ public:
+  // Copies `len` bytes of `data`.
+  RQuicSendRequest(uint32_t session_id,
+                   uint32_t stream_id,
+                   const char* data,
+                   uint32_t len);
+  // Takes the ownership of `data`, `release` is called with `context` when
+  // the request is destroyed.
+  RQuicSendRequest(uint32_t session_id,
+                   uint32_t stream_id,
+                   char* data,
+                   uint32_t len,
+                   RQuicReleaseCallback release,
+                   void* context);
+  RQuicSendRequest(const RQuicSendRequest&) = delete;
+  RQuicSendRequest& operator=(const RQuicSendRequest&) = delete;
+  ~RQuicSendRequest();
+
+  uint32_t session_id() const { return session_id_; }
+  uint32_t stream_id() const { return stream_id_; }
+  const char* data() const { return data_; }
+  uint32_t len() const { return len_; }
+  // Whether the stream is closed for writing after the data.
+  bool fin() const { return fin_; }
+  void set_fin(bool fin) { fin_ = fin; }
+
+ private:
+  friend class RQuicSendQueue;
+
+  const uint32_t session_id_;
+  const uint32_t stream_id_;
+  std::string copy_;
+  char* data_;
+  const uint32_t len_;
+  RQuicReleaseCallback release_;
+  void* release_context_;
+  bool fin_;
+  // Next request pushed earlier. Only used by RQuicSendQueue.
+  RQuicSendRequest* next_;
+};
+
+// A lock-free multi-producer single-consumer queue. Any thread pushes
+// requests, the IO thread takes all of them at once. Only the push onto an
+// empty queue asks for a drain, so a burst of sends from many threads costs a
+// single task on the IO thread.
+class RQuicSendQueue {
+ public:
+  RQuicSendQueue();
+  RQuicSendQueue(const RQuicSendQueue&) = delete;
+  RQuicSendQueue& operator=(const RQuicSendQueue&) = delete;
+  // Destroys remaining requests, so their buffers are released.
+  ~RQuicSendQueue();
+
+  // Returns true if the queue was empty, the caller should schedule a
+  // PopAll() call.
+  bool Push(std::unique_ptr<RQuicSendRequest> request);
+  // Returns all queued requests in the order they are pushed. Must be called
+  // on a single thread.
+  std::vector<std::unique_ptr<RQuicSendRequest>> PopAll();
+
+ private:
+  // Last pushed request. Requests are linked from newer to older ones.
+  std::atomic<RQuicSendRequest*> head_;
+};
+
+}  // namespace net
+
+#endif  // NET_TOOLS_QUIC_RAW_WRAPPER_QUIC_RAW_SEND_QUEUE_H_
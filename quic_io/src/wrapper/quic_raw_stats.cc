@@ -0,0 +1,75 @@
+#include "net/tools/quic/raw/wrapper/quic_raw_stats.h"
+
+#include "net/third_party/quic/core/congestion_control/rtt_stats.h"
+#include "net/third_party/quic/core/quic_connection.h"
+#include "net/third_party/quic/core/quic_connection_stats.h"
+#include "net/third_party/quic/core/quic_sent_packet_manager.h"
+#include "net/third_party/quic/core/quic_session.h"
+
+namespace net {
+
+void FillConnectionStats(quic::QuicSession* session,
+                         RQuicConnectionStats* stats) {
+  quic::QuicConnection* connection = session->connection();
+  const quic::QuicConnectionStats& connection_stats = connection->GetStats();
+  const quic::QuicSentPacketManager& sent_packet_manager =
+      connection->sent_packet_manager();
+  const quic::RttStats* rtt_stats = sent_packet_manager.GetRttStats();
+  stats->smoothed_rtt_us = rtt_stats->smoothed_rtt().ToMicroseconds();
+  stats->min_rtt_us = rtt_stats->min_rtt().ToMicroseconds();
+  stats->latest_rtt_us = rtt_stats->latest_rtt().ToMicroseconds();
+  stats->bandwidth_estimate_bps =
+      sent_packet_manager.BandwidthEstimate().ToBitsPerSecond();
+  stats->congestion_window = sent_packet_manager.GetCongestionWindowInBytes();
+  stats->bytes_in_flight = sent_packet_manager.GetBytesInFlight();
+  stats->bytes_sent = connection_stats.bytes_sent;
+  stats->bytes_received = connection_stats.bytes_received;
+  stats->packets_sent = connection_stats.packets_sent;
+  stats->packets_received = connection_stats.packets_received;
+  stats->packets_lost = connection_stats.packets_lost;
+  stats->packets_retransmitted = connection_stats.packets_retransmitted;
+  stats->stream_count = session->GetNumOpenIncomingStreams() +
+                        session->GetNumOpenOutgoingStreams();
+  stats->age_ms = 0;
+}
+
+RQuicStatsTable::RQuicStatsTable() {}
+
+RQuicStatsTable::~RQuicStatsTable() {}
+
+void RQuicStatsTable::Update(uint32_t session_id,
+                             const RQuicConnectionStats& stats) {
+  const base::TimeTicks now = base::TimeTicks::Now();
+  std::lock_guard<std::mutex> lock(mutex_);
+  Entry& entry = entries_[session_id];
+  entry.stats = stats;
+  entry.update_time = now;
+}
+
+void RQuicStatsTable::Remove(uint32_t session_id) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  entries_.erase(session_id);
+}
+
+void RQuicStatsTable::Clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  entries_.clear();
+}
+
+bool RQuicStatsTable::Get(uint32_t session_id,
+                          RQuicConnectionStats* stats) const {
+  base::TimeTicks update_time;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(session_id);
+    if (it == entries_.end()) {
+      return false;
+    }
+    *stats = it->second.stats;
+    update_time = it->second.update_time;
+  }
+  stats->age_ms = (base::TimeTicks::Now() - update_time).InMilliseconds();
+  return true;
+}
+
+}  // namespace net
@@ -0,0 +1,52 @@
+#ifndef NET_TOOLS_QUIC_RAW_WRAPPER_QUIC_RAW_STATS_H_
+#define NET_TOOLS_QUIC_RAW_WRAPPER_QUIC_RAW_STATS_H_
+
+#include <stdint.h>
+
+#include <mutex>
+#include <unordered_map>
+
+#include "base/time/time.h"
+#include "net/tools/quic/raw/wrapper/quic_raw_lib.h"
+
+namespace quic {
+class QuicSession;
+}  // namespace quic
+
+namespace net {
+
+// Fills `stats` from `session` and its connection, except `age_ms`. Must be
+// called on the session's thread.
+void FillConnectionStats(quic::QuicSession* session,
+                         RQuicConnectionStats* stats);
+
+// The latest statistics snapshot of each session. The IO thread updates
+// snapshots periodically, any thread reads them without waiting for the IO
+// thread.
+class RQuicStatsTable {
+ public:
+  RQuicStatsTable();
+  RQuicStatsTable(const RQuicStatsTable&) = delete;
+  RQuicStatsTable& operator=(const RQuicStatsTable&) = delete;
+  ~RQuicStatsTable();
+
+  void Update(uint32_t session_id, const RQuicConnectionStats& stats);
+  void Remove(uint32_t session_id);
+  void Clear();
+  // Copies the snapshot of `session_id` to `stats`, with its age. Returns
+  // false if there is none.
+  bool Get(uint32_t session_id, RQuicConnectionStats* stats) const;
+
+ private:
+  struct Entry {
+    RQuicConnectionStats stats;
+    base::TimeTicks update_time;
+  };
+
+  mutable std::mutex mutex_;
+  std::unordered_map<uint32_t, Entry> entries_;
+};
+
+}  // namespace net
+
+#endif  // NET_TOOLS_QUIC_RAW_WRAPPER_QUIC_RAW_STATS_H_
@@ -8,6 +8,7 @@
 #define OWT_QUIC_TRANSPORT_CLIENT_INTERFACE_H_
 
 #include "owt/quic/export.h"
+#include "owt/quic/quic_transport_definitions.h"
 #include "owt/quic/quic_transport_stream_interface.h"
 
 namespace owt {
@@ -15,6 +16,42 @@ namespace quic {
 // A client manages a QuicTransport session with a QuicTransport server.
 class OWT_EXPORT QuicTransportClientInterface {
  public:
+  struct Parameters {
+    Parameters()
+        : congestion_control(CongestionControlType::kDefault),
+          server_congestion_control(CongestionControlType::kDefault),
+          congestion_profile(CongestionProfile::kDefault),
+          inline_event_dispatch(false),
+          pooled_send_buffers(false),
+          max_stream_receive_window(0),
+          max_session_receive_window(0) {}
+    // Congestion control algorithm for data sent by this client.
+    CongestionControlType congestion_control;
+    // Congestion control algorithm the server is asked to use for this
+    // session. kDefault lets server use its own setting.
+    CongestionControlType server_congestion_control;
+    // Congestion control tuning of this session, for both directions. The
+    // server is asked to apply it with QUIC connection options. Profiles
+    // other than kDefault override `congestion_control` and
+    // `server_congestion_control`.
+    CongestionProfile congestion_profile;
+    // Calls visitor methods directly on IO thread instead of posting them to
+    // an event thread, which saves a thread hop per event. Visitors must not
+    // block.
+    bool inline_event_dispatch;
+    // Allocates stream send buffers from a pool of size classes owned by the
+    // IO thread instead of malloc.
+    bool pooled_send_buffers;
+    // Caps of receive windows of each stream and of the session, in bytes.
+    // While the reader keeps up and RTT * rate exceeds a window, the window is
+    // doubled as long as it stays within its cap, so high-BDP paths reach full
+    // throughput and other connections keep small windows. QUIC's limits of
+    // 16 MB per stream and 24 MB per session bound larger caps. 0 keeps
+    // QUIC's initial window.
+    uint32_t max_stream_receive_window;
+    uint32_t max_session_receive_window;
+  };
+
   class Visitor {
    public:
     virtual ~Visitor() = default;
@@ -22,12 +59,16 @@ class OWT_EXPORT QuicTransportClientInterface {
     virtual void OnConnected() = 0;
     // Called when the connection state changed from connecting to failed.
     virtual void OnConnectionFailed() = 0;
-    // Called when a session is closed.
+    // Called when a session is closed. The session ID is only valid during
+    // this call.
     virtual void OnConnectionClosed(char*, size_t len) = 0;
     // Called when an incoming stream is received.
     virtual void OnIncomingStream(QuicTransportStreamInterface*) = 0;
     // Called when a stream is closed
     virtual void OnStreamClosed(uint32_t id) = 0;
+    // Called with datagrams received in one round of packet processing. They
+    // are only valid during this call.
+    virtual void OnDatagramsReceived(const Datagram* datagrams, size_t count) {}
   };
 
   virtual ~QuicTransportClientInterface() = default;
@@ -37,11 +78,22 @@ class OWT_EXPORT QuicTransportClientInterface {
   // Close QuicTransport session with server.
   virtual void Stop() = 0;
 
+  // Returns connection ID as a null-terminated string. It's owned by this
+  // object and remains valid during its lifetime.
   virtual const char* Id() = 0;
+  // Length of the string returned by Id().
   virtual uint8_t length() = 0;
   // Create a bidirectional stream.
   virtual QuicTransportStreamInterface* CreateBidirectionalStream() = 0;
+  // Create a stream which only sends data. Incoming unidirectional streams are
+  // passed to Visitor::OnIncomingStream, and they only receive data.
+  virtual QuicTransportStreamInterface* CreateUnidirectionalStream() = 0;
   virtual void CloseStream(uint32_t id) = 0;
+  // Sends `count` datagrams in `batch`. Their data is copied, so buffers can
+  // be reused when it returns. Datagrams are sent asynchronously and
+  // unreliably. Those which cannot be sent, e.g. too large, congestion blocked
+  // or not connected, are dropped.
+  virtual void SendDatagrams(const Datagram* batch, size_t count) = 0;
 };
 }  // namespace quic
 }
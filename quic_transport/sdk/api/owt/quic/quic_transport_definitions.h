@@ -0,0 +1,178 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef OWT_QUIC_TRANSPORT_DEFINITIONS_H_
+#define OWT_QUIC_TRANSPORT_DEFINITIONS_H_
+
+#include <cstddef>
+#include <cstdint>
+#include "owt/quic/export.h"
+
+namespace owt {
+namespace quic {
+
+// Congestion control algorithm of a QUIC connection.
+enum class CongestionControlType {
+  // BBRv1, the algorithm used by all connections in earlier versions.
+  kDefault,
+  kCubic,
+  kReno,
+  kBbr,
+  kBbrV2,
+};
+
+// Tuning of congestion control for a kind of traffic.
+enum class CongestionProfile {
+  // Algorithms selected by CongestionControlType with their default tuning.
+  kDefault,
+  // For interactive media. Uses BBRv2 regardless of CongestionControlType,
+  // leaves STARTUP after one round without bandwidth growth, keeps cwnd close
+  // to bandwidth times min RTT, and shrinks PROBE_RTT to half of that instead
+  // of 4 packets, skipping it when quiet periods already measured min RTT.
+  // Sending stays paced, and rounds with nothing to send are signalled as
+  // app-limited so they don't lower bandwidth estimates.
+  kRealtime,
+};
+
+// An unreliable datagram sent or received in a DATAGRAM frame (RFC 9221).
+struct OWT_EXPORT Datagram {
+  const uint8_t* data;
+  size_t length;
+};
+
+// Statistics of a server, or one of its IO threads. Counters accumulate since
+// the server is started.
+struct OWT_EXPORT ServerStats {
+  // QUIC connections currently open.
+  uint64_t active_sessions;
+  // QUIC connections accepted.
+  uint64_t sessions_created;
+  // Connections accepted per second, measured over the last second.
+  uint64_t handshakes_per_second;
+  // Read passes which ended with CHLOs still buffered, because new
+  // connections were held back to keep up with established ones.
+  uint64_t chlo_backlog_passes;
+  uint64_t packets_received;
+  uint64_t bytes_received;
+  uint64_t packets_sent;
+  uint64_t bytes_sent;
+  // Packets failed to write.
+  uint64_t packets_dropped;
+  // Number of writes blocked by a full socket send buffer.
+  uint64_t write_blocked_events;
+  // Percentage of the last second an IO thread spent processing packets.
+  uint64_t loop_utilization_percent;
+  // Client address changes accepted by connections. New addresses are
+  // validated before they carry more than 3 times the data received from
+  // them. Port-only changes, usually NAT rebinding, keep congestion state and
+  // are also counted by `peer_port_changes`.
+  uint64_t peer_migrations;
+  uint64_t peer_port_changes;
+};
+
+// Memory held by sessions, in bytes unless noted otherwise. All fields are 64
+// bits.
+struct OWT_EXPORT MemoryUsage {
+  // Number of sessions and streams counted.
+  uint64_t sessions;
+  uint64_t streams;
+  // Outgoing data buffered by streams.
+  uint64_t stream_send_buffer_bytes;
+  // Received data not read from stream sequencers yet.
+  uint64_t stream_receive_buffer_bytes;
+  // Received datagrams waiting to be delivered to the event thread.
+  uint64_t datagram_buffer_bytes;
+  // Number of outgoing datagrams queued by congestion control.
+  uint64_t queued_datagrams;
+  // Size of session and stream objects, excluding memory they allocate.
+  uint64_t object_bytes;
+  // Sum of all byte fields above.
+  uint64_t total_bytes;
+};
+
+// Decides whether a connection is logged by qlog. It's called on the IO thread
+// when a connection is created, so it must not block.
+using QlogFilter = bool (*)(const char* peer_address,
+                            const char* connection_id,
+                            void* context);
+
+// Options of qlog output. Each logged connection is written to its own file
+// under `directory` in JSON-SEQ format (draft-ietf-quic-qlog-main-schema),
+// named by its server connection ID. Events are serialized on the IO thread
+// and written to files by a background thread.
+struct OWT_EXPORT QlogOptions {
+  // Created if it doesn't exist.
+  const char* directory;
+  // Fraction of connections logged, 0.0 - 1.0. e.g.: 0.01 logs 1% of
+  // connections.
+  double sampling_rate;
+  // Connections `filter` returns true for are always logged, other
+  // connections are sampled by `sampling_rate`. It could be nullptr.
+  QlogFilter filter;
+  void* filter_context;
+};
+
+// Impairments applied to packets a server sends, for tests and benchmarks
+// under realistic network conditions. Packets are held in memory until
+// they're due, and then written to the socket. Runs with the same `seed` and
+// traffic drop and reorder the same packets. Never use it in production.
+struct OWT_EXPORT NetworkEmulationOptions {
+  NetworkEmulationOptions()
+      : delay_ms(0),
+        jitter_ms(0),
+        loss_rate(0),
+        burst_loss_rate(0),
+        burst_length(0),
+        reorder_rate(0),
+        bandwidth_bps(0),
+        queue_bytes(0),
+        seed(0) {}
+  // One way delay added to each packet. Each packet is delayed by up to
+  // `jitter_ms` more, jitter alone doesn't reorder packets.
+  uint32_t delay_ms;
+  uint32_t jitter_ms;
+  // Probability a packet is dropped, 0.0 - 1.0.
+  double loss_rate;
+  // Probability a burst loss starts at a packet, 0.0 - 1.0. Bursts drop
+  // `burst_length` consecutive packets on average, 0 means 1.
+  double burst_loss_rate;
+  uint32_t burst_length;
+  // Probability a packet skips the delay, so it arrives before packets sent
+  // earlier, 0.0 - 1.0.
+  double reorder_rate;
+  // Rate of the bottleneck link, in bits per second. 0 is unlimited.
+  uint64_t bandwidth_bps;
+  // Packets arriving when the link's queue has more than this many bytes are
+  // dropped. 0 is unlimited. Ignored when bandwidth is unlimited.
+  uint32_t queue_bytes;
+  uint64_t seed;
+};
+
+// Called when the SDK no longer needs a buffer whose ownership is transferred
+// to the SDK. `data` and `length` describe the buffer, `context` is the value
+// passed along with the buffer. It may be called on any thread.
+using BufferReleaseCallback = void (*)(uint8_t* data,
+                                       size_t length,
+                                       void* context);
+
+// Runs tasks of the SDK on a thread owned by the application, e.g. the thread
+// of its own event loop. Tasks must run sequentially on the same thread, in
+// the order they become due, and each of them exactly once.
+class OWT_EXPORT EventExecutorInterface {
+ public:
+  using Task = void (*)(void* context);
+  virtual ~EventExecutorInterface() = default;
+  // Runs `task` with `context` after `delay_ms` milliseconds. It may be called
+  // on any thread.
+  virtual void PostTask(Task task, void* context, uint64_t delay_ms) = 0;
+  // Returns true if it's called on the thread running tasks.
+  virtual bool IsCurrentThread() const = 0;
+};
+
+}  // namespace quic
+}  // namespace owt
+
+#endif
@@ -8,22 +8,29 @@
 #define OWT_QUIC_TRANSPORT_FACTORY_H_
 
 #include "owt/quic/export.h"
+#include "owt/quic/quic_transport_client_interface.h"
+#include "owt/quic/quic_transport_server_interface.h"
 
 namespace owt {
 namespace quic {
 
-class QuicTransportServerInterface;
-class QuicTransportClientInterface;
 
 class OWT_EXPORT QuicTransportFactory {
  public:
   virtual ~QuicTransportFactory() = default;
 
-  /// Create a QuicTransportFactory.
+  /// Create a QuicTransportFactory. Process wide state is initialized by the
+  /// first factory, and threads are started when the first server or client
+  /// is created.
   static QuicTransportFactory* Create();
   /// Create a QuicTransportFactory for testing. It will not initialize
   /// AtExitManager since testing tools will initialize one.
   static QuicTransportFactory* CreateForTesting();
+  // Delivers events of servers and clients created after this call with
+  // `executor` instead of the factory's event thread, which is stopped.
+  // `executor` must outlive this factory and everything created by it. It must
+  // be called before creating any server or client.
+  virtual void SetEventExecutor(EventExecutorInterface* executor) = 0;
   // Create a server directly over Quic with certificate, key and secret
   // file. Ownership of returned value is moved to caller. Returns nullptr if
   // creation is failed.
@@ -38,11 +45,28 @@ class OWT_EXPORT QuicTransportFactory {
       int port,
       const char* pfx_path,
       const char* password) = 0;
+  // Same as above, but the server is created with `options`.
+  virtual QuicTransportServerInterface* CreateQuicTransportServer(
+      int port,
+      const char* cert_file,
+      const char* key_file,
+      const char* secret_path,
+      const QuicTransportServerInterface::Options& options) = 0;
+  virtual QuicTransportServerInterface* CreateQuicTransportServer(
+      int port,
+      const char* pfx_path,
+      const char* password,
+      const QuicTransportServerInterface::Options& options) = 0;
   // Create a Quic client. It will not connect to the given
   // `url` immediately after creation.
   virtual QuicTransportClientInterface* CreateQuicTransportClient(
       const char* host,
       int port) = 0;
+  // Create a Quic client with parameters.
+  virtual QuicTransportClientInterface* CreateQuicTransportClient(
+      const char* host,
+      int port,
+      const QuicTransportClientInterface::Parameters& parameters) = 0;
 };
 }  // namespace quic
 }
@@ -7,7 +7,11 @@
 #ifndef OWT_QUIC_TRANSPORT_SERVER_INTERFACE_H_
 #define OWT_QUIC_TRANSPORT_SERVER_INTERFACE_H_
 
+#include <stddef.h>
+#include <stdint.h>
+
 #include "owt/quic/export.h"
+#include "owt/quic/quic_transport_definitions.h"
 #include "owt/quic/quic_transport_session_interface.h"
 
 namespace owt {
@@ -22,14 +26,129 @@ class OWT_EXPORT QuicTransportServerInterface {
     virtual void OnEnded() = 0;
     // Called when a new session is created.
     virtual void OnSession(QuicTransportSessionInterface*) = 0;
-    // Called when a session is closed.
+    // Called when a session is closed. The session ID is only valid during
+    // this call.
     virtual void OnClosedSession(char*, size_t len) = 0;
   };
+  // Options applied when a server is created. 0 means the default value.
+  struct Options {
+    Options()
+        : socket_receive_buffer_size(0),
+          socket_send_buffer_size(0),
+          initial_stream_flow_control_window(0),
+          initial_session_flow_control_window(0),
+          max_incoming_bidirectional_streams(0),
+          max_incoming_unidirectional_streams(0),
+          idle_timeout_ms(0),
+          max_packets_per_read(0),
+          max_new_connections_per_read(0),
+          congestion_control(CongestionControlType::kDefault),
+          event_thread_count(0),
+          inline_event_dispatch(false),
+          signing_thread_count(0),
+          pooled_send_buffers(false),
+          buffer_numa_node(-1),
+          huge_page_buffers(false),
+          network_emulation(nullptr) {}
+    // Sizes of the UDP socket's kernel buffers, in bytes. The kernel may cap
+    // them, e.g. by net.core.rmem_max on Linux.
+    size_t socket_receive_buffer_size;
+    size_t socket_send_buffer_size;
+    // Flow control windows advertised to clients, in bytes.
+    uint32_t initial_stream_flow_control_window;
+    uint32_t initial_session_flow_control_window;
+    // Max number of streams a client could open concurrently.
+    uint32_t max_incoming_bidirectional_streams;
+    uint32_t max_incoming_unidirectional_streams;
+    // A connection is closed if it has no network activity for this period.
+    uint32_t idle_timeout_ms;
+    // Read budgets. Max number of packets read, and max number of new
+    // connections created, before yielding to other tasks.
+    uint32_t max_packets_per_read;
+    uint32_t max_new_connections_per_read;
+    // Congestion control algorithm of connections. A client could ask for
+    // another one for its session with QUIC connection options.
+    CongestionControlType congestion_control;
+    // Number of threads running session and stream visitor callbacks. Each
+    // session is pinned to one of them, so callbacks of a session are never
+    // called concurrently, but callbacks of different sessions could be.
+    // Default value is 1.
+    size_t event_thread_count;
+    // Calls visitor methods directly on IO thread instead of posting them to
+    // an event thread, which saves a thread hop per event. Visitors must not
+    // block. `event_thread_count` is ignored when it's true.
+    bool inline_event_dispatch;
+    // Number of threads computing handshake signatures with the server's
+    // private key, so a burst of handshakes doesn't delay packets of
+    // established sessions. 0 means signatures are computed on IO threads.
+    size_t signing_thread_count;
+    // Allocates stream send buffers from a pool of size classes owned by the
+    // IO thread instead of malloc. The pool caches up to a few MB of freed
+    // buffers.
+    bool pooled_send_buffers;
+    // When `pooled_send_buffers` is true, the pool's buffers are allocated on
+    // this NUMA node, which should be the node of the CPUs running the IO
+    // thread. -1, the default value, leaves it to the OS.
+    int32_t buffer_numa_node;
+    // Backs the pool's buffers with 2 MB huge pages, so packet processing
+    // touches fewer TLB entries. Reserved huge pages are used if there are
+    // enough, otherwise transparent huge pages are requested. Linux and
+    // Windows only, Windows requires the "Lock pages in memory" privilege.
+    // With either option, the pool keeps its buffers until the server is
+    // destroyed, instead of caching up to a few MB.
+    bool huge_page_buffers;
+    // Emulates network conditions on packets sent by the server, see
+    // NetworkEmulationOptions. It's copied when the server is created.
+    // nullptr, the default value, sends packets as is.
+    const NetworkEmulationOptions* network_emulation;
+  };
+  // Describes server connection IDs which can be routed by a load balancer to
+  // this server, as specified by draft-ietf-quic-load-balancers. A connection
+  // ID is a first octet, `server_id` and a nonce.
+  struct ConnectionIdRoutingConfig {
+    // 0 - 6.
+    uint8_t config_id;
+    const uint8_t* server_id;
+    size_t server_id_length;
+    // A 16 bytes AES-128 key, or nullptr if connection IDs are not encrypted.
+    // Encrypted connection IDs are always 17 bytes.
+    const uint8_t* key;
+    // Length of connection IDs, including the first octet.
+    uint8_t connection_id_length;
+  };
   virtual ~QuicTransportServerInterface() = default;
   virtual int Start() = 0;
+  // Closes all connections and the socket, and then calls Visitor::OnEnded on
+  // the event thread.
   virtual void Stop() = 0;
+  // Stops accepting new connections, and waits for existing ones to be
+  // closed by their clients or by idle timeout. Connections still open after
+  // `timeout_ms` are closed, and then the server is stopped like Stop(). It
+  // returns immediately. Raw QUIC has no GOAWAY, so applications should ask
+  // their clients to leave with their own messages.
+  virtual void Drain(uint32_t timeout_ms) = 0;
   virtual void SetVisitor(Visitor* visitor) = 0;
   virtual int GetListenPort() = 0;
+  // Makes server connection IDs routable by a load balancer. Returns false if
+  // `config` is invalid. Must be called before Start().
+  virtual bool SetConnectionIdRouting(
+      const ConnectionIdRoutingConfig& config) = 0;
+  // Writes qlog traces of connections selected by `options`. Returns false if
+  // `options` is invalid or the directory cannot be created. Must be called
+  // before Start().
+  virtual bool EnableQlog(const QlogOptions& options) = 0;
+  // Returns statistics summed over all IO threads. The IO thread updates its
+  // counters without locks, so reading them never blocks packet processing.
+  // It could be called on any thread. Values are 0 before Start().
+  virtual ServerStats GetServerStats() = 0;
+  // Copies statistics of up to `max_count` IO threads to `stats`. Returns the
+  // number of IO threads.
+  virtual size_t GetIoThreadStats(ServerStats* stats, size_t max_count) = 0;
+  // Returns memory held by all sessions. The IO thread publishes it every
+  // second, so it could be up to a second old. It could be called on any
+  // thread. The usage is also reported to Chromium's memory-infra as dumps
+  // under "owt_quic/quic_transport_server".
+  virtual MemoryUsage GetMemoryUsage() = 0;
 };
 }  // namespace quic
 }
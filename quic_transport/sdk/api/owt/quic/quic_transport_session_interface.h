@@ -8,6 +8,7 @@
 #define OWT_QUIC_TRANSPORT_SESSION_INTERFACE_H_
 
 #include "owt/quic/export.h"
+#include "owt/quic/quic_transport_definitions.h"
 #include "owt/quic/quic_transport_stream_interface.h"
 
 namespace owt {
@@ -18,15 +19,41 @@ class OWT_EXPORT QuicTransportSessionInterface {
    public:
     virtual ~Visitor() = default;
     virtual void OnIncomingStream(QuicTransportStreamInterface*) = 0;
+    // Called when stream `id` is closed. The stream has been released, its
+    // visitor got QuicTransportStreamInterface::Visitor::OnClosed before.
     virtual void OnStreamClosed(uint32_t id) = 0;
+    // Called with datagrams received in one round of packet processing. They
+    // are only valid during this call.
+    virtual void OnDatagramsReceived(const Datagram* datagrams, size_t count) {}
   };
   virtual ~QuicTransportSessionInterface() = default;
   virtual void SetVisitor(Visitor* visitor) = 0;
   virtual void Stop() = 0;
   virtual QuicTransportStreamInterface* CreateBidirectionalStream() = 0;
+  // Creates a stream which only sends data. Incoming unidirectional streams
+  // are passed to Visitor::OnIncomingStream, and they only receive data.
+  virtual QuicTransportStreamInterface* CreateUnidirectionalStream() = 0;
+  // Returns connection ID as a null-terminated string. It's owned by this
+  // object and remains valid during its lifetime.
   virtual const char* Id() = 0;
+  // Length of the string returned by Id().
   virtual uint8_t length() = 0;
   virtual void CloseStream(uint32_t id) = 0;
+  // Sends `count` datagrams in `batch`. Their data is copied, so buffers can
+  // be reused when it returns. Datagrams are sent asynchronously and
+  // unreliably. Those which cannot be sent, e.g. too large or congestion
+  // blocked, are dropped.
+  virtual void SendDatagrams(const Datagram* batch, size_t count) = 0;
+  // Caps the rate of data sent by this session, retransmissions and datagrams
+  // included, to `bits_per_second`. It's enforced by the pacer, so packets are
+  // spread evenly instead of sent in bursts, and congestion control measures
+  // bandwidth under the cap instead of competing with it. Bursts are bounded
+  // by QUIC's pacing burst, 10 packets after the connection is idle. 0
+  // removes the cap, which is the default. It returns immediately.
+  virtual void SetMaxSendRate(uint64_t bits_per_second) = 0;
+  // Returns memory held by this session and its streams. It's computed on IO
+  // thread, so it blocks when it's called on other threads.
+  virtual MemoryUsage GetMemoryUsage() = 0;
 };
 }  // namespace quic
 }
@@ -8,6 +8,7 @@
 #define OWT_QUIC_TRANSPORT_STREAM_INTERFACE_H_
 
 #include "owt/quic/export.h"
+#include "owt/quic/quic_transport_definitions.h"
 #include "stddef.h"
 #include "stdint.h"
 
@@ -15,18 +16,62 @@ namespace owt {
 namespace quic {
 class OWT_EXPORT QuicTransportStreamInterface {
  public:
+  // A contiguous region of received data.
+  struct DataRegion {
+    char* data;
+    size_t len;
+  };
   class Visitor {
    public:
     virtual ~Visitor() = default;
     // Called when new data is available.
     virtual void OnData(QuicTransportStreamInterface* stream, char* data, size_t len) = 0;
+    // Called with all readable regions of `stream` at once. Regions are
+    // consumed after this call returns. The default implementation calls
+    // OnData for each region, override it to handle them in a batch.
+    virtual void OnDataRegions(QuicTransportStreamInterface* stream,
+                               const DataRegion* regions,
+                               size_t count) {
+      for (size_t i = 0; i < count; i++) {
+        OnData(stream, regions[i].data, regions[i].len);
+      }
+    }
+    // Called with a complete message in message mode, instead of OnData and
+    // OnDataRegions. `data` is only valid during this call.
+    virtual void OnMessage(QuicTransportStreamInterface* stream,
+                           const uint8_t* data,
+                           size_t len) {}
+    // Called when the peer finished sending, after all data is delivered.
+    virtual void OnFinReceived(QuicTransportStreamInterface* stream) {}
+    // Called when the peer resets the stream with `error_code`.
+    virtual void OnReset(QuicTransportStreamInterface* stream,
+                         uint64_t error_code) {}
+    // Called when both directions of `stream` are closed. `stream` is
+    // released by the SDK after this call, it must not be used anymore.
+    virtual void OnClosed(QuicTransportStreamInterface* stream) {}
   };
   virtual ~QuicTransportStreamInterface() = default;
   // QUIC stream ID.
   virtual uint32_t Id() const = 0;
   virtual void SetVisitor(Visitor* visitor) = 0;
   virtual void SendData(char* data, size_t len) = 0;
-  // Close the stream.
+  // Same as above, but the ownership of `data` is transferred to the SDK, and
+  // it is not copied. `release` is called with `release_context` once the SDK
+  // no longer needs `data`. `release` could be nullptr.
+  virtual void SendData(uint8_t* data,
+                        size_t len,
+                        BufferReleaseCallback release,
+                        void* release_context) = 0;
+  // Switches received data to message mode, where it's parsed as messages
+  // prefixed by their length as QUIC variable-length integers. Call it before
+  // SetVisitor to parse the stream from its first byte. Messages larger than
+  // 16 MB reset the stream.
+  virtual void EnableMessageMode() = 0;
+  // Sends `data` as a single message, its length prefix and body are written
+  // together. It can be read by a peer in message mode.
+  virtual void SendMessage(const uint8_t* data, size_t len) = 0;
+  // Finishes sending with a FIN. Data can still be received until the peer
+  // finishes sending.
   virtual void Close() = 0;
 };
 }  // namespace quic
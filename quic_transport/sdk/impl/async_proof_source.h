@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef QUIC_TRANSPORT_ASYNC_PROOF_SOURCE_H_
+#define QUIC_TRANSPORT_ASYNC_PROOF_SOURCE_H_
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include "base/task/single_thread_task_runner.h"
+#include "base/threading/thread.h"
+#include "net/third_party/quiche/src/quiche/quic/core/crypto/proof_source.h"
+
+namespace owt {
+namespace quic {
+
+// Wraps a ProofSource, e.g.: ProofSourceOwt or net::ProofSourceChromium, and
+// runs its signing operations on a pool of signing threads, so the handshakes
+// of new connections don't block packet processing of established ones on IO
+// threads. Callbacks are run asynchronously on the thread calling GetProof or
+// ComputeTlsSignature. The wrapped ProofSource's GetProof and
+// ComputeTlsSignature must be safe to be called concurrently.
+class AsyncProofSource : public ::quic::ProofSource {
+ public:
+  // `thread_count` must be positive.
+  AsyncProofSource(std::unique_ptr<::quic::ProofSource> proof_source,
+                   size_t thread_count);
+  ~AsyncProofSource() override;
+  AsyncProofSource(const AsyncProofSource&) = delete;
+  AsyncProofSource& operator=(const AsyncProofSource&) = delete;
+
+  size_t thread_count() const { return threads_.size(); }
+
+  // Overrides quic::ProofSource.
+  void GetProof(const ::quic::QuicSocketAddress& server_address,
+                const ::quic::QuicSocketAddress& client_address,
+                const std::string& hostname,
+                const std::string& server_config,
+                ::quic::QuicTransportVersion quic_version,
+                absl::string_view chlo_hash,
+                std::unique_ptr<Callback> callback) override;
+
+  ::quiche::QuicheReferenceCountedPointer<::quic::ProofSource::Chain> GetCertChain(
+      const ::quic::QuicSocketAddress& server_address,
+      const ::quic::QuicSocketAddress& client_address,
+      const std::string& hostname,
+      bool* cert_matched_sni) override;
+
+  void ComputeTlsSignature(
+      const ::quic::QuicSocketAddress& server_address,
+      const ::quic::QuicSocketAddress& client_address,
+      const std::string& hostname,
+      uint16_t signature_algorithm,
+      absl::string_view in,
+      std::unique_ptr<SignatureCallback> callback) override;
+
+  absl::InlinedVector<uint16_t, 8> SupportedTlsSignatureAlgorithms()
+      const override;
+
+  TicketCrypter* GetTicketCrypter() override;
+
+ private:
+  // Picks signing threads in turn.
+  base::SingleThreadTaskRunner* NextSigningRunner();
+
+  // Must outlive `threads_`, since tasks running on them use it.
+  std::unique_ptr<::quic::ProofSource> proof_source_;
+  std::vector<std::unique_ptr<base::Thread>> threads_;
+  // GetProof and ComputeTlsSignature could be called by multiple IO threads.
+  std::atomic<size_t> next_thread_;
+};
+
+}  // namespace quic
+}  // namespace owt
+
+#endif
@@ -0,0 +1,50 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "owt/quic_transport/sdk/impl/event_thread_pool.h"
+
+#include "base/check.h"
+#include "base/containers/span.h"
+#include "base/hash/hash.h"
+#include "base/message_loop/message_pump_type.h"
+#include "base/strings/string_number_conversions.h"
+
+namespace owt {
+namespace quic {
+
+EventThreadPool::EventThreadPool(
+    scoped_refptr<base::SingleThreadTaskRunner> default_runner,
+    size_t thread_count) {
+  CHECK(default_runner);
+  runners_.push_back(std::move(default_runner));
+  for (size_t i = 1; i < thread_count; i++) {
+    auto thread = std::make_unique<base::Thread>("quic_transport_event_thread_" +
+                                                 base::NumberToString(i));
+    thread->StartWithOptions(
+        base::Thread::Options(base::MessagePumpType::IO, 0));
+    runners_.push_back(thread->task_runner());
+    threads_.push_back(std::move(thread));
+  }
+}
+
+EventThreadPool::~EventThreadPool() {
+  for (auto& thread : threads_) {
+    thread->Stop();
+  }
+}
+
+base::SingleThreadTaskRunner* EventThreadPool::GetTaskRunner(
+    absl::string_view key) const {
+  if (runners_.size() == 1) {
+    return default_runner();
+  }
+  const uint32_t hash = base::PersistentHash(
+      base::as_bytes(base::make_span(key.data(), key.size())));
+  return runners_[hash % runners_.size()].get();
+}
+
+}  // namespace quic
+}  // namespace owt
@@ -0,0 +1,48 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef QUIC_TRANSPORT_EXTERNAL_TASK_RUNNER_H_
+#define QUIC_TRANSPORT_EXTERNAL_TASK_RUNNER_H_
+
+#include "base/callback.h"
+#include "base/location.h"
+#include "base/task/single_thread_task_runner.h"
+#include "base/time/time.h"
+#include "owt/quic/quic_transport_definitions.h"
+
+namespace owt {
+namespace quic {
+
+// A task runner posting tasks to an EventExecutorInterface provided by the
+// application. Since the executor runs tasks sequentially on one thread, it's
+// a SingleThreadTaskRunner. `executor` must outlive this task runner and all
+// tasks posted to it.
+class ExternalTaskRunner : public base::SingleThreadTaskRunner {
+ public:
+  explicit ExternalTaskRunner(EventExecutorInterface* executor);
+  ExternalTaskRunner(const ExternalTaskRunner&) = delete;
+  ExternalTaskRunner& operator=(const ExternalTaskRunner&) = delete;
+
+  // Overrides base::SingleThreadTaskRunner.
+  bool PostDelayedTask(const base::Location& from_here,
+                       base::OnceClosure task,
+                       base::TimeDelta delay) override;
+  bool PostNonNestableDelayedTask(const base::Location& from_here,
+                                  base::OnceClosure task,
+                                  base::TimeDelta delay) override;
+  bool RunsTasksInCurrentSequence() const override;
+
+ private:
+  ~ExternalTaskRunner() override;
+  static void RunTask(void* context);
+
+  EventExecutorInterface* executor_;
+};
+
+}  // namespace quic
+}  // namespace owt
+
+#endif
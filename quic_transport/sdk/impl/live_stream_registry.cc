@@ -0,0 +1,48 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "owt/quic_transport/sdk/impl/live_stream_registry.h"
+
+#include <utility>
+
+namespace owt {
+namespace quic {
+
+LiveStreamRegistry::LiveStreamRegistry() = default;
+
+LiveStreamRegistry::~LiveStreamRegistry() = default;
+
+void LiveStreamRegistry::Add(uint32_t id,
+                             ::quic::QuicTransportOwtStreamImpl* stream) {
+  base::AutoLock lock(lock_);
+  streams_[id] = stream;
+}
+
+void LiveStreamRegistry::Remove(uint32_t id) {
+  base::AutoLock lock(lock_);
+  streams_.erase(id);
+}
+
+void LiveStreamRegistry::Clear() {
+  base::AutoLock lock(lock_);
+  streams_.clear();
+}
+
+bool LiveStreamRegistry::RunIfAlive(
+    uint32_t id,
+    base::OnceCallback<void(::quic::QuicTransportOwtStreamImpl*)> callback)
+    const {
+  base::AutoLock lock(lock_);
+  auto it = streams_.find(id);
+  if (it == streams_.end()) {
+    return false;
+  }
+  std::move(callback).Run(it->second);
+  return true;
+}
+
+}  // namespace quic
+}  // namespace owt
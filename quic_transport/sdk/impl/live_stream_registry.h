@@ -0,0 +1,63 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef QUIC_TRANSPORT_LIVE_STREAM_REGISTRY_H_
+#define QUIC_TRANSPORT_LIVE_STREAM_REGISTRY_H_
+
+#include <cstdint>
+#include <unordered_map>
+
+#include "base/callback.h"
+#include "base/memory/ref_counted.h"
+#include "base/synchronization/lock.h"
+
+namespace quic {
+class QuicTransportOwtStreamImpl;
+}
+
+namespace owt {
+namespace quic {
+
+// Incoming streams whose notification is posted to the event thread. Tasks
+// post stream IDs rather than stream pointers, since a stream could be closed
+// and released on the IO thread before the task runs. The IO thread adds a
+// stream before posting its ID, and removes it before the stream is released.
+// RunIfAlive() holds the lock while the callback runs, so Remove() waits for it
+// and the stream is not released while it's in use. It's ref counted because
+// posted tasks may outlive the session.
+class LiveStreamRegistry
+    : public base::RefCountedThreadSafe<LiveStreamRegistry> {
+ public:
+  LiveStreamRegistry();
+  LiveStreamRegistry(const LiveStreamRegistry&) = delete;
+  LiveStreamRegistry& operator=(const LiveStreamRegistry&) = delete;
+
+  // Called on the IO thread.
+  void Add(uint32_t id, ::quic::QuicTransportOwtStreamImpl* stream);
+  void Remove(uint32_t id);
+  // Removes all streams, e.g.: when the session is destroyed.
+  void Clear();
+
+  // Called on the event thread. Runs `callback` with the stream if it's not
+  // released, and returns false otherwise. `callback` must not call back into
+  // the registry, or wait for the IO thread.
+  bool RunIfAlive(
+      uint32_t id,
+      base::OnceCallback<void(::quic::QuicTransportOwtStreamImpl*)> callback)
+      const;
+
+ private:
+  friend class base::RefCountedThreadSafe<LiveStreamRegistry>;
+  ~LiveStreamRegistry();
+
+  mutable base::Lock lock_;
+  std::unordered_map<uint32_t, ::quic::QuicTransportOwtStreamImpl*> streams_;
+};
+
+}  // namespace quic
+}  // namespace owt
+
+#endif  // QUIC_TRANSPORT_LIVE_STREAM_REGISTRY_H_
@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "owt/quic_transport/sdk/impl/message_framer.h"
+
+#include <algorithm>
+
+#include "net/third_party/quiche/src/quiche/common/quiche_data_reader.h"
+#include "net/third_party/quiche/src/quiche/common/quiche_data_writer.h"
+
+namespace owt {
+namespace quic {
+
+namespace {
+// Returns the length of a variable-length integer starting with `first_byte`.
+size_t VarIntLength(char first_byte) {
+  return static_cast<size_t>(1) << (static_cast<uint8_t>(first_byte) >> 6);
+}
+
+uint64_t DecodeVarInt(absl::string_view encoded) {
+  quiche::QuicheDataReader reader(encoded);
+  uint64_t value = 0;
+  reader.ReadVarInt62(&value);
+  return value;
+}
+}  // namespace
+
+MessageFramer::MessageFramer(uint64_t max_message_size)
+    : max_message_size_(max_message_size),
+      has_message_length_(false),
+      message_length_(0) {}
+
+MessageFramer::~MessageFramer() = default;
+
+std::string MessageFramer::Frame(absl::string_view message) {
+  const size_t length_size =
+      quiche::QuicheDataWriter::GetVarInt62Len(message.size());
+  std::string framed(length_size + message.size(), '\0');
+  quiche::QuicheDataWriter writer(framed.size(), &framed[0]);
+  writer.WriteVarInt62(message.size());
+  writer.WriteStringPiece(message);
+  return framed;
+}
+
+bool MessageFramer::ReadLength(absl::string_view* data) {
+  if (length_buffer_.empty() && data->size() >= VarIntLength((*data)[0])) {
+    const size_t length_size = VarIntLength((*data)[0]);
+    message_length_ = DecodeVarInt(data->substr(0, length_size));
+    data->remove_prefix(length_size);
+    return true;
+  }
+  if (length_buffer_.empty()) {
+    length_buffer_.push_back((*data)[0]);
+    data->remove_prefix(1);
+  }
+  const size_t length_size = VarIntLength(length_buffer_[0]);
+  const size_t bytes_to_copy =
+      std::min(length_size - length_buffer_.size(), data->size());
+  length_buffer_.append(data->data(), bytes_to_copy);
+  data->remove_prefix(bytes_to_copy);
+  if (length_buffer_.size() < length_size) {
+    return false;
+  }
+  message_length_ = DecodeVarInt(length_buffer_);
+  length_buffer_.clear();
+  return true;
+}
+
+bool MessageFramer::Process(absl::string_view data,
+                            MessageCallback on_message) {
+  while (!data.empty()) {
+    if (!has_message_length_) {
+      if (!ReadLength(&data)) {
+        return true;
+      }
+      if (message_length_ > max_message_size_) {
+        return false;
+      }
+      has_message_length_ = true;
+    }
+    if (message_buffer_.empty() && data.size() >= message_length_) {
+      // The whole message is in `data`.
+      on_message(data.substr(0, message_length_));
+      data.remove_prefix(message_length_);
+      has_message_length_ = false;
+      continue;
+    }
+    // `message_buffer_` grows with received bytes rather than the declared
+    // length, so a peer can't make the framer allocate memory it never sends.
+    const size_t bytes_to_copy =
+        std::min<uint64_t>(message_length_ - message_buffer_.size(),
+                           data.size());
+    message_buffer_.append(data.data(), bytes_to_copy);
+    data.remove_prefix(bytes_to_copy);
+    if (message_buffer_.size() == message_length_) {
+      on_message(message_buffer_);
+      message_buffer_.clear();
+      has_message_length_ = false;
+    }
+  }
+  return true;
+}
+
+}  // namespace quic
+}  // namespace owt
@@ -0,0 +1,59 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef QUIC_TRANSPORT_MESSAGE_FRAMER_H_
+#define QUIC_TRANSPORT_MESSAGE_FRAMER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "absl/functional/function_ref.h"
+#include "absl/strings/string_view.h"
+
+namespace owt {
+namespace quic {
+
+// Frames messages on a stream. Each message is prefixed by its length, encoded
+// as a QUIC variable-length integer (RFC 9000 section 16).
+class MessageFramer {
+ public:
+  using MessageCallback = absl::FunctionRef<void(absl::string_view message)>;
+
+  // Messages longer than `max_message_size` are rejected.
+  explicit MessageFramer(uint64_t max_message_size);
+  MessageFramer(const MessageFramer&) = delete;
+  MessageFramer& operator=(const MessageFramer&) = delete;
+  ~MessageFramer();
+
+  // Returns `message` with its length prefix.
+  static std::string Frame(absl::string_view message);
+
+  // Parses `data`, which follows data passed previously, and calls
+  // `on_message` for every complete message. A message within `data` points to
+  // `data` without a copy. Only a message split across calls is assembled in
+  // an internal buffer. Returns false if a message is too large, and the
+  // framer cannot be used anymore.
+  bool Process(absl::string_view data, MessageCallback on_message);
+
+ private:
+  // Consumes length prefix bytes from `data`. Returns true when the length of
+  // the next message is known.
+  bool ReadLength(absl::string_view* data);
+
+  const uint64_t max_message_size_;
+  // Bytes of a length prefix split across calls.
+  std::string length_buffer_;
+  // Body of a message split across calls.
+  std::string message_buffer_;
+  bool has_message_length_;
+  uint64_t message_length_;
+};
+
+}  // namespace quic
+}  // namespace owt
+
+#endif  // QUIC_TRANSPORT_MESSAGE_FRAMER_H_
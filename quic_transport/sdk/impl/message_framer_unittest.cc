@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "owt/quic_transport/sdk/impl/message_framer.h"
+
+#include <string>
+#include <vector>
+
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace owt {
+namespace quic {
+namespace test {
+
+namespace {
+// Feeds `data` to `framer` in chunks of `chunk_size` bytes.
+bool ProcessInChunks(MessageFramer* framer,
+                     const std::string& data,
+                     size_t chunk_size,
+                     std::vector<std::string>* messages) {
+  for (size_t offset = 0; offset < data.size(); offset += chunk_size) {
+    const bool result = framer->Process(
+        absl::string_view(data).substr(offset, chunk_size),
+        [messages](absl::string_view message) {
+          messages->emplace_back(message);
+        });
+    if (!result) {
+      return false;
+    }
+  }
+  return true;
+}
+}  // namespace
+
+TEST(MessageFramerTest, MessagesInOneCall) {
+  MessageFramer framer(1024);
+  const std::string data = MessageFramer::Frame("hello") +
+                           MessageFramer::Frame("") +
+                           MessageFramer::Frame("world");
+  std::vector<std::string> messages;
+  EXPECT_TRUE(ProcessInChunks(&framer, data, data.size(), &messages));
+  EXPECT_EQ(messages, (std::vector<std::string>{"hello", "", "world"}));
+}
+
+TEST(MessageFramerTest, FragmentedLength) {
+  MessageFramer framer(1024 * 1024);
+  // 300 and 70000 bytes need 2 and 4 bytes length prefixes.
+  const std::string first(300, 'a');
+  const std::string second(70000, 'b');
+  const std::string data =
+      MessageFramer::Frame(first) + MessageFramer::Frame(second);
+  ASSERT_EQ(data.size(), 2 + first.size() + 4 + second.size());
+  std::vector<std::string> messages;
+  EXPECT_TRUE(ProcessInChunks(&framer, data, 1, &messages));
+  ASSERT_EQ(messages.size(), 2u);
+  EXPECT_EQ(messages[0], first);
+  EXPECT_EQ(messages[1], second);
+}
+
+TEST(MessageFramerTest, FragmentedMessage) {
+  for (size_t chunk_size : {2u, 3u, 7u, 1000u}) {
+    MessageFramer framer(1024 * 1024);
+    const std::string message(5000, 'c');
+    const std::string data =
+        MessageFramer::Frame(message) + MessageFramer::Frame("tail");
+    std::vector<std::string> messages;
+    EXPECT_TRUE(ProcessInChunks(&framer, data, chunk_size, &messages));
+    EXPECT_EQ(messages, (std::vector<std::string>{message, "tail"}))
+        << "chunk_size: " << chunk_size;
+  }
+}
+
+TEST(MessageFramerTest, RejectsOversizedLength) {
+  MessageFramer framer(100);
+  std::vector<std::string> messages;
+  EXPECT_TRUE(ProcessInChunks(
+      &framer, MessageFramer::Frame(std::string(100, 'd')), 10, &messages));
+  ASSERT_EQ(messages.size(), 1u);
+  // The 4 bytes length prefix of a 16 MB message, split across calls. It's
+  // rejected once the prefix is complete, without waiting for the body.
+  const std::string prefix("\x81\x00\x00\x00", 4);
+  EXPECT_TRUE(
+      framer.Process(prefix.substr(0, 3), [](absl::string_view) { FAIL(); }));
+  EXPECT_FALSE(
+      framer.Process(prefix.substr(3), [](absl::string_view) { FAIL(); }));
+}
+
+}  // namespace test
+}  // namespace quic
+}  // namespace owt
@@ -0,0 +1,114 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef QUIC_TRANSPORT_NETWORK_EMULATOR_H_
+#define QUIC_TRANSPORT_NETWORK_EMULATOR_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <queue>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "base/time/time.h"
+#include "base/timer/timer.h"
+#include "net/third_party/quiche/src/quiche/quic/core/quic_packet_writer_wrapper.h"
+#include "owt/quic/quic_transport_definitions.h"
+
+namespace owt {
+namespace quic {
+
+// Applies NetworkEmulationOptions to packets written by the writer it wraps.
+// The bottleneck link is a FIFO of `bandwidth_bps` with a tail drop queue of
+// `queue_bytes`, packets leaving it are lost at random or in bursts, and the
+// rest are held until their delay elapses. Due packets are written to the
+// wrapped writer by a timer. Accepted packets are never reported as blocked
+// to the connection, but the wrapped writer's blocked state is, so the owner
+// still unblocks it; held packets are retried every millisecond meanwhile.
+// Must be used on the sequence it's created on.
+class NetworkEmulatingPacketWriter : public ::quic::QuicPacketWriterWrapper {
+ public:
+  // Packets not written because of the emulated network.
+  struct Stats {
+    uint64_t packets_dropped_randomly = 0;
+    uint64_t packets_dropped_in_bursts = 0;
+    uint64_t packets_dropped_by_queue = 0;
+    uint64_t packets_reordered = 0;
+  };
+
+  // Takes the ownership of `writer`.
+  NetworkEmulatingPacketWriter(::quic::QuicPacketWriter* writer,
+                               const NetworkEmulationOptions& options);
+  ~NetworkEmulatingPacketWriter() override;
+  NetworkEmulatingPacketWriter(const NetworkEmulatingPacketWriter&) = delete;
+  NetworkEmulatingPacketWriter& operator=(const NetworkEmulatingPacketWriter&) =
+      delete;
+
+  const Stats& stats() const { return stats_; }
+  // Packets waiting for their delivery time, or for the wrapped writer.
+  size_t held_packets() const { return held_packets_.size(); }
+
+  // Overrides ::quic::QuicPacketWriterWrapper. Packets are copied, so the
+  // connection serializes them into its own buffer.
+  ::quic::WriteResult WritePacket(
+      const char* buffer,
+      size_t buf_len,
+      const ::quic::QuicIpAddress& self_address,
+      const ::quic::QuicSocketAddress& peer_address,
+      ::quic::PerPacketOptions* options) override;
+  bool SupportsReleaseTime() const override;
+  bool IsBatchMode() const override;
+  ::quic::QuicPacketBuffer GetNextWriteLocation(
+      const ::quic::QuicIpAddress& self_address,
+      const ::quic::QuicSocketAddress& peer_address) override;
+  ::quic::WriteResult Flush() override;
+
+ private:
+  struct HeldPacket {
+    base::TimeTicks delivery_time;
+    // Breaks ties of `delivery_time` by write order.
+    uint64_t sequence;
+    std::string data;
+    ::quic::QuicIpAddress self_address;
+    ::quic::QuicSocketAddress peer_address;
+  };
+  struct LaterDelivery {
+    bool operator()(const HeldPacket& a, const HeldPacket& b) const {
+      return a.delivery_time != b.delivery_time
+                 ? a.delivery_time > b.delivery_time
+                 : a.sequence > b.sequence;
+    }
+  };
+
+  // Returns true with `probability`.
+  bool RandomEvent(double probability);
+  // Returns true if the packet is lost after leaving the link.
+  bool IsLost();
+  // Writes due packets to the wrapped writer, and schedules the next run.
+  void DeliverDuePackets();
+  void ScheduleDelivery(base::TimeTicks now, bool blocked);
+
+  const NetworkEmulationOptions options_;
+  // Seeded by `options_`, so runs are reproducible.
+  std::mt19937_64 random_;
+  bool in_burst_loss_;
+  // When the link finishes sending packets accepted so far.
+  base::TimeTicks link_free_time_;
+  // Packets not reordered are delivered in order regardless of jitter.
+  base::TimeTicks last_delivery_time_;
+  uint64_t next_sequence_;
+  std::priority_queue<HeldPacket, std::vector<HeldPacket>, LaterDelivery>
+      held_packets_;
+  base::OneShotTimer delivery_timer_;
+  base::TimeTicks scheduled_delivery_time_;
+  Stats stats_;
+};
+
+}  // namespace quic
+}  // namespace owt
+
+#endif  // QUIC_TRANSPORT_NETWORK_EMULATOR_H_
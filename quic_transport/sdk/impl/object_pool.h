@@ -0,0 +1,54 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef QUIC_TRANSPORT_OBJECT_POOL_H_
+#define QUIC_TRANSPORT_OBJECT_POOL_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace owt {
+namespace quic {
+
+// Keeps memory of destroyed objects in per thread free lists, one list for
+// each 16 bytes of object size, so short lived objects created at high rates,
+// e.g.: a stream per media segment, reuse memory instead of hitting the global
+// allocator. An object could be destroyed on a thread other than the one
+// created it, its memory is then cached by the destroying thread. Caches are
+// freed when threads exit. Methods could be called on any thread.
+class ObjectPool {
+ public:
+  // Objects larger than this are allocated by operator new directly.
+  static constexpr size_t kMaxObjectSize = 4096;
+  static constexpr size_t kSizeGranularity = 16;
+  // Upper bound of objects cached by each free list of a thread.
+  static constexpr size_t kMaxCachedObjectsPerSize = 256;
+
+  static void* Allocate(size_t size);
+  // `size` must be the size passed to Allocate.
+  static void Free(void* object, size_t size);
+
+  // Number of objects cached by the current thread, and number of
+  // allocations it served from its caches.
+  static size_t CachedObjectsOnCurrentThread();
+  static uint64_t HitsOnCurrentThread();
+};
+
+// Objects of classes derived from PooledObject are allocated from ObjectPool.
+// Objects of further derived classes are pooled as well, since operator delete
+// gets the size of the most derived class through virtual destructors.
+class PooledObject {
+ public:
+  static void* operator new(size_t size) { return ObjectPool::Allocate(size); }
+  static void operator delete(void* object, size_t size) {
+    ObjectPool::Free(object, size);
+  }
+};
+
+}  // namespace quic
+}  // namespace owt
+
+#endif  // QUIC_TRANSPORT_OBJECT_POOL_H_
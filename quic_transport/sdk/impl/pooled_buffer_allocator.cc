@@ -0,0 +1,248 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "owt/quic_transport/sdk/impl/pooled_buffer_allocator.h"
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <utility>
+
+#include "base/check_op.h"
+
+namespace owt {
+namespace quic {
+
+namespace {
+// Precedes each block, so Delete knows which free list the block belongs to.
+// It keeps buffers aligned as malloc does.
+struct alignas(alignof(std::max_align_t)) BlockHeader {
+  uint32_t size_class;
+  // Non-zero if the block is carved out of a slab.
+  uint32_t from_slab;
+};
+constexpr size_t kHeaderSize = sizeof(BlockHeader);
+
+BlockHeader* HeaderOf(char* buffer) {
+  return reinterpret_cast<BlockHeader*>(buffer - kHeaderSize);
+}
+}  // namespace
+
+PooledBufferAllocator::PooledBufferAllocator(
+    scoped_refptr<base::SingleThreadTaskRunner> owner_runner)
+    : PooledBufferAllocator(std::move(owner_runner), MemoryPlacement()) {}
+
+PooledBufferAllocator::PooledBufferAllocator(
+    scoped_refptr<base::SingleThreadTaskRunner> owner_runner,
+    const MemoryPlacement& placement)
+    : owner_runner_(std::move(owner_runner)),
+      placement_(placement),
+      cached_bytes_(0),
+      pool_hits_(0),
+      pool_misses_(0),
+      slab_cursor_(nullptr),
+      slab_remaining_(0),
+      has_remote_frees_(false) {
+  CHECK(owner_runner_);
+  static_assert(kMinBlockSize << (kSizeClassCount - 1) == kMaxBlockSize,
+                "Size classes must cover kMinBlockSize to kMaxBlockSize.");
+  static_assert(kMinBlockSize >= sizeof(FreeBlock),
+                "A free block must be able to hold a link.");
+  static_assert(kSlabSize >= kHeaderSize + kMaxBlockSize,
+                "A slab must be able to hold the largest block.");
+}
+
+PooledBufferAllocator::~PooledBufferAllocator() {
+  for (FreeList& list : free_lists_) {
+    while (list.head) {
+      FreeBlock* block = list.head;
+      list.head = block->next;
+      char* buffer = reinterpret_cast<char*>(block);
+      if (!HeaderOf(buffer)->from_slab) {
+        ReleaseBlock(buffer);
+      }
+    }
+    list.count = 0;
+  }
+  cached_bytes_ = 0;
+  // Blocks in `remote_frees_` and free lists are unmapped with `slabs_`.
+}
+
+// static
+size_t PooledBufferAllocator::SizeClassIndex(size_t size) {
+  size_t index = 0;
+  size_t block_size = kMinBlockSize;
+  while (index < kSizeClassCount && block_size < size) {
+    block_size <<= 1;
+    index++;
+  }
+  return index;
+}
+
+// static
+size_t PooledBufferAllocator::SizeClassBlockSize(size_t index) {
+  DCHECK_LT(index, kSizeClassCount);
+  return kMinBlockSize << index;
+}
+
+char* PooledBufferAllocator::New(size_t size) {
+  const size_t index = SizeClassIndex(size);
+  if (index == kSizeClassCount || !owner_runner_->BelongsToCurrentThread()) {
+    return AllocateBlock(index, size);
+  }
+  FreeList& list = free_lists_[index];
+  if (!list.head) {
+    DrainRemoteFrees();
+  }
+  if (!list.head) {
+    pool_misses_++;
+    return placement_.IsDefault() ? AllocateBlock(index, size)
+                                  : AllocateSlabBlock(index);
+  }
+  FreeBlock* block = list.head;
+  list.head = block->next;
+  list.count--;
+  cached_bytes_ -= SizeClassBlockSize(index);
+  pool_hits_++;
+  return reinterpret_cast<char*>(block);
+}
+
+char* PooledBufferAllocator::New(size_t size, bool flag_enable) {
+  return New(size);
+}
+
+void PooledBufferAllocator::Delete(char* buffer) {
+  if (!buffer) {
+    return;
+  }
+  const BlockHeader* header = HeaderOf(buffer);
+  const size_t index = header->size_class;
+  if (header->from_slab) {
+    // Slab blocks are always cached, since they cannot be freed one by one.
+    if (owner_runner_->BelongsToCurrentThread()) {
+      PushFreeBlock(index, buffer);
+      return;
+    }
+    base::AutoLock lock(remote_frees_lock_);
+    remote_frees_.push_back(buffer);
+    has_remote_frees_.store(true, std::memory_order_release);
+    return;
+  }
+  if (index == kSizeClassCount || !owner_runner_->BelongsToCurrentThread()) {
+    ReleaseBlock(buffer);
+    return;
+  }
+  FreeList& list = free_lists_[index];
+  if ((list.count + 1) * SizeClassBlockSize(index) >
+      kMaxCachedBytesPerSizeClass) {
+    ReleaseBlock(buffer);
+    return;
+  }
+  PushFreeBlock(index, buffer);
+}
+
+uint64_t PooledBufferAllocator::cached_bytes() const {
+  DCHECK(owner_runner_->BelongsToCurrentThread());
+  return cached_bytes_;
+}
+
+uint64_t PooledBufferAllocator::pool_hits() const {
+  DCHECK(owner_runner_->BelongsToCurrentThread());
+  return pool_hits_;
+}
+
+uint64_t PooledBufferAllocator::pool_misses() const {
+  DCHECK(owner_runner_->BelongsToCurrentThread());
+  return pool_misses_;
+}
+
+uint64_t PooledBufferAllocator::slab_bytes() const {
+  DCHECK(owner_runner_->BelongsToCurrentThread());
+  return slabs_.size() * kSlabSize;
+}
+
+// static
+char* PooledBufferAllocator::AllocateBlock(size_t index, size_t size) {
+  const size_t block_size =
+      index == kSizeClassCount ? size : SizeClassBlockSize(index);
+  void* memory = std::malloc(kHeaderSize + block_size);
+  CHECK(memory);
+  BlockHeader* header = new (memory) BlockHeader;
+  header->size_class = static_cast<uint32_t>(index);
+  header->from_slab = 0;
+  return static_cast<char*>(memory) + kHeaderSize;
+}
+
+// static
+void PooledBufferAllocator::ReleaseBlock(char* block) {
+  std::free(HeaderOf(block));
+}
+
+char* PooledBufferAllocator::AllocateSlabBlock(size_t index) {
+  const size_t size = kHeaderSize + SizeClassBlockSize(index);
+  if (slab_remaining_ < size) {
+    // The rest of the last slab is wasted, at most one block of each size
+    // class but the largest.
+    scoped_refptr<PlacedMemory> slab =
+        PlacedMemory::Allocate(kSlabSize, placement_);
+    if (!slab) {
+      return AllocateBlock(index, 0);
+    }
+    slab_cursor_ = slab->data();
+    slab_remaining_ = slab->size();
+    slabs_.push_back(std::move(slab));
+  }
+  BlockHeader* header = new (slab_cursor_) BlockHeader;
+  header->size_class = static_cast<uint32_t>(index);
+  header->from_slab = 1;
+  char* block = slab_cursor_ + kHeaderSize;
+  slab_cursor_ += size;
+  slab_remaining_ -= size;
+  return block;
+}
+
+void PooledBufferAllocator::PushFreeBlock(size_t index, char* block) {
+  FreeList& list = free_lists_[index];
+  FreeBlock* free_block = reinterpret_cast<FreeBlock*>(block);
+  free_block->next = list.head;
+  list.head = free_block;
+  list.count++;
+  cached_bytes_ += SizeClassBlockSize(index);
+}
+
+void PooledBufferAllocator::DrainRemoteFrees() {
+  if (!has_remote_frees_.load(std::memory_order_acquire)) {
+    return;
+  }
+  std::vector<char*> blocks;
+  {
+    base::AutoLock lock(remote_frees_lock_);
+    blocks.swap(remote_frees_);
+    has_remote_frees_.store(false, std::memory_order_relaxed);
+  }
+  for (char* block : blocks) {
+    PushFreeBlock(HeaderOf(block)->size_class, block);
+  }
+}
+
+PooledBufferConnectionHelper::PooledBufferConnectionHelper(
+    const ::quic::QuicClock* clock,
+    ::quic::QuicRandom* random_generator,
+    PooledBufferAllocator* allocator)
+    : net::QuicChromiumConnectionHelper(clock, random_generator),
+      allocator_(allocator) {
+  CHECK(allocator_);
+}
+
+PooledBufferConnectionHelper::~PooledBufferConnectionHelper() = default;
+
+::quiche::QuicheBufferAllocator*
+PooledBufferConnectionHelper::GetStreamSendBufferAllocator() {
+  return allocator_;
+}
+
+}  // namespace quic
+}  // namespace owt
@@ -0,0 +1,141 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef QUIC_TRANSPORT_POOLED_BUFFER_ALLOCATOR_H_
+#define QUIC_TRANSPORT_POOLED_BUFFER_ALLOCATOR_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "base/memory/scoped_refptr.h"
+#include "base/synchronization/lock.h"
+#include "base/task/single_thread_task_runner.h"
+#include "base/thread_annotations.h"
+#include "net/quic/quic_chromium_connection_helper.h"
+#include "net/third_party/quiche/src/quiche/common/quiche_buffer_allocator.h"
+#include "owt/quic_transport/sdk/impl/placed_memory.h"
+
+namespace owt {
+namespace quic {
+
+// A QuicheBufferAllocator keeping freed buffers in per size class free lists,
+// so stream send buffers and datagram copies don't hit malloc for every write.
+// Size classes are powers of two from kMinBlockSize to kMaxBlockSize, larger
+// buffers are allocated by malloc directly.
+//
+// Free lists belong to the thread of `owner_runner`, usually an IO thread, and
+// are accessed without locks. Buffers could be allocated and deleted on any
+// thread, but only the owner thread reuses them; other threads always fall
+// back to malloc and free. A buffer allocated on another thread and deleted on
+// the owner thread, e.g.: a datagram copied by the sending thread, is still
+// cached.
+//
+// With a MemoryPlacement other than the default, blocks of size classes are
+// carved out of kSlabSize slabs placed on the NUMA node and huge pages it
+// requests. Slab blocks never go back to malloc, so the pool keeps its peak
+// usage until it's destroyed, and slab blocks deleted on other threads are
+// handed back to the owner thread under a lock.
+class PooledBufferAllocator : public ::quiche::QuicheBufferAllocator {
+ public:
+  static constexpr size_t kMinBlockSize = 256;
+  static constexpr size_t kMaxBlockSize = 64 * 1024;
+  static constexpr size_t kSizeClassCount = 9;
+  // Upper bound of bytes cached by each size class's free list. Buffers
+  // deleted when the free list is full are returned to malloc.
+  static constexpr size_t kMaxCachedBytesPerSizeClass = 1024 * 1024;
+  // Slabs are huge page sized, so a slab takes a single TLB entry when huge
+  // pages are used.
+  static constexpr size_t kSlabSize = PlacedMemory::kHugePageSize;
+
+  explicit PooledBufferAllocator(
+      scoped_refptr<base::SingleThreadTaskRunner> owner_runner);
+  PooledBufferAllocator(
+      scoped_refptr<base::SingleThreadTaskRunner> owner_runner,
+      const MemoryPlacement& placement);
+  ~PooledBufferAllocator() override;
+  PooledBufferAllocator(const PooledBufferAllocator&) = delete;
+  PooledBufferAllocator& operator=(const PooledBufferAllocator&) = delete;
+
+  // Overrides ::quiche::QuicheBufferAllocator.
+  char* New(size_t size) override;
+  char* New(size_t size, bool flag_enable) override;
+  void Delete(char* buffer) override;
+
+  // Returns the index of the smallest size class able to hold `size` bytes,
+  // or kSizeClassCount if `size` is larger than kMaxBlockSize.
+  static size_t SizeClassIndex(size_t size);
+  static size_t SizeClassBlockSize(size_t index);
+
+  // Bytes held by free lists, and number of allocations on the owner thread
+  // served by free lists and by malloc. They must be called on the owner
+  // thread.
+  uint64_t cached_bytes() const;
+  uint64_t pool_hits() const;
+  uint64_t pool_misses() const;
+  // Bytes of slabs mapped, 0 with the default placement.
+  uint64_t slab_bytes() const;
+
+ private:
+  struct FreeBlock {
+    FreeBlock* next;
+  };
+  struct FreeList {
+    FreeBlock* head = nullptr;
+    size_t count = 0;
+  };
+
+  // Allocates a block for size class `index`, or a block of exactly `size`
+  // bytes if `index` is kSizeClassCount.
+  static char* AllocateBlock(size_t index, size_t size);
+  // Frees a block allocated by AllocateBlock().
+  static void ReleaseBlock(char* block);
+  // Carves a block for size class `index` out of the current slab, mapping a
+  // new slab if it's full. Falls back to AllocateBlock() if no slab can be
+  // mapped.
+  char* AllocateSlabBlock(size_t index);
+  void PushFreeBlock(size_t index, char* block);
+  // Moves slab blocks deleted on other threads to free lists.
+  void DrainRemoteFrees();
+
+  scoped_refptr<base::SingleThreadTaskRunner> owner_runner_;
+  const MemoryPlacement placement_;
+  FreeList free_lists_[kSizeClassCount];
+  uint64_t cached_bytes_;
+  uint64_t pool_hits_;
+  uint64_t pool_misses_;
+  std::vector<scoped_refptr<PlacedMemory>> slabs_;
+  // Unused bytes at the end of the last slab.
+  char* slab_cursor_;
+  size_t slab_remaining_;
+  base::Lock remote_frees_lock_;
+  std::vector<char*> remote_frees_ GUARDED_BY(remote_frees_lock_);
+  std::atomic<bool> has_remote_frees_;
+};
+
+// A QuicChromiumConnectionHelper whose stream send buffers and datagram copies
+// are allocated by `allocator`. Buffers may be deleted after connections and
+// the helper are destroyed, so `allocator` is not owned, and it must outlive
+// everything allocated from it.
+class PooledBufferConnectionHelper : public net::QuicChromiumConnectionHelper {
+ public:
+  PooledBufferConnectionHelper(const ::quic::QuicClock* clock,
+                               ::quic::QuicRandom* random_generator,
+                               PooledBufferAllocator* allocator);
+  ~PooledBufferConnectionHelper() override;
+
+  // Overrides ::quic::QuicConnectionHelperInterface.
+  ::quiche::QuicheBufferAllocator* GetStreamSendBufferAllocator() override;
+
+ private:
+  PooledBufferAllocator* allocator_;
+};
+
+}  // namespace quic
+}  // namespace owt
+
+#endif  // QUIC_TRANSPORT_POOLED_BUFFER_ALLOCATOR_H_
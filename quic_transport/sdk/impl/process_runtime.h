@@ -0,0 +1,46 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef QUIC_TRANSPORT_PROCESS_RUNTIME_H_
+#define QUIC_TRANSPORT_PROCESS_RUNTIME_H_
+
+#include "base/no_destructor.h"
+#include "base/synchronization/lock.h"
+#include "base/thread_annotations.h"
+
+namespace owt {
+namespace quic {
+
+// Process wide state shared by all factories. Command line, logging and the
+// thread pool belong to the process, so they are initialised once however many
+// factories are created, and are left alone if the embedder, or another
+// library built with the same base, has already initialised them. Thread safe.
+class ProcessRuntime {
+ public:
+  static ProcessRuntime* GetInstance();
+  ProcessRuntime(const ProcessRuntime&) = delete;
+  ProcessRuntime& operator=(const ProcessRuntime&) = delete;
+
+  // Initialises command line and logging. Called when a factory is created.
+  void EnsureInitialized();
+  // Starts the thread pool //net posts blocking work to. Called before the
+  // first server or client is created.
+  void EnsureThreadPoolStarted();
+
+ private:
+  friend class base::NoDestructor<ProcessRuntime>;
+  ProcessRuntime();
+  ~ProcessRuntime();
+
+  base::Lock lock_;
+  bool initialized_ GUARDED_BY(lock_);
+  bool thread_pool_checked_ GUARDED_BY(lock_);
+};
+
+}  // namespace quic
+}  // namespace owt
+
+#endif
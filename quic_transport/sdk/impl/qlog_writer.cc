@@ -0,0 +1,336 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "owt/quic_transport/sdk/impl/qlog_writer.h"
+
+#include <cinttypes>
+
+#include "base/bind.h"
+#include "base/files/file_util.h"
+#include "base/json/string_escape.h"
+#include "base/logging.h"
+#include "base/rand_util.h"
+#include "base/strings/stringprintf.h"
+#include "base/time/time.h"
+#include "net/third_party/quiche/src/quiche/quic/core/congestion_control/rtt_stats.h"
+#include "net/third_party/quiche/src/quiche/quic/core/congestion_control/send_algorithm_interface.h"
+#include "net/third_party/quiche/src/quiche/quic/core/quic_sent_packet_manager.h"
+
+namespace owt {
+namespace quic {
+
+namespace {
+// Buffered records are handed to the writer once they exceed this size.
+constexpr size_t kFlushThresholdBytes = 64 * 1024;
+// Record separator of JSON text sequences (RFC 7464).
+constexpr char kRecordSeparator = '\x1e';
+
+const char* PacketType(::quic::EncryptionLevel level) {
+  switch (level) {
+    case ::quic::ENCRYPTION_INITIAL:
+      return "initial";
+    case ::quic::ENCRYPTION_HANDSHAKE:
+      return "handshake";
+    case ::quic::ENCRYPTION_ZERO_RTT:
+      return "0RTT";
+    case ::quic::ENCRYPTION_FORWARD_SECURE:
+      return "1RTT";
+    default:
+      return "unknown";
+  }
+}
+
+const char* FrameType(::quic::QuicFrameType type) {
+  switch (type) {
+    case ::quic::PADDING_FRAME:
+      return "padding";
+    case ::quic::RST_STREAM_FRAME:
+      return "reset_stream";
+    case ::quic::CONNECTION_CLOSE_FRAME:
+      return "connection_close";
+    case ::quic::ACK_FRAME:
+      return "ack";
+    case ::quic::PING_FRAME:
+      return "ping";
+    case ::quic::CRYPTO_FRAME:
+      return "crypto";
+    case ::quic::HANDSHAKE_DONE_FRAME:
+      return "handshake_done";
+    case ::quic::STREAM_FRAME:
+      return "stream";
+    case ::quic::MAX_STREAMS_FRAME:
+      return "max_streams";
+    case ::quic::STREAMS_BLOCKED_FRAME:
+      return "streams_blocked";
+    case ::quic::WINDOW_UPDATE_FRAME:
+      return "max_data";
+    case ::quic::BLOCKED_FRAME:
+      return "data_blocked";
+    case ::quic::NEW_CONNECTION_ID_FRAME:
+      return "new_connection_id";
+    case ::quic::RETIRE_CONNECTION_ID_FRAME:
+      return "retire_connection_id";
+    case ::quic::STOP_SENDING_FRAME:
+      return "stop_sending";
+    case ::quic::MESSAGE_FRAME:
+      return "datagram";
+    case ::quic::NEW_TOKEN_FRAME:
+      return "new_token";
+    default:
+      return "unknown";
+  }
+}
+
+// Returns the "header" member of packet events.
+std::string PacketHeader(::quic::EncryptionLevel level,
+                         ::quic::QuicPacketNumber packet_number) {
+  return base::StringPrintf(
+      "\"header\":{\"packet_type\":\"%s\",\"packet_number\":%" PRIu64 "}",
+      PacketType(level),
+      packet_number.IsInitialized() ? packet_number.ToUint64() : 0);
+}
+
+void AppendFrames(const ::quic::QuicFrames& frames, std::string* output) {
+  for (const ::quic::QuicFrame& frame : frames) {
+    if (output->back() != '[') {
+      output->push_back(',');
+    }
+    base::StringAppendF(output, "{\"frame_type\":\"%s\"}",
+                        FrameType(frame.type));
+  }
+}
+
+const char* CongestionState(const ::quic::SendAlgorithmInterface* algorithm) {
+  if (algorithm->InRecovery()) {
+    return "recovery";
+  }
+  return algorithm->InSlowStart() ? "slow_start" : "congestion_avoidance";
+}
+}  // namespace
+
+QlogConnectionLogger::QlogConnectionLogger(
+    QlogWriter* writer,
+    const ::quic::QuicConnection* connection,
+    const std::string& file_name)
+    : writer_(writer),
+      connection_(connection),
+      file_name_(file_name),
+      start_time_(connection->clock()->ApproximateNow()),
+      file_created_(false),
+      last_congestion_window_(0),
+      last_bytes_in_flight_(0),
+      last_smoothed_rtt_us_(0),
+      last_congestion_state_(nullptr) {
+  CHECK(writer_);
+  buffer_.push_back(kRecordSeparator);
+  base::StringAppendF(
+      &buffer_,
+      "{\"qlog_version\":\"0.3\",\"qlog_format\":\"JSON-SEQ\","
+      "\"title\":\"owt quic transport\",\"trace\":{\"vantage_point\":"
+      "{\"type\":\"server\"},\"common_fields\":{\"ODCID\":\"%s\","
+      "\"time_format\":\"relative\",\"reference_time\":%.3f}}}\n",
+      connection->connection_id().ToString().c_str(),
+      base::Time::Now().ToJsTime());
+}
+
+QlogConnectionLogger::~QlogConnectionLogger() {
+  Flush();
+}
+
+void QlogConnectionLogger::OnPacketSent(
+    ::quic::QuicPacketNumber packet_number,
+    ::quic::QuicPacketLength packet_length,
+    bool /*has_crypto_handshake*/,
+    ::quic::TransmissionType /*transmission_type*/,
+    ::quic::EncryptionLevel encryption_level,
+    const ::quic::QuicFrames& retransmittable_frames,
+    const ::quic::QuicFrames& nonretransmittable_frames,
+    ::quic::QuicTime sent_time,
+    uint32_t /*batch_id*/) {
+  std::string data = base::StringPrintf(
+      "{%s,\"raw\":{\"length\":%u},\"frames\":[",
+      PacketHeader(encryption_level, packet_number).c_str(),
+      static_cast<unsigned>(packet_length));
+  AppendFrames(retransmittable_frames, &data);
+  AppendFrames(nonretransmittable_frames, &data);
+  data.append("]}");
+  AppendEvent(sent_time, "transport:packet_sent", data);
+}
+
+void QlogConnectionLogger::OnPacketHeader(
+    const ::quic::QuicPacketHeader& header,
+    ::quic::QuicTime receive_time,
+    ::quic::EncryptionLevel level) {
+  AppendEvent(receive_time, "transport:packet_received",
+              "{" + PacketHeader(level, header.packet_number) + "}");
+}
+
+void QlogConnectionLogger::OnPacketLoss(
+    ::quic::QuicPacketNumber lost_packet_number,
+    ::quic::EncryptionLevel encryption_level,
+    ::quic::TransmissionType /*transmission_type*/,
+    ::quic::QuicTime detection_time) {
+  AppendEvent(detection_time, "recovery:packet_lost",
+              "{" + PacketHeader(encryption_level, lost_packet_number) + "}");
+}
+
+void QlogConnectionLogger::OnIncomingAck(
+    ::quic::QuicPacketNumber /*ack_packet_number*/,
+    ::quic::EncryptionLevel /*ack_decrypted_level*/,
+    const ::quic::QuicAckFrame& /*ack_frame*/,
+    ::quic::QuicTime ack_receive_time,
+    ::quic::QuicPacketNumber /*largest_observed*/,
+    bool /*rtt_updated*/,
+    ::quic::QuicPacketNumber /*least_unacked_sent_packet*/) {
+  MaybeLogRecoveryMetrics(ack_receive_time);
+}
+
+void QlogConnectionLogger::OnConnectionClosed(
+    const ::quic::QuicConnectionCloseFrame& frame,
+    ::quic::ConnectionCloseSource source) {
+  AppendEvent(
+      connection_->clock()->ApproximateNow(), "connectivity:connection_closed",
+      base::StringPrintf(
+          "{\"owner\":\"%s\",\"connection_code\":%d,\"reason\":%s}",
+          source == ::quic::ConnectionCloseSource::FROM_SELF ? "local"
+                                                             : "remote",
+          static_cast<int>(frame.quic_error_code),
+          base::GetQuotedJSONString(frame.error_details).c_str()));
+  Flush();
+}
+
+void QlogConnectionLogger::Flush() {
+  if (buffer_.empty()) {
+    return;
+  }
+  writer_->Write(file_name_, std::move(buffer_), !file_created_);
+  file_created_ = true;
+  buffer_.clear();
+}
+
+void QlogConnectionLogger::AppendEvent(::quic::QuicTime time,
+                                       const char* name,
+                                       const std::string& data) {
+  // Events reported before the connection starts, e.g. the first packet
+  // received, are logged at time 0.
+  const double relative_time_ms =
+      time > start_time_ ? (time - start_time_).ToMicroseconds() / 1000.0 : 0;
+  buffer_.push_back(kRecordSeparator);
+  base::StringAppendF(&buffer_, "{\"time\":%.3f,\"name\":\"%s\",\"data\":",
+                      relative_time_ms, name);
+  buffer_.append(data);
+  buffer_.append("}\n");
+  if (buffer_.size() >= kFlushThresholdBytes) {
+    Flush();
+  }
+}
+
+void QlogConnectionLogger::MaybeLogRecoveryMetrics(::quic::QuicTime time) {
+  const ::quic::QuicSentPacketManager& manager =
+      connection_->sent_packet_manager();
+  const uint64_t congestion_window = manager.GetCongestionWindowInBytes();
+  const uint64_t bytes_in_flight = manager.GetBytesInFlight();
+  const ::quic::RttStats* rtt_stats = manager.GetRttStats();
+  const int64_t smoothed_rtt_us = rtt_stats->smoothed_rtt().ToMicroseconds();
+  if (congestion_window != last_congestion_window_ ||
+      bytes_in_flight != last_bytes_in_flight_ ||
+      smoothed_rtt_us != last_smoothed_rtt_us_) {
+    last_congestion_window_ = congestion_window;
+    last_bytes_in_flight_ = bytes_in_flight;
+    last_smoothed_rtt_us_ = smoothed_rtt_us;
+    AppendEvent(
+        time, "recovery:metrics_updated",
+        base::StringPrintf(
+            "{\"congestion_window\":%" PRIu64 ",\"bytes_in_flight\":%" PRIu64
+            ",\"smoothed_rtt\":%.3f,\"min_rtt\":%.3f,\"latest_rtt\":%.3f}",
+            congestion_window, bytes_in_flight, smoothed_rtt_us / 1000.0,
+            rtt_stats->min_rtt().ToMicroseconds() / 1000.0,
+            rtt_stats->latest_rtt().ToMicroseconds() / 1000.0));
+  }
+  const char* congestion_state = CongestionState(manager.GetSendAlgorithm());
+  if (congestion_state != last_congestion_state_) {
+    last_congestion_state_ = congestion_state;
+    AppendEvent(time, "recovery:congestion_state_updated",
+                base::StringPrintf("{\"new\":\"%s\"}", congestion_state));
+  }
+}
+
+// static
+std::unique_ptr<QlogWriter> QlogWriter::Create(const QlogOptions& options) {
+  if (!options.directory || !(options.sampling_rate >= 0) ||
+      !(options.sampling_rate <= 1)) {
+    LOG(ERROR) << "Invalid qlog options.";
+    return nullptr;
+  }
+  base::FilePath directory = base::FilePath::FromUTF8Unsafe(options.directory);
+  if (!base::CreateDirectory(directory)) {
+    LOG(ERROR) << "Failed to create qlog directory " << options.directory;
+    return nullptr;
+  }
+  std::unique_ptr<QlogWriter> writer(new QlogWriter(options, directory));
+  if (!writer->writer_thread_.Start()) {
+    return nullptr;
+  }
+  return writer;
+}
+
+QlogWriter::QlogWriter(const QlogOptions& options,
+                       const base::FilePath& directory)
+    : directory_(directory),
+      sampling_rate_(options.sampling_rate),
+      filter_(options.filter),
+      filter_context_(options.filter_context),
+      writer_thread_("qlog_writer_thread") {}
+
+QlogWriter::~QlogWriter() {
+  // Runs pending writes.
+  writer_thread_.Stop();
+}
+
+bool QlogWriter::ShouldLog(const std::string& peer_address,
+                           const std::string& connection_id) const {
+  if (filter_ &&
+      filter_(peer_address.c_str(), connection_id.c_str(), filter_context_)) {
+    return true;
+  }
+  if (sampling_rate_ <= 0) {
+    return false;
+  }
+  return sampling_rate_ >= 1 || base::RandDouble() < sampling_rate_;
+}
+
+std::unique_ptr<QlogConnectionLogger> QlogWriter::MaybeCreateLogger(
+    const ::quic::QuicConnection* connection) {
+  const std::string connection_id = connection->connection_id().ToString();
+  if (!ShouldLog(connection->peer_address().ToString(), connection_id)) {
+    return nullptr;
+  }
+  return std::make_unique<QlogConnectionLogger>(this, connection,
+                                                connection_id + ".sqlog");
+}
+
+void QlogWriter::Write(const std::string& file_name,
+                       std::string data,
+                       bool create) {
+  writer_thread_.task_runner()->PostTask(
+      FROM_HERE,
+      base::BindOnce(&QlogWriter::WriteOnWriterThread, base::Unretained(this),
+                     file_name, std::move(data), create));
+}
+
+void QlogWriter::WriteOnWriterThread(const std::string& file_name,
+                                     std::string data,
+                                     bool create) {
+  const base::FilePath path = directory_.AppendASCII(file_name);
+  const bool success = create ? base::WriteFile(path, data)
+                              : base::AppendToFile(path, data);
+  if (!success) {
+    LOG(WARNING) << "Failed to write qlog " << path;
+  }
+}
+
+}  // namespace quic
+}  // namespace owt
@@ -0,0 +1,126 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef QUIC_TRANSPORT_QLOG_WRITER_H_
+#define QUIC_TRANSPORT_QLOG_WRITER_H_
+
+#include <memory>
+#include <string>
+
+#include "base/files/file_path.h"
+#include "base/threading/thread.h"
+#include "net/third_party/quiche/src/quiche/quic/core/quic_connection.h"
+#include "net/third_party/quiche/src/quiche/quic/core/quic_time.h"
+#include "owt/quic/quic_transport_definitions.h"
+
+namespace owt {
+namespace quic {
+
+class QlogWriter;
+
+// Serializes events of a QUIC connection as qlog JSON-SEQ records. Records
+// are buffered and handed to QlogWriter in chunks, so the IO thread never
+// touches files. It must be destroyed before the writer.
+class QlogConnectionLogger : public ::quic::QuicConnectionDebugVisitor {
+ public:
+  QlogConnectionLogger(QlogWriter* writer,
+                       const ::quic::QuicConnection* connection,
+                       const std::string& file_name);
+  ~QlogConnectionLogger() override;
+
+  // Overrides ::quic::QuicConnectionDebugVisitor.
+  void OnPacketSent(::quic::QuicPacketNumber packet_number,
+                    ::quic::QuicPacketLength packet_length,
+                    bool has_crypto_handshake,
+                    ::quic::TransmissionType transmission_type,
+                    ::quic::EncryptionLevel encryption_level,
+                    const ::quic::QuicFrames& retransmittable_frames,
+                    const ::quic::QuicFrames& nonretransmittable_frames,
+                    ::quic::QuicTime sent_time,
+                    uint32_t batch_id) override;
+  void OnPacketHeader(const ::quic::QuicPacketHeader& header,
+                      ::quic::QuicTime receive_time,
+                      ::quic::EncryptionLevel level) override;
+  void OnPacketLoss(::quic::QuicPacketNumber lost_packet_number,
+                    ::quic::EncryptionLevel encryption_level,
+                    ::quic::TransmissionType transmission_type,
+                    ::quic::QuicTime detection_time) override;
+  void OnIncomingAck(
+      ::quic::QuicPacketNumber ack_packet_number,
+      ::quic::EncryptionLevel ack_decrypted_level,
+      const ::quic::QuicAckFrame& ack_frame,
+      ::quic::QuicTime ack_receive_time,
+      ::quic::QuicPacketNumber largest_observed,
+      bool rtt_updated,
+      ::quic::QuicPacketNumber least_unacked_sent_packet) override;
+  void OnConnectionClosed(const ::quic::QuicConnectionCloseFrame& frame,
+                          ::quic::ConnectionCloseSource source) override;
+
+  // Hands buffered records to the writer.
+  void Flush();
+
+ private:
+  // Appends a record of `name` whose data is the JSON object `data`.
+  void AppendEvent(::quic::QuicTime time,
+                   const char* name,
+                   const std::string& data);
+  // Logs congestion control metrics and state if they changed since the last
+  // time they were logged.
+  void MaybeLogRecoveryMetrics(::quic::QuicTime time);
+
+  QlogWriter* writer_;
+  const ::quic::QuicConnection* connection_;
+  const std::string file_name_;
+  const ::quic::QuicTime start_time_;
+  std::string buffer_;
+  bool file_created_;
+  // Last logged values of recovery metrics.
+  uint64_t last_congestion_window_;
+  uint64_t last_bytes_in_flight_;
+  int64_t last_smoothed_rtt_us_;
+  const char* last_congestion_state_;
+};
+
+// Writes qlog traces of sampled connections to files under a directory. Files
+// are written on a dedicated thread. Methods could be called on any thread.
+class QlogWriter {
+ public:
+  // Returns nullptr if `options` is invalid, or the directory cannot be
+  // created.
+  static std::unique_ptr<QlogWriter> Create(const QlogOptions& options);
+  // Pending chunks are written before it returns.
+  ~QlogWriter();
+
+  // Returns whether a connection is logged by `options`.
+  bool ShouldLog(const std::string& peer_address,
+                 const std::string& connection_id) const;
+  // Returns a logger for `connection` if it should be logged, otherwise
+  // nullptr. The logger must be set as the debug visitor of `connection`.
+  std::unique_ptr<QlogConnectionLogger> MaybeCreateLogger(
+      const ::quic::QuicConnection* connection);
+  // Appends `data` to the file `file_name`. The file is truncated first if
+  // `create` is true.
+  void Write(const std::string& file_name, std::string data, bool create);
+
+  const base::FilePath& directory() const { return directory_; }
+
+ private:
+  QlogWriter(const QlogOptions& options, const base::FilePath& directory);
+  void WriteOnWriterThread(const std::string& file_name,
+                           std::string data,
+                           bool create);
+
+  const base::FilePath directory_;
+  const double sampling_rate_;
+  const QlogFilter filter_;
+  void* const filter_context_;
+  base::Thread writer_thread_;
+};
+
+}  // namespace quic
+}  // namespace owt
+
+#endif
@@ -6,21 +6,25 @@
 
 #include "owt/quic/logging.h"
 #include "owt/quic_transport/sdk/impl/quic_transport_factory_impl.h"
+#include <algorithm>
 #include "base/at_exit.h"
 #include "base/bind.h"
-#include "base/command_line.h"
 #include "base/logging.h"
-#include "base/task/thread_pool/thread_pool_instance.h"
 #include "base/threading/thread.h"
+#include "owt/quic_transport/sdk/impl/external_task_runner.h"
+#include "owt/quic_transport/sdk/impl/process_runtime.h"
 #include "owt/quic_transport/sdk/impl/proof_source_owt.h"
 #include "owt/quic_transport/sdk/impl/quic_transport_owt_client_impl.h"
 #include "owt/quic_transport/sdk/impl/quic_transport_owt_server_impl.h"
+#include "owt/quic_transport/sdk/impl/utilities.h"
 #include "net/quic/crypto/proof_source_chromium.h"
 #include "net/quic/platform/impl/quic_chromium_clock.h"
 #include "net/quic/quic_chromium_alarm_factory.h"
 #include "net/quic/quic_chromium_connection_helper.h"
 #include "net/third_party/quiche/src/quiche/quic/core/crypto/proof_source.h"
 #include "net/third_party/quiche/src/quiche/quic/core/crypto/quic_crypto_server_config.h"
+#include "net/third_party/quiche/src/quiche/quic/core/quic_config.h"
+#include "net/third_party/quiche/src/quiche/quic/core/quic_constants.h"
 #include "url/gurl.h"
 #include "net/quic/address_utils.h"
 #include "net/tools/quic/synchronous_host_resolver.h"
@@ -29,6 +33,38 @@
 namespace owt {
 namespace quic {
 
+namespace {
+
+void ApplyOptionsToConfig(const QuicTransportServerInterface::Options& options,
+                          ::quic::QuicConfig* config) {
+  if (options.initial_stream_flow_control_window > 0) {
+    config->SetInitialStreamFlowControlWindowToSend(
+        std::max<::quic::QuicByteCount>(
+            options.initial_stream_flow_control_window,
+            ::quic::kMinimumFlowControlSendWindow));
+  }
+  if (options.initial_session_flow_control_window > 0) {
+    config->SetInitialSessionFlowControlWindowToSend(
+        std::max<::quic::QuicByteCount>(
+            options.initial_session_flow_control_window,
+            ::quic::kMinimumFlowControlSendWindow));
+  }
+  if (options.max_incoming_bidirectional_streams > 0) {
+    config->SetMaxBidirectionalStreamsToSend(
+        options.max_incoming_bidirectional_streams);
+  }
+  if (options.max_incoming_unidirectional_streams > 0) {
+    config->SetMaxUnidirectionalStreamsToSend(
+        options.max_incoming_unidirectional_streams);
+  }
+  if (options.idle_timeout_ms > 0) {
+    config->SetIdleNetworkTimeout(
+        ::quic::QuicTime::Delta::FromMilliseconds(options.idle_timeout_ms));
+  }
+}
+
+}  // namespace
+
 // FakeProofVerifier for client
 class FakeProofVerifier : public ::quic::ProofVerifier {
  public:
@@ -68,7 +104,6 @@ class FakeProofVerifier : public ::quic::ProofVerifier {
 };
 
 QuicTransportFactory* QuicTransportFactory::Create() {
-  base::ThreadPoolInstance::CreateAndStartWithDefaultParams("quic_transport_thread_pool");
   QuicTransportFactoryImpl* factory = new QuicTransportFactoryImpl();
   factory->InitializeAtExitManager();
   return factory;
@@ -79,10 +114,6 @@ QuicTransportFactoryImpl::QuicTransportFactoryImpl()
       io_thread_(std::make_unique<base::Thread>("quic_transport_io_thread")),
       event_thread_(
           std::make_unique<base::Thread>("quic_transport_event_thread")) {
-  io_thread_->StartWithOptions(
-      base::Thread::Options(base::MessagePumpType::IO, 0));
-  event_thread_->StartWithOptions(
-      base::Thread::Options(base::MessagePumpType::IO, 0));
   Init();
 }
 
@@ -92,11 +123,41 @@ void QuicTransportFactoryImpl::InitializeAtExitManager() {
   at_exit_manager_ = std::make_unique<base::AtExitManager>();
 }
 
+void QuicTransportFactoryImpl::SetEventExecutor(
+    owt::quic::EventExecutorInterface* executor) {
+  CHECK(executor);
+  base::AutoLock lock(threads_lock_);
+  event_runner_ = base::MakeRefCounted<owt::quic::ExternalTaskRunner>(executor);
+  if (event_thread_) {
+    // Not started yet if no server or client is created.
+    event_thread_->Stop();
+    event_thread_.reset();
+  }
+}
+
 QuicTransportServerInterface* QuicTransportFactoryImpl::CreateQuicTransportServer(
     int port,
     const char* cert_file,
     const char* key_file,
     const char* secret_path) {
+  return CreateQuicTransportServer(port, cert_file, key_file, secret_path,
+                                   QuicTransportServerInterface::Options());
+}
+
+QuicTransportServerInterface* QuicTransportFactoryImpl::CreateQuicTransportServer(
+    int port,
+    const char* pfx_path,
+    const char* password) {
+  return CreateQuicTransportServer(port, pfx_path, password,
+                                   QuicTransportServerInterface::Options());
+}
+
+QuicTransportServerInterface* QuicTransportFactoryImpl::CreateQuicTransportServer(
+    int port,
+    const char* cert_file,
+    const char* key_file,
+    const char* secret_path,
+    const QuicTransportServerInterface::Options& options) {
   auto proof_source = std::make_unique<net::ProofSourceChromium>();
   if (!proof_source->Initialize(
       base::FilePath(cert_file),
@@ -104,13 +165,15 @@ QuicTransportServerInterface* QuicTransportFactoryImpl::CreateQuicTransportServe
     LOG(ERROR) << "Failed to initialize proof source.";
     return nullptr;
   }
-  return CreateQuicTransportServerOnIOThread(port, std::move(proof_source));
+  return CreateQuicTransportServerOnIOThread(port, std::move(proof_source),
+                                             options);
 }
 
 QuicTransportServerInterface* QuicTransportFactoryImpl::CreateQuicTransportServer(
     int port,
     const char* pfx_path,
-    const char* password) {
+    const char* password,
+    const QuicTransportServerInterface::Options& options) {
   auto proof_source = std::make_unique<ProofSourceOwt>();
   if (!proof_source->Initialize(
       base::FilePath::FromUTF8Unsafe(pfx_path),
@@ -118,47 +181,48 @@ QuicTransportServerInterface* QuicTransportFactoryImpl::CreateQuicTransportServe
     LOG(ERROR) << "Failed to initialize proof source.";
     return nullptr;
   }
-  return CreateQuicTransportServerOnIOThread(port, std::move(proof_source));
+  return CreateQuicTransportServerOnIOThread(port, std::move(proof_source),
+                                             options);
 }
 
 QuicTransportServerInterface* QuicTransportFactoryImpl::CreateQuicTransportServerOnIOThread(
     int port,
-    std::unique_ptr<::quic::ProofSource> proof_source) {
+    std::unique_ptr<::quic::ProofSource> proof_source,
+    const QuicTransportServerInterface::Options& options) {
   QuicTransportServerInterface* result(nullptr);
+  base::Thread* io_thread = GetIoThread();
   base::WaitableEvent done(base::WaitableEvent::ResetPolicy::AUTOMATIC,
                            base::WaitableEvent::InitialState::NOT_SIGNALED);
-  io_thread_->task_runner()->PostTask(
+  io_thread->task_runner()->PostTask(
       FROM_HERE,
       base::BindOnce(
           [](int port, std::unique_ptr<::quic::ProofSource> proof_source,
-             base::Thread* io_thread, base::Thread* event_thread,
+             const QuicTransportServerInterface::Options& options,
+             base::Thread* io_thread,
+             scoped_refptr<base::SingleThreadTaskRunner> event_runner,
              QuicTransportServerInterface** result, base::WaitableEvent* event) {
 
             net::IPAddress ip = net::IPAddress::IPv6AllZeros();
             ::quic::QuicConfig config;
+            ApplyOptionsToConfig(options, &config);
 
             *result = new net::QuicTransportOwtServerImpl(
                 port, std::move(proof_source), config, 
                 ::quic::QuicCryptoServerConfig::ConfigOptions(),
-                ::quic::AllSupportedVersions(),
-                io_thread, event_thread);
+                ::quic::AllSupportedVersions(), options,
+                io_thread, std::move(event_runner));
             event->Signal();
           },
-          port, std::move(proof_source), base::Unretained(io_thread_.get()),
-          base::Unretained(event_thread_.get()), base::Unretained(&result),
+          port, std::move(proof_source), options,
+          base::Unretained(io_thread), GetEventRunner(),
+          base::Unretained(&result),
           base::Unretained(&done)));
   done.Wait();
   return result;
 }
 
 void QuicTransportFactoryImpl::Init() {
-  base::CommandLine::Init(0, nullptr);
-  base::CommandLine* command_line(base::CommandLine::ForCurrentProcess());
-  command_line->AppendSwitch("--quic_default_to_bbr");
-  logging::LoggingSettings settings;
-  settings.logging_dest = logging::LOG_TO_STDERR;
-  logging::InitLogging(settings);
-  logging::SetMinLogLevel(1);
+  ProcessRuntime::GetInstance()->EnsureInitialized();
 
   char* str = std::getenv("QUIC_SERVER_FINGERPRINTS");
   if(str == NULL) {
@@ -178,19 +242,81 @@ void QuicTransportFactoryImpl::Init() {
   }
 }
 
+base::Thread* QuicTransportFactoryImpl::GetIoThread() {
+  ProcessRuntime::GetInstance()->EnsureThreadPoolStarted();
+  base::AutoLock lock(threads_lock_);
+  if (!io_thread_->IsRunning()) {
+    io_thread_->StartWithOptions(
+        base::Thread::Options(base::MessagePumpType::IO, 0));
+    client_send_buffer_pool_ =
+        std::make_unique<PooledBufferAllocator>(io_thread_->task_runner());
+  }
+  return io_thread_.get();
+}
+
+scoped_refptr<base::SingleThreadTaskRunner>
+QuicTransportFactoryImpl::GetEventRunner() {
+  base::AutoLock lock(threads_lock_);
+  if (!event_runner_) {
+    DCHECK(event_thread_);
+    event_thread_->StartWithOptions(
+        base::Thread::Options(base::MessagePumpType::IO, 0));
+    event_runner_ = event_thread_->task_runner();
+  }
+  return event_runner_;
+}
+
 QuicTransportClientInterface*
 QuicTransportFactoryImpl::CreateQuicTransportClient(
     const char* host, 
     int port) {
+  return CreateQuicTransportClient(host, port,
+                                   QuicTransportClientInterface::Parameters());
+}
+
+QuicTransportClientInterface*
+QuicTransportFactoryImpl::CreateQuicTransportClient(
+    const char* host,
+    int port,
+    const QuicTransportClientInterface::Parameters& parameters) {
+  ::quic::QuicConfig config;
+  if (parameters.congestion_profile != CongestionProfile::kDefault) {
+    // A profile applies to both directions, with its own algorithm.
+    const ::quic::QuicTagVector profile_options =
+        Utilities::CongestionProfileConnectionOptions(
+            parameters.congestion_profile);
+    config.SetClientConnectionOptions(profile_options);
+    config.SetConnectionOptionsToSend(profile_options);
+  } else {
+    config.SetClientConnectionOptions(
+        {Utilities::CongestionControlConnectionOption(
+            parameters.congestion_control)});
+    if (parameters.server_congestion_control !=
+        CongestionControlType::kDefault) {
+      config.SetConnectionOptionsToSend(
+          {Utilities::CongestionControlConnectionOption(
+              parameters.server_congestion_control)});
+    }
+  }
+  base::Thread* io_thread = GetIoThread();
+  PooledBufferAllocator* send_buffer_pool = nullptr;
+  if (parameters.pooled_send_buffers) {
+    base::AutoLock lock(threads_lock_);
+    send_buffer_pool = client_send_buffer_pool_.get();
+  }
   owt::quic::QuicTransportClientInterface* result(nullptr);
   base::WaitableEvent done(base::WaitableEvent::ResetPolicy::AUTOMATIC,
                            base::WaitableEvent::InitialState::NOT_SIGNALED);
-  io_thread_->task_runner()->PostTask(
+  io_thread->task_runner()->PostTask(
       FROM_HERE,
       base::BindOnce(
-          [](const char* host, int port,
+          [](const char* host, int port, const ::quic::QuicConfig& config,
              const std::vector<::quic::CertificateFingerprint>& fingerprints,
-             base::Thread* io_thread, base::Thread* event_thread,
+             base::Thread* io_thread,
+             scoped_refptr<base::SingleThreadTaskRunner> event_runner,
+             PooledBufferAllocator* send_buffer_pool,
+             uint32_t max_stream_receive_window,
+             uint32_t max_session_receive_window,
              owt::quic::QuicTransportClientInterface** result, base::WaitableEvent* event) {
             ::quic::QuicIpAddress ip_addr;
 
@@ -213,13 +339,24 @@ QuicTransportFactoryImpl::CreateQuicTransportClient(
             ::quic::QuicServerId server_id(host, port, false);
             ::quic::ParsedQuicVersionVector versions = ::quic::CurrentSupportedVersions();
 
-            *result = new net::QuicTransportOwtClientImpl(
-                ::quic::QuicSocketAddress(ip_addr, port), server_id, versions, fingerprints,
-                io_thread, event_thread);
+            auto* client = new net::QuicTransportOwtClientImpl(
+                ::quic::QuicSocketAddress(ip_addr, port), server_id, versions,
+                config, fingerprints, io_thread, std::move(event_runner),
+                send_buffer_pool);
+            client->SetMaxReceiveWindows(max_stream_receive_window,
+                                         max_session_receive_window);
+            *result = client;
             event->Signal();
           },
-          base::Unretained(host), port, server_certificate_fingerprints, base::Unretained(io_thread_.get()),
-          base::Unretained(event_thread_.get()), base::Unretained(&result),
+          base::Unretained(host), port, config, server_certificate_fingerprints,
+          base::Unretained(io_thread),
+          // In inline dispatch mode, IO thread is also the event thread.
+          parameters.inline_event_dispatch ? io_thread->task_runner()
+                                           : GetEventRunner(),
+          base::Unretained(send_buffer_pool),
+          parameters.max_stream_receive_window,
+          parameters.max_session_receive_window,
+          base::Unretained(&result),
           base::Unretained(&done)));
   done.Wait();
   return result;
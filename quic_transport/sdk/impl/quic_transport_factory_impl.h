@@ -10,8 +10,13 @@
 #include <memory>
 #include <string>
 #include <vector>
+#include "base/memory/scoped_refptr.h"
+#include "base/synchronization/lock.h"
+#include "base/task/single_thread_task_runner.h"
+#include "base/thread_annotations.h"
 #include "owt/quic/export.h"
 #include "owt/quic/quic_transport_factory.h"
+#include "owt/quic_transport/sdk/impl/pooled_buffer_allocator.h"
 #include "owt/quic_transport/sdk/impl/proof_source_owt.h"
 #include "net/third_party/quiche/src/quiche/quic/platform/api/quic_default_proof_providers.h"
 #include "net/third_party/quiche/src/quiche/quic/core/quic_types.h"
@@ -40,6 +45,7 @@ class OWT_EXPORT QuicTransportFactoryImpl : public owt::quic::QuicTransportFacto
   QuicTransportFactoryImpl();
   ~QuicTransportFactoryImpl() override;
   void InitializeAtExitManager();
+  void SetEventExecutor(owt::quic::EventExecutorInterface* executor) override;
   // `accepted_origins` is removed at this time because ABI compatible issue.
   QuicTransportServerInterface* CreateQuicTransportServer(
       int port,
@@ -50,19 +56,51 @@ class OWT_EXPORT QuicTransportFactoryImpl : public owt::quic::QuicTransportFacto
     int port,
     const char* pfx_path,
     const char* password) override;
+  QuicTransportServerInterface* CreateQuicTransportServer(
+      int port,
+      const char* cert_path,
+      const char* key_path,
+      const char* secret_path,
+      const QuicTransportServerInterface::Options& options) override;
+  QuicTransportServerInterface* CreateQuicTransportServer(
+      int port,
+      const char* pfx_path,
+      const char* password,
+      const QuicTransportServerInterface::Options& options) override;
   QuicTransportClientInterface* CreateQuicTransportClient(
       const char* host,
       int port) override;
+  QuicTransportClientInterface* CreateQuicTransportClient(
+      const char* host,
+      int port,
+      const QuicTransportClientInterface::Parameters& parameters) override;
 
  private:
   void Init();
+  // Start `io_thread_` and the event thread when the first server or client is
+  // created, so a factory which is never used doesn't run any thread.
+  base::Thread* GetIoThread();
+  scoped_refptr<base::SingleThreadTaskRunner> GetEventRunner();
   QuicTransportServerInterface* CreateQuicTransportServerOnIOThread(
       int port,
-      std::unique_ptr<::quic::ProofSource> proof_source);
+      std::unique_ptr<::quic::ProofSource> proof_source,
+      const QuicTransportServerInterface::Options& options);
 
   std::unique_ptr<base::AtExitManager> at_exit_manager_;
-  std::unique_ptr<base::Thread> io_thread_;
-  std::unique_ptr<base::Thread> event_thread_;
+  base::Lock threads_lock_;
+  // Allocates send buffers of clients created with pooled send buffers. It's
+  // owned by `io_thread_`, created when `io_thread_` is started, and destroyed
+  // after `io_thread_` is stopped.
+  std::unique_ptr<PooledBufferAllocator> client_send_buffer_pool_
+      GUARDED_BY(threads_lock_);
+  std::unique_ptr<base::Thread> io_thread_ GUARDED_BY(threads_lock_);
+  // Stopped and reset when an event executor is set.
+  std::unique_ptr<base::Thread> event_thread_ GUARDED_BY(threads_lock_);
+  // Runs visitor callbacks. It's `event_thread_`'s task runner, or an
+  // ExternalTaskRunner. Null until the event thread is started or an event
+  // executor is set.
+  scoped_refptr<base::SingleThreadTaskRunner> event_runner_
+      GUARDED_BY(threads_lock_);
   std::vector<::quic::CertificateFingerprint> server_certificate_fingerprints;
 };
 
@@ -30,6 +30,7 @@
 #include "net/third_party/quiche/src/quiche/quic/platform/api/quic_flags.h"
 #include "net/third_party/quiche/src/quiche/quic/tools/quic_simple_client_session.h"
 #include "net/quic/platform/impl/quic_chromium_clock.h"
+#include "owt/quic_transport/sdk/impl/utilities.h"
 
 using std::string;
 
@@ -61,21 +62,26 @@ QuicTransportOwtClientImpl::QuicTransportOwtClientImpl(
     quic::QuicSocketAddress server_address,
     const quic::QuicServerId& server_id,
     const quic::ParsedQuicVersionVector& supported_versions,
+    const quic::QuicConfig& config,
     const std::vector<::quic::CertificateFingerprint> server_certificate_fingerprints,
     base::Thread* io_thread,
-    base::Thread* event_thread)
+    scoped_refptr<base::SingleThreadTaskRunner> event_runner,
+    owt::quic::PooledBufferAllocator* send_buffer_pool)
     : quic::QuicTransportOwtClientBase(
           server_id,
           supported_versions,
-          quic::QuicConfig(),
-          CreateQuicConnectionHelper(),
+          config,
+          CreateQuicConnectionHelper(send_buffer_pool),
           CreateQuicAlarmFactory(),
           base::WrapUnique(CreateNetworkHelper()),
           CreateProofVerifier(&clock_, server_certificate_fingerprints),
           nullptr,
           io_thread->task_runner().get(),
-          event_thread->task_runner().get()),
-      event_runner_(event_thread->task_runner()),
+          event_runner.get()),
+      event_runner_(event_runner),
+      max_stream_receive_window_(0),
+      max_session_receive_window_(0),
+      live_streams_(base::MakeRefCounted<owt::quic::LiveStreamRegistry>()),
       weak_factory_(this) {
   if (!io_thread) {
     LOG(INFO) << "Create a new IO stream.";
@@ -99,7 +105,19 @@ QuicTransportOwtClientImpl::~QuicTransportOwtClientImpl() {
   }
 }
 
-QuicChromiumConnectionHelper* QuicTransportOwtClientImpl::CreateQuicConnectionHelper() {
+void QuicTransportOwtClientImpl::SetMaxReceiveWindows(
+    uint32_t max_stream_window,
+    uint32_t max_session_window) {
+  max_stream_receive_window_ = max_stream_window;
+  max_session_receive_window_ = max_session_window;
+}
+
+QuicChromiumConnectionHelper* QuicTransportOwtClientImpl::CreateQuicConnectionHelper(
+    owt::quic::PooledBufferAllocator* send_buffer_pool) {
+  if (send_buffer_pool) {
+    return new owt::quic::PooledBufferConnectionHelper(
+        &clock_, quic::QuicRandom::GetInstance(), send_buffer_pool);
+  }
   return new QuicChromiumConnectionHelper(&clock_,
                                           quic::QuicRandom::GetInstance());
 }
@@ -134,6 +152,9 @@ void QuicTransportOwtClientImpl::StartOnCurrentThread() {
 
   session_ = client_session();
   session_->set_visitor(this);
+  session_->SetMaxReceiveWindows(max_stream_receive_window_,
+                                 max_session_receive_window_);
+  connection_id_ = session_->connection()->connection_id().ToString();
   if(visitor_) {
     visitor_->OnConnected();
   }
@@ -171,30 +192,88 @@ void QuicTransportOwtClientImpl::NewStreamCreated(quic::QuicTransportOwtStreamIm
 }
 
 void QuicTransportOwtClientImpl::OnIncomingNewStream(quic::QuicTransportOwtStreamImpl* stream) {
+  if (event_runner_->BelongsToCurrentThread()) {
+    NewStreamCreated(stream);
+    return;
+  }
+  // The stream could be released before the task runs, so it's looked up by
+  // ID.
+  live_streams_->Add(stream->id(), stream);
   event_runner_->PostTask(
       FROM_HERE,
       base::BindOnce(
           [](QuicTransportOwtClientImpl* client,
-             quic::QuicTransportOwtStreamImpl* stream) {
-            client->NewStreamCreated(stream);
+             scoped_refptr<owt::quic::LiveStreamRegistry> live_streams,
+             uint32_t id) {
+            live_streams->RunIfAlive(
+                id, base::BindOnce(
+                        &QuicTransportOwtClientImpl::NewStreamCreated,
+                        base::Unretained(client)));
           },
-          base::Unretained(this), base::Unretained(stream)));
+          base::Unretained(this), live_streams_, stream->id()));
 }
 
 void QuicTransportOwtClientImpl::OnStreamClosed(uint32_t id) {
+  // Called before the stream is released.
+  live_streams_->Remove(id);
+  if (event_runner_->BelongsToCurrentThread()) {
+    StreamClosed(id);
+    return;
+  }
+  // Posted like OnIncomingNewStream, so the visitor gets them in order.
+  event_runner_->PostTask(
+      FROM_HERE,
+      base::BindOnce(&QuicTransportOwtClientImpl::StreamClosed,
+                     base::Unretained(this), id));
+}
+
+void QuicTransportOwtClientImpl::StreamClosed(uint32_t id) {
   if(visitor_) {
     visitor_->OnStreamClosed(id);
   }
 }
 
-const char* QuicTransportOwtClientImpl::Id() {
-  const std::string& session_id_str =
-      client_session()->connection()->connection_id().ToString();
-  char* id = new char[session_id_str.size() + 1];
-  strcpy(id, session_id_str.c_str());
+void QuicTransportOwtClientImpl::OnDatagramsReceived(
+    std::vector<std::string> datagrams) {
+  if (event_runner_->BelongsToCurrentThread()) {
+    DeliverDatagrams(std::move(datagrams));
+    return;
+  }
+  event_runner_->PostTask(
+      FROM_HERE,
+      base::BindOnce(&QuicTransportOwtClientImpl::DeliverDatagrams,
+                     base::Unretained(this), std::move(datagrams)));
+}
 
-  return id;
+void QuicTransportOwtClientImpl::DeliverDatagrams(
+    std::vector<std::string> datagrams) {
+  if (!visitor_) {
+    return;
+  }
+  std::vector<owt::quic::Datagram> batch =
+      owt::quic::Utilities::DatagramsFromBuffers(datagrams);
+  visitor_->OnDatagramsReceived(batch.data(), batch.size());
+}
 
+void QuicTransportOwtClientImpl::SendDatagrams(const owt::quic::Datagram* batch,
+                                               size_t count) {
+  task_runner_->PostTask(
+      FROM_HERE,
+      base::BindOnce(&QuicTransportOwtClientImpl::SendDatagramsOnCurrentThread,
+                     base::Unretained(this),
+                     owt::quic::Utilities::CopyDatagrams(batch, count)));
+}
+
+void QuicTransportOwtClientImpl::SendDatagramsOnCurrentThread(
+    std::vector<quiche::QuicheMemSlice> datagrams) {
+  if (!connected()) {
+    return;
+  }
+  client_session()->SendDatagrams(std::move(datagrams));
+}
+
+const char* QuicTransportOwtClientImpl::Id() {
+  return connection_id_.c_str();
 }
 
 void QuicTransportOwtClientImpl::CloseStreamOnCurrentThread(uint32_t id) {
@@ -208,10 +287,13 @@ void QuicTransportOwtClientImpl::CloseStream(uint32_t id) {
 }
 
 uint8_t QuicTransportOwtClientImpl::length() {
-  return client_session()->connection()->client_connection_id().length();
+  return connection_id_.size();
 }
 
 owt::quic::QuicTransportStreamInterface* QuicTransportOwtClientImpl::CreateBidirectionalStream() {
+  if (event_runner_->BelongsToCurrentThread()) {
+    return CreateBidirectionalStreamOnCurrentThread();
+  }
   owt::quic::QuicTransportStreamInterface* result(nullptr);
   base::WaitableEvent done(base::WaitableEvent::ResetPolicy::AUTOMATIC,
                            base::WaitableEvent::InitialState::NOT_SIGNALED);
@@ -240,6 +322,35 @@ owt::quic::QuicTransportStreamInterface* QuicTransportOwtClientImpl::CreateBidir
   return stream;
 }
 
+owt::quic::QuicTransportStreamInterface* QuicTransportOwtClientImpl::CreateUnidirectionalStream() {
+  if (task_runner_->BelongsToCurrentThread()) {
+    return CreateUnidirectionalStreamOnCurrentThread();
+  }
+  // The session is only accessed on the IO thread.
+  owt::quic::QuicTransportStreamInterface* result(nullptr);
+  base::WaitableEvent done(base::WaitableEvent::ResetPolicy::AUTOMATIC,
+                           base::WaitableEvent::InitialState::NOT_SIGNALED);
+  task_runner_->PostTask(
+      FROM_HERE,
+      base::BindOnce(
+          [](QuicTransportOwtClientImpl* client,
+             owt::quic::QuicTransportStreamInterface** result, base::WaitableEvent* event) {
+            *result = client->CreateUnidirectionalStreamOnCurrentThread();
+            event->Signal();
+          },
+          base::Unretained(this), base::Unretained(&result),
+          base::Unretained(&done)));
+  done.Wait();
+  return result;
+}
+
+owt::quic::QuicTransportStreamInterface* QuicTransportOwtClientImpl::CreateUnidirectionalStreamOnCurrentThread() {
+  if (!connected()) {
+    return nullptr;
+  }
+  return client_session()->CreateOutgoingUnidirectionalStream();
+}
+
 QuicChromiumAlarmFactory* QuicTransportOwtClientImpl::CreateQuicAlarmFactory() {
   return new QuicChromiumAlarmFactory(base::ThreadTaskRunnerHandle::Get().get(),
                                       &clock_);
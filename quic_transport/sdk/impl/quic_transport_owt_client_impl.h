@@ -7,6 +7,7 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "base/command_line.h"
 #include "absl/base/macros.h"
@@ -23,7 +24,11 @@
 #include "owt/quic_transport/sdk/impl/quic_transport_owt_client_base.h"
 #include "owt/quic/quic_transport_client_interface.h"
 #include "owt/quic/quic_transport_stream_interface.h"
+#include "owt/quic_transport/sdk/impl/live_stream_registry.h"
+#include "owt/quic_transport/sdk/impl/pooled_buffer_allocator.h"
 #include "net/third_party/quiche/src/quiche/quic/core/crypto/web_transport_fingerprint_proof_verifier.h"
+#include "base/memory/scoped_refptr.h"
+#include "base/task/single_thread_task_runner.h"
 #include "base/threading/thread.h"
 
 namespace net {
@@ -37,38 +42,56 @@ class QuicTransportOwtClientImpl : public quic::QuicTransportOwtClientBase,
  public:
 
   // Create a quic client, which will have events managed by the message loop.
+  // Stream send buffers are allocated from `send_buffer_pool` if it's not
+  // nullptr. It must be owned by `io_thread`, and outlive this client.
   QuicTransportOwtClientImpl(quic::QuicSocketAddress server_address,
                    const quic::QuicServerId& server_id,
                    const quic::ParsedQuicVersionVector& supported_versions,
+                   const quic::QuicConfig& config,
                    const std::vector<::quic::CertificateFingerprint> server_certificate_fingerprints,
                    base::Thread* io_thread,
-                   base::Thread* event_thread);
+                   scoped_refptr<base::SingleThreadTaskRunner> event_runner,
+                   owt::quic::PooledBufferAllocator* send_buffer_pool = nullptr);
 
   ~QuicTransportOwtClientImpl() override;
 
+  // See QuicTransportOwtClientSession::SetMaxReceiveWindows. Must be called
+  // before Start().
+  void SetMaxReceiveWindows(uint32_t max_stream_window,
+                            uint32_t max_session_window);
+
   int SocketPort();
   void Start() override;
   void Stop() override;
   void SetVisitor(owt::quic::QuicTransportClientInterface::Visitor* visitor) override;
   owt::quic::QuicTransportStreamInterface* CreateBidirectionalStream() override;
+  owt::quic::QuicTransportStreamInterface* CreateUnidirectionalStream() override;
   void OnConnectionClosed(char*, size_t len) override;
   void OnIncomingNewStream(quic::QuicTransportOwtStreamImpl* stream) override;
   void OnStreamClosed(uint32_t id) override;
+  void OnDatagramsReceived(std::vector<std::string> datagrams) override;
   const char* Id() override;
   uint8_t length() override;
   void CloseStream(uint32_t id) override;
+  void SendDatagrams(const owt::quic::Datagram* batch, size_t count) override;
 
  private:
 
   QuicChromiumAlarmFactory* CreateQuicAlarmFactory();
-  QuicChromiumConnectionHelper* CreateQuicConnectionHelper();
+  QuicChromiumConnectionHelper* CreateQuicConnectionHelper(
+      owt::quic::PooledBufferAllocator* send_buffer_pool);
   QuicClientMessageLooplNetworkHelper* CreateNetworkHelper();
   void StartOnCurrentThread();
   void StopOnCurrentThread();
   void CloseStreamOnCurrentThread(uint32_t id);
+  void SendDatagramsOnCurrentThread(
+      std::vector<quiche::QuicheMemSlice> datagrams);
+  void DeliverDatagrams(std::vector<std::string> datagrams);
   void NewStreamCreated(quic::QuicTransportOwtStreamImpl* stream);
+  void StreamClosed(uint32_t id);
 
   owt::quic::QuicTransportStreamInterface* CreateBidirectionalStreamOnCurrentThread();
+  owt::quic::QuicTransportStreamInterface* CreateUnidirectionalStreamOnCurrentThread();
   //  Used by |helper_| to time alarms.
   quic::QuicChromiumClock clock_;
 
@@ -79,6 +102,13 @@ class QuicTransportOwtClientImpl : public quic::QuicTransportOwtClientBase,
   scoped_refptr<base::SingleThreadTaskRunner> event_runner_;
   QuicTransportClientInterface::Visitor* visitor_;
   quic::QuicTransportOwtClientSession* session_;
+  uint32_t max_stream_receive_window_;
+  uint32_t max_session_receive_window_;
+  // String representation of connection ID, set when connected.
+  std::string connection_id_;
+  // Incoming streams not closed yet, looked up by notifications posted to the
+  // event thread.
+  scoped_refptr<owt::quic::LiveStreamRegistry> live_streams_;
 
   base::WeakPtrFactory<QuicTransportOwtClientImpl> weak_factory_;
 
@@ -2,8 +2,11 @@
 #include "owt/quic_transport/sdk/impl/quic_transport_owt_client_session.h"
 
 #include <string>
+#include <utility>
 
 #include "net/third_party/quiche/src/quiche/quic/core/crypto/crypto_protocol.h"
+#include "net/third_party/quiche/src/quiche/quic/core/quic_connection.h"
+#include "net/third_party/quiche/src/quiche/quic/core/quic_constants.h"
 #include "net/third_party/quiche/src/quiche/quic/core/quic_server_id.h"
 #include "net/third_party/quiche/src/quiche/quic/core/quic_utils.h"
 #include "net/third_party/quiche/src/quiche/quic/platform/api/quic_bug_tracker.h"
@@ -27,7 +30,12 @@ QuicTransportOwtClientSession::QuicTransportOwtClientSession(
       crypto_config_(crypto_config),
       task_runner_(io_runner),
       event_runner_(event_runner),
-      respect_goaway_(false) {}
+      respect_goaway_(false),
+      visitor_(nullptr),
+      receive_window_tuner_(this) {
+  // Advertises support for DATAGRAM frames.
+  this->config()->SetMaxDatagramFrameSizeToSend(kMaxAcceptedDatagramFrameSize);
+}
 
 QuicTransportOwtClientSession::~QuicTransportOwtClientSession() = default;
 
@@ -73,8 +81,10 @@ bool QuicTransportOwtClientSession::ShouldCreateOutgoingBidirectionalStream() {
 }
 
 bool QuicTransportOwtClientSession::ShouldCreateOutgoingUnidirectionalStream() {
-  QUIC_BUG(quic_bug_10396_1) << "Try to create outgoing unidirectional client data streams";
-  return false;
+  if (!connection()->connected()) {
+    return false;
+  }
+  return CanOpenNextOutgoingUnidirectionalStream();
 }
 
 owt::quic::QuicTransportStreamInterface*
@@ -85,6 +95,7 @@ QuicTransportOwtClientSession::CreateOutgoingBidirectionalStream() {
   std::unique_ptr<QuicTransportOwtStreamImpl> stream =
         std::make_unique<QuicTransportOwtStreamImpl>(GetNextOutgoingBidirectionalStreamId(),
                                         this, BIDIRECTIONAL, task_runner_, event_runner_);
+  stream->set_receive_window_tuner(&receive_window_tuner_);
   owt::quic::QuicTransportStreamInterface* stream_ptr = stream.get();
   ActivateStream(std::move(stream));
   return stream_ptr;
@@ -92,8 +103,15 @@ QuicTransportOwtClientSession::CreateOutgoingBidirectionalStream() {
 
 owt::quic::QuicTransportStreamInterface*
 QuicTransportOwtClientSession::CreateOutgoingUnidirectionalStream() {
-  QUIC_BUG(quic_bug_10396_2) << "Try to create outgoing unidirectional client data streams";
-  return nullptr;
+  if (!ShouldCreateOutgoingUnidirectionalStream()) {
+    return nullptr;
+  }
+  std::unique_ptr<QuicTransportOwtStreamImpl> stream =
+        std::make_unique<QuicTransportOwtStreamImpl>(GetNextOutgoingUnidirectionalStreamId(),
+                                        this, WRITE_UNIDIRECTIONAL, task_runner_, event_runner_);
+  owt::quic::QuicTransportStreamInterface* stream_ptr = stream.get();
+  ActivateStream(std::move(stream));
+  return stream_ptr;
 }
 
 QuicCryptoClientStreamBase* QuicTransportOwtClientSession::GetMutableCryptoStream() {
@@ -156,7 +174,8 @@ QuicTransportOwtStreamImpl* QuicTransportOwtClientSession::CreateIncomingStream(
   }
 
   QuicTransportOwtStreamImpl* stream = new QuicTransportOwtStreamImpl(
-      id, this, BIDIRECTIONAL, task_runner_, event_runner_);
+      id, this, IncomingStreamType(id), task_runner_, event_runner_);
+  stream->set_receive_window_tuner(&receive_window_tuner_);
   ActivateStream(absl::WrapUnique(stream));
   if (visitor_) {
     visitor_->OnIncomingNewStream(stream);
@@ -167,7 +186,9 @@ QuicTransportOwtStreamImpl* QuicTransportOwtClientSession::CreateIncomingStream(
 QuicTransportOwtStreamImpl* QuicTransportOwtClientSession::CreateIncomingStream(
     PendingStream* pending) {
   QuicTransportOwtStreamImpl* stream = new QuicTransportOwtStreamImpl(
-      pending, this, BIDIRECTIONAL, task_runner_, event_runner_);
+      pending, this, IncomingStreamType(pending->id()), task_runner_,
+      event_runner_);
+  stream->set_receive_window_tuner(&receive_window_tuner_);
   ActivateStream(absl::WrapUnique(stream));
   if (visitor_) {
     visitor_->OnIncomingNewStream(stream);
@@ -175,6 +196,12 @@ QuicTransportOwtStreamImpl* QuicTransportOwtClientSession::CreateIncomingStream(
   return stream;
 }
 
+StreamType QuicTransportOwtClientSession::IncomingStreamType(
+    QuicStreamId id) const {
+  return QuicUtils::GetStreamType(id, perspective(), /*peer_initiated=*/true,
+                                  version());
+}
+
 std::unique_ptr<QuicCryptoClientStreamBase>
 QuicTransportOwtClientSession::CreateQuicCryptoStream() {
   return std::make_unique<QuicCryptoClientStream>(
@@ -196,20 +223,65 @@ bool QuicTransportOwtClientSession::ShouldKeepConnectionAlive() const {
 }
 
 void QuicTransportOwtClientSession::OnStreamClosed(quic::QuicStreamId stream_id) {
+  QuicStream* stream = GetActiveStream(stream_id);
+  if (stream) {
+    static_cast<QuicTransportOwtStreamImpl*>(stream)->NotifyClosed();
+  }
+  receive_window_tuner_.OnStreamClosed(stream_id);
+  // Before the stream is released, so the visitor can forget it first.
   if (visitor_) {
     visitor_->OnStreamClosed(stream_id);
   }
+  // Releases the stream.
+  QuicSession::OnStreamClosed(stream_id);
+}
+
+void QuicTransportOwtClientSession::SetMaxReceiveWindows(
+    QuicByteCount max_stream_window,
+    QuicByteCount max_session_window) {
+  receive_window_tuner_.SetMaxWindows(max_stream_window, max_session_window);
+}
+
+void QuicTransportOwtClientSession::SendDatagrams(
+    std::vector<quiche::QuicheMemSlice> datagrams) {
+  // Datagrams of a batch are coalesced into as few packets as possible.
+  QuicConnection::ScopedPacketFlusher flusher(connection());
+  for (auto& datagram : datagrams) {
+    MessageResult result = SendMessage(absl::MakeSpan(&datagram, 1));
+    if (result.status != MESSAGE_STATUS_SUCCESS) {
+      QUIC_DVLOG(1) << "Datagram dropped: "
+                    << MessageStatusToString(result.status);
+    }
+  }
+}
+
+void QuicTransportOwtClientSession::OnMessageReceived(
+    absl::string_view message) {
+  if (received_datagrams_.empty()) {
+    // Runs after packets currently being read are processed.
+    task_runner_->PostTask(
+        FROM_HERE,
+        base::BindOnce(&QuicTransportOwtClientSession::FlushReceivedDatagrams,
+                       weak_factory_.GetWeakPtr()));
+  }
+  received_datagrams_.emplace_back(message);
+}
+
+void QuicTransportOwtClientSession::FlushReceivedDatagrams() {
+  std::vector<std::string> datagrams;
+  datagrams.swap(received_datagrams_);
+  if (visitor_ && !datagrams.empty()) {
+    visitor_->OnDatagramsReceived(std::move(datagrams));
+  }
 }
 
 void QuicTransportOwtClientSession::OnConnectionClosed(
     const quic::QuicConnectionCloseFrame& frame,
     quic::ConnectionCloseSource source) {
-  const std::string& session_id_str =
-      connection()->client_connection_id().ToString();
-  char* id = new char[session_id_str.size() + 1];
-  strcpy(id, session_id_str.c_str());
   if (visitor_) {
-    visitor_->OnConnectionClosed(id, session_id_str.size());
+    std::string session_id_str =
+        connection()->client_connection_id().ToString();
+    visitor_->OnConnectionClosed(&session_id_str[0], session_id_str.size());
   }
 }
 
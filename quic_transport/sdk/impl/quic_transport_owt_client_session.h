@@ -5,11 +5,15 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 
+#include "net/third_party/quiche/src/quiche/common/quiche_mem_slice.h"
 #include "net/third_party/quiche/src/quiche/quic/core/quic_crypto_client_stream.h"
 #include "net/third_party/quiche/src/quiche/quic/core/quic_packets.h"
 
 #include "owt/quic_transport/sdk/impl/quic_transport_owt_stream_impl.h"
+#include "owt/quic_transport/sdk/impl/receive_window_tuner.h"
+#include "base/memory/weak_ptr.h"
 #include "base/task/single_thread_task_runner.h"
 
 namespace quic {
@@ -31,7 +35,11 @@ class QuicTransportOwtClientSession
     virtual void OnConnectionClosed(char*, size_t len) = 0;
     // Called when new incoming stream created
     virtual void OnIncomingNewStream(QuicTransportOwtStreamImpl* stream) = 0;
+    // Called before the stream is released.
     virtual void OnStreamClosed(uint32_t id) = 0;
+    // Called on the IO thread with datagrams received in one round of packet
+    // processing.
+    virtual void OnDatagramsReceived(std::vector<std::string> datagrams) = 0;
 
    protected:
     virtual ~Visitor() {}
@@ -100,8 +108,14 @@ class QuicTransportOwtClientSession
   void OnConnectionClosed(const quic::QuicConnectionCloseFrame& frame,
                           quic::ConnectionCloseSource source) override;
 
+  // Sends datagrams in a batch. Those which cannot be sent are dropped.
+  void SendDatagrams(std::vector<quiche::QuicheMemSlice> datagrams);
+
   bool IsConnected() { return connection()->connected(); }
   void set_visitor(Visitor* visitor) { visitor_ = visitor; }
+  // See owt::quic::ReceiveWindowTuner. Zero caps keep initial windows.
+  void SetMaxReceiveWindows(QuicByteCount max_stream_window,
+                            QuicByteCount max_session_window);
 
  protected:
   // QuicSession methods:
@@ -117,6 +131,8 @@ class QuicTransportOwtClientSession
 
   void OnStreamClosed(quic::QuicStreamId stream_id) override;
 
+  void OnMessageReceived(absl::string_view message) override;
+
   // // If an incoming stream can be created, return true.
   // // TODO(fayang): move this up to QuicSpdyClientSessionBase.
   bool ShouldCreateIncomingStream(QuicStreamId id);
@@ -128,6 +144,13 @@ class QuicTransportOwtClientSession
   QuicCryptoClientConfig* crypto_config() { return crypto_config_; }
 
  private:
+  // Returns the type of a stream created by the peer.
+  StreamType IncomingStreamType(QuicStreamId id) const;
+
+  // Delivers datagrams received in the last round of packet processing to
+  // `visitor_`.
+  void FlushReceivedDatagrams();
+
   std::unique_ptr<QuicCryptoClientStreamBase> crypto_stream_;
   QuicServerId server_id_;
   QuicCryptoClientConfig* crypto_config_;
@@ -139,6 +162,12 @@ class QuicTransportOwtClientSession
   // the creation of streams regardless of the high chance they will fail.
   bool respect_goaway_;
   Visitor* visitor_;
+  // Datagrams received since the last FlushReceivedDatagrams().
+  std::vector<std::string> received_datagrams_;
+  // Set on incoming and outgoing bidirectional streams.
+  owt::quic::ReceiveWindowTuner receive_window_tuner_;
+
+  base::WeakPtrFactory<QuicTransportOwtClientSession> weak_factory_{this};
 };
 
 }  // namespace quic
@@ -16,7 +16,7 @@ QuicTransportOwtDispatcher::QuicTransportOwtDispatcher(
     uint8_t expected_server_connection_id_length,
     ConnectionIdGeneratorInterface& generator,
     base::SingleThreadTaskRunner* io_runner,
-    base::SingleThreadTaskRunner* event_runner)
+    const owt::quic::EventThreadPool* event_threads)
     : QuicDispatcher(config,
                      crypto_config,
                      version_manager,
@@ -25,8 +25,11 @@ QuicTransportOwtDispatcher::QuicTransportOwtDispatcher(
                      std::move(alarm_factory),
                      expected_server_connection_id_length, generator),
       task_runner_(io_runner),
-      event_runner_(event_runner),
-      visitor_(nullptr){}
+      event_threads_(event_threads),
+      visitor_(nullptr),
+      congestion_control_(kBBR),
+      qlog_writer_(nullptr),
+      stats_counters_(nullptr) {}
 
 QuicTransportOwtDispatcher::~QuicTransportOwtDispatcher() = default;
 
@@ -44,24 +47,54 @@ std::unique_ptr<QuicSession> QuicTransportOwtDispatcher::CreateQuicSession(
                          alarm_factory(), writer(),
                          /* owns_writer= */ false, Perspective::IS_SERVER,
                          ParsedQuicVersionVector{version}, connection_id_generator());
+  // Congestion control requested by the client is applied when config is
+  // negotiated.
+  connection->sent_packet_manager().SetSendAlgorithm(congestion_control_);
 
+  base::SingleThreadTaskRunner* event_runner =
+      event_threads_->GetTaskRunner(connection_id.ToString());
+  session_event_runners_[connection_id] = event_runner;
   auto session = std::make_unique<QuicTransportOwtServerSession>(
       connection, this, config(), GetSupportedVersions(), session_helper(),
-      crypto_config(), compressed_certs_cache(), task_runner_, event_runner_);
+      crypto_config(), compressed_certs_cache(), task_runner_, event_runner);
   session->Initialize();
+  session->SetStatsCounters(stats_counters_);
+  sessions_[connection_id] = session.get();
+  if (qlog_writer_) {
+    session->SetConnectionLogger(qlog_writer_->MaybeCreateLogger(connection));
+  }
   if (visitor_) {
-    visitor_->OnSessionCreated(session.get());
+    visitor_->OnSessionCreated(session.get(), event_runner);
   }
   return session;
 }
 
+owt::quic::MemoryUsage QuicTransportOwtDispatcher::GetMemoryUsage() const {
+  DCHECK(task_runner_->BelongsToCurrentThread());
+  owt::quic::MemoryUsage usage = {};
+  for (const auto& session : sessions_) {
+    session.second->AddMemoryUsageOnCurrentThread(&usage);
+  }
+  return usage;
+}
+
 // Called when the connection is closed after the streams have been closed.
   void QuicTransportOwtDispatcher::OnConnectionClosed(QuicConnectionId server_connection_id,
                                     QuicErrorCode error,
                                     const std::string& error_details,
                                     ConnectionCloseSource source) {
+    // Closed event is delivered on the session's event runner, so it's not
+    // reordered with other callbacks of the session.
+    base::SingleThreadTaskRunner* event_runner =
+        event_threads_->default_runner();
+    auto it = session_event_runners_.find(server_connection_id);
+    if (it != session_event_runners_.end()) {
+      event_runner = it->second;
+      session_event_runners_.erase(it);
+    }
+    sessions_.erase(server_connection_id);
     if (visitor_) {
-      visitor_->OnSessionClosed(server_connection_id);
+      visitor_->OnSessionClosed(server_connection_id, event_runner);
     }
 
   }
@@ -5,9 +5,12 @@
 #ifndef QUIC_TRANSPORT_OWT_DISPATCHER_H_
 #define QUIC_TRANSPORT_OWT_DISPATCHER_H_
 
+#include "absl/container/flat_hash_map.h"
 #include "absl/strings/string_view.h"
 #include "net/third_party/quiche/src/quiche/quic/core/quic_dispatcher.h"
 
+#include "owt/quic_transport/sdk/impl/event_thread_pool.h"
+#include "owt/quic_transport/sdk/impl/qlog_writer.h"
 #include "owt/quic_transport/sdk/impl/quic_transport_owt_server_session.h"
 #include "base/task/single_thread_task_runner.h"
 
@@ -22,9 +25,14 @@ class QuicTransportOwtDispatcher : public QuicDispatcher {
     Visitor(const Visitor&) = delete;
     Visitor& operator=(const Visitor&) = delete;
 
-    // Called when new session created
-    virtual void OnSessionCreated(QuicTransportOwtServerSession* session) = 0;
-    virtual void OnSessionClosed(QuicConnectionId server_connection_id) = 0;
+    // Called when new session created. `event_runner` runs visitor callbacks
+    // of `session`.
+    virtual void OnSessionCreated(
+        QuicTransportOwtServerSession* session,
+        base::SingleThreadTaskRunner* event_runner) = 0;
+    virtual void OnSessionClosed(
+        QuicConnectionId server_connection_id,
+        base::SingleThreadTaskRunner* event_runner) = 0;
 
    protected:
     virtual ~Visitor() {}
@@ -40,7 +48,7 @@ class QuicTransportOwtDispatcher : public QuicDispatcher {
       uint8_t expected_server_connection_id_length,
       ConnectionIdGeneratorInterface& generator,
       base::SingleThreadTaskRunner* io_runner,
-      base::SingleThreadTaskRunner* event_runner);
+      const owt::quic::EventThreadPool* event_threads);
 
   ~QuicTransportOwtDispatcher() override;
 
@@ -52,6 +60,21 @@ class QuicTransportOwtDispatcher : public QuicDispatcher {
                                     ConnectionCloseSource source) override;
 
   void set_visitor(Visitor* visitor) { visitor_ = visitor; }
+  // Sets the congestion control algorithm of new connections. A client could
+  // override it with connection options.
+  void set_congestion_control(CongestionControlType congestion_control) {
+    congestion_control_ = congestion_control;
+  }
+  // New connections sampled by `writer` are logged. `writer` could be nullptr,
+  // and it must outlive this dispatcher.
+  void set_qlog_writer(owt::quic::QlogWriter* writer) { qlog_writer_ = writer; }
+  // Peer migrations of connections are counted by `counters`. It could be
+  // nullptr, and it must outlive this dispatcher.
+  void set_stats_counters(owt::quic::ServerStatsCounters* counters) {
+    stats_counters_ = counters;
+  }
+  // Returns memory held by sessions not closed. Must be called on IO thread.
+  owt::quic::MemoryUsage GetMemoryUsage() const;
 
  protected:
   std::unique_ptr<QuicSession> CreateQuicSession(
@@ -64,8 +87,23 @@ class QuicTransportOwtDispatcher : public QuicDispatcher {
 
  private:
   base::SingleThreadTaskRunner* task_runner_;
-  base::SingleThreadTaskRunner* event_runner_;
+  // Each session is pinned to one of its threads by connection ID. Not owned.
+  const owt::quic::EventThreadPool* event_threads_;
+  // Event runners of sessions not closed, keyed by the connection ID sessions
+  // are created with.
+  absl::flat_hash_map<QuicConnectionId,
+                      base::SingleThreadTaskRunner*,
+                      QuicConnectionIdHash>
+      session_event_runners_;
+  // Sessions not closed, keyed the same way as `session_event_runners_`.
+  absl::flat_hash_map<QuicConnectionId,
+                      QuicTransportOwtServerSession*,
+                      QuicConnectionIdHash>
+      sessions_;
   Visitor* visitor_;
+  CongestionControlType congestion_control_;
+  owt::quic::QlogWriter* qlog_writer_;
+  owt::quic::ServerStatsCounters* stats_counters_;
 };
 
 }  // namespace quic
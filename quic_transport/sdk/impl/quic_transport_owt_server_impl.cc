@@ -6,8 +6,17 @@
 
 #include <string.h>
 
+#include <algorithm>
+#include <cinttypes>
+#include <limits>
+
 #include "base/location.h"
+#include "base/strings/stringprintf.h"
+#include "base/time/time.h"
 #include "base/threading/thread_task_runner_handle.h"
+#include "base/trace_event/memory_allocator_dump.h"
+#include "base/trace_event/memory_dump_manager.h"
+#include "base/trace_event/process_memory_dump.h"
 #include "net/base/ip_endpoint.h"
 #include "net/base/net_errors.h"
 #include "net/log/net_log_source.h"
@@ -21,6 +30,10 @@
 #include "net/tools/quic/quic_simple_server_packet_writer.h"
 #include "net/tools/quic/quic_simple_server_session_helper.h"
 #include "net/quic/address_utils.h"
+#include "owt/quic_transport/sdk/impl/async_proof_source.h"
+#include "owt/quic_transport/sdk/impl/network_emulator.h"
+#include "owt/quic_transport/sdk/impl/placed_memory.h"
+#include "owt/quic_transport/sdk/impl/utilities.h"
 
 namespace net {
 
@@ -28,11 +41,45 @@ namespace {
 
 const char kSourceAddressTokenSecret[] = "secret";
 const size_t kNumSessionsToCreatePerSocketEvent = 16;
+const int kNumPacketsToReadPerSocketEvent = 32;
+const size_t kMaxEventThreadCount = 64;
+const size_t kMaxSigningThreadCount = 64;
+// Interval of updating rates and sampled values of server stats.
+const int64_t kStatsIntervalMs = 1000;
+// Interval of checking whether all connections are closed when draining.
+const int64_t kDrainCheckIntervalMs = 100;
 
 // Allocate some extra space so we can send an error if the client goes over
 // the limit.
 const int kReadBufferSize = 16 * quic::kMaxIncomingPacketSize;
 
+int OptionOrDefault(size_t option, int default_value) {
+  return option > 0 ? static_cast<int>(std::min<size_t>(
+                          option, std::numeric_limits<int>::max()))
+                    : default_value;
+}
+
+// Moves private key operations of `proof_source` to signing threads if
+// they're enabled by `options`.
+std::unique_ptr<quic::ProofSource> MaybeOffloadSigning(
+    std::unique_ptr<quic::ProofSource> proof_source,
+    const owt::quic::QuicTransportServerInterface::Options& options) {
+  if (options.signing_thread_count == 0) {
+    return proof_source;
+  }
+  return std::make_unique<owt::quic::AsyncProofSource>(
+      std::move(proof_source),
+      std::min(options.signing_thread_count, kMaxSigningThreadCount));
+}
+
+owt::quic::MemoryPlacement GetBufferPlacement(
+    const owt::quic::QuicTransportServerInterface::Options& options) {
+  owt::quic::MemoryPlacement placement;
+  placement.numa_node = options.buffer_numa_node;
+  placement.huge_pages = options.huge_page_buffers;
+  return placement;
+}
+
 }  // namespace
 
 
@@ -42,13 +89,29 @@ QuicTransportOwtServerImpl::QuicTransportOwtServerImpl(
     const quic::QuicConfig& config,
     const quic::QuicCryptoServerConfig::ConfigOptions& crypto_config_options,
     const quic::ParsedQuicVersionVector& supported_versions,
+    const owt::quic::QuicTransportServerInterface::Options& options,
     base::Thread* io_thread,
-    base::Thread* event_thread)
+    scoped_refptr<base::SingleThreadTaskRunner> event_runner)
     : port_(port),
       version_manager_(supported_versions),
-      helper_(
-          new QuicChromiumConnectionHelper(&clock_,
-                                           quic::QuicRandom::GetInstance())),
+      // In inline dispatch mode, IO thread is also the event thread.
+      event_threads_(std::make_unique<owt::quic::EventThreadPool>(
+          options.inline_event_dispatch ? io_thread->task_runner()
+                                        : std::move(event_runner),
+          options.inline_event_dispatch
+              ? 1
+              : std::min(options.event_thread_count, kMaxEventThreadCount))),
+      send_buffer_pool_(options.pooled_send_buffers
+                            ? std::make_unique<owt::quic::PooledBufferAllocator>(
+                                  io_thread->task_runner(),
+                                  GetBufferPlacement(options))
+                            : nullptr),
+      helper_(send_buffer_pool_
+                  ? new owt::quic::PooledBufferConnectionHelper(
+                        &clock_, quic::QuicRandom::GetInstance(),
+                        send_buffer_pool_.get())
+                  : new QuicChromiumConnectionHelper(
+                        &clock_, quic::QuicRandom::GetInstance())),
       alarm_factory_(new QuicChromiumAlarmFactory(
           base::ThreadTaskRunnerHandle::Get().get(),
           &clock_)),
@@ -56,14 +119,39 @@ QuicTransportOwtServerImpl::QuicTransportOwtServerImpl(
       crypto_config_options_(crypto_config_options),
       crypto_config_(kSourceAddressTokenSecret,
                      quic::QuicRandom::GetInstance(),
-                     std::move(proof_source),
+                     MaybeOffloadSigning(std::move(proof_source), options),
                      quic::KeyExchangeSource::Default()),
       read_pending_(false),
       synchronous_read_count_(0),
+      // These default send and receive buffer sizes are sized for a single
+      // connection, because the default usage of QuicTransportOwtServerImpl
+      // is as a test server with one or two clients. `options` should be set
+      // for use with many clients.
+      socket_receive_buffer_size_(
+          OptionOrDefault(options.socket_receive_buffer_size,
+                          static_cast<int>(quic::kDefaultSocketReceiveBuffer))),
+      socket_send_buffer_size_(
+          OptionOrDefault(options.socket_send_buffer_size,
+                          320 * quic::kMaxIncomingPacketSize)),
+      max_packets_per_read_(OptionOrDefault(options.max_packets_per_read,
+                                            kNumPacketsToReadPerSocketEvent)),
+      max_new_connections_per_read_(options.max_new_connections_per_read > 0
+                                        ? options.max_new_connections_per_read
+                                        : kNumSessionsToCreatePerSocketEvent),
+      congestion_control_(owt::quic::Utilities::ConvertCongestionControlType(
+          options.congestion_control)),
+      network_emulation_(options.network_emulation
+                             ? absl::make_optional(*options.network_emulation)
+                             : absl::nullopt),
       read_buffer_(base::MakeRefCounted<IOBufferWithSize>(kReadBufferSize)),
       task_runner_(io_thread->task_runner()),
-      event_runner_(event_thread->task_runner()),
       connection_id_generator_(quic::kQuicDefaultConnectionIdLength),
+      stats_interval_start_(quic::QuicTime::Zero()),
+      busy_time_in_interval_(quic::QuicTime::Delta::Zero()),
+      sessions_created_(0),
+      sessions_created_before_interval_(0),
+      chlo_backlog_passes_(0),
+      memory_dump_provider_registered_(false),
       weak_factory_(this) {
   Initialize();
 }
@@ -119,16 +207,12 @@ void QuicTransportOwtServerImpl::StartOnCurrentThread() {
     LOG(ERROR) << "Listen() failed: " << ErrorToString(rc);
   }
 
-  // These send and receive buffer sizes are sized for a single connection,
-  // because the default usage of QuicTransportOwtServerImpl is as a test server with
-  // one or two clients.  Adjust higher for use with many clients.
-  rc = socket->SetReceiveBufferSize(
-      static_cast<int32_t>(quic::kDefaultSocketReceiveBuffer));
+  rc = socket->SetReceiveBufferSize(socket_receive_buffer_size_);
   if (rc < 0) {
     LOG(ERROR) << "SetReceiveBufferSize() failed: " << ErrorToString(rc);
   }
 
-  rc = socket->SetSendBufferSize(320 * quic::kMaxIncomingPacketSize);
+  rc = socket->SetSendBufferSize(socket_send_buffer_size_);
   if (rc < 0) {
     LOG(ERROR) << "SetSendBufferSize() failed: " << ErrorToString(rc);
   }
@@ -149,11 +233,37 @@ void QuicTransportOwtServerImpl::StartOnCurrentThread() {
       std::unique_ptr<quic::QuicConnectionHelperInterface>(helper_),
       std::unique_ptr<quic::QuicCryptoServerStream::Helper>(
           new QuicSimpleServerSessionHelper(quic::QuicRandom::GetInstance())),
-      std::unique_ptr<quic::QuicAlarmFactory>(alarm_factory_), quic::kQuicDefaultConnectionIdLength, connection_id_generator_, task_runner_.get(), event_runner_.get()));
-  QuicSimpleServerPacketWriter* writer =
+      std::unique_ptr<quic::QuicAlarmFactory>(alarm_factory_),
+      routable_connection_id_generator_
+          ? routable_connection_id_generator_->connection_id_length()
+          : quic::kQuicDefaultConnectionIdLength,
+      routable_connection_id_generator_
+          ? static_cast<quic::ConnectionIdGeneratorInterface&>(
+                *routable_connection_id_generator_)
+          : connection_id_generator_,
+      task_runner_.get(), event_threads_.get()));
+  quic::QuicPacketWriter* writer =
       new QuicSimpleServerPacketWriter(socket_.get(), dispatcher_.get());
-  dispatcher_->InitializeWithWriter(writer);
+  if (network_emulation_) {
+    writer = new owt::quic::NetworkEmulatingPacketWriter(writer,
+                                                         *network_emulation_);
+  }
+  dispatcher_->InitializeWithWriter(
+      new owt::quic::StatsRecordingPacketWriter(writer, &stats_counters_));
   dispatcher_->set_visitor(this);
+  dispatcher_->set_congestion_control(congestion_control_);
+  dispatcher_->set_qlog_writer(qlog_writer_.get());
+  dispatcher_->set_stats_counters(&stats_counters_);
+
+  stats_interval_start_ = clock_.Now();
+  // The timer is stopped on IO thread before the server is destroyed.
+  stats_timer_.Start(
+      FROM_HERE, base::Milliseconds(kStatsIntervalMs),
+      base::BindRepeating(&QuicTransportOwtServerImpl::UpdateStats,
+                          base::Unretained(this)));
+  base::trace_event::MemoryDumpManager::GetInstance()->RegisterDumpProvider(
+      this, "OwtQuicTransportServer", task_runner_);
+  memory_dump_provider_registered_ = true;
 
   StartReading();
 
@@ -168,13 +278,64 @@ void QuicTransportOwtServerImpl::Stop() {
 void QuicTransportOwtServerImpl::StopOnCurrentThread() {
   // Before we shut down the epoll server, give all active sessions a chance to
   // notify clients that they're closing.
-  dispatcher_->Shutdown();
+  if (dispatcher_) {
+    dispatcher_->Shutdown();
+  }
+  stats_timer_.Stop();
+  drain_timer_.Stop();
+  if (memory_dump_provider_registered_) {
+    base::trace_event::MemoryDumpManager::GetInstance()
+        ->UnregisterDumpProvider(this);
+    memory_dump_provider_registered_ = false;
+  }
+  stats_counters_.SetMemoryUsage(owt::quic::MemoryUsage());
+
+  if (socket_) {
+    socket_->Close();
+    socket_.reset();
+  }
+  if (visitor_) {
+    event_threads_->default_runner()->PostTask(
+        FROM_HERE,
+        base::BindOnce(
+            &owt::quic::QuicTransportServerInterface::Visitor::OnEnded,
+            base::Unretained(visitor_)));
+  }
+}
 
-  if (!socket_) {
+void QuicTransportOwtServerImpl::Drain(uint32_t timeout_ms) {
+  task_runner_->PostTask(
+      FROM_HERE,
+      base::BindOnce(&QuicTransportOwtServerImpl::DrainOnCurrentThread,
+                     weak_factory_.GetWeakPtr(), timeout_ms));
+}
+
+void QuicTransportOwtServerImpl::DrainOnCurrentThread(uint32_t timeout_ms) {
+  if (!dispatcher_) {
+    StopOnCurrentThread();
+    return;
+  }
+  LOG(INFO) << "Draining " << dispatcher_->NumSessions() << " connection(s).";
+  // CHLOs of new connections are answered with CONNECTION_CLOSE.
+  dispatcher_->StopAcceptingNewConnections();
+  drain_deadline_ = base::TimeTicks::Now() + base::Milliseconds(timeout_ms);
+  // The timer is stopped on IO thread before the server is destroyed.
+  drain_timer_.Start(
+      FROM_HERE, base::Milliseconds(kDrainCheckIntervalMs),
+      base::BindRepeating(&QuicTransportOwtServerImpl::CheckDrained,
+                          base::Unretained(this)));
+}
+
+void QuicTransportOwtServerImpl::CheckDrained() {
+  if (dispatcher_->NumSessions() > 0 &&
+      base::TimeTicks::Now() < drain_deadline_) {
     return;
   }
-  socket_->Close();
-  socket_.reset();
+  if (dispatcher_->NumSessions() > 0) {
+    LOG(WARNING) << "Closing " << dispatcher_->NumSessions()
+                 << " connection(s) not drained in time.";
+  }
+  StopOnCurrentThread();
 }
 
 void QuicTransportOwtServerImpl::SetVisitor(owt::quic::QuicTransportServerInterface::Visitor* visitor) { 
@@ -187,8 +348,15 @@ void QuicTransportOwtServerImpl::NewSessionCreated(quic::QuicTransportOwtServerS
   }
 }
 
-void QuicTransportOwtServerImpl::OnSessionCreated(quic::QuicTransportOwtServerSession* session) {
-  event_runner_->PostTask(
+void QuicTransportOwtServerImpl::OnSessionCreated(
+    quic::QuicTransportOwtServerSession* session,
+    base::SingleThreadTaskRunner* event_runner) {
+  sessions_created_++;
+  if (event_runner->BelongsToCurrentThread()) {
+    NewSessionCreated(session);
+    return;
+  }
+  event_runner->PostTask(
       FROM_HERE,
       base::BindOnce(
           [](QuicTransportOwtServerImpl* server,
@@ -200,15 +368,19 @@ void QuicTransportOwtServerImpl::OnSessionCreated(quic::QuicTransportOwtServerSe
 
 void QuicTransportOwtServerImpl::SessionClosed(quic::QuicConnectionId sessionId) {
   if (visitor_) {
-    const std::string& session_id_str = sessionId.ToString();
-    char* id = new char[session_id_str.size() + 1];
-    strcpy(id, session_id_str.c_str());
-    visitor_->OnClosedSession(id, session_id_str.size());
+    std::string session_id_str = sessionId.ToString();
+    visitor_->OnClosedSession(&session_id_str[0], session_id_str.size());
   }
 }
 
-void QuicTransportOwtServerImpl::OnSessionClosed(quic::QuicConnectionId sessionId) {
-  event_runner_->PostTask(
+void QuicTransportOwtServerImpl::OnSessionClosed(
+    quic::QuicConnectionId sessionId,
+    base::SingleThreadTaskRunner* event_runner) {
+  if (event_runner->BelongsToCurrentThread()) {
+    SessionClosed(sessionId);
+    return;
+  }
+  event_runner->PostTask(
       FROM_HERE,
       base::BindOnce(
           [](QuicTransportOwtServerImpl* server,
@@ -222,6 +394,115 @@ int QuicTransportOwtServerImpl::GetListenPort() {
   return port_;
 }
 
+bool QuicTransportOwtServerImpl::SetConnectionIdRouting(
+    const owt::quic::QuicTransportServerInterface::ConnectionIdRoutingConfig&
+        config) {
+  DCHECK(!dispatcher_) << "Connection ID routing must be set before Start().";
+  owt::quic::RoutableConnectionIdGenerator::Config generator_config;
+  generator_config.config_id = config.config_id;
+  if (config.server_id) {
+    generator_config.server_id.assign(
+        reinterpret_cast<const char*>(config.server_id),
+        config.server_id_length);
+  }
+  if (config.key) {
+    generator_config.key.assign(reinterpret_cast<const char*>(config.key), 16);
+  }
+  generator_config.connection_id_length = config.connection_id_length;
+  std::unique_ptr<owt::quic::RoutableConnectionIdGenerator> generator =
+      owt::quic::RoutableConnectionIdGenerator::Create(generator_config);
+  if (!generator) {
+    return false;
+  }
+  routable_connection_id_generator_ = std::move(generator);
+  return true;
+}
+
+bool QuicTransportOwtServerImpl::EnableQlog(
+    const owt::quic::QlogOptions& options) {
+  DCHECK(!dispatcher_) << "Qlog must be enabled before Start().";
+  std::unique_ptr<owt::quic::QlogWriter> writer =
+      owt::quic::QlogWriter::Create(options);
+  if (!writer) {
+    return false;
+  }
+  qlog_writer_ = std::move(writer);
+  return true;
+}
+
+owt::quic::ServerStats QuicTransportOwtServerImpl::GetServerStats() {
+  owt::quic::ServerStats stats;
+  stats_counters_.Read(&stats);
+  return stats;
+}
+
+size_t QuicTransportOwtServerImpl::GetIoThreadStats(
+    owt::quic::ServerStats* stats,
+    size_t max_count) {
+  // All connections are processed on a single IO thread.
+  if (max_count > 0) {
+    DCHECK(stats);
+    stats_counters_.Read(stats);
+  }
+  return 1;
+}
+
+owt::quic::MemoryUsage QuicTransportOwtServerImpl::GetMemoryUsage() {
+  owt::quic::MemoryUsage usage;
+  stats_counters_.ReadMemoryUsage(&usage);
+  return usage;
+}
+
+bool QuicTransportOwtServerImpl::OnMemoryDump(
+    const base::trace_event::MemoryDumpArgs& args,
+    base::trace_event::ProcessMemoryDump* pmd) {
+  DCHECK(task_runner_->BelongsToCurrentThread());
+  using base::trace_event::MemoryAllocatorDump;
+  const owt::quic::MemoryUsage usage = dispatcher_->GetMemoryUsage();
+  MemoryAllocatorDump* dump = pmd->CreateAllocatorDump(
+      base::StringPrintf("owt_quic/quic_transport_server/0x%" PRIXPTR,
+                         reinterpret_cast<uintptr_t>(this)));
+  dump->AddScalar(MemoryAllocatorDump::kNameSize,
+                  MemoryAllocatorDump::kUnitsBytes, usage.total_bytes);
+  dump->AddScalar(MemoryAllocatorDump::kNameObjectCount,
+                  MemoryAllocatorDump::kUnitsObjects, usage.sessions);
+  dump->AddScalar("streams", MemoryAllocatorDump::kUnitsObjects,
+                  usage.streams);
+  dump->AddScalar("stream_send_buffers", MemoryAllocatorDump::kUnitsBytes,
+                  usage.stream_send_buffer_bytes);
+  dump->AddScalar("stream_receive_buffers", MemoryAllocatorDump::kUnitsBytes,
+                  usage.stream_receive_buffer_bytes);
+  dump->AddScalar("datagram_buffers", MemoryAllocatorDump::kUnitsBytes,
+                  usage.datagram_buffer_bytes);
+  if (send_buffer_pool_) {
+    dump->AddScalar("send_buffer_pool", MemoryAllocatorDump::kUnitsBytes,
+                    send_buffer_pool_->cached_bytes());
+    dump->AddScalar("send_buffer_slabs", MemoryAllocatorDump::kUnitsBytes,
+                    send_buffer_pool_->slab_bytes());
+  }
+  return true;
+}
+
+void QuicTransportOwtServerImpl::UpdateStats() {
+  const quic::QuicTime now = clock_.Now();
+  const int64_t elapsed_us = (now - stats_interval_start_).ToMicroseconds();
+  if (elapsed_us <= 0) {
+    return;
+  }
+  const uint64_t handshakes_per_second =
+      (sessions_created_ - sessions_created_before_interval_) * 1000000 /
+      elapsed_us;
+  const uint64_t loop_utilization_percent = std::min<uint64_t>(
+      100, busy_time_in_interval_.ToMicroseconds() * 100 / elapsed_us);
+  stats_counters_.SetSessions(dispatcher_->NumSessions(), sessions_created_);
+  stats_counters_.SetChloBacklogPasses(chlo_backlog_passes_);
+  stats_counters_.SetRates(handshakes_per_second, loop_utilization_percent);
+  stats_counters_.SetMemoryUsage(dispatcher_->GetMemoryUsage());
+  stats_interval_start_ = now;
+  busy_time_in_interval_ = quic::QuicTime::Delta::Zero();
+  sessions_created_before_interval_ = sessions_created_;
+}
+
 void QuicTransportOwtServerImpl::ScheduleReadPackets() {
   task_runner_->PostTask(FROM_HERE,
                          base::BindOnce(&QuicTransportOwtServerImpl::StartReading,
@@ -231,7 +512,9 @@ void QuicTransportOwtServerImpl::ScheduleReadPackets() {
 void QuicTransportOwtServerImpl::StartReading() {
   if (synchronous_read_count_ == 0) {
     // Only process buffered packets once per message loop.
-    dispatcher_->ProcessBufferedChlos(kNumSessionsToCreatePerSocketEvent);
+    const quic::QuicTime start = clock_.Now();
+    dispatcher_->ProcessBufferedChlos(max_new_connections_per_read_);
+    busy_time_in_interval_ = busy_time_in_interval_ + (clock_.Now() - start);
   }
 
   if (read_pending_) {
@@ -246,6 +529,7 @@ void QuicTransportOwtServerImpl::StartReading() {
   if (result == ERR_IO_PENDING) {
     synchronous_read_count_ = 0;
     if (dispatcher_->HasChlosBuffered()) {
+      chlo_backlog_passes_++;
       // No more packets to read, so yield before processing buffered packets.
       base::ThreadTaskRunnerHandle::Get()->PostTask(
           FROM_HERE, base::BindOnce(&QuicTransportOwtServerImpl::StartReading,
@@ -255,7 +539,7 @@ void QuicTransportOwtServerImpl::StartReading() {
     return;
   }
 
-  if (++synchronous_read_count_ > 32) {
+  if (++synchronous_read_count_ > max_packets_per_read_) {
     synchronous_read_count_ = 0;
     // Schedule the processing through the message loop to 1) prevent infinite
     // recursion and 2) avoid blocking the thread for too long.
@@ -279,12 +563,16 @@ void QuicTransportOwtServerImpl::OnReadComplete(int result) {
     return;
   }
 
-  quic::QuicReceivedPacket packet(read_buffer_->data(), result,
-                                  helper_->GetClock()->Now(), false);
+  const quic::QuicTime receive_time = helper_->GetClock()->Now();
+  quic::QuicReceivedPacket packet(read_buffer_->data(), result, receive_time,
+                                  false);
+  stats_counters_.OnPacketReceived(result);
   dispatcher_->ProcessPacket(
       ToQuicSocketAddress(server_address_),
       ToQuicSocketAddress(client_address_),
       packet);
+  busy_time_in_interval_ =
+      busy_time_in_interval_ + (helper_->GetClock()->Now() - receive_time);
 
   StartReading();
 }
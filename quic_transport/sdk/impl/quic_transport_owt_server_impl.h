@@ -10,6 +10,7 @@
 #include <memory>
 
 #include "absl/base/macros.h"
+#include "absl/types/optional.h"
 #include "net/base/io_buffer.h"
 #include "net/base/ip_endpoint.h"
 #include "net/log/net_log.h"
@@ -20,11 +21,18 @@
 #include "net/third_party/quiche/src/quiche/quic/core/quic_config.h"
 #include "net/third_party/quiche/src/quiche/quic/core/quic_version_manager.h"
 #include "net/quic/platform/impl/quic_chromium_clock.h"
+#include "owt/quic_transport/sdk/impl/event_thread_pool.h"
+#include "owt/quic_transport/sdk/impl/pooled_buffer_allocator.h"
 #include "owt/quic_transport/sdk/impl/quic_transport_owt_dispatcher.h"
 #include "owt/quic/quic_transport_server_interface.h"
 #include "owt/quic_transport/sdk/impl/proof_source_owt.h"
+#include "owt/quic_transport/sdk/impl/qlog_writer.h"
+#include "owt/quic_transport/sdk/impl/routable_connection_id_generator.h"
+#include "owt/quic_transport/sdk/impl/server_stats_counters.h"
 #include "base/task/single_thread_task_runner.h"
 #include "base/threading/thread.h"
+#include "base/timer/timer.h"
+#include "base/trace_event/memory_dump_provider.h"
 
 namespace net {
 
@@ -38,7 +46,8 @@ namespace net {
 
 class QuicTransportOwtServerImpl 
       : public owt::quic::QuicTransportServerInterface,
-        public quic::QuicTransportOwtDispatcher::Visitor {
+        public quic::QuicTransportOwtDispatcher::Visitor,
+        public base::trace_event::MemoryDumpProvider {
  public:
   QuicTransportOwtServerImpl(
       int port,
@@ -51,8 +60,9 @@ class QuicTransportOwtServerImpl
       const quic::QuicConfig& config,
       const quic::QuicCryptoServerConfig::ConfigOptions& crypto_config_options,
       const quic::ParsedQuicVersionVector& supported_versions,
+      const owt::quic::QuicTransportServerInterface::Options& options,
       base::Thread* io_thread,
-      base::Thread* event_thread);
+      scoped_refptr<base::SingleThreadTaskRunner> event_runner);
 
   ~QuicTransportOwtServerImpl() override;
 
@@ -61,12 +71,27 @@ class QuicTransportOwtServerImpl
   int Start() override;
   // Server deletion is imminent. Start cleaning up.
   void Stop() override;
+  void Drain(uint32_t timeout_ms) override;
   void SetVisitor(owt::quic::QuicTransportServerInterface::Visitor* visitor) override;
   int GetListenPort() override;
+  bool SetConnectionIdRouting(
+      const owt::quic::QuicTransportServerInterface::ConnectionIdRoutingConfig&
+          config) override;
+  bool EnableQlog(const owt::quic::QlogOptions& options) override;
+  owt::quic::ServerStats GetServerStats() override;
+  size_t GetIoThreadStats(owt::quic::ServerStats* stats,
+                          size_t max_count) override;
+  owt::quic::MemoryUsage GetMemoryUsage() override;
 
   // Implement quic::QuicTransportOwtDispatcher::Visitor
-  void OnSessionCreated(quic::QuicTransportOwtServerSession* session) override;
-  void OnSessionClosed(quic::QuicConnectionId sessionId) override;
+  void OnSessionCreated(quic::QuicTransportOwtServerSession* session,
+                        base::SingleThreadTaskRunner* event_runner) override;
+  void OnSessionClosed(quic::QuicConnectionId sessionId,
+                       base::SingleThreadTaskRunner* event_runner) override;
+
+  // Implement base::trace_event::MemoryDumpProvider. Called on IO thread.
+  bool OnMemoryDump(const base::trace_event::MemoryDumpArgs& args,
+                    base::trace_event::ProcessMemoryDump* pmd) override;
 
   // Start reading on the socket. On asynchronous reads, this registers
   // OnReadComplete as the callback, which will then call StartReading again.
@@ -87,14 +112,29 @@ class QuicTransportOwtServerImpl
 
   void StartOnCurrentThread();
   void StopOnCurrentThread();
+  void DrainOnCurrentThread(uint32_t timeout_ms);
+  // Stops the server if draining is complete or timed out.
+  void CheckDrained();
   void ScheduleReadPackets();
   void NewSessionCreated(quic::QuicTransportOwtServerSession* session);
   void SessionClosed(quic::QuicConnectionId sessionId);
+  // Publishes sampled values and rates of the last second to
+  // `stats_counters_`.
+  void UpdateStats();
 
   int port_;
 
   quic::QuicVersionManager version_manager_;
 
+  // Runs visitor callbacks. Its first thread is the factory's event thread.
+  // Sessions hold its task runners, so it must outlive `dispatcher_`.
+  std::unique_ptr<owt::quic::EventThreadPool> event_threads_;
+
+  // Allocates send buffers of connections when pooled send buffers are
+  // enabled, otherwise it's nullptr. Buffers may be deleted after the helper,
+  // so it must outlive `dispatcher_`.
+  std::unique_ptr<owt::quic::PooledBufferAllocator> send_buffer_pool_;
+
   // Accepts data from the framer and demuxes clients to sessions.
   std::unique_ptr<quic::QuicTransportOwtDispatcher> dispatcher_;
 
@@ -130,6 +170,15 @@ class QuicTransportOwtServerImpl
   // and without posting a new task to the message loop.
   int synchronous_read_count_;
 
+  // Socket buffer sizes and read budgets, defaults are resolved.
+  const int socket_receive_buffer_size_;
+  const int socket_send_buffer_size_;
+  const int max_packets_per_read_;
+  const size_t max_new_connections_per_read_;
+  const quic::CongestionControlType congestion_control_;
+  // Copied from the options the server is created with.
+  const absl::optional<owt::quic::NetworkEmulationOptions> network_emulation_;
+
   // The target buffer of the current read.
   scoped_refptr<IOBufferWithSize> read_buffer_;
 
@@ -138,11 +187,31 @@ class QuicTransportOwtServerImpl
 
 
   scoped_refptr<base::SingleThreadTaskRunner> task_runner_;
-  scoped_refptr<base::SingleThreadTaskRunner> event_runner_;
 
   owt::quic::QuicTransportServerInterface::Visitor* visitor_;
 
+  // Used when `routable_connection_id_generator_` is not set.
   quic::DeterministicConnectionIdGenerator connection_id_generator_;
+  std::unique_ptr<owt::quic::RoutableConnectionIdGenerator>
+      routable_connection_id_generator_;
+  // Writes qlog of sampled connections. It's nullptr if qlog is not enabled.
+  // Loggers created by it are owned by sessions, so it must outlive
+  // `dispatcher_`.
+  std::unique_ptr<owt::quic::QlogWriter> qlog_writer_;
+
+  // Updated on IO thread, read by GetServerStats() on any thread.
+  owt::quic::ServerStatsCounters stats_counters_;
+  base::RepeatingTimer stats_timer_;
+  base::RepeatingTimer drain_timer_;
+  base::TimeTicks drain_deadline_;
+  // States of current stats interval.
+  quic::QuicTime stats_interval_start_;
+  quic::QuicTime::Delta busy_time_in_interval_;
+  uint64_t sessions_created_;
+  uint64_t sessions_created_before_interval_;
+  // Read loops which stopped with CHLOs still buffered.
+  uint64_t chlo_backlog_passes_;
+  bool memory_dump_provider_registered_;
 
   base::WeakPtrFactory<QuicTransportOwtServerImpl> weak_factory_;
 
@@ -9,11 +9,16 @@
 #include <string>
 #include <utility>
 
+#include "net/third_party/quiche/src/quiche/quic/core/quic_bandwidth.h"
+#include "net/third_party/quiche/src/quiche/quic/core/quic_connection.h"
+#include "net/third_party/quiche/src/quiche/quic/core/quic_constants.h"
 #include "net/third_party/quiche/src/quiche/quic/core/quic_utils.h"
 #include "net/third_party/quiche/src/quiche/quic/platform/api/quic_bug_tracker.h"
 #include "net/third_party/quiche/src/quiche/quic/platform/api/quic_flag_utils.h"
 #include "net/third_party/quiche/src/quiche/quic/platform/api/quic_flags.h"
 #include "net/third_party/quiche/src/quiche/quic/platform/api/quic_logging.h"
+#include "owt/quic_transport/sdk/impl/server_stats_counters.h"
+#include "owt/quic_transport/sdk/impl/utilities.h"
 
 namespace quic {
 
@@ -28,15 +33,27 @@ QuicTransportOwtServerSession::QuicTransportOwtServerSession(
     base::SingleThreadTaskRunner* io_runner,
     base::SingleThreadTaskRunner* event_runner)
     : QuicSession(connection, visitor, config, supported_versions,  0u),
+      stats_counters_(nullptr),
       crypto_config_(crypto_config),
       compressed_certs_cache_(compressed_certs_cache),
       helper_(helper),
       task_runner_(io_runner),
       event_runner_(event_runner),
-      visitor_(nullptr) {
+      visitor_(nullptr),
+      connection_id_(connection->connection_id().ToString()),
+      live_streams_(base::MakeRefCounted<owt::quic::LiveStreamRegistry>()) {
+  // Advertises support for DATAGRAM frames.
+  this->config()->SetMaxDatagramFrameSizeToSend(kMaxAcceptedDatagramFrameSize);
 }
 
 QuicTransportOwtServerSession::~QuicTransportOwtServerSession() {
+  // Streams are released by QuicSession's destructor.
+  live_streams_->Clear();
+  // The connection is not owned by this session, it must not report events to
+  // the logger destroyed with this session.
+  if (connection_logger_) {
+    connection()->set_debug_visitor(nullptr);
+  }
   // Set the streams' session pointers in closed and dynamic stream lists
   // to null to avoid subsequent use of this session.
   // for (auto& stream : *closed_streams()) {
@@ -50,6 +67,17 @@ QuicTransportOwtServerSession::~QuicTransportOwtServerSession() {
   // }
 }
 
+void QuicTransportOwtServerSession::SetConnectionLogger(
+    std::unique_ptr<owt::quic::QlogConnectionLogger> logger) {
+  connection_logger_ = std::move(logger);
+  connection()->set_debug_visitor(connection_logger_.get());
+}
+
+void QuicTransportOwtServerSession::SetStatsCounters(
+    owt::quic::ServerStatsCounters* counters) {
+  stats_counters_ = counters;
+}
+
 void QuicTransportOwtServerSession::Initialize() {
   crypto_stream_ =
       CreateQuicCryptoServerStream(crypto_config_, compressed_certs_cache_);
@@ -76,10 +104,39 @@ void QuicTransportOwtServerSession::OnConnectionClosed(
   }
 }
 
+void QuicTransportOwtServerSession::OnConnectionMigration(
+    AddressChangeType type) {
+  // QuicConnection has already switched to the new peer address, and it
+  // validates the new path and resets congestion control unless only the
+  // port changed.
+  QuicSession::OnConnectionMigration(type);
+  if (stats_counters_) {
+    stats_counters_->OnPeerMigration(type == PORT_CHANGE);
+  }
+}
+
 void QuicTransportOwtServerSession::OnStreamClosed(quic::QuicStreamId stream_id) {
-  if (visitor_) {
+  QuicStream* stream = GetActiveStream(stream_id);
+  if (stream) {
+    static_cast<QuicTransportOwtStreamImpl*>(stream)->NotifyClosed();
+  }
+  live_streams_->Remove(stream_id);
+  // Releases the stream.
+  QuicSession::OnStreamClosed(stream_id);
+  if (!visitor_) {
+    return;
+  }
+  if (event_runner_->BelongsToCurrentThread()) {
     visitor_->OnStreamClosed(stream_id);
+    return;
   }
+  // Posted like OnIncomingStream, so the visitor gets them in order.
+  event_runner_->PostTask(
+      FROM_HERE,
+      base::BindOnce(
+          [](owt::quic::QuicTransportSessionInterface::Visitor* visitor,
+             uint32_t id) { visitor->OnStreamClosed(id); },
+          base::Unretained(visitor_), stream_id));
 }
 
 void QuicTransportOwtServerSession::StopOnCurrentThread() {
@@ -102,12 +159,7 @@ void QuicTransportOwtServerSession::SetVisitor(owt::quic::QuicTransportSessionIn
 }
 
 const char* QuicTransportOwtServerSession::Id() {
-  const std::string& session_id_str =
-      connection()->connection_id().ToString();
-  char* id = new char[session_id_str.size() + 1];
-  strcpy(id, session_id_str.c_str());
-
-  return id;
+  return connection_id_.c_str();
 }
 
 void QuicTransportOwtServerSession::CloseStreamOnCurrentThread(uint32_t id) {
@@ -120,8 +172,131 @@ void QuicTransportOwtServerSession::CloseStream(uint32_t id) {
       base::BindOnce(&QuicTransportOwtServerSession::CloseStreamOnCurrentThread, base::Unretained(this), id));
 }
 
+void QuicTransportOwtServerSession::SendDatagrams(
+    const owt::quic::Datagram* batch,
+    size_t count) {
+  std::vector<quiche::QuicheMemSlice> datagrams =
+      owt::quic::Utilities::CopyDatagrams(batch, count);
+  if (task_runner_->BelongsToCurrentThread()) {
+    return SendDatagramsOnCurrentThread(std::move(datagrams));
+  }
+  task_runner_->PostTask(
+      FROM_HERE,
+      base::BindOnce(&QuicTransportOwtServerSession::SendDatagramsOnCurrentThread,
+                     base::Unretained(this), std::move(datagrams)));
+}
+
+void QuicTransportOwtServerSession::SetMaxSendRate(uint64_t bits_per_second) {
+  if (task_runner_->BelongsToCurrentThread()) {
+    return SetMaxSendRateOnCurrentThread(bits_per_second);
+  }
+  task_runner_->PostTask(
+      FROM_HERE,
+      base::BindOnce(
+          &QuicTransportOwtServerSession::SetMaxSendRateOnCurrentThread,
+          base::Unretained(this), bits_per_second));
+}
+
+owt::quic::MemoryUsage QuicTransportOwtServerSession::GetMemoryUsage() {
+  owt::quic::MemoryUsage usage = {};
+  if (task_runner_->BelongsToCurrentThread()) {
+    AddMemoryUsageOnCurrentThread(&usage);
+    return usage;
+  }
+  base::WaitableEvent done(base::WaitableEvent::ResetPolicy::AUTOMATIC,
+                           base::WaitableEvent::InitialState::NOT_SIGNALED);
+  task_runner_->PostTask(
+      FROM_HERE,
+      base::BindOnce(
+          [](QuicTransportOwtServerSession* session,
+             owt::quic::MemoryUsage* usage, base::WaitableEvent* event) {
+            session->AddMemoryUsageOnCurrentThread(usage);
+            event->Signal();
+          },
+          base::Unretained(this), base::Unretained(&usage),
+          base::Unretained(&done)));
+  done.Wait();
+  return usage;
+}
+
+void QuicTransportOwtServerSession::AddMemoryUsageOnCurrentThread(
+    owt::quic::MemoryUsage* usage) {
+  DCHECK(task_runner_->BelongsToCurrentThread());
+  owt::quic::MemoryUsage session_usage = {};
+  session_usage.sessions = 1;
+  session_usage.object_bytes = sizeof(*this) + sizeof(QuicConnection);
+  PerformActionOnActiveStreams([&session_usage](QuicStream* stream) {
+    static_cast<QuicTransportOwtStreamImpl*>(stream)->AddMemoryUsage(
+        &session_usage);
+    return true;
+  });
+  for (const auto& datagram : received_datagrams_) {
+    session_usage.datagram_buffer_bytes += datagram.capacity();
+  }
+  // Datagrams are sent with SendMessage(), which drops them instead of
+  // queueing, so `queued_datagrams` is always 0.
+  session_usage.total_bytes = session_usage.stream_send_buffer_bytes +
+                              session_usage.stream_receive_buffer_bytes +
+                              session_usage.datagram_buffer_bytes +
+                              session_usage.object_bytes;
+  owt::quic::ServerStatsCounters::Accumulate(session_usage, usage);
+}
+
+void QuicTransportOwtServerSession::SendDatagramsOnCurrentThread(
+    std::vector<quiche::QuicheMemSlice> datagrams) {
+  // Datagrams of a batch are coalesced into as few packets as possible.
+  QuicConnection::ScopedPacketFlusher flusher(connection());
+  for (auto& datagram : datagrams) {
+    MessageResult result = SendMessage(absl::MakeSpan(&datagram, 1));
+    if (result.status != MESSAGE_STATUS_SUCCESS) {
+      QUIC_DVLOG(1) << "Datagram dropped: "
+                    << MessageStatusToString(result.status);
+    }
+  }
+}
+
+void QuicTransportOwtServerSession::SetMaxSendRateOnCurrentThread(
+    uint64_t bits_per_second) {
+  // A zero max pacing rate means no cap.
+  connection()->SetMaxPacingRate(
+      QuicBandwidth::FromBitsPerSecond(static_cast<int64_t>(bits_per_second)));
+}
+
+void QuicTransportOwtServerSession::OnMessageReceived(
+    absl::string_view message) {
+  if (received_datagrams_.empty()) {
+    // Runs after packets currently being read are processed.
+    task_runner_->PostTask(
+        FROM_HERE,
+        base::BindOnce(&QuicTransportOwtServerSession::FlushReceivedDatagrams,
+                       weak_factory_.GetWeakPtr()));
+  }
+  received_datagrams_.emplace_back(message);
+}
+
+void QuicTransportOwtServerSession::FlushReceivedDatagrams() {
+  std::vector<std::string> datagrams;
+  datagrams.swap(received_datagrams_);
+  if (!visitor_ || datagrams.empty()) {
+    return;
+  }
+  auto deliver = [](owt::quic::QuicTransportSessionInterface::Visitor* visitor,
+                    std::vector<std::string> datagrams) {
+    std::vector<owt::quic::Datagram> batch =
+        owt::quic::Utilities::DatagramsFromBuffers(datagrams);
+    visitor->OnDatagramsReceived(batch.data(), batch.size());
+  };
+  if (event_runner_->BelongsToCurrentThread()) {
+    deliver(visitor_, std::move(datagrams));
+    return;
+  }
+  event_runner_->PostTask(FROM_HERE,
+                          base::BindOnce(deliver, base::Unretained(visitor_),
+                                         std::move(datagrams)));
+}
+
 uint8_t QuicTransportOwtServerSession::length() {
-  return connection()->connection_id().length();
+  return connection_id_.size();
 }
 
 owt::quic::QuicTransportStreamInterface* QuicTransportOwtServerSession::CreateBidirectionalStream() {
@@ -135,6 +310,13 @@ owt::quic::QuicTransportStreamInterface* QuicTransportOwtServerSession::CreateBi
   return stream;
 }
 
+owt::quic::QuicTransportStreamInterface* QuicTransportOwtServerSession::CreateUnidirectionalStream() {
+  if (!connection()->connected()) {
+    return nullptr;
+  }
+  return CreateOutgoingUnidirectionalStream();
+}
+
 void QuicTransportOwtServerSession::CloseConnectionWithDetails(QuicErrorCode error,
                                                  const std::string& details) {
   connection()->CloseConnection(
@@ -203,42 +385,64 @@ QuicTransportOwtStreamImpl* QuicTransportOwtServerSession::CreateIncomingStreamO
   }
 
   QuicTransportOwtStreamImpl* stream = new QuicTransportOwtStreamImpl(
-      id, this, BIDIRECTIONAL, task_runner_, event_runner_);
+      id, this, IncomingStreamType(id), task_runner_, event_runner_);
   ActivateStream(absl::WrapUnique(stream));
-  if (visitor_) {
-    visitor_->OnIncomingStream(stream);
-  }
+  NotifyIncomingStream(stream);
   return stream;
 }
 
+StreamType QuicTransportOwtServerSession::IncomingStreamType(
+    QuicStreamId id) const {
+  return QuicUtils::GetStreamType(id, perspective(), /*peer_initiated=*/true,
+                                  version());
+}
 
-QuicTransportOwtStreamImpl* QuicTransportOwtServerSession::CreateIncomingStream(QuicStreamId id) {
-  QuicTransportOwtStreamImpl* result(nullptr);
-  base::WaitableEvent done(base::WaitableEvent::ResetPolicy::AUTOMATIC,
-                           base::WaitableEvent::InitialState::NOT_SIGNALED);
+void QuicTransportOwtServerSession::NotifyIncomingStream(
+    QuicTransportOwtStreamImpl* stream) {
+  if (!visitor_) {
+    return;
+  }
+  if (event_runner_->BelongsToCurrentThread()) {
+    visitor_->OnIncomingStream(stream);
+    return;
+  }
+  // Data received before the application sets a stream visitor is kept by the
+  // stream's sequencer, so packet processing doesn't wait for the visitor.
+  // The stream could be released before the task runs, so it's looked up by
+  // ID.
+  live_streams_->Add(stream->id(), stream);
   event_runner_->PostTask(
       FROM_HERE,
       base::BindOnce(
-          [](QuicTransportOwtServerSession* session,
-             QuicStreamId& id,
-             QuicTransportOwtStreamImpl** result, base::WaitableEvent* event) {
-            *result = session->CreateIncomingStreamOnCurrentThread(id);
-            event->Signal();
+          [](owt::quic::QuicTransportSessionInterface::Visitor* visitor,
+             scoped_refptr<owt::quic::LiveStreamRegistry> live_streams,
+             QuicStreamId id) {
+            live_streams->RunIfAlive(
+                id,
+                base::BindOnce(
+                    [](owt::quic::QuicTransportSessionInterface::Visitor*
+                           visitor,
+                       QuicTransportOwtStreamImpl* stream) {
+                      visitor->OnIncomingStream(stream);
+                    },
+                    visitor));
           },
-          base::Unretained(this), std::ref(id), base::Unretained(&result),
-          base::Unretained(&done)));
-  done.Wait();
-  return result;
+          base::Unretained(visitor_), live_streams_, stream->id()));
+}
+
+
+QuicTransportOwtStreamImpl* QuicTransportOwtServerSession::CreateIncomingStream(QuicStreamId id) {
+  // Called on the IO thread. The visitor is notified asynchronously.
+  return CreateIncomingStreamOnCurrentThread(id);
 }
 
 QuicTransportOwtStreamImpl* QuicTransportOwtServerSession::CreateIncomingStream(
     PendingStream* pending) {
   QuicTransportOwtStreamImpl* stream = new QuicTransportOwtStreamImpl(
-      pending, this, BIDIRECTIONAL, task_runner_, event_runner_);
+      pending, this, IncomingStreamType(pending->id()), task_runner_,
+      event_runner_);
   ActivateStream(absl::WrapUnique(stream));
-  if (visitor_) {
-    visitor_->OnIncomingStream(stream);
-  }
+  NotifyIncomingStream(stream);
   return stream;
 }
 
@@ -252,11 +456,15 @@ QuicTransportOwtStreamImpl* QuicTransportOwtServerSession::CreateIncomingStream(
 
 owt::quic::QuicTransportStreamInterface*
 QuicTransportOwtServerSession::CreateOutgoingBidirectionalStream() {
-  
+  if (task_runner_->BelongsToCurrentThread()) {
+    return CreateBidirectionalStreamOnCurrentThread();
+  }
+  // Streams are created on the IO thread, which owns the session. It doesn't
+  // depend on the event thread, which may be running a slow visitor.
   owt::quic::QuicTransportStreamInterface* result(nullptr);
   base::WaitableEvent done(base::WaitableEvent::ResetPolicy::AUTOMATIC,
                            base::WaitableEvent::InitialState::NOT_SIGNALED);
-  event_runner_->PostTask(
+  task_runner_->PostTask(
       FROM_HERE,
       base::BindOnce(
           [](QuicTransportOwtServerSession* session,
@@ -288,6 +496,28 @@ QuicTransportOwtServerSession::CreateBidirectionalStreamOnCurrentThread() {
 
 owt::quic::QuicTransportStreamInterface*
 QuicTransportOwtServerSession::CreateOutgoingUnidirectionalStream() {
+  if (task_runner_->BelongsToCurrentThread()) {
+    return CreateUnidirectionalStreamOnCurrentThread();
+  }
+  owt::quic::QuicTransportStreamInterface* result(nullptr);
+  base::WaitableEvent done(base::WaitableEvent::ResetPolicy::AUTOMATIC,
+                           base::WaitableEvent::InitialState::NOT_SIGNALED);
+  task_runner_->PostTask(
+      FROM_HERE,
+      base::BindOnce(
+          [](QuicTransportOwtServerSession* session,
+             owt::quic::QuicTransportStreamInterface** result, base::WaitableEvent* event) {
+            *result = session->CreateUnidirectionalStreamOnCurrentThread();
+            event->Signal();
+          },
+          base::Unretained(this), base::Unretained(&result),
+          base::Unretained(&done)));
+  done.Wait();
+  return result;
+}
+
+owt::quic::QuicTransportStreamInterface*
+QuicTransportOwtServerSession::CreateUnidirectionalStreamOnCurrentThread() {
   if (!ShouldCreateOutgoingUnidirectionalStream()) {
     return nullptr;
   }
@@ -8,14 +8,20 @@
 #include <cstddef>
 #include <memory>
 #include <string>
+#include <vector>
 
+#include "net/third_party/quiche/src/quiche/common/quiche_mem_slice.h"
 #include "net/third_party/quiche/src/quiche/quic/core/quic_session.h"
 #include "net/third_party/quiche/src/quiche/quic/core/quic_versions.h"
 #include "net/third_party/quiche/src/quiche/quic/platform/api/quic_export.h"
 #include "net/third_party/quiche/src/quiche/quic/core/quic_crypto_server_stream.h"
 
 #include "owt/quic/quic_transport_session_interface.h"
+#include "owt/quic_transport/sdk/impl/live_stream_registry.h"
+#include "owt/quic_transport/sdk/impl/qlog_writer.h"
 #include "owt/quic_transport/sdk/impl/quic_transport_owt_stream_impl.h"
+#include "owt/quic_transport/sdk/impl/server_stats_counters.h"
+#include "base/memory/weak_ptr.h"
 #include "base/task/single_thread_task_runner.h"
 
 namespace quic {
@@ -42,6 +48,13 @@ class QUIC_EXPORT_PRIVATE QuicTransportOwtServerSession
 
   void Initialize() override;
 
+  // Sets `logger` as the debug visitor of the connection. It could be nullptr.
+  void SetConnectionLogger(
+      std::unique_ptr<owt::quic::QlogConnectionLogger> logger);
+  // Peer migrations are counted by `counters`. It could be nullptr, and it
+  // must outlive this session.
+  void SetStatsCounters(owt::quic::ServerStatsCounters* counters);
+
   const QuicCryptoServerStreamBase* crypto_stream() const {
     return crypto_stream_.get();
   }
@@ -51,11 +64,18 @@ class QUIC_EXPORT_PRIVATE QuicTransportOwtServerSession
 
   // Implement QuicTransportSessionInterface
   owt::quic::QuicTransportStreamInterface* CreateBidirectionalStream() override;
+  owt::quic::QuicTransportStreamInterface* CreateUnidirectionalStream() override;
   void Stop() override;
   void SetVisitor(owt::quic::QuicTransportSessionInterface::Visitor* visitor) override;
   const char* Id() override;
   uint8_t length() override;
   void CloseStream(uint32_t id) override;
+  void SendDatagrams(const owt::quic::Datagram* batch, size_t count) override;
+  void SetMaxSendRate(uint64_t bits_per_second) override;
+  owt::quic::MemoryUsage GetMemoryUsage() override;
+
+  // Adds memory held by this session and its streams to `usage`.
+  void AddMemoryUsageOnCurrentThread(owt::quic::MemoryUsage* usage);
 
  protected:
   // QuicSession methods(override them with return type of QuicSpdyStream*):
@@ -66,6 +86,8 @@ class QUIC_EXPORT_PRIVATE QuicTransportOwtServerSession
   void OnConnectionClosed(const QuicConnectionCloseFrame& frame,
                           ConnectionCloseSource source) override;
 
+  void OnConnectionMigration(AddressChangeType type) override;
+
   // Override CreateIncomingStream(), CreateOutgoingBidirectionalStream() and
   // CreateOutgoingUnidirectionalStream() with QuicSpdyStream return type to
   // make sure that all data streams are QuicSpdyStreams.
@@ -93,6 +115,8 @@ class QUIC_EXPORT_PRIVATE QuicTransportOwtServerSession
   //Notify stream closed
   void OnStreamClosed(quic::QuicStreamId stream_id) override;
 
+  void OnMessageReceived(absl::string_view message) override;
+
   bool IsConnected() { return connection()->connected(); }
 
   virtual std::unique_ptr<QuicCryptoServerStreamBase> CreateQuicCryptoServerStream(
@@ -113,12 +137,30 @@ class QUIC_EXPORT_PRIVATE QuicTransportOwtServerSession
 
   QuicTransportOwtStreamImpl* CreateIncomingStreamOnCurrentThread(QuicStreamId id);
 
+  // Notifies `visitor_` of an incoming stream on the event thread.
+  void NotifyIncomingStream(QuicTransportOwtStreamImpl* stream);
+
   owt::quic::QuicTransportStreamInterface* CreateBidirectionalStreamOnCurrentThread();
+  owt::quic::QuicTransportStreamInterface* CreateUnidirectionalStreamOnCurrentThread();
+
+  // Returns the type of a stream created by the peer.
+  StreamType IncomingStreamType(QuicStreamId id) const;
 
   void StopOnCurrentThread();
 
   void CloseStreamOnCurrentThread(uint32_t id);
 
+  void SendDatagramsOnCurrentThread(
+      std::vector<quiche::QuicheMemSlice> datagrams);
+
+  void SetMaxSendRateOnCurrentThread(uint64_t bits_per_second);
+
+  // Delivers datagrams received in the last round of packet processing to
+  // `visitor_`.
+  void FlushReceivedDatagrams();
+
+  std::unique_ptr<owt::quic::QlogConnectionLogger> connection_logger_;
+  owt::quic::ServerStatsCounters* stats_counters_;
   const QuicCryptoServerConfig* crypto_config_;
 
   // The cache which contains most recently compressed certs.
@@ -134,6 +176,16 @@ class QUIC_EXPORT_PRIVATE QuicTransportOwtServerSession
   base::SingleThreadTaskRunner* task_runner_;
   base::SingleThreadTaskRunner* event_runner_;
   owt::quic::QuicTransportSessionInterface::Visitor* visitor_;
+  // String representation of connection ID. It's computed once, so Id()
+  // doesn't allocate.
+  const std::string connection_id_;
+  // Datagrams received since the last FlushReceivedDatagrams().
+  std::vector<std::string> received_datagrams_;
+  // Incoming streams not closed yet, looked up by notifications posted to the
+  // event thread.
+  scoped_refptr<owt::quic::LiveStreamRegistry> live_streams_;
+
+  base::WeakPtrFactory<QuicTransportOwtServerSession> weak_factory_{this};
 };
 
 }  // namespace quic
@@ -11,6 +11,13 @@
 
 namespace quic {
 
+namespace {
+// Max number of regions delivered to the visitor in a single call.
+constexpr int kMaxReadableRegions = 16;
+// Max size of a message received in message mode.
+constexpr uint64_t kMaxMessageSize = 16 * 1024 * 1024;
+}  // namespace
+
 QuicTransportOwtStreamImpl::QuicTransportOwtStreamImpl(
     QuicStreamId id,
     QuicSession* session,
@@ -20,7 +27,8 @@ QuicTransportOwtStreamImpl::QuicTransportOwtStreamImpl(
     : QuicStream(id, session, /*is_static=*/false, type),
       task_runner_(io_runner),
       //event_runner_(event_runner),
-      visitor_(nullptr) {
+      visitor_(nullptr),
+      receive_window_tuner_(nullptr) {
 
 }
 
@@ -33,7 +41,8 @@ QuicTransportOwtStreamImpl::QuicTransportOwtStreamImpl(
     : QuicStream(pending, session, /* is_static= */ false),
       task_runner_(io_runner),
       //event_runner_(event_runner),
-      visitor_(nullptr) {}
+      visitor_(nullptr),
+      receive_window_tuner_(nullptr) {}
 
 QuicTransportOwtStreamImpl::~QuicTransportOwtStreamImpl() {}
 
@@ -42,25 +51,95 @@ uint32_t QuicTransportOwtStreamImpl::Id() const {
 }
 
 void QuicTransportOwtStreamImpl::SetVisitor(owt::quic::QuicTransportStreamInterface::Visitor* visitor) {
-  visitor_ = visitor; 
+  if (task_runner_->BelongsToCurrentThread()) {
+    return SetVisitorOnCurrentThread(visitor);
+  }
+  task_runner_->PostTask(
+      FROM_HERE,
+      base::BindOnce(&QuicTransportOwtStreamImpl::SetVisitorOnCurrentThread,
+                     weak_factory_.GetWeakPtr(), visitor));
+}
+
+void QuicTransportOwtStreamImpl::SetVisitorOnCurrentThread(
+    owt::quic::QuicTransportStreamInterface::Visitor* visitor) {
+  visitor_ = visitor;
+  // Deliver data received before the visitor is set.
+  if (visitor_ && !read_side_closed()) {
+    processData();
+  }
 }
 
 void QuicTransportOwtStreamImpl::CloseOnCurrentThread() {
-  // TODO: Post to IO runner.
-  WriteOrBufferData(absl::string_view("", 1), true, nullptr);
+  // Incoming unidirectional streams cannot be written.
+  if (write_side_closed()) {
+    return;
+  }
+  WriteOrBufferData(absl::string_view(), true, nullptr);
 }
 
 void QuicTransportOwtStreamImpl::Close() {
   task_runner_->PostTask(
       FROM_HERE,
-      base::BindOnce(&QuicTransportOwtStreamImpl::CloseOnCurrentThread, base::Unretained(this)));
+      base::BindOnce(&QuicTransportOwtStreamImpl::CloseOnCurrentThread, weak_factory_.GetWeakPtr()));
+}
+
+void QuicTransportOwtStreamImpl::AddMemoryUsage(
+    owt::quic::MemoryUsage* usage) const {
+  DCHECK(task_runner_->BelongsToCurrentThread());
+  usage->streams++;
+  usage->object_bytes += sizeof(*this);
+  usage->stream_send_buffer_bytes += BufferedDataBytes();
+  usage->stream_receive_buffer_bytes += sequencer()->ReadableBytes();
 }
 
 void QuicTransportOwtStreamImpl::SendData(char* data, size_t len) {
   std::string s_data(data, len);
   task_runner_->PostTask(FROM_HERE,
           base::BindOnce(&QuicTransportOwtStreamImpl::SendDataOnCurrentThread,
-              base::Unretained(this), s_data));
+              weak_factory_.GetWeakPtr(), std::move(s_data)));
+}
+
+void QuicTransportOwtStreamImpl::SendData(
+    uint8_t* data,
+    size_t len,
+    owt::quic::BufferReleaseCallback release,
+    void* release_context) {
+  // `data` is released when QUIC no longer needs it, i.e. after it's acked.
+  quiche::QuicheMemSlice slice(
+      reinterpret_cast<const char*>(data), len,
+      [data, len, release, release_context](const char* /*buffer*/) {
+        if (release) {
+          release(data, len, release_context);
+        }
+      });
+  task_runner_->PostTask(FROM_HERE,
+          base::BindOnce(&QuicTransportOwtStreamImpl::SendMemSliceOnCurrentThread,
+              weak_factory_.GetWeakPtr(), std::move(slice)));
+}
+
+void QuicTransportOwtStreamImpl::EnableMessageMode() {
+  if (task_runner_->BelongsToCurrentThread()) {
+    return EnableMessageModeOnCurrentThread();
+  }
+  task_runner_->PostTask(
+      FROM_HERE,
+      base::BindOnce(&QuicTransportOwtStreamImpl::EnableMessageModeOnCurrentThread,
+                     weak_factory_.GetWeakPtr()));
+}
+
+void QuicTransportOwtStreamImpl::EnableMessageModeOnCurrentThread() {
+  if (!message_framer_) {
+    message_framer_ =
+        std::make_unique<owt::quic::MessageFramer>(kMaxMessageSize);
+  }
+}
+
+void QuicTransportOwtStreamImpl::SendMessage(const uint8_t* data, size_t len) {
+  std::string message = owt::quic::MessageFramer::Frame(
+      absl::string_view(reinterpret_cast<const char*>(data), len));
+  task_runner_->PostTask(FROM_HERE,
+          base::BindOnce(&QuicTransportOwtStreamImpl::SendDataOnCurrentThread,
+              weak_factory_.GetWeakPtr(), std::move(message)));
 }
 
 void QuicTransportOwtStreamImpl::SendDataOnCurrentThread(const std::string& data) {
@@ -69,17 +148,74 @@ void QuicTransportOwtStreamImpl::SendDataOnCurrentThread(const std::string& data
   }
 }
 
+void QuicTransportOwtStreamImpl::SendMemSliceOnCurrentThread(
+    quiche::QuicheMemSlice slice) {
+  if (!write_side_closed()) {
+    // Buffered like WriteOrBufferData, even if the send buffer is full.
+    WriteMemSlices(absl::MakeSpan(&slice, 1), false,
+                   /*buffer_unconditionally=*/true);
+  }
+}
+
+void QuicTransportOwtStreamImpl::MarkConsumed(size_t bytes) {
+  sequencer()->MarkConsumed(bytes);
+  if (receive_window_tuner_) {
+    receive_window_tuner_->OnBytesConsumed(this, bytes);
+  }
+}
+
+bool QuicTransportOwtStreamImpl::processMessages(const struct iovec* regions,
+                                                 int count) {
+  size_t consumed = 0;
+  auto on_message = [this](absl::string_view message) {
+    visitor()->OnMessage(this, reinterpret_cast<const uint8_t*>(message.data()),
+                         message.size());
+  };
+  for (int i = 0; i < count; i++) {
+    if (!message_framer_->Process(
+            absl::string_view(static_cast<const char*>(regions[i].iov_base),
+                              regions[i].iov_len),
+            on_message)) {
+      LOG(ERROR) << "Message on stream " << id() << " is too large.";
+      Reset(QUIC_BAD_APPLICATION_PAYLOAD);
+      return false;
+    }
+    consumed += regions[i].iov_len;
+  }
+  // Regions are consumed after messages in them are delivered.
+  MarkConsumed(consumed);
+  return true;
+}
+
 void QuicTransportOwtStreamImpl::processData() {
+  // Keep data in the sequencer until there is a visitor to receive it.
+  if (!visitor()) {
+    return;
+  }
   while (sequencer()->HasBytesToRead()) {
-    struct iovec iov;
-    if (sequencer()->GetReadableRegions(&iov, 1) == 0) {
+    struct iovec iov[kMaxReadableRegions];
+    const int count =
+        sequencer()->GetReadableRegions(iov, kMaxReadableRegions);
+    if (count == 0) {
       // No more data to read.
       break;
     }
-    if (visitor()) {
-      visitor()->OnData(this, static_cast<char*>(iov.iov_base), iov.iov_len);
+    if (message_framer_) {
+      if (!processMessages(iov, count)) {
+        return;
+      }
+      continue;
     }
-    sequencer()->MarkConsumed(iov.iov_len);
+    owt::quic::QuicTransportStreamInterface::DataRegion
+        regions[kMaxReadableRegions];
+    size_t consumed = 0;
+    for (int i = 0; i < count; i++) {
+      regions[i].data = static_cast<char*>(iov[i].iov_base);
+      regions[i].len = iov[i].iov_len;
+      consumed += iov[i].iov_len;
+    }
+    visitor()->OnDataRegions(this, regions, count);
+    MarkConsumed(consumed);
   }
 
   if (!sequencer()->IsClosed()) {
@@ -88,7 +224,8 @@ void QuicTransportOwtStreamImpl::processData() {
   }
 
   // If the sequencer is closed, then all the body, including the fin, has been
-  // consumed.
+  // consumed. OnFinRead may close the stream, so the visitor is notified first.
+  visitor()->OnFinReceived(this);
   OnFinRead();
 
   if (write_side_closed() || fin_buffered()) {
@@ -96,10 +233,25 @@ void QuicTransportOwtStreamImpl::processData() {
   }
 }
 
+void QuicTransportOwtStreamImpl::OnStreamReset(
+    const QuicRstStreamFrame& frame) {
+  if (visitor_) {
+    visitor_->OnReset(this, frame.ietf_error_code);
+  }
+  QuicStream::OnStreamReset(frame);
+}
+
+void QuicTransportOwtStreamImpl::NotifyClosed() {
+  owt::quic::QuicTransportStreamInterface::Visitor* visitor = visitor_;
+  visitor_ = nullptr;
+  if (visitor) {
+    visitor->OnClosed(this);
+  }
+}
+
 void QuicTransportOwtStreamImpl::OnDataAvailable() {
-  task_runner_->PostTask(
-      FROM_HERE,
-      base::BindOnce(&QuicTransportOwtStreamImpl::processData, base::Unretained(this)));
+  // Called on the IO thread, where the visitor is also called.
+  processData();
 }
 
 }  // namespace quic
@@ -5,16 +5,26 @@
 #ifndef QUIC_TRANSPORT_OWT_STREAM_IMPL_H_
 #define QUIC_TRANSPORT_OWT_STREAM_IMPL_H_
 
+#include <memory>
+#include <string>
+
 #include "absl/base/macros.h"
 #include "net/third_party/quiche/src/quiche/quic/core/quic_stream.h"
 #include "net/third_party/quiche/src/quiche/quic/core/quic_session.h"
+#include "net/third_party/quiche/src/quiche/common/quiche_mem_slice.h"
 #include "owt/quic/quic_transport_stream_interface.h"
+#include "owt/quic_transport/sdk/impl/message_framer.h"
+#include "owt/quic_transport/sdk/impl/object_pool.h"
+#include "owt/quic_transport/sdk/impl/receive_window_tuner.h"
+#include "base/memory/weak_ptr.h"
 #include "base/task/single_thread_task_runner.h"
 
 namespace quic {
 
+// Streams are created at high rates, so they are pooled.
 class QUIC_EXPORT_PRIVATE QuicTransportOwtStreamImpl : public QuicStream,
-                                                       public owt::quic::QuicTransportStreamInterface {
+                                                       public owt::quic::QuicTransportStreamInterface,
+                                                       public owt::quic::PooledObject {
  public:
 
   QuicTransportOwtStreamImpl(QuicStreamId id,
@@ -34,27 +44,61 @@ class QUIC_EXPORT_PRIVATE QuicTransportOwtStreamImpl : public QuicStream,
   // QuicStream implementation called by the sequencer when there is
   // data (or a FIN) to be read.
   void OnDataAvailable() override;
+  void OnStreamReset(const QuicRstStreamFrame& frame) override;
+
+  // Called by the session when both directions are closed, before the stream
+  // is released. No visitor method is called after it.
+  void NotifyClosed();
 
   uint32_t Id() const override;
 
   void SetVisitor(owt::quic::QuicTransportStreamInterface::Visitor* visitor) override;
   void SendData(char* data, size_t len) override;
+  void SendData(uint8_t* data,
+                size_t len,
+                owt::quic::BufferReleaseCallback release,
+                void* release_context) override;
+  void EnableMessageMode() override;
+  void SendMessage(const uint8_t* data, size_t len) override;
 
   // Returns true if the sequencer has delivered the FIN, and no more body bytes
   // will be available.
   bool IsClosed() { return sequencer()->IsClosed(); }
   void Close() override;
 
+  // Adds memory held by this stream to `usage`. Called on IO thread.
+  void AddMemoryUsage(owt::quic::MemoryUsage* usage) const;
+
+  // Reports data consumed from this stream to `tuner`, which could be
+  // nullptr, and it must outlive this stream.
+  void set_receive_window_tuner(owt::quic::ReceiveWindowTuner* tuner) {
+    receive_window_tuner_ = tuner;
+  }
+
  protected:
   owt::quic::QuicTransportStreamInterface::Visitor* visitor() { return visitor_; }
 
  private:
+  void SetVisitorOnCurrentThread(
+      owt::quic::QuicTransportStreamInterface::Visitor* visitor);
   void SendDataOnCurrentThread(const std::string& data);
+  void SendMemSliceOnCurrentThread(quiche::QuicheMemSlice slice);
   void CloseOnCurrentThread();
+  void EnableMessageModeOnCurrentThread();
+  // Delivers `regions` as messages. Returns false if the stream is reset.
+  bool processMessages(const struct iovec* regions, int count);
   void processData();
+  // Marks `bytes` of the sequencer consumed.
+  void MarkConsumed(size_t bytes);
   base::SingleThreadTaskRunner* task_runner_;
   //base::SingleThreadTaskRunner* event_runner_;
   owt::quic::QuicTransportStreamInterface::Visitor* visitor_;
+  // Not null in message mode.
+  std::unique_ptr<owt::quic::MessageFramer> message_framer_;
+  owt::quic::ReceiveWindowTuner* receive_window_tuner_;
+
+  // Tasks posted by the application don't run after the stream is released.
+  base::WeakPtrFactory<QuicTransportOwtStreamImpl> weak_factory_{this};
 };
 
 }  // namespace quic
@@ -0,0 +1,104 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "owt/quic_transport/sdk/impl/receive_window_tuner.h"
+
+#include <limits>
+
+#include "net/third_party/quiche/src/quiche/quic/core/congestion_control/rtt_stats.h"
+#include "net/third_party/quiche/src/quiche/quic/core/quic_connection.h"
+#include "net/third_party/quiche/src/quiche/quic/core/quic_flow_controller.h"
+
+namespace owt {
+namespace quic {
+
+ReceiveWindowTuner::ReceiveWindowTuner(::quic::QuicSession* session)
+    : session_(session), max_stream_window_(0), max_session_window_(0) {
+  DCHECK(session_);
+}
+
+ReceiveWindowTuner::~ReceiveWindowTuner() = default;
+
+void ReceiveWindowTuner::SetMaxWindows(
+    ::quic::QuicByteCount max_stream_window,
+    ::quic::QuicByteCount max_session_window) {
+  max_stream_window_ = max_stream_window;
+  max_session_window_ = max_session_window;
+}
+
+void ReceiveWindowTuner::OnBytesConsumed(::quic::QuicStream* stream,
+                                         ::quic::QuicByteCount bytes) {
+  if (bytes == 0) {
+    return;
+  }
+  if (max_stream_window_ > 0) {
+    Tune(stream->flow_controller(), &stream_periods_[stream->id()], bytes,
+         max_stream_window_);
+  }
+  if (max_session_window_ > 0) {
+    Tune(session_->flow_controller(), &session_period_, bytes,
+         max_session_window_);
+  }
+}
+
+void ReceiveWindowTuner::OnStreamClosed(::quic::QuicStreamId id) {
+  stream_periods_.erase(id);
+}
+
+// static
+bool ReceiveWindowTuner::ShouldGrow(::quic::QuicByteCount window,
+                                    ::quic::QuicByteCount consumed,
+                                    ::quic::QuicTime::Delta elapsed,
+                                    ::quic::QuicTime::Delta rtt,
+                                    ::quic::QuicByteCount max_window) {
+  if (window == 0 || window > max_window / 2 || rtt.IsZero() ||
+      elapsed < rtt) {
+    return false;
+  }
+  // Bytes consumed per RTT. A reader falling behind leaves data in the
+  // sequencer, so it consumes less than what the window allows.
+  const double consumed_per_rtt = static_cast<double>(consumed) *
+                                  rtt.ToMicroseconds() /
+                                  elapsed.ToMicroseconds();
+  return consumed_per_rtt * 2 >= window;
+}
+
+void ReceiveWindowTuner::Tune(::quic::QuicFlowController* flow_controller,
+                              Period* period,
+                              ::quic::QuicByteCount bytes,
+                              ::quic::QuicByteCount max_window) {
+  if (!flow_controller || flow_controller->auto_tune_receive_window()) {
+    // QUIC tunes it.
+    return;
+  }
+  ::quic::QuicConnection* connection = session_->connection();
+  const ::quic::QuicTime now = connection->clock()->ApproximateNow();
+  if (!period->start.IsInitialized()) {
+    period->start = now;
+  }
+  period->consumed += bytes;
+  const ::quic::QuicTime::Delta rtt =
+      connection->sent_packet_manager().GetRttStats()->smoothed_rtt();
+  const ::quic::QuicTime::Delta elapsed = now - period->start;
+  if (rtt.IsZero() || elapsed < rtt) {
+    return;
+  }
+  const ::quic::QuicByteCount window = flow_controller->receive_window_size();
+  const bool grow =
+      ShouldGrow(window, period->consumed, elapsed, rtt, max_window);
+  period->start = now;
+  period->consumed = 0;
+  if (grow) {
+    // EnsureWindowAtLeast() returns early unless it's asked for more than the
+    // flow controller's limit, so it's asked for the most. It then doubles the
+    // window up to that limit and sends a WINDOW_UPDATE with the new offset.
+    flow_controller->EnsureWindowAtLeast(
+        std::numeric_limits<::quic::QuicByteCount>::max());
+  }
+}
+
+}  // namespace quic
+}  // namespace owt
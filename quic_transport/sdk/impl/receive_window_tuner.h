@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef QUIC_TRANSPORT_RECEIVE_WINDOW_TUNER_H_
+#define QUIC_TRANSPORT_RECEIVE_WINDOW_TUNER_H_
+
+#include <cstdint>
+
+#include "absl/container/flat_hash_map.h"
+#include "net/third_party/quiche/src/quiche/quic/core/quic_session.h"
+#include "net/third_party/quiche/src/quiche/quic/core/quic_stream.h"
+#include "net/third_party/quiche/src/quiche/quic/core/quic_time.h"
+
+namespace owt {
+namespace quic {
+
+// Grows receive windows of a QUIC session which QUIC doesn't auto-tune, which
+// are windows of clients. Consumption of each stream, and of the session, is
+// measured over periods of at least one smoothed RTT. A window is doubled if
+// its reader consumed half of it or more in a period: the reader keeps up, and
+// RTT * rate reaches the window, so the window rather than the path bounds
+// throughput. Windows never grow beyond their caps, nor beyond QUIC's limits
+// of 16 MB per stream and 24 MB per session. Must be used on the session's
+// thread while the session is alive.
+class ReceiveWindowTuner {
+ public:
+  explicit ReceiveWindowTuner(::quic::QuicSession* session);
+  ~ReceiveWindowTuner();
+  ReceiveWindowTuner(const ReceiveWindowTuner&) = delete;
+  ReceiveWindowTuner& operator=(const ReceiveWindowTuner&) = delete;
+
+  // Zero caps disable tuning of that kind of windows, which is the default.
+  void SetMaxWindows(::quic::QuicByteCount max_stream_window,
+                     ::quic::QuicByteCount max_session_window);
+  // Called after the reader of `stream` consumes `bytes`.
+  void OnBytesConsumed(::quic::QuicStream* stream, ::quic::QuicByteCount bytes);
+  void OnStreamClosed(::quic::QuicStreamId id);
+
+  // Returns true if `window` should be doubled after `consumed` bytes are
+  // consumed in one period of `elapsed`, which is at least `rtt`.
+  static bool ShouldGrow(::quic::QuicByteCount window,
+                         ::quic::QuicByteCount consumed,
+                         ::quic::QuicTime::Delta elapsed,
+                         ::quic::QuicTime::Delta rtt,
+                         ::quic::QuicByteCount max_window);
+
+ private:
+  struct Period {
+    ::quic::QuicTime start = ::quic::QuicTime::Zero();
+    ::quic::QuicByteCount consumed = 0;
+  };
+
+  void Tune(::quic::QuicFlowController* flow_controller,
+            Period* period,
+            ::quic::QuicByteCount bytes,
+            ::quic::QuicByteCount max_window);
+
+  ::quic::QuicSession* session_;
+  ::quic::QuicByteCount max_stream_window_;
+  ::quic::QuicByteCount max_session_window_;
+  absl::flat_hash_map<::quic::QuicStreamId, Period> stream_periods_;
+  Period session_period_;
+};
+
+}  // namespace quic
+}  // namespace owt
+
+#endif  // QUIC_TRANSPORT_RECEIVE_WINDOW_TUNER_H_
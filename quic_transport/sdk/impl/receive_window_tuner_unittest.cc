@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "owt/quic_transport/sdk/impl/receive_window_tuner.h"
+
+#include <memory>
+
+#include "net/third_party/quiche/src/quiche/quic/core/congestion_control/rtt_stats.h"
+#include "net/third_party/quiche/src/quiche/quic/core/quic_flow_controller.h"
+#include "net/third_party/quiche/src/quiche/quic/test_tools/quic_test_utils.h"
+#include "testing/gmock/include/gmock/gmock.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace owt {
+namespace quic {
+namespace test {
+
+namespace {
+const ::quic::QuicTime::Delta kRtt =
+    ::quic::QuicTime::Delta::FromMilliseconds(50);
+}  // namespace
+
+// Tunes the window of a client session's real flow controller. Stream windows
+// aren't tuned, so bytes are consumed without a stream.
+class ReceiveWindowTunerTest : public testing::Test {
+ protected:
+  ReceiveWindowTunerTest()
+      : connection_(new testing::NiceMock<::quic::test::MockQuicConnection>(
+            &helper_,
+            &alarm_factory_,
+            ::quic::Perspective::IS_CLIENT)),
+        session_(
+            std::make_unique<testing::NiceMock<::quic::test::MockQuicSession>>(
+                connection_)),
+        tuner_(std::make_unique<ReceiveWindowTuner>(session_.get())) {
+    // Periods start at initialized times.
+    helper_.AdvanceTime(kRtt);
+    const_cast<::quic::RttStats*>(
+        connection_->sent_packet_manager().GetRttStats())
+        ->UpdateRtt(kRtt, ::quic::QuicTime::Delta::Zero(),
+                    helper_.GetClock()->Now());
+    initial_window_ = window();
+  }
+
+  ~ReceiveWindowTunerTest() override { tuner_.reset(); }
+
+  ::quic::QuicByteCount window() {
+    return session_->flow_controller()->receive_window_size();
+  }
+
+  // Consumes `fraction` of the current window once per RTT, `rtts` times, then
+  // ends the last period. The first period also counts the bytes consumed when
+  // it starts.
+  void ConsumeForRtts(double fraction, int rtts) {
+    for (int i = 0; i < rtts; i++) {
+      tuner_->OnBytesConsumed(
+          nullptr, static_cast<::quic::QuicByteCount>(window() * fraction));
+      helper_.AdvanceTime(kRtt);
+    }
+    // Ends the last period.
+    tuner_->OnBytesConsumed(nullptr, 1);
+  }
+
+  ::quic::test::MockQuicConnectionHelper helper_;
+  ::quic::test::MockAlarmFactory alarm_factory_;
+  // Owned by `session_`.
+  ::quic::test::MockQuicConnection* connection_;
+  std::unique_ptr<::quic::test::MockQuicSession> session_;
+  std::unique_ptr<ReceiveWindowTuner> tuner_;
+  ::quic::QuicByteCount initial_window_;
+};
+
+TEST_F(ReceiveWindowTunerTest, ClientWindowIsNotAutoTunedByQuic) {
+  EXPECT_FALSE(session_->flow_controller()->auto_tune_receive_window());
+}
+
+TEST_F(ReceiveWindowTunerTest, GrowsWindowUpToCap) {
+  tuner_->SetMaxWindows(0, initial_window_ * 4);
+  ConsumeForRtts(1, 1);
+  EXPECT_EQ(window(), initial_window_ * 2);
+  ConsumeForRtts(1, 1);
+  EXPECT_EQ(window(), initial_window_ * 4);
+  ConsumeForRtts(1, 10);
+  EXPECT_EQ(window(), initial_window_ * 4);
+}
+
+TEST_F(ReceiveWindowTunerTest, KeepsWindowOfSlowReader) {
+  tuner_->SetMaxWindows(0, initial_window_ * 4);
+  ConsumeForRtts(0.2, 10);
+  EXPECT_EQ(window(), initial_window_);
+}
+
+TEST_F(ReceiveWindowTunerTest, ZeroCapKeepsWindow) {
+  ConsumeForRtts(1, 10);
+  EXPECT_EQ(window(), initial_window_);
+}
+
+}  // namespace test
+}  // namespace quic
+}  // namespace owt
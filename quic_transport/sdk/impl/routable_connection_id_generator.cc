@@ -0,0 +1,104 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "owt/quic_transport/sdk/impl/routable_connection_id_generator.h"
+
+#include <string.h>
+
+#include "base/check_op.h"
+#include "base/logging.h"
+#include "net/third_party/quiche/src/quiche/quic/core/quic_constants.h"
+#include "net/third_party/quiche/src/quiche/quic/core/quic_utils.h"
+
+namespace owt {
+namespace quic {
+
+namespace {
+const uint8_t kMaxConfigId = 6;
+const size_t kMinNonceLength = 4;
+const size_t kKeyLength = 16;
+}  // namespace
+
+// static
+std::unique_ptr<RoutableConnectionIdGenerator>
+RoutableConnectionIdGenerator::Create(const Config& config) {
+  if (config.config_id > kMaxConfigId) {
+    LOG(ERROR) << "Invalid config ID " << static_cast<int>(config.config_id);
+    return nullptr;
+  }
+  if (config.connection_id_length > ::quic::kQuicMaxConnectionIdLength ||
+      config.connection_id_length <
+          1 + config.server_id.size() + kMinNonceLength) {
+    LOG(ERROR) << "Connection ID length "
+               << static_cast<int>(config.connection_id_length)
+               << " cannot hold server ID and nonce.";
+    return nullptr;
+  }
+  if (!config.key.empty()) {
+    if (config.key.size() != kKeyLength) {
+      LOG(ERROR) << "Key must be " << kKeyLength << " bytes.";
+      return nullptr;
+    }
+    if (config.connection_id_length != 1 + AES_BLOCK_SIZE) {
+      LOG(ERROR) << "Encrypted connection IDs must be " << 1 + AES_BLOCK_SIZE
+                 << " bytes.";
+      return nullptr;
+    }
+  }
+  return std::unique_ptr<RoutableConnectionIdGenerator>(
+      new RoutableConnectionIdGenerator(config));
+}
+
+RoutableConnectionIdGenerator::RoutableConnectionIdGenerator(
+    const Config& config)
+    : config_(config) {
+  if (!config_.key.empty()) {
+    const uint8_t* key = reinterpret_cast<const uint8_t*>(config_.key.data());
+    CHECK_EQ(AES_set_encrypt_key(key, kKeyLength * 8, &encrypt_key_), 0);
+  }
+}
+
+RoutableConnectionIdGenerator::~RoutableConnectionIdGenerator() = default;
+
+absl::optional<::quic::QuicConnectionId>
+RoutableConnectionIdGenerator::GenerateNextConnectionId(
+    const ::quic::QuicConnectionId& original) {
+  return GenerateConnectionId(original);
+}
+
+absl::optional<::quic::QuicConnectionId>
+RoutableConnectionIdGenerator::MaybeReplaceConnectionId(
+    const ::quic::QuicConnectionId& original,
+    const ::quic::ParsedQuicVersion& version) {
+  return GenerateConnectionId(original);
+}
+
+::quic::QuicConnectionId RoutableConnectionIdGenerator::GenerateConnectionId(
+    const ::quic::QuicConnectionId& seed) const {
+  const size_t length = config_.connection_id_length;
+  const size_t nonce_length = length - 1 - config_.server_id.size();
+  char data[::quic::kQuicMaxConnectionIdLength];
+  data[0] = FirstOctet();
+  memcpy(data + 1, config_.server_id.data(), config_.server_id.size());
+  ::quic::QuicConnectionId nonce =
+      ::quic::QuicUtils::CreateReplacementConnectionId(seed, nonce_length);
+  DCHECK_EQ(nonce.length(), nonce_length);
+  memcpy(data + 1 + config_.server_id.size(), nonce.data(), nonce_length);
+  if (!config_.key.empty()) {
+    uint8_t* block = reinterpret_cast<uint8_t*>(data + 1);
+    AES_encrypt(block, block, &encrypt_key_);
+  }
+  return ::quic::QuicConnectionId(data, length);
+}
+
+uint8_t RoutableConnectionIdGenerator::FirstOctet() const {
+  // Low bits encode the length of the rest of connection ID, so a load
+  // balancer can parse short header packets.
+  return (config_.config_id << 5) | ((config_.connection_id_length - 1) & 0x1f);
+}
+
+}  // namespace quic
+}  // namespace owt
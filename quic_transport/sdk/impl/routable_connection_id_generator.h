@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef QUIC_TRANSPORT_ROUTABLE_CONNECTION_ID_GENERATOR_H_
+#define QUIC_TRANSPORT_ROUTABLE_CONNECTION_ID_GENERATOR_H_
+
+#include <memory>
+#include <string>
+
+#include "absl/types/optional.h"
+#include "net/third_party/quiche/src/quiche/quic/core/connection_id_generator.h"
+#include "net/third_party/quiche/src/quiche/quic/core/quic_connection_id.h"
+#include "net/third_party/quiche/src/quiche/quic/core/quic_versions.h"
+#include "third_party/boringssl/src/include/openssl/aes.h"
+
+namespace owt {
+namespace quic {
+
+// Generates server connection IDs routable by a load balancer without per-flow
+// state, in the format of draft-ietf-quic-load-balancers. A connection ID is
+// first octet || server ID || nonce. The first octet has config ID in its
+// three high bits and connection ID length minus one in its low bits. When a
+// key is configured, server ID and nonce are encrypted with AES-128-ECB, which
+// requires them to be exactly 16 bytes.
+class RoutableConnectionIdGenerator
+    : public ::quic::ConnectionIdGeneratorInterface {
+ public:
+  struct Config {
+    // 0 - 6. 7 is reserved for unroutable connection IDs.
+    uint8_t config_id = 0;
+    std::string server_id;
+    // Empty, or a 16 bytes AES-128 key.
+    std::string key;
+    // Includes the first octet.
+    uint8_t connection_id_length = 0;
+  };
+
+  // Returns nullptr if `config` is invalid.
+  static std::unique_ptr<RoutableConnectionIdGenerator> Create(
+      const Config& config);
+  ~RoutableConnectionIdGenerator() override;
+
+  // Implement ::quic::ConnectionIdGeneratorInterface. Client chosen connection
+  // IDs are always replaced, so all connections are routable.
+  absl::optional<::quic::QuicConnectionId> GenerateNextConnectionId(
+      const ::quic::QuicConnectionId& original) override;
+  absl::optional<::quic::QuicConnectionId> MaybeReplaceConnectionId(
+      const ::quic::QuicConnectionId& original,
+      const ::quic::ParsedQuicVersion& version) override;
+
+  uint8_t connection_id_length() const { return config_.connection_id_length; }
+
+ private:
+  explicit RoutableConnectionIdGenerator(const Config& config);
+  // The same `seed` always generates the same connection ID, so retransmitted
+  // CHLOs are mapped to the same connection.
+  ::quic::QuicConnectionId GenerateConnectionId(
+      const ::quic::QuicConnectionId& seed) const;
+  uint8_t FirstOctet() const;
+
+  const Config config_;
+  AES_KEY encrypt_key_;
+};
+
+}  // namespace quic
+}  // namespace owt
+
+#endif  // QUIC_TRANSPORT_ROUTABLE_CONNECTION_ID_GENERATOR_H_
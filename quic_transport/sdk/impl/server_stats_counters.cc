@@ -0,0 +1,208 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "owt/quic_transport/sdk/impl/server_stats_counters.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "base/check.h"
+
+namespace owt {
+namespace quic {
+
+ServerStatsCounters::ServerStatsCounters()
+    : active_sessions_(0),
+      sessions_created_(0),
+      handshakes_per_second_(0),
+      chlo_backlog_passes_(0),
+      packets_received_(0),
+      bytes_received_(0),
+      packets_sent_(0),
+      bytes_sent_(0),
+      packets_dropped_(0),
+      write_blocked_events_(0),
+      loop_utilization_percent_(0),
+      peer_migrations_(0),
+      peer_port_changes_(0) {
+  for (auto& field : memory_usage_) {
+    field.store(0, std::memory_order_relaxed);
+  }
+}
+
+ServerStatsCounters::~ServerStatsCounters() = default;
+
+void ServerStatsCounters::OnPacketReceived(size_t length) {
+  Add(&packets_received_, 1);
+  Add(&bytes_received_, length);
+}
+
+void ServerStatsCounters::OnPacketSent(size_t length) {
+  Add(&packets_sent_, 1);
+  Add(&bytes_sent_, length);
+}
+
+void ServerStatsCounters::OnWriteBlocked() {
+  Add(&write_blocked_events_, 1);
+}
+
+void ServerStatsCounters::OnPacketsDropped(uint64_t count) {
+  Add(&packets_dropped_, count);
+}
+
+void ServerStatsCounters::OnPeerMigration(bool port_only) {
+  Add(&peer_migrations_, 1);
+  if (port_only) {
+    Add(&peer_port_changes_, 1);
+  }
+}
+
+void ServerStatsCounters::SetSessions(uint64_t active_sessions,
+                                      uint64_t sessions_created) {
+  Set(&active_sessions_, active_sessions);
+  Set(&sessions_created_, sessions_created);
+}
+
+void ServerStatsCounters::SetChloBacklogPasses(uint64_t passes) {
+  Set(&chlo_backlog_passes_, passes);
+}
+
+void ServerStatsCounters::SetRates(uint64_t handshakes_per_second,
+                                   uint64_t loop_utilization_percent) {
+  Set(&handshakes_per_second_, handshakes_per_second);
+  Set(&loop_utilization_percent_, loop_utilization_percent);
+}
+
+void ServerStatsCounters::SetMemoryUsage(const MemoryUsage& usage) {
+  uint64_t fields[kMemoryUsageFields];
+  memcpy(fields, &usage, sizeof(fields));
+  for (size_t i = 0; i < kMemoryUsageFields; i++) {
+    Set(&memory_usage_[i], fields[i]);
+  }
+}
+
+void ServerStatsCounters::Read(ServerStats* stats) const {
+  DCHECK(stats);
+  stats->active_sessions = active_sessions_.load(std::memory_order_relaxed);
+  stats->sessions_created = sessions_created_.load(std::memory_order_relaxed);
+  stats->handshakes_per_second =
+      handshakes_per_second_.load(std::memory_order_relaxed);
+  stats->chlo_backlog_passes =
+      chlo_backlog_passes_.load(std::memory_order_relaxed);
+  stats->packets_received = packets_received_.load(std::memory_order_relaxed);
+  stats->bytes_received = bytes_received_.load(std::memory_order_relaxed);
+  stats->packets_sent = packets_sent_.load(std::memory_order_relaxed);
+  stats->bytes_sent = bytes_sent_.load(std::memory_order_relaxed);
+  stats->packets_dropped = packets_dropped_.load(std::memory_order_relaxed);
+  stats->write_blocked_events =
+      write_blocked_events_.load(std::memory_order_relaxed);
+  stats->loop_utilization_percent =
+      loop_utilization_percent_.load(std::memory_order_relaxed);
+  stats->peer_migrations = peer_migrations_.load(std::memory_order_relaxed);
+  stats->peer_port_changes =
+      peer_port_changes_.load(std::memory_order_relaxed);
+}
+
+// static
+void ServerStatsCounters::Accumulate(const ServerStats& stats,
+                                     ServerStats* total) {
+  DCHECK(total);
+  total->active_sessions += stats.active_sessions;
+  total->sessions_created += stats.sessions_created;
+  total->handshakes_per_second += stats.handshakes_per_second;
+  total->chlo_backlog_passes += stats.chlo_backlog_passes;
+  total->packets_received += stats.packets_received;
+  total->bytes_received += stats.bytes_received;
+  total->packets_sent += stats.packets_sent;
+  total->bytes_sent += stats.bytes_sent;
+  total->packets_dropped += stats.packets_dropped;
+  total->write_blocked_events += stats.write_blocked_events;
+  total->loop_utilization_percent = std::max(total->loop_utilization_percent,
+                                             stats.loop_utilization_percent);
+  total->peer_migrations += stats.peer_migrations;
+  total->peer_port_changes += stats.peer_port_changes;
+}
+
+void ServerStatsCounters::ReadMemoryUsage(MemoryUsage* usage) const {
+  DCHECK(usage);
+  uint64_t fields[kMemoryUsageFields];
+  for (size_t i = 0; i < kMemoryUsageFields; i++) {
+    fields[i] = memory_usage_[i].load(std::memory_order_relaxed);
+  }
+  memcpy(usage, fields, sizeof(fields));
+}
+
+// static
+void ServerStatsCounters::Accumulate(const MemoryUsage& usage,
+                                     MemoryUsage* total) {
+  DCHECK(total);
+  total->sessions += usage.sessions;
+  total->streams += usage.streams;
+  total->stream_send_buffer_bytes += usage.stream_send_buffer_bytes;
+  total->stream_receive_buffer_bytes += usage.stream_receive_buffer_bytes;
+  total->datagram_buffer_bytes += usage.datagram_buffer_bytes;
+  total->queued_datagrams += usage.queued_datagrams;
+  total->object_bytes += usage.object_bytes;
+  total->total_bytes += usage.total_bytes;
+}
+
+// static
+void ServerStatsCounters::Add(std::atomic<uint64_t>* counter, uint64_t value) {
+  // There is a single writer, so a load and a store are enough.
+  counter->store(counter->load(std::memory_order_relaxed) + value,
+                 std::memory_order_relaxed);
+}
+
+// static
+void ServerStatsCounters::Set(std::atomic<uint64_t>* counter, uint64_t value) {
+  counter->store(value, std::memory_order_relaxed);
+}
+
+StatsRecordingPacketWriter::StatsRecordingPacketWriter(
+    ::quic::QuicPacketWriter* writer,
+    ServerStatsCounters* counters)
+    : counters_(counters) {
+  CHECK(counters_);
+  set_writer(writer);
+}
+
+StatsRecordingPacketWriter::~StatsRecordingPacketWriter() = default;
+
+::quic::WriteResult StatsRecordingPacketWriter::WritePacket(
+    const char* buffer,
+    size_t buf_len,
+    const ::quic::QuicIpAddress& self_address,
+    const ::quic::QuicSocketAddress& peer_address,
+    ::quic::PerPacketOptions* options) {
+  ::quic::WriteResult result = QuicPacketWriterWrapper::WritePacket(
+      buffer, buf_len, self_address, peer_address, options);
+  // The packet is kept by the writer when its status is
+  // WRITE_STATUS_BLOCKED_DATA_BUFFERED.
+  if (result.status == ::quic::WRITE_STATUS_OK ||
+      result.status == ::quic::WRITE_STATUS_BLOCKED_DATA_BUFFERED) {
+    counters_->OnPacketSent(buf_len);
+  }
+  RecordWriteResult(result);
+  return result;
+}
+
+::quic::WriteResult StatsRecordingPacketWriter::Flush() {
+  ::quic::WriteResult result = QuicPacketWriterWrapper::Flush();
+  RecordWriteResult(result);
+  return result;
+}
+
+void StatsRecordingPacketWriter::RecordWriteResult(
+    const ::quic::WriteResult& result) {
+  if (::quic::IsWriteBlockedStatus(result.status)) {
+    counters_->OnWriteBlocked();
+  } else if (::quic::IsWriteError(result.status)) {
+    counters_->OnPacketsDropped(1);
+  }
+}
+
+}  // namespace quic
+}  // namespace owt
@@ -0,0 +1,105 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef QUIC_TRANSPORT_SERVER_STATS_COUNTERS_H_
+#define QUIC_TRANSPORT_SERVER_STATS_COUNTERS_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "net/third_party/quiche/src/quiche/quic/core/quic_packet_writer_wrapper.h"
+#include "owt/quic/quic_transport_definitions.h"
+
+namespace owt {
+namespace quic {
+
+// Counters of an IO thread. Only the IO thread updates them, so they are
+// stored with relaxed atomic writes instead of locks or read-modify-write
+// instructions. They could be read on any thread. Each counter read is exact,
+// but different counters may be read before and after an update.
+class ServerStatsCounters {
+ public:
+  ServerStatsCounters();
+  ~ServerStatsCounters();
+  ServerStatsCounters(const ServerStatsCounters&) = delete;
+  ServerStatsCounters& operator=(const ServerStatsCounters&) = delete;
+
+  void OnPacketReceived(size_t length);
+  void OnPacketSent(size_t length);
+  void OnWriteBlocked();
+  void OnPacketsDropped(uint64_t count);
+  // `port_only` is true if only the port of the peer address changed.
+  void OnPeerMigration(bool port_only);
+  // Updates values sampled by the IO thread.
+  void SetSessions(uint64_t active_sessions, uint64_t sessions_created);
+  void SetChloBacklogPasses(uint64_t passes);
+  void SetRates(uint64_t handshakes_per_second,
+                uint64_t loop_utilization_percent);
+  void SetMemoryUsage(const MemoryUsage& usage);
+
+  // Copies all counters to `stats`.
+  void Read(ServerStats* stats) const;
+  // Adds `stats` of an IO thread to `total`. Loop utilization of `total` is
+  // the max of all IO threads.
+  static void Accumulate(const ServerStats& stats, ServerStats* total);
+  void ReadMemoryUsage(MemoryUsage* usage) const;
+  // Adds every field of `usage` to `total`.
+  static void Accumulate(const MemoryUsage& usage, MemoryUsage* total);
+
+ private:
+  // MemoryUsage only has 64 bits fields, so it's stored as an array.
+  static constexpr size_t kMemoryUsageFields =
+      sizeof(MemoryUsage) / sizeof(uint64_t);
+
+  static void Add(std::atomic<uint64_t>* counter, uint64_t value);
+  static void Set(std::atomic<uint64_t>* counter, uint64_t value);
+
+  std::atomic<uint64_t> active_sessions_;
+  std::atomic<uint64_t> sessions_created_;
+  std::atomic<uint64_t> handshakes_per_second_;
+  std::atomic<uint64_t> chlo_backlog_passes_;
+  std::atomic<uint64_t> packets_received_;
+  std::atomic<uint64_t> bytes_received_;
+  std::atomic<uint64_t> packets_sent_;
+  std::atomic<uint64_t> bytes_sent_;
+  std::atomic<uint64_t> packets_dropped_;
+  std::atomic<uint64_t> write_blocked_events_;
+  std::atomic<uint64_t> loop_utilization_percent_;
+  std::atomic<uint64_t> peer_migrations_;
+  std::atomic<uint64_t> peer_port_changes_;
+  std::atomic<uint64_t> memory_usage_[kMemoryUsageFields];
+};
+
+// Counts packets written by the writer it wraps. A packet is counted as sent
+// once the wrapped writer accepts it, which could be before a batch writer
+// flushes it.
+class StatsRecordingPacketWriter : public ::quic::QuicPacketWriterWrapper {
+ public:
+  // Takes the ownership of `writer`. `counters` must outlive this writer.
+  StatsRecordingPacketWriter(::quic::QuicPacketWriter* writer,
+                             ServerStatsCounters* counters);
+  ~StatsRecordingPacketWriter() override;
+
+  // Overrides ::quic::QuicPacketWriterWrapper.
+  ::quic::WriteResult WritePacket(
+      const char* buffer,
+      size_t buf_len,
+      const ::quic::QuicIpAddress& self_address,
+      const ::quic::QuicSocketAddress& peer_address,
+      ::quic::PerPacketOptions* options) override;
+  ::quic::WriteResult Flush() override;
+
+ private:
+  void RecordWriteResult(const ::quic::WriteResult& result);
+
+  ServerStatsCounters* counters_;
+};
+
+}  // namespace quic
+}  // namespace owt
+
+#endif  // QUIC_TRANSPORT_SERVER_STATS_COUNTERS_H_
@@ -0,0 +1,366 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+// Measures stream goodput, datagram rate, message latency and CPU cost of an
+// in-process QuicTransport server and clients over loopback. Each client
+// session opens `streams` bidirectional streams which are echoed by the
+// server, and keeps `pipeline` messages of `message_size` bytes in flight on
+// each of them. Latency is measured from sending a message to receiving its
+// echo.
+
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/at_exit.h"
+#include "base/command_line.h"
+#include "base/files/file_path.h"
+#include "base/logging.h"
+#include "base/process/process_metrics.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/synchronization/lock.h"
+#include "base/synchronization/waitable_event.h"
+#include "base/threading/platform_thread.h"
+#include "base/time/time.h"
+#include "net/test/test_data_directory.h"
+#include "owt/quic/quic_transport_factory.h"
+
+namespace owt {
+namespace quic {
+namespace test {
+namespace {
+
+struct BenchmarkConfig {
+  int port = 20003;
+  size_t sessions = 1;
+  size_t streams = 1;
+  size_t message_size = 1024;
+  size_t pipeline = 1;
+  size_t datagram_size = 0;
+  size_t datagrams_per_ms = 10;
+  int duration_s = 10;
+};
+
+size_t GetSizeSwitch(const base::CommandLine& command_line,
+                     const char* name,
+                     size_t default_value) {
+  size_t value;
+  if (!command_line.HasSwitch(name) ||
+      !base::StringToSizeT(command_line.GetSwitchValueASCII(name), &value)) {
+    return default_value;
+  }
+  return value;
+}
+
+BenchmarkConfig ParseConfig(const base::CommandLine& command_line) {
+  BenchmarkConfig config;
+  config.port = static_cast<int>(GetSizeSwitch(command_line, "port", 20003));
+  config.sessions =
+      std::max<size_t>(1, GetSizeSwitch(command_line, "sessions", 1));
+  config.streams = GetSizeSwitch(command_line, "streams", 1);
+  config.message_size =
+      std::max<size_t>(1, GetSizeSwitch(command_line, "message_size", 1024));
+  config.pipeline =
+      std::max<size_t>(1, GetSizeSwitch(command_line, "pipeline", 1));
+  config.datagram_size = GetSizeSwitch(command_line, "datagram_size", 0);
+  config.datagrams_per_ms =
+      GetSizeSwitch(command_line, "datagrams_per_ms", 10);
+  config.duration_s = static_cast<int>(
+      std::max<size_t>(1, GetSizeSwitch(command_line, "duration_s", 10)));
+  return config;
+}
+
+// Collects results from all streams and sessions. Methods could be called on
+// any thread.
+class BenchmarkRecorder {
+ public:
+  void OnMessageEchoed(base::TimeDelta latency, size_t bytes) {
+    base::AutoLock auto_lock(lock_);
+    latencies_us_.push_back(latency.InMicroseconds());
+    echoed_bytes_ += bytes;
+  }
+  void OnDatagramsSent(size_t count) { datagrams_sent_ += count; }
+  void OnDatagramsReceived(size_t count) { datagrams_received_ += count; }
+
+  void Report(base::TimeDelta duration, base::TimeDelta cpu_time) {
+    base::AutoLock auto_lock(lock_);
+    const double seconds = duration.InSecondsF();
+    std::sort(latencies_us_.begin(), latencies_us_.end());
+    std::cout << "messages: " << latencies_us_.size() << std::endl;
+    std::cout << "stream_goodput_mbps: "
+              << echoed_bytes_ * 8 / seconds / 1000000 << std::endl;
+    std::cout << "latency_p50_us: " << Percentile(0.5) << std::endl;
+    std::cout << "latency_p99_us: " << Percentile(0.99) << std::endl;
+    std::cout << "latency_p999_us: " << Percentile(0.999) << std::endl;
+    std::cout << "datagrams_sent_per_second: " << datagrams_sent_ / seconds
+              << std::endl;
+    std::cout << "datagrams_received_per_second: "
+              << datagrams_received_ / seconds << std::endl;
+    // Server and clients run in the same process, so it's the cost of both
+    // ends. Echoed data crosses loopback twice.
+    const uint64_t bytes_transferred = 2 * echoed_bytes_;
+    if (bytes_transferred > 0) {
+      std::cout << "cpu_seconds_per_gb: "
+                << cpu_time.InSecondsF() * 1000000000 / bytes_transferred
+                << std::endl;
+    }
+  }
+
+ private:
+  int64_t Percentile(double percentile) const {
+    if (latencies_us_.empty()) {
+      return 0;
+    }
+    size_t index = static_cast<size_t>(percentile * latencies_us_.size());
+    return latencies_us_[std::min(index, latencies_us_.size() - 1)];
+  }
+
+  base::Lock lock_;
+  std::vector<int64_t> latencies_us_;
+  uint64_t echoed_bytes_ = 0;
+  std::atomic<uint64_t> datagrams_sent_{0};
+  std::atomic<uint64_t> datagrams_received_{0};
+};
+
+// Echoes all streams and counts datagrams on the server side.
+class BenchmarkServerVisitor : public QuicTransportServerInterface::Visitor,
+                               public QuicTransportSessionInterface::Visitor,
+                               public QuicTransportStreamInterface::Visitor {
+ public:
+  explicit BenchmarkServerVisitor(BenchmarkRecorder* recorder)
+      : recorder_(recorder) {}
+
+  // Overrides QuicTransportServerInterface::Visitor.
+  void OnEnded() override {}
+  void OnSession(QuicTransportSessionInterface* session) override {
+    session->SetVisitor(this);
+  }
+  void OnClosedSession(char*, size_t) override {}
+
+  // Overrides QuicTransportSessionInterface::Visitor.
+  void OnIncomingStream(QuicTransportStreamInterface* stream) override {
+    stream->SetVisitor(this);
+  }
+  void OnStreamClosed(uint32_t) override {}
+  void OnDatagramsReceived(const Datagram*, size_t count) override {
+    recorder_->OnDatagramsReceived(count);
+  }
+
+  // Overrides QuicTransportStreamInterface::Visitor.
+  void OnData(QuicTransportStreamInterface* stream,
+              char* data,
+              size_t len) override {
+    stream->SendData(data, len);
+  }
+
+ private:
+  BenchmarkRecorder* recorder_;
+};
+
+// Sends messages on a client stream and measures their round trip time.
+class BenchmarkStreamDriver : public QuicTransportStreamInterface::Visitor {
+ public:
+  BenchmarkStreamDriver(QuicTransportStreamInterface* stream,
+                        size_t message_size,
+                        const std::atomic<bool>* running,
+                        BenchmarkRecorder* recorder)
+      : stream_(stream),
+        message_(message_size, 'm'),
+        running_(running),
+        recorder_(recorder),
+        pending_bytes_(0) {}
+
+  void Start(size_t pipeline) {
+    base::AutoLock auto_lock(lock_);
+    for (size_t i = 0; i < pipeline; i++) {
+      SendMessage();
+    }
+  }
+
+  // Overrides QuicTransportStreamInterface::Visitor.
+  void OnData(QuicTransportStreamInterface*, char*, size_t len) override {
+    base::AutoLock auto_lock(lock_);
+    pending_bytes_ += len;
+    while (pending_bytes_ >= message_.size() && !send_times_.empty()) {
+      pending_bytes_ -= message_.size();
+      recorder_->OnMessageEchoed(base::TimeTicks::Now() - send_times_.front(),
+                                 message_.size());
+      send_times_.pop_front();
+      if (running_->load(std::memory_order_relaxed)) {
+        SendMessage();
+      }
+    }
+  }
+
+ private:
+  void SendMessage() {
+    send_times_.push_back(base::TimeTicks::Now());
+    stream_->SendData(message_.data(), message_.size());
+  }
+
+  QuicTransportStreamInterface* stream_;
+  std::vector<char> message_;
+  const std::atomic<bool>* running_;
+  BenchmarkRecorder* recorder_;
+  // Start() runs on the main thread, OnData runs on the event thread.
+  base::Lock lock_;
+  // Send time of each message whose echo is not fully received.
+  std::deque<base::TimeTicks> send_times_;
+  // Bytes received for the oldest message in flight.
+  size_t pending_bytes_;
+};
+
+class BenchmarkClientVisitor : public QuicTransportClientInterface::Visitor {
+ public:
+  BenchmarkClientVisitor(std::atomic<int>* pending_connections,
+                         base::WaitableEvent* all_connected)
+      : pending_connections_(pending_connections),
+        all_connected_(all_connected) {}
+
+  // Overrides QuicTransportClientInterface::Visitor.
+  void OnConnected() override { OnConnectionDone(); }
+  void OnConnectionFailed() override {
+    LOG(ERROR) << "Benchmark client failed to connect.";
+    OnConnectionDone();
+  }
+  void OnConnectionClosed(char*, size_t) override {}
+  void OnIncomingStream(QuicTransportStreamInterface*) override {}
+  void OnStreamClosed(uint32_t) override {}
+
+ private:
+  void OnConnectionDone() {
+    if (pending_connections_->fetch_sub(1) == 1) {
+      all_connected_->Signal();
+    }
+  }
+
+  std::atomic<int>* pending_connections_;
+  base::WaitableEvent* all_connected_;
+};
+
+int RunBenchmark(const BenchmarkConfig& config) {
+  BenchmarkRecorder recorder;
+  BenchmarkServerVisitor server_visitor(&recorder);
+  std::atomic<int> pending_connections(static_cast<int>(config.sessions));
+  base::WaitableEvent all_connected;
+  BenchmarkClientVisitor client_visitor(&pending_connections, &all_connected);
+  std::atomic<bool> running(true);
+  // Declared before the factory, so they outlive event threads.
+  std::vector<std::unique_ptr<BenchmarkStreamDriver>> drivers;
+
+  std::unique_ptr<QuicTransportFactory> factory(
+      QuicTransportFactory::CreateForTesting());
+  base::FilePath certs_dir = net::GetTestCertsDirectory();
+  std::unique_ptr<QuicTransportServerInterface> server(
+      factory->CreateQuicTransportServer(
+          config.port,
+          certs_dir.AppendASCII("quic-chain.pem").MaybeAsASCII().c_str(),
+          certs_dir.AppendASCII("quic-leaf-cert.key").MaybeAsASCII().c_str(),
+          certs_dir.AppendASCII("quic-leaf-cert.key.sct")
+              .MaybeAsASCII()
+              .c_str()));
+  if (!server) {
+    LOG(ERROR) << "Failed to create server.";
+    return 1;
+  }
+  server->SetVisitor(&server_visitor);
+  if (server->Start() != 0) {
+    LOG(ERROR) << "Failed to start server.";
+    return 1;
+  }
+
+  std::vector<std::unique_ptr<QuicTransportClientInterface>> clients;
+  for (size_t i = 0; i < config.sessions; i++) {
+    clients.emplace_back(
+        factory->CreateQuicTransportClient("127.0.0.1", config.port));
+    clients.back()->SetVisitor(&client_visitor);
+    clients.back()->Start();
+  }
+  all_connected.Wait();
+
+  for (auto& client : clients) {
+    for (size_t i = 0; i < config.streams; i++) {
+      QuicTransportStreamInterface* stream =
+          client->CreateBidirectionalStream();
+      if (!stream) {
+        LOG(ERROR) << "Failed to create stream.";
+        break;
+      }
+      drivers.push_back(std::make_unique<BenchmarkStreamDriver>(
+          stream, config.message_size, &running, &recorder));
+      stream->SetVisitor(drivers.back().get());
+    }
+  }
+
+  std::unique_ptr<base::ProcessMetrics> metrics =
+      base::ProcessMetrics::CreateCurrentProcessMetrics();
+  const base::TimeDelta cpu_start = metrics->GetCumulativeCPUUsage();
+  const base::TimeTicks start = base::TimeTicks::Now();
+  for (auto& driver : drivers) {
+    driver->Start(config.pipeline);
+  }
+  const base::TimeTicks end = start + base::Seconds(config.duration_s);
+  if (config.datagram_size > 0 && config.datagrams_per_ms > 0) {
+    // Datagrams are sent from this thread once per millisecond.
+    std::vector<uint8_t> payload(config.datagram_size, 'd');
+    std::vector<Datagram> batch(config.datagrams_per_ms,
+                                Datagram{payload.data(), payload.size()});
+    while (base::TimeTicks::Now() < end) {
+      for (auto& client : clients) {
+        client->SendDatagrams(batch.data(), batch.size());
+        recorder.OnDatagramsSent(batch.size());
+      }
+      base::PlatformThread::Sleep(base::Milliseconds(1));
+    }
+  } else {
+    base::PlatformThread::Sleep(end - base::TimeTicks::Now());
+  }
+  running = false;
+  const base::TimeDelta elapsed = base::TimeTicks::Now() - start;
+  const base::TimeDelta cpu_time =
+      metrics->GetCumulativeCPUUsage() - cpu_start;
+
+  std::cout << "sessions: " << config.sessions
+            << ", streams per session: " << config.streams
+            << ", message size: " << config.message_size
+            << ", pipeline: " << config.pipeline
+            << ", datagram size: " << config.datagram_size << std::endl;
+  recorder.Report(elapsed, cpu_time);
+
+  for (auto& client : clients) {
+    client->Stop();
+  }
+  server->Stop();
+  return 0;
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace quic
+}  // namespace owt
+
+int main(int argc, char* argv[]) {
+  base::AtExitManager exit_manager;
+  base::CommandLine::Init(argc, argv);
+  logging::LoggingSettings settings;
+  settings.logging_dest = logging::LOG_TO_SYSTEM_DEBUG_LOG;
+  logging::InitLogging(settings);
+  const base::CommandLine& command_line =
+      *base::CommandLine::ForCurrentProcess();
+  if (command_line.HasSwitch("help")) {
+    std::cout << "Usage: owt_quic_transport_benchmark [--port=] [--sessions=] "
+                 "[--streams=] [--message_size=] [--pipeline=] "
+                 "[--datagram_size=] [--datagrams_per_ms=] [--duration_s=]"
+              << std::endl;
+    return 0;
+  }
+  return owt::quic::test::RunBenchmark(
+      owt::quic::test::ParseConfig(command_line));
+}
@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "owt/quic_transport/sdk/impl/utilities.h"
+
+#include "absl/strings/string_view.h"
+#include "net/third_party/quiche/src/quiche/common/quiche_buffer_allocator.h"
+#include "net/third_party/quiche/src/quiche/common/simple_buffer_allocator.h"
+#include "net/third_party/quiche/src/quiche/quic/core/crypto/crypto_protocol.h"
+
+namespace owt {
+namespace quic {
+
+::quic::CongestionControlType Utilities::ConvertCongestionControlType(
+    CongestionControlType type) {
+  switch (type) {
+    case CongestionControlType::kCubic:
+      return ::quic::kCubicBytes;
+    case CongestionControlType::kReno:
+      return ::quic::kRenoBytes;
+    case CongestionControlType::kBbrV2:
+      return ::quic::kBBRv2;
+    case CongestionControlType::kDefault:
+    case CongestionControlType::kBbr:
+    default:
+      return ::quic::kBBR;
+  }
+}
+
+::quic::QuicTag Utilities::CongestionControlConnectionOption(
+    CongestionControlType type) {
+  switch (type) {
+    case CongestionControlType::kCubic:
+      return ::quic::kBYTE;
+    case CongestionControlType::kReno:
+      return ::quic::kRENO;
+    case CongestionControlType::kBbrV2:
+      return ::quic::kB2ON;
+    case CongestionControlType::kDefault:
+    case CongestionControlType::kBbr:
+    default:
+      return ::quic::kTBBR;
+  }
+}
+
+::quic::QuicTagVector Utilities::CongestionProfileConnectionOptions(
+    CongestionProfile profile) {
+  switch (profile) {
+    case CongestionProfile::kRealtime:
+      // BBRv2 limits PROBE_RTT cwnd to half of the BDP, and skips PROBE_RTT if
+      // inflight was low enough to measure min RTT recently. k1RTT exits
+      // STARTUP after one round without bandwidth growth instead of three.
+      // B2CL doesn't add ack height to PROBE_BW cwnd, and BSAO keeps ack
+      // aggregation from inflating bandwidth samples.
+      return {::quic::kB2ON, ::quic::k1RTT, ::quic::kB2CL, ::quic::kBSAO};
+    case CongestionProfile::kDefault:
+    default:
+      return {};
+  }
+}
+
+std::vector<::quiche::QuicheMemSlice> Utilities::CopyDatagrams(
+    const Datagram* batch,
+    size_t count) {
+  std::vector<::quiche::QuicheMemSlice> slices;
+  slices.reserve(count);
+  for (size_t i = 0; i < count; i++) {
+    slices.emplace_back(::quiche::QuicheBuffer::Copy(
+        ::quiche::SimpleBufferAllocator::Get(),
+        absl::string_view(reinterpret_cast<const char*>(batch[i].data),
+                          batch[i].length)));
+  }
+  return slices;
+}
+
+std::vector<Datagram> Utilities::DatagramsFromBuffers(
+    const std::vector<std::string>& buffers) {
+  std::vector<Datagram> datagrams;
+  datagrams.reserve(buffers.size());
+  for (const auto& buffer : buffers) {
+    datagrams.push_back(
+        {reinterpret_cast<const uint8_t*>(buffer.data()), buffer.size()});
+  }
+  return datagrams;
+}
+
+}  // namespace quic
+}  // namespace owt
@@ -0,0 +1,45 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef QUIC_TRANSPORT_UTILITIES_H_
+#define QUIC_TRANSPORT_UTILITIES_H_
+
+#include <string>
+#include <vector>
+
+#include "net/third_party/quiche/src/quiche/common/quiche_mem_slice.h"
+#include "net/third_party/quiche/src/quiche/quic/core/quic_tag.h"
+#include "net/third_party/quiche/src/quiche/quic/core/quic_types.h"
+#include "owt/quic/quic_transport_definitions.h"
+
+namespace owt {
+namespace quic {
+
+class Utilities {
+ public:
+  static ::quic::CongestionControlType ConvertCongestionControlType(
+      CongestionControlType type);
+  // Returns the QUIC connection option which selects `type`.
+  static ::quic::QuicTag CongestionControlConnectionOption(
+      CongestionControlType type);
+  // Returns the QUIC connection options which apply `profile`, including the
+  // one selecting its algorithm. It's empty for kDefault.
+  static ::quic::QuicTagVector CongestionProfileConnectionOptions(
+      CongestionProfile profile);
+  // Copies `count` datagrams in `batch` to memory slices, so they can be sent
+  // on another thread.
+  static std::vector<::quiche::QuicheMemSlice> CopyDatagrams(
+      const Datagram* batch,
+      size_t count);
+  // Returns datagrams pointing to `buffers`, which must outlive them.
+  static std::vector<Datagram> DatagramsFromBuffers(
+      const std::vector<std::string>& buffers);
+};
+
+}  // namespace quic
+}  // namespace owt
+
+#endif  // QUIC_TRANSPORT_UTILITIES_H_
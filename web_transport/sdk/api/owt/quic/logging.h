@@ -7,6 +7,7 @@
 #ifndef OWT_WEB_TRANSPORT_LOGGING_H_
 #define OWT_WEB_TRANSPORT_LOGGING_H_
 
+#include <stdint.h>
 #include "export.h"
 
 namespace owt {
@@ -27,6 +28,21 @@ enum class LoggingSeverity : int {
   kFatal
 };
 
+/// Receives log messages. Messages are queued in a lock-free ring buffer by the
+/// thread that logs them, and delivered to the sink on a background logging
+/// thread, so writing to a slow destination never blocks network threads.
+/// Messages are dropped when the buffer is full.
+class OWT_EXPORT LogSink {
+ public:
+  virtual ~LogSink() = default;
+  /// Called on the logging thread for each message. `file` and `message` are
+  /// only valid during this call. `message` doesn't end with a new line.
+  virtual void OnLogMessage(LoggingSeverity severity,
+                            const char* file,
+                            int line,
+                            const char* message) = 0;
+};
+
 class OWT_EXPORT Logging {
  public:
   /// Set logging severity. All logging messages with higher severity will be
@@ -36,6 +52,16 @@ class OWT_EXPORT Logging {
   static LoggingSeverity Severity();
   // Init logging module.
   static void InitLogging();
+  /// Routes all log messages except fatal ones to `sink`, which is not owned
+  /// by the SDK and must outlive its use. nullptr restores the default
+  /// destination. Messages queued before this call may go to either
+  /// destination.
+  static void SetLogSink(LogSink* sink);
+  /// Writes all queued messages before returning, e.g.: before exiting or
+  /// destroying a sink.
+  static void Flush();
+  /// Returns the number of messages dropped because the ring buffer was full.
+  static uint64_t DroppedMessages();
 
  private:
   static LoggingSeverity min_severity_;
@@ -0,0 +1,101 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef OWT_WEB_TRANSPORT_METRICS_H_
+#define OWT_WEB_TRANSPORT_METRICS_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "export.h"
+
+namespace owt {
+namespace quic {
+
+/// Counters accumulated by all servers and clients of this process since it
+/// started.
+enum class MetricCounter : int {
+  /// UDP packets received and sent by servers, and their payload bytes.
+  kPacketsReceived,
+  kBytesReceived,
+  kPacketsSent,
+  kBytesSent,
+  /// WebTransport streams created and destroyed.
+  kStreamsOpened,
+  kStreamsClosed,
+  /// Datagrams dropped without being sent, e.g.: expired in queue.
+  kDatagramsDropped,
+  /// Client address changes accepted by server connections.
+  kPeerMigrations,
+  kCount
+};
+
+/// Distributions of latencies, in microseconds.
+enum class MetricHistogram : int {
+  /// From a server receiving the first packet of a connection to its
+  /// WebTransport session being ready.
+  kServerHandshakeLatency,
+  /// From a client starting to connect to its WebTransport session being
+  /// ready.
+  kClientHandshakeLatency,
+  /// Time an event waits in an event thread's queue before its visitor method
+  /// is called.
+  kEventQueueDelay,
+  kCount
+};
+
+/// Values sampled by servers every second, summed over all servers.
+enum class MetricGauge : int {
+  /// Memory held by server sessions, see MemoryUsage.
+  kServerMemoryBytes,
+  kServerStreamSendBufferBytes,
+  kServerStreamReceiveBufferBytes,
+  kServerDatagramBufferBytes,
+  kCount
+};
+
+struct OWT_EXPORT HistogramSnapshot {
+  uint64_t count;
+  uint64_t sum;
+  uint64_t min;
+  uint64_t max;
+  /// Percentiles have a relative error below 1/16 of the value.
+  uint64_t p50;
+  uint64_t p90;
+  uint64_t p99;
+  uint64_t p999;
+};
+
+struct OWT_EXPORT MetricsSnapshot {
+  uint64_t counters[static_cast<int>(MetricCounter::kCount)];
+  HistogramSnapshot histograms[static_cast<int>(MetricHistogram::kCount)];
+  int64_t gauges[static_cast<int>(MetricGauge::kCount)];
+};
+
+/// Metrics are recorded by each thread into its own cache line aligned slots
+/// without locks or read-modify-write instructions, and summed when they are
+/// read. Methods could be called on any thread.
+class OWT_EXPORT Metrics {
+ public:
+  /// Returns the sum of values recorded by all threads. Values recorded
+  /// concurrently may or may not be included.
+  static MetricsSnapshot Snapshot();
+  /// Writes a snapshot in Prometheus text exposition format to `buffer`,
+  /// including the terminating null character if `size` is large enough.
+  /// Returns the length of the text, excluding the terminating null
+  /// character. Call it with a larger buffer if the return value is not less
+  /// than `size`.
+  static size_t PrometheusText(char* buffer, size_t size);
+  /// Returns the name of `counter`, `histogram` or `gauge`, e.g.:
+  /// "packets_received".
+  static const char* Name(MetricCounter counter);
+  static const char* Name(MetricHistogram histogram);
+  static const char* Name(MetricGauge gauge);
+};
+
+}  // namespace quic
+}  // namespace owt
+
+#endif
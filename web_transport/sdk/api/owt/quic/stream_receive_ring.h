@@ -0,0 +1,122 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+// A single producer single consumer ring buffer owned by the application and
+// filled by the SDK with incoming stream data. See
+// WebTransportStreamInterface::SetReceiveRing. This file is header only.
+//
+// Example:
+//   StreamReceiveRing ring(storage, sizeof(storage));
+//   stream->SetReceiveRing(&ring, 16 * 1024);
+//   // In Visitor::OnCanRead, or whenever the consumer runs:
+//   while (size_t length = ring.Read(buffer, sizeof(buffer))) {
+//     Consume(buffer, length);
+//   }
+//   if (ring.TakeProducerBlocked()) {
+//     stream->ResumeReceive();
+//   }
+
+#ifndef OWT_WEB_TRANSPORT_STREAM_RECEIVE_RING_H_
+#define OWT_WEB_TRANSPORT_STREAM_RECEIVE_RING_H_
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace owt {
+namespace quic {
+
+// The SDK produces on IO thread, and one application thread consumes. `data`
+// must outlive the stream the ring is registered to, or be unregistered
+// before it's released.
+class StreamReceiveRing {
+ public:
+  StreamReceiveRing(uint8_t* data, size_t capacity)
+      : data_(data),
+        capacity_(capacity),
+        write_index_(0),
+        read_index_(0),
+        producer_blocked_(false) {}
+  StreamReceiveRing(const StreamReceiveRing&) = delete;
+  StreamReceiveRing& operator=(const StreamReceiveRing&) = delete;
+
+  size_t capacity() const { return capacity_; }
+  // Bytes written and not read yet.
+  size_t ReadableBytes() const {
+    return static_cast<size_t>(write_index_.load(std::memory_order_acquire) -
+                               read_index_.load(std::memory_order_acquire));
+  }
+  size_t WritableBytes() const { return capacity_ - ReadableBytes(); }
+
+  // Consumer side.
+  // Copies at most `length` bytes out of the ring, returns the number of bytes
+  // copied.
+  size_t Read(uint8_t* data, size_t length) {
+    const uint64_t read_index = read_index_.load(std::memory_order_relaxed);
+    const size_t readable = static_cast<size_t>(
+        write_index_.load(std::memory_order_acquire) - read_index);
+    const size_t total = std::min(length, readable);
+    const size_t offset = static_cast<size_t>(read_index % capacity_);
+    const size_t first = std::min(total, capacity_ - offset);
+    memcpy(data, data_ + offset, first);
+    memcpy(data + first, data_, total - first);
+    // Pairs with the check in MarkProducerBlocked, so either the producer sees
+    // the space freed, or the consumer sees the flag.
+    read_index_.store(read_index + total, std::memory_order_seq_cst);
+    return total;
+  }
+  // Returns true once after the producer stopped because the ring is full and
+  // space is freed since. The consumer calls
+  // WebTransportStreamInterface::ResumeReceive then.
+  bool TakeProducerBlocked() {
+    return producer_blocked_.load(std::memory_order_seq_cst) &&
+           producer_blocked_.exchange(false, std::memory_order_seq_cst);
+  }
+
+  // Producer side, only called by the SDK.
+  // Returns the contiguous free region at the write position, and sets
+  // `length` to its size. `length` is 0 when the ring is full.
+  uint8_t* GetWriteRegion(size_t* length) {
+    const uint64_t write_index = write_index_.load(std::memory_order_relaxed);
+    const size_t offset = static_cast<size_t>(write_index % capacity_);
+    *length = std::min(WritableBytes(), capacity_ - offset);
+    return data_ + offset;
+  }
+  // Publishes `length` bytes written to the region returned by
+  // GetWriteRegion.
+  void CommitWrite(size_t length) {
+    write_index_.store(write_index_.load(std::memory_order_relaxed) + length,
+                       std::memory_order_release);
+  }
+  // Flags the producer as blocked on a full ring. Returns false if space has
+  // been freed meanwhile, in which case the flag is cleared and the producer
+  // continues writing.
+  bool MarkProducerBlocked() {
+    producer_blocked_.store(true, std::memory_order_seq_cst);
+    if (write_index_.load(std::memory_order_relaxed) -
+            read_index_.load(std::memory_order_seq_cst) ==
+        capacity_) {
+      return true;
+    }
+    producer_blocked_.store(false, std::memory_order_relaxed);
+    return false;
+  }
+
+ private:
+  uint8_t* const data_;
+  const size_t capacity_;
+  // Total bytes written and read. They never wrap in practice.
+  std::atomic<uint64_t> write_index_;
+  std::atomic<uint64_t> read_index_;
+  std::atomic<bool> producer_blocked_;
+};
+
+}  // namespace quic
+}  // namespace owt
+
+#endif
@@ -0,0 +1,40 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef OWT_WEB_TRANSPORT_TRACING_H_
+#define OWT_WEB_TRANSPORT_TRACING_H_
+
+#include "export.h"
+
+namespace owt {
+namespace quic {
+
+/// Records trace events of this SDK in the Chrome JSON trace format, which can
+/// be loaded by chrome://tracing or https://ui.perfetto.dev. Events of this SDK
+/// are recorded in the "net" category, together with the ones from Chromium's
+/// network stack. Tasks posted to the event thread are connected to where they
+/// are posted by flow events, and record how long they wait in the queue as
+/// "queue_wait_us".
+class OWT_EXPORT Tracing {
+ public:
+  /// Starts recording trace events of `categories`, a comma separated list of
+  /// category filters like "net,-toplevel". Pass nullptr to record the default
+  /// categories of this SDK. Returns false if a trace is already being
+  /// recorded.
+  static bool Start(const char* categories);
+  /// Stops recording and writes the trace to `file_path`. It blocks until
+  /// trace events from all threads are collected, so don't call it on a
+  /// thread whose events are being recorded, e.g. event thread. Returns false
+  /// if no trace is being recorded or writing the file failed.
+  static bool StopAndWrite(const char* file_path);
+  /// Returns true if a trace is being recorded.
+  static bool IsRecording();
+};
+
+}  // namespace quic
+}  // namespace owt
+
+#endif
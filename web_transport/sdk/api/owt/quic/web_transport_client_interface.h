@@ -18,9 +18,89 @@ class OWT_EXPORT WebTransportClientInterface {
  public:
   // https://wicg.github.io/web-transport/#dom-quictransportconfiguration-server_certificate_fingerprints.
   struct Parameters {
-    Parameters() : server_certificate_fingerprints_length(0) {}
+    Parameters()
+        : server_certificate_fingerprints_length(0),
+          congestion_control(CongestionControlType::kDefault),
+          server_congestion_control(CongestionControlType::kDefault),
+          congestion_profile(CongestionProfile::kDefault),
+          inline_event_dispatch(false),
+          enable_session_resumption(false),
+          pooled_send_buffers(false),
+          enable_mtu_discovery(false),
+          enable_ack_frequency(false),
+          ack_eliciting_threshold(0),
+          max_ack_delay_ms(0),
+          disable_qpack_dynamic_table(false),
+          qpack_dynamic_table_capacity(0),
+          qpack_blocked_streams(0),
+          idle_timeout_ms(0),
+          keepalive_interval_ms(0),
+          max_stream_receive_window(0),
+          max_session_receive_window(0),
+          batch_packet_reads(false),
+          max_packets_per_read(0),
+          network_emulation(nullptr) {}
     CertificateFingerprint** server_certificate_fingerprints;
     size_t server_certificate_fingerprints_length;
+    // Congestion control algorithm for data sent by this client.
+    CongestionControlType congestion_control;
+    // Congestion control algorithm the server is asked to use for this
+    // session. kDefault lets server use its own setting.
+    CongestionControlType server_congestion_control;
+    // Congestion control tuning of this session, for both directions. The
+    // server is asked to apply it with QUIC connection options. Profiles
+    // other than kDefault override `congestion_control` and
+    // `server_congestion_control`.
+    CongestionProfile congestion_profile;
+    // Calls visitor methods directly on IO thread instead of posting them to
+    // an event thread, which saves a thread hop per event. Visitors must not
+    // block.
+    bool inline_event_dispatch;
+    // Resumes TLS sessions established by earlier clients created by the same
+    // factory, which saves a round trip when reconnecting. Requests are sent
+    // as 0-RTT data if the server accepts it, so they could be replayed.
+    bool enable_session_resumption;
+    // Allocates stream send buffers and datagram copies from a pool of size
+    // classes owned by the IO thread instead of malloc.
+    bool pooled_send_buffers;
+    // Probes the path for packets up to 1450 bytes, and asks the server to
+    // probe its path as well, so larger datagrams could be sent on paths
+    // allowing them.
+    bool enable_mtu_discovery;
+    // Same as the fields of WebTransportServerInterface::Options, but for
+    // this client's connection and its server.
+    bool enable_ack_frequency;
+    uint32_t ack_eliciting_threshold;
+    uint32_t max_ack_delay_ms;
+    // Same as the fields of WebTransportServerInterface::Options, but
+    // advertised to the server.
+    bool disable_qpack_dynamic_table;
+    uint32_t qpack_dynamic_table_capacity;
+    uint32_t qpack_blocked_streams;
+    // Same as the fields of WebTransportServerInterface::Options, but for
+    // this client's connection. The idle timeout is also advertised to the
+    // server, the smaller one of both ends applies. Visitor::OnClosed is
+    // called when it expires. 0 means QUIC's defaults.
+    uint32_t idle_timeout_ms;
+    uint32_t keepalive_interval_ms;
+    // Caps of receive windows of each stream and of the session, in bytes.
+    // While the reader keeps up and RTT * rate exceeds a window, the window is
+    // doubled as long as it stays within its cap, so high-BDP paths reach full
+    // throughput and other connections keep small windows. QUIC's limits of
+    // 16 MB per stream and 24 MB per session bound larger caps. 0 keeps
+    // QUIC's initial window.
+    uint32_t max_stream_receive_window;
+    uint32_t max_session_receive_window;
+    // Reads packets with recvmmsg, and UDP GRO if kernel supports it, instead
+    // of one datagram per read. Only supported on Linux, ignored on other
+    // platforms. `max_packets_per_read` caps packets read before yielding to
+    // other tasks on IO thread, 0 means the default.
+    bool batch_packet_reads;
+    uint32_t max_packets_per_read;
+    // Emulates network conditions on packets sent by this client, see
+    // NetworkEmulationOptions. It's copied when the client is created.
+    // nullptr, the default value, sends packets as is.
+    const NetworkEmulationOptions* network_emulation;
   };
 
   class Visitor {
@@ -36,21 +116,81 @@ class OWT_EXPORT WebTransportClientInterface {
     virtual void OnDatagramProcessed(MessageStatus) = 0;
     // Called when the connection is closed.
     virtual void OnClosed(uint32_t code, const char* reason) = 0;
+    // Called when the value returned by GetMaxDatagramSize changes, e.g. when
+    // path MTU discovery finds a larger packet size.
+    virtual void OnMaxDatagramSizeChanged(size_t max_datagram_size) {}
   };
   virtual ~WebTransportClientInterface() = default;
   // Set a visitor for the client.
   virtual void SetVisitor(Visitor* visitor) = 0;
-  // Connect to a QUIC transport server. URL is specified during creation.
+  // Connect to a QUIC transport server. URL is specified during creation. It
+  // returns immediately, the result is delivered by Visitor's OnConnected or
+  // OnConnectionFailed.
   virtual void Connect() = 0;
   // Close WebTransport session with server.
   virtual void Close() = 0;
+  // Moves the connection to a new socket, e.g. after switching from Wi-Fi to
+  // cellular. The new path is validated before it's used, streams and
+  // datagrams keep flowing during migration. It's also tried automatically
+  // when reading from the current socket fails. No-op if the client is not
+  // connected.
+  virtual void MigrateConnection() = 0;
   // Create a bidirectional stream.
   virtual WebTransportStreamInterface* CreateBidirectionalStream() = 0;
   // Create an ougoing unidirectional stream.
   virtual WebTransportStreamInterface*
   CreateOutgoingUnidirectionalStream() = 0;
+  // Creates at most `count` streams in a single task on IO thread, and stores
+  // them in `streams`, which should have at least `count` elements. Returns
+  // the number of streams created, which could be less than `count` when
+  // stream limit is reached.
+  virtual size_t CreateBidirectionalStreams(
+      size_t count,
+      WebTransportStreamInterface** streams) = 0;
+  // Same as above, but creates outgoing unidirectional streams.
+  virtual size_t CreateOutgoingUnidirectionalStreams(
+      size_t count,
+      WebTransportStreamInterface** streams) = 0;
+  // Same as WebTransportSessionInterface::SetWarmStreamPoolSize. It could be
+  // called before Connect(), streams are opened once the client is connected.
+  virtual void SetWarmStreamPoolSize(size_t bidirectional,
+                                     size_t unidirectional) = 0;
+  // Same as WebTransportSessionInterface::AcquireStream.
+  virtual WebTransportStreamInterface* AcquireStream(bool bidirectional) = 0;
+  // Datagrams queued by congestion control for more than `max_time_ms`
+  // milliseconds are dropped, and reported as MessageStatus::kExpired by
+  // Visitor::OnDatagramProcessed. 0 restores QUIC's default, which is derived
+  // from RTT. It could be called before Connect(). It returns immediately.
+  virtual void SetMaxDatagramTimeInQueue(uint32_t max_time_ms) = 0;
+  // Sets the order of queued datagrams relative to stream data. It could be
+  // called before Connect(). It returns immediately.
+  virtual void SetDatagramPriority(DatagramPriority priority) = 0;
+  // Same as WebTransportSessionInterface::SetDatagramClasses. It could be
+  // called before Connect(). It returns immediately.
+  virtual void SetDatagramClasses(const DatagramClassOptions* classes,
+                                  size_t count) = 0;
+  // Same as WebTransportSessionInterface::SetMaxSendRate. It could be called
+  // before Connect(). It returns immediately.
+  virtual void SetMaxSendRate(uint64_t bits_per_second) = 0;
+  // Returns the max size of a datagram which fits in a packet of the current
+  // max packet size of the connection, or 0 before the client is connected.
+  // Larger datagrams are rejected with MessageStatus::kTooLarge. The value is
+  // cached by IO thread, so it doesn't block.
+  virtual size_t GetMaxDatagramSize() const = 0;
   // Send or queue datagram. Sending datagrams is unreliable.
   virtual MessageStatus SendOrQueueDatagram(uint8_t* data, size_t length) = 0;
+  // Same as above, but the ownership of `data` is transferred to the SDK, and
+  // it is not copied. `release` is called with `release_context` once the SDK
+  // no longer needs `data`. `release` could be nullptr.
+  virtual MessageStatus SendOrQueueDatagram(uint8_t* data,
+                                            size_t length,
+                                            BufferReleaseCallback release,
+                                            void* release_context) = 0;
+  // Same as WebTransportSessionInterface::SendOrQueuePrioritizedDatagram.
+  virtual MessageStatus SendOrQueuePrioritizedDatagram(
+      uint8_t* data,
+      size_t length,
+      uint32_t priority_class) = 0;
 };
 }  // namespace quic
 }  // namespace owt
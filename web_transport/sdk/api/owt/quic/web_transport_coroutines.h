@@ -0,0 +1,532 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+// Optional C++20 coroutine wrappers of the visitor based interfaces. This file
+// is header only, and it's empty when the compiler doesn't support coroutines,
+// so the SDK itself doesn't depend on C++20.
+//
+// Example:
+//   CoroutineSession session(session_interface, &executor);
+//   while (WebTransportStreamInterface* s = co_await session.AcceptStream()) {
+//     CoroutineStream stream(s, &executor);
+//     uint8_t buffer[4096];
+//     while (size_t length = co_await stream.Read(buffer, sizeof(buffer))) {
+//       if (!co_await stream.Write(buffer, length)) {
+//         break;
+//       }
+//     }
+//   }
+
+#ifndef OWT_WEB_TRANSPORT_WEB_TRANSPORT_COROUTINES_H_
+#define OWT_WEB_TRANSPORT_WEB_TRANSPORT_COROUTINES_H_
+
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L
+
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <utility>
+#include "owt/quic/web_transport_client_interface.h"
+#include "owt/quic/web_transport_server_interface.h"
+#include "owt/quic/web_transport_session_interface.h"
+#include "owt/quic/web_transport_stream_interface.h"
+
+namespace owt {
+namespace quic {
+
+// Resumes coroutines suspended by awaitables in this file. Visitor methods are
+// called on IO thread or event thread, an executor moves coroutines back to
+// the thread or event loop they belong to.
+class CoroutineExecutor {
+ public:
+  virtual ~CoroutineExecutor() = default;
+  // Called on IO thread or event thread. `handle` must be resumed once.
+  virtual void Post(std::coroutine_handle<> handle) = 0;
+};
+
+// Resumes coroutines on the thread calling visitor methods, which saves a
+// thread hop. Coroutines resumed by it must not block.
+class InlineCoroutineExecutor final : public CoroutineExecutor {
+ public:
+  void Post(std::coroutine_handle<> handle) override { handle.resume(); }
+};
+
+namespace internal {
+
+// Hands objects delivered by visitor methods to coroutines awaiting them, in
+// the order they are awaited. Awaiting a closed queue results in nullptr.
+template <typename T>
+class AwaitQueue {
+ public:
+  class Awaitable {
+   public:
+    explicit Awaitable(AwaitQueue* queue) : queue_(queue), result_(nullptr) {}
+    bool await_ready() const noexcept { return false; }
+    bool await_suspend(std::coroutine_handle<> handle) {
+      handle_ = handle;
+      return queue_->Wait(this);
+    }
+    T* await_resume() const noexcept { return result_; }
+
+   private:
+    friend class AwaitQueue;
+    AwaitQueue* queue_;
+    T* result_;
+    std::coroutine_handle<> handle_;
+  };
+
+  explicit AwaitQueue(CoroutineExecutor* executor)
+      : executor_(executor), closed_(false) {}
+  AwaitQueue(const AwaitQueue&) = delete;
+  AwaitQueue& operator=(const AwaitQueue&) = delete;
+
+  Awaitable Next() { return Awaitable(this); }
+
+  void Push(T* item) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (closed_) {
+      return;
+    }
+    if (waiters_.empty()) {
+      items_.push_back(item);
+      return;
+    }
+    Awaitable* waiter = waiters_.front();
+    waiters_.pop_front();
+    lock.unlock();
+    waiter->result_ = item;
+    executor_->Post(waiter->handle_);
+  }
+
+  // Items not taken yet are dropped, they're destroyed with their owner.
+  void Close() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    closed_ = true;
+    items_.clear();
+    std::deque<Awaitable*> waiters;
+    waiters.swap(waiters_);
+    lock.unlock();
+    for (Awaitable* waiter : waiters) {
+      executor_->Post(waiter->handle_);
+    }
+  }
+
+ private:
+  // Returns false if `waiter` gets its result without suspending.
+  bool Wait(Awaitable* waiter) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (closed_) {
+      return false;
+    }
+    if (!items_.empty()) {
+      waiter->result_ = items_.front();
+      items_.pop_front();
+      return false;
+    }
+    waiters_.push_back(waiter);
+    return true;
+  }
+
+  CoroutineExecutor* executor_;
+  std::mutex mutex_;
+  bool closed_;
+  std::deque<T*> items_;
+  std::deque<Awaitable*> waiters_;
+};
+
+}  // namespace internal
+
+// Wraps a stream for coroutines. It becomes the stream's visitor, so another
+// visitor or push mode must not be set. Only one Read could be awaited at a
+// time. Writes could be awaited from one coroutine or sequence concurrently,
+// they complete in order. It must be destroyed before the stream is closed,
+// or after its awaitables complete because of it.
+class CoroutineStream final : public WebTransportStreamInterface::Visitor {
+ public:
+  class ReadAwaitable {
+   public:
+    ReadAwaitable(CoroutineStream* stream, uint8_t* data, size_t length)
+        : stream_(stream), data_(data), length_(length), result_(0) {}
+    bool await_ready() const noexcept { return false; }
+    bool await_suspend(std::coroutine_handle<> handle) {
+      handle_ = handle;
+      return !stream_->TryRead(this);
+    }
+    // Number of bytes read. 0 if all incoming data is read, or the stream is
+    // closed.
+    size_t await_resume() const noexcept { return result_; }
+
+   private:
+    friend class CoroutineStream;
+    CoroutineStream* stream_;
+    uint8_t* data_;
+    size_t length_;
+    size_t result_;
+    std::coroutine_handle<> handle_;
+  };
+
+  class WriteAwaitable {
+   public:
+    WriteAwaitable(CoroutineStream* stream, const uint8_t* data, size_t length)
+        : stream_(stream), data_(data), length_(length), result_(false) {}
+    bool await_ready() const noexcept { return false; }
+    bool await_suspend(std::coroutine_handle<> handle) {
+      handle_ = handle;
+      return stream_->StartWrite(this);
+    }
+    // True if data is written or buffered by the QUIC stream.
+    bool await_resume() const noexcept { return result_; }
+
+   private:
+    friend class CoroutineStream;
+    CoroutineStream* stream_;
+    const uint8_t* data_;
+    size_t length_;
+    bool result_;
+    std::coroutine_handle<> handle_;
+  };
+
+  CoroutineStream(WebTransportStreamInterface* stream,
+                  CoroutineExecutor* executor)
+      : stream_(stream),
+        executor_(executor),
+        read_events_(0),
+        fin_read_(false),
+        closed_(false),
+        pending_read_(nullptr) {
+    stream_->SetVisitor(this);
+  }
+  ~CoroutineStream() override {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!closed_) {
+      lock.unlock();
+      stream_->SetVisitor(nullptr);
+    }
+  }
+  CoroutineStream(const CoroutineStream&) = delete;
+  CoroutineStream& operator=(const CoroutineStream&) = delete;
+
+  WebTransportStreamInterface* stream() const { return stream_; }
+
+  // Reads at most `length` bytes into `data`, which must be valid until the
+  // read completes. It completes once some data is available.
+  ReadAwaitable Read(uint8_t* data, size_t length) {
+    return ReadAwaitable(this, data, length);
+  }
+  // Queues `data` by WriteAsync, so it's copied and could be released once
+  // this method returns. It completes when Visitor::OnWriteCompleted is called
+  // for it.
+  WriteAwaitable Write(const uint8_t* data, size_t length) {
+    return WriteAwaitable(this, data, length);
+  }
+
+  // WebTransportStreamInterface::Visitor.
+  void OnCanRead() override { ResumeRead(/*fin=*/false); }
+  void OnCanWrite() override {}
+  void OnFinRead() override { ResumeRead(/*fin=*/true); }
+  void OnWriteCompleted(size_t length, bool success) override {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (pending_writes_.empty()) {
+      return;
+    }
+    WriteAwaitable* write = pending_writes_.front();
+    pending_writes_.pop_front();
+    lock.unlock();
+    write->result_ = success;
+    executor_->Post(write->handle_);
+  }
+  void OnClosed() override {
+    std::unique_lock<std::mutex> lock(mutex_);
+    closed_ = true;
+    ReadAwaitable* read = std::exchange(pending_read_, nullptr);
+    std::deque<WriteAwaitable*> writes;
+    writes.swap(pending_writes_);
+    lock.unlock();
+    // `this` could be destroyed by resumed coroutines.
+    CoroutineExecutor* executor = executor_;
+    if (read) {
+      read->result_ = 0;
+      executor->Post(read->handle_);
+    }
+    for (WriteAwaitable* write : writes) {
+      write->result_ = false;
+      executor->Post(write->handle_);
+    }
+  }
+
+ private:
+  // Returns true if `read` is completed. Otherwise it's kept until more data
+  // or FIN arrives. Read() is called without holding `mutex_` because it may
+  // call visitor methods.
+  bool TryRead(ReadAwaitable* read) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+      if (closed_) {
+        read->result_ = 0;
+        return true;
+      }
+      const uint64_t read_events = read_events_;
+      lock.unlock();
+      read->result_ = stream_->Read(read->data_, read->length_);
+      lock.lock();
+      if (read->result_ > 0 || fin_read_) {
+        return true;
+      }
+      if (read_events == read_events_) {
+        pending_read_ = read;
+        return false;
+      }
+    }
+  }
+
+  void ResumeRead(bool fin) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    read_events_++;
+    fin_read_ = fin_read_ || fin;
+    ReadAwaitable* read = std::exchange(pending_read_, nullptr);
+    lock.unlock();
+    if (read && TryRead(read)) {
+      executor_->Post(read->handle_);
+    }
+  }
+
+  // Returns false if `write` is completed without suspending.
+  bool StartWrite(WriteAwaitable* write) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (closed_) {
+      write->result_ = false;
+      return false;
+    }
+    pending_writes_.push_back(write);
+    lock.unlock();
+    stream_->WriteAsync(write->data_, write->length_);
+    return true;
+  }
+
+  WebTransportStreamInterface* stream_;
+  CoroutineExecutor* executor_;
+  std::mutex mutex_;
+  // Increased by every OnCanRead and OnFinRead, so TryRead knows whether new
+  // data arrived during Read().
+  uint64_t read_events_;
+  bool fin_read_;
+  bool closed_;
+  ReadAwaitable* pending_read_;
+  std::deque<WriteAwaitable*> pending_writes_;
+};
+
+// Wraps a session for coroutines. It becomes the session's visitor, visitor
+// methods not used by it are forwarded to `delegate`, which could be nullptr.
+class CoroutineSession final : public WebTransportSessionInterface::Visitor {
+ public:
+  using AcceptStreamAwaitable =
+      internal::AwaitQueue<WebTransportStreamInterface>::Awaitable;
+
+  CoroutineSession(WebTransportSessionInterface* session,
+                   CoroutineExecutor* executor,
+                   WebTransportSessionInterface::Visitor* delegate = nullptr)
+      : session_(session), delegate_(delegate), incoming_streams_(executor) {
+    session_->SetVisitor(this);
+  }
+  ~CoroutineSession() override = default;
+  CoroutineSession(const CoroutineSession&) = delete;
+  CoroutineSession& operator=(const CoroutineSession&) = delete;
+
+  WebTransportSessionInterface* session() const { return session_; }
+
+  // Completes with the next incoming stream, or nullptr after the connection
+  // is closed. Multiple coroutines could await it at the same time.
+  AcceptStreamAwaitable AcceptStream() { return incoming_streams_.Next(); }
+
+  // WebTransportSessionInterface::Visitor.
+  void OnIncomingStream(WebTransportStreamInterface* stream) override {
+    incoming_streams_.Push(stream);
+  }
+  void OnCanCreateNewOutgoingStream(bool unidirectional) override {
+    if (delegate_) {
+      delegate_->OnCanCreateNewOutgoingStream(unidirectional);
+    }
+  }
+  void OnConnectionClosed() override {
+    if (delegate_) {
+      delegate_->OnConnectionClosed();
+    }
+    incoming_streams_.Close();
+  }
+  void OnDatagramReceived(const uint8_t* data, size_t length) override {
+    if (delegate_) {
+      delegate_->OnDatagramReceived(data, length);
+    }
+  }
+  void OnDatagramsReceived(const Datagram* datagrams, size_t count) override {
+    if (delegate_) {
+      delegate_->OnDatagramsReceived(datagrams, count);
+    }
+  }
+  void OnDatagramProcessed(MessageStatus status) override {
+    if (delegate_) {
+      delegate_->OnDatagramProcessed(status);
+    }
+  }
+  void OnBandwidthEstimateUpdated(uint64_t bandwidth_bps,
+                                  uint64_t smoothed_rtt_us) override {
+    if (delegate_) {
+      delegate_->OnBandwidthEstimateUpdated(bandwidth_bps, smoothed_rtt_us);
+    }
+  }
+
+ private:
+  WebTransportSessionInterface* session_;
+  WebTransportSessionInterface::Visitor* delegate_;
+  internal::AwaitQueue<WebTransportStreamInterface> incoming_streams_;
+};
+
+// Wraps a client for coroutines. It becomes the client's visitor, visitor
+// methods not used by it are forwarded to `delegate`, which could be nullptr.
+class CoroutineClient final : public WebTransportClientInterface::Visitor {
+ public:
+  using AcceptStreamAwaitable =
+      internal::AwaitQueue<WebTransportStreamInterface>::Awaitable;
+
+  class ConnectAwaitable {
+   public:
+    explicit ConnectAwaitable(CoroutineClient* client)
+        : client_(client), result_(false) {}
+    bool await_ready() const noexcept { return false; }
+    bool await_suspend(std::coroutine_handle<> handle) {
+      handle_ = handle;
+      return client_->StartConnect(this);
+    }
+    // True if connected.
+    bool await_resume() const noexcept { return result_; }
+
+   private:
+    friend class CoroutineClient;
+    CoroutineClient* client_;
+    bool result_;
+    std::coroutine_handle<> handle_;
+  };
+
+  CoroutineClient(WebTransportClientInterface* client,
+                  CoroutineExecutor* executor,
+                  WebTransportClientInterface::Visitor* delegate = nullptr)
+      : client_(client),
+        executor_(executor),
+        delegate_(delegate),
+        pending_connect_(nullptr),
+        incoming_streams_(executor) {
+    client_->SetVisitor(this);
+  }
+  ~CoroutineClient() override = default;
+  CoroutineClient(const CoroutineClient&) = delete;
+  CoroutineClient& operator=(const CoroutineClient&) = delete;
+
+  WebTransportClientInterface* client() const { return client_; }
+
+  // Connects to the server. It should be awaited once.
+  ConnectAwaitable Connect() { return ConnectAwaitable(this); }
+  // Completes with the next incoming stream, or nullptr after the connection
+  // is closed.
+  AcceptStreamAwaitable AcceptStream() { return incoming_streams_.Next(); }
+
+  // WebTransportClientInterface::Visitor.
+  void OnConnected() override {
+    if (delegate_) {
+      delegate_->OnConnected();
+    }
+    CompleteConnect(true);
+  }
+  void OnConnectionFailed() override {
+    if (delegate_) {
+      delegate_->OnConnectionFailed();
+    }
+    incoming_streams_.Close();
+    CompleteConnect(false);
+  }
+  void OnIncomingStream(WebTransportStreamInterface* stream) override {
+    incoming_streams_.Push(stream);
+  }
+  void OnDatagramProcessed(MessageStatus status) override {
+    if (delegate_) {
+      delegate_->OnDatagramProcessed(status);
+    }
+  }
+  void OnClosed(uint32_t code, const char* reason) override {
+    if (delegate_) {
+      delegate_->OnClosed(code, reason);
+    }
+    incoming_streams_.Close();
+    CompleteConnect(false);
+  }
+
+ private:
+  bool StartConnect(ConnectAwaitable* connect) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      pending_connect_ = connect;
+    }
+    client_->Connect();
+    return true;
+  }
+
+  void CompleteConnect(bool connected) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    ConnectAwaitable* connect = std::exchange(pending_connect_, nullptr);
+    lock.unlock();
+    if (connect) {
+      connect->result_ = connected;
+      executor_->Post(connect->handle_);
+    }
+  }
+
+  WebTransportClientInterface* client_;
+  CoroutineExecutor* executor_;
+  WebTransportClientInterface::Visitor* delegate_;
+  std::mutex mutex_;
+  ConnectAwaitable* pending_connect_;
+  internal::AwaitQueue<WebTransportStreamInterface> incoming_streams_;
+};
+
+// Wraps a server for coroutines. It becomes the server's visitor.
+class CoroutineServer final : public WebTransportServerInterface::Visitor {
+ public:
+  using AcceptSessionAwaitable =
+      internal::AwaitQueue<WebTransportSessionInterface>::Awaitable;
+
+  CoroutineServer(WebTransportServerInterface* server,
+                  CoroutineExecutor* executor)
+      : server_(server), incoming_sessions_(executor) {
+    server_->SetVisitor(this);
+  }
+  ~CoroutineServer() override = default;
+  CoroutineServer(const CoroutineServer&) = delete;
+  CoroutineServer& operator=(const CoroutineServer&) = delete;
+
+  WebTransportServerInterface* server() const { return server_; }
+
+  // Completes with the next session, or nullptr after the server is ended.
+  // Multiple coroutines could await it at the same time.
+  AcceptSessionAwaitable AcceptSession() { return incoming_sessions_.Next(); }
+
+  // WebTransportServerInterface::Visitor.
+  void OnEnded() override { incoming_sessions_.Close(); }
+  void OnSession(WebTransportSessionInterface* session) override {
+    incoming_sessions_.Push(session);
+  }
+
+ private:
+  WebTransportServerInterface* server_;
+  internal::AwaitQueue<WebTransportSessionInterface> incoming_sessions_;
+};
+
+}  // namespace quic
+}  // namespace owt
+
+#endif
+
+#endif
@@ -15,17 +15,368 @@
 #ifndef OWT_WEB_TRANSPORT_WEB_TRANSPORT_DEFINITIONS_H_
 #define OWT_WEB_TRANSPORT_WEB_TRANSPORT_DEFINITIONS_H_
 
+#include <cstddef>
 #include <cstdint>
 #include "owt/quic/export.h"
 
 namespace owt {
 namespace quic {
 
-// Stats for a QUIC connection.
+class WebTransportSessionInterface;
+
+// Stats for a QUIC connection. All fields are 64 bits.
 // Ref: net/third_party/quiche/src/quic/core/quic_connection_stats.h.
 struct OWT_EXPORT ConnectionStats {
   // Estimated bandwidth in bit per second.
   uint64_t estimated_bandwidth;
+  // Bytes of outgoing data buffered by all streams of a session.
+  uint64_t buffered_send_bytes;
+  // Smoothed RTT in microseconds.
+  uint64_t smoothed_rtt_us;
+  // Min RTT in microseconds.
+  uint64_t min_rtt_us;
+  // Congestion window in bytes.
+  uint64_t congestion_window;
+  uint64_t bytes_in_flight;
+  uint64_t packets_sent;
+  uint64_t packets_lost;
+  uint64_t packets_retransmitted;
+  // Pacing rate in bit per second.
+  uint64_t pacing_rate;
+  // Number of outgoing datagrams failed to send or expired in queue.
+  uint64_t datagrams_dropped;
+  // Number of times the client's address changed, e.g. by NAT rebinding.
+  uint64_t peer_migrations;
+};
+
+// Statistics of a server, or one of its IO threads. Counters accumulate since
+// the server is started. All fields are 64 bits.
+struct OWT_EXPORT ServerStats {
+  // QUIC connections currently open.
+  uint64_t active_sessions;
+  // QUIC connections accepted.
+  uint64_t sessions_created;
+  // Connections accepted per second, measured over the last second.
+  uint64_t handshakes_per_second;
+  // Read passes which ended with CHLOs still buffered, because new
+  // connections were held back to keep up with established ones.
+  uint64_t chlo_backlog_passes;
+  uint64_t packets_received;
+  uint64_t bytes_received;
+  uint64_t packets_sent;
+  uint64_t bytes_sent;
+  // Received packets dropped by kernel because the socket receive buffer is
+  // full (Linux only), and packets failed to write.
+  uint64_t packets_dropped;
+  // Number of writes blocked by a full socket send buffer.
+  uint64_t write_blocked_events;
+  // Percentage of the last second an IO thread spent reading and processing
+  // packets. For a whole server, it's the value of its busiest IO thread.
+  uint64_t loop_utilization_percent;
+  // Client address changes accepted by connections. New addresses are
+  // validated before they carry more than 3 times the data received from
+  // them. Port-only changes, usually NAT rebinding, keep congestion state and
+  // are also counted by `peer_port_changes`.
+  uint64_t peer_migrations;
+  uint64_t peer_port_changes;
+  // Received datagrams marked ECN capable, ECT(0) or ECT(1), and marked
+  // congestion experienced (CE) by the network (Linux only). QUIC congestion
+  // control doesn't react to CE marks, they indicate queueing on the path.
+  uint64_t ect_packets_received;
+  uint64_t ce_packets_received;
+  // Load shedding, see WebTransportServerInterface::Options::
+  // overload_queue_delay_ms. Times an IO thread became overloaded, new
+  // connections rejected and received datagrams dropped while overloaded.
+  uint64_t overload_events;
+  uint64_t connections_rejected;
+  uint64_t datagrams_shed;
+  // Stateless retry, see WebTransportServerInterface::Options::
+  // retry_chlo_rate_threshold. RETRY packets sent, and Initial packets with
+  // tokens which are invalid or expired.
+  uint64_t retries_sent;
+  uint64_t invalid_retry_tokens;
+  // Longest wait of a task in the queue of an IO thread or an event thread,
+  // measured by the last probes, in milliseconds. For a whole server, it's the
+  // value of its most delayed IO thread. 0 if load shedding is disabled.
+  uint64_t max_queue_delay_ms;
+};
+
+// Memory held by sessions, in bytes unless noted otherwise. All fields are 64
+// bits.
+struct OWT_EXPORT MemoryUsage {
+  // Number of sessions and streams counted.
+  uint64_t sessions;
+  uint64_t streams;
+  // Outgoing data buffered by streams, including data waiting to be handed to
+  // QUIC streams.
+  uint64_t stream_send_buffer_bytes;
+  // Received data not read by the application yet.
+  uint64_t stream_receive_buffer_bytes;
+  // Capacity of buffers holding received datagrams for event threads.
+  uint64_t datagram_buffer_bytes;
+  // Number of outgoing datagrams queued by congestion control.
+  uint64_t queued_datagrams;
+  // Size of session and stream objects, excluding memory they allocate.
+  uint64_t object_bytes;
+  // Sum of all byte fields above.
+  uint64_t total_bytes;
+};
+
+// Thread time spent on a session's QUIC connection, in microseconds. Sessions
+// pooled on the same connection share it. See
+// WebTransportServerInterface::GetTopSessionsByCpu.
+struct OWT_EXPORT SessionCpuUsage {
+  // Longest connection ID string plus the terminating null character.
+  static constexpr size_t kConnectionIdSize = 41;
+  // Same as WebTransportSessionInterface::ConnectionId().
+  char connection_id[kConnectionIdSize];
+  // Index of the IO thread owning the connection.
+  uint32_t io_thread_index;
+  // Time on the IO thread processing packets, timers and writes of the
+  // connection, including visitor callbacks called on the IO thread, since the
+  // connection is created.
+  uint64_t io_time_us;
+  // Time on event threads running visitor callbacks of the connection's
+  // sessions since the connection is created, i.e.: datagram callbacks.
+  // Stream visitor callbacks are called on the IO thread, and counted in
+  // `io_time_us`.
+  uint64_t event_time_us;
+  // IO and event thread time of the last second, which sessions are ranked
+  // by.
+  uint64_t recent_time_us;
+};
+
+// Called when the SDK no longer needs a buffer whose ownership is transferred
+// to the SDK. `data` and `length` describe the buffer, `context` is the value
+// passed along with the buffer. It may be called on any thread.
+using BufferReleaseCallback = void (*)(uint8_t* data,
+                                       size_t length,
+                                       void* context);
+
+// Runs tasks of the SDK on a thread owned by the application, e.g. the thread
+// of its own event loop. Tasks must run sequentially on the same thread, in
+// the order they become due, and each of them exactly once.
+class OWT_EXPORT EventExecutorInterface {
+ public:
+  using Task = void (*)(void* context);
+  virtual ~EventExecutorInterface() = default;
+  // Runs `task` with `context` after `delay_ms` milliseconds. It may be called
+  // on any thread.
+  virtual void PostTask(Task task, void* context, uint64_t delay_ms) = 0;
+  // Returns true if it's called on the thread running tasks.
+  virtual bool IsCurrentThread() const = 0;
+};
+
+// A piece of data to be written, similar to struct iovec.
+struct OWT_EXPORT IoVec {
+  const uint8_t* data;
+  size_t length;
+};
+
+// A datagram to be sent.
+struct OWT_EXPORT Datagram {
+  const uint8_t* data;
+  size_t length;
+};
+
+// A destination of broadcast data.
+struct OWT_EXPORT BroadcastTarget {
+  WebTransportSessionInterface* session;
+  // Data is sent as a datagram if it's true, otherwise it's written to
+  // `session`'s stream with `stream_id`.
+  bool datagram;
+  uint32_t stream_id;
+};
+
+// Congestion control algorithm of a QUIC connection.
+enum class CongestionControlType {
+  // BBRv1, the algorithm used by all connections in earlier versions.
+  kDefault,
+  kCubic,
+  kReno,
+  kBbr,
+  kBbrV2,
+};
+
+// Tuning of congestion control for a kind of traffic.
+enum class CongestionProfile {
+  // Algorithms selected by CongestionControlType with their default tuning.
+  kDefault,
+  // For interactive media. Uses BBRv2 regardless of CongestionControlType,
+  // leaves STARTUP after one round without bandwidth growth, keeps cwnd close
+  // to bandwidth times min RTT, and shrinks PROBE_RTT to half of that instead
+  // of 4 packets, skipping it when quiet periods already measured min RTT.
+  // Sending stays paced, and rounds with nothing to send are signalled as
+  // app-limited so they don't lower bandwidth estimates.
+  kRealtime,
+};
+
+// Order of datagrams queued by congestion control relative to stream data.
+enum class DatagramPriority {
+  // QUIC's default order. Once the connection becomes writable, lost stream
+  // data is retransmitted first, then queued datagrams are sent before new
+  // stream data.
+  kDefault,
+  // Queued datagrams are sent before lost stream data is retransmitted as
+  // well, e.g.: audio datagrams of a session sending video over streams on a
+  // lossy network. Datagrams of a session with this priority are not dropped
+  // when event threads are overloaded.
+  kAboveStreams,
+};
+
+// What a priority class of the SDK's datagram queue drops when it's full.
+enum class DatagramDropPolicy {
+  // New datagrams are rejected with MessageStatus::kQueueFull.
+  kTailDrop,
+  // The oldest datagram of the class is dropped to make room for the new one,
+  // e.g.: enhancement layers superseded by newer frames.
+  kDropOldest,
+};
+
+// A priority class of the SDK's datagram queue, see
+// WebTransportSessionInterface::SetDatagramClasses.
+struct OWT_EXPORT DatagramClassOptions {
+  DatagramClassOptions()
+      : max_queued_datagrams(0),
+        drop_policy(DatagramDropPolicy::kTailDrop),
+        max_age_ms(0) {}
+  // Max number of datagrams queued in the class. Default value is 64.
+  uint32_t max_queued_datagrams;
+  DatagramDropPolicy drop_policy;
+  // Datagrams queued for longer than this are dropped instead of sent, and
+  // reported as MessageStatus::kExpired. 0 means no limit.
+  uint32_t max_age_ms;
+};
+
+// Whether a server accepts 0-RTT data sent by clients resuming TLS sessions.
+// 0-RTT data is not protected against replay by TLS.
+enum class EarlyDataPolicy {
+  // 0-RTT data is rejected, resumed sessions take 1-RTT handshakes.
+  kReject,
+  // 0-RTT data is accepted, but each session ticket is only accepted once by
+  // a server. Replayed tickets fall back to full handshakes. Tickets are not
+  // tracked across servers.
+  kAcceptSingleUseTickets,
+  // 0-RTT data is accepted. Applications must tolerate replayed data.
+  kAccept,
+};
+
+// Threads started by the SDK. Threads of a kind are numbered from 0.
+enum class SdkThread {
+  // Index 0 is the factory's IO thread, which runs all clients and the first
+  // IO thread of each server. Index N is the Nth extra IO thread of each
+  // server, see WebTransportServerInterface::SetIoThreadCount.
+  kIo,
+  // Index 0 is the factory's event thread. Index N is the Nth extra event
+  // thread of each server, see WebTransportServerInterface::Options::
+  // event_thread_count.
+  kEvent,
+  // Threads computing handshake signatures of each server, see
+  // WebTransportServerInterface::Options::signing_thread_count.
+  kSigning,
+};
+
+// Scheduling priority of a thread. Raising it may require privileges, e.g.:
+// CAP_SYS_NICE or RLIMIT_RTPRIO on Linux. Failures are logged, and the thread
+// keeps running with its previous priority.
+enum class ThreadPriority {
+  kDefault,
+  // Preferred over normal threads, e.g.: nice -8 on Linux.
+  kHigh,
+  // A real-time scheduling policy, e.g.: SCHED_RR on Linux. A busy real-time
+  // thread starves normal threads on its CPUs.
+  kRealtime,
+};
+
+struct OWT_EXPORT ThreadSchedulingOptions {
+  ThreadSchedulingOptions()
+      : cpus(nullptr),
+        cpu_count(0),
+        numa_node(-1),
+        priority(ThreadPriority::kDefault) {}
+  // CPUs the thread is allowed to run on. Both 0 keep the OS default.
+  const uint32_t* cpus;
+  size_t cpu_count;
+  // Restricts the thread to CPUs of this NUMA node, and to `cpus` as well if
+  // it's set. Memory the thread allocates afterwards is then local to the
+  // node by the OS's first touch policy. -1 means any node. Linux only.
+  int32_t numa_node;
+  ThreadPriority priority;
+};
+
+// Describes server connection IDs which can be routed by a load balancer to
+// this server, as specified by draft-ietf-quic-load-balancers. A connection ID
+// is a first octet, `server_id` and a nonce.
+struct OWT_EXPORT ConnectionIdRoutingConfig {
+  // 0 - 6.
+  uint8_t config_id;
+  const uint8_t* server_id;
+  size_t server_id_length;
+  // A 16 bytes AES-128 key, or nullptr if connection IDs are not encrypted.
+  // Encrypted connection IDs are always 17 bytes.
+  const uint8_t* key;
+  // Length of connection IDs, including the first octet. It must not be 8,
+  // the default length of connection IDs chosen by clients.
+  uint8_t connection_id_length;
+};
+
+// Decides whether a connection is logged by qlog. It's called on IO threads
+// when a connection is created, so it must not block.
+using QlogFilter = bool (*)(const char* peer_address,
+                            const char* connection_id,
+                            void* context);
+
+// Options of qlog output. Each logged connection is written to its own file
+// under `directory` in JSON-SEQ format (draft-ietf-quic-qlog-main-schema),
+// named by its server connection ID. Events are serialized on IO threads and
+// written to files by a background thread.
+struct OWT_EXPORT QlogOptions {
+  // Created if it doesn't exist.
+  const char* directory;
+  // Fraction of connections logged, 0.0 - 1.0. e.g.: 0.01 logs 1% of
+  // connections.
+  double sampling_rate;
+  // Connections `filter` returns true for are always logged, other
+  // connections are sampled by `sampling_rate`. It could be nullptr.
+  QlogFilter filter;
+  void* filter_context;
+};
+
+// Impairments applied to packets a server or client sends, for tests and
+// benchmarks under realistic network conditions. Packets are held in memory
+// until they're due, and then written to the socket, so both ends of a path
+// should be configured for symmetric conditions. Runs with the same `seed`
+// and traffic drop and reorder the same packets. Never use it in production.
+struct OWT_EXPORT NetworkEmulationOptions {
+  NetworkEmulationOptions()
+      : delay_ms(0),
+        jitter_ms(0),
+        loss_rate(0),
+        burst_loss_rate(0),
+        burst_length(0),
+        reorder_rate(0),
+        bandwidth_bps(0),
+        queue_bytes(0),
+        seed(0) {}
+  // One way delay added to each packet. Each packet is delayed by up to
+  // `jitter_ms` more, jitter alone doesn't reorder packets.
+  uint32_t delay_ms;
+  uint32_t jitter_ms;
+  // Probability a packet is dropped, 0.0 - 1.0.
+  double loss_rate;
+  // Probability a burst loss starts at a packet, 0.0 - 1.0. Bursts drop
+  // `burst_length` consecutive packets on average, 0 means 1.
+  double burst_loss_rate;
+  uint32_t burst_length;
+  // Probability a packet skips the delay, so it arrives before packets sent
+  // earlier, 0.0 - 1.0.
+  double reorder_rate;
+  // Rate of the bottleneck link, in bits per second. 0 is unlimited.
+  uint64_t bandwidth_bps;
+  // Packets arriving when the link's queue has more than this many bytes are
+  // dropped. 0 is unlimited. Ignored when bandwidth is unlimited.
+  uint32_t queue_bytes;
+  uint64_t seed;
 };
 
 // Hash function algorithm and certificate fingerprint as described in RFC4572.
@@ -56,9 +407,15 @@ enum class MessageStatus {
   kTooLarge,
   // Failed to send message because connection reaches an invalid state.
   kInternalError,
+  // Message was queued, but dropped because it stayed in the queue for too
+  // long.
+  kExpired,
   // Message status is not available. When C++17 std::optional is enabled, this
   // value will be removed.
-  kUnavailable
+  kUnavailable,
+  // Message was not queued because its priority class of the SDK's datagram
+  // queue is full.
+  kQueueFull
 };
 
 }  // namespace quic
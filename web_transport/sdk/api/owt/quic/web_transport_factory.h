@@ -9,22 +9,37 @@
 
 #include "owt/quic/export.h"
 #include "owt/quic/web_transport_client_interface.h"
+#include "owt/quic/web_transport_server_interface.h"
 
 namespace owt {
 namespace quic {
 
-class WebTransportServerInterface;
 class WebTransportClientInterface;
 
 class OWT_EXPORT WebTransportFactory {
  public:
   virtual ~WebTransportFactory() = default;
 
-  /// Create a WebTransportFactory.
+  /// Create a WebTransportFactory. Process wide state is initialized by the
+  /// first factory, and threads are started when the first server or client
+  /// is created.
   static WebTransportFactory* Create();
   /// Create a WebTransportFactory for testing. It will not initialize
   /// AtExitManager since testing tools will initialize one.
   static WebTransportFactory* CreateForTesting();
+  // Delivers events of servers and clients created after this call with
+  // `executor` instead of the factory's event thread, which is stopped.
+  // `executor` must outlive this factory and everything created by it. It must
+  // be called before creating any server or client.
+  virtual void SetEventExecutor(EventExecutorInterface* executor) = 0;
+  // Sets CPU affinity and priority of the `index`th SDK thread of `thread`
+  // kind, e.g.: pinning IO threads to CPUs of the NIC's NUMA node avoids
+  // migrating them across sockets. It applies to threads of servers created
+  // after this call, and to the factory's own threads immediately if they are
+  // started. `options` is copied.
+  virtual void SetThreadScheduling(SdkThread thread,
+                                   size_t index,
+                                   const ThreadSchedulingOptions& options) = 0;
   // Create a WebTransport over HTTP/3 server with certificate, key and secret
   // file. Ownership of returned value is moved to caller. Returns nullptr if
   // creation is failed.
@@ -39,8 +54,22 @@ class OWT_EXPORT WebTransportFactory {
       int port,
       const char* pfx_path,
       const char* password) = 0;
+  // Same as above, but the server is created with `options`.
+  virtual WebTransportServerInterface* CreateWebTransportServer(
+      int port,
+      const char* cert_path,
+      const char* key_path,
+      const char* secret_path,
+      const WebTransportServerInterface::Options& options) = 0;
+  virtual WebTransportServerInterface* CreateWebTransportServer(
+      int port,
+      const char* pfx_path,
+      const char* password,
+      const WebTransportServerInterface::Options& options) = 0;
   // Create a WebTransport over HTTP/3 client. It will not connect to the given
-  // `url` immediately after creation.
+  // `url` immediately after creation. Clients created by the same factory run
+  // on its IO thread and share one host resolver, certificate verifier and
+  // QUIC configuration, they must be deleted before the factory.
   virtual WebTransportClientInterface* CreateWebTransportClient(
       const char* url) = 0;
   // Create a WebTransport over HTTP/3 client with parameters. It will not
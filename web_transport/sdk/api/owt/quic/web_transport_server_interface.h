@@ -15,6 +15,187 @@ namespace quic {
 // A server accepts WebTransport connections.
 class OWT_EXPORT WebTransportServerInterface {
  public:
+  // Length of each session ticket key, in bytes.
+  static constexpr size_t kSessionTicketKeyLength = 32;
+  // Length of each address token key, in bytes.
+  static constexpr size_t kAddressTokenKeyLength = 32;
+  // Options applied when a server is created. 0 means the default value.
+  struct Options {
+    Options()
+        : socket_receive_buffer_size(0),
+          socket_send_buffer_size(0),
+          initial_stream_flow_control_window(0),
+          initial_session_flow_control_window(0),
+          max_incoming_bidirectional_streams(0),
+          max_incoming_unidirectional_streams(0),
+          idle_timeout_ms(0),
+          keepalive_interval_ms(0),
+          max_packets_per_read(0),
+          max_new_connections_per_read(0),
+          congestion_control(CongestionControlType::kDefault),
+          event_thread_count(0),
+          inline_event_dispatch(false),
+          signing_thread_count(0),
+          session_ticket_keys(nullptr),
+          session_ticket_key_count(0),
+          early_data_policy(EarlyDataPolicy::kReject),
+          retry_chlo_rate_threshold(0),
+          address_token_keys(nullptr),
+          address_token_key_count(0),
+          compressed_certificate_cache_size(0),
+          pooled_send_buffers(false),
+          numa_local_buffers(false),
+          huge_page_buffers(false),
+          enable_mtu_discovery(false),
+          enable_ack_frequency(false),
+          ack_eliciting_threshold(0),
+          max_ack_delay_ms(0),
+          overload_queue_delay_ms(0),
+          disable_qpack_dynamic_table(false),
+          qpack_dynamic_table_capacity(0),
+          qpack_blocked_streams(0),
+          accepted_origins(nullptr),
+          accepted_origin_count(0),
+          top_sessions_by_cpu(0),
+          network_emulation(nullptr) {}
+    // Sizes of each UDP socket's kernel buffers, in bytes. The kernel may cap
+    // them, e.g. by net.core.rmem_max on Linux.
+    size_t socket_receive_buffer_size;
+    size_t socket_send_buffer_size;
+    // Flow control windows advertised to clients, in bytes.
+    uint32_t initial_stream_flow_control_window;
+    uint32_t initial_session_flow_control_window;
+    // Max number of streams a client could open concurrently. HTTP/3 uses 3
+    // unidirectional streams for control and QPACK, so it must be at least 3
+    // more than the number of unidirectional WebTransport streams expected.
+    uint32_t max_incoming_bidirectional_streams;
+    uint32_t max_incoming_unidirectional_streams;
+    // A connection is closed if it has no network activity for this period.
+    uint32_t idle_timeout_ms;
+    // When it's not 0, the server sends a PING on a connection after every
+    // period of this length in which nothing is received, so a live client's
+    // ACKs keep the connection active, and a dead client is detected by
+    // `idle_timeout_ms`, which should be a few intervals. Once the idle
+    // timeout expires, the connection is closed and visitors are notified.
+    uint32_t keepalive_interval_ms;
+    // Upper bounds of each IO thread's read budgets. Max number of packets
+    // read, and max number of new connections created, before yielding to
+    // other tasks. Actual budgets adapt to load below these bounds, new
+    // connections are held back when established ones fall behind.
+    uint32_t max_packets_per_read;
+    uint32_t max_new_connections_per_read;
+    // Congestion control algorithm of connections. A client could ask for
+    // another one for its session with QUIC connection options.
+    CongestionControlType congestion_control;
+    // Number of threads running session and stream visitor callbacks. Each
+    // session is pinned to one of them, so callbacks of a session are never
+    // called concurrently, but callbacks of different sessions could be.
+    // Default value is 1.
+    size_t event_thread_count;
+    // Calls session and stream visitor methods directly on the session's IO
+    // thread instead of posting them to an event thread, which saves a thread
+    // hop per event. Visitors must not block. `event_thread_count` is ignored
+    // when it's true.
+    bool inline_event_dispatch;
+    // Number of threads computing handshake signatures with the server's
+    // private key, so a burst of handshakes doesn't delay packets of
+    // established sessions. 0 means signatures are computed on IO threads.
+    size_t signing_thread_count;
+    // `session_ticket_key_count` keys of kSessionTicketKeyLength bytes stored
+    // in `session_ticket_keys`, which encrypt TLS session tickets issued to
+    // clients. New tickets are encrypted with the first key, tickets encrypted
+    // with any of them are accepted. Servers behind the same load balancer
+    // should share keys. Session resumption is disabled when there is no key.
+    const uint8_t* session_ticket_keys;
+    size_t session_ticket_key_count;
+    // Ignored when session resumption is disabled.
+    EarlyDataPolicy early_data_policy;
+    // Stateless retry (RFC 9000 section 8.1). Once an IO thread receives its
+    // share of `retry_chlo_rate_threshold` Initial packets per second from
+    // clients which haven't validated their addresses, it answers them with
+    // RETRY packets instead of starting handshakes, so spoofed floods cost a
+    // token per packet. Clients echoing a valid token get handshakes, one RTT
+    // later than usual. Below the threshold, RETRY is not sent. 1 always sends
+    // RETRY, 0 disables it.
+    uint32_t retry_chlo_rate_threshold;
+    // `address_token_key_count` keys of kAddressTokenKeyLength bytes stored in
+    // `address_token_keys`, which protect tokens of RETRY packets. Like
+    // session ticket keys, new tokens use the first key and tokens of any key
+    // are accepted. Servers behind the same load balancer should share keys.
+    // A random key is used when there is no key.
+    const uint8_t* address_token_keys;
+    size_t address_token_key_count;
+    // Certificate chains are compressed with brotli or zlib (RFC 8879) for
+    // clients supporting it, so the server's first flight is more likely to
+    // fit in the anti-amplification limit. This is the max number of
+    // compressed chains cached, default value is 16.
+    size_t compressed_certificate_cache_size;
+    // Allocates stream send buffers and datagram copies from per IO thread
+    // pools of size classes instead of malloc. Each IO thread caches up to a
+    // few MB of freed buffers.
+    bool pooled_send_buffers;
+    // Allocates each IO thread's receive buffers, and send buffers if
+    // `pooled_send_buffers` is true, on the NUMA node set for the thread by
+    // WebTransportFactory::SetThreadScheduling. No effect on IO threads
+    // without a NUMA node. Pooled send buffers are then kept until the server
+    // is destroyed, instead of being capped to a few MB.
+    bool numa_local_buffers;
+    // Backs the same buffers with 2 MB huge pages, so packet processing
+    // touches fewer TLB entries. Reserved huge pages are used if there are
+    // enough, otherwise transparent huge pages are requested. Pooled send
+    // buffers are kept like `numa_local_buffers`. Linux and Windows only,
+    // Windows requires the "Lock pages in memory" privilege.
+    bool huge_page_buffers;
+    // Probes each connection's path for packets up to 1450 bytes, so larger
+    // datagrams could be sent on paths allowing them. Connections of clients
+    // asking for it are probed regardless of this option.
+    bool enable_mtu_discovery;
+    // QUIC ACK frequency extension. When it's enabled, connections advertise
+    // support for it, so clients could ask them to send fewer ACKs.
+    bool enable_ack_frequency;
+    // When `ack_eliciting_threshold` is not 0, clients supporting the ACK
+    // frequency extension are asked to send an ACK after receiving this many
+    // ack-eliciting packets, or after `max_ack_delay_ms`, once the handshake
+    // is confirmed. 0 `max_ack_delay_ms` means 25 ms. Fewer ACKs save CPU on
+    // both ends for bulk transfers on high-BDP paths.
+    uint32_t ack_eliciting_threshold;
+    uint32_t max_ack_delay_ms;
+    // Load shedding. Each IO thread probes how long tasks wait in its own
+    // queue and in queues of event threads. When any wait reaches this
+    // threshold, the IO thread is overloaded: new connections are rejected,
+    // datagrams received by sessions not prioritizing datagrams are dropped,
+    // and Visitor::OnOverload is called. It recovers when all waits fall
+    // below half of the threshold. 0 disables load shedding.
+    uint32_t overload_queue_delay_ms;
+    // QPACK settings advertised to clients. They bound the dynamic table and
+    // the number of blocked streams of both ends' encoders. A WebTransport
+    // session exchanges a single request and response, so the dynamic table
+    // rarely pays off, and disabling it saves memory, encoder instructions
+    // and decoder work per session. Zero capacity and blocked streams mean
+    // QUICHE's defaults, 64 KB and 100.
+    bool disable_qpack_dynamic_table;
+    uint32_t qpack_dynamic_table_capacity;
+    uint32_t qpack_blocked_streams;
+    // `accepted_origin_count` serialized origins, e.g.: "https://example.com",
+    // stored in `accepted_origins`. When there is any, WebTransport requests
+    // from other origins, or without Origin header, are answered with 403
+    // before a session is created for them. Invalid origins are ignored.
+    // They're copied when the server is created. All origins are accepted by
+    // default.
+    const char* const* accepted_origins;
+    size_t accepted_origin_count;
+    // Number of sessions with the most recent CPU time each IO thread
+    // reports to GetTopSessionsByCpu() every second. Time is measured with
+    // thread CPU clocks where they're supported, which costs a system call
+    // around each packet and write of a session. 0 disables accounting.
+    size_t top_sessions_by_cpu;
+    // Emulates network conditions on packets sent by the server, see
+    // NetworkEmulationOptions. Packets of all connections on an IO thread
+    // share a link. It's copied when the server is created. nullptr, the
+    // default value, sends packets as is.
+    const NetworkEmulationOptions* network_emulation;
+  };
+
   class Visitor {
    public:
     virtual ~Visitor() = default;
@@ -22,11 +203,116 @@ class OWT_EXPORT WebTransportServerInterface {
     virtual void OnEnded() = 0;
     // Called when a new session is created.
     virtual void OnSession(WebTransportSessionInterface*) = 0;
+    // Called on an IO thread when it becomes overloaded, or recovers. See
+    // Options::overload_queue_delay_ms.
+    virtual void OnOverload(bool overloaded) {}
   };
   virtual ~WebTransportServerInterface() = default;
   virtual int Start() = 0;
+  // Closes all connections and sockets, and then calls Visitor::OnEnded on
+  // the event thread. A stopped server cannot be started again.
   virtual void Stop() = 0;
+  // Stops accepting new connections, and sends HTTP/3 GOAWAY on all
+  // connections, so clients could finish their sessions and reconnect to
+  // another server. Connections still open after `timeout_ms` are closed.
+  // Once all IO threads are drained, sockets are closed and Visitor::OnEnded
+  // is called on the event thread. It returns immediately. Must be called
+  // after Start().
+  virtual void Drain(uint32_t timeout_ms) = 0;
   virtual void SetVisitor(Visitor* visitor) = 0;
+  // Sets the number of IO threads processing connections. Each IO thread has
+  // its own UDP socket bound to the same port with SO_REUSEPORT, and a
+  // connection stays on the IO thread accepts it. Visitor methods may be
+  // called on different IO threads. Must be called before Start(). Default
+  // value is 1. Multiple IO threads are only supported on Linux.
+  virtual void SetIoThreadCount(size_t count) = 0;
+  // Makes server connection IDs routable by a load balancer. Returns false if
+  // `config` is invalid. Must be called before Start(). Connection IDs also
+  // carry the index of IO thread owning the connection.
+  virtual bool SetConnectionIdRouting(
+      const ConnectionIdRoutingConfig& config) = 0;
+  // Writes qlog traces of connections selected by `options`. Returns false if
+  // `options` is invalid or the directory cannot be created. Must be called
+  // before Start().
+  virtual bool EnableQlog(const QlogOptions& options) = 0;
+  // Duplicates the socket of each IO thread into `fds`, up to `max_count`.
+  // Returns the number of IO threads. A restarting server could pass them to
+  // its new process, e.g.: with SCM_RIGHTS over a UNIX domain socket, and call
+  // Drain() once the new process takes them over, so no packet is refused in
+  // between. While both processes read the sockets, packets of new
+  // connections are left to the new process. The caller owns the fds, which
+  // are -1 if a socket cannot be duplicated. Linux only. Must be called after
+  // Start().
+  virtual size_t GetListeningSockets(int* fds, size_t max_count) = 0;
+  // Makes Start() take over `count` sockets returned by GetListeningSockets()
+  // of another server, one for each IO thread, instead of binding new ones.
+  // It overrides SetIoThreadCount(). For `grace_period_ms` after Start(),
+  // packets of unknown connections are dropped instead of answered with
+  // stateless resets, since they may belong to connections still served by
+  // the other server. The server owns `fds` if it returns true. Returns false
+  // on platforms other than Linux. Must be called before Start().
+  virtual bool SetListeningSockets(const int* fds,
+                                   size_t count,
+                                   uint32_t grace_period_ms) = 0;
+  // Sets the max number of bytes of outgoing data buffered by all sessions of
+  // this server, and the default budget for each new session. 0 means
+  // unlimited.
+  virtual void SetSendBufferBudget(uint64_t server_budget,
+                                   uint64_t session_budget) = 0;
+  // Replaces session ticket keys, e.g. to rotate them. Keys have the same
+  // format as Options::session_ticket_keys. Returns false if session
+  // resumption is not enabled by Options, or `key_count` is 0. It could be
+  // called on any thread.
+  virtual bool SetSessionTicketKeys(const uint8_t* keys, size_t key_count) = 0;
+  // Replaces address token keys, e.g. to rotate them. Keys have the same
+  // format as Options::address_token_keys. Returns false if `key_count` is 0.
+  // It could be called on any thread.
+  virtual bool SetAddressTokenKeys(const uint8_t* keys, size_t key_count) = 0;
+  // Replaces the certificate and private key of a server created with a
+  // PKCS12 file, e.g. when the certificate is renewed. Established sessions
+  // are not affected, handshakes started later use the new certificate.
+  // Returns false if the file cannot be loaded, or the server is created with
+  // certificate and key files. It could be called on any thread.
+  virtual bool ReloadCertificate(const char* pfx_path,
+                                 const char* password) = 0;
+  // Returns statistics summed over all IO threads. Each IO thread updates its
+  // own counters without locks, so reading them never blocks packet
+  // processing. It could be called on any thread, but not concurrently with
+  // Start() or Stop(). Values are 0 before Start().
+  virtual ServerStats GetServerStats() = 0;
+  // Copies statistics of up to `max_count` IO threads to `stats`. Returns the
+  // number of IO threads. Same threading requirements as GetServerStats().
+  virtual size_t GetIoThreadStats(ServerStats* stats, size_t max_count) = 0;
+  // Returns memory held by all sessions of this server. Each IO thread
+  // publishes the usage of its sessions every second, so it could be up to a
+  // second old. Same threading requirements as GetServerStats(). The usage is
+  // also reported to Metrics gauges, and to Chromium's memory-infra as dumps
+  // under "owt_quic/web_transport_server".
+  virtual MemoryUsage GetMemoryUsage() = 0;
+  // Copies up to `max_count` sessions with the most CPU time in the last
+  // second to `sessions`, ordered by SessionCpuUsage::recent_time_us. Returns
+  // the number of sessions copied. Each IO thread publishes its top
+  // Options::top_sessions_by_cpu sessions every second, nothing is copied if
+  // it's 0. Same threading requirements as GetServerStats().
+  virtual size_t GetTopSessionsByCpu(SessionCpuUsage* sessions,
+                                     size_t max_count) = 0;
+  // Sends the same data to all `targets` in a single task on IO thread. Data
+  // is copied once and shared by all targets. Sessions in `targets` must be
+  // created by this server. It returns immediately, status of datagrams is
+  // reported by WebTransportSessionInterface::Visitor::OnDatagramProcessed.
+  virtual void Broadcast(const BroadcastTarget* targets,
+                         size_t count,
+                         const uint8_t* data,
+                         size_t length) = 0;
+  // Same as above, but the ownership of `data` is transferred to the SDK, and
+  // it is not copied. `release` is called with `release_context` once all
+  // targets no longer need `data`. `release` could be nullptr.
+  virtual void Broadcast(const BroadcastTarget* targets,
+                         size_t count,
+                         uint8_t* data,
+                         size_t length,
+                         BufferReleaseCallback release,
+                         void* release_context) = 0;
 };
 }  // namespace quic
 }  // namespace owt
@@ -22,19 +22,153 @@ class OWT_EXPORT WebTransportSessionInterface {
     virtual void OnCanCreateNewOutgoingStream(bool unidirectional) = 0;
     virtual void OnConnectionClosed() = 0;
     virtual void OnDatagramReceived(const uint8_t* data, size_t length) = 0;
+    // Called on event thread with datagrams received in a batch when datagram
+    // batching is enabled. `datagrams` and data they point to are only valid
+    // during this call.
+    virtual void OnDatagramsReceived(const Datagram* datagrams, size_t count) {
+    }
+    // Called with the final status of each outgoing datagram, in the order
+    // they are sent.
+    virtual void OnDatagramProcessed(MessageStatus status) {}
+    // Called on IO thread when estimated bandwidth changes more than the
+    // threshold set by SetBandwidthEstimateHysteresis.
+    virtual void OnBandwidthEstimateUpdated(uint64_t bandwidth_bps,
+                                            uint64_t smoothed_rtt_us) {}
+    // Called on IO thread when the value returned by GetMaxDatagramSize
+    // changes, e.g. when path MTU discovery finds a larger packet size.
+    virtual void OnMaxDatagramSizeChanged(size_t max_datagram_size) {}
   };
   virtual ~WebTransportSessionInterface() = default;
+  // Returns connection ID as a null-terminated string. It's owned by the
+  // session and remains valid during the session's lifetime. Sessions pooled
+  // over the same QUIC connection have the same connection ID.
   virtual const char* ConnectionId() const = 0;
   virtual void SetVisitor(Visitor* visitor) = 0;
   virtual bool IsSessionReady() const = 0;
   virtual WebTransportStreamInterface* CreateBidirectionalStream() = 0;
+  // Create an outgoing unidirectional stream. Returns nullptr if no more
+  // stream can be created at this moment.
+  virtual WebTransportStreamInterface*
+  CreateOutgoingUnidirectionalStream() = 0;
+  // Creates at most `count` streams in a single task on IO thread, and stores
+  // them in `streams`, which should have at least `count` elements. Returns
+  // the number of streams created, which could be less than `count` when
+  // stream limit is reached.
+  virtual size_t CreateBidirectionalStreams(
+      size_t count,
+      WebTransportStreamInterface** streams) = 0;
+  // Same as above, but creates outgoing unidirectional streams.
+  virtual size_t CreateOutgoingUnidirectionalStreams(
+      size_t count,
+      WebTransportStreamInterface** streams) = 0;
+  // Keeps `bidirectional` bidirectional streams and `unidirectional` outgoing
+  // unidirectional streams opened ahead of time, so AcquireStream() takes one
+  // without waiting for IO thread. The pool is refilled after streams are
+  // acquired, and when the peer raises its stream limit. Pooled streams count
+  // against the peer's stream limit, and the peer may see them before
+  // anything is written. At most 64 streams of each direction are kept. 0 for
+  // both disables the pool, which is the default. It returns immediately.
+  virtual void SetWarmStreamPoolSize(size_t bidirectional,
+                                     size_t unidirectional) = 0;
+  // Takes a stream from the pool set by SetWarmStreamPoolSize. Returns nullptr
+  // if the pool is empty, e.g. all streams allowed by the peer are in use.
+  virtual WebTransportStreamInterface* AcquireStream(bool bidirectional) = 0;
   virtual MessageStatus SendOrQueueDatagram(uint8_t* data, size_t length) = 0;
-  // Get connection stats.
-  virtual const ConnectionStats& GetStats() = 0;
+  // Same as above, but the ownership of `data` is transferred to the SDK, and
+  // it is not copied. `release` is called with `release_context` once the SDK
+  // no longer needs `data`. `release` could be nullptr.
+  virtual MessageStatus SendOrQueueDatagram(uint8_t* data,
+                                            size_t length,
+                                            BufferReleaseCallback release,
+                                            void* release_context) = 0;
+  // Same as SendOrQueueDatagram, but returns immediately without waiting for IO
+  // thread. Status is reported by Visitor::OnDatagramProcessed.
+  virtual void SendOrQueueDatagramAsync(uint8_t* data, size_t length) = 0;
+  // Send or queue `count` datagrams in `batch`. Status of each datagram is
+  // stored in `results`, which should have at least `count` elements, or be
+  // nullptr if status is not needed. It's more efficient than calling
+  // SendOrQueueDatagram for each datagram, especially when it's called on a
+  // thread other than IO thread.
+  virtual void SendOrQueueDatagrams(const Datagram* batch,
+                                    size_t count,
+                                    MessageStatus* results) = 0;
+  // When enabled, datagrams received in the same round of packet processing
+  // are delivered together by Visitor::OnDatagramsReceived instead of
+  // Visitor::OnDatagramReceived. Disabled by default.
+  virtual void SetDatagramBatchingEnabled(bool enabled) = 0;
+  // Visitor::OnBandwidthEstimateUpdated is fired when estimated bandwidth
+  // changes by at least `percent` percent since last update. 0 disables it,
+  // which is the default value.
+  virtual void SetBandwidthEstimateHysteresis(uint32_t percent) = 0;
+  // Datagrams queued by congestion control for more than `max_time_ms`
+  // milliseconds are dropped, and reported as MessageStatus::kExpired by
+  // Visitor::OnDatagramProcessed. 0 restores QUIC's default, which is derived
+  // from RTT. Sessions pooled over one connection share its datagram queue,
+  // so they share this setting. It returns immediately.
+  virtual void SetMaxDatagramTimeInQueue(uint32_t max_time_ms) = 0;
+  // Sets the order of queued datagrams relative to stream data. The order is
+  // a setting of the connection, so the last session pooled over it setting
+  // the priority wins, while each session keeps its own overload behavior. It
+  // returns immediately.
+  virtual void SetDatagramPriority(DatagramPriority priority) = 0;
+  // Queues datagrams sent by SendOrQueuePrioritizedDatagram in the SDK
+  // instead of QUIC's datagram queue while congestion control blocks them,
+  // in `count` priority classes described by `classes`, class 0 first. Queued
+  // datagrams are sent strictly by priority as the connection can send, before
+  // stream data, and oldest first within a class. Each class drops datagrams
+  // by its own policy, so e.g.: audio and base layers in higher classes still
+  // get through bandwidth dips. Datagrams dropped after they're queued are
+  // reported as MessageStatus::kExpired by Visitor::OnDatagramProcessed. At
+  // most 8 classes are used. 0 `count` disables the SDK queue, which is the
+  // default, and drops datagrams queued by it. It returns immediately.
+  virtual void SetDatagramClasses(const DatagramClassOptions* classes,
+                                  size_t count) = 0;
+  // Sends or queues a datagram of `priority_class`, which is clamped to the
+  // last class. `data` is copied. Returns MessageStatus::kBlocked if it's
+  // queued, its status is then reported by Visitor::OnDatagramProcessed, or
+  // MessageStatus::kQueueFull if its class rejects it. Same as
+  // SendOrQueueDatagram if SetDatagramClasses is not called.
+  virtual MessageStatus SendOrQueuePrioritizedDatagram(
+      uint8_t* data,
+      size_t length,
+      uint32_t priority_class) = 0;
+  // Caps the rate of data sent by this session's connection, retransmissions
+  // and datagrams included, to `bits_per_second`. It's enforced by the pacer,
+  // so packets are spread evenly instead of sent in bursts, and congestion
+  // control measures bandwidth under the cap instead of competing with it.
+  // Bursts are bounded by QUIC's pacing burst, 10 packets after the
+  // connection is idle. 0 removes the cap, which is the default. Sessions
+  // pooled over one connection share the cap. It returns immediately.
+  virtual void SetMaxSendRate(uint64_t bits_per_second) = 0;
+  // Sends a PING after every `interval_ms` milliseconds in which nothing is
+  // received from the peer, so a live peer's ACKs keep the connection active.
+  // When `idle_timeout_ms` is not 0, it replaces the connection's idle
+  // timeout, so a dead peer is detected once it expires, and
+  // Visitor::OnConnectionClosed is called. e.g.: 250 ms interval and 1000 ms
+  // idle timeout detect a dead peer within about a second. 0 `interval_ms`
+  // stops PINGs. It overrides the server's keepalive options, and is shared
+  // by sessions pooled over one connection. It returns immediately.
+  virtual void SetKeepAlive(uint32_t interval_ms, uint32_t idle_timeout_ms) = 0;
+  // Returns the max size of a datagram which fits in a packet of the current
+  // max packet size of the connection. Larger datagrams are rejected with
+  // MessageStatus::kTooLarge. It grows when path MTU discovery finds a larger
+  // packet size. The value is cached by IO thread, so it doesn't block.
+  virtual size_t GetMaxDatagramSize() const = 0;
+  // Returns a copy of connection stats. Stats are published by IO thread
+  // periodically, so this method doesn't block when it's called on other
+  // threads.
+  virtual ConnectionStats GetStats() = 0;
+  // Returns memory held by this session and its streams. It's computed on IO
+  // thread, so it blocks when it's called on other threads.
+  virtual MemoryUsage GetMemoryUsage() = 0;
   // Close a WebTransport session. `code` is the error code communicated with
   // peer, `reason` is a pointer to a UTF-8 encoded null terminated string, its
   // length should not exceed 1024.
   virtual void Close(uint32_t code, const char* reason) = 0;
+  // Sets the max number of bytes of outgoing data buffered by all streams of
+  // this session. 0 means unlimited. When the budget is exceeded, CanWrite()
+  // returns false and WriteAsync fails until buffered data is sent.
+  virtual void SetSendBufferBudget(uint64_t bytes) = 0;
 };
 }  // namespace quic
 }  // namespace owt
@@ -8,6 +8,8 @@
 #define OWT_WEB_TRANSPORT_WEB_TRANSPORT_STREAM_INTERFACE_H_
 
 #include "owt/quic/export.h"
+#include "owt/quic/stream_receive_ring.h"
+#include "owt/quic/web_transport_definitions.h"
 #include "stddef.h"
 #include "stdint.h"
 
@@ -18,7 +20,9 @@ class OWT_EXPORT WebTransportStreamInterface {
   class Visitor {
    public:
     virtual ~Visitor() = default;
-    // Called when new data is available.
+    // Called when new data is available. When a receive ring is registered,
+    // it's called on IO thread when data in the ring rises to the fill
+    // watermark instead.
     virtual void OnCanRead() = 0;
     // Called when stream is ready to write new data. It doesn't called before
     // first write. Before first write, please check IsSessionReady().
@@ -26,6 +30,33 @@ class OWT_EXPORT WebTransportStreamInterface {
     virtual void OnCanWrite() = 0;
     // Called when final incoming data is read.
     virtual void OnFinRead() = 0;
+    // Called when data queued by WriteAsync is written or buffered by the
+    // QUIC stream, or dropped because the write side is closed. `length` is
+    // the size of data passed to WriteAsync. Calls are in the same order as
+    // WriteAsync calls.
+    virtual void OnWriteCompleted(size_t length, bool success) {}
+    // Called on IO thread when push mode is enabled and new data is received.
+    // `data` is only valid during this call, all data passed is considered as
+    // consumed. `fin` is true if `data` is the final part of incoming data.
+    virtual void OnDataReceived(const uint8_t* data, size_t length, bool fin) {}
+    // Called when buffered data reaches the high watermark set by
+    // SetBufferWatermarks. Write() returns 0 until OnBufferLow is called.
+    virtual void OnBufferHigh() {}
+    // Called when buffered data drops to the low watermark after OnBufferHigh.
+    virtual void OnBufferLow() {}
+    // Called on IO thread when remote side resets the stream with
+    // RESET_STREAM. Data not received yet will not arrive.
+    virtual void OnResetStreamReceived(uint8_t error_code) {}
+    // Called on IO thread when remote side asks this side to stop sending with
+    // STOP_SENDING. The stream is reset in response, data queued and not sent
+    // yet is dropped.
+    virtual void OnStopSendingReceived(uint8_t error_code) {}
+    // Called on IO thread when the deadline set by SetSendDeadline passes
+    // before all data is acknowledged. The stream has been reset.
+    virtual void OnSendDeadlineExpired() {}
+    // Called on IO thread when both directions of the stream are finished. The
+    // stream is destroyed right after this call, it must not be used anymore.
+    virtual void OnClosed() {}
   };
   virtual ~WebTransportStreamInterface() = default;
   // QUIC stream ID.
@@ -34,13 +65,104 @@ class OWT_EXPORT WebTransportStreamInterface {
   // Write or buffer data. Returns the length of data written or buffered.
   // Current implementation always returns 0 or `length`.
   virtual size_t Write(const uint8_t* data, size_t length) = 0;
+  // Queues data to be written and returns immediately. `data` is copied, so it
+  // can be released after this method returns. Data is kept in the SDK until
+  // the stream is writable, and Visitor::OnWriteCompleted is called for each
+  // call. Data queued by WriteAsync is always written before data passed to
+  // subsequent calls of Write.
+  virtual void WriteAsync(const uint8_t* data, size_t length) = 0;
+  // Same as above, but the ownership of `data` is transferred to the SDK, and
+  // it is not copied. `release` is called with `release_context` once the SDK
+  // no longer needs `data`, e.g.: data is acknowledged by remote side or the
+  // stream is closed. `release` could be nullptr if the buffer does not need
+  // to be released. Caller must not modify `data` before it is released.
+  virtual void WriteAsync(uint8_t* data,
+                          size_t length,
+                          BufferReleaseCallback release,
+                          void* release_context) = 0;
+  // Queues all pieces of data described by `iov` as a single write, and
+  // returns immediately. Data is copied. Visitor::OnWriteCompleted is called
+  // once with the total length of all pieces. If `fin` is true, FIN is sent
+  // after the data.
+  virtual void Writev(const IoVec* iov, size_t iovcnt, bool fin) = 0;
+  // Queues `length` bytes of the file `fd` starting at `offset` as a single
+  // write, and returns immediately. Data isn't read by the caller: it's read in
+  // chunks on a thread pool, so reads don't block the IO thread, and handed to
+  // QUIC stream whenever the stream is writable. Only a few chunks are in
+  // memory at any time.
+  // Visitor::OnWriteCompleted is called once with `length` after the last
+  // chunk is handed to the QUIC stream. `fd` must stay open until then, and
+  // the range must not be modified. If the file can't be read, e.g.: it's
+  // shorter than `offset` + `length`, the stream is reset with error code 0
+  // rather than sending truncated data. If `fin` is true, FIN is sent after
+  // the data.
+  virtual void WriteFile(int fd,
+                         uint64_t offset,
+                         uint64_t length,
+                         bool fin) = 0;
+  // Enables write coalescing when `threshold` is greater than 0. Data written
+  // is kept in the SDK until the size of data kept reaches `threshold` bytes,
+  // `delay_ms` milliseconds elapsed since data is kept, or Flush() is called.
+  // Then all data kept is written to QUIC stream together, which results in
+  // fewer and fuller packets. `delay_ms` 0 means no time threshold. Coalescing
+  // is disabled by default.
+  virtual void SetWriteCoalescing(size_t threshold, uint32_t delay_ms) = 0;
+  // Writes all data kept for coalescing to QUIC stream. It returns
+  // immediately.
+  virtual void Flush() = 0;
+  // Sets high and low watermarks of buffered data in bytes, which includes
+  // data buffered by QUIC stream and data queued in the SDK. `high` 0 disables
+  // watermarks, which is the default. `low` should be less than `high`.
+  virtual void SetBufferWatermarks(uint64_t high, uint64_t low) = 0;
+  // Sets the priority of this stream. `urgency` is in the range of 0 (highest)
+  // to 7 (lowest), as defined in RFC 9218. The default urgency is 3. When
+  // multiple streams are blocked by congestion control, streams with higher
+  // priority are scheduled first. It returns immediately.
+  virtual void SetPriority(uint8_t urgency) = 0;
   // Reads at most `length` bytes into `data` and returns the number of bytes
   // actually read.
   virtual size_t Read(uint8_t* data, size_t length) = 0;
+  // Enables or disables push mode. In push mode, incoming data is read by the
+  // SDK once it's available and delivered to Visitor::OnDataReceived on IO
+  // thread, OnCanRead is not called. Push mode is disabled by default. Data
+  // already received is delivered right after push mode is enabled.
+  virtual void SetPushModeEnabled(bool enabled) = 0;
+  // Registers `ring` to receive incoming data. Data is copied into `ring` on IO
+  // thread as soon as it arrives and consumed from the QUIC stream, so no
+  // Read() call is needed. Visitor::OnCanRead is only called when data in
+  // `ring` rises from below `fill_watermark` bytes to or above it, and
+  // Visitor::OnFinRead is called once all data including FIN has been copied.
+  // When `ring` is full, data stays in the QUIC stream, which eventually
+  // blocks the peer by flow control, until ResumeReceive() is called. It takes
+  // precedence over push mode. `ring` nullptr unregisters the ring. It returns
+  // immediately.
+  virtual void SetReceiveRing(StreamReceiveRing* ring,
+                              size_t fill_watermark) = 0;
+  // Continues copying data into the receive ring after the consumer freed
+  // space, see StreamReceiveRing::TakeProducerBlocked. It returns immediately.
+  virtual void ResumeReceive() = 0;
+  // ReadableBytes, BufferedDataBytes and CanWrite don't block when they are
+  // called on a thread other than IO thread. They return the latest state
+  // published by IO thread, which could be slightly out of date.
   // Indicates the number of bytes that can be read from the stream.
   virtual size_t ReadableBytes() const = 0;
   // Close the stream, send FIN to remote side.
   virtual void Close() = 0;
+  // Abandons the write side of the stream by sending RESET_STREAM with
+  // `error_code`. Data queued or buffered and not sent yet is dropped, and
+  // pending WriteAsync calls complete with failure. It returns immediately.
+  virtual void Reset(uint8_t error_code) = 0;
+  // Asks remote side to stop sending by sending STOP_SENDING with
+  // `error_code`. Data not received yet will not arrive. It returns
+  // immediately.
+  virtual void StopSending(uint8_t error_code) = 0;
+  // Sets a deadline `timeout_ms` milliseconds from now. If data written to
+  // this stream and its FIN are not fully acknowledged by remote side by then,
+  // the stream is reset with `error_code`, so late data is no longer
+  // retransmitted, and Visitor::OnSendDeadlineExpired is called. It replaces
+  // the previous deadline. `timeout_ms` 0 cancels the deadline. It returns
+  // immediately.
+  virtual void SetSendDeadline(uint32_t timeout_ms, uint8_t error_code) = 0;
   // Bytes of data buffered.
   virtual uint64_t BufferedDataBytes() const = 0;
   // Ready to write new data.
@@ -0,0 +1,188 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "impl/address_token_crypter.h"
+#include <algorithm>
+#include <utility>
+#include "base/check.h"
+#include "crypto/random.h"
+#include "crypto/sha2.h"
+#include "net/third_party/quiche/src/quic/core/quic_constants.h"
+
+namespace owt {
+namespace quic {
+
+namespace {
+// A token is key name || nonce || AEAD(issue time || original connection ID).
+// The additional data is key name || client address || retry connection ID.
+constexpr size_t kKeyNameLength = 8;
+constexpr size_t kNonceLength = 12;
+constexpr size_t kHeaderLength = kKeyNameLength + kNonceLength;
+constexpr size_t kIssueTimeLength = sizeof(int64_t);
+
+const EVP_AEAD* Aead() {
+  return EVP_aead_aes_256_gcm();
+}
+
+std::string AdditionalData(absl::string_view key_name,
+                           const ::quic::QuicIpAddress& client_address,
+                           const ::quic::QuicConnectionId& retry_connection_id) {
+  // Addresses are 4 or 16 bytes, so they're length prefixed.
+  const std::string address = client_address.ToPackedString();
+  std::string data(key_name);
+  data.push_back(static_cast<char>(address.size()));
+  data.append(address);
+  data.append(retry_connection_id.data(), retry_connection_id.length());
+  return data;
+}
+
+void WriteIssueTime(int64_t issue_time, uint8_t* out) {
+  uint64_t value = static_cast<uint64_t>(issue_time);
+  for (size_t i = 0; i < kIssueTimeLength; i++) {
+    out[kIssueTimeLength - 1 - i] = static_cast<uint8_t>(value & 0xff);
+    value >>= 8;
+  }
+}
+
+int64_t ReadIssueTime(const uint8_t* in) {
+  uint64_t value = 0;
+  for (size_t i = 0; i < kIssueTimeLength; i++) {
+    value = (value << 8) | in[i];
+  }
+  return static_cast<int64_t>(value);
+}
+}  // namespace
+
+AddressTokenCrypter::AddressTokenCrypter(const ::quic::QuicClock* clock)
+    : clock_(clock) {
+  CHECK(clock_);
+  uint8_t key[kKeyLength];
+  crypto::RandBytes(key, sizeof(key));
+  CHECK(SetKeys(key, 1));
+}
+
+AddressTokenCrypter::~AddressTokenCrypter() = default;
+
+bool AddressTokenCrypter::SetKeys(const uint8_t* keys, size_t key_count) {
+  std::shared_ptr<const KeySet> key_set = CreateKeySet(keys, key_count);
+  if (!key_set) {
+    return false;
+  }
+  base::AutoLock lock(lock_);
+  keys_ = std::move(key_set);
+  return true;
+}
+
+std::string AddressTokenCrypter::MintToken(
+    const ::quic::QuicIpAddress& client_address,
+    const ::quic::QuicConnectionId& original_connection_id,
+    const ::quic::QuicConnectionId& retry_connection_id) {
+  std::vector<uint8_t> plaintext(kIssueTimeLength +
+                                 original_connection_id.length());
+  WriteIssueTime(clock_->WallNow().ToUNIXMicroseconds(), plaintext.data());
+  std::copy(original_connection_id.data(),
+            original_connection_id.data() + original_connection_id.length(),
+            plaintext.begin() + kIssueTimeLength);
+
+  std::shared_ptr<const KeySet> keys = GetKeys();
+  const Key& key = *keys->front();
+  const std::string additional_data =
+      AdditionalData(key.name, client_address, retry_connection_id);
+  std::string token(
+      kHeaderLength + plaintext.size() + EVP_AEAD_max_overhead(Aead()), '\0');
+  uint8_t* out = reinterpret_cast<uint8_t*>(&token[0]);
+  std::copy(key.name.begin(), key.name.end(), out);
+  crypto::RandBytes(out + kKeyNameLength, kNonceLength);
+  size_t sealed_length = 0;
+  if (!EVP_AEAD_CTX_seal(
+          key.context.get(), out + kHeaderLength, &sealed_length,
+          token.size() - kHeaderLength, out + kKeyNameLength, kNonceLength,
+          plaintext.data(), plaintext.size(),
+          reinterpret_cast<const uint8_t*>(additional_data.data()),
+          additional_data.size())) {
+    return std::string();
+  }
+  token.resize(kHeaderLength + sealed_length);
+  return token;
+}
+
+bool AddressTokenCrypter::ValidateToken(
+    absl::string_view token,
+    const ::quic::QuicIpAddress& client_address,
+    const ::quic::QuicConnectionId& retry_connection_id,
+    ::quic::QuicConnectionId* original_connection_id) {
+  DCHECK(original_connection_id);
+  if (token.size() < kHeaderLength + EVP_AEAD_max_overhead(Aead())) {
+    return false;
+  }
+  const absl::string_view key_name = token.substr(0, kKeyNameLength);
+  const uint8_t* in = reinterpret_cast<const uint8_t*>(token.data());
+  std::shared_ptr<const KeySet> keys = GetKeys();
+  for (const auto& key : *keys) {
+    if (key->name != key_name) {
+      continue;
+    }
+    const std::string additional_data =
+        AdditionalData(key_name, client_address, retry_connection_id);
+    std::vector<uint8_t> plaintext(token.size() - kHeaderLength);
+    size_t plaintext_length = 0;
+    if (!EVP_AEAD_CTX_open(
+            key->context.get(), plaintext.data(), &plaintext_length,
+            plaintext.size(), in + kKeyNameLength, kNonceLength,
+            in + kHeaderLength, token.size() - kHeaderLength,
+            reinterpret_cast<const uint8_t*>(additional_data.data()),
+            additional_data.size())) {
+      return false;
+    }
+    if (plaintext_length < kIssueTimeLength ||
+        plaintext_length - kIssueTimeLength >
+            ::quic::kQuicMaxConnectionIdWithLengthPrefixLength) {
+      return false;
+    }
+    const int64_t age = clock_->WallNow().ToUNIXMicroseconds() -
+                        ReadIssueTime(plaintext.data());
+    if (age < 0 || age >= kTokenLifetimeSeconds * 1000 * 1000) {
+      return false;
+    }
+    *original_connection_id = ::quic::QuicConnectionId(
+        reinterpret_cast<const char*>(plaintext.data() + kIssueTimeLength),
+        static_cast<uint8_t>(plaintext_length - kIssueTimeLength));
+    return true;
+  }
+  return false;
+}
+
+// static
+std::shared_ptr<const AddressTokenCrypter::KeySet>
+AddressTokenCrypter::CreateKeySet(const uint8_t* keys, size_t key_count) {
+  if (!keys || key_count == 0) {
+    return nullptr;
+  }
+  auto key_set = std::make_shared<KeySet>();
+  for (size_t i = 0; i < key_count; i++) {
+    const uint8_t* key_data = keys + i * kKeyLength;
+    auto key = std::make_unique<Key>();
+    key->name = crypto::SHA256HashString(
+                    std::string(reinterpret_cast<const char*>(key_data),
+                                kKeyLength))
+                    .substr(0, kKeyNameLength);
+    if (!EVP_AEAD_CTX_init(key->context.get(), Aead(), key_data, kKeyLength,
+                           EVP_AEAD_DEFAULT_TAG_LENGTH, nullptr)) {
+      return nullptr;
+    }
+    key_set->push_back(std::move(key));
+  }
+  return key_set;
+}
+
+std::shared_ptr<const AddressTokenCrypter::KeySet>
+AddressTokenCrypter::GetKeys() {
+  base::AutoLock lock(lock_);
+  return keys_;
+}
+
+}  // namespace quic
+}  // namespace owt
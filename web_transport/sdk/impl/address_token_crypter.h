@@ -0,0 +1,85 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef OWT_WEB_TRANSPORT_ADDRESS_TOKEN_CRYPTER_H_
+#define OWT_WEB_TRANSPORT_ADDRESS_TOKEN_CRYPTER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "base/synchronization/lock.h"
+#include "base/thread_annotations.h"
+#include "net/third_party/quiche/src/quic/core/quic_clock.h"
+#include "net/third_party/quiche/src/quic/core/quic_connection_id.h"
+#include "net/third_party/quiche/src/quic/platform/api/quic_ip_address.h"
+#include "third_party/abseil-cpp/absl/strings/string_view.h"
+#include "third_party/boringssl/src/include/openssl/aead.h"
+
+namespace owt {
+namespace quic {
+
+// Mints and validates tokens of RETRY packets (RFC 9000 section 8.1.2). A
+// token carries the client's original destination connection ID and its
+// issue time, and it's bound to the client's IP address and the connection ID
+// chosen by the RETRY, so it cannot be used from another address. Like
+// SessionTicketCrypter, new tokens are sealed with the first key and tokens
+// sealed with any of the keys are accepted. Thread safe, since a server's IO
+// threads share the same crypter.
+class AddressTokenCrypter {
+ public:
+  // Length of each key, in bytes.
+  static constexpr size_t kKeyLength = 32;
+  // Tokens older than this are rejected. Clients use them immediately.
+  static constexpr int64_t kTokenLifetimeSeconds = 10;
+
+  // Starts with a random key, so RETRY works without keys provided by the
+  // application, but tokens are only accepted by this crypter.
+  explicit AddressTokenCrypter(const ::quic::QuicClock* clock);
+  ~AddressTokenCrypter();
+  AddressTokenCrypter(const AddressTokenCrypter&) = delete;
+  AddressTokenCrypter& operator=(const AddressTokenCrypter&) = delete;
+
+  // Replaces keys with `key_count` keys of kKeyLength bytes stored in `keys`.
+  // Returns false and keeps current keys if `key_count` is 0.
+  bool SetKeys(const uint8_t* keys, size_t key_count);
+
+  // Returns an empty string on failure.
+  std::string MintToken(
+      const ::quic::QuicIpAddress& client_address,
+      const ::quic::QuicConnectionId& original_connection_id,
+      const ::quic::QuicConnectionId& retry_connection_id);
+  // Returns true and sets `original_connection_id` if `token` is minted for
+  // `client_address` and `retry_connection_id`, and it hasn't expired.
+  bool ValidateToken(absl::string_view token,
+                     const ::quic::QuicIpAddress& client_address,
+                     const ::quic::QuicConnectionId& retry_connection_id,
+                     ::quic::QuicConnectionId* original_connection_id);
+
+ private:
+  struct Key {
+    // Identifies the key which seals a token.
+    std::string name;
+    bssl::ScopedEVP_AEAD_CTX context;
+  };
+  using KeySet = std::vector<std::unique_ptr<Key>>;
+
+  // Returns nullptr if `keys` cannot be used.
+  static std::shared_ptr<const KeySet> CreateKeySet(const uint8_t* keys,
+                                                    size_t key_count);
+  // Tokens are sealed and opened without holding `lock_`.
+  std::shared_ptr<const KeySet> GetKeys();
+
+  const ::quic::QuicClock* clock_;  // Not owned.
+  base::Lock lock_;
+  std::shared_ptr<const KeySet> keys_ GUARDED_BY(lock_);
+};
+
+}  // namespace quic
+}  // namespace owt
+
+#endif
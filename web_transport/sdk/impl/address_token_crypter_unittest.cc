@@ -0,0 +1,118 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "owt/web_transport/sdk/impl/address_token_crypter.h"
+#include "net/third_party/quiche/src/quic/test_tools/mock_clock.h"
+#include "net/third_party/quiche/src/quic/test_tools/quic_test_utils.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace owt {
+namespace quic {
+namespace test {
+
+namespace {
+// `count` keys filled with `first_value`, `first_value + 1`, ...
+std::vector<uint8_t> Keys(uint8_t first_value, size_t count) {
+  std::vector<uint8_t> keys;
+  for (size_t i = 0; i < count; i++) {
+    keys.insert(keys.end(), AddressTokenCrypter::kKeyLength,
+                static_cast<uint8_t>(first_value + i));
+  }
+  return keys;
+}
+
+class AddressTokenCrypterTest : public testing::Test {
+ protected:
+  AddressTokenCrypterTest()
+      : client_address_(::quic::QuicIpAddress::Loopback4()),
+        original_connection_id_(::quic::test::TestConnectionId(1)),
+        retry_connection_id_(::quic::test::TestConnectionId(2)) {
+    clock_.AdvanceTime(::quic::QuicTime::Delta::FromSeconds(1));
+  }
+
+  bool Validate(AddressTokenCrypter& crypter, const std::string& token) {
+    ::quic::QuicConnectionId original_connection_id;
+    if (!crypter.ValidateToken(token, client_address_, retry_connection_id_,
+                               &original_connection_id)) {
+      return false;
+    }
+    EXPECT_EQ(original_connection_id, original_connection_id_);
+    return true;
+  }
+
+  std::string Mint(AddressTokenCrypter& crypter) {
+    return crypter.MintToken(client_address_, original_connection_id_,
+                             retry_connection_id_);
+  }
+
+  ::quic::MockClock clock_;
+  const ::quic::QuicIpAddress client_address_;
+  const ::quic::QuicConnectionId original_connection_id_;
+  const ::quic::QuicConnectionId retry_connection_id_;
+};
+}  // namespace
+
+TEST_F(AddressTokenCrypterTest, MintAndValidate) {
+  AddressTokenCrypter crypter(&clock_);
+  std::string token = Mint(crypter);
+  ASSERT_FALSE(token.empty());
+  EXPECT_TRUE(Validate(crypter, token));
+  // Tampered tokens are rejected.
+  token.back() ^= 1;
+  EXPECT_FALSE(Validate(crypter, token));
+  EXPECT_FALSE(Validate(crypter, ""));
+  EXPECT_FALSE(crypter.SetKeys(nullptr, 0));
+}
+
+TEST_F(AddressTokenCrypterTest, BoundToAddressAndConnectionId) {
+  AddressTokenCrypter crypter(&clock_);
+  const std::string token = Mint(crypter);
+  ::quic::QuicConnectionId original_connection_id;
+  EXPECT_FALSE(crypter.ValidateToken(token, ::quic::QuicIpAddress::Loopback6(),
+                                     retry_connection_id_,
+                                     &original_connection_id));
+  EXPECT_FALSE(crypter.ValidateToken(token, client_address_,
+                                     ::quic::test::TestConnectionId(3),
+                                     &original_connection_id));
+}
+
+TEST_F(AddressTokenCrypterTest, TokensExpire) {
+  AddressTokenCrypter crypter(&clock_);
+  const std::string token = Mint(crypter);
+  clock_.AdvanceTime(::quic::QuicTime::Delta::FromSeconds(
+      AddressTokenCrypter::kTokenLifetimeSeconds - 1));
+  EXPECT_TRUE(Validate(crypter, token));
+  clock_.AdvanceTime(::quic::QuicTime::Delta::FromSeconds(1));
+  EXPECT_FALSE(Validate(crypter, token));
+}
+
+TEST_F(AddressTokenCrypterTest, RotateKeys) {
+  AddressTokenCrypter crypter(&clock_);
+  // The random key is replaced.
+  const std::string random_key_token = Mint(crypter);
+  std::vector<uint8_t> old_keys = Keys(1, 1);
+  ASSERT_TRUE(crypter.SetKeys(old_keys.data(), 1));
+  EXPECT_FALSE(Validate(crypter, random_key_token));
+  const std::string old_token = Mint(crypter);
+
+  // New key first, old key is kept for validation.
+  std::vector<uint8_t> keys = Keys(2, 1);
+  keys.insert(keys.end(), old_keys.begin(), old_keys.end());
+  ASSERT_TRUE(crypter.SetKeys(keys.data(), 2));
+  const std::string new_token = Mint(crypter);
+  EXPECT_TRUE(Validate(crypter, old_token));
+  EXPECT_TRUE(Validate(crypter, new_token));
+
+  // A server which only has the new key.
+  AddressTokenCrypter other_crypter(&clock_);
+  ASSERT_TRUE(other_crypter.SetKeys(keys.data(), 1));
+  EXPECT_TRUE(Validate(other_crypter, new_token));
+  EXPECT_FALSE(Validate(other_crypter, old_token));
+}
+
+}  // namespace test
+}  // namespace quic
+}  // namespace owt
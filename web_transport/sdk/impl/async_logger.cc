@@ -0,0 +1,242 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "impl/async_logger.h"
+#include <algorithm>
+#include <cstring>
+#include "base/bind.h"
+#include "base/synchronization/waitable_event.h"
+#include "base/time/time.h"
+
+namespace owt {
+namespace quic {
+
+namespace {
+// Queued messages are delivered in batches at this interval, so logging a
+// message never wakes up the logging thread.
+constexpr base::TimeDelta kDrainInterval = base::Milliseconds(20);
+}  // namespace
+
+LogRingBuffer::LogRingBuffer() : push_position_(0), pop_position_(0) {
+  for (size_t i = 0; i < kCapacity; i++) {
+    slots_[i].sequence.store(i, std::memory_order_relaxed);
+  }
+}
+
+LogRingBuffer::~LogRingBuffer() = default;
+
+bool LogRingBuffer::Push(logging::LogSeverity severity,
+                         const char* file,
+                         int line,
+                         const char* message,
+                         size_t length) {
+  size_t position = push_position_.load(std::memory_order_relaxed);
+  Slot* slot;
+  for (;;) {
+    slot = &slots_[position % kCapacity];
+    const size_t sequence = slot->sequence.load(std::memory_order_acquire);
+    const intptr_t difference =
+        static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+    if (difference == 0) {
+      if (push_position_.compare_exchange_weak(position, position + 1,
+                                               std::memory_order_relaxed)) {
+        break;
+      }
+    } else if (difference < 0) {
+      // The consumer hasn't popped the record pushed kCapacity positions ago.
+      return false;
+    } else {
+      position = push_position_.load(std::memory_order_relaxed);
+    }
+  }
+  slot->severity = severity;
+  slot->file = file;
+  slot->line = line;
+  slot->length = std::min(length, kMaxMessageLength);
+  memcpy(slot->message, message, slot->length);
+  slot->sequence.store(position + 1, std::memory_order_release);
+  return true;
+}
+
+bool LogRingBuffer::Pop(LogRecord* record) {
+  Slot* slot = &slots_[pop_position_ % kCapacity];
+  if (slot->sequence.load(std::memory_order_acquire) != pop_position_ + 1) {
+    return false;
+  }
+  record->severity = slot->severity;
+  record->file = slot->file;
+  record->line = slot->line;
+  record->message.assign(slot->message, slot->length);
+  slot->sequence.store(pop_position_ + kCapacity, std::memory_order_release);
+  pop_position_++;
+  return true;
+}
+
+bool LogRateLimiter::Allow(uint64_t* suppressed) {
+  return AllowAt((base::TimeTicks::Now() - base::TimeTicks()).InSeconds(),
+                 suppressed);
+}
+
+bool LogRateLimiter::AllowAt(int64_t now_seconds, uint64_t* suppressed) {
+  // Racing threads may let a few more messages through when a new window
+  // starts, which is fine for rate limiting.
+  int64_t window = window_.load(std::memory_order_relaxed);
+  if (window != now_seconds &&
+      window_.compare_exchange_strong(window, now_seconds,
+                                      std::memory_order_relaxed)) {
+    count_.store(0, std::memory_order_relaxed);
+  }
+  if (count_.fetch_add(1, std::memory_order_relaxed) < kMessagesPerSecond) {
+    *suppressed = suppressed_.exchange(0, std::memory_order_relaxed);
+    return true;
+  }
+  suppressed_.fetch_add(1, std::memory_order_relaxed);
+  return false;
+}
+
+AsyncLogger::AsyncLogger()
+    : dropped_messages_(0),
+      started_(false),
+      sink_(nullptr),
+      thread_("owt_logging_thread") {}
+
+AsyncLogger::~AsyncLogger() = default;
+
+// static
+AsyncLogger* AsyncLogger::GetInstance() {
+  static base::NoDestructor<AsyncLogger> instance;
+  return instance.get();
+}
+
+void AsyncLogger::Log(logging::LogSeverity severity,
+                      const char* file,
+                      int line,
+                      const std::string& message) {
+  EnsureStarted();
+  if (!buffer_.Push(severity, file, line, message.data(), message.size())) {
+    dropped_messages_.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+void AsyncLogger::SetSink(LogSink* sink) {
+  EnsureStarted();
+  {
+    // Waits for the delivery to the previous sink.
+    base::AutoLock lock(lock_);
+    sink_ = sink;
+  }
+  logging::SetLogMessageHandler(sink ? &AsyncLogger::OnChromiumLogMessage
+                                     : nullptr);
+}
+
+void AsyncLogger::Flush() {
+  if (!started_.load(std::memory_order_acquire)) {
+    return;
+  }
+  DCHECK(!thread_.task_runner()->BelongsToCurrentThread());
+  base::WaitableEvent done;
+  thread_.task_runner()->PostTask(
+      FROM_HERE, base::BindOnce(
+                     [](AsyncLogger* logger, base::WaitableEvent* done) {
+                       logger->Drain(false);
+                       done->Signal();
+                     },
+                     base::Unretained(this), base::Unretained(&done)));
+  done.Wait();
+}
+
+// static
+LoggingSeverity AsyncLogger::ConvertSeverity(logging::LogSeverity severity) {
+  if (severity >= logging::LOG_FATAL) {
+    return LoggingSeverity::kFatal;
+  }
+  if (severity >= logging::LOG_ERROR) {
+    return LoggingSeverity::kError;
+  }
+  if (severity >= logging::LOG_WARNING) {
+    return LoggingSeverity::kWarning;
+  }
+  if (severity >= logging::LOG_INFO) {
+    return LoggingSeverity::kInfo;
+  }
+  return LoggingSeverity::kVerbose;
+}
+
+// static
+bool AsyncLogger::OnChromiumLogMessage(int severity,
+                                       const char* file,
+                                       int line,
+                                       size_t message_start,
+                                       const std::string& str) {
+  // Fatal messages are written before the process crashes.
+  if (severity >= logging::LOG_FATAL) {
+    return false;
+  }
+  size_t end = str.size();
+  if (end > message_start && str[end - 1] == '\n') {
+    end--;
+  }
+  GetInstance()->Log(severity, file, line,
+                     str.substr(message_start, end - message_start));
+  return true;
+}
+
+void AsyncLogger::EnsureStarted() {
+  if (started_.load(std::memory_order_acquire)) {
+    return;
+  }
+  static base::NoDestructor<base::Lock> start_lock;
+  base::AutoLock lock(*start_lock);
+  if (started_.load(std::memory_order_relaxed)) {
+    return;
+  }
+  CHECK(thread_.Start());
+  thread_.task_runner()->PostTask(
+      FROM_HERE, base::BindOnce(&AsyncLogger::Drain, base::Unretained(this),
+                                true));
+  started_.store(true, std::memory_order_release);
+}
+
+void AsyncLogger::Drain(bool schedule_next) {
+  DCHECK(thread_.task_runner()->BelongsToCurrentThread());
+  LogRecord record;
+  while (buffer_.Pop(&record)) {
+    Deliver(record);
+  }
+  if (schedule_next) {
+    thread_.task_runner()->PostDelayedTask(
+        FROM_HERE,
+        base::BindOnce(&AsyncLogger::Drain, base::Unretained(this), true),
+        kDrainInterval);
+  }
+}
+
+void AsyncLogger::Deliver(const LogRecord& record) {
+  base::AutoLock lock(lock_);
+  if (sink_) {
+    sink_->OnLogMessage(ConvertSeverity(record.severity), record.file,
+                        record.line, record.message.c_str());
+    return;
+  }
+  logging::LogMessage(record.file, record.line, record.severity).stream()
+      << record.message;
+}
+
+AsyncLogMessage::AsyncLogMessage(logging::LogSeverity severity,
+                                 const char* file,
+                                 int line,
+                                 uint64_t suppressed)
+    : severity_(severity), file_(file), line_(line), suppressed_(suppressed) {}
+
+AsyncLogMessage::~AsyncLogMessage() {
+  if (suppressed_ > 0) {
+    stream_ << " (" << suppressed_ << " similar messages suppressed)";
+  }
+  AsyncLogger::GetInstance()->Log(severity_, file_, line_, stream_.str());
+}
+
+}  // namespace quic
+}  // namespace owt
@@ -0,0 +1,184 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef OWT_WEB_TRANSPORT_ASYNC_LOGGER_H_
+#define OWT_WEB_TRANSPORT_ASYNC_LOGGER_H_
+
+#include <array>
+#include <atomic>
+#include <sstream>
+#include <string>
+#include "base/logging.h"
+#include "base/no_destructor.h"
+#include "base/synchronization/lock.h"
+#include "base/thread_annotations.h"
+#include "base/threading/thread.h"
+#include "owt/quic/logging.h"
+
+namespace owt {
+namespace quic {
+
+struct LogRecord {
+  logging::LogSeverity severity;
+  // A string literal, e.g.: __FILE__.
+  const char* file;
+  int line;
+  std::string message;
+};
+
+// A bounded multi-producer single-consumer queue of log records. Push never
+// blocks or allocates, it fails when the queue is full. Long messages are
+// truncated.
+class LogRingBuffer {
+ public:
+  static constexpr size_t kCapacity = 1024;
+  static constexpr size_t kMaxMessageLength = 512;
+
+  LogRingBuffer();
+  ~LogRingBuffer();
+  LogRingBuffer(const LogRingBuffer&) = delete;
+  LogRingBuffer& operator=(const LogRingBuffer&) = delete;
+
+  bool Push(logging::LogSeverity severity,
+            const char* file,
+            int line,
+            const char* message,
+            size_t length);
+  // Only called by the consumer. Returns false if the queue is empty.
+  bool Pop(LogRecord* record);
+
+ private:
+  struct Slot {
+    // Equals to the position of a push when the slot is free, or the position
+    // plus 1 when it holds a record.
+    std::atomic<size_t> sequence;
+    logging::LogSeverity severity;
+    const char* file;
+    int line;
+    size_t length;
+    char message[kMaxMessageLength];
+  };
+
+  std::array<Slot, kCapacity> slots_;
+  alignas(64) std::atomic<size_t> push_position_;
+  alignas(64) size_t pop_position_;
+};
+
+// Limits messages logged by a call site to kMessagesPerSecond. Its constructor
+// is constexpr, so static instances in functions need no initialization guard.
+class LogRateLimiter {
+ public:
+  static constexpr uint32_t kMessagesPerSecond = 10;
+
+  constexpr LogRateLimiter() : window_(0), count_(0), suppressed_(0) {}
+
+  // Returns whether a message could be logged in the current second. When it
+  // returns true, `suppressed` is set to the number of messages suppressed
+  // since the last allowed one.
+  bool Allow(uint64_t* suppressed);
+  bool AllowAt(int64_t now_seconds, uint64_t* suppressed);
+
+ private:
+  std::atomic<int64_t> window_;
+  std::atomic<uint32_t> count_;
+  std::atomic<uint64_t> suppressed_;
+};
+
+// Delivers log messages to a LogSink, or to the default destination of
+// Chromium logging when there is no sink, on a background thread. Methods
+// could be called on any thread.
+class AsyncLogger {
+ public:
+  static AsyncLogger* GetInstance();
+
+  // Queues a message. It's dropped if the queue is full.
+  void Log(logging::LogSeverity severity,
+           const char* file,
+           int line,
+           const std::string& message);
+  void SetSink(LogSink* sink);
+  // Delivers all queued messages before returning.
+  void Flush();
+  uint64_t dropped_messages() const {
+    return dropped_messages_.load(std::memory_order_relaxed);
+  }
+
+  static LoggingSeverity ConvertSeverity(logging::LogSeverity severity);
+
+ private:
+  AsyncLogger();
+  ~AsyncLogger();
+  friend class base::NoDestructor<AsyncLogger>;
+
+  // Handles messages of Chromium logging when a sink is set.
+  static bool OnChromiumLogMessage(int severity,
+                                   const char* file,
+                                   int line,
+                                   size_t message_start,
+                                   const std::string& str);
+
+  // Starts the logging thread if it's not started.
+  void EnsureStarted();
+  // Delivers queued messages and schedules the next pass. Runs on the logging
+  // thread.
+  void Drain(bool schedule_next);
+  void Deliver(const LogRecord& record);
+
+  LogRingBuffer buffer_;
+  std::atomic<uint64_t> dropped_messages_;
+  std::atomic<bool> started_;
+  base::Lock lock_;
+  LogSink* sink_ GUARDED_BY(lock_);
+  base::Thread thread_;
+};
+
+// Collects a message with a stream, and queues it to AsyncLogger when
+// destroyed.
+class AsyncLogMessage {
+ public:
+  AsyncLogMessage(logging::LogSeverity severity,
+                  const char* file,
+                  int line,
+                  uint64_t suppressed);
+  ~AsyncLogMessage();
+  AsyncLogMessage(const AsyncLogMessage&) = delete;
+  AsyncLogMessage& operator=(const AsyncLogMessage&) = delete;
+
+  std::ostream& stream() { return stream_; }
+
+ private:
+  logging::LogSeverity severity_;
+  const char* file_;
+  int line_;
+  uint64_t suppressed_;
+  std::ostringstream stream_;
+};
+
+}  // namespace quic
+}  // namespace owt
+
+// Like LOG(severity), but the message is written on the logging thread, and
+// each call site logs at most LogRateLimiter::kMessagesPerSecond messages per
+// second. Use it on IO threads and other hot paths.
+#define OWT_ASYNC_LOG(severity) OWT_ASYNC_LOG_IF(severity, true)
+#define OWT_ASYNC_DLOG(severity) OWT_ASYNC_LOG_IF(severity, DCHECK_IS_ON())
+
+// The rate limiter is a static variable of a lambda, so each call site has its
+// own. The loop runs at most once.
+#define OWT_ASYNC_LOG_IF(severity, condition)                         \
+  for (uint64_t owt_log_suppressed = 0,                               \
+                owt_log_once = (condition) && LOG_IS_ON(severity) &&  \
+                               [](uint64_t* suppressed) {             \
+                                 static ::owt::quic::LogRateLimiter   \
+                                     limiter;                         \
+                                 return limiter.Allow(suppressed);    \
+                               }(&owt_log_suppressed);                \
+       owt_log_once; owt_log_once = 0)                                \
+  ::owt::quic::AsyncLogMessage(logging::LOG_##severity, __FILE__,     \
+                               __LINE__, owt_log_suppressed)          \
+      .stream()
+
+#endif
@@ -0,0 +1,115 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "owt/web_transport/sdk/impl/async_logger.h"
+#include <memory>
+#include <string>
+#include <vector>
+#include "testing/gmock/include/gmock/gmock.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace owt {
+namespace quic {
+namespace test {
+
+using ::testing::HasSubstr;
+
+namespace {
+class RecordingLogSink : public LogSink {
+ public:
+  void OnLogMessage(LoggingSeverity severity,
+                    const char* file,
+                    int line,
+                    const char* message) override {
+    severities.push_back(severity);
+    messages.push_back(message);
+  }
+
+  std::vector<LoggingSeverity> severities;
+  std::vector<std::string> messages;
+};
+}  // namespace
+
+TEST(LogRingBufferTest, PushAndPop) {
+  auto buffer = std::make_unique<LogRingBuffer>();
+  LogRecord record;
+  EXPECT_FALSE(buffer->Pop(&record));
+  ASSERT_TRUE(buffer->Push(logging::LOG_WARNING, __FILE__, 10, "first", 5));
+  ASSERT_TRUE(buffer->Push(logging::LOG_INFO, __FILE__, 20, "second", 6));
+  ASSERT_TRUE(buffer->Pop(&record));
+  EXPECT_EQ(record.severity, logging::LOG_WARNING);
+  EXPECT_EQ(record.line, 10);
+  EXPECT_EQ(record.message, "first");
+  ASSERT_TRUE(buffer->Pop(&record));
+  EXPECT_EQ(record.message, "second");
+  EXPECT_FALSE(buffer->Pop(&record));
+}
+
+TEST(LogRingBufferTest, PushFailsWhenFull) {
+  auto buffer = std::make_unique<LogRingBuffer>();
+  for (size_t i = 0; i < LogRingBuffer::kCapacity; i++) {
+    ASSERT_TRUE(buffer->Push(logging::LOG_INFO, __FILE__, __LINE__, "m", 1));
+  }
+  EXPECT_FALSE(buffer->Push(logging::LOG_INFO, __FILE__, __LINE__, "m", 1));
+  LogRecord record;
+  ASSERT_TRUE(buffer->Pop(&record));
+  EXPECT_TRUE(buffer->Push(logging::LOG_INFO, __FILE__, __LINE__, "m", 1));
+}
+
+TEST(LogRingBufferTest, TruncateLongMessage) {
+  auto buffer = std::make_unique<LogRingBuffer>();
+  const std::string message(LogRingBuffer::kMaxMessageLength + 10, 'a');
+  ASSERT_TRUE(buffer->Push(logging::LOG_INFO, __FILE__, __LINE__,
+                           message.data(), message.size()));
+  LogRecord record;
+  ASSERT_TRUE(buffer->Pop(&record));
+  EXPECT_EQ(record.message.size(), LogRingBuffer::kMaxMessageLength);
+}
+
+TEST(LogRateLimiterTest, LimitMessagesPerSecond) {
+  LogRateLimiter limiter;
+  uint64_t suppressed = 0;
+  for (uint32_t i = 0; i < LogRateLimiter::kMessagesPerSecond; i++) {
+    EXPECT_TRUE(limiter.AllowAt(1, &suppressed));
+    EXPECT_EQ(suppressed, 0u);
+  }
+  EXPECT_FALSE(limiter.AllowAt(1, &suppressed));
+  EXPECT_FALSE(limiter.AllowAt(1, &suppressed));
+  EXPECT_TRUE(limiter.AllowAt(2, &suppressed));
+  EXPECT_EQ(suppressed, 2u);
+}
+
+TEST(AsyncLoggerTest, DeliverToSink) {
+  RecordingLogSink sink;
+  Logging::SetLogSink(&sink);
+  for (int i = 0; i < 100; i++) {
+    OWT_ASYNC_LOG(ERROR) << "Message " << i;
+  }
+  LOG(ERROR) << "Chromium message";
+  Logging::Flush();
+  Logging::SetLogSink(nullptr);
+  // The call site may cross a second boundary once.
+  ASSERT_GE(sink.messages.size(), LogRateLimiter::kMessagesPerSecond + 1);
+  EXPECT_LE(sink.messages.size(), 2 * LogRateLimiter::kMessagesPerSecond + 1);
+  EXPECT_EQ(sink.messages[0], "Message 0");
+  EXPECT_EQ(sink.severities[0], LoggingSeverity::kError);
+  EXPECT_THAT(sink.messages.back(), HasSubstr("Chromium message"));
+}
+
+TEST(AsyncLoggerTest, ConvertSeverity) {
+  EXPECT_EQ(AsyncLogger::ConvertSeverity(logging::LOG_VERBOSE),
+            LoggingSeverity::kVerbose);
+  EXPECT_EQ(AsyncLogger::ConvertSeverity(logging::LOG_INFO),
+            LoggingSeverity::kInfo);
+  EXPECT_EQ(AsyncLogger::ConvertSeverity(logging::LOG_WARNING),
+            LoggingSeverity::kWarning);
+  EXPECT_EQ(AsyncLogger::ConvertSeverity(logging::LOG_ERROR),
+            LoggingSeverity::kError);
+}
+
+}  // namespace test
+}  // namespace quic
+}  // namespace owt
@@ -0,0 +1,184 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "impl/async_proof_source.h"
+#include <string>
+#include <utility>
+#include "base/bind.h"
+#include "base/check_op.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/threading/thread_task_runner_handle.h"
+
+namespace owt {
+namespace quic {
+
+namespace {
+// Passed to the wrapped ProofSource on a signing thread. Results are posted
+// back to the thread which started the operation.
+class SignatureCallbackRelay : public ::quic::ProofSource::SignatureCallback {
+ public:
+  SignatureCallbackRelay(
+      scoped_refptr<base::SingleThreadTaskRunner> origin_runner,
+      std::unique_ptr<::quic::ProofSource::SignatureCallback> callback)
+      : origin_runner_(std::move(origin_runner)),
+        callback_(std::move(callback)) {}
+
+  void Run(bool ok,
+           std::string signature,
+           std::unique_ptr<::quic::ProofSource::Details> details) override {
+    origin_runner_->PostTask(
+        FROM_HERE,
+        base::BindOnce(
+            [](std::unique_ptr<::quic::ProofSource::SignatureCallback> callback,
+               bool ok, std::string signature,
+               std::unique_ptr<::quic::ProofSource::Details> details) {
+              callback->Run(ok, std::move(signature), std::move(details));
+            },
+            std::move(callback_), ok, std::move(signature),
+            std::move(details)));
+  }
+
+ private:
+  scoped_refptr<base::SingleThreadTaskRunner> origin_runner_;
+  std::unique_ptr<::quic::ProofSource::SignatureCallback> callback_;
+};
+
+class ProofCallbackRelay : public ::quic::ProofSource::Callback {
+ public:
+  ProofCallbackRelay(scoped_refptr<base::SingleThreadTaskRunner> origin_runner,
+                     std::unique_ptr<::quic::ProofSource::Callback> callback)
+      : origin_runner_(std::move(origin_runner)),
+        callback_(std::move(callback)) {}
+
+  void Run(bool ok,
+           const ::quic::QuicReferenceCountedPointer<::quic::ProofSource::Chain>&
+               chain,
+           const ::quic::QuicCryptoProof& proof,
+           std::unique_ptr<::quic::ProofSource::Details> details) override {
+    origin_runner_->PostTask(
+        FROM_HERE,
+        base::BindOnce(
+            [](std::unique_ptr<::quic::ProofSource::Callback> callback, bool ok,
+               ::quic::QuicReferenceCountedPointer<::quic::ProofSource::Chain>
+                   chain,
+               ::quic::QuicCryptoProof proof,
+               std::unique_ptr<::quic::ProofSource::Details> details) {
+              callback->Run(ok, chain, proof, std::move(details));
+            },
+            std::move(callback_), ok, chain, proof, std::move(details)));
+  }
+
+ private:
+  scoped_refptr<base::SingleThreadTaskRunner> origin_runner_;
+  std::unique_ptr<::quic::ProofSource::Callback> callback_;
+};
+}  // namespace
+
+AsyncProofSource::AsyncProofSource(
+    std::unique_ptr<::quic::ProofSource> proof_source,
+    size_t thread_count,
+    const ThreadScheduling* thread_scheduling)
+    : proof_source_(std::move(proof_source)), next_thread_(0) {
+  CHECK(proof_source_);
+  CHECK_GT(thread_count, 0u);
+  for (size_t i = 0; i < thread_count; i++) {
+    auto thread = std::make_unique<base::Thread>(
+        "web_transport_signing_thread_" + base::NumberToString(i));
+    CHECK(thread->Start());
+    if (thread_scheduling) {
+      thread_scheduling->ApplyTo(SdkThread::kSigning, i, thread.get());
+    }
+    threads_.push_back(std::move(thread));
+  }
+}
+
+AsyncProofSource::~AsyncProofSource() {
+  // Signing tasks in flight are completed before `proof_source_` is destroyed.
+  // Their callbacks are dropped if origin threads are already stopped.
+  for (auto& thread : threads_) {
+    thread->Stop();
+  }
+}
+
+base::SingleThreadTaskRunner* AsyncProofSource::NextSigningRunner() {
+  const size_t index = next_thread_.fetch_add(1, std::memory_order_relaxed);
+  return threads_[index % threads_.size()]->task_runner().get();
+}
+
+void AsyncProofSource::GetProof(
+    const ::quic::QuicSocketAddress& server_address,
+    const ::quic::QuicSocketAddress& client_address,
+    const std::string& hostname,
+    const std::string& server_config,
+    ::quic::QuicTransportVersion quic_version,
+    absl::string_view chlo_hash,
+    std::unique_ptr<Callback> callback) {
+  NextSigningRunner()->PostTask(
+      FROM_HERE,
+      base::BindOnce(
+          [](::quic::ProofSource* proof_source,
+             ::quic::QuicSocketAddress server_address,
+             ::quic::QuicSocketAddress client_address, std::string hostname,
+             std::string server_config,
+             ::quic::QuicTransportVersion quic_version, std::string chlo_hash,
+             std::unique_ptr<Callback> callback) {
+            proof_source->GetProof(server_address, client_address, hostname,
+                                   server_config, quic_version, chlo_hash,
+                                   std::move(callback));
+          },
+          base::Unretained(proof_source_.get()), server_address,
+          client_address, hostname, server_config, quic_version,
+          std::string(chlo_hash),
+          std::make_unique<ProofCallbackRelay>(
+              base::ThreadTaskRunnerHandle::Get(), std::move(callback))));
+}
+
+::quic::QuicReferenceCountedPointer<::quic::ProofSource::Chain>
+AsyncProofSource::GetCertChain(const ::quic::QuicSocketAddress& server_address,
+                               const ::quic::QuicSocketAddress& client_address,
+                               const std::string& hostname,
+                               bool* cert_matched_sni) {
+  // No private key operation, it's cheap enough to run on IO threads.
+  return proof_source_->GetCertChain(server_address, client_address, hostname,
+                                     cert_matched_sni);
+}
+
+void AsyncProofSource::ComputeTlsSignature(
+    const ::quic::QuicSocketAddress& server_address,
+    const ::quic::QuicSocketAddress& client_address,
+    const std::string& hostname,
+    uint16_t signature_algorithm,
+    absl::string_view in,
+    std::unique_ptr<SignatureCallback> callback) {
+  NextSigningRunner()->PostTask(
+      FROM_HERE,
+      base::BindOnce(
+          [](::quic::ProofSource* proof_source,
+             ::quic::QuicSocketAddress server_address,
+             ::quic::QuicSocketAddress client_address, std::string hostname,
+             uint16_t signature_algorithm, std::string in,
+             std::unique_ptr<SignatureCallback> callback) {
+            proof_source->ComputeTlsSignature(server_address, client_address,
+                                              hostname, signature_algorithm,
+                                              in, std::move(callback));
+          },
+          base::Unretained(proof_source_.get()), server_address,
+          client_address, hostname, signature_algorithm, std::string(in),
+          std::make_unique<SignatureCallbackRelay>(
+              base::ThreadTaskRunnerHandle::Get(), std::move(callback))));
+}
+
+absl::InlinedVector<uint16_t, 8>
+AsyncProofSource::SupportedTlsSignatureAlgorithms() const {
+  return proof_source_->SupportedTlsSignatureAlgorithms();
+}
+
+::quic::ProofSource::TicketCrypter* AsyncProofSource::GetTicketCrypter() {
+  return proof_source_->GetTicketCrypter();
+}
+
+}  // namespace quic
+}  // namespace owt
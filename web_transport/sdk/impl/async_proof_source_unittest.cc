@@ -0,0 +1,117 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "owt/web_transport/sdk/impl/async_proof_source.h"
+#include "base/run_loop.h"
+#include "base/test/task_environment.h"
+#include "base/threading/platform_thread.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace owt {
+namespace quic {
+namespace test {
+
+namespace {
+// Signs by prefixing the input, and records the signing thread.
+class FakeProofSource : public ::quic::ProofSource {
+ public:
+  explicit FakeProofSource(base::PlatformThreadId* signing_thread)
+      : signing_thread_(signing_thread) {}
+
+  void GetProof(const ::quic::QuicSocketAddress& server_address,
+                const ::quic::QuicSocketAddress& client_address,
+                const std::string& hostname,
+                const std::string& server_config,
+                ::quic::QuicTransportVersion quic_version,
+                absl::string_view chlo_hash,
+                std::unique_ptr<Callback> callback) override {
+    *signing_thread_ = base::PlatformThread::CurrentId();
+    ::quic::QuicCryptoProof proof;
+    proof.signature = "proof:" + server_config;
+    callback->Run(true, nullptr, proof, nullptr);
+  }
+
+  ::quic::QuicReferenceCountedPointer<::quic::ProofSource::Chain> GetCertChain(
+      const ::quic::QuicSocketAddress& server_address,
+      const ::quic::QuicSocketAddress& client_address,
+      const std::string& hostname,
+      bool* cert_matched_sni) override {
+    *cert_matched_sni = false;
+    return nullptr;
+  }
+
+  void ComputeTlsSignature(
+      const ::quic::QuicSocketAddress& server_address,
+      const ::quic::QuicSocketAddress& client_address,
+      const std::string& hostname,
+      uint16_t signature_algorithm,
+      absl::string_view in,
+      std::unique_ptr<SignatureCallback> callback) override {
+    *signing_thread_ = base::PlatformThread::CurrentId();
+    callback->Run(true, "signature:" + std::string(in), nullptr);
+  }
+
+  absl::InlinedVector<uint16_t, 8> SupportedTlsSignatureAlgorithms()
+      const override {
+    return {};
+  }
+
+  TicketCrypter* GetTicketCrypter() override { return nullptr; }
+
+ private:
+  base::PlatformThreadId* signing_thread_;
+};
+
+class TestSignatureCallback : public ::quic::ProofSource::SignatureCallback {
+ public:
+  TestSignatureCallback(std::string* signature,
+                        base::PlatformThreadId* callback_thread,
+                        base::OnceClosure done)
+      : signature_(signature),
+        callback_thread_(callback_thread),
+        done_(std::move(done)) {}
+
+  void Run(bool ok,
+           std::string signature,
+           std::unique_ptr<::quic::ProofSource::Details> details) override {
+    EXPECT_TRUE(ok);
+    *signature_ = std::move(signature);
+    *callback_thread_ = base::PlatformThread::CurrentId();
+    std::move(done_).Run();
+  }
+
+ private:
+  std::string* signature_;
+  base::PlatformThreadId* callback_thread_;
+  base::OnceClosure done_;
+};
+}  // namespace
+
+TEST(AsyncProofSourceTest, SignsOnSigningThread) {
+  base::test::TaskEnvironment task_environment;
+  base::PlatformThreadId signing_thread = base::kInvalidThreadId;
+  base::PlatformThreadId callback_thread = base::kInvalidThreadId;
+  std::string signature;
+  AsyncProofSource proof_source(
+      std::make_unique<FakeProofSource>(&signing_thread), 2, nullptr);
+  EXPECT_EQ(proof_source.thread_count(), 2u);
+  base::RunLoop run_loop;
+  proof_source.ComputeTlsSignature(
+      ::quic::QuicSocketAddress(), ::quic::QuicSocketAddress(), "localhost", 0,
+      "hello",
+      std::make_unique<TestSignatureCallback>(&signature, &callback_thread,
+                                              run_loop.QuitClosure()));
+  // Callback is never run synchronously.
+  EXPECT_TRUE(signature.empty());
+  run_loop.Run();
+  EXPECT_EQ(signature, "signature:hello");
+  EXPECT_NE(signing_thread, base::PlatformThread::CurrentId());
+  EXPECT_EQ(callback_thread, base::PlatformThread::CurrentId());
+}
+
+}  // namespace test
+}  // namespace quic
+}  // namespace owt
@@ -0,0 +1,203 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "impl/certificate_compression.h"
+#include <utility>
+#include "crypto/sha2.h"
+#include "third_party/brotli/include/brotli/decode.h"
+#include "third_party/brotli/include/brotli/encode.h"
+#include "third_party/zlib/zlib.h"
+
+namespace owt {
+namespace quic {
+
+namespace {
+constexpr size_t kDefaultMaxEntries = 16;
+// Lower than the max quality when messages are not cached, since they're
+// compressed for every handshake.
+constexpr int kUncachedBrotliQuality = 5;
+
+int CacheIndex() {
+  static const int index =
+      SSL_CTX_get_ex_new_index(0, nullptr, nullptr, nullptr, nullptr);
+  return index;
+}
+
+CompressedCertificateCache* GetCache(SSL* ssl) {
+  return static_cast<CompressedCertificateCache*>(
+      SSL_CTX_get_ex_data(SSL_get_SSL_CTX(ssl), CacheIndex()));
+}
+
+bool CompressWithBrotli(const uint8_t* in,
+                        size_t in_len,
+                        int quality,
+                        std::string* out) {
+  size_t out_len = BrotliEncoderMaxCompressedSize(in_len);
+  if (out_len == 0) {
+    return false;
+  }
+  out->resize(out_len);
+  if (!BrotliEncoderCompress(quality, BROTLI_DEFAULT_WINDOW,
+                             BROTLI_MODE_GENERIC, in_len, in, &out_len,
+                             reinterpret_cast<uint8_t*>(&(*out)[0]))) {
+    return false;
+  }
+  out->resize(out_len);
+  return true;
+}
+
+bool CompressWithZlib(const uint8_t* in, size_t in_len, std::string* out) {
+  uLongf out_len = compressBound(in_len);
+  out->resize(out_len);
+  if (compress2(reinterpret_cast<Bytef*>(&(*out)[0]), &out_len, in, in_len,
+                Z_BEST_COMPRESSION) != Z_OK) {
+    return false;
+  }
+  out->resize(out_len);
+  return true;
+}
+
+int Compress(uint16_t algorithm,
+             SSL* ssl,
+             CBB* out,
+             const uint8_t* in,
+             size_t in_len) {
+  CompressedCertificateCache* cache = GetCache(ssl);
+  if (cache) {
+    absl::optional<std::string> cached = cache->Get(algorithm, in, in_len);
+    if (cached) {
+      return CBB_add_bytes(
+          out, reinterpret_cast<const uint8_t*>(cached->data()),
+          cached->size());
+    }
+  }
+  std::string compressed;
+  const bool ok =
+      algorithm == TLSEXT_cert_compression_brotli
+          ? CompressWithBrotli(
+                in, in_len, cache ? BROTLI_MAX_QUALITY : kUncachedBrotliQuality,
+                &compressed)
+          : CompressWithZlib(in, in_len, &compressed);
+  if (!ok || !CBB_add_bytes(out,
+                            reinterpret_cast<const uint8_t*>(compressed.data()),
+                            compressed.size())) {
+    return 0;
+  }
+  if (cache) {
+    cache->Put(algorithm, in, in_len, std::move(compressed));
+  }
+  return 1;
+}
+
+int CompressBrotli(SSL* ssl, CBB* out, const uint8_t* in, size_t in_len) {
+  return Compress(TLSEXT_cert_compression_brotli, ssl, out, in, in_len);
+}
+
+int CompressZlib(SSL* ssl, CBB* out, const uint8_t* in, size_t in_len) {
+  return Compress(TLSEXT_cert_compression_zlib, ssl, out, in, in_len);
+}
+
+int DecompressBrotli(SSL* ssl,
+                     CRYPTO_BUFFER** out,
+                     size_t uncompressed_len,
+                     const uint8_t* in,
+                     size_t in_len) {
+  uint8_t* data = nullptr;
+  bssl::UniquePtr<CRYPTO_BUFFER> buffer(
+      CRYPTO_BUFFER_alloc(&data, uncompressed_len));
+  if (!buffer) {
+    return 0;
+  }
+  size_t output_size = uncompressed_len;
+  if (BrotliDecoderDecompress(in_len, in, &output_size, data) !=
+          BROTLI_DECODER_RESULT_SUCCESS ||
+      output_size != uncompressed_len) {
+    return 0;
+  }
+  *out = buffer.release();
+  return 1;
+}
+
+int DecompressZlib(SSL* ssl,
+                   CRYPTO_BUFFER** out,
+                   size_t uncompressed_len,
+                   const uint8_t* in,
+                   size_t in_len) {
+  uint8_t* data = nullptr;
+  bssl::UniquePtr<CRYPTO_BUFFER> buffer(
+      CRYPTO_BUFFER_alloc(&data, uncompressed_len));
+  if (!buffer) {
+    return 0;
+  }
+  uLongf output_size = uncompressed_len;
+  if (uncompress(data, &output_size, in, in_len) != Z_OK ||
+      output_size != uncompressed_len) {
+    return 0;
+  }
+  *out = buffer.release();
+  return 1;
+}
+}  // namespace
+
+CompressedCertificateCache::CompressedCertificateCache(size_t max_entries)
+    : max_entries_(max_entries > 0 ? max_entries : kDefaultMaxEntries) {}
+
+CompressedCertificateCache::~CompressedCertificateCache() = default;
+
+// static
+std::string CompressedCertificateCache::Key(uint16_t algorithm,
+                                            const uint8_t* in,
+                                            size_t in_len) {
+  std::string key(reinterpret_cast<const char*>(&algorithm),
+                  sizeof(algorithm));
+  key += crypto::SHA256HashString(
+      std::string(reinterpret_cast<const char*>(in), in_len));
+  return key;
+}
+
+absl::optional<std::string> CompressedCertificateCache::Get(uint16_t algorithm,
+                                                            const uint8_t* in,
+                                                            size_t in_len) {
+  const std::string key = Key(algorithm, in, in_len);
+  base::AutoLock lock(lock_);
+  auto it = entries_.find(key);
+  if (it == entries_.end()) {
+    return absl::nullopt;
+  }
+  return it->second;
+}
+
+void CompressedCertificateCache::Put(uint16_t algorithm,
+                                     const uint8_t* in,
+                                     size_t in_len,
+                                     std::string compressed) {
+  std::string key = Key(algorithm, in, in_len);
+  base::AutoLock lock(lock_);
+  if (!entries_.emplace(key, std::move(compressed)).second) {
+    return;
+  }
+  insertion_order_.push_back(std::move(key));
+  if (insertion_order_.size() > max_entries_) {
+    entries_.erase(insertion_order_.front());
+    insertion_order_.pop_front();
+  }
+}
+
+bool ConfigureCertificateCompression(SSL_CTX* ssl_ctx,
+                                     CompressedCertificateCache* cache) {
+  if (cache && !SSL_CTX_set_ex_data(ssl_ctx, CacheIndex(), cache)) {
+    return false;
+  }
+  // Brotli is preferred, it has better ratio for certificates.
+  return SSL_CTX_add_cert_compression_alg(ssl_ctx,
+                                          TLSEXT_cert_compression_brotli,
+                                          CompressBrotli, DecompressBrotli) &&
+         SSL_CTX_add_cert_compression_alg(ssl_ctx, TLSEXT_cert_compression_zlib,
+                                          CompressZlib, DecompressZlib);
+}
+
+}  // namespace quic
+}  // namespace owt
@@ -0,0 +1,67 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef OWT_WEB_TRANSPORT_CERTIFICATE_COMPRESSION_H_
+#define OWT_WEB_TRANSPORT_CERTIFICATE_COMPRESSION_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include "base/synchronization/lock.h"
+#include "base/thread_annotations.h"
+#include "third_party/abseil-cpp/absl/container/flat_hash_map.h"
+#include "third_party/abseil-cpp/absl/types/optional.h"
+#include "third_party/boringssl/src/include/openssl/ssl.h"
+
+namespace owt {
+namespace quic {
+
+// Caches certificate messages compressed for RFC 8879, since a server sends
+// the same certificate chain in most of its handshakes. Thread safe, it could
+// be shared by multiple IO threads.
+class CompressedCertificateCache {
+ public:
+  // At most `max_entries` compressed messages are cached, 0 means default
+  // value.
+  explicit CompressedCertificateCache(size_t max_entries);
+  ~CompressedCertificateCache();
+  CompressedCertificateCache(const CompressedCertificateCache&) = delete;
+  CompressedCertificateCache& operator=(const CompressedCertificateCache&) =
+      delete;
+
+  size_t max_entries() const { return max_entries_; }
+
+  // Returns the message compressed by `algorithm` for `in`, if it's cached.
+  absl::optional<std::string> Get(uint16_t algorithm,
+                                  const uint8_t* in,
+                                  size_t in_len);
+  void Put(uint16_t algorithm,
+           const uint8_t* in,
+           size_t in_len,
+           std::string compressed);
+
+ private:
+  static std::string Key(uint16_t algorithm, const uint8_t* in, size_t in_len);
+
+  const size_t max_entries_;
+  base::Lock lock_;
+  absl::flat_hash_map<std::string, std::string> entries_ GUARDED_BY(lock_);
+  // Keys of `entries_`, oldest first.
+  std::deque<std::string> insertion_order_ GUARDED_BY(lock_);
+};
+
+// Adds brotli and zlib certificate compression, as specified by RFC 8879, to
+// `ssl_ctx`. Certificates sent are compressed, and compressed certificates
+// received are decompressed. Compressed messages are cached by `cache` if it's
+// not nullptr, `cache` must outlive `ssl_ctx`. Returns false on failure.
+bool ConfigureCertificateCompression(SSL_CTX* ssl_ctx,
+                                     CompressedCertificateCache* cache);
+
+}  // namespace quic
+}  // namespace owt
+
+#endif
@@ -0,0 +1,59 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "owt/web_transport/sdk/impl/certificate_compression.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace owt {
+namespace quic {
+namespace test {
+
+namespace {
+const uint8_t kCertificate[] = {1, 2, 3, 4, 5, 6, 7, 8};
+const uint8_t kAnotherCertificate[] = {8, 7, 6, 5, 4, 3, 2, 1};
+}  // namespace
+
+TEST(CompressedCertificateCacheTest, GetAndPut) {
+  CompressedCertificateCache cache(0);
+  EXPECT_EQ(cache.max_entries(), 16u);
+  EXPECT_FALSE(cache.Get(TLSEXT_cert_compression_brotli, kCertificate,
+                         sizeof(kCertificate)));
+  cache.Put(TLSEXT_cert_compression_brotli, kCertificate, sizeof(kCertificate),
+            "compressed");
+  EXPECT_EQ(cache.Get(TLSEXT_cert_compression_brotli, kCertificate,
+                      sizeof(kCertificate)),
+            "compressed");
+  // Keyed by algorithm and content.
+  EXPECT_FALSE(cache.Get(TLSEXT_cert_compression_zlib, kCertificate,
+                         sizeof(kCertificate)));
+  EXPECT_FALSE(cache.Get(TLSEXT_cert_compression_brotli, kAnotherCertificate,
+                         sizeof(kAnotherCertificate)));
+}
+
+TEST(CompressedCertificateCacheTest, EvictsOldestEntry) {
+  CompressedCertificateCache cache(1);
+  cache.Put(TLSEXT_cert_compression_brotli, kCertificate, sizeof(kCertificate),
+            "first");
+  cache.Put(TLSEXT_cert_compression_brotli, kAnotherCertificate,
+            sizeof(kAnotherCertificate), "second");
+  EXPECT_FALSE(cache.Get(TLSEXT_cert_compression_brotli, kCertificate,
+                         sizeof(kCertificate)));
+  EXPECT_EQ(cache.Get(TLSEXT_cert_compression_brotli, kAnotherCertificate,
+                      sizeof(kAnotherCertificate)),
+            "second");
+}
+
+TEST(CertificateCompressionTest, Configure) {
+  bssl::UniquePtr<SSL_CTX> ssl_ctx(SSL_CTX_new(TLS_method()));
+  CompressedCertificateCache cache(0);
+  EXPECT_TRUE(ConfigureCertificateCompression(ssl_ctx.get(), &cache));
+  // Algorithms cannot be registered twice.
+  EXPECT_FALSE(ConfigureCertificateCompression(ssl_ctx.get(), nullptr));
+}
+
+}  // namespace test
+}  // namespace quic
+}  // namespace owt
@@ -0,0 +1,170 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "impl/client_batch_packet_io.h"
+
+#if defined(OS_LINUX) || defined(OS_CHROMEOS)
+
+#include <errno.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include "base/bind.h"
+#include "base/logging.h"
+#include "base/memory/ptr_util.h"
+#include "base/posix/eintr_wrapper.h"
+#include "base/threading/sequenced_task_runner_handle.h"
+#include "base/trace_event/trace_event.h"
+#include "impl/tracing.h"
+#include "impl/udp_gso_batch_writer.h"
+#include "net/base/net_errors.h"
+#include "net/quic/address_utils.h"
+#include "net/third_party/quiche/src/quic/core/quic_udp_socket.h"
+
+namespace owt {
+namespace quic {
+
+namespace {
+// Same as UdpPacketIoEngine's default budget of batched reads. A client has a
+// single connection, so there are no new connections to budget.
+constexpr size_t kDefaultMaxPacketsPerRead = 128;
+}  // namespace
+
+// static
+std::unique_ptr<ClientBatchPacketIo> ClientBatchPacketIo::Create(
+    const net::IPEndPoint& server_address,
+    int receive_buffer_size,
+    int send_buffer_size,
+    size_t max_packets_per_read,
+    const ::quic::QuicClock* clock,
+    Visitor* visitor) {
+  DCHECK(clock);
+  DCHECK(visitor);
+  const ::quic::QuicSocketAddress peer_address =
+      net::ToQuicSocketAddress(server_address);
+  const int address_family = peer_address.host().AddressFamilyToInt();
+  ::quic::QuicUdpSocketApi socket_api;
+  ::quic::QuicUdpSocketFd fd =
+      socket_api.Create(address_family, receive_buffer_size, send_buffer_size);
+  if (fd == ::quic::kQuicInvalidSocketFd) {
+    return nullptr;
+  }
+  // Connecting the socket binds it to an ephemeral port, and filters out
+  // datagrams from other peers.
+  const sockaddr_storage peer_storage = peer_address.generic_address();
+  const socklen_t peer_length = address_family == AF_INET6
+                                    ? sizeof(sockaddr_in6)
+                                    : sizeof(sockaddr_in);
+  ::quic::QuicSocketAddress self_address;
+  if (HANDLE_EINTR(connect(fd, reinterpret_cast<const sockaddr*>(&peer_storage),
+                           peer_length)) != 0 ||
+      self_address.FromSocket(fd) != 0) {
+    LOG(WARNING) << "Failed to connect batch socket to "
+                 << server_address.ToString() << ", errno: " << errno;
+    socket_api.Destroy(fd);
+    return nullptr;
+  }
+  return base::WrapUnique(new ClientBatchPacketIo(
+      fd, self_address,
+      max_packets_per_read > 0 ? max_packets_per_read
+                               : kDefaultMaxPacketsPerRead,
+      clock, visitor));
+}
+
+ClientBatchPacketIo::ClientBatchPacketIo(
+    int fd,
+    const ::quic::QuicSocketAddress& self_address,
+    size_t max_packets_per_read,
+    const ::quic::QuicClock* clock,
+    Visitor* visitor)
+    : fd_(fd),
+      self_address_(self_address),
+      max_packets_per_read_(max_packets_per_read),
+      visitor_(visitor),
+      task_runner_(base::SequencedTaskRunnerHandle::Get()),
+      reader_(std::make_unique<UdpBatchPacketReader>(fd, clock)),
+      stopped_(false),
+      read_pending_(false) {
+  reader_->EnableGro();
+}
+
+ClientBatchPacketIo::~ClientBatchPacketIo() {
+  // Stops watching the socket before closing it.
+  reader_.reset();
+  ::quic::QuicUdpSocketApi().Destroy(fd_);
+}
+
+std::unique_ptr<::quic::QuicPacketWriter> ClientBatchPacketIo::CreateWriter() {
+  return std::make_unique<UdpGsoBatchWriter>(
+      fd_, base::BindRepeating(&ClientBatchPacketIo::OnWriteBlocked,
+                               weak_factory_.GetWeakPtr()));
+}
+
+void ClientBatchPacketIo::StartReading() {
+  DCHECK(task_runner_->RunsTasksInCurrentSequence());
+  stopped_ = false;
+  if (!read_pending_) {
+    ReadPackets();
+  }
+}
+
+void ClientBatchPacketIo::ProcessPacket(
+    const ::quic::QuicSocketAddress& self_address,
+    const ::quic::QuicSocketAddress& peer_address,
+    const ::quic::QuicReceivedPacket& packet) {
+  if (stopped_) {
+    return;
+  }
+  if (!visitor_->OnBatchPacket(packet, self_address, peer_address)) {
+    stopped_ = true;
+  }
+}
+
+void ClientBatchPacketIo::ScheduleReadPackets() {
+  read_pending_ = true;
+  task_runner_->PostTask(FROM_HERE,
+                         base::BindOnce(&ClientBatchPacketIo::ReadPackets,
+                                        weak_factory_.GetWeakPtr()));
+}
+
+void ClientBatchPacketIo::ReadPackets() {
+  TRACE_EVENT0(OWT_TRACE_CATEGORY, "ClientBatchPacketIo::ReadPackets");
+  read_pending_ = false;
+  if (stopped_) {
+    return;
+  }
+  int result = reader_->ReadAndDispatchPackets(
+      max_packets_per_read_, self_address_, this,
+      base::BindOnce(&ClientBatchPacketIo::ReadPackets,
+                     weak_factory_.GetWeakPtr()));
+  if (result == net::ERR_IO_PENDING) {
+    read_pending_ = true;
+    return;
+  }
+  if (stopped_) {
+    return;
+  }
+  if (result != net::OK) {
+    stopped_ = true;
+    visitor_->OnBatchReadError(result, this);
+    return;
+  }
+  // The budget is used up, other tasks run before the next pass.
+  ScheduleReadPackets();
+}
+
+void ClientBatchPacketIo::OnWriteBlocked() {
+  reader_->WatchWritable(base::BindOnce(&ClientBatchPacketIo::OnCanWrite,
+                                        weak_factory_.GetWeakPtr()));
+}
+
+void ClientBatchPacketIo::OnCanWrite() {
+  visitor_->OnBatchWriteUnblocked(this);
+}
+
+}  // namespace quic
+}  // namespace owt
+
+#endif  // defined(OS_LINUX) || defined(OS_CHROMEOS)
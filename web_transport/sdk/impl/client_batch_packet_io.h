@@ -0,0 +1,114 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef OWT_WEB_TRANSPORT_CLIENT_BATCH_PACKET_IO_H_
+#define OWT_WEB_TRANSPORT_CLIENT_BATCH_PACKET_IO_H_
+
+#include "build/build_config.h"
+
+#if defined(OS_LINUX) || defined(OS_CHROMEOS)
+
+#include <memory>
+#include "base/memory/weak_ptr.h"
+#include "base/task/sequenced_task_runner.h"
+#include "net/base/ip_endpoint.h"
+#include "net/third_party/quiche/src/quic/core/quic_clock.h"
+#include "net/third_party/quiche/src/quic/core/quic_packet_writer.h"
+#include "net/third_party/quiche/src/quic/core/quic_packets.h"
+#include "net/third_party/quiche/src/quic/core/quic_process_packet_interface.h"
+#include "net/third_party/quiche/src/quic/platform/api/quic_socket_address.h"
+#include "owt/web_transport/sdk/impl/udp_batch_packet_reader.h"
+
+namespace owt {
+namespace quic {
+
+// Packet I/O of a client connection on a UDP socket connected to the server,
+// built on the batch reader and writer of UdpPacketIoEngine. Datagrams are
+// received with recvmmsg, and UDP GRO when kernel supports it, into the
+// reader's ReceiveBufferRing. Each read pass reads up to a budget of packets
+// before yielding to other tasks on the thread. Packets are sent with sendmmsg
+// and UDP GSO. Must be used on the thread which creates it, and the thread must
+// run an IO message pump.
+class ClientBatchPacketIo : public ::quic::ProcessPacketInterface {
+ public:
+  class Visitor {
+   public:
+    virtual ~Visitor() = default;
+    // Returns false to stop reading, the rest of packets received by the same
+    // syscall are dropped. It must not destroy the ClientBatchPacketIo.
+    virtual bool OnBatchPacket(
+        const ::quic::QuicReceivedPacket& packet,
+        const ::quic::QuicSocketAddress& self_address,
+        const ::quic::QuicSocketAddress& peer_address) = 0;
+    // Reading stops after a read error.
+    virtual void OnBatchReadError(int result,
+                                  const ClientBatchPacketIo* packet_io) = 0;
+    // Called when the socket becomes writable after the writer is blocked.
+    virtual void OnBatchWriteUnblocked(
+        const ClientBatchPacketIo* packet_io) = 0;
+  };
+
+  // Returns nullptr if the socket can't be created or connected.
+  // `max_packets_per_read` of 0 means the default budget. `clock` and
+  // `visitor` must outlive the returned object.
+  static std::unique_ptr<ClientBatchPacketIo> Create(
+      const net::IPEndPoint& server_address,
+      int receive_buffer_size,
+      int send_buffer_size,
+      size_t max_packets_per_read,
+      const ::quic::QuicClock* clock,
+      Visitor* visitor);
+  ~ClientBatchPacketIo() override;
+  ClientBatchPacketIo(const ClientBatchPacketIo&) = delete;
+  ClientBatchPacketIo& operator=(const ClientBatchPacketIo&) = delete;
+
+  // Returns a writer sending packets on the socket. It could be owned by a
+  // QuicConnection, and must be destroyed before this object.
+  std::unique_ptr<::quic::QuicPacketWriter> CreateWriter();
+  // Starts reading, or resumes reading after the visitor asked to stop.
+  void StartReading();
+
+  const ::quic::QuicSocketAddress& self_address() const {
+    return self_address_;
+  }
+  size_t max_packets_per_read() const { return max_packets_per_read_; }
+
+  // Overrides ::quic::ProcessPacketInterface.
+  void ProcessPacket(const ::quic::QuicSocketAddress& self_address,
+                     const ::quic::QuicSocketAddress& peer_address,
+                     const ::quic::QuicReceivedPacket& packet) override;
+
+ private:
+  ClientBatchPacketIo(int fd,
+                      const ::quic::QuicSocketAddress& self_address,
+                      size_t max_packets_per_read,
+                      const ::quic::QuicClock* clock,
+                      Visitor* visitor);
+
+  void ScheduleReadPackets();
+  void ReadPackets();
+  void OnWriteBlocked();
+  void OnCanWrite();
+
+  const int fd_;
+  const ::quic::QuicSocketAddress self_address_;
+  const size_t max_packets_per_read_;
+  Visitor* visitor_;  // Not owned.
+  scoped_refptr<base::SequencedTaskRunner> task_runner_;
+  std::unique_ptr<UdpBatchPacketReader> reader_;
+  // Whether the visitor asked to stop reading, or a read error occurred.
+  bool stopped_;
+  // Whether a read pass is posted, or waits for the socket to be readable.
+  bool read_pending_;
+  base::WeakPtrFactory<ClientBatchPacketIo> weak_factory_{this};
+};
+
+}  // namespace quic
+}  // namespace owt
+
+#endif  // defined(OS_LINUX) || defined(OS_CHROMEOS)
+
+#endif
@@ -0,0 +1,196 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "owt/web_transport/sdk/impl/client_batch_packet_io.h"
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+#include "base/check_op.h"
+#include "base/run_loop.h"
+#include "base/test/task_environment.h"
+#include "net/base/ip_address.h"
+#include "net/third_party/quiche/src/quic/core/quic_default_clock.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace owt {
+namespace quic {
+namespace test {
+
+namespace {
+const size_t kPacketSize = 1000;
+
+// A UDP socket bound to an ephemeral port on IPv4 loopback, acting as the
+// server. Receiving times out after a second.
+class LoopbackServer {
+ public:
+  LoopbackServer() {
+    fd_ = socket(AF_INET, SOCK_DGRAM, 0);
+    CHECK_GE(fd_, 0);
+    struct sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    CHECK_EQ(bind(fd_, reinterpret_cast<struct sockaddr*>(&address),
+                  sizeof(address)),
+             0);
+    CHECK_EQ(address_.FromSocket(fd_), 0);
+    struct timeval timeout = {/*tv_sec=*/1, /*tv_usec=*/0};
+    CHECK_EQ(
+        setsockopt(fd_, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout)),
+        0);
+  }
+  ~LoopbackServer() { close(fd_); }
+  LoopbackServer(const LoopbackServer&) = delete;
+  LoopbackServer& operator=(const LoopbackServer&) = delete;
+
+  void SendTo(const std::string& packet,
+              const ::quic::QuicSocketAddress& peer_address) {
+    const sockaddr_storage peer = peer_address.generic_address();
+    CHECK_EQ(sendto(fd_, packet.data(), packet.size(), 0,
+                    reinterpret_cast<const sockaddr*>(&peer),
+                    sizeof(sockaddr_in)),
+             static_cast<ssize_t>(packet.size()));
+  }
+
+  // Returns an empty string if nothing is received.
+  std::string Receive() {
+    char buffer[2 * kPacketSize];
+    ssize_t length = recv(fd_, buffer, sizeof(buffer), 0);
+    return length > 0 ? std::string(buffer, length) : std::string();
+  }
+
+  net::IPEndPoint endpoint() const {
+    return net::IPEndPoint(net::IPAddress::IPv4Localhost(), address_.port());
+  }
+  const ::quic::QuicSocketAddress& address() const { return address_; }
+
+ private:
+  int fd_;
+  ::quic::QuicSocketAddress address_;
+};
+
+class RecordingVisitor : public ClientBatchPacketIo::Visitor {
+ public:
+  bool OnBatchPacket(const ::quic::QuicReceivedPacket& packet,
+                     const ::quic::QuicSocketAddress& self_address,
+                     const ::quic::QuicSocketAddress& peer_address) override {
+    packets.emplace_back(packet.data(), packet.length());
+    self_addresses.push_back(self_address);
+    peer_addresses.push_back(peer_address);
+    return keep_reading;
+  }
+  void OnBatchReadError(int result,
+                        const ClientBatchPacketIo* packet_io) override {
+    read_errors++;
+  }
+  void OnBatchWriteUnblocked(const ClientBatchPacketIo* packet_io) override {}
+
+  bool keep_reading = true;
+  std::vector<std::string> packets;
+  std::vector<::quic::QuicSocketAddress> self_addresses;
+  std::vector<::quic::QuicSocketAddress> peer_addresses;
+  int read_errors = 0;
+};
+
+std::string Packet(size_t index) {
+  return std::string(kPacketSize, static_cast<char>('a' + index % 26));
+}
+}  // namespace
+
+class ClientBatchPacketIoTest : public testing::Test {
+ protected:
+  std::unique_ptr<ClientBatchPacketIo> CreatePacketIo(
+      size_t max_packets_per_read) {
+    return ClientBatchPacketIo::Create(server_.endpoint(),
+                                       /*receive_buffer_size=*/1024 * 1024,
+                                       /*send_buffer_size=*/1024 * 1024,
+                                       max_packets_per_read, &clock_,
+                                       &visitor_);
+  }
+
+  base::test::TaskEnvironment task_environment_{
+      base::test::TaskEnvironment::MainThreadType::IO};
+  ::quic::QuicDefaultClock clock_;
+  LoopbackServer server_;
+  RecordingVisitor visitor_;
+};
+
+TEST_F(ClientBatchPacketIoTest, ConnectsToServer) {
+  auto packet_io = CreatePacketIo(/*max_packets_per_read=*/0);
+  ASSERT_TRUE(packet_io);
+  EXPECT_TRUE(packet_io->self_address().IsInitialized());
+  EXPECT_NE(packet_io->self_address().port(), 0);
+  EXPECT_GT(packet_io->max_packets_per_read(), 0u);
+}
+
+TEST_F(ClientBatchPacketIoTest, ReadsPacketsInBudgetedPasses) {
+  auto packet_io = CreatePacketIo(/*max_packets_per_read=*/2);
+  ASSERT_TRUE(packet_io);
+  EXPECT_EQ(packet_io->max_packets_per_read(), 2u);
+  std::vector<std::string> packets;
+  for (size_t i = 0; i < 5; i++) {
+    packets.push_back(Packet(i));
+    server_.SendTo(packets.back(), packet_io->self_address());
+  }
+  // The first pass runs synchronously, and stops at the budget.
+  packet_io->StartReading();
+  EXPECT_EQ(visitor_.packets.size(), 2u);
+  // Other passes are posted.
+  base::RunLoop().RunUntilIdle();
+  EXPECT_EQ(visitor_.packets, packets);
+  for (size_t i = 0; i < packets.size(); i++) {
+    EXPECT_EQ(visitor_.self_addresses[i], packet_io->self_address());
+    EXPECT_EQ(visitor_.peer_addresses[i], server_.address());
+  }
+  // Packets arriving later are read once the socket becomes readable.
+  packets.push_back(Packet(5));
+  server_.SendTo(packets.back(), packet_io->self_address());
+  for (int i = 0; i < 100 && visitor_.packets.size() < packets.size(); i++) {
+    base::RunLoop().RunUntilIdle();
+  }
+  EXPECT_EQ(visitor_.packets, packets);
+  EXPECT_EQ(visitor_.read_errors, 0);
+}
+
+TEST_F(ClientBatchPacketIoTest, StopsWhenVisitorRefusesPacket) {
+  // A budget of one packet per syscall, so no packet is dropped on stopping.
+  auto packet_io = CreatePacketIo(/*max_packets_per_read=*/1);
+  ASSERT_TRUE(packet_io);
+  std::vector<std::string> packets;
+  for (size_t i = 0; i < 3; i++) {
+    packets.push_back(Packet(i));
+    server_.SendTo(packets.back(), packet_io->self_address());
+  }
+  visitor_.keep_reading = false;
+  packet_io->StartReading();
+  base::RunLoop().RunUntilIdle();
+  EXPECT_EQ(visitor_.packets.size(), 1u);
+  visitor_.keep_reading = true;
+  packet_io->StartReading();
+  base::RunLoop().RunUntilIdle();
+  EXPECT_EQ(visitor_.packets, packets);
+}
+
+TEST_F(ClientBatchPacketIoTest, WriterSendsToServer) {
+  auto packet_io = CreatePacketIo(/*max_packets_per_read=*/0);
+  ASSERT_TRUE(packet_io);
+  std::unique_ptr<::quic::QuicPacketWriter> writer = packet_io->CreateWriter();
+  const std::string packet = Packet(0);
+  EXPECT_EQ(writer
+                ->WritePacket(packet.data(), packet.size(),
+                              packet_io->self_address().host(),
+                              server_.address(), nullptr)
+                .status,
+            ::quic::WRITE_STATUS_OK);
+  EXPECT_EQ(writer->Flush().status, ::quic::WRITE_STATUS_OK);
+  EXPECT_EQ(server_.Receive(), packet);
+}
+
+}  // namespace test
+}  // namespace quic
+}  // namespace owt
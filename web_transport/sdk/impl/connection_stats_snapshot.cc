@@ -0,0 +1,54 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "impl/connection_stats_snapshot.h"
+#include <cstring>
+#include <type_traits>
+
+namespace owt {
+namespace quic {
+
+static_assert(std::is_trivially_copyable<ConnectionStats>::value,
+              "ConnectionStats must be trivially copyable.");
+static_assert(sizeof(ConnectionStats) % sizeof(uint64_t) == 0,
+              "All fields of ConnectionStats must be 64 bits.");
+
+ConnectionStatsSnapshot::ConnectionStatsSnapshot() : sequence_(0) {
+  for (auto& word : words_) {
+    word.store(0, std::memory_order_relaxed);
+  }
+}
+
+ConnectionStatsSnapshot::~ConnectionStatsSnapshot() {}
+
+void ConnectionStatsSnapshot::Publish(const ConnectionStats& stats) {
+  uint64_t words[kWords];
+  memcpy(words, &stats, sizeof(words));
+  const uint32_t sequence = sequence_.load(std::memory_order_relaxed);
+  sequence_.store(sequence + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  for (size_t i = 0; i < kWords; i++) {
+    words_[i].store(words[i], std::memory_order_relaxed);
+  }
+  sequence_.store(sequence + 2, std::memory_order_release);
+}
+
+void ConnectionStatsSnapshot::Read(ConnectionStats* stats) const {
+  uint64_t words[kWords];
+  uint32_t begin, end;
+  do {
+    begin = sequence_.load(std::memory_order_acquire);
+    for (size_t i = 0; i < kWords; i++) {
+      words[i] = words_[i].load(std::memory_order_relaxed);
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    end = sequence_.load(std::memory_order_relaxed);
+  } while ((begin & 1) || begin != end);
+  memcpy(stats, words, sizeof(words));
+}
+
+}  // namespace quic
+}  // namespace owt
@@ -0,0 +1,42 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef OWT_WEB_TRANSPORT_CONNECTION_STATS_SNAPSHOT_H_
+#define OWT_WEB_TRANSPORT_CONNECTION_STATS_SNAPSHOT_H_
+
+#include <atomic>
+#include <cstdint>
+#include "owt/quic/web_transport_definitions.h"
+
+namespace owt {
+namespace quic {
+
+// Holds the latest ConnectionStats published by IO thread. It's a sequence
+// lock, so readers on other threads never block the writer, and always get a
+// consistent copy. Only one thread is allowed to publish stats.
+class ConnectionStatsSnapshot {
+ public:
+  ConnectionStatsSnapshot();
+  ~ConnectionStatsSnapshot();
+  ConnectionStatsSnapshot(const ConnectionStatsSnapshot&) = delete;
+  ConnectionStatsSnapshot& operator=(const ConnectionStatsSnapshot&) = delete;
+
+  void Publish(const ConnectionStats& stats);
+  // Copies the latest stats published to `stats`.
+  void Read(ConnectionStats* stats) const;
+
+ private:
+  static constexpr size_t kWords = sizeof(ConnectionStats) / sizeof(uint64_t);
+
+  // Odd when a writer is updating `words_`.
+  std::atomic<uint32_t> sequence_;
+  std::atomic<uint64_t> words_[kWords];
+};
+
+}  // namespace quic
+}  // namespace owt
+
+#endif
@@ -0,0 +1,41 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "owt/web_transport/sdk/impl/connection_stats_snapshot.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace owt {
+namespace quic {
+namespace test {
+
+TEST(ConnectionStatsSnapshotTest, ZeroBeforePublish) {
+  ConnectionStatsSnapshot snapshot;
+  ConnectionStats stats;
+  stats.estimated_bandwidth = 1;
+  snapshot.Read(&stats);
+  EXPECT_EQ(stats.estimated_bandwidth, 0u);
+  EXPECT_EQ(stats.smoothed_rtt_us, 0u);
+}
+
+TEST(ConnectionStatsSnapshotTest, ReadLatestPublished) {
+  ConnectionStatsSnapshot snapshot;
+  ConnectionStats stats = {};
+  stats.estimated_bandwidth = 1000000;
+  stats.smoothed_rtt_us = 20000;
+  stats.datagrams_dropped = 3;
+  snapshot.Publish(stats);
+  stats.smoothed_rtt_us = 30000;
+  snapshot.Publish(stats);
+  ConnectionStats result;
+  snapshot.Read(&result);
+  EXPECT_EQ(result.estimated_bandwidth, 1000000u);
+  EXPECT_EQ(result.smoothed_rtt_us, 30000u);
+  EXPECT_EQ(result.datagrams_dropped, 3u);
+}
+
+}  // namespace test
+}  // namespace quic
+}  // namespace owt
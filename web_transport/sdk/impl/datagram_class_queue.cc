@@ -0,0 +1,136 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "impl/datagram_class_queue.h"
+#include <algorithm>
+#include <utility>
+#include "base/check.h"
+
+namespace owt {
+namespace quic {
+
+DatagramClassQueue::DatagramClassQueue(const ::quic::QuicClock* clock)
+    : clock_(clock), size_(0), bytes_(0), dropped_(0) {
+  CHECK(clock_);
+}
+
+DatagramClassQueue::~DatagramClassQueue() = default;
+
+void DatagramClassQueue::SetClasses(
+    const std::vector<DatagramClassOptions>& classes) {
+  const size_t count = std::min(classes.size(), kMaxClassCount);
+  while (classes_.size() > count) {
+    Class& removed = classes_.back();
+    while (!removed.entries.empty()) {
+      PopFront(removed);
+      dropped_++;
+    }
+    classes_.pop_back();
+  }
+  classes_.resize(count);
+  for (size_t i = 0; i < count; i++) {
+    Class& datagram_class = classes_[i];
+    datagram_class.max_queued_datagrams =
+        classes[i].max_queued_datagrams > 0 ? classes[i].max_queued_datagrams
+                                            : kDefaultMaxQueuedDatagrams;
+    datagram_class.drop_policy = classes[i].drop_policy;
+    datagram_class.max_age =
+        ::quic::QuicTime::Delta::FromMilliseconds(classes[i].max_age_ms);
+    while (datagram_class.entries.size() >
+           datagram_class.max_queued_datagrams) {
+      if (datagram_class.drop_policy == DatagramDropPolicy::kDropOldest) {
+        PopFront(datagram_class);
+      } else {
+        PopBack(datagram_class);
+      }
+      dropped_++;
+    }
+  }
+}
+
+bool DatagramClassQueue::Enqueue(uint32_t priority_class,
+                                 ::quic::QuicMemSlice datagram) {
+  DCHECK(enabled());
+  Class& datagram_class =
+      classes_[std::min<size_t>(priority_class, classes_.size() - 1)];
+  const ::quic::QuicTime now = clock_->ApproximateNow();
+  DropExpired(datagram_class, now);
+  if (datagram_class.entries.size() >= datagram_class.max_queued_datagrams) {
+    if (datagram_class.drop_policy == DatagramDropPolicy::kTailDrop) {
+      return false;
+    }
+    PopFront(datagram_class);
+    dropped_++;
+  }
+  size_++;
+  bytes_ += datagram.length();
+  datagram_class.entries.push_back(Entry{std::move(datagram), now});
+  return true;
+}
+
+bool DatagramClassQueue::Dequeue(::quic::QuicMemSlice* datagram) {
+  DCHECK(datagram);
+  if (empty()) {
+    return false;
+  }
+  const ::quic::QuicTime now = clock_->ApproximateNow();
+  for (Class& datagram_class : classes_) {
+    DropExpired(datagram_class, now);
+    if (datagram_class.entries.empty()) {
+      continue;
+    }
+    Entry& entry = datagram_class.entries.front();
+    size_--;
+    bytes_ -= entry.datagram.length();
+    *datagram = std::move(entry.datagram);
+    datagram_class.entries.pop_front();
+    return true;
+  }
+  return false;
+}
+
+void DatagramClassQueue::Clear() {
+  for (Class& datagram_class : classes_) {
+    dropped_ += datagram_class.entries.size();
+    datagram_class.entries.clear();
+  }
+  size_ = 0;
+  bytes_ = 0;
+}
+
+size_t DatagramClassQueue::TakeDroppedCount() {
+  return std::exchange(dropped_, 0);
+}
+
+void DatagramClassQueue::PopFront(Class& datagram_class) {
+  DCHECK(!datagram_class.entries.empty());
+  size_--;
+  bytes_ -= datagram_class.entries.front().datagram.length();
+  datagram_class.entries.pop_front();
+}
+
+void DatagramClassQueue::PopBack(Class& datagram_class) {
+  DCHECK(!datagram_class.entries.empty());
+  size_--;
+  bytes_ -= datagram_class.entries.back().datagram.length();
+  datagram_class.entries.pop_back();
+}
+
+void DatagramClassQueue::DropExpired(Class& datagram_class,
+                                     ::quic::QuicTime now) {
+  if (datagram_class.max_age.IsZero()) {
+    return;
+  }
+  while (!datagram_class.entries.empty() &&
+         now - datagram_class.entries.front().enqueue_time >
+             datagram_class.max_age) {
+    PopFront(datagram_class);
+    dropped_++;
+  }
+}
+
+}  // namespace quic
+}  // namespace owt
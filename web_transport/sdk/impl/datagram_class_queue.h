@@ -0,0 +1,92 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef OWT_WEB_TRANSPORT_DATAGRAM_CLASS_QUEUE_H_
+#define OWT_WEB_TRANSPORT_DATAGRAM_CLASS_QUEUE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "base/containers/circular_deque.h"
+#include "net/third_party/quiche/src/quic/core/quic_clock.h"
+#include "net/third_party/quiche/src/quic/core/quic_time.h"
+#include "net/third_party/quiche/src/quic/platform/api/quic_mem_slice.h"
+#include "owt/quic/web_transport_definitions.h"
+
+namespace owt {
+namespace quic {
+
+// Outgoing datagrams blocked by congestion control, in priority classes
+// described by DatagramClassOptions. Unlike QUIC's datagram queue, which is a
+// single FIFO, datagrams are taken from the highest priority class having
+// one, and each class drops datagrams by its own policy when it's full. The
+// owner sends taken datagrams once the connection can send. Not thread safe.
+class DatagramClassQueue {
+ public:
+  // Used when DatagramClassOptions::max_queued_datagrams is 0.
+  static constexpr uint32_t kDefaultMaxQueuedDatagrams = 64;
+  static constexpr size_t kMaxClassCount = 8;
+
+  explicit DatagramClassQueue(const ::quic::QuicClock* clock);
+  ~DatagramClassQueue();
+  DatagramClassQueue(const DatagramClassQueue&) = delete;
+  DatagramClassQueue& operator=(const DatagramClassQueue&) = delete;
+
+  // Replaces classes with the first kMaxClassCount of `classes`. Datagrams
+  // stay in classes with the same index, and are dropped by the new policies
+  // if they don't fit. Datagrams of removed classes are dropped. Empty
+  // `classes` disables the queue.
+  void SetClasses(const std::vector<DatagramClassOptions>& classes);
+  bool enabled() const { return !classes_.empty(); }
+  size_t class_count() const { return classes_.size(); }
+
+  // Queues `datagram` in `priority_class`, or the last class if it's larger.
+  // Returns false if the class rejects it.
+  bool Enqueue(uint32_t priority_class, ::quic::QuicMemSlice datagram);
+  // Moves the oldest datagram of the highest priority class having one to
+  // `datagram`, dropping expired datagrams first. Returns false if nothing is
+  // queued.
+  bool Dequeue(::quic::QuicMemSlice* datagram);
+  // Drops every queued datagram.
+  void Clear();
+
+  bool empty() const { return size_ == 0; }
+  size_t size() const { return size_; }
+  // Bytes of queued datagrams.
+  size_t bytes() const { return bytes_; }
+  // Returns the number of datagrams dropped after they were queued since the
+  // last call.
+  size_t TakeDroppedCount();
+
+ private:
+  struct Entry {
+    ::quic::QuicMemSlice datagram;
+    ::quic::QuicTime enqueue_time;
+  };
+  struct Class {
+    size_t max_queued_datagrams;
+    DatagramDropPolicy drop_policy;
+    // Zero means no limit.
+    ::quic::QuicTime::Delta max_age;
+    base::circular_deque<Entry> entries;
+  };
+
+  void PopFront(Class& datagram_class);
+  void PopBack(Class& datagram_class);
+  // Drops datagrams of `datagram_class` older than its max age.
+  void DropExpired(Class& datagram_class, ::quic::QuicTime now);
+
+  const ::quic::QuicClock* clock_;  // Not owned.
+  std::vector<Class> classes_;
+  size_t size_;
+  size_t bytes_;
+  size_t dropped_;
+};
+
+}  // namespace quic
+}  // namespace owt
+
+#endif
@@ -0,0 +1,136 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "owt/web_transport/sdk/impl/datagram_class_queue.h"
+#include <string>
+#include "net/third_party/quiche/src/quic/core/quic_simple_buffer_allocator.h"
+#include "net/third_party/quiche/src/quic/test_tools/mock_clock.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace owt {
+namespace quic {
+namespace test {
+
+namespace {
+DatagramClassOptions ClassOptions(uint32_t max_queued_datagrams,
+                                  DatagramDropPolicy drop_policy,
+                                  uint32_t max_age_ms) {
+  DatagramClassOptions options;
+  options.max_queued_datagrams = max_queued_datagrams;
+  options.drop_policy = drop_policy;
+  options.max_age_ms = max_age_ms;
+  return options;
+}
+
+class DatagramClassQueueTest : public testing::Test {
+ protected:
+  DatagramClassQueueTest() : queue_(&clock_) {
+    clock_.AdvanceTime(::quic::QuicTime::Delta::FromSeconds(1));
+  }
+
+  bool Enqueue(uint32_t priority_class, const std::string& data) {
+    return queue_.Enqueue(priority_class,
+                          ::quic::QuicMemSlice(::quic::QuicBuffer::Copy(
+                              &allocator_, absl::string_view(data))));
+  }
+
+  std::string Dequeue() {
+    ::quic::QuicMemSlice datagram;
+    if (!queue_.Dequeue(&datagram)) {
+      return std::string();
+    }
+    return std::string(datagram.AsStringView());
+  }
+
+  ::quic::MockClock clock_;
+  ::quic::SimpleBufferAllocator allocator_;
+  DatagramClassQueue queue_;
+};
+}  // namespace
+
+TEST_F(DatagramClassQueueTest, DequeueByPriority) {
+  EXPECT_FALSE(queue_.enabled());
+  queue_.SetClasses({DatagramClassOptions(), DatagramClassOptions()});
+  ASSERT_TRUE(queue_.enabled());
+  EXPECT_TRUE(Enqueue(1, "video1"));
+  EXPECT_TRUE(Enqueue(0, "audio1"));
+  EXPECT_TRUE(Enqueue(1, "video2"));
+  // Clamped to the last class.
+  EXPECT_TRUE(Enqueue(7, "video3"));
+  EXPECT_TRUE(Enqueue(0, "audio2"));
+  EXPECT_EQ(5u, queue_.size());
+  EXPECT_EQ(30u, queue_.bytes());
+  EXPECT_EQ("audio1", Dequeue());
+  EXPECT_EQ("audio2", Dequeue());
+  EXPECT_EQ("video1", Dequeue());
+  EXPECT_TRUE(Enqueue(0, "audio3"));
+  EXPECT_EQ("audio3", Dequeue());
+  EXPECT_EQ("video2", Dequeue());
+  EXPECT_EQ("video3", Dequeue());
+  EXPECT_EQ("", Dequeue());
+  EXPECT_TRUE(queue_.empty());
+  EXPECT_EQ(0u, queue_.bytes());
+  EXPECT_EQ(0u, queue_.TakeDroppedCount());
+}
+
+TEST_F(DatagramClassQueueTest, DropPolicies) {
+  queue_.SetClasses({ClassOptions(2, DatagramDropPolicy::kTailDrop, 0),
+                     ClassOptions(2, DatagramDropPolicy::kDropOldest, 0)});
+  EXPECT_TRUE(Enqueue(0, "a1"));
+  EXPECT_TRUE(Enqueue(0, "a2"));
+  EXPECT_FALSE(Enqueue(0, "a3"));
+  EXPECT_TRUE(Enqueue(1, "b1"));
+  EXPECT_TRUE(Enqueue(1, "b2"));
+  EXPECT_TRUE(Enqueue(1, "b3"));
+  // Rejected datagrams are not counted.
+  EXPECT_EQ(1u, queue_.TakeDroppedCount());
+  EXPECT_EQ(0u, queue_.TakeDroppedCount());
+  EXPECT_EQ("a1", Dequeue());
+  EXPECT_EQ("a2", Dequeue());
+  EXPECT_EQ("b2", Dequeue());
+  EXPECT_EQ("b3", Dequeue());
+}
+
+TEST_F(DatagramClassQueueTest, DropExpiredDatagrams) {
+  queue_.SetClasses({ClassOptions(0, DatagramDropPolicy::kDropOldest, 0),
+                     ClassOptions(0, DatagramDropPolicy::kDropOldest, 100)});
+  EXPECT_TRUE(Enqueue(0, "a1"));
+  EXPECT_TRUE(Enqueue(1, "b1"));
+  clock_.AdvanceTime(::quic::QuicTime::Delta::FromMilliseconds(60));
+  EXPECT_TRUE(Enqueue(1, "b2"));
+  clock_.AdvanceTime(::quic::QuicTime::Delta::FromMilliseconds(60));
+  EXPECT_EQ("a1", Dequeue());
+  EXPECT_EQ("b2", Dequeue());
+  EXPECT_EQ(1u, queue_.TakeDroppedCount());
+  EXPECT_TRUE(queue_.empty());
+}
+
+TEST_F(DatagramClassQueueTest, ReplaceClasses) {
+  queue_.SetClasses({ClassOptions(0, DatagramDropPolicy::kTailDrop, 0),
+                     ClassOptions(0, DatagramDropPolicy::kDropOldest, 0),
+                     ClassOptions(0, DatagramDropPolicy::kTailDrop, 0)});
+  EXPECT_TRUE(Enqueue(0, "a1"));
+  EXPECT_TRUE(Enqueue(0, "a2"));
+  EXPECT_TRUE(Enqueue(1, "b1"));
+  EXPECT_TRUE(Enqueue(1, "b2"));
+  EXPECT_TRUE(Enqueue(2, "c1"));
+  // Classes beyond the new count are dropped, others are trimmed by their
+  // new policies.
+  queue_.SetClasses({ClassOptions(1, DatagramDropPolicy::kTailDrop, 0),
+                     ClassOptions(1, DatagramDropPolicy::kDropOldest, 0)});
+  EXPECT_EQ(3u, queue_.TakeDroppedCount());
+  EXPECT_EQ("a1", Dequeue());
+  EXPECT_EQ("b2", Dequeue());
+  EXPECT_TRUE(Enqueue(1, "b3"));
+  queue_.Clear();
+  EXPECT_EQ(1u, queue_.TakeDroppedCount());
+  queue_.SetClasses({});
+  EXPECT_FALSE(queue_.enabled());
+}
+
+}  // namespace test
+}  // namespace quic
+}  // namespace owt
@@ -0,0 +1,60 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef OWT_WEB_TRANSPORT_EVENT_THREAD_POOL_H_
+#define OWT_WEB_TRANSPORT_EVENT_THREAD_POOL_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "base/memory/scoped_refptr.h"
+#include "base/task/single_thread_task_runner.h"
+#include "base/threading/thread.h"
+#include "owt/web_transport/sdk/impl/thread_scheduling.h"
+#include "third_party/abseil-cpp/absl/strings/string_view.h"
+
+namespace owt {
+namespace quic {
+
+// A fixed set of threads running visitor callbacks. Each session is pinned to
+// one of them by the hash of a key, e.g.: its connection ID, so callbacks of a
+// session keep their order, while a slow callback only delays sessions pinned
+// to the same thread. All methods are thread safe.
+class EventThreadPool {
+ public:
+  // `default_runner` is the first runner of the pool, `thread_count` - 1 more
+  // threads are started. `thread_count` 0 is treated as 1. Started threads
+  // are scheduled by `thread_scheduling` as SdkThread::kEvent threads 1 to
+  // `thread_count` - 1. It could be nullptr.
+  EventThreadPool(scoped_refptr<base::SingleThreadTaskRunner> default_runner,
+                  size_t thread_count,
+                  const ThreadScheduling* thread_scheduling);
+  // Stops threads started by this pool. Tasks not ran are dropped.
+  ~EventThreadPool();
+  EventThreadPool(const EventThreadPool&) = delete;
+  EventThreadPool& operator=(const EventThreadPool&) = delete;
+
+  size_t size() const { return runners_.size(); }
+  base::SingleThreadTaskRunner* default_runner() const {
+    return runners_[0].get();
+  }
+  // `index` must be less than size().
+  base::SingleThreadTaskRunner* runner(size_t index) const {
+    return runners_[index].get();
+  }
+  // Returns the runner `key` is pinned to. The same key is always pinned to
+  // the same runner.
+  base::SingleThreadTaskRunner* GetTaskRunner(absl::string_view key) const;
+
+ private:
+  std::vector<std::unique_ptr<base::Thread>> threads_;
+  std::vector<scoped_refptr<base::SingleThreadTaskRunner>> runners_;
+};
+
+}  // namespace quic
+}  // namespace owt
+
+#endif
@@ -0,0 +1,47 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "owt/web_transport/sdk/impl/event_thread_pool.h"
+#include <set>
+#include "base/strings/string_number_conversions.h"
+#include "base/test/task_environment.h"
+#include "base/threading/thread_task_runner_handle.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace owt {
+namespace quic {
+namespace test {
+
+TEST(EventThreadPoolTest, SingleThread) {
+  base::test::TaskEnvironment task_environment;
+  scoped_refptr<base::SingleThreadTaskRunner> runner =
+      base::ThreadTaskRunnerHandle::Get();
+  EventThreadPool pool(runner, 0, nullptr);
+  EXPECT_EQ(pool.size(), 1u);
+  EXPECT_EQ(pool.GetTaskRunner("session"), runner.get());
+}
+
+TEST(EventThreadPoolTest, KeysArePinned) {
+  base::test::TaskEnvironment task_environment;
+  scoped_refptr<base::SingleThreadTaskRunner> runner =
+      base::ThreadTaskRunnerHandle::Get();
+  EventThreadPool pool(runner, 4, nullptr);
+  ASSERT_EQ(pool.size(), 4u);
+  EXPECT_EQ(pool.default_runner(), runner.get());
+  std::set<base::SingleThreadTaskRunner*> used_runners;
+  for (int i = 0; i < 64; i++) {
+    const std::string key = "session" + base::NumberToString(i);
+    base::SingleThreadTaskRunner* key_runner = pool.GetTaskRunner(key);
+    EXPECT_EQ(pool.GetTaskRunner(key), key_runner);
+    used_runners.insert(key_runner);
+  }
+  // Sessions are spread over more than one thread.
+  EXPECT_GT(used_runners.size(), 1u);
+}
+
+}  // namespace test
+}  // namespace quic
+}  // namespace owt
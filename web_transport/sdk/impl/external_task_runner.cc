@@ -0,0 +1,54 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "impl/external_task_runner.h"
+#include <algorithm>
+#include <memory>
+#include <utility>
+#include "base/check.h"
+
+namespace owt {
+namespace quic {
+
+ExternalTaskRunner::ExternalTaskRunner(EventExecutorInterface* executor)
+    : executor_(executor) {
+  CHECK(executor_);
+}
+
+ExternalTaskRunner::~ExternalTaskRunner() = default;
+
+bool ExternalTaskRunner::PostDelayedTask(const base::Location& from_here,
+                                         base::OnceClosure task,
+                                         base::TimeDelta delay) {
+  // Ownership of the task is passed to the executor, and is taken back when
+  // it runs.
+  auto* context = new base::OnceClosure(std::move(task));
+  executor_->PostTask(&ExternalTaskRunner::RunTask, context,
+                      std::max<int64_t>(0, delay.InMillisecondsRoundedUp()));
+  return true;
+}
+
+bool ExternalTaskRunner::PostNonNestableDelayedTask(
+    const base::Location& from_here,
+    base::OnceClosure task,
+    base::TimeDelta delay) {
+  // Executors never run tasks in nested loops.
+  return PostDelayedTask(from_here, std::move(task), delay);
+}
+
+bool ExternalTaskRunner::RunsTasksInCurrentSequence() const {
+  return executor_->IsCurrentThread();
+}
+
+// static
+void ExternalTaskRunner::RunTask(void* context) {
+  std::unique_ptr<base::OnceClosure> task(
+      static_cast<base::OnceClosure*>(context));
+  std::move(*task).Run();
+}
+
+}  // namespace quic
+}  // namespace owt
@@ -0,0 +1,82 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "owt/web_transport/sdk/impl/external_task_runner.h"
+#include <vector>
+#include "base/bind.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace owt {
+namespace quic {
+namespace test {
+
+namespace {
+class FakeExecutor : public EventExecutorInterface {
+ public:
+  struct PostedTask {
+    Task task;
+    void* context;
+    uint64_t delay_ms;
+  };
+
+  void PostTask(Task task, void* context, uint64_t delay_ms) override {
+    tasks_.push_back(PostedTask{task, context, delay_ms});
+  }
+  bool IsCurrentThread() const override { return running_; }
+
+  void RunAll() {
+    running_ = true;
+    std::vector<PostedTask> tasks;
+    tasks.swap(tasks_);
+    for (const PostedTask& task : tasks) {
+      task.task(task.context);
+    }
+    running_ = false;
+  }
+  const std::vector<PostedTask>& tasks() const { return tasks_; }
+
+ private:
+  std::vector<PostedTask> tasks_;
+  bool running_ = false;
+};
+}  // namespace
+
+TEST(ExternalTaskRunnerTest, RunsTasksOnExecutor) {
+  FakeExecutor executor;
+  auto runner = base::MakeRefCounted<ExternalTaskRunner>(&executor);
+  std::vector<int> results;
+  runner->PostTask(FROM_HERE,
+                   base::BindOnce([](std::vector<int>* r) { r->push_back(1); },
+                                  &results));
+  runner->PostDelayedTask(
+      FROM_HERE,
+      base::BindOnce([](std::vector<int>* r) { r->push_back(2); }, &results),
+      base::Milliseconds(10));
+  ASSERT_EQ(executor.tasks().size(), 2u);
+  EXPECT_EQ(executor.tasks()[0].delay_ms, 0u);
+  EXPECT_EQ(executor.tasks()[1].delay_ms, 10u);
+  EXPECT_TRUE(results.empty());
+  executor.RunAll();
+  EXPECT_EQ(results, std::vector<int>({1, 2}));
+}
+
+TEST(ExternalTaskRunnerTest, BelongsToExecutorThread) {
+  FakeExecutor executor;
+  auto runner = base::MakeRefCounted<ExternalTaskRunner>(&executor);
+  EXPECT_FALSE(runner->BelongsToCurrentThread());
+  bool belongs = false;
+  runner->PostTask(FROM_HERE, base::BindOnce(
+                                  [](ExternalTaskRunner* runner, bool* result) {
+                                    *result = runner->BelongsToCurrentThread();
+                                  },
+                                  base::Unretained(runner.get()), &belongs));
+  executor.RunAll();
+  EXPECT_TRUE(belongs);
+}
+
+}  // namespace test
+}  // namespace quic
+}  // namespace owt
@@ -13,7 +13,10 @@
 // with modifications.
 
 #include "impl/http3_server_session.h"
+#include <algorithm>
 #include "impl/http3_server_stream.h"
+#include "impl/issued_connection_id_table.h"
+#include "impl/utilities.h"
 #include "net/third_party/quiche/src/quic/core/http/quic_server_initiated_spdy_stream.h"
 
 namespace owt {
@@ -39,15 +42,220 @@ Http3ServerSession::Http3ServerSession(
                             compressed_certs_cache),
       backend_(backend),
       io_runner_(io_runner),
-      event_runner_(event_runner) {
+      event_runner_(event_runner),
+      creation_time_(base::TimeTicks::Now()),
+      datagrams_before_retransmissions_(false),
+      stats_counters_(nullptr),
+      issued_connection_ids_(nullptr),
+      worker_index_(0),
+      origin_allowlist_(nullptr),
+      peer_migrations_(0),
+      ack_eliciting_threshold_(0),
+      max_ack_delay_(::quic::QuicTime::Delta::Zero()),
+      ack_frequency_sent_(false),
+      keepalive_pending_(false),
+      keepalive_pinger_(this) {
   CHECK(io_runner_);
   CHECK(event_runner_);
 }
 
 Http3ServerSession::~Http3ServerSession() {
+  // Sessions are destroyed without closing their connections when the
+  // dispatcher is destroyed.
+  for (Observer* observer : observers_) {
+    observer->OnSessionDestroyed();
+  }
+  if (issued_connection_ids_) {
+    for (const ::quic::QuicConnectionId& id : issued_connection_id_list_) {
+      issued_connection_ids_->Remove(id);
+    }
+  }
   DeleteConnection();
 }
 
+size_t Http3ServerSession::QueuedDatagramCount() {
+  return datagram_queue()->queue_size();
+}
+
+bool Http3ServerSession::CanSendDatagramNow() {
+  return datagram_queue()->empty() &&
+         connection()->CanWrite(::quic::HAS_RETRANSMITTABLE_DATA);
+}
+
+void Http3ServerSession::AddObserver(Observer* observer) {
+  DCHECK(observer);
+  observers_.push_back(observer);
+}
+
+void Http3ServerSession::OnSendingDatagram(Observer* sender) {
+  datagram_senders_.push_back(sender);
+}
+
+void Http3ServerSession::SetConnectionLogger(
+    std::unique_ptr<QlogConnectionLogger> logger) {
+  connection_logger_ = std::move(logger);
+  connection()->set_debug_visitor(connection_logger_.get());
+}
+
+void Http3ServerSession::SetAckFrequency(
+    uint32_t ack_eliciting_threshold,
+    ::quic::QuicTime::Delta max_ack_delay) {
+  ack_eliciting_threshold_ = ack_eliciting_threshold;
+  max_ack_delay_ = max_ack_delay;
+}
+
+void Http3ServerSession::MaybeSendAckFrequency() {
+  if (ack_frequency_sent_ || ack_eliciting_threshold_ == 0 ||
+      GetHandshakeState() != ::quic::HANDSHAKE_CONFIRMED) {
+    return;
+  }
+  ack_frequency_sent_ = true;
+  absl::optional<::quic::QuicAckFrequencyFrame> frame =
+      Utilities::CreateAckFrequencyFrame(*config(), ack_eliciting_threshold_,
+                                         max_ack_delay_);
+  if (frame) {
+    control_frame_manager().WriteOrBufferAckFrequency(*frame);
+  }
+}
+
+void Http3ServerSession::SetKeepAlive(base::TimeDelta interval,
+                                      base::TimeDelta idle_timeout) {
+  keepalive_interval_ = interval;
+  keepalive_idle_timeout_ = idle_timeout;
+  keepalive_pending_ = true;
+  MaybeStartKeepAlive();
+}
+
+void Http3ServerSession::MaybeStartKeepAlive() {
+  if (!keepalive_pending_ ||
+      GetHandshakeState() != ::quic::HANDSHAKE_CONFIRMED) {
+    return;
+  }
+  keepalive_pending_ = false;
+  keepalive_pinger_.SetKeepAlive(keepalive_interval_, keepalive_idle_timeout_);
+}
+
+void Http3ServerSession::SetStatsCounters(ServerStatsCounters* counters) {
+  stats_counters_ = counters;
+}
+
+void Http3ServerSession::SetIssuedConnectionIdTable(
+    IssuedConnectionIdTable* table,
+    uint8_t worker_index) {
+  issued_connection_ids_ = table;
+  worker_index_ = worker_index;
+}
+
+bool Http3ServerSession::MaybeReserveConnectionId(
+    const ::quic::QuicConnectionId& server_connection_id) {
+  if (!QuicServerSessionBase::MaybeReserveConnectionId(server_connection_id)) {
+    return false;
+  }
+  if (issued_connection_ids_) {
+    // Added before the NEW_CONNECTION_ID frame is sent, so packets using it
+    // are steered to this worker by any worker.
+    issued_connection_ids_->Add(server_connection_id, worker_index_);
+    issued_connection_id_list_.push_back(server_connection_id);
+  }
+  return true;
+}
+
+void Http3ServerSession::OnServerConnectionIdRetired(
+    const ::quic::QuicConnectionId& server_connection_id) {
+  QuicServerSessionBase::OnServerConnectionIdRetired(server_connection_id);
+  if (!issued_connection_ids_) {
+    return;
+  }
+  auto it = std::find(issued_connection_id_list_.begin(),
+                      issued_connection_id_list_.end(), server_connection_id);
+  if (it != issued_connection_id_list_.end()) {
+    issued_connection_ids_->Remove(server_connection_id);
+    issued_connection_id_list_.erase(it);
+  }
+}
+
+void Http3ServerSession::SetOriginAllowlist(
+    const OriginAllowlist* allowlist) {
+  origin_allowlist_ = allowlist;
+}
+
+void Http3ServerSession::EnableCpuAccounting() {
+  if (!cpu_account_) {
+    cpu_account_ = base::MakeRefCounted<SessionCpuAccount>();
+  }
+}
+
+void Http3ServerSession::ProcessUdpPacket(
+    const ::quic::QuicSocketAddress& self_address,
+    const ::quic::QuicSocketAddress& peer_address,
+    const ::quic::QuicReceivedPacket& packet) {
+  // Includes stream and visitor callbacks called for the packet.
+  SessionCpuAccount::ScopedIoTimer timer(cpu_account_.get());
+  QuicServerSessionBase::ProcessUdpPacket(self_address, peer_address, packet);
+}
+
+void Http3ServerSession::OnDatagramProcessed(
+    absl::optional<::quic::MessageStatus> status) {
+  if (datagram_senders_.empty()) {
+    return;
+  }
+  Observer* sender = datagram_senders_.front();
+  datagram_senders_.pop_front();
+  sender->OnDatagramProcessed(status);
+}
+
+void Http3ServerSession::OnCongestionWindowChange(::quic::QuicTime now) {
+  QuicServerSessionBase::OnCongestionWindowChange(now);
+  MaybeSendAckFrequency();
+  MaybeStartKeepAlive();
+  for (Observer* observer : observers_) {
+    observer->OnCongestionWindowChange();
+  }
+}
+
+void Http3ServerSession::OnCanWrite() {
+  SessionCpuAccount::ScopedIoTimer timer(cpu_account_.get());
+  // Datagrams sent here and data written by QuicSession share packets.
+  ::quic::QuicConnection::ScopedPacketFlusher flusher(connection());
+  if (datagrams_before_retransmissions_ && !datagram_queue()->empty()) {
+    // QuicSession::OnCanWrite() retransmits lost stream data before sending
+    // queued datagrams. Datagrams are sent until congestion control blocks
+    // them, stream data is written with the remaining window.
+    datagram_queue()->SendDatagrams();
+  }
+  for (Observer* observer : observers_) {
+    if (observer->HasQueuedDatagrams()) {
+      observer->OnCanSendDatagrams();
+    }
+  }
+  QuicServerSessionBase::OnCanWrite();
+}
+
+bool Http3ServerSession::WillingAndAbleToWrite() const {
+  if (QuicServerSessionBase::WillingAndAbleToWrite()) {
+    return true;
+  }
+  for (const Observer* observer : observers_) {
+    if (observer->HasQueuedDatagrams()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void Http3ServerSession::OnConnectionMigration(
+    ::quic::AddressChangeType type) {
+  // QuicConnection has switched to the new peer address. Until reverse path
+  // validation succeeds, data sent to it is limited by anti-amplification,
+  // and the connection falls back to the old address if validation fails.
+  // Congestion state is only reset when the IP address changes.
+  QuicServerSessionBase::OnConnectionMigration(type);
+  peer_migrations_++;
+  if (stats_counters_) {
+    stats_counters_->OnPeerMigration(type == ::quic::PORT_CHANGE);
+  }
+}
+
 ::quic::QuicSpdyStream* Http3ServerSession::CreateIncomingStream(
     ::quic::QuicStreamId id) {
   if (!ShouldCreateIncomingStream(id)) {
@@ -7,16 +7,48 @@
 #ifndef OWT_QUIC_WEB_TRANSPORT_HTTP3_SERVER_SESSION_H_
 #define OWT_QUIC_WEB_TRANSPORT_HTTP3_SERVER_SESSION_H_
 
+#include <memory>
+#include <vector>
+#include "base/containers/circular_deque.h"
+#include "base/memory/scoped_refptr.h"
 #include "base/task/single_thread_task_runner.h"
+#include "base/time/time.h"
 #include "net/third_party/quiche/src/quic/core/http/quic_server_session_base.h"
+#include "owt/web_transport/sdk/impl/keepalive_pinger.h"
+#include "owt/web_transport/sdk/impl/origin_allowlist.h"
+#include "owt/web_transport/sdk/impl/qlog_writer.h"
+#include "owt/web_transport/sdk/impl/server_stats_counters.h"
+#include "owt/web_transport/sdk/impl/session_cpu_account.h"
 
 namespace owt {
 namespace quic {
 
+class IssuedConnectionIdTable;
 class WebTransportServerBackend;
 
 class Http3ServerSession : public ::quic::QuicServerSessionBase {
  public:
+  // Observes events of the QUIC connection on IO thread.
+  class Observer {
+   public:
+    virtual ~Observer() = default;
+    // Called when a datagram is sent, or dropped without being sent. `status`
+    // has no value if the datagram expired in queue.
+    virtual void OnDatagramProcessed(
+        absl::optional<::quic::MessageStatus> status) = 0;
+    // Called when congestion state changes, e.g.: after an ACK is processed.
+    virtual void OnCongestionWindowChange() = 0;
+    // Called when the connection becomes writable, before stream data is
+    // written, so datagrams queued by the observer could be sent.
+    virtual void OnCanSendDatagrams() {}
+    // Whether the observer has queued datagrams to send once the connection
+    // becomes writable.
+    virtual bool HasQueuedDatagrams() const { return false; }
+    // Called before the session is destroyed. The observer must not access
+    // the session afterwards.
+    virtual void OnSessionDestroyed() {}
+  };
+
   explicit Http3ServerSession(
       const ::quic::QuicConfig& config,
       const ::quic::ParsedQuicVersionVector& supported_versions,
@@ -31,6 +63,75 @@ class Http3ServerSession : public ::quic::QuicServerSessionBase {
   ~Http3ServerSession() override;
   Http3ServerSession& operator=(Http3ServerSession&) = delete;
 
+  // Each WebTransport session over this connection adds an observer. Events
+  // of the connection are reported to all of them, except datagram status,
+  // which is reported to the observer that sent the datagram. Observers must
+  // outlive this session.
+  void AddObserver(Observer* observer);
+  // Called right before `sender` sends or queues a datagram.
+  void OnSendingDatagram(Observer* sender);
+  // Sets `logger` as the debug visitor of the connection. It could be nullptr.
+  void SetConnectionLogger(std::unique_ptr<QlogConnectionLogger> logger);
+  // Peer migrations are counted by `counters`. It could be nullptr, and it
+  // must outlive this session.
+  void SetStatsCounters(ServerStatsCounters* counters);
+  ServerStatsCounters* stats_counters() const { return stats_counters_; }
+  // Connection IDs issued in NEW_CONNECTION_ID frames are added to `table` as
+  // owned by `worker_index` until they're retired or the session is
+  // destroyed. `table` could be nullptr, and it must outlive this session.
+  void SetIssuedConnectionIdTable(IssuedConnectionIdTable* table,
+                                  uint8_t worker_index);
+  // WebTransport requests are checked against `allowlist` before their
+  // sessions are created. It could be nullptr, which allows all origins, and
+  // it must outlive this session.
+  void SetOriginAllowlist(const OriginAllowlist* allowlist);
+  const OriginAllowlist* origin_allowlist() const { return origin_allowlist_; }
+  // Starts accounting thread time spent on this connection. It's called
+  // before the first packet is processed.
+  void EnableCpuAccounting();
+  // nullptr if CPU accounting is not enabled.
+  SessionCpuAccount* cpu_account() const { return cpu_account_.get(); }
+  // Asks the client to send an ACK after receiving `ack_eliciting_threshold`
+  // ack-eliciting packets, or after `max_ack_delay`, once the handshake is
+  // confirmed. 0 `ack_eliciting_threshold` doesn't send the request.
+  void SetAckFrequency(uint32_t ack_eliciting_threshold,
+                       ::quic::QuicTime::Delta max_ack_delay);
+  // Sends PINGs after every `interval` without received packets once the
+  // handshake is confirmed. Non-zero `idle_timeout` replaces the negotiated
+  // idle timeout. See KeepAlivePinger.
+  void SetKeepAlive(base::TimeDelta interval, base::TimeDelta idle_timeout);
+  // Number of times the peer address of this connection changed.
+  uint64_t peer_migrations() const { return peer_migrations_; }
+  // Time when this session is created for the first packet of a connection.
+  base::TimeTicks creation_time() const { return creation_time_; }
+  // Number of outgoing datagrams queued by congestion control.
+  size_t QueuedDatagramCount();
+  // When it's true, queued datagrams are sent before lost stream data is
+  // retransmitted, see DatagramPriority::kAboveStreams. It's a setting of the
+  // connection, the last session setting it wins.
+  void set_datagrams_before_retransmissions(bool enabled) {
+    datagrams_before_retransmissions_ = enabled;
+  }
+  // Whether a datagram sent now goes out without waiting in QUIC's datagram
+  // queue. When it's false, the connection calls OnCanWrite() once it can
+  // send again, as long as an observer has queued datagrams.
+  bool CanSendDatagramNow();
+
+  // Overrides ::quic::QuicSession.
+  void ProcessUdpPacket(const ::quic::QuicSocketAddress& self_address,
+                        const ::quic::QuicSocketAddress& peer_address,
+                        const ::quic::QuicReceivedPacket& packet) override;
+  void OnDatagramProcessed(
+      absl::optional<::quic::MessageStatus> status) override;
+  void OnCongestionWindowChange(::quic::QuicTime now) override;
+  void OnCanWrite() override;
+  bool WillingAndAbleToWrite() const override;
+  void OnConnectionMigration(::quic::AddressChangeType type) override;
+  bool MaybeReserveConnectionId(
+      const ::quic::QuicConnectionId& server_connection_id) override;
+  void OnServerConnectionIdRetired(
+      const ::quic::QuicConnectionId& server_connection_id) override;
+
  protected:
   // Override ::quic::QuicServerSessionBase.
   ::quic::QuicSpdyStream* CreateIncomingStream(
@@ -49,9 +150,38 @@ class Http3ServerSession : public ::quic::QuicServerSessionBase {
   ::quic::HttpDatagramSupport LocalHttpDatagramSupport() override;
 
  private:
+  // ACK_FREQUENCY frames are only allowed in 1-RTT packets, so the request is
+  // sent on the first congestion event after the handshake is confirmed.
+  void MaybeSendAckFrequency();
+  // Applies keepalive settings once the handshake is confirmed.
+  void MaybeStartKeepAlive();
+
   WebTransportServerBackend* backend_;
   base::SingleThreadTaskRunner* io_runner_;
   base::SingleThreadTaskRunner* event_runner_;
+  std::vector<Observer*> observers_;
+  // Senders of datagrams not processed yet, in the order they are sent.
+  base::circular_deque<Observer*> datagram_senders_;
+  const base::TimeTicks creation_time_;
+  bool datagrams_before_retransmissions_;
+  ServerStatsCounters* stats_counters_;
+  IssuedConnectionIdTable* issued_connection_ids_;
+  uint8_t worker_index_;
+  // Connection IDs this session added to `issued_connection_ids_`.
+  std::vector<::quic::QuicConnectionId> issued_connection_id_list_;
+  const OriginAllowlist* origin_allowlist_;
+  scoped_refptr<SessionCpuAccount> cpu_account_;
+  uint64_t peer_migrations_;
+  uint32_t ack_eliciting_threshold_;
+  ::quic::QuicTime::Delta max_ack_delay_;
+  bool ack_frequency_sent_;
+  base::TimeDelta keepalive_interval_;
+  base::TimeDelta keepalive_idle_timeout_;
+  // Keepalive settings are not applied yet.
+  bool keepalive_pending_;
+  KeepAlivePinger keepalive_pinger_;
+  // Destroyed after the connection, which may report events until then.
+  std::unique_ptr<QlogConnectionLogger> connection_logger_;
 };
 
 }  // namespace quic
@@ -5,6 +5,8 @@
  */
 
 #include "impl/http3_server_stream.h"
+#include "base/no_destructor.h"
+#include "impl/http3_server_session.h"
 #include "impl/web_transport_server_backend.h"
 #include "net/third_party/quiche/src/quic/core/http/spdy_utils.h"
 #include "net/third_party/quiche/src/quic/core/http/web_transport_http3.h"
@@ -12,6 +14,48 @@
 namespace owt {
 namespace quic {
 
+namespace {
+const char kErrorBody[] = "Error.";
+
+spdy::Http2HeaderBlock CreateResponseHeaders(int status) {
+  spdy::Http2HeaderBlock headers;
+  headers[":status"] = absl::StrCat(status);
+  if (status != 200) {
+    headers["content-length"] = absl::StrCat(strlen(kErrorBody));
+  }
+  return headers;
+}
+
+// Every session sends the same few responses, so their header blocks are built
+// once and cloned, instead of formatting and allocating each field again.
+spdy::Http2HeaderBlock GetResponseHeaders(int status) {
+  static const base::NoDestructor<spdy::Http2HeaderBlock> ok(
+      CreateResponseHeaders(200));
+  static const base::NoDestructor<spdy::Http2HeaderBlock> bad_request(
+      CreateResponseHeaders(400));
+  static const base::NoDestructor<spdy::Http2HeaderBlock> forbidden(
+      CreateResponseHeaders(403));
+  static const base::NoDestructor<spdy::Http2HeaderBlock> not_allowed(
+      CreateResponseHeaders(405));
+  static const base::NoDestructor<spdy::Http2HeaderBlock> internal_error(
+      CreateResponseHeaders(500));
+  switch (status) {
+    case 200:
+      return ok->Clone();
+    case 400:
+      return bad_request->Clone();
+    case 403:
+      return forbidden->Clone();
+    case 405:
+      return not_allowed->Clone();
+    case 500:
+      return internal_error->Clone();
+    default:
+      return CreateResponseHeaders(status);
+  }
+}
+}  // namespace
+
 Http3ServerStream::Http3ServerStream(::quic::QuicStreamId id,
                                      ::quic::QuicSpdySession* session,
                                      ::quic::StreamType type,
@@ -59,14 +103,26 @@ void Http3ServerStream::OnInitialHeadersComplete(
   if (!::quic::SpdyUtils::CopyAndValidateHeaders(header_list, &content_length_,
                                                  &request_headers_)) {
     DVLOG(1) << "Invalid headers";
-    SendErrorResponse(400);
+    return SendErrorResponse(400);
   }
   ConsumeHeaderList();
   auto it = request_headers_.find(":method");
   if (it == request_headers_.end() ||
       !absl::StartsWith(it->second, "CONNECT")) {
     // Only support CONNECT for WebTransport.
-    SendErrorResponse(405);
+    return SendErrorResponse(405);
+  }
+  // Checked before the backend creates a WebTransport session for the request.
+  const OriginAllowlist* allowlist =
+      static_cast<Http3ServerSession*>(spdy_session())->origin_allowlist();
+  if (allowlist && !allowlist->empty()) {
+    auto origin = request_headers_.find("origin");
+    if (!allowlist->IsAllowed(origin == request_headers_.end()
+                                  ? absl::string_view()
+                                  : origin->second)) {
+      DVLOG(1) << "Origin is not allowed.";
+      return SendErrorResponse(403);
+    }
   }
   SendResponse();
 }
@@ -77,19 +133,13 @@ void Http3ServerStream::SendResponse() {
     return SendErrorResponse(500);
   }
   backend_->OnSessionReady(web_transport(), spdy_session());
-  spdy::Http2HeaderBlock response_headers;
-  response_headers[":status"] = "200";
-  WriteHeaders(std::move(response_headers), false, nullptr);
+  WriteHeaders(GetResponseHeaders(200), false, nullptr);
   web_transport()->HeadersReceived(request_headers_);
 }
 
 void Http3ServerStream::SendErrorResponse(int resp_code) {
-  spdy::Http2HeaderBlock headers;
-  headers[":status"] = absl::StrCat(resp_code);
-  std::string error_body("Error.");
-  headers["content-length"] = absl::StrCat(strlen(error_body.c_str()));
-  WriteHeaders(std::move(headers), false, nullptr);
-  WriteOrBufferBody(error_body, true);
+  WriteHeaders(GetResponseHeaders(resp_code), false, nullptr);
+  WriteOrBufferBody(kErrorBody, true);
 }
 
 }  // namespace quic
@@ -0,0 +1,63 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "impl/issued_connection_id_table.h"
+#include "net/third_party/quiche/src/quic/core/quic_constants.h"
+
+namespace owt {
+namespace quic {
+
+IssuedConnectionIdTable::Shard::Shard() = default;
+
+IssuedConnectionIdTable::Shard::~Shard() = default;
+
+IssuedConnectionIdTable::IssuedConnectionIdTable() = default;
+
+IssuedConnectionIdTable::~IssuedConnectionIdTable() = default;
+
+void IssuedConnectionIdTable::Add(
+    const ::quic::QuicConnectionId& connection_id,
+    uint8_t worker_index) {
+  Shard& shard = ShardOf(connection_id);
+  base::AutoLock lock(shard.lock);
+  shard.owners[connection_id] = worker_index;
+}
+
+void IssuedConnectionIdTable::Remove(
+    const ::quic::QuicConnectionId& connection_id) {
+  Shard& shard = ShardOf(connection_id);
+  base::AutoLock lock(shard.lock);
+  shard.owners.erase(connection_id);
+}
+
+absl::optional<uint8_t> IssuedConnectionIdTable::GetWorkerIndex(
+    const char* data,
+    size_t length) const {
+  if (length > ::quic::kQuicMaxConnectionIdLength) {
+    return absl::nullopt;
+  }
+  const ::quic::QuicConnectionId connection_id(data, length);
+  const Shard& shard = ShardOf(connection_id);
+  base::AutoLock lock(shard.lock);
+  auto it = shard.owners.find(connection_id);
+  if (it == shard.owners.end()) {
+    return absl::nullopt;
+  }
+  return it->second;
+}
+
+IssuedConnectionIdTable::Shard& IssuedConnectionIdTable::ShardOf(
+    const ::quic::QuicConnectionId& connection_id) {
+  return shards_[connection_id.Hash() % kShardCount];
+}
+
+const IssuedConnectionIdTable::Shard& IssuedConnectionIdTable::ShardOf(
+    const ::quic::QuicConnectionId& connection_id) const {
+  return shards_[connection_id.Hash() % kShardCount];
+}
+
+}  // namespace quic
+}  // namespace owt
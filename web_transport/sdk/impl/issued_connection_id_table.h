@@ -0,0 +1,64 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef OWT_WEB_TRANSPORT_ISSUED_CONNECTION_ID_TABLE_H_
+#define OWT_WEB_TRANSPORT_ISSUED_CONNECTION_ID_TABLE_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include "base/synchronization/lock.h"
+#include "base/thread_annotations.h"
+#include "net/third_party/quiche/src/quic/core/quic_connection_id.h"
+#include "third_party/abseil-cpp/absl/types/optional.h"
+
+namespace owt {
+namespace quic {
+
+// Workers owning connection IDs issued in NEW_CONNECTION_ID frames. This
+// version of QUICHE derives them from the previous connection ID of a
+// connection without a generator hook, so they don't carry the worker index
+// like IDs generated by RoutableConnectionIdGenerator. Sessions add the IDs
+// they issue and remove them once they're retired, and packets are steered
+// by this table before the generator's encoding. All methods are thread
+// safe, IDs are sharded so workers rarely contend for a lock.
+class IssuedConnectionIdTable {
+ public:
+  IssuedConnectionIdTable();
+  ~IssuedConnectionIdTable();
+  IssuedConnectionIdTable(const IssuedConnectionIdTable&) = delete;
+  IssuedConnectionIdTable& operator=(const IssuedConnectionIdTable&) = delete;
+
+  void Add(const ::quic::QuicConnectionId& connection_id,
+           uint8_t worker_index);
+  void Remove(const ::quic::QuicConnectionId& connection_id);
+  // Returns the worker owning a connection ID, or nullopt if it's not issued.
+  absl::optional<uint8_t> GetWorkerIndex(const char* data,
+                                         size_t length) const;
+
+ private:
+  static constexpr size_t kShardCount = 16;
+  struct Shard {
+    Shard();
+    ~Shard();
+    mutable base::Lock lock;
+    std::unordered_map<::quic::QuicConnectionId,
+                       uint8_t,
+                       ::quic::QuicConnectionIdHash>
+        owners GUARDED_BY(lock);
+  };
+
+  Shard& ShardOf(const ::quic::QuicConnectionId& connection_id);
+  const Shard& ShardOf(const ::quic::QuicConnectionId& connection_id) const;
+
+  std::array<Shard, kShardCount> shards_;
+};
+
+}  // namespace quic
+}  // namespace owt
+
+#endif
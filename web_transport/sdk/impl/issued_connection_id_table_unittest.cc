@@ -0,0 +1,40 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "owt/web_transport/sdk/impl/issued_connection_id_table.h"
+#include "net/third_party/quiche/src/quic/test_tools/quic_test_utils.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace owt {
+namespace quic {
+namespace test {
+
+TEST(IssuedConnectionIdTableTest, AddAndRemove) {
+  IssuedConnectionIdTable table;
+  const ::quic::QuicConnectionId id1 = ::quic::test::TestConnectionId(1);
+  const ::quic::QuicConnectionId id2 = ::quic::test::TestConnectionId(2);
+  EXPECT_FALSE(table.GetWorkerIndex(id1.data(), id1.length()));
+  table.Add(id1, 3);
+  table.Add(id2, 5);
+  EXPECT_EQ(table.GetWorkerIndex(id1.data(), id1.length()), 3);
+  EXPECT_EQ(table.GetWorkerIndex(id2.data(), id2.length()), 5);
+  table.Remove(id1);
+  EXPECT_FALSE(table.GetWorkerIndex(id1.data(), id1.length()));
+  EXPECT_EQ(table.GetWorkerIndex(id2.data(), id2.length()), 5);
+}
+
+TEST(IssuedConnectionIdTableTest, PrefixIsNotMatched) {
+  IssuedConnectionIdTable table;
+  const ::quic::QuicConnectionId id = ::quic::test::TestConnectionId(1);
+  table.Add(id, 1);
+  // Packets are parsed with the length of generated IDs.
+  EXPECT_FALSE(table.GetWorkerIndex(id.data(), id.length() - 1));
+  EXPECT_FALSE(table.GetWorkerIndex(id.data(), 21));
+}
+
+}  // namespace test
+}  // namespace quic
+}  // namespace owt
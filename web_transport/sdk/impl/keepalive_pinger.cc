@@ -0,0 +1,82 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "impl/keepalive_pinger.h"
+#include <cmath>
+#include "base/bind.h"
+#include "net/third_party/quiche/src/quic/core/quic_connection.h"
+
+namespace owt {
+namespace quic {
+
+KeepAlivePinger::KeepAlivePinger(::quic::QuicSession* session)
+    : session_(session),
+      packets_received_(0),
+      silent_intervals_(0),
+      max_silent_intervals_(0) {
+  DCHECK(session_);
+}
+
+KeepAlivePinger::~KeepAlivePinger() = default;
+
+void KeepAlivePinger::SetKeepAlive(base::TimeDelta interval,
+                                   base::TimeDelta idle_timeout) {
+  ::quic::QuicConnection* connection = session_->connection();
+  if (!connection->connected()) {
+    return;
+  }
+  if (idle_timeout.is_positive()) {
+    // Sessions only exist after the handshake, so the handshake timeout no
+    // longer applies.
+    connection->SetNetworkTimeouts(
+        ::quic::QuicTime::Delta::Infinite(),
+        ::quic::QuicTime::Delta::FromMicroseconds(
+            idle_timeout.InMicroseconds()));
+  }
+  if (!interval.is_positive()) {
+    timer_.Stop();
+    return;
+  }
+  max_silent_intervals_ =
+      idle_timeout.is_positive()
+          ? static_cast<uint32_t>(std::ceil(idle_timeout / interval))
+          : 0;
+  silent_intervals_ = 0;
+  packets_received_ = connection->GetStats().packets_received;
+  // `timer_` is owned by this object.
+  timer_.Start(FROM_HERE, interval,
+               base::BindRepeating(&KeepAlivePinger::OnTimer,
+                                   base::Unretained(this)));
+}
+
+void KeepAlivePinger::OnTimer() {
+  ::quic::QuicConnection* connection = session_->connection();
+  if (!connection->connected()) {
+    timer_.Stop();
+    return;
+  }
+  const uint64_t packets_received = connection->GetStats().packets_received;
+  if (packets_received != packets_received_) {
+    // The peer is alive, and the idle timeout is already reset.
+    packets_received_ = packets_received;
+    silent_intervals_ = 0;
+    return;
+  }
+  if (max_silent_intervals_ > 0 &&
+      ++silent_intervals_ >= max_silent_intervals_) {
+    timer_.Stop();
+    connection->CloseConnection(
+        ::quic::QUIC_NETWORK_IDLE_TIMEOUT,
+        "No packet is received after keep-alive PINGs.",
+        ::quic::ConnectionCloseBehavior::SILENT_CLOSE);
+    return;
+  }
+  // PING is ack-eliciting, the ACK of a live peer resets the idle timeout.
+  session_->SendPing();
+}
+
+}  // namespace quic
+}  // namespace owt
@@ -0,0 +1,56 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef OWT_WEB_TRANSPORT_KEEPALIVE_PINGER_H_
+#define OWT_WEB_TRANSPORT_KEEPALIVE_PINGER_H_
+
+#include <cstdint>
+#include "base/time/time.h"
+#include "base/timer/timer.h"
+#include "net/third_party/quiche/src/quic/core/quic_session.h"
+
+namespace owt {
+namespace quic {
+
+// Detects dead peers of a QUIC connection. QUIC only sends PINGs from clients,
+// every 15 seconds, so a quiet connection is only closed when its idle timeout
+// expires. When an interval is set, the pinger sends a PING after every
+// interval in which no packet is received, and a live peer's ACK resets the
+// idle timeout. When an idle timeout is set as well, the pinger closes the
+// connection itself once nothing is received for that long, because QUICHE
+// adds 3 seconds to the idle timeout of servers. Must be used on the session's
+// thread, and destroyed before the session.
+class KeepAlivePinger {
+ public:
+  explicit KeepAlivePinger(::quic::QuicSession* session);
+  ~KeepAlivePinger();
+  KeepAlivePinger(const KeepAlivePinger&) = delete;
+  KeepAlivePinger& operator=(const KeepAlivePinger&) = delete;
+
+  // Zero `interval` stops sending PINGs. Non-zero `idle_timeout` replaces the
+  // negotiated idle timeout of the connection. It should be a few intervals,
+  // so a lost PING or ACK doesn't close a live connection. It's rounded up to
+  // a whole number of intervals while PINGs are sent.
+  void SetKeepAlive(base::TimeDelta interval, base::TimeDelta idle_timeout);
+
+ private:
+  void OnTimer();
+
+  ::quic::QuicSession* session_;
+  base::RepeatingTimer timer_;
+  // Packets received before the last timer tick.
+  uint64_t packets_received_;
+  // Consecutive timer ticks without received packets.
+  uint32_t silent_intervals_;
+  // The connection is closed after this many silent intervals. 0 leaves it to
+  // the connection's idle timeout.
+  uint32_t max_silent_intervals_;
+};
+
+}  // namespace quic
+}  // namespace owt
+
+#endif
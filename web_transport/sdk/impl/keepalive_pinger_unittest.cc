@@ -0,0 +1,117 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "owt/web_transport/sdk/impl/keepalive_pinger.h"
+#include <memory>
+#include "base/test/task_environment.h"
+#include "net/third_party/quiche/src/quic/test_tools/quic_connection_peer.h"
+#include "net/third_party/quiche/src/quic/test_tools/quic_test_utils.h"
+#include "testing/gmock/include/gmock/gmock.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace owt {
+namespace quic {
+namespace test {
+
+using ::testing::_;
+
+namespace {
+class TestSession : public ::quic::test::MockQuicSession {
+ public:
+  explicit TestSession(::quic::QuicConnection* connection)
+      : MockQuicSession(connection) {}
+  MOCK_METHOD(void, SendPing, (), (override));
+};
+}  // namespace
+
+class KeepAlivePingerTest : public testing::Test {
+ protected:
+  KeepAlivePingerTest()
+      : connection_(new testing::NiceMock<::quic::test::MockQuicConnection>(
+            &helper_,
+            &alarm_factory_,
+            ::quic::Perspective::IS_SERVER)),
+        session_(std::make_unique<testing::NiceMock<TestSession>>(connection_)),
+        pinger_(std::make_unique<KeepAlivePinger>(session_.get())) {}
+
+  ~KeepAlivePingerTest() override { pinger_.reset(); }
+
+  // Pretends a packet is received from the peer.
+  void ReceivePacket() {
+    ::quic::test::QuicConnectionPeer::GetStats(connection_)
+        ->packets_received++;
+  }
+
+  base::test::TaskEnvironment task_environment_{
+      base::test::TaskEnvironment::TimeSource::MOCK_TIME};
+  ::quic::test::MockQuicConnectionHelper helper_;
+  ::quic::test::MockAlarmFactory alarm_factory_;
+  // Owned by `session_`.
+  ::quic::test::MockQuicConnection* connection_;
+  std::unique_ptr<TestSession> session_;
+  std::unique_ptr<KeepAlivePinger> pinger_;
+};
+
+TEST_F(KeepAlivePingerTest, ClosesSilentConnectionAfterIdleTimeout) {
+  pinger_->SetKeepAlive(base::Milliseconds(250), base::Milliseconds(1000));
+  EXPECT_CALL(*session_, SendPing()).Times(3);
+  EXPECT_CALL(*connection_, CloseConnection(_, _, _)).Times(0);
+  task_environment_.FastForwardBy(base::Milliseconds(750));
+  testing::Mock::VerifyAndClearExpectations(connection_);
+  testing::Mock::VerifyAndClearExpectations(session_.get());
+  EXPECT_CALL(*session_, SendPing()).Times(0);
+  // Not the idle timeout plus 3 seconds QUICHE adds to servers.
+  EXPECT_CALL(*connection_,
+              CloseConnection(::quic::QUIC_NETWORK_IDLE_TIMEOUT, _,
+                              ::quic::ConnectionCloseBehavior::SILENT_CLOSE))
+      .Times(1);
+  task_environment_.FastForwardBy(base::Milliseconds(250));
+  testing::Mock::VerifyAndClearExpectations(connection_);
+  // The pinger stops once it closes the connection.
+  EXPECT_CALL(*connection_, CloseConnection(_, _, _)).Times(0);
+  task_environment_.FastForwardBy(base::Seconds(5));
+}
+
+TEST_F(KeepAlivePingerTest, ReceivedPacketsRestartIdleTimeout) {
+  pinger_->SetKeepAlive(base::Milliseconds(250), base::Milliseconds(1000));
+  EXPECT_CALL(*connection_, CloseConnection(_, _, _)).Times(0);
+  task_environment_.FastForwardBy(base::Milliseconds(600));
+  ReceivePacket();
+  // The tick at 750 ms sees the packet and doesn't send a PING, 3 silent ticks
+  // follow.
+  EXPECT_CALL(*session_, SendPing()).Times(3);
+  task_environment_.FastForwardBy(base::Milliseconds(900));
+  testing::Mock::VerifyAndClearExpectations(connection_);
+  EXPECT_CALL(*connection_, CloseConnection(_, _, _)).Times(1);
+  task_environment_.FastForwardBy(base::Milliseconds(250));
+}
+
+TEST_F(KeepAlivePingerTest, IdleTimeoutIsRoundedUpToIntervals) {
+  pinger_->SetKeepAlive(base::Milliseconds(300), base::Milliseconds(1000));
+  EXPECT_CALL(*connection_, CloseConnection(_, _, _)).Times(0);
+  task_environment_.FastForwardBy(base::Milliseconds(1000));
+  testing::Mock::VerifyAndClearExpectations(connection_);
+  EXPECT_CALL(*connection_, CloseConnection(_, _, _)).Times(1);
+  task_environment_.FastForwardBy(base::Milliseconds(200));
+}
+
+TEST_F(KeepAlivePingerTest, WithoutIdleTimeoutConnectionIsNotClosed) {
+  pinger_->SetKeepAlive(base::Milliseconds(250), base::TimeDelta());
+  EXPECT_CALL(*connection_, CloseConnection(_, _, _)).Times(0);
+  task_environment_.FastForwardBy(base::Seconds(5));
+}
+
+TEST_F(KeepAlivePingerTest, ZeroIntervalStopsPinger) {
+  pinger_->SetKeepAlive(base::Milliseconds(250), base::Milliseconds(1000));
+  task_environment_.FastForwardBy(base::Milliseconds(500));
+  pinger_->SetKeepAlive(base::TimeDelta(), base::TimeDelta());
+  EXPECT_CALL(*connection_, CloseConnection(_, _, _)).Times(0);
+  task_environment_.FastForwardBy(base::Seconds(5));
+}
+
+}  // namespace test
+}  // namespace quic
+}  // namespace owt
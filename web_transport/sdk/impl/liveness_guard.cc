@@ -0,0 +1,31 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "impl/liveness_guard.h"
+
+namespace owt {
+namespace quic {
+
+LivenessGuard::LivenessGuard() : alive_(true) {}
+
+LivenessGuard::~LivenessGuard() = default;
+
+bool LivenessGuard::RunIfAlive(base::OnceClosure callback) {
+  base::AutoLock lock(lock_);
+  if (!alive_) {
+    return false;
+  }
+  std::move(callback).Run();
+  return true;
+}
+
+void LivenessGuard::Invalidate() {
+  base::AutoLock lock(lock_);
+  alive_ = false;
+}
+
+}  // namespace quic
+}  // namespace owt
@@ -0,0 +1,45 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef OWT_WEB_TRANSPORT_LIVENESS_GUARD_H_
+#define OWT_WEB_TRANSPORT_LIVENESS_GUARD_H_
+
+#include "base/callback.h"
+#include "base/memory/ref_counted.h"
+#include "base/synchronization/lock.h"
+
+namespace owt {
+namespace quic {
+
+// Tells tasks posted to another thread whether their target is still alive.
+// A WeakPtr can't do it, since it's bound to one sequence. The owner calls
+// Invalidate() before it's destroyed, on any thread. Tasks hold a reference,
+// so the guard outlives the owner.
+class LivenessGuard : public base::RefCountedThreadSafe<LivenessGuard> {
+ public:
+  LivenessGuard();
+  LivenessGuard(const LivenessGuard&) = delete;
+  LivenessGuard& operator=(const LivenessGuard&) = delete;
+
+  // Runs `callback` unless Invalidate() has been called, and returns whether
+  // it runs. Invalidate() waits for `callback` to return, so the owner is
+  // alive while it runs. `callback` must not wait for the thread destroying
+  // the owner.
+  bool RunIfAlive(base::OnceClosure callback);
+  void Invalidate();
+
+ private:
+  friend class base::RefCountedThreadSafe<LivenessGuard>;
+  ~LivenessGuard();
+
+  base::Lock lock_;
+  bool alive_;
+};
+
+}  // namespace quic
+}  // namespace owt
+
+#endif
@@ -0,0 +1,63 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "owt/web_transport/sdk/impl/liveness_guard.h"
+#include <atomic>
+#include "base/bind.h"
+#include "base/memory/scoped_refptr.h"
+#include "base/synchronization/waitable_event.h"
+#include "base/threading/platform_thread.h"
+#include "base/threading/thread.h"
+#include "base/time/time.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace owt {
+namespace quic {
+namespace test {
+
+TEST(LivenessGuardTest, RunsCallbackUntilInvalidated) {
+  auto guard = base::MakeRefCounted<LivenessGuard>();
+  int runs = 0;
+  EXPECT_TRUE(guard->RunIfAlive(
+      base::BindOnce([](int* runs) { (*runs)++; }, &runs)));
+  EXPECT_EQ(runs, 1);
+  guard->Invalidate();
+  EXPECT_FALSE(guard->RunIfAlive(
+      base::BindOnce([](int* runs) { (*runs)++; }, &runs)));
+  EXPECT_EQ(runs, 1);
+}
+
+TEST(LivenessGuardTest, InvalidateWaitsForRunningCallback) {
+  auto guard = base::MakeRefCounted<LivenessGuard>();
+  base::Thread thread("liveness_guard_test_thread");
+  ASSERT_TRUE(thread.Start());
+  base::WaitableEvent started;
+  std::atomic<bool> finished(false);
+  thread.task_runner()->PostTask(
+      FROM_HERE, base::BindOnce(
+                     [](scoped_refptr<LivenessGuard> guard,
+                        base::WaitableEvent* started,
+                        std::atomic<bool>* finished) {
+                       guard->RunIfAlive(base::BindOnce(
+                           [](base::WaitableEvent* started,
+                              std::atomic<bool>* finished) {
+                             started->Signal();
+                             base::PlatformThread::Sleep(
+                                 base::Milliseconds(50));
+                             finished->store(true);
+                           },
+                           started, finished));
+                     },
+                     guard, &started, &finished));
+  started.Wait();
+  guard->Invalidate();
+  EXPECT_TRUE(finished.load());
+  thread.Stop();
+}
+
+}  // namespace test
+}  // namespace quic
+}  // namespace owt
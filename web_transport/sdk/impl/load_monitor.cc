@@ -0,0 +1,119 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "impl/load_monitor.h"
+#include <algorithm>
+#include <utility>
+#include "base/bind.h"
+#include "base/check.h"
+
+namespace owt {
+namespace quic {
+
+OverloadDetector::OverloadDetector(size_t runner_count,
+                                   base::TimeDelta threshold)
+    : threshold_(threshold), delays_(runner_count), overloaded_(false) {
+  DCHECK(threshold_.is_positive());
+}
+
+OverloadDetector::~OverloadDetector() = default;
+
+bool OverloadDetector::OnQueueDelay(size_t index, base::TimeDelta delay) {
+  DCHECK_LT(index, delays_.size());
+  delays_[index] = delay;
+  const base::TimeDelta max_delay = max_queue_delay();
+  if (!overloaded_ && max_delay >= threshold_) {
+    overloaded_ = true;
+    return true;
+  }
+  if (overloaded_ && max_delay < threshold_ / 2) {
+    overloaded_ = false;
+    return true;
+  }
+  return false;
+}
+
+base::TimeDelta OverloadDetector::max_queue_delay() const {
+  base::TimeDelta max_delay;
+  for (const base::TimeDelta& delay : delays_) {
+    max_delay = std::max(max_delay, delay);
+  }
+  return max_delay;
+}
+
+LoadMonitor::LoadMonitor(std::vector<base::SingleThreadTaskRunner*> runners,
+                         base::TimeDelta threshold,
+                         base::TimeDelta probe_interval,
+                         base::SingleThreadTaskRunner* owner_runner,
+                         Delegate* delegate)
+    : probe_interval_(probe_interval),
+      owner_runner_(owner_runner),
+      delegate_(delegate),
+      detector_(runners.size(), threshold),
+      probes_posted_(runners.size()) {
+  CHECK(owner_runner_);
+  CHECK(delegate_);
+  for (base::SingleThreadTaskRunner* runner : runners) {
+    CHECK(runner);
+    runners_.push_back(base::WrapRefCounted(runner));
+  }
+}
+
+LoadMonitor::~LoadMonitor() = default;
+
+void LoadMonitor::Start() {
+  DCHECK(owner_runner_->BelongsToCurrentThread());
+  probe_timer_.Start(FROM_HERE, probe_interval_,
+                     base::BindRepeating(&LoadMonitor::SendProbes,
+                                         base::Unretained(this)));
+}
+
+void LoadMonitor::Stop() {
+  DCHECK(owner_runner_->BelongsToCurrentThread());
+  probe_timer_.Stop();
+  weak_factory_.InvalidateWeakPtrs();
+  std::fill(probes_posted_.begin(), probes_posted_.end(), base::TimeTicks());
+}
+
+// static
+void LoadMonitor::RunProbe(scoped_refptr<base::SingleThreadTaskRunner> owner,
+                           base::WeakPtr<LoadMonitor> monitor,
+                           size_t index,
+                           base::TimeTicks posted_time) {
+  const base::TimeDelta wait = base::TimeTicks::Now() - posted_time;
+  owner->PostTask(FROM_HERE, base::BindOnce(&LoadMonitor::OnProbeCompleted,
+                                            monitor, index, wait));
+}
+
+void LoadMonitor::SendProbes() {
+  DCHECK(owner_runner_->BelongsToCurrentThread());
+  const base::TimeTicks now = base::TimeTicks::Now();
+  for (size_t i = 0; i < runners_.size(); i++) {
+    if (!probes_posted_[i].is_null()) {
+      OnQueueDelay(i, now - probes_posted_[i]);
+      continue;
+    }
+    probes_posted_[i] = now;
+    runners_[i]->PostTask(
+        FROM_HERE, base::BindOnce(&LoadMonitor::RunProbe, owner_runner_,
+                                  weak_factory_.GetWeakPtr(), i, now));
+  }
+}
+
+void LoadMonitor::OnProbeCompleted(size_t index, base::TimeDelta wait) {
+  DCHECK(owner_runner_->BelongsToCurrentThread());
+  probes_posted_[index] = base::TimeTicks();
+  OnQueueDelay(index, wait);
+}
+
+void LoadMonitor::OnQueueDelay(size_t index, base::TimeDelta delay) {
+  if (detector_.OnQueueDelay(index, delay)) {
+    delegate_->OnOverloadChanged(detector_.overloaded());
+  }
+}
+
+}  // namespace quic
+}  // namespace owt
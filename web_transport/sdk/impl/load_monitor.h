@@ -0,0 +1,102 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef OWT_WEB_TRANSPORT_LOAD_MONITOR_H_
+#define OWT_WEB_TRANSPORT_LOAD_MONITOR_H_
+
+#include <cstddef>
+#include <vector>
+#include "base/memory/scoped_refptr.h"
+#include "base/memory/weak_ptr.h"
+#include "base/task/single_thread_task_runner.h"
+#include "base/time/time.h"
+#include "base/timer/timer.h"
+
+namespace owt {
+namespace quic {
+
+// Decides whether a set of task runners is overloaded from the latest queue
+// delay of each of them. It becomes overloaded when any delay reaches the
+// threshold, and recovers when all delays fall below half of it, so the state
+// doesn't flap around the threshold. Not thread safe.
+class OverloadDetector {
+ public:
+  // `threshold` must be positive.
+  OverloadDetector(size_t runner_count, base::TimeDelta threshold);
+  ~OverloadDetector();
+
+  // Records the latest queue delay of runner `index`. Returns true if the
+  // overload state changes.
+  bool OnQueueDelay(size_t index, base::TimeDelta delay);
+  bool overloaded() const { return overloaded_; }
+  // Max of the latest delays of all runners.
+  base::TimeDelta max_queue_delay() const;
+
+ private:
+  const base::TimeDelta threshold_;
+  std::vector<base::TimeDelta> delays_;
+  bool overloaded_;
+};
+
+// Measures how long tasks wait in the queues of `runners` by posting a
+// timestamped probe to each of them every `probe_interval`. Chromium task
+// runners don't expose the number of pending tasks, so the wait of a probe
+// stands in for the queue depth: it's the time any task posted at the same
+// moment waits. A probe still pending when the next one is due counts its age
+// so far, so a stuck runner is detected before its probe runs. Except the
+// constructor, methods must be called on `owner_runner`.
+class LoadMonitor {
+ public:
+  class Delegate {
+   public:
+    virtual ~Delegate() = default;
+    // Called on `owner_runner` when the overload state changes.
+    virtual void OnOverloadChanged(bool overloaded) = 0;
+  };
+
+  // `delegate` must outlive this monitor.
+  LoadMonitor(std::vector<base::SingleThreadTaskRunner*> runners,
+              base::TimeDelta threshold,
+              base::TimeDelta probe_interval,
+              base::SingleThreadTaskRunner* owner_runner,
+              Delegate* delegate);
+  ~LoadMonitor();
+  LoadMonitor(const LoadMonitor&) = delete;
+  LoadMonitor& operator=(const LoadMonitor&) = delete;
+
+  void Start();
+  // Probes not completed yet are ignored.
+  void Stop();
+  bool overloaded() const { return detector_.overloaded(); }
+  base::TimeDelta max_queue_delay() const {
+    return detector_.max_queue_delay();
+  }
+
+ private:
+  // Runs on the probed runner, and reports `posted_time`'s wait to `owner`.
+  static void RunProbe(scoped_refptr<base::SingleThreadTaskRunner> owner,
+                       base::WeakPtr<LoadMonitor> monitor,
+                       size_t index,
+                       base::TimeTicks posted_time);
+  void SendProbes();
+  void OnProbeCompleted(size_t index, base::TimeDelta wait);
+  void OnQueueDelay(size_t index, base::TimeDelta delay);
+
+  std::vector<scoped_refptr<base::SingleThreadTaskRunner>> runners_;
+  const base::TimeDelta probe_interval_;
+  scoped_refptr<base::SingleThreadTaskRunner> owner_runner_;
+  Delegate* delegate_;
+  OverloadDetector detector_;
+  // Time the pending probe of each runner is posted, null if there is none.
+  std::vector<base::TimeTicks> probes_posted_;
+  base::RepeatingTimer probe_timer_;
+  base::WeakPtrFactory<LoadMonitor> weak_factory_{this};
+};
+
+}  // namespace quic
+}  // namespace owt
+
+#endif
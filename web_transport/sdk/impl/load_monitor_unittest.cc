@@ -0,0 +1,45 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "owt/web_transport/sdk/impl/load_monitor.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace owt {
+namespace quic {
+namespace test {
+
+namespace {
+const base::TimeDelta kThreshold = base::Milliseconds(100);
+}  // namespace
+
+TEST(OverloadDetectorTest, OverloadedWhenAnyRunnerReachesThreshold) {
+  OverloadDetector detector(2, kThreshold);
+  EXPECT_FALSE(detector.OnQueueDelay(0, base::Milliseconds(10)));
+  EXPECT_FALSE(detector.OnQueueDelay(1, base::Milliseconds(99)));
+  EXPECT_FALSE(detector.overloaded());
+  EXPECT_TRUE(detector.OnQueueDelay(1, kThreshold));
+  EXPECT_TRUE(detector.overloaded());
+  EXPECT_EQ(detector.max_queue_delay(), kThreshold);
+  // Already overloaded.
+  EXPECT_FALSE(detector.OnQueueDelay(0, base::Milliseconds(300)));
+  EXPECT_EQ(detector.max_queue_delay(), base::Milliseconds(300));
+}
+
+TEST(OverloadDetectorTest, RecoversWhenAllRunnersFallBelowHalfThreshold) {
+  OverloadDetector detector(2, kThreshold);
+  EXPECT_TRUE(detector.OnQueueDelay(0, base::Milliseconds(150)));
+  EXPECT_FALSE(detector.OnQueueDelay(1, base::Milliseconds(120)));
+  EXPECT_FALSE(detector.OnQueueDelay(0, base::Milliseconds(10)));
+  // Below the threshold, but not below half of it.
+  EXPECT_FALSE(detector.OnQueueDelay(1, base::Milliseconds(60)));
+  EXPECT_TRUE(detector.overloaded());
+  EXPECT_TRUE(detector.OnQueueDelay(1, base::Milliseconds(49)));
+  EXPECT_FALSE(detector.overloaded());
+}
+
+}  // namespace test
+}  // namespace quic
+}  // namespace owt
@@ -7,6 +7,7 @@
 #include "owt/quic/logging.h"
 #include <unordered_map>
 #include "base/logging.h"
+#include "impl/async_logger.h"
 
 namespace owt {
 namespace quic {
@@ -43,5 +44,17 @@ void Logging::InitLogging() {
   logging::InitLogging(settings);
 }
 
+void Logging::SetLogSink(LogSink* sink) {
+  AsyncLogger::GetInstance()->SetSink(sink);
+}
+
+void Logging::Flush() {
+  AsyncLogger::GetInstance()->Flush();
+}
+
+uint64_t Logging::DroppedMessages() {
+  return AsyncLogger::GetInstance()->dropped_messages();
+}
+
 }  // namespace quic
 }  // namespace owt
\ No newline at end of file
@@ -0,0 +1,310 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "owt/quic/metrics.h"
+#include <algorithm>
+#include <cinttypes>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <utility>
+#include "base/bits.h"
+#include "base/check_op.h"
+#include "base/strings/stringprintf.h"
+#include "impl/metrics.h"
+
+namespace owt {
+namespace quic {
+
+namespace {
+constexpr char kMetricPrefix[] = "owt_quic_";
+
+const char* const kCounterNames[] = {
+    "packets_received", "bytes_received",  "packets_sent",
+    "bytes_sent",       "streams_opened",  "streams_closed",
+    "datagrams_dropped", "peer_migrations",
+};
+static_assert(std::size(kCounterNames) ==
+                  static_cast<size_t>(MetricCounter::kCount),
+              "Missing counter names.");
+
+const char* const kHistogramNames[] = {
+    "server_handshake_latency_us",
+    "client_handshake_latency_us",
+    "event_queue_delay_us",
+};
+static_assert(std::size(kHistogramNames) ==
+                  static_cast<size_t>(MetricHistogram::kCount),
+              "Missing histogram names.");
+
+const char* const kGaugeNames[] = {
+    "server_memory_bytes",
+    "server_stream_send_buffer_bytes",
+    "server_stream_receive_buffer_bytes",
+    "server_datagram_buffer_bytes",
+};
+static_assert(std::size(kGaugeNames) ==
+                  static_cast<size_t>(MetricGauge::kCount),
+              "Missing gauge names.");
+
+// Each shard is only updated by its own thread, so there is no need for
+// read-modify-write instructions.
+void AddRelaxed(std::atomic<uint64_t>* value, uint64_t delta) {
+  value->store(value->load(std::memory_order_relaxed) + delta,
+               std::memory_order_relaxed);
+}
+}  // namespace
+
+LogLinearHistogram::Counts::Counts()
+    : buckets(kBucketCount, 0),
+      count(0),
+      sum(0),
+      min(std::numeric_limits<uint64_t>::max()),
+      max(0) {}
+
+LogLinearHistogram::Counts::~Counts() = default;
+
+LogLinearHistogram::LogLinearHistogram()
+    : count_(0),
+      sum_(0),
+      min_(std::numeric_limits<uint64_t>::max()),
+      max_(0) {
+  for (auto& bucket : buckets_) {
+    bucket.store(0, std::memory_order_relaxed);
+  }
+}
+
+LogLinearHistogram::~LogLinearHistogram() = default;
+
+void LogLinearHistogram::Record(uint64_t value) {
+  AddRelaxed(&buckets_[BucketIndex(value)], 1);
+  AddRelaxed(&count_, 1);
+  AddRelaxed(&sum_, value);
+  if (value < min_.load(std::memory_order_relaxed)) {
+    min_.store(value, std::memory_order_relaxed);
+  }
+  if (value > max_.load(std::memory_order_relaxed)) {
+    max_.store(value, std::memory_order_relaxed);
+  }
+}
+
+void LogLinearHistogram::AddTo(Counts* counts) const {
+  DCHECK_EQ(counts->buckets.size(), kBucketCount);
+  for (size_t i = 0; i < kBucketCount; i++) {
+    counts->buckets[i] += buckets_[i].load(std::memory_order_relaxed);
+  }
+  counts->count += count_.load(std::memory_order_relaxed);
+  counts->sum += sum_.load(std::memory_order_relaxed);
+  counts->min = std::min(counts->min, min_.load(std::memory_order_relaxed));
+  counts->max = std::max(counts->max, max_.load(std::memory_order_relaxed));
+}
+
+// static
+size_t LogLinearHistogram::BucketIndex(uint64_t value) {
+  if (value < kSubBucketCount) {
+    return value;
+  }
+  const int highest_bit = 63 - base::bits::CountLeadingZeroBits(value);
+  const int shift = highest_bit - kSubBucketBits;
+  return (highest_bit - kSubBucketBits + 1) * kSubBucketCount +
+         ((value >> shift) & (kSubBucketCount - 1));
+}
+
+// static
+uint64_t LogLinearHistogram::BucketLowerBound(size_t index) {
+  DCHECK_LT(index, kBucketCount);
+  if (index < kSubBucketCount) {
+    return index;
+  }
+  const int shift = index / kSubBucketCount - 1;
+  return (kSubBucketCount + index % kSubBucketCount) << shift;
+}
+
+// static
+uint64_t LogLinearHistogram::BucketUpperBound(size_t index) {
+  if (index < kSubBucketCount) {
+    return index;
+  }
+  const int shift = index / kSubBucketCount - 1;
+  return BucketLowerBound(index) + ((uint64_t(1) << shift) - 1);
+}
+
+// static
+uint64_t LogLinearHistogram::ValueAtPercentile(const Counts& counts,
+                                               double percentile) {
+  if (counts.count == 0) {
+    return 0;
+  }
+  const uint64_t rank = std::max<uint64_t>(
+      1, static_cast<uint64_t>(std::ceil(percentile / 100 * counts.count)));
+  uint64_t seen = 0;
+  for (size_t i = 0; i < kBucketCount; i++) {
+    seen += counts.buckets[i];
+    if (seen >= rank) {
+      const uint64_t lower = BucketLowerBound(i);
+      const uint64_t middle = lower + (BucketUpperBound(i) - lower) / 2;
+      return std::min(std::max(middle, counts.min), counts.max);
+    }
+  }
+  return counts.max;
+}
+
+// static
+HistogramSnapshot LogLinearHistogram::ToSnapshot(const Counts& counts) {
+  HistogramSnapshot snapshot;
+  snapshot.count = counts.count;
+  snapshot.sum = counts.sum;
+  snapshot.min = counts.count > 0 ? counts.min : 0;
+  snapshot.max = counts.max;
+  snapshot.p50 = ValueAtPercentile(counts, 50);
+  snapshot.p90 = ValueAtPercentile(counts, 90);
+  snapshot.p99 = ValueAtPercentile(counts, 99);
+  snapshot.p999 = ValueAtPercentile(counts, 99.9);
+  return snapshot;
+}
+
+MetricsRegistry::Shard::Shard() = default;
+
+MetricsRegistry::Shard::~Shard() = default;
+
+MetricsRegistry::MetricsRegistry() = default;
+
+MetricsRegistry::~MetricsRegistry() = default;
+
+// static
+MetricsRegistry* MetricsRegistry::GetInstance() {
+  static base::NoDestructor<MetricsRegistry> instance;
+  return instance.get();
+}
+
+// static
+void MetricsRegistry::Increment(MetricCounter counter, uint64_t value) {
+  Shard* shard = GetInstance()->CurrentThreadShard();
+  AddRelaxed(&shard->counters[static_cast<int>(counter)].value, value);
+}
+
+// static
+void MetricsRegistry::Record(MetricHistogram histogram, uint64_t value) {
+  GetInstance()
+      ->CurrentThreadShard()
+      ->histograms[static_cast<int>(histogram)]
+      .Record(value);
+}
+
+// static
+void MetricsRegistry::AddToGauge(MetricGauge gauge, int64_t delta) {
+  Shard* shard = GetInstance()->CurrentThreadShard();
+  AddRelaxed(&shard->gauges[static_cast<int>(gauge)].value,
+             static_cast<uint64_t>(delta));
+}
+
+MetricsSnapshot MetricsRegistry::Snapshot() const {
+  MetricsSnapshot snapshot;
+  memset(&snapshot, 0, sizeof(snapshot));
+  LogLinearHistogram::Counts
+      histogram_counts[static_cast<int>(MetricHistogram::kCount)];
+  uint64_t gauges[static_cast<int>(MetricGauge::kCount)] = {};
+  {
+    base::AutoLock lock(lock_);
+    for (const auto& shard : shards_) {
+      for (int i = 0; i < static_cast<int>(MetricCounter::kCount); i++) {
+        snapshot.counters[i] +=
+            shard->counters[i].value.load(std::memory_order_relaxed);
+      }
+      for (int i = 0; i < static_cast<int>(MetricHistogram::kCount); i++) {
+        shard->histograms[i].AddTo(&histogram_counts[i]);
+      }
+      for (int i = 0; i < static_cast<int>(MetricGauge::kCount); i++) {
+        gauges[i] += shard->gauges[i].value.load(std::memory_order_relaxed);
+      }
+    }
+  }
+  for (int i = 0; i < static_cast<int>(MetricGauge::kCount); i++) {
+    snapshot.gauges[i] = static_cast<int64_t>(gauges[i]);
+  }
+  for (int i = 0; i < static_cast<int>(MetricHistogram::kCount); i++) {
+    snapshot.histograms[i] =
+        LogLinearHistogram::ToSnapshot(histogram_counts[i]);
+  }
+  return snapshot;
+}
+
+MetricsRegistry::Shard* MetricsRegistry::CurrentThreadShard() {
+  Shard* shard = current_shard_.Get();
+  if (shard) {
+    return shard;
+  }
+  auto new_shard = std::make_unique<Shard>();
+  shard = new_shard.get();
+  {
+    base::AutoLock lock(lock_);
+    shards_.push_back(std::move(new_shard));
+  }
+  current_shard_.Set(shard);
+  return shard;
+}
+
+MetricsSnapshot Metrics::Snapshot() {
+  return MetricsRegistry::GetInstance()->Snapshot();
+}
+
+size_t Metrics::PrometheusText(char* buffer, size_t size) {
+  const MetricsSnapshot snapshot = Snapshot();
+  std::string text;
+  for (int i = 0; i < static_cast<int>(MetricCounter::kCount); i++) {
+    const char* name = kCounterNames[i];
+    base::StringAppendF(&text,
+                        "# TYPE %s%s_total counter\n%s%s_total %" PRIu64 "\n",
+                        kMetricPrefix, name, kMetricPrefix, name,
+                        snapshot.counters[i]);
+  }
+  for (int i = 0; i < static_cast<int>(MetricHistogram::kCount); i++) {
+    const char* name = kHistogramNames[i];
+    const HistogramSnapshot& histogram = snapshot.histograms[i];
+    base::StringAppendF(&text, "# TYPE %s%s summary\n", kMetricPrefix, name);
+    const std::pair<const char*, uint64_t> quantiles[] = {
+        {"0.5", histogram.p50},
+        {"0.9", histogram.p90},
+        {"0.99", histogram.p99},
+        {"0.999", histogram.p999}};
+    for (const auto& quantile : quantiles) {
+      base::StringAppendF(&text, "%s%s{quantile=\"%s\"} %" PRIu64 "\n",
+                          kMetricPrefix, name, quantile.first,
+                          quantile.second);
+    }
+    base::StringAppendF(&text, "%s%s_sum %" PRIu64 "\n%s%s_count %" PRIu64 "\n",
+                        kMetricPrefix, name, histogram.sum, kMetricPrefix,
+                        name, histogram.count);
+  }
+  for (int i = 0; i < static_cast<int>(MetricGauge::kCount); i++) {
+    const char* name = kGaugeNames[i];
+    base::StringAppendF(&text, "# TYPE %s%s gauge\n%s%s %" PRId64 "\n",
+                        kMetricPrefix, name, kMetricPrefix, name,
+                        snapshot.gauges[i]);
+  }
+  if (buffer && size > 0) {
+    const size_t copied = std::min(text.size(), size - 1);
+    memcpy(buffer, text.data(), copied);
+    buffer[copied] = '\0';
+  }
+  return text.size();
+}
+
+const char* Metrics::Name(MetricCounter counter) {
+  return kCounterNames[static_cast<int>(counter)];
+}
+
+const char* Metrics::Name(MetricHistogram histogram) {
+  return kHistogramNames[static_cast<int>(histogram)];
+}
+
+const char* Metrics::Name(MetricGauge gauge) {
+  return kGaugeNames[static_cast<int>(gauge)];
+}
+
+}  // namespace quic
+}  // namespace owt
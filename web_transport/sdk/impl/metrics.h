@@ -0,0 +1,115 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef OWT_WEB_TRANSPORT_METRICS_IMPL_H_
+#define OWT_WEB_TRANSPORT_METRICS_IMPL_H_
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include "base/no_destructor.h"
+#include "base/synchronization/lock.h"
+#include "base/thread_annotations.h"
+#include "base/threading/thread_local.h"
+#include "owt/quic/metrics.h"
+
+namespace owt {
+namespace quic {
+
+// A histogram with log-linear buckets like HdrHistogram. Values below 16 have
+// their own buckets, larger values share a bucket with others of the same
+// highest set bit and the same next 4 bits. Only one thread records values,
+// others could read them.
+class LogLinearHistogram {
+ public:
+  static constexpr int kSubBucketBits = 4;
+  static constexpr size_t kSubBucketCount = 1 << kSubBucketBits;
+  static constexpr size_t kBucketCount = (64 - kSubBucketBits + 1) *
+                                         kSubBucketCount;
+
+  // Sums of multiple histograms.
+  struct Counts {
+    Counts();
+    ~Counts();
+    std::vector<uint64_t> buckets;
+    uint64_t count;
+    uint64_t sum;
+    uint64_t min;
+    uint64_t max;
+  };
+
+  LogLinearHistogram();
+  ~LogLinearHistogram();
+  LogLinearHistogram(const LogLinearHistogram&) = delete;
+  LogLinearHistogram& operator=(const LogLinearHistogram&) = delete;
+
+  void Record(uint64_t value);
+  // Adds values of this histogram to `counts`.
+  void AddTo(Counts* counts) const;
+
+  static size_t BucketIndex(uint64_t value);
+  // The smallest and the largest value of a bucket.
+  static uint64_t BucketLowerBound(size_t index);
+  static uint64_t BucketUpperBound(size_t index);
+  // Returns the value at `percentile` (0 - 100) of `counts`, or 0 if it's
+  // empty.
+  static uint64_t ValueAtPercentile(const Counts& counts, double percentile);
+  static HistogramSnapshot ToSnapshot(const Counts& counts);
+
+ private:
+  std::array<std::atomic<uint64_t>, kBucketCount> buckets_;
+  std::atomic<uint64_t> count_;
+  std::atomic<uint64_t> sum_;
+  std::atomic<uint64_t> min_;
+  std::atomic<uint64_t> max_;
+};
+
+// Holds metrics recorded by each thread in a separate shard, so recording a
+// value only touches cache lines of the current thread. Shards are kept after
+// their threads exit, since counters accumulate over the lifetime of the
+// process.
+class MetricsRegistry {
+ public:
+  static MetricsRegistry* GetInstance();
+
+  // Records a value from the current thread.
+  static void Increment(MetricCounter counter, uint64_t value = 1);
+  static void Record(MetricHistogram histogram, uint64_t value);
+  // Gauges are sums of deltas added by all threads.
+  static void AddToGauge(MetricGauge gauge, int64_t delta);
+
+  MetricsSnapshot Snapshot() const;
+
+ private:
+  struct alignas(64) PaddedCounter {
+    std::atomic<uint64_t> value{0};
+  };
+  struct Shard {
+    Shard();
+    ~Shard();
+    PaddedCounter counters[static_cast<int>(MetricCounter::kCount)];
+    LogLinearHistogram histograms[static_cast<int>(MetricHistogram::kCount)];
+    // Deltas are stored as unsigned values, whose sums wrap around to signed
+    // values.
+    PaddedCounter gauges[static_cast<int>(MetricGauge::kCount)];
+  };
+
+  MetricsRegistry();
+  ~MetricsRegistry();
+  friend class base::NoDestructor<MetricsRegistry>;
+
+  Shard* CurrentThreadShard();
+
+  base::ThreadLocalPointer<Shard> current_shard_;
+  mutable base::Lock lock_;
+  std::vector<std::unique_ptr<Shard>> shards_ GUARDED_BY(lock_);
+};
+
+}  // namespace quic
+}  // namespace owt
+
+#endif
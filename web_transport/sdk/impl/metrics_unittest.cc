@@ -0,0 +1,146 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "owt/web_transport/sdk/impl/metrics.h"
+#include <string>
+#include "base/bind.h"
+#include "base/synchronization/waitable_event.h"
+#include "base/threading/thread.h"
+#include "testing/gmock/include/gmock/gmock.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace owt {
+namespace quic {
+namespace test {
+
+using ::testing::HasSubstr;
+
+TEST(LogLinearHistogramTest, BucketBounds) {
+  for (uint64_t value = 0; value < 16; value++) {
+    EXPECT_EQ(LogLinearHistogram::BucketIndex(value), value);
+  }
+  EXPECT_EQ(LogLinearHistogram::BucketIndex(16), 16u);
+  EXPECT_EQ(LogLinearHistogram::BucketIndex(31), 31u);
+  EXPECT_EQ(LogLinearHistogram::BucketIndex(32), 32u);
+  EXPECT_EQ(LogLinearHistogram::BucketIndex(33), 32u);
+  EXPECT_EQ(LogLinearHistogram::BucketIndex(UINT64_MAX),
+            LogLinearHistogram::kBucketCount - 1);
+  EXPECT_EQ(LogLinearHistogram::BucketUpperBound(
+                LogLinearHistogram::kBucketCount - 1),
+            UINT64_MAX);
+  for (size_t i = 0; i + 1 < LogLinearHistogram::kBucketCount; i++) {
+    const uint64_t lower = LogLinearHistogram::BucketLowerBound(i);
+    const uint64_t upper = LogLinearHistogram::BucketUpperBound(i);
+    EXPECT_EQ(LogLinearHistogram::BucketIndex(lower), i);
+    EXPECT_EQ(LogLinearHistogram::BucketIndex(upper), i);
+    EXPECT_EQ(LogLinearHistogram::BucketLowerBound(i + 1), upper + 1);
+  }
+}
+
+TEST(LogLinearHistogramTest, Percentiles) {
+  LogLinearHistogram histogram;
+  for (uint64_t value = 1; value <= 1000; value++) {
+    histogram.Record(value);
+  }
+  LogLinearHistogram::Counts counts;
+  histogram.AddTo(&counts);
+  HistogramSnapshot snapshot = LogLinearHistogram::ToSnapshot(counts);
+  EXPECT_EQ(snapshot.count, 1000u);
+  EXPECT_EQ(snapshot.sum, 500500u);
+  EXPECT_EQ(snapshot.min, 1u);
+  EXPECT_EQ(snapshot.max, 1000u);
+  EXPECT_NEAR(snapshot.p50, 500, 500 / 16);
+  EXPECT_NEAR(snapshot.p90, 900, 900 / 16);
+  EXPECT_NEAR(snapshot.p99, 990, 990 / 16);
+  EXPECT_LE(snapshot.p999, 1000u);
+}
+
+TEST(LogLinearHistogramTest, EmptySnapshot) {
+  LogLinearHistogram::Counts counts;
+  HistogramSnapshot snapshot = LogLinearHistogram::ToSnapshot(counts);
+  EXPECT_EQ(snapshot.count, 0u);
+  EXPECT_EQ(snapshot.min, 0u);
+  EXPECT_EQ(snapshot.p99, 0u);
+}
+
+// The registry is shared by the whole process, so tests only check changes of
+// its values.
+TEST(MetricsRegistryTest, SumCountersOfAllThreads) {
+  const uint64_t packets_before =
+      Metrics::Snapshot()
+          .counters[static_cast<int>(MetricCounter::kPacketsReceived)];
+  MetricsRegistry::Increment(MetricCounter::kPacketsReceived, 3);
+  base::Thread thread("metrics_test_thread");
+  ASSERT_TRUE(thread.Start());
+  base::WaitableEvent done;
+  thread.task_runner()->PostTask(
+      FROM_HERE, base::BindOnce(
+                     [](base::WaitableEvent* done) {
+                       MetricsRegistry::Increment(
+                           MetricCounter::kPacketsReceived, 4);
+                       done->Signal();
+                     },
+                     base::Unretained(&done)));
+  done.Wait();
+  thread.Stop();
+  // Values recorded by a thread are kept after it exits.
+  EXPECT_EQ(Metrics::Snapshot()
+                .counters[static_cast<int>(MetricCounter::kPacketsReceived)],
+            packets_before + 7);
+}
+
+TEST(MetricsRegistryTest, RecordHistogram) {
+  const uint64_t count_before =
+      Metrics::Snapshot()
+          .histograms[static_cast<int>(MetricHistogram::kEventQueueDelay)]
+          .count;
+  MetricsRegistry::Record(MetricHistogram::kEventQueueDelay, 100);
+  EXPECT_EQ(Metrics::Snapshot()
+                .histograms[static_cast<int>(MetricHistogram::kEventQueueDelay)]
+                .count,
+            count_before + 1);
+}
+
+TEST(MetricsRegistryTest, GaugeSumsDeltas) {
+  const int gauge = static_cast<int>(MetricGauge::kServerMemoryBytes);
+  const int64_t before = Metrics::Snapshot().gauges[gauge];
+  MetricsRegistry::AddToGauge(MetricGauge::kServerMemoryBytes, 1000);
+  MetricsRegistry::AddToGauge(MetricGauge::kServerMemoryBytes, -400);
+  EXPECT_EQ(Metrics::Snapshot().gauges[gauge], before + 600);
+  MetricsRegistry::AddToGauge(MetricGauge::kServerMemoryBytes, -600);
+  EXPECT_EQ(Metrics::Snapshot().gauges[gauge], before);
+}
+
+TEST(MetricsTest, PrometheusText) {
+  const size_t length = Metrics::PrometheusText(nullptr, 0);
+  ASSERT_GT(length, 0u);
+  std::string text(length + 1, '\0');
+  EXPECT_EQ(Metrics::PrometheusText(&text[0], text.size()), length);
+  text.resize(length);
+  EXPECT_THAT(text,
+              HasSubstr("# TYPE owt_quic_packets_received_total counter"));
+  EXPECT_THAT(text,
+              HasSubstr("owt_quic_event_queue_delay_us{quantile=\"0.99\"}"));
+  EXPECT_THAT(text, HasSubstr("owt_quic_server_handshake_latency_us_count"));
+  EXPECT_THAT(text, HasSubstr("# TYPE owt_quic_server_memory_bytes gauge"));
+}
+
+TEST(MetricsTest, PrometheusTextTruncated) {
+  char buffer[8];
+  EXPECT_GT(Metrics::PrometheusText(buffer, sizeof(buffer)), sizeof(buffer));
+  EXPECT_EQ(buffer[sizeof(buffer) - 1], '\0');
+  EXPECT_EQ(std::string(buffer), "# TYPE ");
+}
+
+TEST(MetricsTest, Names) {
+  EXPECT_STREQ(Metrics::Name(MetricCounter::kBytesSent), "bytes_sent");
+  EXPECT_STREQ(Metrics::Name(MetricHistogram::kClientHandshakeLatency),
+               "client_handshake_latency_us");
+}
+
+}  // namespace test
+}  // namespace quic
+}  // namespace owt
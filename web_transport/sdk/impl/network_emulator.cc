@@ -0,0 +1,173 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "impl/network_emulator.h"
+#include <algorithm>
+#include "base/bind.h"
+#include "base/logging.h"
+
+namespace owt {
+namespace quic {
+
+namespace {
+// Interval of retrying held packets while the wrapped writer is blocked.
+constexpr base::TimeDelta kBlockedRetryInterval = base::Milliseconds(1);
+}  // namespace
+
+NetworkEmulatingPacketWriter::NetworkEmulatingPacketWriter(
+    ::quic::QuicPacketWriter* writer,
+    const NetworkEmulationOptions& options)
+    : options_(options),
+      random_(options.seed),
+      in_burst_loss_(false),
+      next_sequence_(0) {
+  set_writer(writer);
+}
+
+NetworkEmulatingPacketWriter::~NetworkEmulatingPacketWriter() = default;
+
+::quic::WriteResult NetworkEmulatingPacketWriter::WritePacket(
+    const char* buffer,
+    size_t buf_len,
+    const ::quic::QuicIpAddress& self_address,
+    const ::quic::QuicSocketAddress& peer_address,
+    ::quic::PerPacketOptions* options) {
+  const ::quic::WriteResult accepted(::quic::WRITE_STATUS_OK, buf_len);
+  const base::TimeTicks now = base::TimeTicks::Now();
+  base::TimeTicks departure_time = now;
+  if (options_.bandwidth_bps > 0) {
+    const base::TimeTicks start_time = std::max(now, link_free_time_);
+    if (options_.queue_bytes > 0) {
+      const uint64_t queued_bytes = (start_time - now).InMicroseconds() *
+                                    options_.bandwidth_bps / 8000000;
+      if (queued_bytes + buf_len > options_.queue_bytes) {
+        stats_.packets_dropped_by_queue++;
+        return accepted;
+      }
+    }
+    link_free_time_ =
+        start_time +
+        base::Microseconds(buf_len * 8000000 / options_.bandwidth_bps);
+    departure_time = link_free_time_;
+  }
+  if (IsLost()) {
+    return accepted;
+  }
+  base::TimeTicks delivery_time = departure_time;
+  if (RandomEvent(options_.reorder_rate)) {
+    stats_.packets_reordered++;
+  } else {
+    delivery_time += base::Milliseconds(options_.delay_ms);
+    if (options_.jitter_ms > 0) {
+      delivery_time += base::Microseconds(
+          std::uniform_int_distribution<int64_t>(
+              0, options_.jitter_ms * int64_t{1000})(random_));
+    }
+    delivery_time = std::max(delivery_time, last_delivery_time_);
+    last_delivery_time_ = delivery_time;
+  }
+  held_packets_.push(HeldPacket{delivery_time, next_sequence_++,
+                                std::string(buffer, buf_len), self_address,
+                                peer_address});
+  if (delivery_time <= now) {
+    DeliverDuePackets();
+  } else if (!delivery_timer_.IsRunning() ||
+             delivery_time < scheduled_delivery_time_) {
+    ScheduleDelivery(now, /*blocked=*/false);
+  }
+  return accepted;
+}
+
+bool NetworkEmulatingPacketWriter::SupportsReleaseTime() const {
+  return false;
+}
+
+bool NetworkEmulatingPacketWriter::IsBatchMode() const {
+  return false;
+}
+
+::quic::QuicPacketBuffer NetworkEmulatingPacketWriter::GetNextWriteLocation(
+    const ::quic::QuicIpAddress& self_address,
+    const ::quic::QuicSocketAddress& peer_address) {
+  return {nullptr, nullptr};
+}
+
+::quic::WriteResult NetworkEmulatingPacketWriter::Flush() {
+  // Held packets are flushed when they're written to the wrapped writer.
+  return ::quic::WriteResult(::quic::WRITE_STATUS_OK, 0);
+}
+
+bool NetworkEmulatingPacketWriter::RandomEvent(double probability) {
+  if (probability <= 0) {
+    return false;
+  }
+  return std::uniform_real_distribution<double>(0, 1)(random_) < probability;
+}
+
+bool NetworkEmulatingPacketWriter::IsLost() {
+  if (in_burst_loss_ || RandomEvent(options_.burst_loss_rate)) {
+    // Burst lengths are geometrically distributed.
+    in_burst_loss_ =
+        !RandomEvent(1.0 / std::max<uint32_t>(options_.burst_length, 1));
+    stats_.packets_dropped_in_bursts++;
+    return true;
+  }
+  if (RandomEvent(options_.loss_rate)) {
+    stats_.packets_dropped_randomly++;
+    return true;
+  }
+  return false;
+}
+
+void NetworkEmulatingPacketWriter::DeliverDuePackets() {
+  const base::TimeTicks now = base::TimeTicks::Now();
+  bool written = false;
+  bool blocked = false;
+  while (!held_packets_.empty() && held_packets_.top().delivery_time <= now) {
+    if (writer()->IsWriteBlocked()) {
+      blocked = true;
+      break;
+    }
+    const HeldPacket& packet = held_packets_.top();
+    const ::quic::WriteResult result =
+        writer()->WritePacket(packet.data.data(), packet.data.size(),
+                              packet.self_address, packet.peer_address,
+                              nullptr);
+    if (result.status == ::quic::WRITE_STATUS_BLOCKED) {
+      // Not buffered by the wrapped writer, it's written again later.
+      blocked = true;
+      break;
+    }
+    if (::quic::IsWriteError(result.status)) {
+      VLOG(1) << "Failed to write an emulated packet, error: "
+              << result.error_code;
+    }
+    held_packets_.pop();
+    written = true;
+  }
+  if (written && writer()->IsBatchMode()) {
+    writer()->Flush();
+  }
+  ScheduleDelivery(now, blocked);
+}
+
+void NetworkEmulatingPacketWriter::ScheduleDelivery(base::TimeTicks now,
+                                                    bool blocked) {
+  if (held_packets_.empty()) {
+    delivery_timer_.Stop();
+    return;
+  }
+  scheduled_delivery_time_ =
+      blocked ? now + kBlockedRetryInterval
+              : std::max(now, held_packets_.top().delivery_time);
+  delivery_timer_.Start(
+      FROM_HERE, scheduled_delivery_time_ - now,
+      base::BindOnce(&NetworkEmulatingPacketWriter::DeliverDuePackets,
+                     base::Unretained(this)));
+}
+
+}  // namespace quic
+}  // namespace owt
@@ -0,0 +1,188 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "owt/web_transport/sdk/impl/network_emulator.h"
+#include <algorithm>
+#include <vector>
+#include "base/test/task_environment.h"
+#include "net/third_party/quiche/src/quic/test_tools/quic_test_utils.h"
+#include "testing/gmock/include/gmock/gmock.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace owt {
+namespace quic {
+namespace test {
+
+using ::testing::_;
+using ::testing::NiceMock;
+using ::testing::Return;
+
+namespace {
+constexpr size_t kPacketSize = 100;
+
+class NetworkEmulatingPacketWriterTest : public testing::Test {
+ protected:
+  NetworkEmulatingPacketWriterTest()
+      : mock_writer_(new NiceMock<::quic::test::MockPacketWriter>()),
+        written_(0) {
+    ON_CALL(*mock_writer_, WritePacket(_, _, _, _, _))
+        .WillByDefault([this](const char*, size_t buf_len,
+                              const ::quic::QuicIpAddress&,
+                              const ::quic::QuicSocketAddress&,
+                              ::quic::PerPacketOptions*) {
+          written_++;
+          return ::quic::WriteResult(::quic::WRITE_STATUS_OK, buf_len);
+        });
+  }
+
+  std::unique_ptr<NetworkEmulatingPacketWriter> CreateWriter(
+      const NetworkEmulationOptions& options) {
+    return std::make_unique<NetworkEmulatingPacketWriter>(mock_writer_,
+                                                          options);
+  }
+
+  void WritePackets(NetworkEmulatingPacketWriter* writer, size_t count) {
+    const char buffer[kPacketSize] = {};
+    for (size_t i = 0; i < count; i++) {
+      EXPECT_EQ(writer
+                    ->WritePacket(buffer, sizeof(buffer),
+                                  ::quic::QuicIpAddress::Any6(),
+                                  ::quic::QuicSocketAddress(), nullptr)
+                    .status,
+                ::quic::WRITE_STATUS_OK);
+    }
+  }
+
+  base::test::TaskEnvironment task_environment_{
+      base::test::TaskEnvironment::TimeSource::MOCK_TIME};
+  // Owned by the writer created by CreateWriter().
+  NiceMock<::quic::test::MockPacketWriter>* mock_writer_;
+  size_t written_;
+};
+}  // namespace
+
+TEST_F(NetworkEmulatingPacketWriterTest, WritesImmediatelyWithoutImpairments) {
+  auto writer = CreateWriter(NetworkEmulationOptions());
+  WritePackets(writer.get(), 3);
+  EXPECT_EQ(written_, 3u);
+  EXPECT_EQ(writer->held_packets(), 0u);
+}
+
+TEST_F(NetworkEmulatingPacketWriterTest, DelaysPackets) {
+  NetworkEmulationOptions options;
+  options.delay_ms = 100;
+  auto writer = CreateWriter(options);
+  WritePackets(writer.get(), 2);
+  task_environment_.FastForwardBy(base::Milliseconds(99));
+  EXPECT_EQ(written_, 0u);
+  task_environment_.FastForwardBy(base::Milliseconds(1));
+  EXPECT_EQ(written_, 2u);
+}
+
+TEST_F(NetworkEmulatingPacketWriterTest, JitterKeepsOrder) {
+  NetworkEmulationOptions options;
+  options.delay_ms = 10;
+  options.jitter_ms = 50;
+  auto writer = CreateWriter(options);
+  std::vector<char> first_bytes;
+  EXPECT_CALL(*mock_writer_, WritePacket(_, _, _, _, _))
+      .WillRepeatedly([&first_bytes](const char* buffer, size_t buf_len,
+                                     const ::quic::QuicIpAddress&,
+                                     const ::quic::QuicSocketAddress&,
+                                     ::quic::PerPacketOptions*) {
+        first_bytes.push_back(buffer[0]);
+        return ::quic::WriteResult(::quic::WRITE_STATUS_OK, buf_len);
+      });
+  for (char i = 0; i < 20; i++) {
+    writer->WritePacket(&i, 1, ::quic::QuicIpAddress::Any6(),
+                        ::quic::QuicSocketAddress(), nullptr);
+  }
+  task_environment_.FastForwardBy(base::Milliseconds(60));
+  ASSERT_EQ(first_bytes.size(), 20u);
+  EXPECT_TRUE(std::is_sorted(first_bytes.begin(), first_bytes.end()));
+}
+
+TEST_F(NetworkEmulatingPacketWriterTest, ReorderedPacketsSkipDelay) {
+  NetworkEmulationOptions options;
+  options.delay_ms = 100;
+  options.reorder_rate = 1;
+  auto writer = CreateWriter(options);
+  WritePackets(writer.get(), 2);
+  EXPECT_EQ(written_, 2u);
+  EXPECT_EQ(writer->stats().packets_reordered, 2u);
+}
+
+TEST_F(NetworkEmulatingPacketWriterTest, LimitsBandwidth) {
+  NetworkEmulationOptions options;
+  // 100 ms per packet.
+  options.bandwidth_bps = kPacketSize * 8 * 10;
+  auto writer = CreateWriter(options);
+  WritePackets(writer.get(), 3);
+  task_environment_.FastForwardBy(base::Milliseconds(100));
+  EXPECT_EQ(written_, 1u);
+  task_environment_.FastForwardBy(base::Milliseconds(200));
+  EXPECT_EQ(written_, 3u);
+}
+
+TEST_F(NetworkEmulatingPacketWriterTest, DropsPacketsExceedingQueue) {
+  NetworkEmulationOptions options;
+  options.bandwidth_bps = kPacketSize * 8 * 10;
+  options.queue_bytes = kPacketSize * 2;
+  auto writer = CreateWriter(options);
+  WritePackets(writer.get(), 4);
+  EXPECT_EQ(writer->stats().packets_dropped_by_queue, 2u);
+  task_environment_.FastForwardBy(base::Seconds(1));
+  EXPECT_EQ(written_, 2u);
+}
+
+TEST_F(NetworkEmulatingPacketWriterTest, DropsPacketsInBursts) {
+  NetworkEmulationOptions options;
+  options.burst_loss_rate = 1;
+  options.burst_length = 4;
+  auto writer = CreateWriter(options);
+  WritePackets(writer.get(), 10);
+  EXPECT_EQ(written_, 0u);
+  EXPECT_EQ(writer->stats().packets_dropped_in_bursts, 10u);
+}
+
+TEST_F(NetworkEmulatingPacketWriterTest, SameSeedDropsSamePackets) {
+  NetworkEmulationOptions options;
+  options.loss_rate = 0.5;
+  options.seed = 42;
+  auto writer = CreateWriter(options);
+  WritePackets(writer.get(), 100);
+  const uint64_t dropped = writer->stats().packets_dropped_randomly;
+  EXPECT_GT(dropped, 0u);
+  EXPECT_LT(dropped, 100u);
+  EXPECT_EQ(written_ + dropped, 100u);
+
+  mock_writer_ = new NiceMock<::quic::test::MockPacketWriter>();
+  ON_CALL(*mock_writer_, WritePacket(_, _, _, _, _))
+      .WillByDefault(
+          Return(::quic::WriteResult(::quic::WRITE_STATUS_OK, kPacketSize)));
+  auto another_writer = CreateWriter(options);
+  WritePackets(another_writer.get(), 100);
+  EXPECT_EQ(another_writer->stats().packets_dropped_randomly, dropped);
+}
+
+TEST_F(NetworkEmulatingPacketWriterTest, RetriesWhileWrappedWriterIsBlocked) {
+  auto writer = CreateWriter(NetworkEmulationOptions());
+  EXPECT_CALL(*mock_writer_, IsWriteBlocked())
+      .WillOnce(Return(true))
+      .WillOnce(Return(true))
+      .WillRepeatedly(Return(false));
+  WritePackets(writer.get(), 1);
+  EXPECT_EQ(writer->held_packets(), 1u);
+  task_environment_.FastForwardBy(base::Milliseconds(1));
+  EXPECT_EQ(writer->held_packets(), 1u);
+  task_environment_.FastForwardBy(base::Milliseconds(1));
+  EXPECT_EQ(writer->held_packets(), 0u);
+  EXPECT_EQ(written_, 1u);
+}
+
+}  // namespace test
+}  // namespace quic
+}  // namespace owt
@@ -0,0 +1,134 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "impl/object_pool.h"
+#include <memory>
+#include <new>
+#include "base/no_destructor.h"
+#include "base/threading/thread_local.h"
+
+namespace owt {
+namespace quic {
+
+namespace {
+constexpr size_t kFreeListCount =
+    ObjectPool::kMaxObjectSize / ObjectPool::kSizeGranularity;
+
+size_t FreeListIndex(size_t size) {
+  return size == 0 ? 0 : (size - 1) / ObjectPool::kSizeGranularity;
+}
+
+// Free lists of a thread. Objects are at least kSizeGranularity bytes, so a
+// free object could hold a link.
+class ThreadObjectCache {
+ public:
+  ThreadObjectCache() = default;
+  ~ThreadObjectCache() {
+    for (FreeList& list : free_lists_) {
+      while (list.head) {
+        FreeObject* object = list.head;
+        list.head = object->next;
+        ::operator delete(object);
+      }
+    }
+  }
+  ThreadObjectCache(const ThreadObjectCache&) = delete;
+  ThreadObjectCache& operator=(const ThreadObjectCache&) = delete;
+
+  void* Allocate(size_t index) {
+    FreeList& list = free_lists_[index];
+    if (!list.head) {
+      return ::operator new((index + 1) * ObjectPool::kSizeGranularity);
+    }
+    FreeObject* object = list.head;
+    list.head = object->next;
+    list.count--;
+    cached_objects_--;
+    hits_++;
+    return object;
+  }
+
+  void Free(void* memory, size_t index) {
+    FreeList& list = free_lists_[index];
+    if (list.count >= ObjectPool::kMaxCachedObjectsPerSize) {
+      ::operator delete(memory);
+      return;
+    }
+    FreeObject* object = static_cast<FreeObject*>(memory);
+    object->next = list.head;
+    list.head = object;
+    list.count++;
+    cached_objects_++;
+  }
+
+  size_t cached_objects() const { return cached_objects_; }
+  uint64_t hits() const { return hits_; }
+
+ private:
+  struct FreeObject {
+    FreeObject* next;
+  };
+  struct FreeList {
+    FreeObject* head = nullptr;
+    size_t count = 0;
+  };
+
+  FreeList free_lists_[kFreeListCount];
+  size_t cached_objects_ = 0;
+  uint64_t hits_ = 0;
+};
+
+base::ThreadLocalOwnedPointer<ThreadObjectCache>& ThreadCaches() {
+  static base::NoDestructor<base::ThreadLocalOwnedPointer<ThreadObjectCache>>
+      caches;
+  return *caches;
+}
+
+ThreadObjectCache* CurrentThreadCache() {
+  ThreadObjectCache* cache = ThreadCaches().Get();
+  if (!cache) {
+    auto new_cache = std::make_unique<ThreadObjectCache>();
+    cache = new_cache.get();
+    ThreadCaches().Set(std::move(new_cache));
+  }
+  return cache;
+}
+}  // namespace
+
+// static
+void* ObjectPool::Allocate(size_t size) {
+  if (size > kMaxObjectSize) {
+    return ::operator new(size);
+  }
+  return CurrentThreadCache()->Allocate(FreeListIndex(size));
+}
+
+// static
+void ObjectPool::Free(void* object, size_t size) {
+  if (!object) {
+    return;
+  }
+  if (size > kMaxObjectSize) {
+    ::operator delete(object);
+    return;
+  }
+  CurrentThreadCache()->Free(object, FreeListIndex(size));
+}
+
+// static
+size_t ObjectPool::CachedObjectsOnCurrentThread() {
+  ThreadObjectCache* cache = ThreadCaches().Get();
+  return cache ? cache->cached_objects() : 0;
+}
+
+// static
+uint64_t ObjectPool::HitsOnCurrentThread() {
+  ThreadObjectCache* cache = ThreadCaches().Get();
+  return cache ? cache->hits() : 0;
+}
+
+}  // namespace quic
+}  // namespace owt
@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "owt/web_transport/sdk/impl/object_pool.h"
+#include <memory>
+#include <vector>
+#include "base/bind.h"
+#include "base/synchronization/waitable_event.h"
+#include "base/threading/thread.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace owt {
+namespace quic {
+namespace test {
+
+namespace {
+class Base : public PooledObject {
+ public:
+  virtual ~Base() = default;
+  char data[100];
+};
+
+class Derived : public Base {
+ public:
+  char more_data[500];
+};
+}  // namespace
+
+TEST(ObjectPoolTest, ReuseMemoryOfDestroyedObjects) {
+  base::Thread thread("object_pool_test_thread");
+  ASSERT_TRUE(thread.Start());
+  base::WaitableEvent done;
+  thread.task_runner()->PostTask(
+      FROM_HERE,
+      base::BindOnce(
+          [](base::WaitableEvent* done) {
+            auto object = std::make_unique<Base>();
+            Base* address = object.get();
+            object.reset();
+            EXPECT_EQ(1u, ObjectPool::CachedObjectsOnCurrentThread());
+            object = std::make_unique<Base>();
+            EXPECT_EQ(address, object.get());
+            EXPECT_EQ(1u, ObjectPool::HitsOnCurrentThread());
+            EXPECT_EQ(0u, ObjectPool::CachedObjectsOnCurrentThread());
+            done->Signal();
+          },
+          base::Unretained(&done)));
+  done.Wait();
+}
+
+TEST(ObjectPoolTest, DerivedObjectsUseTheirOwnSize) {
+  base::Thread thread("object_pool_test_thread");
+  ASSERT_TRUE(thread.Start());
+  base::WaitableEvent done;
+  thread.task_runner()->PostTask(
+      FROM_HERE,
+      base::BindOnce(
+          [](base::WaitableEvent* done) {
+            std::unique_ptr<Base> derived = std::make_unique<Derived>();
+            Base* address = derived.get();
+            derived.reset();
+            // A Base doesn't get memory of a destroyed Derived.
+            auto base = std::make_unique<Base>();
+            EXPECT_NE(address, base.get());
+            std::unique_ptr<Base> another_derived = std::make_unique<Derived>();
+            EXPECT_EQ(address, another_derived.get());
+            done->Signal();
+          },
+          base::Unretained(&done)));
+  done.Wait();
+}
+
+TEST(ObjectPoolTest, CachedObjectsAreBounded) {
+  base::Thread thread("object_pool_test_thread");
+  ASSERT_TRUE(thread.Start());
+  base::WaitableEvent done;
+  thread.task_runner()->PostTask(
+      FROM_HERE,
+      base::BindOnce(
+          [](base::WaitableEvent* done) {
+            std::vector<std::unique_ptr<Base>> objects;
+            for (size_t i = 0; i < ObjectPool::kMaxCachedObjectsPerSize + 10;
+                 i++) {
+              objects.push_back(std::make_unique<Base>());
+            }
+            objects.clear();
+            EXPECT_EQ(ObjectPool::kMaxCachedObjectsPerSize,
+                      ObjectPool::CachedObjectsOnCurrentThread());
+            done->Signal();
+          },
+          base::Unretained(&done)));
+  done.Wait();
+}
+
+TEST(ObjectPoolTest, LargeObjectsAreNotCached) {
+  void* object = ObjectPool::Allocate(ObjectPool::kMaxObjectSize + 1);
+  ASSERT_TRUE(object);
+  const size_t cached = ObjectPool::CachedObjectsOnCurrentThread();
+  ObjectPool::Free(object, ObjectPool::kMaxObjectSize + 1);
+  EXPECT_EQ(cached, ObjectPool::CachedObjectsOnCurrentThread());
+}
+
+}  // namespace test
+}  // namespace quic
+}  // namespace owt
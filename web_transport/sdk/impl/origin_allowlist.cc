@@ -0,0 +1,34 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "impl/origin_allowlist.h"
+
+namespace owt {
+namespace quic {
+
+OriginAllowlist::OriginAllowlist() : restricted_(false) {}
+
+OriginAllowlist::OriginAllowlist(const std::vector<url::Origin>& origins)
+    : restricted_(!origins.empty()) {
+  for (const url::Origin& origin : origins) {
+    if (origin.opaque()) {
+      continue;
+    }
+    origins_.insert(origin.Serialize());
+  }
+}
+
+OriginAllowlist::~OriginAllowlist() = default;
+
+bool OriginAllowlist::IsAllowed(absl::string_view origin) const {
+  if (!restricted_) {
+    return true;
+  }
+  return !origin.empty() && origins_.contains(origin);
+}
+
+}  // namespace quic
+}  // namespace owt
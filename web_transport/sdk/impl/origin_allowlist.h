@@ -0,0 +1,44 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef OWT_WEB_TRANSPORT_ORIGIN_ALLOWLIST_H_
+#define OWT_WEB_TRANSPORT_ORIGIN_ALLOWLIST_H_
+
+#include <string>
+#include <vector>
+#include "third_party/abseil-cpp/absl/container/flat_hash_set.h"
+#include "third_party/abseil-cpp/absl/strings/string_view.h"
+#include "url/origin.h"
+
+namespace owt {
+namespace quic {
+
+// Origins allowed to establish WebTransport sessions. Origins are serialized
+// once when the allowlist is built, so checking a request is a hash lookup of
+// its Origin header, which browsers always send in serialized form. An
+// allowlist built from no origin allows all requests.
+class OriginAllowlist {
+ public:
+  OriginAllowlist();
+  // Opaque origins in `origins` never match, but still restrict requests to
+  // the other origins, so a list of invalid origins doesn't allow all.
+  explicit OriginAllowlist(const std::vector<url::Origin>& origins);
+  ~OriginAllowlist();
+
+  bool empty() const { return !restricted_; }
+  // `origin` is the value of the Origin header, empty if there is none.
+  // Requests without Origin header are only allowed by an empty allowlist.
+  bool IsAllowed(absl::string_view origin) const;
+
+ private:
+  bool restricted_;
+  absl::flat_hash_set<std::string> origins_;
+};
+
+}  // namespace quic
+}  // namespace owt
+
+#endif
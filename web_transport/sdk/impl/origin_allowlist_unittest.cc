@@ -0,0 +1,46 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "owt/web_transport/sdk/impl/origin_allowlist.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "url/gurl.h"
+
+namespace owt {
+namespace quic {
+namespace test {
+
+TEST(OriginAllowlistTest, EmptyAllowlistAllowsAll) {
+  OriginAllowlist allowlist;
+  EXPECT_TRUE(allowlist.empty());
+  EXPECT_TRUE(allowlist.IsAllowed("https://example.com"));
+  EXPECT_TRUE(allowlist.IsAllowed(""));
+}
+
+TEST(OriginAllowlistTest, OnlyListedOriginsAreAllowed) {
+  OriginAllowlist allowlist(
+      {url::Origin::Create(GURL("https://example.com/path")),
+       url::Origin::Create(GURL("https://example.org:8443")),
+       url::Origin()});
+  EXPECT_FALSE(allowlist.empty());
+  EXPECT_TRUE(allowlist.IsAllowed("https://example.com"));
+  EXPECT_TRUE(allowlist.IsAllowed("https://example.org:8443"));
+  EXPECT_FALSE(allowlist.IsAllowed("https://example.org"));
+  EXPECT_FALSE(allowlist.IsAllowed("http://example.com"));
+  EXPECT_FALSE(allowlist.IsAllowed("null"));
+  EXPECT_FALSE(allowlist.IsAllowed(""));
+}
+
+TEST(OriginAllowlistTest, OpaqueOriginsAllowNothing) {
+  OriginAllowlist allowlist({url::Origin::Create(GURL("not a url"))});
+  EXPECT_FALSE(allowlist.empty());
+  EXPECT_FALSE(allowlist.IsAllowed("https://example.com"));
+  EXPECT_FALSE(allowlist.IsAllowed("null"));
+  EXPECT_FALSE(allowlist.IsAllowed(""));
+}
+
+}  // namespace test
+}  // namespace quic
+}  // namespace owt
@@ -0,0 +1,200 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "impl/placed_memory.h"
+#include <cstdint>
+#include <vector>
+#include "base/logging.h"
+#include "build/build_config.h"
+#if defined(OS_WIN)
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+#if defined(OS_LINUX) || defined(OS_CHROMEOS)
+#include <sys/syscall.h>
+#endif
+
+namespace owt {
+namespace quic {
+
+namespace {
+size_t RoundUp(size_t size, size_t alignment) {
+  return (size + alignment - 1) / alignment * alignment;
+}
+
+size_t PageSize() {
+#if defined(OS_WIN)
+  SYSTEM_INFO info;
+  GetSystemInfo(&info);
+  return info.dwPageSize;
+#else
+  return static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#endif
+}
+
+// Touches every page of `data`, so they're allocated by the policy bound to
+// them instead of on the first write of a packet.
+void Prefault(char* data, size_t size) {
+  const size_t page_size = PageSize();
+  for (size_t offset = 0; offset < size; offset += page_size) {
+    data[offset] = 0;
+  }
+}
+
+#if defined(OS_WIN)
+char* Map(size_t size,
+          const MemoryPlacement& placement,
+          bool* huge_pages,
+          bool* numa_bound) {
+  const DWORD node =
+      placement.numa_node >= 0 ? static_cast<DWORD>(placement.numa_node)
+                               : NUMA_NO_PREFERRED_NODE;
+  void* memory = nullptr;
+  // Large pages require SeLockMemoryPrivilege.
+  if (placement.huge_pages && GetLargePageMinimum() > 0 &&
+      size % GetLargePageMinimum() == 0) {
+    memory = VirtualAllocExNuma(GetCurrentProcess(), nullptr, size,
+                                MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES,
+                                PAGE_READWRITE, node);
+    *huge_pages = memory != nullptr;
+  }
+  if (!memory) {
+    memory = VirtualAllocExNuma(GetCurrentProcess(), nullptr, size,
+                                MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE, node);
+  }
+  *numa_bound = memory && placement.numa_node >= 0;
+  if (!memory && node != NUMA_NO_PREFERRED_NODE) {
+    // E.g.: the node doesn't exist.
+    memory = VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT,
+                          PAGE_READWRITE);
+  }
+  return static_cast<char*>(memory);
+}
+
+void Unmap(char* data, size_t size) {
+  PLOG_IF(WARNING, !VirtualFree(data, 0, MEM_RELEASE))
+      << "Failed to free placed memory.";
+}
+#else
+char* MapAnonymous(size_t size, int extra_flags) {
+  void* memory = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS | extra_flags, -1, 0);
+  return memory == MAP_FAILED ? nullptr : static_cast<char*>(memory);
+}
+
+#if defined(OS_LINUX) || defined(OS_CHROMEOS)
+// Maps `size` bytes, a multiple of kHugePageSize, backed by huge pages if
+// they're available. Reserved huge pages are used if there are enough,
+// otherwise transparent huge pages are requested for a 2 MB aligned region.
+char* MapHugePages(size_t size, bool* huge_pages) {
+  char* memory = MapAnonymous(size, MAP_HUGETLB);
+  if (memory) {
+    *huge_pages = true;
+    return memory;
+  }
+  const size_t alignment = PlacedMemory::kHugePageSize;
+  char* mapping = MapAnonymous(size + alignment, 0);
+  if (!mapping) {
+    return nullptr;
+  }
+  memory = reinterpret_cast<char*>(
+      RoundUp(reinterpret_cast<uintptr_t>(mapping), alignment));
+  if (memory > mapping) {
+    munmap(mapping, memory - mapping);
+  }
+  const size_t tail = (mapping + size + alignment) - (memory + size);
+  if (tail > 0) {
+    munmap(memory + size, tail);
+  }
+  *huge_pages = madvise(memory, size, MADV_HUGEPAGE) == 0;
+  return memory;
+}
+
+// Prefers `node` for pages of `data` not allocated yet.
+bool BindToNumaNode(char* data, size_t size, int32_t node) {
+  // Guards against huge node masks for invalid nodes.
+  constexpr int32_t kMaxNumaNode = 1023;
+  constexpr int kMpolPreferred = 1;
+  constexpr size_t kBitsPerWord = sizeof(unsigned long) * 8;
+  if (node > kMaxNumaNode) {
+    return false;
+  }
+  std::vector<unsigned long> mask(node / kBitsPerWord + 1, 0);
+  mask[node / kBitsPerWord] |= 1UL << (node % kBitsPerWord);
+  // Like libnuma, one more than the bits of the mask, since the kernel
+  // ignores the last bit.
+  return syscall(SYS_mbind, data, size, kMpolPreferred, mask.data(),
+                 mask.size() * kBitsPerWord + 1, 0) == 0;
+}
+#endif
+
+char* Map(size_t size,
+          const MemoryPlacement& placement,
+          bool* huge_pages,
+          bool* numa_bound) {
+#if defined(OS_LINUX) || defined(OS_CHROMEOS)
+  char* memory = placement.huge_pages ? MapHugePages(size, huge_pages)
+                                      : MapAnonymous(size, 0);
+  if (memory && placement.numa_node >= 0) {
+    *numa_bound = BindToNumaNode(memory, size, placement.numa_node);
+  }
+  return memory;
+#else
+  return MapAnonymous(size, 0);
+#endif
+}
+
+void Unmap(char* data, size_t size) {
+  PLOG_IF(WARNING, munmap(data, size) != 0)
+      << "Failed to unmap placed memory.";
+}
+#endif
+}  // namespace
+
+// static
+scoped_refptr<PlacedMemory> PlacedMemory::Allocate(
+    size_t size,
+    const MemoryPlacement& placement) {
+  if (size == 0) {
+    return nullptr;
+  }
+  size = RoundUp(size, placement.huge_pages ? kHugePageSize : PageSize());
+  bool huge_pages = false;
+  bool numa_bound = false;
+  char* data = Map(size, placement, &huge_pages, &numa_bound);
+  if (!data) {
+    PLOG(WARNING) << "Failed to map " << size << " bytes of buffer memory.";
+    return nullptr;
+  }
+  LOG_IF(WARNING, placement.huge_pages && !huge_pages)
+      << "Huge pages are not available, buffers use normal pages.";
+  LOG_IF(WARNING, placement.numa_node >= 0 && !numa_bound)
+      << "Failed to allocate buffers on NUMA node " << placement.numa_node
+      << ".";
+  if (numa_bound) {
+    Prefault(data, size);
+  }
+  return base::WrapRefCounted(
+      new PlacedMemory(data, size, huge_pages, numa_bound));
+}
+
+PlacedMemory::PlacedMemory(char* data,
+                           size_t size,
+                           bool huge_pages,
+                           bool numa_bound)
+    : data_(data),
+      size_(size),
+      huge_pages_(huge_pages),
+      numa_bound_(numa_bound) {}
+
+PlacedMemory::~PlacedMemory() {
+  Unmap(data_, size_);
+}
+
+}  // namespace quic
+}  // namespace owt
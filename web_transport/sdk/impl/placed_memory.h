@@ -0,0 +1,70 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef OWT_WEB_TRANSPORT_PLACED_MEMORY_H_
+#define OWT_WEB_TRANSPORT_PLACED_MEMORY_H_
+
+#include <cstddef>
+#include <cstdint>
+#include "base/memory/ref_counted.h"
+#include "base/memory/scoped_refptr.h"
+
+namespace owt {
+namespace quic {
+
+// Where memory of a buffer pool is placed.
+struct MemoryPlacement {
+  // NUMA node the memory is allocated on. -1 leaves it to the OS, which
+  // usually allocates pages on the node of the thread touching them first.
+  int32_t numa_node = -1;
+  // Backs the memory with 2 MB huge pages, so packet buffers cost fewer TLB
+  // entries.
+  bool huge_pages = false;
+
+  bool IsDefault() const { return numa_node < 0 && !huge_pages; }
+};
+
+// A region of memory mapped with a MemoryPlacement, for buffer pools carving
+// many buffers out of it. Placement is best effort: reserved huge pages are
+// tried first, then transparent huge pages, then normal pages; the NUMA node
+// is preferred rather than required. Memory bound to a node is touched when
+// it's mapped, so its pages are allocated there up front. It's unmapped when
+// the last reference is released, on any thread.
+class PlacedMemory : public base::RefCountedThreadSafe<PlacedMemory> {
+ public:
+  static constexpr size_t kHugePageSize = 2 * 1024 * 1024;
+
+  // Returns nullptr if no memory could be mapped. `size` is rounded up to
+  // pages, or to huge pages if they're requested.
+  static scoped_refptr<PlacedMemory> Allocate(
+      size_t size,
+      const MemoryPlacement& placement);
+
+  PlacedMemory(const PlacedMemory&) = delete;
+  PlacedMemory& operator=(const PlacedMemory&) = delete;
+
+  char* data() const { return data_; }
+  size_t size() const { return size_; }
+  // Whether the placement requested is applied.
+  bool huge_pages() const { return huge_pages_; }
+  bool numa_bound() const { return numa_bound_; }
+
+ private:
+  friend class base::RefCountedThreadSafe<PlacedMemory>;
+
+  PlacedMemory(char* data, size_t size, bool huge_pages, bool numa_bound);
+  ~PlacedMemory();
+
+  char* const data_;
+  const size_t size_;
+  const bool huge_pages_;
+  const bool numa_bound_;
+};
+
+}  // namespace quic
+}  // namespace owt
+
+#endif
@@ -0,0 +1,49 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "owt/web_transport/sdk/impl/placed_memory.h"
+#include <cstring>
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace owt {
+namespace quic {
+namespace test {
+
+TEST(PlacedMemoryTest, DefaultPlacement) {
+  EXPECT_TRUE(MemoryPlacement().IsDefault());
+  scoped_refptr<PlacedMemory> memory =
+      PlacedMemory::Allocate(1000, MemoryPlacement());
+  ASSERT_TRUE(memory);
+  EXPECT_GE(memory->size(), 1000u);
+  EXPECT_FALSE(memory->huge_pages());
+  EXPECT_FALSE(memory->numa_bound());
+  memset(memory->data(), 'a', memory->size());
+  EXPECT_FALSE(PlacedMemory::Allocate(0, MemoryPlacement()));
+}
+
+// Placement is best effort, memory is mapped without huge pages or NUMA
+// nodes.
+TEST(PlacedMemoryTest, FallBackToNormalPages) {
+  MemoryPlacement placement;
+  placement.huge_pages = true;
+  placement.numa_node = 0;
+  EXPECT_FALSE(placement.IsDefault());
+  scoped_refptr<PlacedMemory> memory = PlacedMemory::Allocate(1, placement);
+  ASSERT_TRUE(memory);
+  EXPECT_EQ(PlacedMemory::kHugePageSize, memory->size());
+  memset(memory->data(), 'a', memory->size());
+
+  // An invalid node.
+  placement.huge_pages = false;
+  placement.numa_node = 1 << 20;
+  memory = PlacedMemory::Allocate(1, placement);
+  ASSERT_TRUE(memory);
+  EXPECT_FALSE(memory->numa_bound());
+}
+
+}  // namespace test
+}  // namespace quic
+}  // namespace owt
@@ -0,0 +1,174 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "owt/web_transport/sdk/impl/pooled_buffer_allocator.h"
+#include <cstring>
+#include <vector>
+#include "base/bind.h"
+#include "base/synchronization/waitable_event.h"
+#include "base/test/task_environment.h"
+#include "base/threading/thread.h"
+#include "base/threading/thread_task_runner_handle.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace owt {
+namespace quic {
+namespace test {
+
+TEST(PooledBufferAllocatorTest, SizeClassIndex) {
+  EXPECT_EQ(0u, PooledBufferAllocator::SizeClassIndex(0));
+  EXPECT_EQ(0u, PooledBufferAllocator::SizeClassIndex(1));
+  EXPECT_EQ(0u, PooledBufferAllocator::SizeClassIndex(256));
+  EXPECT_EQ(1u, PooledBufferAllocator::SizeClassIndex(257));
+  EXPECT_EQ(3u, PooledBufferAllocator::SizeClassIndex(1350));
+  EXPECT_EQ(PooledBufferAllocator::kSizeClassCount - 1,
+            PooledBufferAllocator::SizeClassIndex(
+                PooledBufferAllocator::kMaxBlockSize));
+  EXPECT_EQ(PooledBufferAllocator::kSizeClassCount,
+            PooledBufferAllocator::SizeClassIndex(
+                PooledBufferAllocator::kMaxBlockSize + 1));
+  EXPECT_EQ(2048u, PooledBufferAllocator::SizeClassBlockSize(3));
+}
+
+TEST(PooledBufferAllocatorTest, ReuseFreedBuffers) {
+  base::test::TaskEnvironment task_environment;
+  PooledBufferAllocator allocator(base::ThreadTaskRunnerHandle::Get());
+  char* buffer = allocator.New(1000);
+  ASSERT_TRUE(buffer);
+  memset(buffer, 'a', 1000);
+  EXPECT_EQ(0u, allocator.pool_hits());
+  EXPECT_EQ(1u, allocator.pool_misses());
+  allocator.Delete(buffer);
+  EXPECT_EQ(1024u, allocator.cached_bytes());
+  // Any size in the same size class gets the cached buffer.
+  char* reused = allocator.New(600, true);
+  EXPECT_EQ(buffer, reused);
+  EXPECT_EQ(1u, allocator.pool_hits());
+  EXPECT_EQ(0u, allocator.cached_bytes());
+  // Another size class doesn't.
+  char* other = allocator.New(100);
+  EXPECT_NE(buffer, other);
+  EXPECT_EQ(2u, allocator.pool_misses());
+  allocator.Delete(reused);
+  allocator.Delete(other);
+  EXPECT_EQ(1024u + 256u, allocator.cached_bytes());
+}
+
+TEST(PooledBufferAllocatorTest, LargeBuffersAreNotCached) {
+  base::test::TaskEnvironment task_environment;
+  PooledBufferAllocator allocator(base::ThreadTaskRunnerHandle::Get());
+  const size_t size = PooledBufferAllocator::kMaxBlockSize + 1;
+  char* buffer = allocator.New(size);
+  ASSERT_TRUE(buffer);
+  memset(buffer, 'a', size);
+  allocator.Delete(buffer);
+  EXPECT_EQ(0u, allocator.cached_bytes());
+}
+
+TEST(PooledBufferAllocatorTest, CachedBytesAreBounded) {
+  base::test::TaskEnvironment task_environment;
+  PooledBufferAllocator allocator(base::ThreadTaskRunnerHandle::Get());
+  const size_t count = PooledBufferAllocator::kMaxCachedBytesPerSizeClass /
+                           PooledBufferAllocator::kMaxBlockSize +
+                       2;
+  std::vector<char*> buffers;
+  for (size_t i = 0; i < count; i++) {
+    buffers.push_back(allocator.New(PooledBufferAllocator::kMaxBlockSize));
+  }
+  for (char* buffer : buffers) {
+    allocator.Delete(buffer);
+  }
+  EXPECT_EQ(PooledBufferAllocator::kMaxCachedBytesPerSizeClass,
+            allocator.cached_bytes());
+}
+
+// Buffers allocated on other threads, e.g.: by WriteAsync, are cached when
+// they're deleted on the owner thread.
+TEST(PooledBufferAllocatorTest, CacheBuffersAllocatedOnOtherThreads) {
+  base::test::TaskEnvironment task_environment;
+  PooledBufferAllocator allocator(base::ThreadTaskRunnerHandle::Get());
+  base::Thread thread("pooled_buffer_allocator_test_thread");
+  ASSERT_TRUE(thread.Start());
+  char* buffer = nullptr;
+  base::WaitableEvent done;
+  thread.task_runner()->PostTask(
+      FROM_HERE, base::BindOnce(
+                     [](PooledBufferAllocator* allocator, char** buffer,
+                        base::WaitableEvent* done) {
+                       *buffer = allocator->New(3000);
+                       memset(*buffer, 'a', 3000);
+                       done->Signal();
+                     },
+                     base::Unretained(&allocator), base::Unretained(&buffer),
+                     base::Unretained(&done)));
+  done.Wait();
+  thread.Stop();
+  ASSERT_TRUE(buffer);
+  EXPECT_EQ(0u, allocator.pool_misses());
+  allocator.Delete(buffer);
+  EXPECT_EQ(4096u, allocator.cached_bytes());
+  EXPECT_EQ(buffer, allocator.New(4096));
+  EXPECT_EQ(1u, allocator.pool_hits());
+  allocator.Delete(buffer);
+}
+
+TEST(PooledBufferAllocatorTest, CarveBlocksOutOfSlabs) {
+  base::test::TaskEnvironment task_environment;
+  MemoryPlacement placement;
+  placement.huge_pages = true;
+  PooledBufferAllocator allocator(base::ThreadTaskRunnerHandle::Get(),
+                                  placement);
+  const size_t count = PooledBufferAllocator::kMaxCachedBytesPerSizeClass /
+                           PooledBufferAllocator::kMaxBlockSize +
+                       2;
+  std::vector<char*> buffers;
+  for (size_t i = 0; i < count; i++) {
+    buffers.push_back(allocator.New(PooledBufferAllocator::kMaxBlockSize));
+    memset(buffers.back(), 'a', PooledBufferAllocator::kMaxBlockSize);
+  }
+  EXPECT_EQ(PooledBufferAllocator::kSlabSize, allocator.slab_bytes());
+  // Slab blocks are cached beyond kMaxCachedBytesPerSizeClass.
+  for (char* buffer : buffers) {
+    allocator.Delete(buffer);
+  }
+  EXPECT_EQ(count * PooledBufferAllocator::kMaxBlockSize,
+            allocator.cached_bytes());
+  // Buffers larger than size classes still come from the heap.
+  allocator.Delete(allocator.New(PooledBufferAllocator::kMaxBlockSize + 1));
+  EXPECT_EQ(PooledBufferAllocator::kSlabSize, allocator.slab_bytes());
+}
+
+TEST(PooledBufferAllocatorTest, ReturnSlabBlocksDeletedOnOtherThreads) {
+  base::test::TaskEnvironment task_environment;
+  MemoryPlacement placement;
+  placement.huge_pages = true;
+  PooledBufferAllocator allocator(base::ThreadTaskRunnerHandle::Get(),
+                                  placement);
+  char* buffer = allocator.New(1000);
+  ASSERT_TRUE(buffer);
+  base::Thread thread("pooled_buffer_allocator_test_thread");
+  ASSERT_TRUE(thread.Start());
+  base::WaitableEvent done;
+  thread.task_runner()->PostTask(
+      FROM_HERE,
+      base::BindOnce(
+          [](PooledBufferAllocator* allocator, char* buffer,
+             base::WaitableEvent* done) {
+            allocator->Delete(buffer);
+            done->Signal();
+          },
+          base::Unretained(&allocator), buffer, base::Unretained(&done)));
+  done.Wait();
+  thread.Stop();
+  EXPECT_EQ(0u, allocator.cached_bytes());
+  EXPECT_EQ(buffer, allocator.New(1024));
+  EXPECT_EQ(1u, allocator.pool_hits());
+  allocator.Delete(buffer);
+}
+
+}  // namespace test
+}  // namespace quic
+}  // namespace owt
@@ -0,0 +1,54 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "impl/process_runtime.h"
+#include "base/command_line.h"
+#include "base/task/thread_pool/thread_pool_instance.h"
+#include "owt/quic/logging.h"
+
+namespace owt {
+namespace quic {
+
+// static
+ProcessRuntime* ProcessRuntime::GetInstance() {
+  static base::NoDestructor<ProcessRuntime> instance;
+  return instance.get();
+}
+
+ProcessRuntime::ProcessRuntime()
+    : initialized_(false), thread_pool_checked_(false) {}
+
+ProcessRuntime::~ProcessRuntime() = default;
+
+void ProcessRuntime::EnsureInitialized() {
+  base::AutoLock lock(lock_);
+  if (initialized_) {
+    return;
+  }
+  initialized_ = true;
+  if (base::CommandLine::InitializedForCurrentProcess()) {
+    // Logging is initialised by whoever initialised the command line.
+    return;
+  }
+  base::CommandLine::Init(0, nullptr);
+  Logging::InitLogging();
+}
+
+void ProcessRuntime::EnsureThreadPoolStarted() {
+  base::AutoLock lock(lock_);
+  if (thread_pool_checked_) {
+    return;
+  }
+  thread_pool_checked_ = true;
+  if (base::ThreadPoolInstance::Get()) {
+    return;
+  }
+  base::ThreadPoolInstance::CreateAndStartWithDefaultParams(
+      "web_transport_thread_pool");
+}
+
+}  // namespace quic
+}  // namespace owt
@@ -0,0 +1,35 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "owt/web_transport/sdk/impl/process_runtime.h"
+#include "base/command_line.h"
+#include "base/task/thread_pool/thread_pool_instance.h"
+#include "base/test/task_environment.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace owt {
+namespace quic {
+namespace test {
+
+TEST(ProcessRuntimeTest, KeepsCommandLineInitializedByEmbedder) {
+  ASSERT_TRUE(base::CommandLine::InitializedForCurrentProcess());
+  base::CommandLine* command_line = base::CommandLine::ForCurrentProcess();
+  ProcessRuntime::GetInstance()->EnsureInitialized();
+  ProcessRuntime::GetInstance()->EnsureInitialized();
+  EXPECT_EQ(command_line, base::CommandLine::ForCurrentProcess());
+}
+
+TEST(ProcessRuntimeTest, KeepsThreadPoolStartedByEmbedder) {
+  base::test::TaskEnvironment task_environment;
+  base::ThreadPoolInstance* thread_pool = base::ThreadPoolInstance::Get();
+  ASSERT_TRUE(thread_pool);
+  ProcessRuntime::GetInstance()->EnsureThreadPoolStarted();
+  EXPECT_EQ(thread_pool, base::ThreadPoolInstance::Get());
+}
+
+}  // namespace test
+}  // namespace quic
+}  // namespace owt
@@ -24,17 +24,53 @@
 namespace owt {
 namespace quic {
 
+namespace {
+// Max number of TLS handshakes between GetCertChain and ComputeTlsSignature.
+const size_t kMaxHandshakeIdentities = 1024;
+
+std::string HandshakeKey(const ::quic::QuicSocketAddress& server_address,
+                         const ::quic::QuicSocketAddress& client_address) {
+  return server_address.ToString() + "-" + client_address.ToString();
+}
+}  // namespace
+
+ProofSourceOwt::Identity::Identity() = default;
+
+ProofSourceOwt::Identity::~Identity() = default;
+
 ProofSourceOwt::ProofSourceOwt()
-    : private_key_(nullptr), ticket_crypter_(nullptr) {}
+    : handshake_identities_(kMaxHandshakeIdentities),
+      ticket_crypter_(nullptr) {}
 
 ProofSourceOwt::~ProofSourceOwt() {}
 
+std::shared_ptr<const ProofSourceOwt::Identity> ProofSourceOwt::GetIdentity()
+    const {
+  base::AutoLock lock(lock_);
+  return identity_;
+}
+
+std::shared_ptr<const ProofSourceOwt::Identity>
+ProofSourceOwt::TakeHandshakeIdentity(
+    const ::quic::QuicSocketAddress& server_address,
+    const ::quic::QuicSocketAddress& client_address) {
+  base::AutoLock lock(lock_);
+  auto it =
+      handshake_identities_.Peek(HandshakeKey(server_address, client_address));
+  if (it == handshake_identities_.end()) {
+    return identity_;
+  }
+  std::shared_ptr<const Identity> identity = std::move(it->second);
+  handshake_identities_.Erase(it);
+  return identity;
+}
+
 bool ProofSourceOwt::Initialize(const base::FilePath& pfx_path,
                                 const std::string& password) {
   crypto::EnsureOpenSSLInit();
   std::string pfx_data;
   if (!base::ReadFileToString(pfx_path, &pfx_data)) {
-    DLOG(FATAL) << "Unable to read pfx file.";
+    LOG(ERROR) << "Unable to read pfx file.";
     return false;
   }
 
@@ -47,6 +83,8 @@ bool ProofSourceOwt::Initialize(const base::FilePath& pfx_path,
       0) {
     return false;
   }
+  bssl::UniquePtr<EVP_PKEY> private_key(key);
+  auto identity = std::make_shared<Identity>();
   std::vector<std::string> certs_string;
   for (X509* cert : certs.get()) {
     int len(0);
@@ -59,22 +97,24 @@ bool ProofSourceOwt::Initialize(const base::FilePath& pfx_path,
     auto cert_list = net::X509Certificate::CreateCertificateListFromBytes(
         base::as_bytes(base::span<unsigned char>(buffer, len)),
         net::X509Certificate::FORMAT_AUTO);
-    certs_in_file_.insert(certs_in_file_.end(), cert_list.begin(),
-                          cert_list.end());
+    identity->certs_in_file.insert(identity->certs_in_file.end(),
+                                   cert_list.begin(), cert_list.end());
     bssl::UniquePtr<CRYPTO_BUFFER> crypto_buffer =
         net::x509_util::CreateCryptoBuffer(buffer, len);
     certs_string.emplace_back(
         net::x509_util::CryptoBufferAsStringPiece(crypto_buffer.get()));
   }
 
-  if (certs_in_file_.empty()) {
-    DLOG(FATAL) << "No certificates.";
+  if (identity->certs_in_file.empty()) {
+    LOG(ERROR) << "No certificates.";
     return false;
   }
 
-  chain_ = new ::quic::ProofSource::Chain(certs_string);
-  private_key_ = std::make_unique<::quic::CertificatePrivateKey>(
-      bssl::UniquePtr<EVP_PKEY>(key));
+  identity->chain = new ::quic::ProofSource::Chain(certs_string);
+  identity->private_key =
+      std::make_unique<::quic::CertificatePrivateKey>(std::move(private_key));
+  base::AutoLock lock(lock_);
+  identity_ = std::move(identity);
   return true;
 }
 
@@ -104,7 +144,11 @@ bool ProofSourceOwt::GetProofInner(
   // This function is copied from `ProofSourceChromium`, but `leaf_cert_scts` is
   // not set.
   DCHECK(proof);
-  DCHECK(private_key_);
+  std::shared_ptr<const Identity> identity = GetIdentity();
+  if (!identity) {
+    return false;
+  }
+  EVP_PKEY* private_key = identity->private_key->private_key();
 
   crypto::OpenSSLErrStackTracer err_tracer(FROM_HERE);
   bssl::ScopedEVP_MD_CTX sign_context;
@@ -112,8 +156,8 @@ bool ProofSourceOwt::GetProofInner(
 
   uint32_t len_tmp = chlo_hash.length();
   if (!EVP_DigestSignInit(sign_context.get(), &pkey_ctx, EVP_sha256(), nullptr,
-                          private_key_->private_key()) ||
-      (EVP_PKEY_id(private_key_->private_key()) == EVP_PKEY_RSA &&
+                          private_key) ||
+      (EVP_PKEY_id(private_key) == EVP_PKEY_RSA &&
        (!EVP_PKEY_CTX_set_rsa_padding(pkey_ctx, RSA_PKCS1_PSS_PADDING) ||
         !EVP_PKEY_CTX_set_rsa_pss_saltlen(pkey_ctx, -1))) ||
       !EVP_DigestSignUpdate(
@@ -145,7 +189,7 @@ bool ProofSourceOwt::GetProofInner(
   signature.resize(len);
   proof->signature.assign(reinterpret_cast<const char*>(signature.data()),
                           signature.size());
-  *out_chain = chain_;
+  *out_chain = identity->chain;
   VLOG(1) << "signature: "
           << base::HexEncode(proof->signature.data(), proof->signature.size());
   return true;
@@ -176,15 +220,26 @@ ProofSourceOwt::GetCertChain(const ::quic::QuicSocketAddress& server_address,
                              const std::string& hostname,
                              bool* cert_matched_sni) {
   *cert_matched_sni = false;
+  std::shared_ptr<const Identity> identity;
+  {
+    base::AutoLock lock(lock_);
+    identity = identity_;
+    if (!identity) {
+      return nullptr;
+    }
+    handshake_identities_.Put(HandshakeKey(server_address, client_address),
+                              identity);
+  }
   if (!hostname.empty()) {
-    for (const scoped_refptr<net::X509Certificate>& cert : certs_in_file_) {
+    for (const scoped_refptr<net::X509Certificate>& cert :
+         identity->certs_in_file) {
       if (cert->VerifyNameMatch(hostname)) {
         *cert_matched_sni = true;
         break;
       }
     }
   }
-  return chain_;
+  return identity->chain;
 }
 
 void ProofSourceOwt::ComputeTlsSignature(
@@ -200,9 +255,16 @@ void ProofSourceOwt::ComputeTlsSignature(
 
   size_t siglen;
   std::string sig;
+  std::shared_ptr<const Identity> identity =
+      TakeHandshakeIdentity(server_address, client_address);
+  if (!identity) {
+    callback->Run(false, sig, nullptr);
+    return;
+  }
+  EVP_PKEY* private_key = identity->private_key->private_key();
   if (!EVP_DigestSignInit(sign_context.get(), &pkey_ctx, EVP_sha256(), nullptr,
-                          private_key_->private_key()) ||
-      (EVP_PKEY_id(private_key_->private_key()) == EVP_PKEY_RSA &&
+                          private_key) ||
+      (EVP_PKEY_id(private_key) == EVP_PKEY_RSA &&
        (!EVP_PKEY_CTX_set_rsa_padding(pkey_ctx, RSA_PKCS1_PSS_PADDING) ||
         !EVP_PKEY_CTX_set_rsa_pss_saltlen(pkey_ctx, -1))) ||
       !EVP_DigestSignUpdate(sign_context.get(),
@@ -14,7 +14,12 @@
 #ifndef OWT_WEB_TRANSPORT_PROOF_SOURCE_OWT_H_
 #define OWT_WEB_TRANSPORT_PROOF_SOURCE_OWT_H_
 
+#include <memory>
+#include <string>
+#include "base/containers/mru_cache.h"
 #include "base/files/file_path.h"
+#include "base/synchronization/lock.h"
+#include "base/thread_annotations.h"
 #include "crypto/rsa_private_key.h"
 #include "net/cert/x509_certificate.h"
 #include "net/third_party/quiche/src/quic/core/crypto/proof_source.h"
@@ -23,13 +28,16 @@ namespace owt {
 namespace quic {
 
 // ProofSourceOwt could be initialized with a PKCS12 file. OWT conference server
-// stores certificate and key in this format.
+// stores certificate and key in this format. Thread safe.
 class ProofSourceOwt : public ::quic::ProofSource {
  public:
   ProofSourceOwt();
   ~ProofSourceOwt() override;
   ProofSourceOwt& operator=(ProofSourceOwt&) = delete;
-  // Initializes this object based on a pfx file.
+  // Initializes this object based on a pfx file. It could be called again to
+  // replace the certificate and key, e.g. when the certificate is renewed.
+  // Handshakes started after that use the new certificate. If the file cannot
+  // be loaded, it returns false and the current certificate is kept.
   bool Initialize(const base::FilePath& pfx_path, const std::string& password);
 
   // Overrides quic::ProofSource.
@@ -62,6 +70,24 @@ class ProofSourceOwt : public ::quic::ProofSource {
   void SetTicketCrypter(std::unique_ptr<TicketCrypter> ticket_crypter);
 
  private:
+  // A certificate chain and its private key, replaced as a whole.
+  struct Identity {
+    Identity();
+    ~Identity();
+    std::unique_ptr<::quic::CertificatePrivateKey> private_key;
+    std::vector<scoped_refptr<net::X509Certificate>> certs_in_file;
+    ::quic::QuicReferenceCountedPointer<::quic::ProofSource::Chain> chain;
+  };
+
+  // Returns nullptr if it's not initialized.
+  std::shared_ptr<const Identity> GetIdentity() const;
+  // Returns the identity whose chain GetCertChain returned to the handshake
+  // between `server_address` and `client_address`, or the current identity if
+  // there is none.
+  std::shared_ptr<const Identity> TakeHandshakeIdentity(
+      const ::quic::QuicSocketAddress& server_address,
+      const ::quic::QuicSocketAddress& client_address);
+
   bool GetProofInner(
       const ::quic::QuicSocketAddress& server_ip,
       const std::string& hostname,
@@ -72,9 +98,17 @@ class ProofSourceOwt : public ::quic::ProofSource {
           out_chain,
       ::quic::QuicCryptoProof* proof);
 
-  std::unique_ptr<::quic::CertificatePrivateKey> private_key_;
-  std::vector<scoped_refptr<net::X509Certificate>> certs_in_file_;
-  ::quic::QuicReferenceCountedPointer<::quic::ProofSource::Chain> chain_;
+  mutable base::Lock lock_;
+  // Operations in progress hold a reference, so they're not affected by
+  // reloading.
+  std::shared_ptr<const Identity> identity_ GUARDED_BY(lock_);
+  // TLS handshakes get the certificate chain and the signature by separate
+  // calls, so a handshake signs with the key of the chain it sent even if the
+  // identity is reloaded in between. Keyed by the handshake's addresses.
+  // Handshakes which never sign, e.g. resumed ones, are evicted when it's
+  // full.
+  base::MRUCache<std::string, std::shared_ptr<const Identity>>
+      handshake_identities_ GUARDED_BY(lock_);
   std::unique_ptr<::quic::ProofSource::TicketCrypter> ticket_crypter_;
 };
 
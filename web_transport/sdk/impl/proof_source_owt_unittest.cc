@@ -5,8 +5,11 @@
  */
 
 #include "owt/web_transport/sdk/impl/proof_source_owt.h"
+#include <memory>
+#include <string>
 #include "base/files/file_path.h"
 #include "base/path_service.h"
+#include "third_party/boringssl/src/include/openssl/ssl.h"
 #include "testing/gtest/include/gtest/gtest.h"
 
 namespace owt {
@@ -16,6 +19,24 @@ namespace test {
 const base::FilePath::CharType kCertificatePath[] =
     FILE_PATH_LITERAL("owt/web_transport/sdk/resources/ssl/certificates");
 
+namespace {
+class TestSignatureCallback : public ::quic::ProofSource::SignatureCallback {
+ public:
+  TestSignatureCallback(bool* ok, std::string* signature)
+      : ok_(ok), signature_(signature) {}
+  void Run(bool ok,
+           std::string signature,
+           std::unique_ptr<::quic::ProofSource::Details> details) override {
+    *ok_ = ok;
+    *signature_ = std::move(signature);
+  }
+
+ private:
+  bool* ok_;
+  std::string* signature_;
+};
+}  // namespace
+
 TEST(ProofSourceOwtTest, InitializeProofSourceWithValidPassword) {
   owt::quic::ProofSourceOwt proof_source;
   base::FilePath src_root;
@@ -26,6 +47,59 @@ TEST(ProofSourceOwtTest, InitializeProofSourceWithValidPassword) {
   EXPECT_FALSE(proof_source.Initialize(pfx_path, "wrong_password"));
 }
 
+TEST(ProofSourceOwtTest, ReloadKeepsCertificateOnFailure) {
+  owt::quic::ProofSourceOwt proof_source;
+  base::FilePath src_root;
+  base::PathService::Get(base::DIR_SOURCE_ROOT, &src_root);
+  base::FilePath pfx_path(src_root.Append(kCertificatePath)
+                              .AppendASCII("proof_source_pkcs12_test.pfx"));
+  ::quic::QuicSocketAddress address;
+  bool cert_matched_sni = false;
+  EXPECT_FALSE(
+      proof_source.GetCertChain(address, address, "", &cert_matched_sni));
+  ASSERT_TRUE(proof_source.Initialize(pfx_path, "password"));
+  auto chain =
+      proof_source.GetCertChain(address, address, "", &cert_matched_sni);
+  ASSERT_TRUE(chain);
+  EXPECT_FALSE(proof_source.Initialize(pfx_path, "wrong_password"));
+  EXPECT_EQ(proof_source.GetCertChain(address, address, "", &cert_matched_sni),
+            chain);
+  ASSERT_TRUE(proof_source.Initialize(pfx_path, "password"));
+  EXPECT_NE(proof_source.GetCertChain(address, address, "", &cert_matched_sni),
+            chain);
+}
+
+TEST(ProofSourceOwtTest, SignsHandshakeAfterReload) {
+  owt::quic::ProofSourceOwt proof_source;
+  base::FilePath src_root;
+  base::PathService::Get(base::DIR_SOURCE_ROOT, &src_root);
+  base::FilePath pfx_path(src_root.Append(kCertificatePath)
+                              .AppendASCII("proof_source_pkcs12_test.pfx"));
+  ASSERT_TRUE(proof_source.Initialize(pfx_path, "password"));
+  const ::quic::QuicSocketAddress server_address(
+      ::quic::QuicIpAddress::Loopback4(), 443);
+  const ::quic::QuicSocketAddress client_address(
+      ::quic::QuicIpAddress::Loopback4(), 50000);
+  bool cert_matched_sni = false;
+  ASSERT_TRUE(proof_source.GetCertChain(server_address, client_address, "",
+                                        &cert_matched_sni));
+  // The handshake signs with the identity whose chain it got.
+  ASSERT_TRUE(proof_source.Initialize(pfx_path, "password"));
+  bool ok = false;
+  std::string signature;
+  proof_source.ComputeTlsSignature(
+      server_address, client_address, "", SSL_SIGN_RSA_PSS_RSAE_SHA256,
+      "data", std::make_unique<TestSignatureCallback>(&ok, &signature));
+  EXPECT_TRUE(ok);
+  EXPECT_FALSE(signature.empty());
+  // Handshakes without a chain, e.g. resumed ones, use the current identity.
+  ok = false;
+  proof_source.ComputeTlsSignature(
+      server_address, client_address, "", SSL_SIGN_RSA_PSS_RSAE_SHA256,
+      "data", std::make_unique<TestSignatureCallback>(&ok, &signature));
+  EXPECT_TRUE(ok);
+}
+
 }  // namespace test
 }  // namespace quic
 }  // namespace owt
\ No newline at end of file
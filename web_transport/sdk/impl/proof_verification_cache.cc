@@ -0,0 +1,162 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "impl/proof_verification_cache.h"
+#include "base/check.h"
+#include "crypto/sha2.h"
+
+namespace owt {
+namespace quic {
+
+namespace {
+constexpr size_t kDefaultMaxEntries = 256;
+constexpr base::TimeDelta kDefaultTtl = base::Minutes(5);
+
+// Adds a verified chain to the cache before running the callback of the
+// handshake.
+class CachingProofVerifierCallback : public ::quic::ProofVerifierCallback {
+ public:
+  CachingProofVerifierCallback(
+      std::unique_ptr<::quic::ProofVerifierCallback> callback,
+      std::string key,
+      ProofVerificationCache* cache)
+      : callback_(std::move(callback)), key_(std::move(key)), cache_(cache) {}
+  ~CachingProofVerifierCallback() override = default;
+
+  void Run(bool ok,
+           const std::string& error_details,
+           std::unique_ptr<::quic::ProofVerifyDetails>* details) override {
+    if (ok) {
+      cache_->Insert(key_, base::TimeTicks::Now());
+    }
+    callback_->Run(ok, error_details, details);
+  }
+
+ private:
+  std::unique_ptr<::quic::ProofVerifierCallback> callback_;
+  const std::string key_;
+  ProofVerificationCache* cache_;
+};
+
+// Appends `value` with its length, so fields can't run into each other.
+void AppendField(const std::string& value, std::string* out) {
+  const uint64_t length = value.size();
+  out->append(reinterpret_cast<const char*>(&length), sizeof(length));
+  out->append(value);
+}
+}  // namespace
+
+ProofVerificationCache::ProofVerificationCache(size_t max_entries,
+                                               base::TimeDelta ttl)
+    : max_entries_(max_entries > 0 ? max_entries : kDefaultMaxEntries),
+      ttl_(ttl.is_positive() ? ttl : kDefaultTtl) {}
+
+ProofVerificationCache::~ProofVerificationCache() = default;
+
+// static
+std::string ProofVerificationCache::Key(const std::string& scope,
+                                        const std::string& hostname,
+                                        uint16_t port,
+                                        const std::vector<std::string>& certs,
+                                        const std::string& ocsp_response,
+                                        const std::string& cert_sct) {
+  std::string input;
+  AppendField(scope, &input);
+  AppendField(hostname, &input);
+  input.append(reinterpret_cast<const char*>(&port), sizeof(port));
+  for (const std::string& cert : certs) {
+    AppendField(cert, &input);
+  }
+  AppendField(ocsp_response, &input);
+  AppendField(cert_sct, &input);
+  return crypto::SHA256HashString(input);
+}
+
+bool ProofVerificationCache::Lookup(const std::string& key,
+                                    base::TimeTicks now) {
+  base::AutoLock lock(lock_);
+  auto it = entries_.find(key);
+  // An expired entry is kept until it's evicted or verified again.
+  return it != entries_.end() && now < it->second;
+}
+
+void ProofVerificationCache::Insert(const std::string& key,
+                                    base::TimeTicks now) {
+  base::AutoLock lock(lock_);
+  if (!entries_.insert_or_assign(key, now + ttl_).second) {
+    // Refreshed, it keeps its place in `insertion_order_`.
+    return;
+  }
+  insertion_order_.push_back(key);
+  if (insertion_order_.size() > max_entries_) {
+    entries_.erase(insertion_order_.front());
+    insertion_order_.pop_front();
+  }
+}
+
+CachingProofVerifier::CachingProofVerifier(
+    std::unique_ptr<::quic::ProofVerifier> verifier,
+    std::string scope,
+    ProofVerificationCache* cache)
+    : verifier_(std::move(verifier)), scope_(std::move(scope)), cache_(cache) {
+  DCHECK(verifier_);
+  DCHECK(cache_);
+}
+
+CachingProofVerifier::~CachingProofVerifier() = default;
+
+::quic::QuicAsyncStatus CachingProofVerifier::VerifyProof(
+    const std::string& hostname,
+    const uint16_t port,
+    const std::string& server_config,
+    ::quic::QuicTransportVersion quic_version,
+    absl::string_view chlo_hash,
+    const std::vector<std::string>& certs,
+    const std::string& cert_sct,
+    const std::string& signature,
+    const ::quic::ProofVerifyContext* context,
+    std::string* error_details,
+    std::unique_ptr<::quic::ProofVerifyDetails>* details,
+    std::unique_ptr<::quic::ProofVerifierCallback> callback) {
+  return verifier_->VerifyProof(hostname, port, server_config, quic_version,
+                                chlo_hash, certs, cert_sct, signature, context,
+                                error_details, details, std::move(callback));
+}
+
+::quic::QuicAsyncStatus CachingProofVerifier::VerifyCertChain(
+    const std::string& hostname,
+    const uint16_t port,
+    const std::vector<std::string>& certs,
+    const std::string& ocsp_response,
+    const std::string& cert_sct,
+    const ::quic::ProofVerifyContext* context,
+    std::string* error_details,
+    std::unique_ptr<::quic::ProofVerifyDetails>* details,
+    uint8_t* out_alert,
+    std::unique_ptr<::quic::ProofVerifierCallback> callback) {
+  std::string key = ProofVerificationCache::Key(scope_, hostname, port, certs,
+                                                ocsp_response, cert_sct);
+  if (cache_->Lookup(key, base::TimeTicks::Now())) {
+    return ::quic::QUIC_SUCCESS;
+  }
+  auto caching_callback = std::make_unique<CachingProofVerifierCallback>(
+      std::move(callback), key, cache_);
+  ::quic::QuicAsyncStatus status = verifier_->VerifyCertChain(
+      hostname, port, certs, ocsp_response, cert_sct, context, error_details,
+      details, out_alert, std::move(caching_callback));
+  if (status == ::quic::QUIC_SUCCESS) {
+    cache_->Insert(key, base::TimeTicks::Now());
+  }
+  return status;
+}
+
+std::unique_ptr<::quic::ProofVerifyContext>
+CachingProofVerifier::CreateDefaultContext() {
+  return verifier_->CreateDefaultContext();
+}
+
+}  // namespace quic
+}  // namespace owt
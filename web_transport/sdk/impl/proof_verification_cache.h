@@ -0,0 +1,116 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef OWT_WEB_TRANSPORT_PROOF_VERIFICATION_CACHE_H_
+#define OWT_WEB_TRANSPORT_PROOF_VERIFICATION_CACHE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+#include "base/synchronization/lock.h"
+#include "base/thread_annotations.h"
+#include "base/time/time.h"
+#include "net/third_party/quiche/src/quic/core/crypto/proof_verifier.h"
+#include "third_party/abseil-cpp/absl/container/flat_hash_map.h"
+
+namespace owt {
+namespace quic {
+
+// Caches successful verifications of server certificate chains, so clients
+// reconnecting to the same server, e.g.: a relay reconnecting hundreds of
+// sessions, don't verify the same chain again and again. Entries expire after
+// a TTL. Thread safe, it could be shared by clients on multiple IO threads.
+class ProofVerificationCache {
+ public:
+  // At most `max_entries` verifications are cached, each for `ttl`. 0 and
+  // zero TTL mean default values.
+  ProofVerificationCache(size_t max_entries, base::TimeDelta ttl);
+  ~ProofVerificationCache();
+  ProofVerificationCache(const ProofVerificationCache&) = delete;
+  ProofVerificationCache& operator=(const ProofVerificationCache&) = delete;
+
+  size_t max_entries() const { return max_entries_; }
+  base::TimeDelta ttl() const { return ttl_; }
+
+  // Returns a key of a chain verified for `hostname` and `port`. `scope`
+  // identifies the verifier's configuration, results of verifiers accepting
+  // different certificates must not share keys.
+  static std::string Key(const std::string& scope,
+                         const std::string& hostname,
+                         uint16_t port,
+                         const std::vector<std::string>& certs,
+                         const std::string& ocsp_response,
+                         const std::string& cert_sct);
+
+  // Returns true if `key` is verified and not expired at `now`.
+  bool Lookup(const std::string& key, base::TimeTicks now);
+  void Insert(const std::string& key, base::TimeTicks now);
+
+ private:
+  const size_t max_entries_;
+  const base::TimeDelta ttl_;
+  base::Lock lock_;
+  // Expiration time of each key.
+  absl::flat_hash_map<std::string, base::TimeTicks> entries_ GUARDED_BY(lock_);
+  // Keys of `entries_`, oldest first.
+  std::deque<std::string> insertion_order_ GUARDED_BY(lock_);
+};
+
+// Wraps a ProofVerifier, and skips verifications of certificate chains cached
+// by a ProofVerificationCache. Chains verified by the wrapped verifier are
+// added to the cache. No ProofVerifyDetails is returned for cached chains.
+// Proofs of QUIC crypto are always verified by the wrapped verifier.
+class CachingProofVerifier : public ::quic::ProofVerifier {
+ public:
+  // `cache` must outlive this object. See ProofVerificationCache::Key for
+  // `scope`.
+  CachingProofVerifier(std::unique_ptr<::quic::ProofVerifier> verifier,
+                       std::string scope,
+                       ProofVerificationCache* cache);
+  ~CachingProofVerifier() override;
+  CachingProofVerifier(const CachingProofVerifier&) = delete;
+  CachingProofVerifier& operator=(const CachingProofVerifier&) = delete;
+
+  // Overrides ::quic::ProofVerifier.
+  ::quic::QuicAsyncStatus VerifyProof(
+      const std::string& hostname,
+      const uint16_t port,
+      const std::string& server_config,
+      ::quic::QuicTransportVersion quic_version,
+      absl::string_view chlo_hash,
+      const std::vector<std::string>& certs,
+      const std::string& cert_sct,
+      const std::string& signature,
+      const ::quic::ProofVerifyContext* context,
+      std::string* error_details,
+      std::unique_ptr<::quic::ProofVerifyDetails>* details,
+      std::unique_ptr<::quic::ProofVerifierCallback> callback) override;
+  ::quic::QuicAsyncStatus VerifyCertChain(
+      const std::string& hostname,
+      const uint16_t port,
+      const std::vector<std::string>& certs,
+      const std::string& ocsp_response,
+      const std::string& cert_sct,
+      const ::quic::ProofVerifyContext* context,
+      std::string* error_details,
+      std::unique_ptr<::quic::ProofVerifyDetails>* details,
+      uint8_t* out_alert,
+      std::unique_ptr<::quic::ProofVerifierCallback> callback) override;
+  std::unique_ptr<::quic::ProofVerifyContext> CreateDefaultContext() override;
+
+ private:
+  std::unique_ptr<::quic::ProofVerifier> verifier_;
+  const std::string scope_;
+  ProofVerificationCache* cache_;  // Not owned.
+};
+
+}  // namespace quic
+}  // namespace owt
+
+#endif
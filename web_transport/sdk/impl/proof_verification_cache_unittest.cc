@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "owt/web_transport/sdk/impl/proof_verification_cache.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace owt {
+namespace quic {
+namespace test {
+
+namespace {
+const std::vector<std::string> kChain = {"leaf", "intermediate"};
+
+std::string ChainKey(const std::string& scope,
+                     const std::string& hostname,
+                     const std::vector<std::string>& certs) {
+  return ProofVerificationCache::Key(scope, hostname, 443, certs, "", "");
+}
+}  // namespace
+
+TEST(ProofVerificationCacheTest, LooksUpInsertedChain) {
+  ProofVerificationCache cache(0, base::TimeDelta());
+  const base::TimeTicks now = base::TimeTicks::Now();
+  const std::string key = ChainKey("ca", "example.com", kChain);
+  EXPECT_FALSE(cache.Lookup(key, now));
+  cache.Insert(key, now);
+  EXPECT_TRUE(cache.Lookup(key, now));
+}
+
+TEST(ProofVerificationCacheTest, KeysDifferByScopeHostAndChain) {
+  const std::string key = ChainKey("ca", "example.com", kChain);
+  EXPECT_NE(key, ChainKey("fingerprints", "example.com", kChain));
+  EXPECT_NE(key, ChainKey("ca", "example.org", kChain));
+  EXPECT_NE(key, ChainKey("ca", "example.com", {"leaf"}));
+  EXPECT_NE(key, ProofVerificationCache::Key("ca", "example.com", 4433, kChain,
+                                             "", ""));
+  // Fields are length prefixed.
+  EXPECT_NE(ChainKey("ca", "example.com", {"ab", "c"}),
+            ChainKey("ca", "example.com", {"a", "bc"}));
+}
+
+TEST(ProofVerificationCacheTest, EntriesExpire) {
+  ProofVerificationCache cache(0, base::Seconds(10));
+  const base::TimeTicks now = base::TimeTicks::Now();
+  const std::string key = ChainKey("ca", "example.com", kChain);
+  cache.Insert(key, now);
+  EXPECT_TRUE(cache.Lookup(key, now + base::Seconds(9)));
+  EXPECT_FALSE(cache.Lookup(key, now + base::Seconds(10)));
+  // Verified again.
+  cache.Insert(key, now + base::Seconds(10));
+  EXPECT_TRUE(cache.Lookup(key, now + base::Seconds(19)));
+}
+
+TEST(ProofVerificationCacheTest, EvictsOldestEntries) {
+  ProofVerificationCache cache(2, base::TimeDelta());
+  const base::TimeTicks now = base::TimeTicks::Now();
+  const std::string key1 = ChainKey("ca", "1.example.com", kChain);
+  const std::string key2 = ChainKey("ca", "2.example.com", kChain);
+  const std::string key3 = ChainKey("ca", "3.example.com", kChain);
+  cache.Insert(key1, now);
+  cache.Insert(key2, now);
+  cache.Insert(key1, now);
+  cache.Insert(key3, now);
+  EXPECT_FALSE(cache.Lookup(key1, now));
+  EXPECT_TRUE(cache.Lookup(key2, now));
+  EXPECT_TRUE(cache.Lookup(key3, now));
+}
+
+}  // namespace test
+}  // namespace quic
+}  // namespace owt
@@ -0,0 +1,112 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "owt/web_transport/sdk/impl/qlog_writer.h"
+#include <string>
+#include "base/files/file_util.h"
+#include "base/files/scoped_temp_dir.h"
+#include "net/third_party/quiche/src/quic/test_tools/quic_test_utils.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace owt {
+namespace quic {
+namespace test {
+
+namespace {
+bool MatchConnectionId(const char* /*peer_address*/,
+                       const char* connection_id,
+                       void* context) {
+  return std::string(connection_id) ==
+         *reinterpret_cast<std::string*>(context);
+}
+}  // namespace
+
+class QlogWriterTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    ASSERT_TRUE(temp_dir_.CreateUniqueTempDir());
+    directory_ = temp_dir_.GetPath().AppendASCII("qlog").AsUTF8Unsafe();
+    options_.directory = directory_.c_str();
+    options_.sampling_rate = 0;
+    options_.filter = nullptr;
+    options_.filter_context = nullptr;
+  }
+
+  base::ScopedTempDir temp_dir_;
+  std::string directory_;
+  QlogOptions options_;
+};
+
+TEST_F(QlogWriterTest, RejectsInvalidOptions) {
+  QlogOptions options = options_;
+  options.directory = nullptr;
+  EXPECT_EQ(QlogWriter::Create(options), nullptr);
+  options = options_;
+  options.sampling_rate = 1.5;
+  EXPECT_EQ(QlogWriter::Create(options), nullptr);
+  options.sampling_rate = -0.1;
+  EXPECT_EQ(QlogWriter::Create(options), nullptr);
+}
+
+TEST_F(QlogWriterTest, CreatesDirectory) {
+  auto writer = QlogWriter::Create(options_);
+  ASSERT_NE(writer, nullptr);
+  EXPECT_TRUE(base::DirectoryExists(writer->directory()));
+}
+
+TEST_F(QlogWriterTest, SamplesConnections) {
+  auto writer = QlogWriter::Create(options_);
+  ASSERT_NE(writer, nullptr);
+  EXPECT_FALSE(writer->ShouldLog("127.0.0.1:1234", "0102030405060708"));
+  options_.sampling_rate = 1;
+  writer = QlogWriter::Create(options_);
+  ASSERT_NE(writer, nullptr);
+  EXPECT_TRUE(writer->ShouldLog("127.0.0.1:1234", "0102030405060708"));
+}
+
+TEST_F(QlogWriterTest, FilterSelectsConnections) {
+  std::string logged_connection_id = "0102030405060708";
+  options_.filter = &MatchConnectionId;
+  options_.filter_context = &logged_connection_id;
+  auto writer = QlogWriter::Create(options_);
+  ASSERT_NE(writer, nullptr);
+  EXPECT_TRUE(writer->ShouldLog("127.0.0.1:1234", "0102030405060708"));
+  EXPECT_FALSE(writer->ShouldLog("127.0.0.1:1234", "0807060504030201"));
+}
+
+TEST_F(QlogWriterTest, WritesEventsOfLoggedConnection) {
+  options_.sampling_rate = 1;
+  auto writer = QlogWriter::Create(options_);
+  ASSERT_NE(writer, nullptr);
+  ::quic::test::MockQuicConnectionHelper helper;
+  ::quic::test::MockAlarmFactory alarm_factory;
+  auto* connection = new ::quic::test::MockQuicConnection(
+      &helper, &alarm_factory, ::quic::Perspective::IS_SERVER);
+  std::unique_ptr<QlogConnectionLogger> logger =
+      writer->MaybeCreateLogger(connection);
+  ASSERT_NE(logger, nullptr);
+  logger->OnPacketLoss(::quic::QuicPacketNumber(3),
+                       ::quic::ENCRYPTION_FORWARD_SECURE,
+                       ::quic::NOT_RETRANSMISSION, helper.GetClock()->Now());
+  const base::FilePath path = writer->directory().AppendASCII(
+      connection->connection_id().ToString() + ".sqlog");
+  logger.reset();
+  delete connection;
+  // Pending writes are done when the writer is destroyed.
+  writer.reset();
+
+  std::string qlog;
+  ASSERT_TRUE(base::ReadFileToString(path, &qlog));
+  ASSERT_FALSE(qlog.empty());
+  EXPECT_EQ(qlog[0], '\x1e');
+  EXPECT_NE(qlog.find("\"qlog_format\":\"JSON-SEQ\""), std::string::npos);
+  EXPECT_NE(qlog.find("\"name\":\"recovery:packet_lost\""), std::string::npos);
+  EXPECT_NE(qlog.find("\"packet_number\":3"), std::string::npos);
+}
+
+}  // namespace test
+}  // namespace quic
+}  // namespace owt
@@ -0,0 +1,75 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "impl/read_budget_scheduler.h"
+#include <algorithm>
+#include "base/check_op.h"
+
+namespace owt {
+namespace quic {
+
+namespace {
+// Budgets grow by 1/kIncreaseDivisor of their max after a healthy pass.
+constexpr size_t kIncreaseDivisor = 8;
+
+size_t Increase(size_t budget, size_t max_budget) {
+  return std::min(max_budget,
+                  budget + std::max<size_t>(1, max_budget / kIncreaseDivisor));
+}
+}  // namespace
+
+ReadBudgetScheduler::ReadBudgetScheduler(
+    size_t max_packets_per_pass,
+    size_t max_connections_per_pass,
+    ::quic::QuicTime::Delta target_pass_duration)
+    : max_packets_per_pass_(max_packets_per_pass),
+      max_connections_per_pass_(max_connections_per_pass),
+      min_packets_per_pass_(std::max<size_t>(1, max_packets_per_pass / 4)),
+      target_pass_duration_(target_pass_duration),
+      packet_budget_(max_packets_per_pass),
+      connection_budget_(max_connections_per_pass) {
+  CHECK_GT(max_packets_per_pass_, 0u);
+  CHECK_GT(max_connections_per_pass_, 0u);
+}
+
+ReadBudgetScheduler::~ReadBudgetScheduler() = default;
+
+void ReadBudgetScheduler::OnPassComplete(const PassResult& result) {
+  stats_.passes++;
+  stats_.packets_read += result.packets_read;
+  stats_.connections_created += result.connections_created;
+  stats_.last_pass_duration = result.duration;
+  stats_.max_pass_duration =
+      std::max(stats_.max_pass_duration, result.duration);
+  // Same weight as RTT smoothing.
+  stats_.smoothed_pass_duration =
+      stats_.passes == 1 ? result.duration
+                         : 0.875 * stats_.smoothed_pass_duration +
+                               0.125 * result.duration;
+  if (result.chlos_buffered) {
+    stats_.chlo_backlog_passes++;
+  }
+
+  const bool too_long = result.duration > target_pass_duration_;
+  if (too_long || !result.socket_drained) {
+    stats_.overloaded_passes++;
+    // At least one connection is created per pass, so handshakes are delayed
+    // rather than starved.
+    connection_budget_ = std::max<size_t>(1, connection_budget_ / 2);
+    if (too_long) {
+      // Yield to other tasks, e.g.: alarms and writes, more frequently.
+      packet_budget_ = std::max(min_packets_per_pass_, packet_budget_ / 2);
+    } else {
+      packet_budget_ = std::min(max_packets_per_pass_, packet_budget_ * 2);
+    }
+    return;
+  }
+  packet_budget_ = Increase(packet_budget_, max_packets_per_pass_);
+  connection_budget_ = Increase(connection_budget_, max_connections_per_pass_);
+}
+
+}  // namespace quic
+}  // namespace owt
@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef OWT_WEB_TRANSPORT_READ_BUDGET_SCHEDULER_H_
+#define OWT_WEB_TRANSPORT_READ_BUDGET_SCHEDULER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include "net/third_party/quiche/src/quic/core/quic_time.h"
+
+namespace owt {
+namespace quic {
+
+// Decides how many packets to read, and how many new connections to create
+// from buffered CHLOs, in each pass of a server's read loop. Established
+// connections are prioritized: when a pass cannot drain the socket or takes
+// longer than the target duration, the new connection budget is halved, so a
+// burst of handshakes does not delay packets of existing sessions. Budgets
+// grow back gradually once passes are healthy. Not thread safe.
+class ReadBudgetScheduler {
+ public:
+  struct PassResult {
+    size_t packets_read = 0;
+    size_t connections_created = 0;
+    // False if the packet budget is used up before the socket is drained.
+    bool socket_drained = true;
+    // True if CHLOs are still buffered by the dispatcher after this pass.
+    bool chlos_buffered = false;
+    ::quic::QuicTime::Delta duration = ::quic::QuicTime::Delta::Zero();
+  };
+
+  struct Stats {
+    uint64_t passes = 0;
+    uint64_t packets_read = 0;
+    uint64_t connections_created = 0;
+    // Passes exceeding the target duration, or leaving the socket undrained.
+    uint64_t overloaded_passes = 0;
+    // Passes leaving CHLOs buffered.
+    uint64_t chlo_backlog_passes = 0;
+    ::quic::QuicTime::Delta last_pass_duration =
+        ::quic::QuicTime::Delta::Zero();
+    ::quic::QuicTime::Delta smoothed_pass_duration =
+        ::quic::QuicTime::Delta::Zero();
+    ::quic::QuicTime::Delta max_pass_duration =
+        ::quic::QuicTime::Delta::Zero();
+  };
+
+  // Budgets start from, and never exceed, `max_packets_per_pass` and
+  // `max_connections_per_pass`. Both must be positive.
+  ReadBudgetScheduler(size_t max_packets_per_pass,
+                      size_t max_connections_per_pass,
+                      ::quic::QuicTime::Delta target_pass_duration);
+  ~ReadBudgetScheduler();
+
+  size_t packet_budget() const { return packet_budget_; }
+  size_t connection_budget() const { return connection_budget_; }
+  const Stats& stats() const { return stats_; }
+
+  // Updates budgets for the next pass.
+  void OnPassComplete(const PassResult& result);
+
+ private:
+  const size_t max_packets_per_pass_;
+  const size_t max_connections_per_pass_;
+  const size_t min_packets_per_pass_;
+  const ::quic::QuicTime::Delta target_pass_duration_;
+  size_t packet_budget_;
+  size_t connection_budget_;
+  Stats stats_;
+};
+
+}  // namespace quic
+}  // namespace owt
+
+#endif
@@ -0,0 +1,86 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "owt/web_transport/sdk/impl/read_budget_scheduler.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace owt {
+namespace quic {
+namespace test {
+
+namespace {
+const ::quic::QuicTime::Delta kTarget =
+    ::quic::QuicTime::Delta::FromMilliseconds(4);
+
+ReadBudgetScheduler::PassResult HealthyPass() {
+  ReadBudgetScheduler::PassResult result;
+  result.packets_read = 10;
+  result.duration = ::quic::QuicTime::Delta::FromMilliseconds(1);
+  return result;
+}
+}  // namespace
+
+TEST(ReadBudgetSchedulerTest, StartsFromMaxBudgets) {
+  ReadBudgetScheduler scheduler(128, 32, kTarget);
+  EXPECT_EQ(scheduler.packet_budget(), 128u);
+  EXPECT_EQ(scheduler.connection_budget(), 32u);
+  scheduler.OnPassComplete(HealthyPass());
+  EXPECT_EQ(scheduler.packet_budget(), 128u);
+  EXPECT_EQ(scheduler.connection_budget(), 32u);
+}
+
+TEST(ReadBudgetSchedulerTest, HoldsBackConnectionsWhenSocketIsNotDrained) {
+  ReadBudgetScheduler scheduler(128, 32, kTarget);
+  ReadBudgetScheduler::PassResult result = HealthyPass();
+  result.socket_drained = false;
+  result.chlos_buffered = true;
+  scheduler.OnPassComplete(result);
+  EXPECT_EQ(scheduler.connection_budget(), 16u);
+  EXPECT_EQ(scheduler.packet_budget(), 128u);
+  for (int i = 0; i < 10; i++) {
+    scheduler.OnPassComplete(result);
+  }
+  // Never drops to zero.
+  EXPECT_EQ(scheduler.connection_budget(), 1u);
+  EXPECT_EQ(scheduler.stats().overloaded_passes, 11u);
+  EXPECT_EQ(scheduler.stats().chlo_backlog_passes, 11u);
+}
+
+TEST(ReadBudgetSchedulerTest, ShrinksPacketBudgetForLongPasses) {
+  ReadBudgetScheduler scheduler(128, 32, kTarget);
+  ReadBudgetScheduler::PassResult result = HealthyPass();
+  result.duration = ::quic::QuicTime::Delta::FromMilliseconds(10);
+  scheduler.OnPassComplete(result);
+  EXPECT_EQ(scheduler.packet_budget(), 64u);
+  EXPECT_EQ(scheduler.connection_budget(), 16u);
+  scheduler.OnPassComplete(result);
+  scheduler.OnPassComplete(result);
+  // Bounded by a quarter of max budget.
+  EXPECT_EQ(scheduler.packet_budget(), 32u);
+  EXPECT_EQ(scheduler.stats().max_pass_duration, result.duration);
+}
+
+TEST(ReadBudgetSchedulerTest, RecoversAfterHealthyPasses) {
+  ReadBudgetScheduler scheduler(128, 32, kTarget);
+  ReadBudgetScheduler::PassResult result = HealthyPass();
+  result.socket_drained = false;
+  for (int i = 0; i < 6; i++) {
+    scheduler.OnPassComplete(result);
+  }
+  ASSERT_EQ(scheduler.connection_budget(), 1u);
+  scheduler.OnPassComplete(HealthyPass());
+  EXPECT_EQ(scheduler.connection_budget(), 5u);
+  for (int i = 0; i < 10; i++) {
+    scheduler.OnPassComplete(HealthyPass());
+  }
+  EXPECT_EQ(scheduler.connection_budget(), 32u);
+  EXPECT_EQ(scheduler.stats().passes, 17u);
+  EXPECT_EQ(scheduler.stats().packets_read, 170u);
+}
+
+}  // namespace test
+}  // namespace quic
+}  // namespace owt
@@ -0,0 +1,119 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "impl/receive_buffer_ring.h"
+#include <utility>
+#include "base/check_op.h"
+
+namespace owt {
+namespace quic {
+
+namespace {
+// A buffer pointing into placed memory, which is kept mapped until every
+// buffer carved out of it is destroyed.
+class PlacedIOBuffer : public net::IOBufferWithSize {
+ public:
+  PlacedIOBuffer(scoped_refptr<PlacedMemory> memory, char* data, size_t size)
+      : net::IOBufferWithSize(data, size), memory_(std::move(memory)) {}
+
+ private:
+  ~PlacedIOBuffer() override {
+    // Not allocated by IOBuffer.
+    data_ = nullptr;
+  }
+
+  scoped_refptr<PlacedMemory> memory_;
+};
+}  // namespace
+
+PooledReceivedPacket::PooledReceivedPacket(
+    scoped_refptr<net::IOBufferWithSize> buffer,
+    const char* data,
+    size_t length,
+    ::quic::QuicTime receive_time)
+    : ::quic::QuicReceivedPacket(data,
+                                 length,
+                                 receive_time,
+                                 /*owns_buffer=*/false),
+      buffer_(std::move(buffer)) {}
+
+PooledReceivedPacket::~PooledReceivedPacket() = default;
+
+ReceiveBufferRing::ReceiveBufferRing(size_t slot_count, size_t buffer_size)
+    : ReceiveBufferRing(slot_count, buffer_size, MemoryPlacement()) {}
+
+ReceiveBufferRing::ReceiveBufferRing(size_t slot_count,
+                                     size_t buffer_size,
+                                     const MemoryPlacement& placement)
+    : buffer_size_(buffer_size),
+      placed_buffers_(0),
+      buffers_allocated_(0),
+      packets_retained_(0) {
+  CHECK_GT(slot_count, 0u);
+  CHECK_GT(buffer_size_, 0u);
+  if (!placement.IsDefault()) {
+    placed_memory_ = PlacedMemory::Allocate(
+        (slot_count + kMaxRetainedBuffers) * buffer_size_, placement);
+  }
+  slots_.reserve(slot_count);
+  for (size_t i = 0; i < slot_count; i++) {
+    slots_.push_back(TakeFreeBuffer());
+  }
+}
+
+ReceiveBufferRing::~ReceiveBufferRing() = default;
+
+net::IOBufferWithSize* ReceiveBufferRing::GetWritableBuffer(size_t slot) {
+  DCHECK_LT(slot, slots_.size());
+  scoped_refptr<net::IOBufferWithSize>& buffer = slots_[slot];
+  if (!buffer->HasOneRef()) {
+    // Packets still point into it, so they keep it until they are destroyed.
+    if (retained_buffers_.size() < kMaxRetainedBuffers) {
+      retained_buffers_.push_back(std::move(buffer));
+    }
+    buffer = TakeFreeBuffer();
+  }
+  return buffer.get();
+}
+
+std::unique_ptr<::quic::QuicReceivedPacket> ReceiveBufferRing::RetainPacket(
+    size_t slot,
+    const ::quic::QuicReceivedPacket& packet) {
+  DCHECK_LT(slot, slots_.size());
+  const scoped_refptr<net::IOBufferWithSize>& buffer = slots_[slot];
+  const char* begin = buffer->data();
+  const char* end = begin + buffer->size();
+  if (packet.data() < begin || packet.data() + packet.length() > end) {
+    return packet.Clone();
+  }
+  packets_retained_++;
+  return std::make_unique<PooledReceivedPacket>(
+      buffer, packet.data(), packet.length(), packet.receipt_time());
+}
+
+scoped_refptr<net::IOBufferWithSize> ReceiveBufferRing::TakeFreeBuffer() {
+  for (size_t i = 0; i < retained_buffers_.size(); i++) {
+    if (retained_buffers_[i]->HasOneRef()) {
+      scoped_refptr<net::IOBufferWithSize> buffer =
+          std::move(retained_buffers_[i]);
+      retained_buffers_[i] = std::move(retained_buffers_.back());
+      retained_buffers_.pop_back();
+      return buffer;
+    }
+  }
+  buffers_allocated_++;
+  if (placed_memory_ &&
+      (placed_buffers_ + 1) * buffer_size_ <= placed_memory_->size()) {
+    char* data = placed_memory_->data() + placed_buffers_ * buffer_size_;
+    placed_buffers_++;
+    return base::MakeRefCounted<PlacedIOBuffer>(placed_memory_, data,
+                                                buffer_size_);
+  }
+  return base::MakeRefCounted<net::IOBufferWithSize>(buffer_size_);
+}
+
+}  // namespace quic
+}  // namespace owt
@@ -0,0 +1,101 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef OWT_WEB_TRANSPORT_RECEIVE_BUFFER_RING_H_
+#define OWT_WEB_TRANSPORT_RECEIVE_BUFFER_RING_H_
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include "base/memory/scoped_refptr.h"
+#include "net/base/io_buffer.h"
+#include "net/third_party/quiche/src/quic/core/quic_packets.h"
+#include "net/third_party/quiche/src/quic/core/quic_time.h"
+#include "owt/web_transport/sdk/impl/placed_memory.h"
+
+namespace owt {
+namespace quic {
+
+// A received packet pointing into a pooled receive buffer. The buffer is kept
+// alive by the packet, so it could be held after the read which filled the
+// buffer, or passed to another thread, without copying.
+class PooledReceivedPacket : public ::quic::QuicReceivedPacket {
+ public:
+  PooledReceivedPacket(scoped_refptr<net::IOBufferWithSize> buffer,
+                       const char* data,
+                       size_t length,
+                       ::quic::QuicTime receive_time);
+  ~PooledReceivedPacket() override;
+
+ private:
+  scoped_refptr<net::IOBufferWithSize> buffer_;
+};
+
+// A fixed number of slots, each holds a receive buffer of `buffer_size`
+// bytes that a read writes into, e.g.: a message of recvmmsg. Packets are
+// dispatched pointing into slots without owning them. Retaining a packet
+// shares its slot's buffer, and the slot gets another buffer before the next
+// read. Buffers are reused once packets retaining them are destroyed. Packets
+// could be destroyed on any thread, other methods must be called on the
+// thread reading packets.
+//
+// With a MemoryPlacement other than the default, buffers are carved out of a
+// single PlacedMemory sized for every slot and kMaxRetainedBuffers retained
+// buffers. Buffers allocated after it's used up, e.g.: replacing retained
+// buffers dropped beyond kMaxRetainedBuffers, come from the heap.
+class ReceiveBufferRing {
+ public:
+  // Max number of retained buffers tracked for reuse, beyond which buffers
+  // are freed with the last packet retaining them.
+  static constexpr size_t kMaxRetainedBuffers = 64;
+
+  ReceiveBufferRing(size_t slot_count, size_t buffer_size);
+  ReceiveBufferRing(size_t slot_count,
+                    size_t buffer_size,
+                    const MemoryPlacement& placement);
+  ~ReceiveBufferRing();
+  ReceiveBufferRing(const ReceiveBufferRing&) = delete;
+  ReceiveBufferRing& operator=(const ReceiveBufferRing&) = delete;
+
+  // Returns the buffer of `slot` for the next read. It's not shared by any
+  // packet.
+  net::IOBufferWithSize* GetWritableBuffer(size_t slot);
+  // Returns a packet sharing `slot`'s buffer, or a copy of `packet` if it
+  // doesn't point into the buffer.
+  std::unique_ptr<::quic::QuicReceivedPacket> RetainPacket(
+      size_t slot,
+      const ::quic::QuicReceivedPacket& packet);
+
+  size_t slot_count() const { return slots_.size(); }
+  size_t buffer_size() const { return buffer_size_; }
+  // Number of buffers allocated since the ring is created, including the
+  // initial buffer of each slot.
+  uint64_t buffers_allocated() const { return buffers_allocated_; }
+  // Number of packets retained without copying.
+  uint64_t packets_retained() const { return packets_retained_; }
+  // Whether buffers are carved out of placed memory.
+  bool placed() const { return placed_memory_ != nullptr; }
+
+ private:
+  // Returns a buffer not shared by any packet, reusing a retained buffer if
+  // its packets are destroyed.
+  scoped_refptr<net::IOBufferWithSize> TakeFreeBuffer();
+
+  const size_t buffer_size_;
+  scoped_refptr<PlacedMemory> placed_memory_;
+  // Number of buffers carved out of `placed_memory_`.
+  size_t placed_buffers_;
+  std::vector<scoped_refptr<net::IOBufferWithSize>> slots_;
+  // Buffers moved out of slots while packets retain them.
+  std::vector<scoped_refptr<net::IOBufferWithSize>> retained_buffers_;
+  uint64_t buffers_allocated_;
+  uint64_t packets_retained_;
+};
+
+}  // namespace quic
+}  // namespace owt
+
+#endif
@@ -0,0 +1,130 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "owt/web_transport/sdk/impl/receive_buffer_ring.h"
+#include <cstring>
+#include <memory>
+#include <vector>
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace owt {
+namespace quic {
+namespace test {
+
+namespace {
+const ::quic::QuicTime kReceiveTime =
+    ::quic::QuicTime::Zero() + ::quic::QuicTime::Delta::FromMilliseconds(5);
+}  // namespace
+
+TEST(ReceiveBufferRingTest, ReuseBuffersNotRetained) {
+  ReceiveBufferRing ring(2, 1500);
+  EXPECT_EQ(2u, ring.buffers_allocated());
+  net::IOBufferWithSize* buffer = ring.GetWritableBuffer(0);
+  EXPECT_EQ(1500, buffer->size());
+  EXPECT_EQ(buffer, ring.GetWritableBuffer(0));
+  EXPECT_NE(buffer, ring.GetWritableBuffer(1));
+  EXPECT_EQ(2u, ring.buffers_allocated());
+}
+
+TEST(ReceiveBufferRingTest, RetainPacketWithoutCopying) {
+  ReceiveBufferRing ring(1, 1500);
+  net::IOBufferWithSize* buffer = ring.GetWritableBuffer(0);
+  memcpy(buffer->data(), "abcdef", 6);
+  ::quic::QuicReceivedPacket packet(buffer->data() + 2, 3, kReceiveTime,
+                                    /*owns_buffer=*/false);
+  std::unique_ptr<::quic::QuicReceivedPacket> retained =
+      ring.RetainPacket(0, packet);
+  EXPECT_EQ(packet.data(), retained->data());
+  EXPECT_EQ(3u, retained->length());
+  EXPECT_EQ(kReceiveTime, retained->receipt_time());
+  EXPECT_EQ(1u, ring.packets_retained());
+
+  // The slot gets another buffer while the packet is alive.
+  net::IOBufferWithSize* next = ring.GetWritableBuffer(0);
+  EXPECT_NE(buffer, next);
+  EXPECT_EQ(2u, ring.buffers_allocated());
+  memset(next->data(), 'x', next->size());
+  EXPECT_EQ(0, memcmp(retained->data(), "cde", 3));
+
+  // The retained buffer is reused after the packet is destroyed.
+  ::quic::QuicReceivedPacket next_packet(next->data(), 10, kReceiveTime,
+                                         /*owns_buffer=*/false);
+  std::unique_ptr<::quic::QuicReceivedPacket> next_retained =
+      ring.RetainPacket(0, next_packet);
+  retained.reset();
+  EXPECT_EQ(buffer, ring.GetWritableBuffer(0));
+  EXPECT_EQ(2u, ring.buffers_allocated());
+}
+
+TEST(ReceiveBufferRingTest, CopyPacketsOutsideOfBuffer) {
+  ReceiveBufferRing ring(1, 1500);
+  const char data[] = "packet";
+  ::quic::QuicReceivedPacket packet(data, sizeof(data), kReceiveTime,
+                                    /*owns_buffer=*/false);
+  std::unique_ptr<::quic::QuicReceivedPacket> retained =
+      ring.RetainPacket(0, packet);
+  EXPECT_NE(packet.data(), retained->data());
+  EXPECT_EQ(0, memcmp(data, retained->data(), sizeof(data)));
+  EXPECT_EQ(0u, ring.packets_retained());
+}
+
+TEST(ReceiveBufferRingTest, BoundRetainedBuffers) {
+  ReceiveBufferRing ring(1, 100);
+  std::vector<std::unique_ptr<::quic::QuicReceivedPacket>> packets;
+  for (size_t i = 0; i < ReceiveBufferRing::kMaxRetainedBuffers + 8; i++) {
+    net::IOBufferWithSize* buffer = ring.GetWritableBuffer(0);
+    ::quic::QuicReceivedPacket packet(buffer->data(), 10, kReceiveTime,
+                                      /*owns_buffer=*/false);
+    packets.push_back(ring.RetainPacket(0, packet));
+  }
+  const uint64_t allocated = ring.buffers_allocated();
+  packets.clear();
+  // The slot's buffer and tracked buffers are reused. Others were freed with
+  // their packets.
+  for (size_t i = 0; i < ReceiveBufferRing::kMaxRetainedBuffers + 1; i++) {
+    net::IOBufferWithSize* buffer = ring.GetWritableBuffer(0);
+    ::quic::QuicReceivedPacket packet(buffer->data(), 10, kReceiveTime,
+                                      /*owns_buffer=*/false);
+    packets.push_back(ring.RetainPacket(0, packet));
+  }
+  EXPECT_EQ(allocated, ring.buffers_allocated());
+  ring.GetWritableBuffer(0);
+  EXPECT_EQ(allocated + 1, ring.buffers_allocated());
+}
+
+TEST(ReceiveBufferRingTest, CarveBuffersOutOfPlacedMemory) {
+  MemoryPlacement placement;
+  placement.huge_pages = true;
+  ReceiveBufferRing ring(2, 1500, placement);
+  ASSERT_TRUE(ring.placed());
+  net::IOBufferWithSize* first = ring.GetWritableBuffer(0);
+  net::IOBufferWithSize* second = ring.GetWritableBuffer(1);
+  EXPECT_EQ(1500, first->size());
+  EXPECT_EQ(first->data() + 1500, second->data());
+
+  // A retained packet keeps its buffer after the ring is destroyed.
+  memcpy(first->data(), "abc", 3);
+  ::quic::QuicReceivedPacket packet(first->data(), 3, kReceiveTime,
+                                    /*owns_buffer=*/false);
+  std::unique_ptr<::quic::QuicReceivedPacket> retained =
+      ring.RetainPacket(0, packet);
+  EXPECT_EQ(packet.data(), retained->data());
+  EXPECT_EQ(second->data() + 1500, ring.GetWritableBuffer(0)->data());
+  EXPECT_EQ(3u, ring.buffers_allocated());
+  std::unique_ptr<ReceiveBufferRing> other =
+      std::make_unique<ReceiveBufferRing>(1, 100, placement);
+  ::quic::QuicReceivedPacket other_packet(other->GetWritableBuffer(0)->data(),
+                                          3, kReceiveTime,
+                                          /*owns_buffer=*/false);
+  memcpy(other->GetWritableBuffer(0)->data(), "def", 3);
+  retained = other->RetainPacket(0, other_packet);
+  other.reset();
+  EXPECT_EQ(0, memcmp(retained->data(), "def", 3));
+}
+
+}  // namespace test
+}  // namespace quic
+}  // namespace owt
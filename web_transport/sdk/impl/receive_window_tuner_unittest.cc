@@ -0,0 +1,140 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "owt/web_transport/sdk/impl/receive_window_tuner.h"
+#include <memory>
+#include "net/third_party/quiche/src/quic/core/congestion_control/rtt_stats.h"
+#include "net/third_party/quiche/src/quic/core/quic_flow_controller.h"
+#include "net/third_party/quiche/src/quic/test_tools/quic_test_utils.h"
+#include "testing/gmock/include/gmock/gmock.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace owt {
+namespace quic {
+namespace test {
+
+namespace {
+const ::quic::QuicByteCount kWindow = 64 * 1024;
+const ::quic::QuicByteCount kMaxWindow = 16 * 1024 * 1024;
+const ::quic::QuicTime::Delta kRtt =
+    ::quic::QuicTime::Delta::FromMilliseconds(150);
+}  // namespace
+
+TEST(ReceiveWindowTunerTest, GrowsWhenReaderConsumesHalfWindowPerRtt) {
+  EXPECT_TRUE(ReceiveWindowTuner::ShouldGrow(kWindow, kWindow / 2, kRtt, kRtt,
+                                             kMaxWindow));
+  EXPECT_TRUE(ReceiveWindowTuner::ShouldGrow(kWindow, kWindow, kRtt, kRtt,
+                                             kMaxWindow));
+}
+
+TEST(ReceiveWindowTunerTest, DoesNotGrowWhenReaderFallsBehind) {
+  EXPECT_FALSE(ReceiveWindowTuner::ShouldGrow(kWindow, kWindow / 4, kRtt, kRtt,
+                                              kMaxWindow));
+}
+
+TEST(ReceiveWindowTunerTest, RateIsNormalizedToRtt) {
+  // Half a window consumed over two RTTs is a quarter per RTT.
+  EXPECT_FALSE(ReceiveWindowTuner::ShouldGrow(kWindow, kWindow / 2, kRtt * 2,
+                                              kRtt, kMaxWindow));
+  EXPECT_TRUE(ReceiveWindowTuner::ShouldGrow(kWindow, kWindow, kRtt * 2, kRtt,
+                                             kMaxWindow));
+}
+
+TEST(ReceiveWindowTunerTest, WaitsForOneRtt) {
+  EXPECT_FALSE(ReceiveWindowTuner::ShouldGrow(
+      kWindow, kWindow, kRtt - ::quic::QuicTime::Delta::FromMilliseconds(1),
+      kRtt, kMaxWindow));
+  EXPECT_FALSE(ReceiveWindowTuner::ShouldGrow(
+      kWindow, kWindow, kRtt, ::quic::QuicTime::Delta::Zero(), kMaxWindow));
+}
+
+TEST(ReceiveWindowTunerTest, StopsAtCap) {
+  EXPECT_TRUE(ReceiveWindowTuner::ShouldGrow(kWindow, kWindow, kRtt, kRtt,
+                                             kWindow * 2));
+  EXPECT_FALSE(ReceiveWindowTuner::ShouldGrow(kWindow, kWindow, kRtt, kRtt,
+                                              kWindow * 2 - 1));
+  EXPECT_FALSE(
+      ReceiveWindowTuner::ShouldGrow(kWindow, kWindow, kRtt, kRtt, 0));
+}
+
+// Tunes the window of a client session's real flow controller. Stream windows
+// aren't tuned, so bytes are consumed without a stream.
+class ReceiveWindowTunerFlowControllerTest : public testing::Test {
+ protected:
+  ReceiveWindowTunerFlowControllerTest()
+      : connection_(new testing::NiceMock<::quic::test::MockQuicConnection>(
+            &helper_,
+            &alarm_factory_,
+            ::quic::Perspective::IS_CLIENT)),
+        session_(
+            std::make_unique<testing::NiceMock<::quic::test::MockQuicSession>>(
+                connection_)),
+        tuner_(std::make_unique<ReceiveWindowTuner>(session_.get())) {
+    // Periods start at initialized times.
+    helper_.AdvanceTime(kRtt);
+    const_cast<::quic::RttStats*>(
+        connection_->sent_packet_manager().GetRttStats())
+        ->UpdateRtt(kRtt, ::quic::QuicTime::Delta::Zero(),
+                    helper_.GetClock()->Now());
+    initial_window_ = window();
+  }
+
+  ~ReceiveWindowTunerFlowControllerTest() override { tuner_.reset(); }
+
+  ::quic::QuicByteCount window() {
+    return session_->flow_controller()->receive_window_size();
+  }
+
+  // Consumes `fraction` of the current window once per RTT, `rtts` times, then
+  // ends the last period. The first period also counts the bytes consumed when
+  // it starts.
+  void ConsumeForRtts(double fraction, int rtts) {
+    for (int i = 0; i < rtts; i++) {
+      tuner_->OnBytesConsumed(
+          nullptr, static_cast<::quic::QuicByteCount>(window() * fraction));
+      helper_.AdvanceTime(kRtt);
+    }
+    // Ends the last period.
+    tuner_->OnBytesConsumed(nullptr, 1);
+  }
+
+  ::quic::test::MockQuicConnectionHelper helper_;
+  ::quic::test::MockAlarmFactory alarm_factory_;
+  // Owned by `session_`.
+  ::quic::test::MockQuicConnection* connection_;
+  std::unique_ptr<::quic::test::MockQuicSession> session_;
+  std::unique_ptr<ReceiveWindowTuner> tuner_;
+  ::quic::QuicByteCount initial_window_;
+};
+
+TEST_F(ReceiveWindowTunerFlowControllerTest, ClientWindowIsNotAutoTunedByQuic) {
+  EXPECT_FALSE(session_->flow_controller()->auto_tune_receive_window());
+}
+
+TEST_F(ReceiveWindowTunerFlowControllerTest, GrowsWindowUpToCap) {
+  tuner_->SetMaxWindows(0, initial_window_ * 4);
+  ConsumeForRtts(1, 1);
+  EXPECT_EQ(window(), initial_window_ * 2);
+  ConsumeForRtts(1, 1);
+  EXPECT_EQ(window(), initial_window_ * 4);
+  ConsumeForRtts(1, 10);
+  EXPECT_EQ(window(), initial_window_ * 4);
+}
+
+TEST_F(ReceiveWindowTunerFlowControllerTest, KeepsWindowOfSlowReader) {
+  tuner_->SetMaxWindows(0, initial_window_ * 4);
+  ConsumeForRtts(0.2, 10);
+  EXPECT_EQ(window(), initial_window_);
+}
+
+TEST_F(ReceiveWindowTunerFlowControllerTest, ZeroCapKeepsWindow) {
+  ConsumeForRtts(1, 10);
+  EXPECT_EQ(window(), initial_window_);
+}
+
+}  // namespace test
+}  // namespace quic
+}  // namespace owt
@@ -0,0 +1,119 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "impl/routable_connection_id_generator.h"
+#include <string.h>
+#include "base/check_op.h"
+#include "base/logging.h"
+#include "net/third_party/quiche/src/quic/core/quic_constants.h"
+#include "net/third_party/quiche/src/quic/core/quic_utils.h"
+
+namespace owt {
+namespace quic {
+
+namespace {
+constexpr uint8_t kMaxConfigId = 6;
+constexpr size_t kMinNonceLength = 4;
+constexpr size_t kKeyLength = 16;
+}  // namespace
+
+// static
+std::unique_ptr<RoutableConnectionIdGenerator>
+RoutableConnectionIdGenerator::Create(const Config& config) {
+  if (config.config_id > kMaxConfigId) {
+    LOG(ERROR) << "Invalid config ID " << static_cast<int>(config.config_id);
+    return nullptr;
+  }
+  if (config.connection_id_length > ::quic::kQuicMaxConnectionIdLength ||
+      config.connection_id_length <
+          1 + config.server_id.size() + kMinNonceLength) {
+    LOG(ERROR) << "Connection ID length "
+               << static_cast<int>(config.connection_id_length)
+               << " cannot hold server ID and nonce.";
+    return nullptr;
+  }
+  if (!config.key.empty()) {
+    if (config.key.size() != kKeyLength) {
+      LOG(ERROR) << "Key must be " << kKeyLength << " bytes.";
+      return nullptr;
+    }
+    if (config.connection_id_length != 1 + AES_BLOCK_SIZE) {
+      LOG(ERROR) << "Encrypted connection IDs must be "
+                 << 1 + AES_BLOCK_SIZE << " bytes.";
+      return nullptr;
+    }
+  }
+  return std::unique_ptr<RoutableConnectionIdGenerator>(
+      new RoutableConnectionIdGenerator(config));
+}
+
+RoutableConnectionIdGenerator::RoutableConnectionIdGenerator(
+    const Config& config)
+    : config_(config) {
+  if (!config_.key.empty()) {
+    const uint8_t* key = reinterpret_cast<const uint8_t*>(config_.key.data());
+    CHECK_EQ(AES_set_encrypt_key(key, kKeyLength * 8, &encrypt_key_), 0);
+    CHECK_EQ(AES_set_decrypt_key(key, kKeyLength * 8, &decrypt_key_), 0);
+  }
+}
+
+RoutableConnectionIdGenerator::~RoutableConnectionIdGenerator() = default;
+
+::quic::QuicConnectionId RoutableConnectionIdGenerator::GenerateConnectionId(
+    uint8_t worker_index,
+    const ::quic::QuicConnectionId& seed) const {
+  const size_t length = config_.connection_id_length;
+  char data[::quic::kQuicMaxConnectionIdLength];
+  data[0] = FirstOctet();
+  memcpy(data + 1, config_.server_id.data(), config_.server_id.size());
+  char* nonce = data + 1 + config_.server_id.size();
+  nonce[0] = static_cast<char>(worker_index);
+  // The rest of nonce is a hash of `seed`, so retransmitted CHLOs get the same
+  // connection ID.
+  const size_t hash_length = NonceLength() - 1;
+  ::quic::QuicConnectionId hash =
+      ::quic::QuicUtils::CreateReplacementConnectionId(seed, hash_length);
+  DCHECK_EQ(hash.length(), hash_length);
+  memcpy(nonce + 1, hash.data(), hash_length);
+  if (!config_.key.empty()) {
+    uint8_t* block = reinterpret_cast<uint8_t*>(data + 1);
+    AES_encrypt(block, block, &encrypt_key_);
+  }
+  return ::quic::QuicConnectionId(data, length);
+}
+
+absl::optional<uint8_t> RoutableConnectionIdGenerator::GetWorkerIndex(
+    const char* data,
+    size_t length) const {
+  if (length != config_.connection_id_length ||
+      static_cast<uint8_t>(data[0]) != FirstOctet()) {
+    return absl::nullopt;
+  }
+  char plaintext[::quic::kQuicMaxConnectionIdLength];
+  memcpy(plaintext, data, length);
+  if (!config_.key.empty()) {
+    uint8_t* block = reinterpret_cast<uint8_t*>(plaintext + 1);
+    AES_decrypt(block, block, &decrypt_key_);
+  }
+  if (memcmp(plaintext + 1, config_.server_id.data(),
+             config_.server_id.size()) != 0) {
+    return absl::nullopt;
+  }
+  return static_cast<uint8_t>(plaintext[1 + config_.server_id.size()]);
+}
+
+uint8_t RoutableConnectionIdGenerator::FirstOctet() const {
+  // Low bits encode the length of the rest of connection ID, so a load
+  // balancer can parse short header packets.
+  return (config_.config_id << 5) | ((config_.connection_id_length - 1) & 0x1f);
+}
+
+size_t RoutableConnectionIdGenerator::NonceLength() const {
+  return config_.connection_id_length - 1 - config_.server_id.size();
+}
+
+}  // namespace quic
+}  // namespace owt
@@ -0,0 +1,68 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef OWT_WEB_TRANSPORT_ROUTABLE_CONNECTION_ID_GENERATOR_H_
+#define OWT_WEB_TRANSPORT_ROUTABLE_CONNECTION_ID_GENERATOR_H_
+
+#include <memory>
+#include <string>
+#include "net/third_party/quiche/src/quic/core/quic_connection_id.h"
+#include "third_party/abseil-cpp/absl/types/optional.h"
+#include "third_party/boringssl/src/include/openssl/aes.h"
+
+namespace owt {
+namespace quic {
+
+// Generates server connection IDs routable by a load balancer without per-flow
+// state, in the format of draft-ietf-quic-load-balancers. A connection ID is
+// first octet || server ID || nonce. The first octet has config ID in its
+// three high bits and connection ID length minus one in its low bits. The
+// first byte of nonce is the index of worker owning the connection, the rest
+// of nonce is derived from a seed. When a key is configured, server ID and
+// nonce are encrypted with AES-128-ECB, which requires them to be exactly 16
+// bytes. All methods are thread safe.
+class RoutableConnectionIdGenerator {
+ public:
+  struct Config {
+    // 0 - 6. 7 is reserved for unroutable connection IDs.
+    uint8_t config_id = 0;
+    std::string server_id;
+    // Empty, or a 16 bytes AES-128 key.
+    std::string key;
+    // Includes the first octet.
+    uint8_t connection_id_length = 0;
+  };
+
+  // Returns nullptr if `config` is invalid.
+  static std::unique_ptr<RoutableConnectionIdGenerator> Create(
+      const Config& config);
+  ~RoutableConnectionIdGenerator();
+
+  // Generates a connection ID owned by `worker_index`. The same `seed` always
+  // generates the same connection ID.
+  ::quic::QuicConnectionId GenerateConnectionId(
+      uint8_t worker_index,
+      const ::quic::QuicConnectionId& seed) const;
+  // Returns the worker index encoded in a connection ID, or nullopt if the
+  // connection ID is not generated by this generator.
+  absl::optional<uint8_t> GetWorkerIndex(const char* data,
+                                         size_t length) const;
+  uint8_t connection_id_length() const { return config_.connection_id_length; }
+
+ private:
+  explicit RoutableConnectionIdGenerator(const Config& config);
+  uint8_t FirstOctet() const;
+  size_t NonceLength() const;
+
+  const Config config_;
+  AES_KEY encrypt_key_;
+  AES_KEY decrypt_key_;
+};
+
+}  // namespace quic
+}  // namespace owt
+
+#endif
@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "owt/web_transport/sdk/impl/routable_connection_id_generator.h"
+#include "net/third_party/quiche/src/quic/test_tools/quic_test_utils.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace owt {
+namespace quic {
+namespace test {
+
+namespace {
+RoutableConnectionIdGenerator::Config PlaintextConfig() {
+  RoutableConnectionIdGenerator::Config config;
+  config.config_id = 1;
+  config.server_id = std::string("\x0a\x0b\x0c", 3);
+  config.connection_id_length = 12;
+  return config;
+}
+}  // namespace
+
+TEST(RoutableConnectionIdGeneratorTest, RejectsInvalidConfig) {
+  RoutableConnectionIdGenerator::Config config = PlaintextConfig();
+  config.config_id = 7;
+  EXPECT_EQ(RoutableConnectionIdGenerator::Create(config), nullptr);
+  config = PlaintextConfig();
+  config.connection_id_length = 6;
+  EXPECT_EQ(RoutableConnectionIdGenerator::Create(config), nullptr);
+  config = PlaintextConfig();
+  config.key = std::string(16, 'k');
+  EXPECT_EQ(RoutableConnectionIdGenerator::Create(config), nullptr);
+}
+
+TEST(RoutableConnectionIdGeneratorTest, PlaintextConnectionId) {
+  auto generator = RoutableConnectionIdGenerator::Create(PlaintextConfig());
+  ASSERT_NE(generator, nullptr);
+  ::quic::QuicConnectionId connection_id = generator->GenerateConnectionId(
+      /*worker_index=*/5, ::quic::test::TestConnectionId(42));
+  ASSERT_EQ(connection_id.length(), 12u);
+  EXPECT_EQ(static_cast<uint8_t>(connection_id.data()[0]), (1 << 5) | 11);
+  EXPECT_EQ(std::string(connection_id.data() + 1, 3),
+            std::string("\x0a\x0b\x0c", 3));
+  EXPECT_EQ(generator->GetWorkerIndex(connection_id.data(),
+                                      connection_id.length()),
+            5);
+  // Same seed generates the same connection ID.
+  EXPECT_EQ(connection_id, generator->GenerateConnectionId(
+                               5, ::quic::test::TestConnectionId(42)));
+  EXPECT_NE(connection_id, generator->GenerateConnectionId(
+                               5, ::quic::test::TestConnectionId(43)));
+}
+
+TEST(RoutableConnectionIdGeneratorTest, EncryptedConnectionId) {
+  RoutableConnectionIdGenerator::Config config = PlaintextConfig();
+  config.key = std::string(16, 'k');
+  config.connection_id_length = 17;
+  auto generator = RoutableConnectionIdGenerator::Create(config);
+  ASSERT_NE(generator, nullptr);
+  ::quic::QuicConnectionId connection_id = generator->GenerateConnectionId(
+      /*worker_index=*/3, ::quic::test::TestConnectionId(42));
+  ASSERT_EQ(connection_id.length(), 17u);
+  // Server ID is not visible.
+  EXPECT_NE(std::string(connection_id.data() + 1, 3),
+            std::string("\x0a\x0b\x0c", 3));
+  EXPECT_EQ(generator->GetWorkerIndex(connection_id.data(),
+                                      connection_id.length()),
+            3);
+}
+
+TEST(RoutableConnectionIdGeneratorTest, UnknownConnectionId) {
+  auto generator = RoutableConnectionIdGenerator::Create(PlaintextConfig());
+  ASSERT_NE(generator, nullptr);
+  ::quic::QuicConnectionId connection_id = ::quic::test::TestConnectionId(42);
+  EXPECT_FALSE(
+      generator->GetWorkerIndex(connection_id.data(), connection_id.length()));
+  RoutableConnectionIdGenerator::Config other_config = PlaintextConfig();
+  other_config.server_id = std::string("\x01\x02\x03", 3);
+  auto other_generator = RoutableConnectionIdGenerator::Create(other_config);
+  ASSERT_NE(other_generator, nullptr);
+  connection_id = other_generator->GenerateConnectionId(
+      0, ::quic::test::TestConnectionId(42));
+  EXPECT_FALSE(
+      generator->GetWorkerIndex(connection_id.data(), connection_id.length()));
+}
+
+}  // namespace test
+}  // namespace quic
+}  // namespace owt
@@ -0,0 +1,72 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "impl/send_buffer_budget.h"
+#include "base/check_op.h"
+
+namespace owt {
+namespace quic {
+
+SendBufferBudget::SendBufferBudget(SendBufferBudget* parent, Delegate* delegate)
+    : parent_(parent),
+      delegate_(delegate),
+      limit_(0),
+      usage_(0),
+      exceeded_(false) {}
+
+SendBufferBudget::~SendBufferBudget() {
+  // Return all bytes to parent in case some users are still alive.
+  if (parent_) {
+    parent_->Remove(usage());
+  }
+}
+
+void SendBufferBudget::SetLimit(uint64_t limit) {
+  limit_ = limit;
+  bool was_exceeded = exceeded_;
+  exceeded_ = IsExceededOnCurrentLevel();
+  if (was_exceeded && !exceeded_ && delegate_) {
+    delegate_->OnSendBufferBudgetAvailable();
+  }
+}
+
+void SendBufferBudget::Add(uint64_t bytes) {
+  if (bytes == 0) {
+    return;
+  }
+  usage_.fetch_add(bytes, std::memory_order_relaxed);
+  exceeded_ = IsExceededOnCurrentLevel();
+  if (parent_) {
+    parent_->Add(bytes);
+  }
+}
+
+void SendBufferBudget::Remove(uint64_t bytes) {
+  if (bytes == 0) {
+    return;
+  }
+  DCHECK_GE(usage(), bytes);
+  usage_.fetch_sub(bytes, std::memory_order_relaxed);
+  if (parent_) {
+    parent_->Remove(bytes);
+  }
+  bool was_exceeded = exceeded_;
+  exceeded_ = IsExceededOnCurrentLevel();
+  if (was_exceeded && !exceeded_ && delegate_) {
+    delegate_->OnSendBufferBudgetAvailable();
+  }
+}
+
+bool SendBufferBudget::IsExceeded() const {
+  return exceeded_ || (parent_ && parent_->IsExceeded());
+}
+
+bool SendBufferBudget::IsExceededOnCurrentLevel() const {
+  return limit_ > 0 && usage() >= limit_;
+}
+
+}  // namespace quic
+}  // namespace owt
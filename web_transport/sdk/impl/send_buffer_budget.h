@@ -0,0 +1,59 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef OWT_WEB_TRANSPORT_SEND_BUFFER_BUDGET_H_
+#define OWT_WEB_TRANSPORT_SEND_BUFFER_BUDGET_H_
+
+#include <atomic>
+#include <cstdint>
+
+namespace owt {
+namespace quic {
+
+// Accounts bytes buffered for sending. A budget may have a parent, e.g.: a
+// session's budget has its server's budget as parent, bytes added to the
+// session's budget are also added to the server's budget. Except usage(), all
+// methods must be called on IO thread. A parent doesn't notify its children
+// when it becomes available; its delegate notifies their users.
+class SendBufferBudget {
+ public:
+  class Delegate {
+   public:
+    virtual ~Delegate() = default;
+    // Called when usage drops below limit after the budget is exceeded.
+    virtual void OnSendBufferBudgetAvailable() = 0;
+  };
+
+  // `parent` and `delegate` could be nullptr.
+  SendBufferBudget(SendBufferBudget* parent, Delegate* delegate);
+  ~SendBufferBudget();
+  SendBufferBudget(const SendBufferBudget&) = delete;
+  SendBufferBudget& operator=(const SendBufferBudget&) = delete;
+
+  // Sets the max number of bytes could be buffered. 0 means unlimited.
+  void SetLimit(uint64_t limit);
+  void Add(uint64_t bytes);
+  void Remove(uint64_t bytes);
+  // Returns true if usage of this budget or any of its ancestors reaches its
+  // limit.
+  bool IsExceeded() const;
+  // Bytes buffered. It can be called on any thread.
+  uint64_t usage() const { return usage_.load(std::memory_order_relaxed); }
+
+ private:
+  bool IsExceededOnCurrentLevel() const;
+
+  SendBufferBudget* parent_;
+  Delegate* delegate_;
+  uint64_t limit_;
+  std::atomic<uint64_t> usage_;
+  bool exceeded_;
+};
+
+}  // namespace quic
+}  // namespace owt
+
+#endif
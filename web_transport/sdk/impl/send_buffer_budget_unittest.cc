@@ -0,0 +1,63 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "owt/web_transport/sdk/impl/send_buffer_budget.h"
+#include "testing/gmock/include/gmock/gmock.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace owt {
+namespace quic {
+namespace test {
+
+namespace {
+class MockDelegate : public SendBufferBudget::Delegate {
+ public:
+  MOCK_METHOD0(OnSendBufferBudgetAvailable, void());
+};
+}  // namespace
+
+TEST(SendBufferBudgetTest, UnlimitedByDefault) {
+  SendBufferBudget budget(nullptr, nullptr);
+  budget.Add(1024 * 1024);
+  EXPECT_FALSE(budget.IsExceeded());
+  EXPECT_EQ(budget.usage(), 1024u * 1024u);
+}
+
+TEST(SendBufferBudgetTest, ExceededAndAvailable) {
+  MockDelegate delegate;
+  SendBufferBudget budget(nullptr, &delegate);
+  budget.SetLimit(100);
+  budget.Add(60);
+  EXPECT_FALSE(budget.IsExceeded());
+  budget.Add(40);
+  EXPECT_TRUE(budget.IsExceeded());
+  EXPECT_CALL(delegate, OnSendBufferBudgetAvailable()).Times(1);
+  budget.Remove(10);
+  EXPECT_FALSE(budget.IsExceeded());
+  EXPECT_EQ(budget.usage(), 90u);
+}
+
+TEST(SendBufferBudgetTest, ParentBudget) {
+  SendBufferBudget parent(nullptr, nullptr);
+  parent.SetLimit(100);
+  {
+    SendBufferBudget child1(&parent, nullptr);
+    SendBufferBudget child2(&parent, nullptr);
+    child1.Add(50);
+    EXPECT_FALSE(child2.IsExceeded());
+    child2.Add(50);
+    EXPECT_EQ(parent.usage(), 100u);
+    EXPECT_TRUE(child1.IsExceeded());
+    EXPECT_TRUE(child2.IsExceeded());
+  }
+  // Bytes are returned to parent when children are destroyed.
+  EXPECT_EQ(parent.usage(), 0u);
+  EXPECT_FALSE(parent.IsExceeded());
+}
+
+}  // namespace test
+}  // namespace quic
+}  // namespace owt
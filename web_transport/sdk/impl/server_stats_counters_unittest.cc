@@ -0,0 +1,144 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "owt/web_transport/sdk/impl/server_stats_counters.h"
+#include "net/third_party/quiche/src/quic/test_tools/quic_test_utils.h"
+#include "testing/gmock/include/gmock/gmock.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace owt {
+namespace quic {
+namespace test {
+
+using ::testing::_;
+using ::testing::Return;
+
+TEST(ServerStatsCountersTest, ZeroByDefault) {
+  ServerStatsCounters counters;
+  ServerStats stats;
+  counters.Read(&stats);
+  EXPECT_EQ(stats.active_sessions, 0u);
+  EXPECT_EQ(stats.packets_received, 0u);
+  EXPECT_EQ(stats.bytes_sent, 0u);
+  EXPECT_EQ(stats.loop_utilization_percent, 0u);
+}
+
+TEST(ServerStatsCountersTest, ReadUpdatedCounters) {
+  ServerStatsCounters counters;
+  counters.OnPacketReceived(100);
+  counters.OnPacketReceived(200);
+  counters.OnPacketSent(1200);
+  counters.OnWriteBlocked();
+  counters.OnPacketsDropped(3);
+  counters.SetSessions(2, 5);
+  counters.SetChloBacklogPasses(4);
+  counters.SetRates(10, 75);
+  counters.OnPeerMigration(true);
+  counters.OnPeerMigration(false);
+  counters.SetEcnCounts(6, 1);
+  counters.OnOverload();
+  counters.OnConnectionRejected();
+  counters.OnConnectionRejected();
+  counters.OnDatagramShed();
+  counters.OnRetrySent();
+  counters.OnRetrySent();
+  counters.OnInvalidRetryToken();
+  counters.SetMaxQueueDelay(120);
+  ServerStats stats;
+  counters.Read(&stats);
+  EXPECT_EQ(stats.packets_received, 2u);
+  EXPECT_EQ(stats.bytes_received, 300u);
+  EXPECT_EQ(stats.packets_sent, 1u);
+  EXPECT_EQ(stats.bytes_sent, 1200u);
+  EXPECT_EQ(stats.write_blocked_events, 1u);
+  EXPECT_EQ(stats.packets_dropped, 3u);
+  EXPECT_EQ(stats.active_sessions, 2u);
+  EXPECT_EQ(stats.sessions_created, 5u);
+  EXPECT_EQ(stats.chlo_backlog_passes, 4u);
+  EXPECT_EQ(stats.handshakes_per_second, 10u);
+  EXPECT_EQ(stats.loop_utilization_percent, 75u);
+  EXPECT_EQ(stats.peer_migrations, 2u);
+  EXPECT_EQ(stats.peer_port_changes, 1u);
+  EXPECT_EQ(stats.ect_packets_received, 6u);
+  EXPECT_EQ(stats.ce_packets_received, 1u);
+  EXPECT_EQ(stats.overload_events, 1u);
+  EXPECT_EQ(stats.connections_rejected, 2u);
+  EXPECT_EQ(stats.datagrams_shed, 1u);
+  EXPECT_EQ(stats.retries_sent, 2u);
+  EXPECT_EQ(stats.invalid_retry_tokens, 1u);
+  EXPECT_EQ(stats.max_queue_delay_ms, 120u);
+}
+
+TEST(ServerStatsCountersTest, AccumulateSumsCountersAndKeepsMaxUtilization) {
+  ServerStats first = {};
+  first.packets_received = 10;
+  first.active_sessions = 1;
+  first.loop_utilization_percent = 30;
+  first.max_queue_delay_ms = 150;
+  ServerStats second = {};
+  second.packets_received = 5;
+  second.active_sessions = 2;
+  second.loop_utilization_percent = 80;
+  second.max_queue_delay_ms = 20;
+  ServerStats total = {};
+  ServerStatsCounters::Accumulate(first, &total);
+  ServerStatsCounters::Accumulate(second, &total);
+  EXPECT_EQ(total.packets_received, 15u);
+  EXPECT_EQ(total.active_sessions, 3u);
+  EXPECT_EQ(total.loop_utilization_percent, 80u);
+  EXPECT_EQ(total.max_queue_delay_ms, 150u);
+}
+
+TEST(ServerStatsCountersTest, PublishAndAccumulateMemoryUsage) {
+  ServerStatsCounters counters;
+  MemoryUsage usage;
+  counters.ReadMemoryUsage(&usage);
+  EXPECT_EQ(usage.sessions, 0u);
+  EXPECT_EQ(usage.total_bytes, 0u);
+  MemoryUsage published = {};
+  published.sessions = 2;
+  published.streams = 7;
+  published.stream_send_buffer_bytes = 1000;
+  published.queued_datagrams = 3;
+  published.total_bytes = 4000;
+  counters.SetMemoryUsage(published);
+  counters.ReadMemoryUsage(&usage);
+  EXPECT_EQ(usage.sessions, 2u);
+  EXPECT_EQ(usage.streams, 7u);
+  EXPECT_EQ(usage.stream_send_buffer_bytes, 1000u);
+  EXPECT_EQ(usage.queued_datagrams, 3u);
+  EXPECT_EQ(usage.total_bytes, 4000u);
+  MemoryUsage total = {};
+  ServerStatsCounters::Accumulate(usage, &total);
+  ServerStatsCounters::Accumulate(usage, &total);
+  EXPECT_EQ(total.sessions, 4u);
+  EXPECT_EQ(total.total_bytes, 8000u);
+}
+
+TEST(StatsRecordingPacketWriterTest, CountsWriteResults) {
+  ServerStatsCounters counters;
+  auto* mock_writer = new ::quic::test::MockPacketWriter();
+  StatsRecordingPacketWriter writer(mock_writer, &counters);
+  const char buffer[1000] = {};
+  EXPECT_CALL(*mock_writer, WritePacket(_, _, _, _, _))
+      .WillOnce(Return(::quic::WriteResult(::quic::WRITE_STATUS_OK, 1000)))
+      .WillOnce(Return(::quic::WriteResult(::quic::WRITE_STATUS_BLOCKED, 0)))
+      .WillOnce(Return(::quic::WriteResult(::quic::WRITE_STATUS_ERROR, 0)));
+  for (int i = 0; i < 3; i++) {
+    writer.WritePacket(buffer, sizeof(buffer), ::quic::QuicIpAddress::Any6(),
+                       ::quic::QuicSocketAddress(), nullptr);
+  }
+  ServerStats stats;
+  counters.Read(&stats);
+  EXPECT_EQ(stats.packets_sent, 1u);
+  EXPECT_EQ(stats.bytes_sent, 1000u);
+  EXPECT_EQ(stats.write_blocked_events, 1u);
+  EXPECT_EQ(stats.packets_dropped, 1u);
+}
+
+}  // namespace test
+}  // namespace quic
+}  // namespace owt
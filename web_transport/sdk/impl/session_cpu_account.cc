@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "impl/session_cpu_account.h"
+#include <algorithm>
+#include "base/check_op.h"
+#include "base/time/time.h"
+
+namespace owt {
+namespace quic {
+
+SessionCpuAccount::ScopedIoTimer::ScopedIoTimer(SessionCpuAccount* account)
+    : account_(account),
+      outermost_(account && account->io_timer_depth_++ == 0),
+      start_us_(outermost_ ? account->clock_() : 0) {}
+
+SessionCpuAccount::ScopedIoTimer::~ScopedIoTimer() {
+  if (!account_) {
+    return;
+  }
+  DCHECK_GT(account_->io_timer_depth_, 0u);
+  account_->io_timer_depth_--;
+  if (outermost_) {
+    account_->AddIoTime(account_->clock_() - start_us_);
+  }
+}
+
+SessionCpuAccount::ScopedEventTimer::ScopedEventTimer(
+    SessionCpuAccount* account)
+    : account_(account),
+      start_us_(account ? account->clock_() : 0) {}
+
+SessionCpuAccount::ScopedEventTimer::~ScopedEventTimer() {
+  if (!account_) {
+    return;
+  }
+  account_->AddEventTime(account_->clock_() - start_us_);
+}
+
+SessionCpuAccount::SessionCpuAccount()
+    : clock_(&ThreadNowInMicroseconds),
+      io_timer_depth_(0),
+      io_time_us_(0),
+      event_time_us_(0),
+      taken_time_us_(0),
+      recent_time_us_(0) {}
+
+SessionCpuAccount::~SessionCpuAccount() = default;
+
+// static
+int64_t SessionCpuAccount::ThreadNowInMicroseconds() {
+  static const bool thread_ticks_supported = base::ThreadTicks::IsSupported();
+  if (thread_ticks_supported) {
+    return (base::ThreadTicks::Now() - base::ThreadTicks()).InMicroseconds();
+  }
+  return (base::TimeTicks::Now() - base::TimeTicks()).InMicroseconds();
+}
+
+// static
+void SessionCpuAccount::KeepTop(std::vector<SessionCpuUsage>* usages,
+                                size_t count) {
+  const auto by_recent_time = [](const SessionCpuUsage& a,
+                                 const SessionCpuUsage& b) {
+    return a.recent_time_us > b.recent_time_us;
+  };
+  if (usages->size() > count) {
+    std::partial_sort(usages->begin(), usages->begin() + count, usages->end(),
+                      by_recent_time);
+    usages->resize(count);
+    return;
+  }
+  std::sort(usages->begin(), usages->end(), by_recent_time);
+}
+
+void SessionCpuAccount::AddIoTime(int64_t time_us) {
+  io_time_us_ += time_us;
+}
+
+void SessionCpuAccount::AddEventTime(int64_t time_us) {
+  event_time_us_.fetch_add(time_us, std::memory_order_relaxed);
+}
+
+int64_t SessionCpuAccount::TakeRecentTime() {
+  const int64_t total = io_time_us_ + event_time_us();
+  recent_time_us_ = total - taken_time_us_;
+  taken_time_us_ = total;
+  return recent_time_us_;
+}
+
+void SessionCpuAccount::FillUsage(SessionCpuUsage* usage) const {
+  usage->io_time_us = io_time_us_;
+  usage->event_time_us = event_time_us();
+  usage->recent_time_us = recent_time_us_;
+}
+
+}  // namespace quic
+}  // namespace owt
@@ -0,0 +1,105 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef OWT_WEB_TRANSPORT_SESSION_CPU_ACCOUNT_H_
+#define OWT_WEB_TRANSPORT_SESSION_CPU_ACCOUNT_H_
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+#include "base/memory/ref_counted.h"
+#include "owt/quic/web_transport_definitions.h"
+
+namespace owt {
+namespace quic {
+
+// Thread time spent on a QUIC connection. It's shared by the connection's
+// Http3ServerSession and its WebTransport sessions, which may outlive the
+// connection. Except AddEventTime() and event_time_us(), methods must be
+// called on the connection's IO thread.
+class SessionCpuAccount : public base::RefCountedThreadSafe<SessionCpuAccount> {
+ public:
+  // Adds the thread time between its construction and destruction to the IO
+  // time of `account`, unless another timer of the same account is on the
+  // stack, whose time already includes it. `account` could be nullptr.
+  class ScopedIoTimer {
+   public:
+    explicit ScopedIoTimer(SessionCpuAccount* account);
+    ~ScopedIoTimer();
+    ScopedIoTimer(const ScopedIoTimer&) = delete;
+    ScopedIoTimer& operator=(const ScopedIoTimer&) = delete;
+
+   private:
+    SessionCpuAccount* account_;
+    // False if this timer is nested.
+    bool outermost_;
+    int64_t start_us_;
+  };
+
+  // Same as ScopedIoTimer, but adds event time. Event callbacks are not
+  // nested. It's only used for callbacks posted to event runners, e.g.:
+  // datagram callbacks. Stream visitor callbacks are called on the IO thread,
+  // and counted by the IO timers around them.
+  class ScopedEventTimer {
+   public:
+    explicit ScopedEventTimer(SessionCpuAccount* account);
+    ~ScopedEventTimer();
+    ScopedEventTimer(const ScopedEventTimer&) = delete;
+    ScopedEventTimer& operator=(const ScopedEventTimer&) = delete;
+
+   private:
+    SessionCpuAccount* account_;
+    int64_t start_us_;
+  };
+
+  // Returns thread time in microseconds.
+  using Clock = int64_t (*)();
+
+  SessionCpuAccount();
+  SessionCpuAccount(const SessionCpuAccount&) = delete;
+  SessionCpuAccount& operator=(const SessionCpuAccount&) = delete;
+
+  // CPU time consumed by the calling thread, or a monotonic clock when thread
+  // clocks are not supported, in microseconds.
+  static int64_t ThreadNowInMicroseconds();
+  // Keeps the `count` usages with the largest recent time in `usages`, sorted
+  // by recent time in descending order.
+  static void KeepTop(std::vector<SessionCpuUsage>* usages, size_t count);
+
+  // Replaces ThreadNowInMicroseconds() for timers of this account. Must be
+  // called before any timer is created.
+  void SetClockForTesting(Clock clock) { clock_ = clock; }
+
+  void AddIoTime(int64_t time_us);
+  void AddEventTime(int64_t time_us);
+  int64_t io_time_us() const { return io_time_us_; }
+  int64_t event_time_us() const {
+    return event_time_us_.load(std::memory_order_relaxed);
+  }
+  // Returns IO and event time added since the last call.
+  int64_t TakeRecentTime();
+  // Fills `usage` with times of this account. `recent_time_us` is only
+  // updated by TakeRecentTime().
+  void FillUsage(SessionCpuUsage* usage) const;
+
+ private:
+  friend class base::RefCountedThreadSafe<SessionCpuAccount>;
+  ~SessionCpuAccount();
+
+  Clock clock_;
+  // Number of IO timers on the stack.
+  uint32_t io_timer_depth_;
+  int64_t io_time_us_;
+  std::atomic<int64_t> event_time_us_;
+  // Total time when TakeRecentTime() is called last time.
+  int64_t taken_time_us_;
+  int64_t recent_time_us_;
+};
+
+}  // namespace quic
+}  // namespace owt
+
+#endif
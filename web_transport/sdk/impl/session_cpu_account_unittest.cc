@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "owt/web_transport/sdk/impl/session_cpu_account.h"
+#include <vector>
+#include "base/memory/scoped_refptr.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace owt {
+namespace quic {
+namespace test {
+
+namespace {
+int64_t g_fake_now_us = 0;
+
+int64_t FakeNow() {
+  return g_fake_now_us;
+}
+}  // namespace
+
+TEST(SessionCpuAccountTest, NullAccountIsIgnored) {
+  SessionCpuAccount::ScopedIoTimer io_timer(nullptr);
+  SessionCpuAccount::ScopedEventTimer event_timer(nullptr);
+}
+
+TEST(SessionCpuAccountTest, NestedTimersAreCountedOnce) {
+  auto account = base::MakeRefCounted<SessionCpuAccount>();
+  account->SetClockForTesting(&FakeNow);
+  g_fake_now_us = 1000;
+  {
+    SessionCpuAccount::ScopedIoTimer outer(account.get());
+    g_fake_now_us += 50;
+    {
+      SessionCpuAccount::ScopedIoTimer inner(account.get());
+      g_fake_now_us += 100;
+    }
+    g_fake_now_us += 50;
+  }
+  EXPECT_EQ(account->io_time_us(), 200);
+  // Timers after the outermost one is destroyed are counted again.
+  {
+    SessionCpuAccount::ScopedIoTimer timer(account.get());
+    g_fake_now_us += 30;
+  }
+  EXPECT_EQ(account->io_time_us(), 230);
+  EXPECT_EQ(account->event_time_us(), 0);
+}
+
+TEST(SessionCpuAccountTest, EventTimersAddEventTime) {
+  auto account = base::MakeRefCounted<SessionCpuAccount>();
+  account->SetClockForTesting(&FakeNow);
+  g_fake_now_us = 1000;
+  {
+    SessionCpuAccount::ScopedEventTimer timer(account.get());
+    g_fake_now_us += 70;
+  }
+  EXPECT_EQ(account->event_time_us(), 70);
+  EXPECT_EQ(account->io_time_us(), 0);
+}
+
+TEST(SessionCpuAccountTest, RecentTimeSinceLastTake) {
+  auto account = base::MakeRefCounted<SessionCpuAccount>();
+  account->AddIoTime(300);
+  account->AddEventTime(200);
+  EXPECT_EQ(account->TakeRecentTime(), 500);
+  account->AddEventTime(50);
+  EXPECT_EQ(account->TakeRecentTime(), 50);
+  EXPECT_EQ(account->TakeRecentTime(), 0);
+  SessionCpuUsage usage = {};
+  account->FillUsage(&usage);
+  EXPECT_EQ(usage.io_time_us, 300u);
+  EXPECT_EQ(usage.event_time_us, 250u);
+  EXPECT_EQ(usage.recent_time_us, 0u);
+}
+
+TEST(SessionCpuAccountTest, KeepTopSortsAndTruncates) {
+  std::vector<SessionCpuUsage> usages(4, SessionCpuUsage{});
+  usages[0].recent_time_us = 10;
+  usages[1].recent_time_us = 40;
+  usages[2].recent_time_us = 20;
+  usages[3].recent_time_us = 30;
+  SessionCpuAccount::KeepTop(&usages, 2);
+  ASSERT_EQ(usages.size(), 2u);
+  EXPECT_EQ(usages[0].recent_time_us, 40u);
+  EXPECT_EQ(usages[1].recent_time_us, 30u);
+  SessionCpuAccount::KeepTop(&usages, 5);
+  ASSERT_EQ(usages.size(), 2u);
+  EXPECT_EQ(usages[0].recent_time_us, 40u);
+}
+
+}  // namespace test
+}  // namespace quic
+}  // namespace owt
@@ -0,0 +1,170 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "impl/session_ticket_crypter.h"
+#include <algorithm>
+#include <limits>
+#include <utility>
+#include "base/check.h"
+#include "crypto/random.h"
+#include "crypto/sha2.h"
+
+namespace owt {
+namespace quic {
+
+namespace {
+// A ticket is key name || nonce || AEAD(issue time || TLS ticket), key name is
+// the additional data.
+constexpr size_t kKeyNameLength = 16;
+constexpr size_t kNonceLength = 12;
+constexpr size_t kHeaderLength = kKeyNameLength + kNonceLength;
+constexpr size_t kIssueTimeLength = sizeof(int64_t);
+// Max number of tickets remembered for replay detection.
+constexpr size_t kMaxUsedTickets = 64 * 1024;
+
+const EVP_AEAD* Aead() {
+  return EVP_aead_aes_256_gcm();
+}
+
+void WriteIssueTime(int64_t issue_time, uint8_t* out) {
+  uint64_t value = static_cast<uint64_t>(issue_time);
+  for (size_t i = 0; i < kIssueTimeLength; i++) {
+    out[kIssueTimeLength - 1 - i] = static_cast<uint8_t>(value & 0xff);
+    value >>= 8;
+  }
+}
+
+int64_t ReadIssueTime(const uint8_t* in) {
+  uint64_t value = 0;
+  for (size_t i = 0; i < kIssueTimeLength; i++) {
+    value = (value << 8) | in[i];
+  }
+  return static_cast<int64_t>(value);
+}
+}  // namespace
+
+SessionTicketCrypter::SessionTicketCrypter(bool single_use_tickets,
+                                           const ::quic::QuicClock* clock)
+    : single_use_tickets_(single_use_tickets),
+      clock_(clock),
+      min_issue_time_(std::numeric_limits<int64_t>::min()) {
+  CHECK(clock_);
+}
+
+SessionTicketCrypter::~SessionTicketCrypter() = default;
+
+bool SessionTicketCrypter::SetKeys(const uint8_t* keys, size_t key_count) {
+  if (!keys || key_count == 0) {
+    return false;
+  }
+  std::vector<std::unique_ptr<Key>> new_keys;
+  for (size_t i = 0; i < key_count; i++) {
+    const uint8_t* key_data = keys + i * kKeyLength;
+    auto key = std::make_unique<Key>();
+    key->name = crypto::SHA256HashString(
+                    std::string(reinterpret_cast<const char*>(key_data),
+                                kKeyLength))
+                    .substr(0, kKeyNameLength);
+    if (!EVP_AEAD_CTX_init(key->context.get(), Aead(), key_data, kKeyLength,
+                           EVP_AEAD_DEFAULT_TAG_LENGTH, nullptr)) {
+      return false;
+    }
+    new_keys.push_back(std::move(key));
+  }
+  base::AutoLock lock(lock_);
+  keys_ = std::move(new_keys);
+  return true;
+}
+
+size_t SessionTicketCrypter::MaxOverhead() {
+  return kHeaderLength + kIssueTimeLength + EVP_AEAD_max_overhead(Aead());
+}
+
+std::vector<uint8_t> SessionTicketCrypter::Encrypt(
+    absl::string_view in,
+    absl::string_view encryption_key) {
+  // Only set by ProofSourceHandle implementations, which are not used.
+  DCHECK(encryption_key.empty());
+  std::vector<uint8_t> plaintext(kIssueTimeLength + in.size());
+  WriteIssueTime(clock_->WallNow().ToUNIXMicroseconds(), plaintext.data());
+  std::copy(in.begin(), in.end(), plaintext.begin() + kIssueTimeLength);
+
+  std::vector<uint8_t> out(plaintext.size() + MaxOverhead());
+  base::AutoLock lock(lock_);
+  if (keys_.empty()) {
+    return std::vector<uint8_t>();
+  }
+  const Key& key = *keys_.front();
+  std::copy(key.name.begin(), key.name.end(), out.begin());
+  crypto::RandBytes(out.data() + kKeyNameLength, kNonceLength);
+  size_t sealed_length = 0;
+  if (!EVP_AEAD_CTX_seal(key.context.get(), out.data() + kHeaderLength,
+                         &sealed_length, out.size() - kHeaderLength,
+                         out.data() + kKeyNameLength, kNonceLength,
+                         plaintext.data(), plaintext.size(), out.data(),
+                         kKeyNameLength)) {
+    return std::vector<uint8_t>();
+  }
+  out.resize(kHeaderLength + sealed_length);
+  return out;
+}
+
+void SessionTicketCrypter::Decrypt(
+    absl::string_view in,
+    std::unique_ptr<::quic::ProofSource::DecryptCallback> callback) {
+  callback->Run(DecryptTicket(in));
+}
+
+std::vector<uint8_t> SessionTicketCrypter::DecryptTicket(absl::string_view in) {
+  if (in.size() < kHeaderLength) {
+    return std::vector<uint8_t>();
+  }
+  const uint8_t* data = reinterpret_cast<const uint8_t*>(in.data());
+  const absl::string_view name = in.substr(0, kKeyNameLength);
+  std::vector<uint8_t> plaintext(in.size() - kHeaderLength);
+  base::AutoLock lock(lock_);
+  auto key = std::find_if(
+      keys_.begin(), keys_.end(),
+      [name](const std::unique_ptr<Key>& key) { return key->name == name; });
+  if (key == keys_.end()) {
+    return std::vector<uint8_t>();
+  }
+  size_t opened_length = 0;
+  if (!EVP_AEAD_CTX_open((*key)->context.get(), plaintext.data(),
+                         &opened_length, plaintext.size(),
+                         data + kKeyNameLength, kNonceLength,
+                         data + kHeaderLength, in.size() - kHeaderLength, data,
+                         kKeyNameLength) ||
+      opened_length < kIssueTimeLength) {
+    return std::vector<uint8_t>();
+  }
+  if (single_use_tickets_ &&
+      !MarkTicketUsed(std::string(in.substr(0, kHeaderLength)),
+                      ReadIssueTime(plaintext.data()))) {
+    return std::vector<uint8_t>();
+  }
+  plaintext.resize(opened_length);
+  plaintext.erase(plaintext.begin(), plaintext.begin() + kIssueTimeLength);
+  return plaintext;
+}
+
+bool SessionTicketCrypter::MarkTicketUsed(const std::string& id,
+                                          int64_t issue_time) {
+  if (issue_time <= min_issue_time_ || !used_tickets_.insert(id).second) {
+    return false;
+  }
+  used_ticket_order_.push_back(UsedTicket{id, issue_time});
+  if (used_ticket_order_.size() > kMaxUsedTickets) {
+    const UsedTicket& oldest = used_ticket_order_.front();
+    min_issue_time_ = std::max(min_issue_time_, oldest.issue_time);
+    used_tickets_.erase(oldest.id);
+    used_ticket_order_.pop_front();
+  }
+  return true;
+}
+
+}  // namespace quic
+}  // namespace owt
@@ -0,0 +1,88 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef OWT_WEB_TRANSPORT_SESSION_TICKET_CRYPTER_H_
+#define OWT_WEB_TRANSPORT_SESSION_TICKET_CRYPTER_H_
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+#include "base/synchronization/lock.h"
+#include "base/thread_annotations.h"
+#include "net/third_party/quiche/src/quic/core/crypto/proof_source.h"
+#include "net/third_party/quiche/src/quic/core/quic_clock.h"
+#include "third_party/abseil-cpp/absl/container/flat_hash_set.h"
+#include "third_party/boringssl/src/include/openssl/aead.h"
+
+namespace owt {
+namespace quic {
+
+// Encrypts and decrypts TLS session tickets with keys provided by the
+// application, so servers sharing the same keys could resume sessions of each
+// other. New tickets are encrypted with the first key, and tickets encrypted
+// with any of the keys are accepted, which allows keys to be rotated without
+// invalidating all tickets. Thread safe, since a server's IO threads share the
+// same crypter.
+class SessionTicketCrypter : public ::quic::ProofSource::TicketCrypter {
+ public:
+  // Length of each key, in bytes.
+  static constexpr size_t kKeyLength = 32;
+
+  // If `single_use_tickets` is true, a ticket is only accepted once, so early
+  // data sent with it cannot be replayed to this crypter. Replayed tickets
+  // fall back to full handshakes.
+  SessionTicketCrypter(bool single_use_tickets, const ::quic::QuicClock* clock);
+  ~SessionTicketCrypter() override;
+  SessionTicketCrypter(const SessionTicketCrypter&) = delete;
+  SessionTicketCrypter& operator=(const SessionTicketCrypter&) = delete;
+
+  // Replaces keys with `key_count` keys of kKeyLength bytes stored in `keys`.
+  // Returns false and keeps current keys if `key_count` is 0.
+  bool SetKeys(const uint8_t* keys, size_t key_count);
+
+  // Overrides ::quic::ProofSource::TicketCrypter.
+  size_t MaxOverhead() override;
+  std::vector<uint8_t> Encrypt(absl::string_view in,
+                               absl::string_view encryption_key) override;
+  void Decrypt(absl::string_view in,
+               std::unique_ptr<::quic::ProofSource::DecryptCallback> callback)
+      override;
+
+ private:
+  struct Key {
+    // Identifies the key which encrypts a ticket.
+    std::string name;
+    bssl::ScopedEVP_AEAD_CTX context;
+  };
+  struct UsedTicket {
+    std::string id;
+    int64_t issue_time;
+  };
+
+  // Returns an empty vector if `in` cannot be decrypted, or it's replayed.
+  std::vector<uint8_t> DecryptTicket(absl::string_view in);
+  // Returns false if the ticket identified by `id` has been used.
+  bool MarkTicketUsed(const std::string& id, int64_t issue_time)
+      EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  const bool single_use_tickets_;
+  const ::quic::QuicClock* clock_;  // Not owned.
+  base::Lock lock_;
+  std::vector<std::unique_ptr<Key>> keys_ GUARDED_BY(lock_);
+  // Tickets accepted recently, in the order of their first use. When the
+  // oldest is evicted, tickets issued before it are no longer accepted, so
+  // evicted tickets cannot be replayed.
+  absl::flat_hash_set<std::string> used_tickets_ GUARDED_BY(lock_);
+  std::deque<UsedTicket> used_ticket_order_ GUARDED_BY(lock_);
+  int64_t min_issue_time_ GUARDED_BY(lock_);
+};
+
+}  // namespace quic
+}  // namespace owt
+
+#endif
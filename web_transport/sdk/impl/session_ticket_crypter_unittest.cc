@@ -0,0 +1,105 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "owt/web_transport/sdk/impl/session_ticket_crypter.h"
+#include "net/third_party/quiche/src/quic/test_tools/mock_clock.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace owt {
+namespace quic {
+namespace test {
+
+namespace {
+class TestDecryptCallback : public ::quic::ProofSource::DecryptCallback {
+ public:
+  explicit TestDecryptCallback(std::vector<uint8_t>* out) : out_(out) {}
+  void Run(std::vector<uint8_t> plaintext) override {
+    *out_ = std::move(plaintext);
+  }
+
+ private:
+  std::vector<uint8_t>* out_;
+};
+
+std::vector<uint8_t> Decrypt(SessionTicketCrypter& crypter,
+                             const std::vector<uint8_t>& ticket) {
+  std::vector<uint8_t> out;
+  crypter.Decrypt(
+      absl::string_view(reinterpret_cast<const char*>(ticket.data()),
+                        ticket.size()),
+      std::make_unique<TestDecryptCallback>(&out));
+  return out;
+}
+
+// `count` keys filled with `first_value`, `first_value + 1`, ...
+std::vector<uint8_t> Keys(uint8_t first_value, size_t count) {
+  std::vector<uint8_t> keys;
+  for (size_t i = 0; i < count; i++) {
+    keys.insert(keys.end(), SessionTicketCrypter::kKeyLength,
+                static_cast<uint8_t>(first_value + i));
+  }
+  return keys;
+}
+
+const char kTicket[] = "session ticket";
+const std::vector<uint8_t> kTicketBytes(kTicket, kTicket + sizeof(kTicket) - 1);
+}  // namespace
+
+TEST(SessionTicketCrypterTest, EncryptAndDecrypt) {
+  ::quic::MockClock clock;
+  SessionTicketCrypter crypter(false, &clock);
+  std::vector<uint8_t> keys = Keys(1, 1);
+  ASSERT_TRUE(crypter.SetKeys(keys.data(), 1));
+  std::vector<uint8_t> ticket = crypter.Encrypt(kTicket, "");
+  ASSERT_FALSE(ticket.empty());
+  EXPECT_LE(ticket.size(), kTicketBytes.size() + crypter.MaxOverhead());
+  EXPECT_EQ(Decrypt(crypter, ticket), kTicketBytes);
+  // Tickets could be reused.
+  EXPECT_EQ(Decrypt(crypter, ticket), kTicketBytes);
+  // Tampered tickets are rejected.
+  ticket.back() ^= 1;
+  EXPECT_TRUE(Decrypt(crypter, ticket).empty());
+  EXPECT_FALSE(crypter.SetKeys(nullptr, 0));
+}
+
+TEST(SessionTicketCrypterTest, RotateKeys) {
+  ::quic::MockClock clock;
+  SessionTicketCrypter crypter(false, &clock);
+  std::vector<uint8_t> old_keys = Keys(1, 1);
+  ASSERT_TRUE(crypter.SetKeys(old_keys.data(), 1));
+  std::vector<uint8_t> old_ticket = crypter.Encrypt(kTicket, "");
+
+  // New key first, old key is kept for decryption.
+  std::vector<uint8_t> keys = Keys(2, 1);
+  keys.insert(keys.end(), old_keys.begin(), old_keys.end());
+  ASSERT_TRUE(crypter.SetKeys(keys.data(), 2));
+  std::vector<uint8_t> new_ticket = crypter.Encrypt(kTicket, "");
+  EXPECT_EQ(Decrypt(crypter, old_ticket), kTicketBytes);
+  EXPECT_EQ(Decrypt(crypter, new_ticket), kTicketBytes);
+
+  // A server which only has the new key.
+  SessionTicketCrypter other_crypter(false, &clock);
+  ASSERT_TRUE(other_crypter.SetKeys(keys.data(), 1));
+  EXPECT_EQ(Decrypt(other_crypter, new_ticket), kTicketBytes);
+  EXPECT_TRUE(Decrypt(other_crypter, old_ticket).empty());
+}
+
+TEST(SessionTicketCrypterTest, SingleUseTickets) {
+  ::quic::MockClock clock;
+  clock.AdvanceTime(::quic::QuicTime::Delta::FromSeconds(1));
+  SessionTicketCrypter crypter(true, &clock);
+  std::vector<uint8_t> keys = Keys(1, 1);
+  ASSERT_TRUE(crypter.SetKeys(keys.data(), 1));
+  std::vector<uint8_t> ticket = crypter.Encrypt(kTicket, "");
+  std::vector<uint8_t> another_ticket = crypter.Encrypt(kTicket, "");
+  EXPECT_EQ(Decrypt(crypter, ticket), kTicketBytes);
+  EXPECT_TRUE(Decrypt(crypter, ticket).empty());
+  EXPECT_EQ(Decrypt(crypter, another_ticket), kTicketBytes);
+}
+
+}  // namespace test
+}  // namespace quic
+}  // namespace owt
@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "owt/quic/stream_receive_ring.h"
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace owt {
+namespace quic {
+namespace test {
+
+namespace {
+// Writes `data` the way the SDK does, returns the number of bytes written.
+size_t Produce(StreamReceiveRing* ring, const std::string& data) {
+  size_t written = 0;
+  while (written < data.size()) {
+    size_t length = 0;
+    uint8_t* region = ring->GetWriteRegion(&length);
+    if (length == 0) {
+      break;
+    }
+    length = std::min(length, data.size() - written);
+    memcpy(region, data.data() + written, length);
+    ring->CommitWrite(length);
+    written += length;
+  }
+  return written;
+}
+
+std::string Consume(StreamReceiveRing* ring, size_t length) {
+  std::string data(length, '\0');
+  data.resize(ring->Read(reinterpret_cast<uint8_t*>(&data[0]), length));
+  return data;
+}
+}  // namespace
+
+TEST(StreamReceiveRingTest, DataWrapsAroundTheEnd) {
+  uint8_t storage[8];
+  StreamReceiveRing ring(storage, sizeof(storage));
+  EXPECT_EQ(6u, Produce(&ring, "abcdef"));
+  EXPECT_EQ("abcd", Consume(&ring, 4));
+  EXPECT_EQ(6u, Produce(&ring, "ghijkl"));
+  EXPECT_EQ(8u, ring.ReadableBytes());
+  EXPECT_EQ(0u, ring.WritableBytes());
+  EXPECT_EQ("efghijkl", Consume(&ring, 16));
+  EXPECT_EQ(0u, ring.ReadableBytes());
+}
+
+TEST(StreamReceiveRingTest, ConsumerSeesBlockedProducerOnce) {
+  uint8_t storage[4];
+  StreamReceiveRing ring(storage, sizeof(storage));
+  EXPECT_EQ(4u, Produce(&ring, "abcdef"));
+  EXPECT_TRUE(ring.MarkProducerBlocked());
+  EXPECT_EQ("ab", Consume(&ring, 2));
+  EXPECT_TRUE(ring.TakeProducerBlocked());
+  EXPECT_FALSE(ring.TakeProducerBlocked());
+  // Space is available, so the producer keeps writing instead.
+  EXPECT_FALSE(ring.MarkProducerBlocked());
+  EXPECT_FALSE(ring.TakeProducerBlocked());
+}
+
+}  // namespace test
+}  // namespace quic
+}  // namespace owt
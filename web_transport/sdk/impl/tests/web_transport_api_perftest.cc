@@ -0,0 +1,368 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+// Measures the per-call cost of public stream, session and client methods
+// when they are called on the IO thread, and from a foreign thread while the
+// IO thread is idle or loaded. Calls from a foreign thread either read cached
+// state, post a task, or post a task and wait for its result, so the numbers
+// show which methods still block on a thread hop.
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+#include "base/bind.h"
+#include "base/files/file_path.h"
+#include "base/strings/strcat.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/synchronization/waitable_event.h"
+#include "base/test/bind.h"
+#include "base/threading/thread.h"
+#include "base/timer/lap_timer.h"
+#include "impl/web_transport_owt_client_impl.h"
+#include "net/proxy_resolution/configured_proxy_resolution_service.h"
+#include "net/quic/platform/impl/quic_chromium_clock.h"
+#include "net/quic/web_transport_client.h"
+#include "net/test/test_data_directory.h"
+#include "net/test/test_with_task_environment.h"
+#include "net/third_party/quiche/src/quic/core/quic_simple_buffer_allocator.h"
+#include "net/url_request/url_request_context.h"
+#include "net/url_request/url_request_context_builder.h"
+#include "owt/quic/web_transport_factory.h"
+#include "owt/quic/web_transport_server_interface.h"
+#include "owt/web_transport/sdk/impl/tests/web_transport_echo_visitors.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_result_reporter.h"
+
+namespace owt {
+namespace quic {
+namespace test {
+
+namespace {
+constexpr int kWarmupLaps = 100;
+constexpr int kTimeLimitMs = 1000;
+constexpr int kTimeCheckInterval = 10;
+// Stream creation is limited by the peer's stream limit.
+constexpr int kMaxStreamsCreated = 50;
+// Each load task keeps the IO thread busy for this long.
+constexpr int64_t kLoadTaskDurationUs = 200;
+// quic-short-lived.pem is only valid around this time.
+constexpr uint64_t kCertificateValidUnixSeconds = 1591389300;
+
+class PerfTestWallClock : public ::quic::QuicClock {
+ public:
+  ::quic::QuicTime Now() const override {
+    return ::quic::QuicChromiumClock::GetInstance()->Now();
+  }
+  ::quic::QuicTime ApproximateNow() const override {
+    return ::quic::QuicChromiumClock::GetInstance()->ApproximateNow();
+  }
+  ::quic::QuicWallTime WallNow() const override {
+    return ::quic::QuicWallTime::FromUNIXSeconds(kCertificateValidUnixSeconds);
+  }
+};
+
+class PerfTestConnectionHelper : public ::quic::QuicConnectionHelperInterface {
+ public:
+  const ::quic::QuicClock* GetClock() const override { return &clock_; }
+  ::quic::QuicRandom* GetRandomGenerator() override {
+    return ::quic::QuicRandom::GetInstance();
+  }
+  ::quic::QuicBufferAllocator* GetStreamSendBufferAllocator() override {
+    return &allocator_;
+  }
+
+ private:
+  PerfTestWallClock clock_;
+  ::quic::SimpleBufferAllocator allocator_;
+};
+
+class PerfTestClientVisitor : public WebTransportClientInterface::Visitor {
+ public:
+  explicit PerfTestClientVisitor(base::OnceClosure on_connected)
+      : on_connected_(std::move(on_connected)) {}
+  void OnConnected() override { std::move(on_connected_).Run(); }
+  void OnConnectionFailed() override { ADD_FAILURE() << "Failed to connect."; }
+  void OnIncomingStream(WebTransportStreamInterface*) override {}
+  void OnDatagramProcessed(MessageStatus) override {}
+  void OnClosed(uint32_t, const char*) override {}
+
+ private:
+  base::OnceClosure on_connected_;
+};
+
+class PerfTestStreamVisitor : public WebTransportStreamInterface::Visitor {
+ public:
+  void OnCanRead() override {}
+  void OnCanWrite() override {}
+  void OnFinRead() override {}
+};
+
+// Keeps a thread busy by posting tasks which spin for kLoadTaskDurationUs,
+// so tasks posted by a foreign thread wait behind them.
+class ThreadLoadGenerator {
+ public:
+  explicit ThreadLoadGenerator(
+      scoped_refptr<base::SingleThreadTaskRunner> runner)
+      : runner_(std::move(runner)), running_(false) {}
+  ~ThreadLoadGenerator() { Stop(); }
+
+  void Start() {
+    running_ = true;
+    runner_->PostTask(FROM_HERE, base::BindOnce(&ThreadLoadGenerator::Spin,
+                                                base::Unretained(this)));
+  }
+
+  // Waits until the last load task finishes.
+  void Stop() {
+    if (!running_) {
+      return;
+    }
+    running_ = false;
+    base::WaitableEvent done;
+    runner_->PostTask(FROM_HERE, base::BindOnce(&base::WaitableEvent::Signal,
+                                                base::Unretained(&done)));
+    done.Wait();
+  }
+
+ private:
+  void Spin() {
+    if (!running_) {
+      return;
+    }
+    const base::TimeTicks end =
+        base::TimeTicks::Now() + base::Microseconds(kLoadTaskDurationUs);
+    while (base::TimeTicks::Now() < end) {
+    }
+    runner_->PostTask(FROM_HERE, base::BindOnce(&ThreadLoadGenerator::Spin,
+                                                base::Unretained(this)));
+  }
+
+  scoped_refptr<base::SingleThreadTaskRunner> runner_;
+  std::atomic<bool> running_;
+};
+
+}  // namespace
+
+class WebTransportApiPerfTest : public net::TestWithTaskEnvironment {
+ public:
+  WebTransportApiPerfTest()
+      : io_thread_("web_transport_api_perftest_io_thread"),
+        event_thread_("web_transport_api_perftest_event_thread"),
+        factory_(WebTransportFactory::CreateForTesting()),
+        port_(20004) {
+    io_thread_.StartWithOptions(
+        base::Thread::Options(base::MessagePumpType::IO, 0));
+    event_thread_.StartWithOptions(
+        base::Thread::Options(base::MessagePumpType::IO, 0));
+  }
+
+  ~WebTransportApiPerfTest() override {
+    client_.reset();
+    base::WaitableEvent done;
+    io_thread_.task_runner()->PostTask(
+        FROM_HERE, base::BindOnce(
+                       [](std::unique_ptr<net::URLRequestContext> context,
+                          std::unique_ptr<WebTransportServerInterface> server,
+                          base::WaitableEvent* event) {
+                         context.reset();
+                         server.reset();
+                         event->Signal();
+                       },
+                       std::move(context_), std::move(server_), &done));
+    done.Wait();
+    factory_.reset();
+  }
+
+  void SetUp() override {
+    base::FilePath certs_dir = net::GetTestCertsDirectory();
+    server_.reset(factory_->CreateWebTransportServer(
+        port_,
+        certs_dir.AppendASCII("quic-short-lived.pem").MaybeAsASCII().c_str(),
+        certs_dir.AppendASCII("quic-leaf-cert.key").MaybeAsASCII().c_str(),
+        certs_dir.AppendASCII("quic-leaf-cert.key.sct").MaybeAsASCII().c_str(),
+        WebTransportServerInterface::Options()));
+    ASSERT_TRUE(server_);
+    server_->SetVisitor(&server_visitor_);
+    server_->Start();
+
+    base::WaitableEvent context_ready;
+    io_thread_.task_runner()->PostTask(
+        FROM_HERE, base::BindOnce(&WebTransportApiPerfTest::InitContext,
+                                  base::Unretained(this), &context_ready));
+    context_ready.Wait();
+    net::WebTransportParameters parameters;
+    parameters.server_certificate_fingerprints.push_back(
+        ::quic::CertificateFingerprint{
+            .algorithm = ::quic::CertificateFingerprint::kSha256,
+            .fingerprint =
+                "ED:3D:D7:C3:67:10:94:68:D1:DC:D1:26:5C:B2:74:D7:1C:"
+                "A2:63:3E:94:94:C0:84:39:D6:64:FA:08:B9:77:37"});
+    client_ = std::make_unique<WebTransportOwtClientImpl>(
+        GURL(base::StrCat({"https://test.example.com:",
+                           base::NumberToString(port_), "/echo"})),
+        url::Origin(), parameters, context_.get(), &io_thread_,
+        &event_thread_);
+    base::RunLoop run_loop;
+    PerfTestClientVisitor client_visitor(run_loop.QuitClosure());
+    client_->SetVisitor(&client_visitor);
+    client_->Connect();
+    run_loop.Run();
+    client_->SetVisitor(nullptr);
+    stream_ = client_->CreateBidirectionalStream();
+    ASSERT_TRUE(stream_);
+    stream_->SetVisitor(&stream_visitor_);
+  }
+
+ protected:
+  enum class CallSite { kIoThread, kIdleForeignThread, kLoadedForeignThread };
+
+  void InitContext(base::WaitableEvent* event) {
+    net::URLRequestContextBuilder builder;
+    builder.set_proxy_resolution_service(
+        net::ConfiguredProxyResolutionService::CreateDirect());
+    auto quic_context = std::make_unique<net::QuicContext>(
+        std::make_unique<PerfTestConnectionHelper>());
+    quic_context->params()->origins_to_force_quic_on.insert(
+        net::HostPortPair("test.example.com", 0));
+    builder.set_quic_context(std::move(quic_context));
+    context_ = builder.Build();
+    event->Signal();
+  }
+
+  // Calls `call` repeatedly from `site` and reports the time per call as
+  // `metric`. `max_laps` bounds calls which consume limited resources.
+  void MeasureCall(const std::string& metric,
+                   CallSite site,
+                   base::RepeatingClosure call,
+                   int max_laps = 0) {
+    base::TimeDelta time_per_call;
+    auto run = [&]() {
+      base::LapTimer timer(max_laps > 0 ? 0 : kWarmupLaps,
+                           base::Milliseconds(kTimeLimitMs),
+                           kTimeCheckInterval);
+      do {
+        call.Run();
+        timer.NextLap();
+      } while (!timer.HasTimeLimitExpired() &&
+               (max_laps == 0 || timer.NumLaps() < max_laps));
+      time_per_call = timer.TimePerLap();
+    };
+    if (site == CallSite::kIoThread) {
+      base::WaitableEvent done;
+      io_thread_.task_runner()->PostTask(
+          FROM_HERE, base::BindOnce(
+                         [](decltype(run)* run, base::WaitableEvent* done) {
+                           (*run)();
+                           done->Signal();
+                         },
+                         &run, &done));
+      done.Wait();
+    } else {
+      ThreadLoadGenerator load(io_thread_.task_runner());
+      if (site == CallSite::kLoadedForeignThread) {
+        load.Start();
+      }
+      run();
+    }
+    const char* story = site == CallSite::kIoThread ? "io_thread"
+                        : site == CallSite::kIdleForeignThread
+                            ? "foreign_thread_idle_io"
+                            : "foreign_thread_loaded_io";
+    perf_test::PerfResultReporter reporter("WebTransportApi.", story);
+    reporter.RegisterImportantMetric(metric, "us");
+    reporter.AddResult(metric, time_per_call.InMicrosecondsF());
+  }
+
+  // Measures `call` from all call sites.
+  void MeasureCallFromAllSites(const std::string& metric,
+                               base::RepeatingClosure call,
+                               int max_laps = 0) {
+    MeasureCall(metric, CallSite::kIoThread, call, max_laps);
+    MeasureCall(metric, CallSite::kIdleForeignThread, call, max_laps);
+    MeasureCall(metric, CallSite::kLoadedForeignThread, call, max_laps);
+  }
+
+  base::Thread io_thread_;
+  base::Thread event_thread_;
+  std::unique_ptr<WebTransportFactory> factory_;
+  std::unique_ptr<WebTransportServerInterface> server_;
+  ServerEchoVisitor server_visitor_;
+  int port_;
+  std::unique_ptr<net::URLRequestContext> context_;
+  std::unique_ptr<WebTransportClientInterface> client_;
+  WebTransportStreamInterface* stream_ = nullptr;
+  PerfTestStreamVisitor stream_visitor_;
+};
+
+TEST_F(WebTransportApiPerfTest, StreamWrite) {
+  const uint8_t data[64] = {};
+  MeasureCallFromAllSites("Write", base::BindLambdaForTesting([&]() {
+                            stream_->Write(data, sizeof(data));
+                          }));
+}
+
+TEST_F(WebTransportApiPerfTest, StreamRead) {
+  uint8_t buffer[64];
+  MeasureCallFromAllSites("Read", base::BindLambdaForTesting([&]() {
+                            stream_->Read(buffer, sizeof(buffer));
+                          }));
+}
+
+TEST_F(WebTransportApiPerfTest, StreamReadableBytes) {
+  MeasureCallFromAllSites("ReadableBytes", base::BindLambdaForTesting([&]() {
+                            stream_->ReadableBytes();
+                          }));
+}
+
+TEST_F(WebTransportApiPerfTest, StreamCanWrite) {
+  MeasureCallFromAllSites("CanWrite", base::BindLambdaForTesting(
+                                          [&]() { stream_->CanWrite(); }));
+}
+
+TEST_F(WebTransportApiPerfTest, ClientSendOrQueueDatagram) {
+  uint8_t data[64] = {};
+  MeasureCallFromAllSites("SendOrQueueDatagram",
+                          base::BindLambdaForTesting([&]() {
+                            client_->SendOrQueueDatagram(data, sizeof(data));
+                          }));
+}
+
+TEST_F(WebTransportApiPerfTest, ClientCreateBidirectionalStream) {
+  for (CallSite site : {CallSite::kIoThread, CallSite::kIdleForeignThread,
+                        CallSite::kLoadedForeignThread}) {
+    MeasureCall("CreateBidirectionalStream", site,
+                base::BindLambdaForTesting(
+                    [&]() { client_->CreateBidirectionalStream(); }),
+                kMaxStreamsCreated / 3);
+  }
+}
+
+// Server sessions run on IO threads owned by the server, so they're only
+// called from a foreign thread.
+TEST_F(WebTransportApiPerfTest, ServerSessionSendOrQueueDatagram) {
+  ASSERT_FALSE(server_visitor_.Sessions().empty());
+  WebTransportSessionInterface* session = server_visitor_.Sessions()[0];
+  uint8_t data[64] = {};
+  MeasureCall("ServerSessionSendOrQueueDatagram", CallSite::kIdleForeignThread,
+              base::BindLambdaForTesting([&]() {
+                session->SendOrQueueDatagram(data, sizeof(data));
+              }));
+}
+
+TEST_F(WebTransportApiPerfTest, ServerSessionCreateBidirectionalStream) {
+  ASSERT_FALSE(server_visitor_.Sessions().empty());
+  WebTransportSessionInterface* session = server_visitor_.Sessions()[0];
+  MeasureCall(
+      "ServerSessionCreateBidirectionalStream", CallSite::kIdleForeignThread,
+      base::BindLambdaForTesting(
+          [&]() { session->CreateBidirectionalStream(); }),
+      kMaxStreamsCreated);
+}
+
+}  // namespace test
+}  // namespace quic
+}  // namespace owt
@@ -0,0 +1,576 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+// Measures stream goodput, datagram rate, message latency and CPU cost of an
+// in-process WebTransport server and clients over loopback. Each client
+// session opens `streams` bidirectional streams to the echo endpoint, and
+// keeps `pipeline` messages of `message_size` bytes in flight on each of them.
+// Latency is measured from writing a message to reading its echo. The net_*
+// flags emulate delay, loss, reordering and bandwidth limits on both
+// directions, see NetworkEmulationOptions.
+
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "base/bind.h"
+#include "base/files/file_path.h"
+#include "base/process/process_metrics.h"
+#include "base/strings/strcat.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/synchronization/lock.h"
+#include "base/synchronization/waitable_event.h"
+#include "base/threading/platform_thread.h"
+#include "base/threading/thread.h"
+#include "base/time/time.h"
+#include "impl/web_transport_owt_client_impl.h"
+#include "net/proxy_resolution/configured_proxy_resolution_service.h"
+#include "net/quic/platform/impl/quic_chromium_clock.h"
+#include "net/quic/web_transport_client.h"
+#include "net/test/test_data_directory.h"
+#include "net/third_party/quiche/src/quic/core/quic_simple_buffer_allocator.h"
+#include "net/third_party/quiche/src/quic/platform/api/quic_flags.h"
+#include "net/third_party/quiche/src/quic/platform/api/quic_system_event_loop.h"
+#include "net/url_request/url_request_context.h"
+#include "net/url_request/url_request_context_builder.h"
+#include "owt/quic/web_transport_factory.h"
+#include "owt/quic/web_transport_server_interface.h"
+
+DEFINE_QUIC_COMMAND_LINE_FLAG(int32_t, port, 20002, "Server port.");
+DEFINE_QUIC_COMMAND_LINE_FLAG(int32_t,
+                              io_threads,
+                              1,
+                              "Number of server IO threads.");
+DEFINE_QUIC_COMMAND_LINE_FLAG(int32_t,
+                              sessions,
+                              1,
+                              "Number of client sessions.");
+DEFINE_QUIC_COMMAND_LINE_FLAG(int32_t,
+                              streams,
+                              1,
+                              "Number of bidirectional streams per session.");
+DEFINE_QUIC_COMMAND_LINE_FLAG(int32_t,
+                              message_size,
+                              1024,
+                              "Size of each message written to a stream.");
+DEFINE_QUIC_COMMAND_LINE_FLAG(int32_t,
+                              pipeline,
+                              1,
+                              "Messages in flight per stream.");
+DEFINE_QUIC_COMMAND_LINE_FLAG(int32_t,
+                              datagram_size,
+                              0,
+                              "Size of datagrams sent by each session. 0 "
+                              "disables datagrams.");
+DEFINE_QUIC_COMMAND_LINE_FLAG(int32_t,
+                              datagrams_per_ms,
+                              10,
+                              "Datagrams sent by each session per "
+                              "millisecond.");
+DEFINE_QUIC_COMMAND_LINE_FLAG(int32_t,
+                              duration_s,
+                              10,
+                              "Duration of the measurement in seconds.");
+DEFINE_QUIC_COMMAND_LINE_FLAG(int32_t,
+                              net_delay_ms,
+                              0,
+                              "Emulated one way delay of each direction.");
+DEFINE_QUIC_COMMAND_LINE_FLAG(int32_t,
+                              net_jitter_ms,
+                              0,
+                              "Emulated jitter of each direction.");
+DEFINE_QUIC_COMMAND_LINE_FLAG(double,
+                              net_loss_rate,
+                              0,
+                              "Emulated random loss rate, 0.0 - 1.0.");
+DEFINE_QUIC_COMMAND_LINE_FLAG(double,
+                              net_burst_loss_rate,
+                              0,
+                              "Emulated probability of a burst loss starting "
+                              "at each packet, 0.0 - 1.0.");
+DEFINE_QUIC_COMMAND_LINE_FLAG(int32_t,
+                              net_burst_length,
+                              0,
+                              "Average packets dropped by each burst loss.");
+DEFINE_QUIC_COMMAND_LINE_FLAG(double,
+                              net_reorder_rate,
+                              0,
+                              "Emulated reordering rate, 0.0 - 1.0.");
+DEFINE_QUIC_COMMAND_LINE_FLAG(int32_t,
+                              net_bandwidth_kbps,
+                              0,
+                              "Emulated bandwidth of each direction. 0 is "
+                              "unlimited.");
+DEFINE_QUIC_COMMAND_LINE_FLAG(int32_t,
+                              net_queue_kb,
+                              0,
+                              "Emulated bottleneck queue size. 0 is "
+                              "unlimited.");
+DEFINE_QUIC_COMMAND_LINE_FLAG(int32_t,
+                              net_seed,
+                              0,
+                              "Seed of emulated losses and reordering.");
+
+namespace owt {
+namespace quic {
+namespace test {
+namespace {
+
+// Same as the one in web_transport_owt_end_to_end_test.cc. quic-short-lived.pem
+// is only valid around this time.
+constexpr uint64_t kCertificateValidUnixSeconds = 1591389300;
+constexpr char kCertificateFingerprint[] =
+    "ED:3D:D7:C3:67:10:94:68:D1:DC:D1:26:5C:B2:74:D7:1C:A2:63:3E:94:94:C0:84:"
+    "39:D6:64:FA:08:B9:77:37";
+
+// A clock that only mocks out WallNow(), so the test certificate is valid.
+class BenchmarkWallClock : public ::quic::QuicClock {
+ public:
+  ::quic::QuicTime Now() const override {
+    return ::quic::QuicChromiumClock::GetInstance()->Now();
+  }
+  ::quic::QuicTime ApproximateNow() const override {
+    return ::quic::QuicChromiumClock::GetInstance()->ApproximateNow();
+  }
+  ::quic::QuicWallTime WallNow() const override {
+    return ::quic::QuicWallTime::FromUNIXSeconds(kCertificateValidUnixSeconds);
+  }
+};
+
+class BenchmarkConnectionHelper
+    : public ::quic::QuicConnectionHelperInterface {
+ public:
+  const ::quic::QuicClock* GetClock() const override { return &clock_; }
+  ::quic::QuicRandom* GetRandomGenerator() override {
+    return ::quic::QuicRandom::GetInstance();
+  }
+  ::quic::QuicBufferAllocator* GetStreamSendBufferAllocator() override {
+    return &allocator_;
+  }
+
+ private:
+  BenchmarkWallClock clock_;
+  ::quic::SimpleBufferAllocator allocator_;
+};
+
+// Collects results from all streams and sessions. Methods could be called on
+// any thread.
+class BenchmarkRecorder {
+ public:
+  void OnMessageEchoed(base::TimeDelta latency, size_t bytes) {
+    base::AutoLock auto_lock(lock_);
+    latencies_us_.push_back(latency.InMicroseconds());
+    echoed_bytes_ += bytes;
+  }
+  void OnDatagramSent() { datagrams_sent_++; }
+  void OnDatagramReceived() { datagrams_received_++; }
+
+  void Report(base::TimeDelta duration, base::TimeDelta cpu_time) {
+    base::AutoLock auto_lock(lock_);
+    const double seconds = duration.InSecondsF();
+    std::sort(latencies_us_.begin(), latencies_us_.end());
+    std::cout << "messages: " << latencies_us_.size() << std::endl;
+    std::cout << "stream_goodput_mbps: "
+              << echoed_bytes_ * 8 / seconds / 1000000 << std::endl;
+    std::cout << "latency_p50_us: " << Percentile(0.5) << std::endl;
+    std::cout << "latency_p99_us: " << Percentile(0.99) << std::endl;
+    std::cout << "latency_p999_us: " << Percentile(0.999) << std::endl;
+    std::cout << "datagrams_sent_per_second: " << datagrams_sent_ / seconds
+              << std::endl;
+    std::cout << "datagrams_received_per_second: "
+              << datagrams_received_ / seconds << std::endl;
+    // Server and clients run in the same process, so it's the cost of both
+    // ends. Echoed data crosses loopback twice.
+    const uint64_t bytes_transferred = 2 * echoed_bytes_;
+    if (bytes_transferred > 0) {
+      std::cout << "cpu_seconds_per_gb: "
+                << cpu_time.InSecondsF() * 1000000000 / bytes_transferred
+                << std::endl;
+    }
+  }
+
+ private:
+  int64_t Percentile(double percentile) const {
+    if (latencies_us_.empty()) {
+      return 0;
+    }
+    size_t index = static_cast<size_t>(percentile * latencies_us_.size());
+    return latencies_us_[std::min(index, latencies_us_.size() - 1)];
+  }
+
+  base::Lock lock_;
+  std::vector<int64_t> latencies_us_;
+  uint64_t echoed_bytes_ = 0;
+  std::atomic<uint64_t> datagrams_sent_{0};
+  std::atomic<uint64_t> datagrams_received_{0};
+};
+
+// Echoes streams and counts datagrams on the server side.
+class BenchmarkServerStreamVisitor : public WebTransportStreamInterface::Visitor {
+ public:
+  explicit BenchmarkServerStreamVisitor(WebTransportStreamInterface* stream)
+      : stream_(stream), buffer_(64 * 1024) {}
+  void OnCanRead() override {
+    size_t read;
+    while ((read = stream_->Read(buffer_.data(), buffer_.size())) > 0) {
+      stream_->Write(buffer_.data(), read);
+    }
+  }
+  void OnCanWrite() override {}
+  void OnFinRead() override {}
+
+ private:
+  WebTransportStreamInterface* stream_;
+  std::vector<uint8_t> buffer_;
+};
+
+class BenchmarkServerSessionVisitor
+    : public WebTransportSessionInterface::Visitor {
+ public:
+  explicit BenchmarkServerSessionVisitor(BenchmarkRecorder* recorder)
+      : recorder_(recorder) {}
+  void OnIncomingStream(WebTransportStreamInterface* stream) override {
+    auto visitor = std::make_unique<BenchmarkServerStreamVisitor>(stream);
+    stream->SetVisitor(visitor.get());
+    stream_visitors_.push_back(std::move(visitor));
+  }
+  void OnCanCreateNewOutgoingStream(bool) override {}
+  void OnConnectionClosed() override {}
+  void OnDatagramReceived(const uint8_t*, size_t) override {
+    recorder_->OnDatagramReceived();
+  }
+
+ private:
+  BenchmarkRecorder* recorder_;
+  std::vector<std::unique_ptr<BenchmarkServerStreamVisitor>> stream_visitors_;
+};
+
+class BenchmarkServerVisitor : public WebTransportServerInterface::Visitor {
+ public:
+  explicit BenchmarkServerVisitor(BenchmarkRecorder* recorder)
+      : recorder_(recorder) {}
+  void OnEnded() override {}
+  void OnSession(WebTransportSessionInterface* session) override {
+    auto visitor = std::make_unique<BenchmarkServerSessionVisitor>(recorder_);
+    session->SetVisitor(visitor.get());
+    session_visitors_.push_back(std::move(visitor));
+  }
+
+ private:
+  BenchmarkRecorder* recorder_;
+  std::vector<std::unique_ptr<BenchmarkServerSessionVisitor>>
+      session_visitors_;
+};
+
+// Writes messages to a client stream and measures their round trip time.
+class BenchmarkStreamDriver : public WebTransportStreamInterface::Visitor {
+ public:
+  BenchmarkStreamDriver(WebTransportStreamInterface* stream,
+                        size_t message_size,
+                        const std::atomic<bool>* running,
+                        BenchmarkRecorder* recorder)
+      : stream_(stream),
+        message_(message_size, 'm'),
+        read_buffer_(64 * 1024),
+        running_(running),
+        recorder_(recorder),
+        pending_bytes_(0) {}
+
+  void Start(size_t pipeline) {
+    for (size_t i = 0; i < pipeline; i++) {
+      SendMessage();
+    }
+  }
+
+  void OnCanRead() override {
+    size_t read;
+    while ((read = stream_->Read(read_buffer_.data(), read_buffer_.size())) >
+           0) {
+      pending_bytes_ += read;
+      while (pending_bytes_ >= message_.size() && !send_times_.empty()) {
+        pending_bytes_ -= message_.size();
+        recorder_->OnMessageEchoed(
+            base::TimeTicks::Now() - send_times_.front(), message_.size());
+        send_times_.pop_front();
+        if (running_->load(std::memory_order_relaxed)) {
+          SendMessage();
+        }
+      }
+    }
+  }
+  void OnCanWrite() override {}
+  void OnFinRead() override {}
+
+ private:
+  void SendMessage() {
+    send_times_.push_back(base::TimeTicks::Now());
+    stream_->WriteAsync(message_.data(), message_.size());
+  }
+
+  WebTransportStreamInterface* stream_;
+  const std::vector<uint8_t> message_;
+  std::vector<uint8_t> read_buffer_;
+  const std::atomic<bool>* running_;
+  BenchmarkRecorder* recorder_;
+  // Send time of each message whose echo is not fully received.
+  std::deque<base::TimeTicks> send_times_;
+  // Bytes received for the oldest message in flight.
+  size_t pending_bytes_;
+};
+
+class BenchmarkClientVisitor : public WebTransportClientInterface::Visitor {
+ public:
+  BenchmarkClientVisitor(std::atomic<int>* pending_connections,
+                         base::WaitableEvent* all_connected)
+      : pending_connections_(pending_connections),
+        all_connected_(all_connected) {}
+  void OnConnected() override { OnConnectionDone(); }
+  void OnConnectionFailed() override {
+    LOG(ERROR) << "Benchmark client failed to connect.";
+    OnConnectionDone();
+  }
+  void OnIncomingStream(WebTransportStreamInterface*) override {}
+  void OnDatagramProcessed(MessageStatus) override {}
+  void OnClosed(uint32_t, const char*) override {}
+
+ private:
+  void OnConnectionDone() {
+    if (pending_connections_->fetch_sub(1) == 1) {
+      all_connected_->Signal();
+    }
+  }
+
+  std::atomic<int>* pending_connections_;
+  base::WaitableEvent* all_connected_;
+};
+
+// Sends datagrams of all sessions on `runner` at a fixed rate until
+// `running` becomes false.
+void SendDatagrams(std::vector<WebTransportClientInterface*> clients,
+                   size_t datagram_size,
+                   size_t datagrams_per_ms,
+                   scoped_refptr<base::SingleThreadTaskRunner> runner,
+                   const std::atomic<bool>* running,
+                   BenchmarkRecorder* recorder) {
+  if (!running->load(std::memory_order_relaxed)) {
+    return;
+  }
+  std::vector<uint8_t> datagram(datagram_size, 'd');
+  for (WebTransportClientInterface* client : clients) {
+    for (size_t i = 0; i < datagrams_per_ms; i++) {
+      if (client->SendOrQueueDatagram(datagram.data(), datagram.size()) ==
+          MessageStatus::kSuccess) {
+        recorder->OnDatagramSent();
+      }
+    }
+  }
+  runner->PostDelayedTask(
+      FROM_HERE,
+      base::BindOnce(&SendDatagrams, std::move(clients), datagram_size,
+                     datagrams_per_ms, runner, running, recorder),
+      base::Milliseconds(1));
+}
+
+void InitContextOnIOThread(std::unique_ptr<net::URLRequestContext>* context,
+                           base::WaitableEvent* event) {
+  net::URLRequestContextBuilder builder;
+  builder.set_proxy_resolution_service(
+      net::ConfiguredProxyResolutionService::CreateDirect());
+  auto quic_context = std::make_unique<net::QuicContext>(
+      std::make_unique<BenchmarkConnectionHelper>());
+  quic_context->params()->origins_to_force_quic_on.insert(
+      net::HostPortPair("test.example.com", 0));
+  builder.set_quic_context(std::move(quic_context));
+  *context = builder.Build();
+  event->Signal();
+}
+
+int RunBenchmark() {
+  const int port = GetQuicFlag(FLAGS_port);
+  const size_t sessions = std::max(1, GetQuicFlag(FLAGS_sessions));
+  const size_t streams = std::max(0, GetQuicFlag(FLAGS_streams));
+  const size_t message_size = std::max(1, GetQuicFlag(FLAGS_message_size));
+  const size_t pipeline = std::max(1, GetQuicFlag(FLAGS_pipeline));
+  const size_t datagram_size = std::max(0, GetQuicFlag(FLAGS_datagram_size));
+  const size_t datagrams_per_ms =
+      std::max(0, GetQuicFlag(FLAGS_datagrams_per_ms));
+  const base::TimeDelta duration =
+      base::Seconds(std::max(1, GetQuicFlag(FLAGS_duration_s)));
+  // Both directions are emulated with the same conditions.
+  NetworkEmulationOptions emulation;
+  emulation.delay_ms = std::max(0, GetQuicFlag(FLAGS_net_delay_ms));
+  emulation.jitter_ms = std::max(0, GetQuicFlag(FLAGS_net_jitter_ms));
+  emulation.loss_rate = GetQuicFlag(FLAGS_net_loss_rate);
+  emulation.burst_loss_rate = GetQuicFlag(FLAGS_net_burst_loss_rate);
+  emulation.burst_length = std::max(0, GetQuicFlag(FLAGS_net_burst_length));
+  emulation.reorder_rate = GetQuicFlag(FLAGS_net_reorder_rate);
+  emulation.bandwidth_bps =
+      uint64_t{1000} * std::max(0, GetQuicFlag(FLAGS_net_bandwidth_kbps));
+  emulation.queue_bytes = 1024 * std::max(0, GetQuicFlag(FLAGS_net_queue_kb));
+  emulation.seed = std::max(0, GetQuicFlag(FLAGS_net_seed));
+  const bool emulate_network =
+      emulation.delay_ms > 0 || emulation.jitter_ms > 0 ||
+      emulation.loss_rate > 0 || emulation.burst_loss_rate > 0 ||
+      emulation.reorder_rate > 0 || emulation.bandwidth_bps > 0;
+
+  base::Thread io_thread("web_transport_benchmark_io_thread");
+  io_thread.StartWithOptions(
+      base::Thread::Options(base::MessagePumpType::IO, 0));
+  base::Thread event_thread("web_transport_benchmark_event_thread");
+  event_thread.StartWithOptions(
+      base::Thread::Options(base::MessagePumpType::IO, 0));
+  std::unique_ptr<WebTransportFactory> factory(
+      WebTransportFactory::CreateForTesting());
+  BenchmarkRecorder recorder;
+
+  base::FilePath certs_dir = net::GetTestCertsDirectory();
+  WebTransportServerInterface::Options options;
+  if (emulate_network) {
+    options.network_emulation = &emulation;
+  }
+  std::unique_ptr<WebTransportServerInterface> server(
+      factory->CreateWebTransportServer(
+          port,
+          certs_dir.AppendASCII("quic-short-lived.pem").MaybeAsASCII().c_str(),
+          certs_dir.AppendASCII("quic-leaf-cert.key").MaybeAsASCII().c_str(),
+          certs_dir.AppendASCII("quic-leaf-cert.key.sct")
+              .MaybeAsASCII()
+              .c_str(),
+          options));
+  if (!server) {
+    LOG(ERROR) << "Failed to create server.";
+    return 1;
+  }
+  BenchmarkServerVisitor server_visitor(&recorder);
+  server->SetVisitor(&server_visitor);
+  server->SetIoThreadCount(std::max(1, GetQuicFlag(FLAGS_io_threads)));
+  if (server->Start() != 0) {
+    LOG(ERROR) << "Failed to start server.";
+    return 1;
+  }
+
+  std::unique_ptr<net::URLRequestContext> context;
+  base::WaitableEvent context_ready;
+  io_thread.task_runner()->PostTask(
+      FROM_HERE,
+      base::BindOnce(&InitContextOnIOThread, &context, &context_ready));
+  context_ready.Wait();
+
+  net::WebTransportParameters parameters;
+  parameters.server_certificate_fingerprints.push_back(
+      ::quic::CertificateFingerprint{
+          .algorithm = ::quic::CertificateFingerprint::kSha256,
+          .fingerprint = kCertificateFingerprint});
+  const GURL url(base::StrCat(
+      {"https://test.example.com:", base::NumberToString(port), "/echo"}));
+  std::atomic<int> pending_connections(static_cast<int>(sessions));
+  base::WaitableEvent all_connected;
+  BenchmarkClientVisitor client_visitor(&pending_connections, &all_connected);
+  std::vector<std::unique_ptr<WebTransportClientInterface>> clients;
+  for (size_t i = 0; i < sessions; i++) {
+    auto* client = new WebTransportOwtClientImpl(
+        url, url::Origin(), parameters, context.get(), &io_thread,
+        &event_thread);
+    if (emulate_network) {
+      // Each session has its own link.
+      NetworkEmulationOptions client_emulation = emulation;
+      client_emulation.seed += i + 1;
+      client->SetNetworkEmulation(client_emulation);
+    }
+    clients.emplace_back(client);
+    clients.back()->SetVisitor(&client_visitor);
+    clients.back()->Connect();
+  }
+  all_connected.Wait();
+
+  std::atomic<bool> running(true);
+  std::vector<std::unique_ptr<BenchmarkStreamDriver>> drivers;
+  std::vector<WebTransportClientInterface*> datagram_clients;
+  for (auto& client : clients) {
+    for (size_t i = 0; i < streams; i++) {
+      WebTransportStreamInterface* stream = client->CreateBidirectionalStream();
+      if (!stream) {
+        LOG(ERROR) << "Failed to create stream.";
+        break;
+      }
+      drivers.push_back(std::make_unique<BenchmarkStreamDriver>(
+          stream, message_size, &running, &recorder));
+      stream->SetVisitor(drivers.back().get());
+    }
+    datagram_clients.push_back(client.get());
+  }
+
+  std::unique_ptr<base::ProcessMetrics> metrics =
+      base::ProcessMetrics::CreateCurrentProcessMetrics();
+  const base::TimeDelta cpu_start = metrics->GetCumulativeCPUUsage();
+  const base::TimeTicks start = base::TimeTicks::Now();
+  // Streams are driven on the event thread once started.
+  event_thread.task_runner()->PostTask(
+      FROM_HERE, base::BindOnce(
+                     [](std::vector<std::unique_ptr<BenchmarkStreamDriver>>*
+                            drivers,
+                        size_t pipeline) {
+                       for (auto& driver : *drivers) {
+                         driver->Start(pipeline);
+                       }
+                     },
+                     &drivers, pipeline));
+  if (datagram_size > 0 && datagrams_per_ms > 0) {
+    event_thread.task_runner()->PostTask(
+        FROM_HERE,
+        base::BindOnce(&SendDatagrams, datagram_clients, datagram_size,
+                       datagrams_per_ms, event_thread.task_runner(), &running,
+                       &recorder));
+  }
+  base::PlatformThread::Sleep(duration);
+  running = false;
+  const base::TimeDelta elapsed = base::TimeTicks::Now() - start;
+  const base::TimeDelta cpu_time =
+      metrics->GetCumulativeCPUUsage() - cpu_start;
+
+  std::cout << "sessions: " << sessions << ", streams per session: "
+            << streams << ", message size: " << message_size
+            << ", pipeline: " << pipeline
+            << ", datagram size: " << datagram_size << std::endl;
+  recorder.Report(elapsed, cpu_time);
+
+  // Stops delivering events before drivers and clients are destroyed.
+  event_thread.Stop();
+  clients.clear();
+  base::WaitableEvent done;
+  io_thread.task_runner()->PostTask(
+      FROM_HERE, base::BindOnce(
+                     [](std::unique_ptr<net::URLRequestContext> context,
+                        std::unique_ptr<WebTransportServerInterface> server,
+                        base::WaitableEvent* event) {
+                       context.reset();
+                       server.reset();
+                       event->Signal();
+                     },
+                     std::move(context), std::move(server), &done));
+  done.Wait();
+  return 0;
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace quic
+}  // namespace owt
+
+int main(int argc, char* argv[]) {
+  QuicSystemEventLoop event_loop("web_transport_benchmark");
+  const char* usage = "Usage: owt_web_transport_benchmark [options]";
+  std::vector<std::string> non_option_args =
+      ::quic::QuicParseCommandLineFlags(usage, argc, argv);
+  if (!non_option_args.empty()) {
+    ::quic::QuicPrintCommandLineFlagHelp(usage);
+    exit(0);
+  }
+  return owt::quic::test::RunBenchmark();
+}
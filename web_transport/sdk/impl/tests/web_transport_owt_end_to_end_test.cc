@@ -8,7 +8,10 @@
  * Reference: net/third_party/quiche/src/quic/core/http/end_to_end_test.cc
  */
 
+#include "base/files/file.h"
 #include "base/files/file_path.h"
+#include "base/files/file_util.h"
+#include "base/files/scoped_temp_dir.h"
 #include "base/strings/strcat.h"
 #include "base/threading/thread.h"
 #include "impl/web_transport_owt_client_impl.h"
@@ -47,6 +50,10 @@ class StreamMockVisitor : public WebTransportStreamInterface::Visitor {
   MOCK_METHOD0(OnCanRead, void());
   MOCK_METHOD0(OnCanWrite, void());
   MOCK_METHOD0(OnFinRead, void());
+  MOCK_METHOD2(OnWriteCompleted, void(size_t, bool));
+  MOCK_METHOD3(OnDataReceived, void(const uint8_t*, size_t, bool));
+  MOCK_METHOD1(OnResetStreamReceived, void(uint8_t));
+  MOCK_METHOD1(OnStopSendingReceived, void(uint8_t));
 };
 
 // A clock that only mocks out WallNow(), but uses real Now() and
@@ -119,7 +126,9 @@ class WebTransportOwtEndToEndTest : public net::TestWithTaskEnvironment {
     factory_.reset();
   }
 
-  void StartEchoServer() {
+  void StartEchoServer(size_t io_thread_count = 1,
+                       const WebTransportServerInterface::Options& options =
+                           WebTransportServerInterface::Options()) {
     base::FilePath certs_dir = net::GetTestCertsDirectory();
     base::FilePath cert_path = certs_dir.AppendASCII("quic-short-lived.pem");
     base::FilePath key_path = certs_dir.AppendASCII("quic-leaf-cert.key");
@@ -141,14 +150,16 @@ class WebTransportOwtEndToEndTest : public net::TestWithTaskEnvironment {
         factory_->CreateWebTransportServer(port_,
 #if defined(OS_WIN)
                                            cert_path_char, key_path_char,
-                                           secret_path_char));
+                                           secret_path_char, options));
 #else
                                            cert_path.value().c_str(),
                                            key_path.value().c_str(),
-                                           secret_path.value().c_str()));
+                                           secret_path.value().c_str(),
+                                           options));
 #endif
     server_visitor_ = std::make_unique<ServerEchoVisitor>();
     server_->SetVisitor(server_visitor_.get());
+    server_->SetIoThreadCount(io_thread_count);
     server_->Start();
   }
 
@@ -180,14 +191,18 @@ class WebTransportOwtEndToEndTest : public net::TestWithTaskEnvironment {
     event->Signal();
   }
 
+  // Clients created by a test share `context_`.
   std::unique_ptr<WebTransportClientInterface> CreateClient(const GURL& url) {
-    base::WaitableEvent done(base::WaitableEvent::ResetPolicy::AUTOMATIC,
-                             base::WaitableEvent::InitialState::NOT_SIGNALED);
-    io_thread_->task_runner()->PostTask(
-        FROM_HERE,
-        base::BindOnce(&WebTransportOwtEndToEndTest::InitContextOnIOThread,
-                       base::Unretained(this), &done));
-    done.Wait();
+    if (!context_) {
+      base::WaitableEvent done(
+          base::WaitableEvent::ResetPolicy::AUTOMATIC,
+          base::WaitableEvent::InitialState::NOT_SIGNALED);
+      io_thread_->task_runner()->PostTask(
+          FROM_HERE,
+          base::BindOnce(&WebTransportOwtEndToEndTest::InitContextOnIOThread,
+                         base::Unretained(this), &done));
+      done.Wait();
+    }
     net::WebTransportParameters parameters;
     parameters.server_certificate_fingerprints.push_back(
         ::quic::CertificateFingerprint{
@@ -203,6 +218,28 @@ class WebTransportOwtEndToEndTest : public net::TestWithTaskEnvironment {
                                       io_thread_.get(), event_thread_.get()));
   }
 
+  // Sets `visitor_` as `client_`'s visitor, and waits for `client_` to
+  // connect.
+  void ConnectClient() {
+    client_->SetVisitor(&visitor_);
+    EXPECT_CALL(visitor_, OnConnected()).WillOnce(StopRunning());
+    client_->Connect();
+    Run();
+  }
+
+  // Writes a few bytes to `stream` of an echo session, and checks they are
+  // read back. `stream_visitor` must be `stream`'s visitor.
+  void ExpectEcho(WebTransportStreamInterface* stream,
+                  StreamMockVisitor* stream_visitor) {
+    const uint8_t data[] = {1, 2, 3, 4};
+    EXPECT_CALL(*stream_visitor, OnCanRead()).WillOnce(StopRunning());
+    EXPECT_EQ(stream->Write(data, sizeof(data)), sizeof(data));
+    Run();
+    uint8_t read_buffer[sizeof(data)];
+    EXPECT_EQ(stream->Read(read_buffer, sizeof(read_buffer)), sizeof(data));
+    EXPECT_EQ(memcmp(read_buffer, data, sizeof(data)), 0);
+  }
+
  protected:
   std::unique_ptr<base::Thread> io_thread_;
   std::unique_ptr<base::Thread> event_thread_;
@@ -221,12 +258,165 @@ class WebTransportOwtEndToEndTest : public net::TestWithTaskEnvironment {
 TEST_F(WebTransportOwtEndToEndTest, Connect) {
   StartEchoServer();
   client_ = CreateClient(GetServerUrl("/discard"));
-  client_->SetVisitor(&visitor_);
-  EXPECT_CALL(visitor_, OnConnected()).WillOnce(StopRunning());
-  client_->Connect();
+  ConnectClient();
+}
+
+#if defined(OS_LINUX) || defined(OS_CHROMEOS)
+TEST_F(WebTransportOwtEndToEndTest, EchoWithMultipleIoThreads) {
+  StartEchoServer(/*io_thread_count=*/4);
+  client_ = CreateClient(GetServerUrl("/echo"));
+  ConnectClient();
+  StreamMockVisitor stream_visitor;
+  auto* stream = client_->CreateBidirectionalStream();
+  ASSERT_TRUE(stream != nullptr);
+  stream->SetVisitor(&stream_visitor);
+  ExpectEcho(stream, &stream_visitor);
+}
+
+// Data larger than a budget of reads, so the client reads in several passes.
+TEST_F(WebTransportOwtEndToEndTest, EchoWithBatchPacketReads) {
+  StartEchoServer();
+  client_ = CreateClient(GetServerUrl("/echo"));
+  static_cast<WebTransportOwtClientImpl*>(client_.get())
+      ->SetBatchPacketReads(true, /*max_packets_per_read=*/2);
+  ConnectClient();
+  StreamMockVisitor stream_visitor;
+  auto* stream = client_->CreateBidirectionalStream();
+  ASSERT_TRUE(stream != nullptr);
+  stream->SetVisitor(&stream_visitor);
+  stream->SetPushModeEnabled(true);
+  std::vector<uint8_t> data(64 * 1024);
+  for (size_t i = 0; i < data.size(); i++) {
+    data[i] = static_cast<uint8_t>(i);
+  }
+  std::vector<uint8_t> data_received;
+  EXPECT_CALL(stream_visitor, OnDataReceived(testing::_, testing::_, false))
+      .WillRepeatedly([&](const uint8_t* received, size_t length, bool fin) {
+        data_received.insert(data_received.end(), received, received + length);
+        if (data_received.size() == data.size()) {
+          run_loop_->Quit();
+        }
+      });
+  EXPECT_EQ(stream->Write(data.data(), data.size()), data.size());
   Run();
+  EXPECT_EQ(data, data_received);
+}
+#endif
+
+TEST_F(WebTransportOwtEndToEndTest, EchoWithServerOptions) {
+  WebTransportServerInterface::Options options;
+  options.socket_receive_buffer_size = 4 * 1024 * 1024;
+  options.socket_send_buffer_size = 4 * 1024 * 1024;
+  options.initial_stream_flow_control_window = 256 * 1024;
+  options.initial_session_flow_control_window = 4 * 1024 * 1024;
+  options.max_incoming_bidirectional_streams = 10;
+  options.idle_timeout_ms = 5000;
+  options.max_packets_per_read = 4;
+  options.max_new_connections_per_read = 1;
+  options.event_thread_count = 4;
+  options.signing_thread_count = 2;
+  StartEchoServer(/*io_thread_count=*/1, options);
+  client_ = CreateClient(GetServerUrl("/echo"));
+  ConnectClient();
+  StreamMockVisitor stream_visitor;
+  auto* stream = client_->CreateBidirectionalStream();
+  ASSERT_TRUE(stream != nullptr);
+  stream->SetVisitor(&stream_visitor);
+  ExpectEcho(stream, &stream_visitor);
 }
 
+TEST_F(WebTransportOwtEndToEndTest, EchoWithInlineEventDispatch) {
+  WebTransportServerInterface::Options options;
+  options.inline_event_dispatch = true;
+  StartEchoServer(/*io_thread_count=*/1, options);
+  client_ = CreateClient(GetServerUrl("/echo"));
+  ConnectClient();
+  StreamMockVisitor stream_visitor;
+  auto* stream = client_->CreateBidirectionalStream();
+  ASSERT_TRUE(stream != nullptr);
+  stream->SetVisitor(&stream_visitor);
+  ExpectEcho(stream, &stream_visitor);
+}
+
+TEST_F(WebTransportOwtEndToEndTest, EchoOverEmulatedNetwork) {
+  NetworkEmulationOptions emulation;
+  emulation.delay_ms = 20;
+  emulation.jitter_ms = 5;
+  emulation.loss_rate = 0.05;
+  emulation.reorder_rate = 0.01;
+  emulation.bandwidth_bps = 10 * 1000 * 1000;
+  emulation.queue_bytes = 64 * 1024;
+  emulation.seed = 1;
+  WebTransportServerInterface::Options options;
+  options.network_emulation = &emulation;
+  StartEchoServer(/*io_thread_count=*/1, options);
+  client_ = CreateClient(GetServerUrl("/echo"));
+  static_cast<WebTransportOwtClientImpl*>(client_.get())
+      ->SetNetworkEmulation(emulation);
+  ConnectClient();
+  StreamMockVisitor stream_visitor;
+  auto* stream = client_->CreateBidirectionalStream();
+  ASSERT_TRUE(stream != nullptr);
+  stream->SetVisitor(&stream_visitor);
+  ExpectEcho(stream, &stream_visitor);
+}
+
+TEST_F(WebTransportOwtEndToEndTest, EchoAfterRetry) {
+  WebTransportServerInterface::Options options;
+  options.retry_chlo_rate_threshold = 1;
+  StartEchoServer(/*io_thread_count=*/1, options);
+  client_ = CreateClient(GetServerUrl("/echo"));
+  ConnectClient();
+  StreamMockVisitor stream_visitor;
+  auto* stream = client_->CreateBidirectionalStream();
+  ASSERT_TRUE(stream != nullptr);
+  stream->SetVisitor(&stream_visitor);
+  ExpectEcho(stream, &stream_visitor);
+  const ServerStats stats = server_->GetServerStats();
+  EXPECT_GE(stats.retries_sent, 1u);
+  EXPECT_EQ(stats.invalid_retry_tokens, 0u);
+}
+
+TEST_F(WebTransportOwtEndToEndTest, EchoAfterConnectionMigration) {
+  StartEchoServer();
+  client_ = CreateClient(GetServerUrl("/echo"));
+  ConnectClient();
+  StreamMockVisitor stream_visitor;
+  auto* stream = client_->CreateBidirectionalStream();
+  ASSERT_TRUE(stream != nullptr);
+  stream->SetVisitor(&stream_visitor);
+  // The stream keeps working while the new path is validated. The client
+  // switches to it once validation succeeds, so data is echoed until the
+  // server sees the new address.
+  client_->MigrateConnection();
+  for (int i = 0; i < 50 && server_->GetServerStats().peer_migrations == 0;
+       i++) {
+    ExpectEcho(stream, &stream_visitor);
+  }
+  EXPECT_EQ(server_->GetServerStats().peer_migrations, 1u);
+}
+
+#if defined(OS_LINUX) || defined(OS_CHROMEOS)
+// The new path may reach another worker, which steers packets by connection
+// IDs issued after the handshake to the connection's worker.
+TEST_F(WebTransportOwtEndToEndTest,
+       EchoAfterConnectionMigrationWithMultipleIoThreads) {
+  StartEchoServer(/*io_thread_count=*/4);
+  client_ = CreateClient(GetServerUrl("/echo"));
+  ConnectClient();
+  StreamMockVisitor stream_visitor;
+  auto* stream = client_->CreateBidirectionalStream();
+  ASSERT_TRUE(stream != nullptr);
+  stream->SetVisitor(&stream_visitor);
+  client_->MigrateConnection();
+  for (int i = 0; i < 50 && server_->GetServerStats().peer_migrations == 0;
+       i++) {
+    ExpectEcho(stream, &stream_visitor);
+  }
+  EXPECT_EQ(server_->GetServerStats().peer_migrations, 1u);
+}
+#endif
+
 TEST_F(WebTransportOwtEndToEndTest, InvalidCertificate) {
   StartEchoServer();
   std::unique_ptr<WebTransportClientInterface> client =
@@ -239,13 +429,58 @@ TEST_F(WebTransportOwtEndToEndTest, InvalidCertificate) {
   Run();
 }
 
+TEST_F(WebTransportOwtEndToEndTest, ConnectClientsInParallel) {
+  StartEchoServer();
+  const GURL url = GetServerUrl("/discard");
+  std::unique_ptr<WebTransportClientInterface> client1 = CreateClient(url);
+  std::unique_ptr<WebTransportClientInterface> client2 = CreateClient(url);
+  ClientMockVisitor visitor1;
+  ClientMockVisitor visitor2;
+  client1->SetVisitor(&visitor1);
+  client2->SetVisitor(&visitor2);
+  // Connect() returns before the connection is established, so both
+  // handshakes run at the same time on the shared context.
+  int connected = 0;
+  auto on_connected = [&]() {
+    if (++connected == 2) {
+      run_loop_->Quit();
+    }
+  };
+  EXPECT_CALL(visitor1, OnConnected()).WillOnce(on_connected);
+  EXPECT_CALL(visitor2, OnConnected()).WillOnce(on_connected);
+  EXPECT_CALL(visitor1, OnConnectionFailed()).Times(0);
+  EXPECT_CALL(visitor2, OnConnectionFailed()).Times(0);
+  client1->Connect();
+  client2->Connect();
+  Run();
+  EXPECT_EQ(connected, 2);
+  client1.reset();
+  client2.reset();
+}
+
+TEST_F(WebTransportOwtEndToEndTest, ConnectFactoryClientsInParallel) {
+  StartEchoServer();
+  const std::string url = GetServerUrl("/discard").spec();
+  // The first client creates the shared context on the IO thread.
+  std::unique_ptr<WebTransportClientInterface> client1(
+      factory_->CreateWebTransportClient(url.c_str()));
+  std::unique_ptr<WebTransportClientInterface> client2(
+      factory_->CreateWebTransportClient(url.c_str()));
+  client1->SetVisitor(&visitor_);
+  client2->SetVisitor(&visitor_);
+  // The factory's context doesn't trust the test certificate, so both fail.
+  EXPECT_CALL(visitor_, OnConnectionFailed())
+      .WillOnce(testing::Return())
+      .WillOnce(StopRunning());
+  client1->Connect();
+  client2->Connect();
+  Run();
+}
+
 TEST_F(WebTransportOwtEndToEndTest, EchoBidirectionalStream) {
   StartEchoServer();
   client_ = CreateClient(GetServerUrl("/echo"));
-  client_->SetVisitor(&visitor_);
-  EXPECT_CALL(visitor_, OnConnected()).WillOnce(StopRunning());
-  client_->Connect();
-  Run();
+  ConnectClient();
   StreamMockVisitor stream_visitor;
   auto* stream = client_->CreateBidirectionalStream();
   EXPECT_TRUE(stream != nullptr);
@@ -266,13 +501,187 @@ TEST_F(WebTransportOwtEndToEndTest, EchoBidirectionalStream) {
   }
 }
 
-TEST_F(WebTransportOwtEndToEndTest, ClientSendsDatagram) {
+TEST_F(WebTransportOwtEndToEndTest, EchoBidirectionalStreamAsyncWrite) {
   StartEchoServer();
   client_ = CreateClient(GetServerUrl("/echo"));
-  client_->SetVisitor(&visitor_);
-  EXPECT_CALL(visitor_, OnConnected()).WillOnce(StopRunning());
-  client_->Connect();
+  ConnectClient();
+  StreamMockVisitor stream_visitor;
+  auto* stream = client_->CreateBidirectionalStream();
+  EXPECT_TRUE(stream != nullptr);
+  stream->SetVisitor(&stream_visitor);
+  size_t data_size = 10;
+  std::vector<uint8_t> data(data_size);
+  for (size_t i = 0; i < data_size; i++) {
+    data[i] = i;
+  }
+  EXPECT_CALL(stream_visitor, OnWriteCompleted(data_size, true)).Times(1);
+  EXPECT_CALL(stream_visitor, OnCanRead()).WillOnce(StopRunning());
+  stream->WriteAsync(data.data(), data_size);
+  // Data has been copied by WriteAsync.
+  std::vector<uint8_t> expected(data);
+  data.clear();
   Run();
+  EXPECT_EQ(stream->ReadableBytes(), data_size);
+  std::vector<uint8_t> data_read(data_size);
+  stream->Read(data_read.data(), data_size);
+  EXPECT_EQ(expected, data_read);
+}
+
+TEST_F(WebTransportOwtEndToEndTest, StopSendingResetsRemoteWriteSide) {
+  StartEchoServer();
+  client_ = CreateClient(GetServerUrl("/echo"));
+  ConnectClient();
+  StreamMockVisitor stream_visitor;
+  auto* stream = client_->CreateBidirectionalStream();
+  ASSERT_TRUE(stream != nullptr);
+  stream->SetVisitor(&stream_visitor);
+  EXPECT_CALL(stream_visitor, OnCanRead()).WillRepeatedly(testing::Return());
+  const uint8_t data[] = {1, 2, 3};
+  EXPECT_EQ(sizeof(data), stream->Write(data, sizeof(data)));
+  // Server resets its write side in response to STOP_SENDING.
+  EXPECT_CALL(stream_visitor, OnResetStreamReceived(testing::_))
+      .WillOnce(StopRunning());
+  stream->StopSending(7);
+  Run();
+  // Reset abandons the write side, so writes are refused afterwards.
+  stream->Reset(8);
+  EXPECT_CALL(stream_visitor, OnWriteCompleted(sizeof(data), false))
+      .WillOnce(StopRunning());
+  stream->WriteAsync(data, sizeof(data));
+  Run();
+}
+
+TEST_F(WebTransportOwtEndToEndTest, EchoBidirectionalStreamWritev) {
+  StartEchoServer();
+  client_ = CreateClient(GetServerUrl("/echo"));
+  ConnectClient();
+  StreamMockVisitor stream_visitor;
+  auto* stream = client_->CreateBidirectionalStream();
+  EXPECT_TRUE(stream != nullptr);
+  stream->SetVisitor(&stream_visitor);
+  std::vector<uint8_t> header = {0, 1};
+  std::vector<uint8_t> payload = {2, 3, 4, 5, 6, 7, 8, 9};
+  IoVec iov[] = {{header.data(), header.size()},
+                 {payload.data(), payload.size()}};
+  size_t data_size = header.size() + payload.size();
+  EXPECT_CALL(stream_visitor, OnWriteCompleted(data_size, true)).Times(1);
+  EXPECT_CALL(stream_visitor, OnCanRead()).WillOnce(StopRunning());
+  stream->Writev(iov, 2, false);
+  Run();
+  EXPECT_EQ(stream->ReadableBytes(), data_size);
+  std::vector<uint8_t> data_read(data_size);
+  stream->Read(data_read.data(), data_size);
+  for (size_t i = 0; i < data_size; i++) {
+    EXPECT_EQ(i, data_read[i]);
+  }
+}
+
+TEST_F(WebTransportOwtEndToEndTest, EchoBidirectionalStreamPushMode) {
+  StartEchoServer();
+  client_ = CreateClient(GetServerUrl("/echo"));
+  ConnectClient();
+  StreamMockVisitor stream_visitor;
+  auto* stream = client_->CreateBidirectionalStream();
+  EXPECT_TRUE(stream != nullptr);
+  stream->SetVisitor(&stream_visitor);
+  stream->SetPushModeEnabled(true);
+  size_t data_size = 10;
+  std::vector<uint8_t> data(data_size);
+  for (size_t i = 0; i < data_size; i++) {
+    data[i] = i;
+  }
+  std::vector<uint8_t> data_received;
+  EXPECT_CALL(stream_visitor, OnCanRead()).Times(0);
+  EXPECT_CALL(stream_visitor, OnDataReceived(testing::_, testing::_, false))
+      .WillRepeatedly([&](const uint8_t* received, size_t length, bool fin) {
+        data_received.insert(data_received.end(), received, received + length);
+        if (data_received.size() == data_size) {
+          run_loop_->Quit();
+        }
+      });
+  EXPECT_EQ(stream->Write(data.data(), data_size), data_size);
+  Run();
+  EXPECT_EQ(data, data_received);
+}
+
+#if defined(OS_POSIX)
+TEST_F(WebTransportOwtEndToEndTest, EchoBidirectionalStreamWriteFile) {
+  StartEchoServer();
+  client_ = CreateClient(GetServerUrl("/echo"));
+  ConnectClient();
+  // Several chunks, the last of which is partial.
+  const size_t file_size = 200 * 1024 + 7;
+  const size_t offset = 3;
+  std::string content(file_size, '\0');
+  for (size_t i = 0; i < file_size; i++) {
+    content[i] = static_cast<char>(i % 251);
+  }
+  base::ScopedTempDir temp_dir;
+  ASSERT_TRUE(temp_dir.CreateUniqueTempDir());
+  base::FilePath path = temp_dir.GetPath().AppendASCII("write_file");
+  ASSERT_TRUE(base::WriteFile(path, content));
+  base::File file(path, base::File::FLAG_OPEN | base::File::FLAG_READ);
+  ASSERT_TRUE(file.IsValid());
+  StreamMockVisitor stream_visitor;
+  auto* stream = client_->CreateBidirectionalStream();
+  ASSERT_TRUE(stream != nullptr);
+  stream->SetVisitor(&stream_visitor);
+  stream->SetPushModeEnabled(true);
+  const size_t length = file_size - offset;
+  // Both callbacks run on the event thread.
+  bool write_completed = false;
+  std::vector<uint8_t> data_received;
+  auto quit_when_done = [&]() {
+    if (write_completed && data_received.size() == length) {
+      run_loop_->Quit();
+    }
+  };
+  EXPECT_CALL(stream_visitor, OnWriteCompleted(length, true))
+      .WillOnce([&](size_t, bool) {
+        write_completed = true;
+        quit_when_done();
+      });
+  EXPECT_CALL(stream_visitor, OnDataReceived(testing::_, testing::_, false))
+      .WillRepeatedly([&](const uint8_t* received, size_t size, bool fin) {
+        data_received.insert(data_received.end(), received, received + size);
+        quit_when_done();
+      });
+  stream->WriteFile(file.GetPlatformFile(), offset, length, false);
+  Run();
+  EXPECT_EQ(std::vector<uint8_t>(content.begin() + offset, content.end()),
+            data_received);
+}
+
+TEST_F(WebTransportOwtEndToEndTest, WriteFileReadErrorResetsStream) {
+  StartEchoServer();
+  client_ = CreateClient(GetServerUrl("/echo"));
+  ConnectClient();
+  base::ScopedTempDir temp_dir;
+  ASSERT_TRUE(temp_dir.CreateUniqueTempDir());
+  base::FilePath path = temp_dir.GetPath().AppendASCII("short_file");
+  ASSERT_TRUE(base::WriteFile(path, std::string(1000, 'a')));
+  base::File file(path, base::File::FLAG_OPEN | base::File::FLAG_READ);
+  ASSERT_TRUE(file.IsValid());
+  StreamMockVisitor stream_visitor;
+  auto* stream = client_->CreateBidirectionalStream();
+  ASSERT_TRUE(stream != nullptr);
+  stream->SetVisitor(&stream_visitor);
+  EXPECT_CALL(stream_visitor, OnCanRead()).WillRepeatedly(testing::Return());
+  // The file is shorter than the range, so the first read fails and the
+  // stream is reset instead of sending truncated data.
+  const size_t length = 100 * 1024;
+  EXPECT_CALL(stream_visitor, OnWriteCompleted(length, false))
+      .WillOnce(StopRunning());
+  stream->WriteFile(file.GetPlatformFile(), 0, length, false);
+  Run();
+  EXPECT_FALSE(stream->CanWrite());
+}
+#endif
+
+TEST_F(WebTransportOwtEndToEndTest, ClientSendsDatagram) {
+  StartEchoServer();
+  client_ = CreateClient(GetServerUrl("/echo"));
+  ConnectClient();
   size_t data_size = 10;
   uint8_t* data = new uint8_t[data_size];
   for (size_t i = 0; i < data_size; i++) {
@@ -285,10 +694,7 @@ TEST_F(WebTransportOwtEndToEndTest, ClientSendsDatagram) {
 TEST_F(WebTransportOwtEndToEndTest, ClientOnClosed) {
   StartEchoServer();
   client_ = CreateClient(GetServerUrl("/echo"));
-  client_->SetVisitor(&visitor_);
-  EXPECT_CALL(visitor_, OnConnected()).WillOnce(StopRunning());
-  client_->Connect();
-  Run();
+  ConnectClient();
   EXPECT_EQ(server_visitor_->Sessions().size(), (unsigned long)1);
   EXPECT_CALL(visitor_, OnClosed(testing::_, testing::_))
       .WillOnce(StopRunning());
@@ -0,0 +1,715 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+// Runs an in-process WebTransport server and many client sessions over
+// loopback for a long time, and fails if memory grows or latency drifts
+// beyond thresholds. Each session keeps `streams_in_flight` messages in
+// flight, every message is sent on a new bidirectional stream which is closed
+// once its echo is received, so streams are created and destroyed at a high
+// rate. Streams are acquired from the warm stream pool when it's not empty.
+// Sessions also send datagrams at a fixed rate.
+//
+// Every `sample_interval_s` seconds, process RSS, malloc usage, memory held by
+// the server's sessions, live server streams and p99 message latency of the
+// interval are printed. After the run, the average of the first
+// `compare_samples` samples after `warmup_samples` is compared with the
+// average of the last `compare_samples` samples. The process exits with 1 if
+// any of them grows more than its threshold.
+
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "base/bind.h"
+#include "base/files/file_path.h"
+#include "base/process/process_metrics.h"
+#include "base/strings/strcat.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/synchronization/lock.h"
+#include "base/synchronization/waitable_event.h"
+#include "base/threading/platform_thread.h"
+#include "base/threading/thread.h"
+#include "base/time/time.h"
+#include "build/build_config.h"
+#include "impl/web_transport_owt_client_impl.h"
+#include "net/proxy_resolution/configured_proxy_resolution_service.h"
+#include "net/quic/platform/impl/quic_chromium_clock.h"
+#include "net/quic/web_transport_client.h"
+#include "net/test/test_data_directory.h"
+#include "net/third_party/quiche/src/quic/core/quic_simple_buffer_allocator.h"
+#include "net/third_party/quiche/src/quic/platform/api/quic_flags.h"
+#include "net/third_party/quiche/src/quic/platform/api/quic_system_event_loop.h"
+#include "net/url_request/url_request_context.h"
+#include "net/url_request/url_request_context_builder.h"
+#include "owt/quic/web_transport_factory.h"
+#include "owt/quic/web_transport_server_interface.h"
+
+DEFINE_QUIC_COMMAND_LINE_FLAG(int32_t, port, 20003, "Server port.");
+DEFINE_QUIC_COMMAND_LINE_FLAG(int32_t,
+                              io_threads,
+                              1,
+                              "Number of server IO threads.");
+DEFINE_QUIC_COMMAND_LINE_FLAG(int32_t,
+                              sessions,
+                              1000,
+                              "Number of client sessions.");
+DEFINE_QUIC_COMMAND_LINE_FLAG(int32_t,
+                              streams_in_flight,
+                              2,
+                              "Messages in flight per session, each on its "
+                              "own stream.");
+DEFINE_QUIC_COMMAND_LINE_FLAG(int32_t,
+                              message_size,
+                              1024,
+                              "Size of each message.");
+DEFINE_QUIC_COMMAND_LINE_FLAG(int32_t,
+                              datagram_size,
+                              200,
+                              "Size of datagrams sent by each session. 0 "
+                              "disables datagrams.");
+DEFINE_QUIC_COMMAND_LINE_FLAG(int32_t,
+                              datagrams_per_second,
+                              50,
+                              "Datagrams sent by each session per second.");
+DEFINE_QUIC_COMMAND_LINE_FLAG(int32_t,
+                              duration_s,
+                              3600,
+                              "Duration of the run in seconds.");
+DEFINE_QUIC_COMMAND_LINE_FLAG(int32_t,
+                              sample_interval_s,
+                              60,
+                              "Interval between samples in seconds.");
+DEFINE_QUIC_COMMAND_LINE_FLAG(int32_t,
+                              warmup_samples,
+                              2,
+                              "Samples taken while caches and pools warm up, "
+                              "which are not compared.");
+DEFINE_QUIC_COMMAND_LINE_FLAG(int32_t,
+                              compare_samples,
+                              3,
+                              "Samples averaged at each end of the run.");
+DEFINE_QUIC_COMMAND_LINE_FLAG(int32_t,
+                              max_rss_growth_mb,
+                              64,
+                              "Max growth of resident set size.");
+DEFINE_QUIC_COMMAND_LINE_FLAG(int32_t,
+                              max_malloc_growth_mb,
+                              64,
+                              "Max growth of memory allocated by malloc.");
+DEFINE_QUIC_COMMAND_LINE_FLAG(int32_t,
+                              max_session_memory_growth_mb,
+                              16,
+                              "Max growth of memory held by server sessions.");
+DEFINE_QUIC_COMMAND_LINE_FLAG(int32_t,
+                              max_p99_drift_percent,
+                              50,
+                              "Max increase of p99 message latency.");
+
+namespace owt {
+namespace quic {
+namespace test {
+namespace {
+
+// Same as the one in web_transport_owt_end_to_end_test.cc. quic-short-lived.pem
+// is only valid around this time.
+constexpr uint64_t kCertificateValidUnixSeconds = 1591389300;
+constexpr char kCertificateFingerprint[] =
+    "ED:3D:D7:C3:67:10:94:68:D1:DC:D1:26:5C:B2:74:D7:1C:A2:63:3E:94:94:C0:84:"
+    "39:D6:64:FA:08:B9:77:37";
+constexpr int64_t kMegabyte = 1024 * 1024;
+
+// A clock that only mocks out WallNow(), so the test certificate is valid.
+class SoakWallClock : public ::quic::QuicClock {
+ public:
+  ::quic::QuicTime Now() const override {
+    return ::quic::QuicChromiumClock::GetInstance()->Now();
+  }
+  ::quic::QuicTime ApproximateNow() const override {
+    return ::quic::QuicChromiumClock::GetInstance()->ApproximateNow();
+  }
+  ::quic::QuicWallTime WallNow() const override {
+    return ::quic::QuicWallTime::FromUNIXSeconds(kCertificateValidUnixSeconds);
+  }
+};
+
+class SoakConnectionHelper : public ::quic::QuicConnectionHelperInterface {
+ public:
+  const ::quic::QuicClock* GetClock() const override { return &clock_; }
+  ::quic::QuicRandom* GetRandomGenerator() override {
+    return ::quic::QuicRandom::GetInstance();
+  }
+  ::quic::QuicBufferAllocator* GetStreamSendBufferAllocator() override {
+    return &allocator_;
+  }
+
+ private:
+  SoakWallClock clock_;
+  ::quic::SimpleBufferAllocator allocator_;
+};
+
+struct Sample {
+  base::TimeDelta elapsed;
+  int64_t rss_bytes = 0;
+  int64_t malloc_bytes = 0;
+  int64_t session_bytes = 0;
+  uint64_t server_streams = 0;
+  uint64_t messages = 0;
+  int64_t latency_p99_us = 0;
+  uint64_t datagrams_received = 0;
+};
+
+// Collects message latencies of the current sample interval. Methods could
+// be called on any thread.
+class SoakRecorder {
+ public:
+  void OnMessageEchoed(base::TimeDelta latency) {
+    base::AutoLock auto_lock(lock_);
+    latencies_us_.push_back(latency.InMicroseconds());
+  }
+  void OnMessageFailed() { messages_failed_++; }
+  void OnDatagramReceived() { datagrams_received_++; }
+
+  // Fills latency fields of `sample` and starts a new interval.
+  void TakeInterval(Sample* sample) {
+    std::vector<int64_t> latencies;
+    {
+      base::AutoLock auto_lock(lock_);
+      latencies.swap(latencies_us_);
+    }
+    sample->messages = latencies.size();
+    sample->datagrams_received = datagrams_received_.exchange(0);
+    if (latencies.empty()) {
+      return;
+    }
+    const size_t index = static_cast<size_t>(0.99 * latencies.size());
+    std::nth_element(latencies.begin(), latencies.begin() + index,
+                     latencies.end());
+    sample->latency_p99_us = latencies[index];
+  }
+  uint64_t messages_failed() const { return messages_failed_; }
+
+ private:
+  base::Lock lock_;
+  std::vector<int64_t> latencies_us_;
+  std::atomic<uint64_t> messages_failed_{0};
+  std::atomic<uint64_t> datagrams_received_{0};
+};
+
+// Echoes a server stream, and closes it after echoing all data.
+class SoakServerSessionVisitor;
+class SoakServerStreamVisitor : public WebTransportStreamInterface::Visitor {
+ public:
+  SoakServerStreamVisitor(WebTransportStreamInterface* stream,
+                          SoakServerSessionVisitor* session)
+      : stream_(stream), session_(session), buffer_(16 * 1024) {}
+  void OnCanRead() override {
+    size_t read;
+    while ((read = stream_->Read(buffer_.data(), buffer_.size())) > 0) {
+      stream_->Write(buffer_.data(), read);
+    }
+  }
+  void OnCanWrite() override {}
+  void OnFinRead() override { stream_->Close(); }
+  void OnClosed() override;
+
+ private:
+  WebTransportStreamInterface* stream_;
+  SoakServerSessionVisitor* session_;
+  std::vector<uint8_t> buffer_;
+};
+
+// It runs on IO threads, since the server dispatches events inline.
+class SoakServerSessionVisitor : public WebTransportSessionInterface::Visitor {
+ public:
+  explicit SoakServerSessionVisitor(SoakRecorder* recorder)
+      : recorder_(recorder) {}
+  void OnIncomingStream(WebTransportStreamInterface* stream) override {
+    auto visitor = std::make_unique<SoakServerStreamVisitor>(stream, this);
+    stream->SetVisitor(visitor.get());
+    stream_visitors_[visitor.get()] = std::move(visitor);
+  }
+  void OnCanCreateNewOutgoingStream(bool) override {}
+  void OnConnectionClosed() override {}
+  void OnDatagramReceived(const uint8_t*, size_t) override {
+    recorder_->OnDatagramReceived();
+  }
+
+  // Destroys `visitor`.
+  void OnStreamClosed(SoakServerStreamVisitor* visitor) {
+    stream_visitors_.erase(visitor);
+  }
+
+ private:
+  SoakRecorder* recorder_;
+  // Visitors of live streams, so the benchmark itself doesn't grow.
+  std::unordered_map<SoakServerStreamVisitor*,
+                     std::unique_ptr<SoakServerStreamVisitor>>
+      stream_visitors_;
+};
+
+void SoakServerStreamVisitor::OnClosed() {
+  // Deletes this.
+  session_->OnStreamClosed(this);
+}
+
+class SoakServerVisitor : public WebTransportServerInterface::Visitor {
+ public:
+  explicit SoakServerVisitor(SoakRecorder* recorder) : recorder_(recorder) {}
+  void OnEnded() override {}
+  void OnSession(WebTransportSessionInterface* session) override {
+    auto visitor = std::make_unique<SoakServerSessionVisitor>(recorder_);
+    session->SetVisitor(visitor.get());
+    base::AutoLock auto_lock(lock_);
+    session_visitors_.push_back(std::move(visitor));
+  }
+
+ private:
+  SoakRecorder* recorder_;
+  // Sessions of different IO threads are created concurrently.
+  base::Lock lock_;
+  std::vector<std::unique_ptr<SoakServerSessionVisitor>> session_visitors_;
+};
+
+// Sends messages of a client session, each on a new stream. All methods run on
+// the client IO thread, which also dispatches client events.
+class SoakSessionDriver {
+ public:
+  SoakSessionDriver(WebTransportClientInterface* client,
+                    size_t message_size,
+                    scoped_refptr<base::SingleThreadTaskRunner> io_runner,
+                    const std::atomic<bool>* running,
+                    SoakRecorder* recorder)
+      : client_(client),
+        message_(message_size, 'm'),
+        io_runner_(std::move(io_runner)),
+        running_(running),
+        recorder_(recorder) {}
+
+  void Start(size_t streams_in_flight) {
+    for (size_t i = 0; i < streams_in_flight; i++) {
+      SendMessage();
+    }
+  }
+
+ private:
+  // Sends one message and reads its echo.
+  class Message : public WebTransportStreamInterface::Visitor {
+   public:
+    Message(SoakSessionDriver* driver, WebTransportStreamInterface* stream)
+        : driver_(driver),
+          stream_(stream),
+          send_time_(base::TimeTicks::Now()),
+          received_(0),
+          done_(false) {}
+    void OnCanRead() override {
+      uint8_t buffer[4096];
+      size_t read;
+      while ((read = stream_->Read(buffer, sizeof(buffer))) > 0) {
+        received_ += read;
+      }
+    }
+    void OnCanWrite() override {}
+    void OnFinRead() override {
+      OnCanRead();
+      if (received_ == driver_->message_.size()) {
+        driver_->recorder_->OnMessageEchoed(base::TimeTicks::Now() -
+                                            send_time_);
+        done_ = true;
+      }
+    }
+    void OnClosed() override {
+      if (!done_) {
+        driver_->recorder_->OnMessageFailed();
+      }
+      // Deletes this.
+      driver_->OnMessageClosed(this);
+    }
+
+   private:
+    SoakSessionDriver* driver_;
+    WebTransportStreamInterface* stream_;
+    const base::TimeTicks send_time_;
+    size_t received_;
+    bool done_;
+  };
+
+  void SendMessage() {
+    if (!running_->load(std::memory_order_relaxed)) {
+      return;
+    }
+    // Streams are taken from the warm pool when possible, so opening them
+    // doesn't wait for the IO thread.
+    WebTransportStreamInterface* stream = client_->AcquireStream(true);
+    if (!stream) {
+      stream = client_->CreateBidirectionalStream();
+    }
+    if (!stream) {
+      // Stream limit is reached until the server's MAX_STREAMS arrives.
+      io_runner_->PostDelayedTask(
+          FROM_HERE,
+          base::BindOnce(&SoakSessionDriver::SendMessage,
+                         base::Unretained(this)),
+          base::Milliseconds(1));
+      return;
+    }
+    auto message = std::make_unique<Message>(this, stream);
+    stream->SetVisitor(message.get());
+    messages_[message.get()] = std::move(message);
+    stream->Write(message_.data(), message_.size());
+    stream->Close();
+  }
+
+  void OnMessageClosed(Message* message) {
+    messages_.erase(message);
+    // The next message is not sent on the closing stream's call stack.
+    io_runner_->PostTask(FROM_HERE,
+                         base::BindOnce(&SoakSessionDriver::SendMessage,
+                                        base::Unretained(this)));
+  }
+
+  WebTransportClientInterface* client_;
+  const std::vector<uint8_t> message_;
+  scoped_refptr<base::SingleThreadTaskRunner> io_runner_;
+  const std::atomic<bool>* running_;
+  SoakRecorder* recorder_;
+  std::unordered_map<Message*, std::unique_ptr<Message>> messages_;
+};
+
+class SoakClientVisitor : public WebTransportClientInterface::Visitor {
+ public:
+  SoakClientVisitor(std::atomic<int>* pending_connections,
+                    base::WaitableEvent* all_connected)
+      : pending_connections_(pending_connections),
+        all_connected_(all_connected) {}
+  void OnConnected() override { OnConnectionDone(); }
+  void OnConnectionFailed() override {
+    LOG(ERROR) << "Soak client failed to connect.";
+    OnConnectionDone();
+  }
+  void OnIncomingStream(WebTransportStreamInterface*) override {}
+  void OnDatagramProcessed(MessageStatus) override {}
+  void OnClosed(uint32_t, const char*) override {
+    LOG(ERROR) << "Soak client is closed.";
+  }
+
+ private:
+  void OnConnectionDone() {
+    if (pending_connections_->fetch_sub(1) == 1) {
+      all_connected_->Signal();
+    }
+  }
+
+  std::atomic<int>* pending_connections_;
+  base::WaitableEvent* all_connected_;
+};
+
+// Sends a datagram from each client every `interval` until `running` becomes
+// false.
+void SendDatagrams(std::vector<WebTransportClientInterface*> clients,
+                   size_t datagram_size,
+                   base::TimeDelta interval,
+                   scoped_refptr<base::SingleThreadTaskRunner> runner,
+                   const std::atomic<bool>* running) {
+  if (!running->load(std::memory_order_relaxed)) {
+    return;
+  }
+  std::vector<uint8_t> datagram(datagram_size, 'd');
+  for (WebTransportClientInterface* client : clients) {
+    client->SendOrQueueDatagram(datagram.data(), datagram.size());
+  }
+  runner->PostDelayedTask(
+      FROM_HERE,
+      base::BindOnce(&SendDatagrams, std::move(clients), datagram_size,
+                     interval, runner, running),
+      interval);
+}
+
+void InitContextOnIOThread(std::unique_ptr<net::URLRequestContext>* context,
+                           base::WaitableEvent* event) {
+  net::URLRequestContextBuilder builder;
+  builder.set_proxy_resolution_service(
+      net::ConfiguredProxyResolutionService::CreateDirect());
+  auto quic_context = std::make_unique<net::QuicContext>(
+      std::make_unique<SoakConnectionHelper>());
+  quic_context->params()->origins_to_force_quic_on.insert(
+      net::HostPortPair("test.example.com", 0));
+  builder.set_quic_context(std::move(quic_context));
+  *context = builder.Build();
+  event->Signal();
+}
+
+Sample TakeSample(base::TimeDelta elapsed,
+                  base::ProcessMetrics* metrics,
+                  WebTransportServerInterface* server,
+                  SoakRecorder* recorder) {
+  Sample sample;
+  sample.elapsed = elapsed;
+#if defined(OS_LINUX) || defined(OS_CHROMEOS) || defined(OS_ANDROID)
+  sample.rss_bytes = metrics->GetResidentSetSize();
+#endif
+  sample.malloc_bytes = metrics->GetMallocUsage();
+  const MemoryUsage usage = server->GetMemoryUsage();
+  sample.session_bytes = usage.total_bytes;
+  sample.server_streams = usage.streams;
+  recorder->TakeInterval(&sample);
+  return sample;
+}
+
+void PrintSample(const Sample& sample) {
+  std::cout << "t_s: " << sample.elapsed.InSeconds()
+            << ", rss_mb: " << sample.rss_bytes / kMegabyte
+            << ", malloc_mb: " << sample.malloc_bytes / kMegabyte
+            << ", session_memory_kb: " << sample.session_bytes / 1024
+            << ", server_streams: " << sample.server_streams
+            << ", messages: " << sample.messages
+            << ", latency_p99_us: " << sample.latency_p99_us
+            << ", datagrams_received: " << sample.datagrams_received
+            << std::endl;
+}
+
+// Returns the average of `field` over samples in [begin, end).
+template <typename T>
+double Average(const std::vector<Sample>& samples,
+               size_t begin,
+               size_t end,
+               T Sample::*field) {
+  double sum = 0;
+  for (size_t i = begin; i < end; i++) {
+    sum += static_cast<double>(samples[i].*field);
+  }
+  return sum / (end - begin);
+}
+
+// Compares both ends of `samples`. Returns false if any growth exceeds its
+// threshold.
+bool CheckSamples(const std::vector<Sample>& samples,
+                  size_t expected_streams) {
+  bool passed = true;
+  for (const Sample& sample : samples) {
+    // Echoed streams are closed, so live streams are bounded by messages in
+    // flight. The server may not have destroyed the latest closed ones yet.
+    if (sample.server_streams > 2 * expected_streams) {
+      std::cout << "FAILED: " << sample.server_streams
+                << " server streams at " << sample.elapsed.InSeconds()
+                << " s, expected at most " << expected_streams << std::endl;
+      passed = false;
+      break;
+    }
+  }
+  const size_t warmup = std::max(0, GetQuicFlag(FLAGS_warmup_samples));
+  const size_t window = std::max(1, GetQuicFlag(FLAGS_compare_samples));
+  if (samples.size() < warmup + 2 * window) {
+    std::cout << "Only " << samples.size()
+              << " samples, growth is not checked. Run longer or sample more "
+                 "often."
+              << std::endl;
+    return passed;
+  }
+  const size_t first = warmup;
+  const size_t last = samples.size() - window;
+  auto check_growth = [&](const char* name, int64_t Sample::*field,
+                          int64_t max_growth, int64_t unit) {
+    const double growth = Average(samples, last, samples.size(), field) -
+                          Average(samples, first, first + window, field);
+    std::cout << name << "_growth: " << growth / unit << std::endl;
+    if (growth > max_growth * unit) {
+      std::cout << "FAILED: " << name << " grows more than " << max_growth
+                << std::endl;
+      passed = false;
+    }
+  };
+  check_growth("rss_mb", &Sample::rss_bytes,
+               GetQuicFlag(FLAGS_max_rss_growth_mb), kMegabyte);
+  check_growth("malloc_mb", &Sample::malloc_bytes,
+               GetQuicFlag(FLAGS_max_malloc_growth_mb), kMegabyte);
+  check_growth("session_memory_mb", &Sample::session_bytes,
+               GetQuicFlag(FLAGS_max_session_memory_growth_mb), kMegabyte);
+  const double first_p99 =
+      Average(samples, first, first + window, &Sample::latency_p99_us);
+  const double last_p99 =
+      Average(samples, last, samples.size(), &Sample::latency_p99_us);
+  if (first_p99 > 0) {
+    const double drift = (last_p99 - first_p99) * 100 / first_p99;
+    std::cout << "latency_p99_drift_percent: " << drift << std::endl;
+    if (drift > GetQuicFlag(FLAGS_max_p99_drift_percent)) {
+      std::cout << "FAILED: p99 latency drifts more than "
+                << GetQuicFlag(FLAGS_max_p99_drift_percent) << "%"
+                << std::endl;
+      passed = false;
+    }
+  }
+  if (Average(samples, last, samples.size(), &Sample::messages) == 0) {
+    std::cout << "FAILED: no message is echoed at the end of the run."
+              << std::endl;
+    passed = false;
+  }
+  return passed;
+}
+
+int RunSoak() {
+  const int port = GetQuicFlag(FLAGS_port);
+  const size_t sessions = std::max(1, GetQuicFlag(FLAGS_sessions));
+  const size_t streams_in_flight =
+      std::max(1, GetQuicFlag(FLAGS_streams_in_flight));
+  const size_t message_size = std::max(1, GetQuicFlag(FLAGS_message_size));
+  const size_t datagram_size = std::max(0, GetQuicFlag(FLAGS_datagram_size));
+  const int datagrams_per_second =
+      std::max(0, GetQuicFlag(FLAGS_datagrams_per_second));
+  const base::TimeDelta duration =
+      base::Seconds(std::max(1, GetQuicFlag(FLAGS_duration_s)));
+  const base::TimeDelta sample_interval =
+      base::Seconds(std::max(1, GetQuicFlag(FLAGS_sample_interval_s)));
+
+  base::Thread io_thread("web_transport_soak_io_thread");
+  io_thread.StartWithOptions(
+      base::Thread::Options(base::MessagePumpType::IO, 0));
+  std::unique_ptr<WebTransportFactory> factory(
+      WebTransportFactory::CreateForTesting());
+  SoakRecorder recorder;
+
+  base::FilePath certs_dir = net::GetTestCertsDirectory();
+  WebTransportServerInterface::Options options;
+  // Stream visitors are destroyed in OnClosed, which is called on IO threads.
+  options.inline_event_dispatch = true;
+  std::unique_ptr<WebTransportServerInterface> server(
+      factory->CreateWebTransportServer(
+          port,
+          certs_dir.AppendASCII("quic-short-lived.pem").MaybeAsASCII().c_str(),
+          certs_dir.AppendASCII("quic-leaf-cert.key").MaybeAsASCII().c_str(),
+          certs_dir.AppendASCII("quic-leaf-cert.key.sct")
+              .MaybeAsASCII()
+              .c_str(),
+          options));
+  if (!server) {
+    LOG(ERROR) << "Failed to create server.";
+    return 1;
+  }
+  SoakServerVisitor server_visitor(&recorder);
+  server->SetVisitor(&server_visitor);
+  server->SetIoThreadCount(std::max(1, GetQuicFlag(FLAGS_io_threads)));
+  if (server->Start() != 0) {
+    LOG(ERROR) << "Failed to start server.";
+    return 1;
+  }
+
+  std::unique_ptr<net::URLRequestContext> context;
+  base::WaitableEvent context_ready;
+  io_thread.task_runner()->PostTask(
+      FROM_HERE,
+      base::BindOnce(&InitContextOnIOThread, &context, &context_ready));
+  context_ready.Wait();
+
+  net::WebTransportParameters parameters;
+  parameters.server_certificate_fingerprints.push_back(
+      ::quic::CertificateFingerprint{
+          .algorithm = ::quic::CertificateFingerprint::kSha256,
+          .fingerprint = kCertificateFingerprint});
+  const GURL url(base::StrCat(
+      {"https://test.example.com:", base::NumberToString(port), "/echo"}));
+  std::atomic<int> pending_connections(static_cast<int>(sessions));
+  base::WaitableEvent all_connected;
+  SoakClientVisitor client_visitor(&pending_connections, &all_connected);
+  std::vector<std::unique_ptr<WebTransportClientInterface>> clients;
+  for (size_t i = 0; i < sessions; i++) {
+    // Client events are dispatched on the IO thread, so messages are created
+    // and destroyed on the thread their streams live on.
+    clients.emplace_back(new WebTransportOwtClientImpl(
+        url, url::Origin(), parameters, context.get(), &io_thread,
+        io_thread.task_runner()));
+    clients.back()->SetVisitor(&client_visitor);
+    clients.back()->SetWarmStreamPoolSize(streams_in_flight, 0);
+    clients.back()->Connect();
+  }
+  all_connected.Wait();
+
+  std::atomic<bool> running(true);
+  std::vector<std::unique_ptr<SoakSessionDriver>> drivers;
+  std::vector<WebTransportClientInterface*> datagram_clients;
+  for (auto& client : clients) {
+    drivers.push_back(std::make_unique<SoakSessionDriver>(
+        client.get(), message_size, io_thread.task_runner(), &running,
+        &recorder));
+    datagram_clients.push_back(client.get());
+  }
+  io_thread.task_runner()->PostTask(
+      FROM_HERE, base::BindOnce(
+                     [](std::vector<std::unique_ptr<SoakSessionDriver>>*
+                            drivers,
+                        size_t streams_in_flight) {
+                       for (auto& driver : *drivers) {
+                         driver->Start(streams_in_flight);
+                       }
+                     },
+                     &drivers, streams_in_flight));
+  if (datagram_size > 0 && datagrams_per_second > 0) {
+    io_thread.task_runner()->PostTask(
+        FROM_HERE,
+        base::BindOnce(&SendDatagrams, datagram_clients, datagram_size,
+                       base::Seconds(1) / datagrams_per_second,
+                       io_thread.task_runner(), &running));
+  }
+
+  std::cout << "sessions: " << sessions
+            << ", streams in flight per session: " << streams_in_flight
+            << ", message size: " << message_size
+            << ", datagram size: " << datagram_size
+            << ", duration: " << duration.InSeconds() << " s" << std::endl;
+  std::unique_ptr<base::ProcessMetrics> metrics =
+      base::ProcessMetrics::CreateCurrentProcessMetrics();
+  std::vector<Sample> samples;
+  const base::TimeTicks start = base::TimeTicks::Now();
+  base::TimeTicks next_sample = start + sample_interval;
+  while (next_sample <= start + duration) {
+    base::PlatformThread::Sleep(next_sample - base::TimeTicks::Now());
+    samples.push_back(TakeSample(base::TimeTicks::Now() - start,
+                                 metrics.get(), server.get(), &recorder));
+    PrintSample(samples.back());
+    next_sample += sample_interval;
+  }
+  running = false;
+  std::cout << "messages_failed: " << recorder.messages_failed() << std::endl;
+  const bool passed = CheckSamples(samples, sessions * streams_in_flight);
+  std::cout << (passed ? "PASSED" : "FAILED") << std::endl;
+
+  // Clients are destroyed before drivers, because closing their streams
+  // notifies drivers. Drivers outlive the IO thread, since its pending tasks
+  // refer to them.
+  clients.clear();
+  base::WaitableEvent done;
+  io_thread.task_runner()->PostTask(
+      FROM_HERE, base::BindOnce(
+                     [](std::unique_ptr<net::URLRequestContext> context,
+                        std::unique_ptr<WebTransportServerInterface> server,
+                        base::WaitableEvent* event) {
+                       context.reset();
+                       server.reset();
+                       event->Signal();
+                     },
+                     std::move(context), std::move(server), &done));
+  done.Wait();
+  io_thread.Stop();
+  return passed ? 0 : 1;
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace quic
+}  // namespace owt
+
+int main(int argc, char* argv[]) {
+  QuicSystemEventLoop event_loop("web_transport_soak");
+  const char* usage = "Usage: owt_web_transport_soak [options]";
+  std::vector<std::string> non_option_args =
+      ::quic::QuicParseCommandLineFlags(usage, argc, argv);
+  if (!non_option_args.empty()) {
+    ::quic::QuicPrintCommandLineFlagHelp(usage);
+    exit(0);
+  }
+  return owt::quic::test::RunSoak();
+}
@@ -6,10 +6,24 @@
 
 // Similar to net/third_party/quiche/src/quic/tools/quic_client_bin.cc, but it
 // only connects to a WebTransport server.
+//
+// With --sessions=N, it runs as a load generator. N sessions are opened at
+// --connect_rate sessions per second, held for --hold_s seconds with optional
+// stream and datagram traffic, and then the distribution of handshake latency
+// and the number of errors are reported.
 
+#include <algorithm>
+#include <memory>
 #include <string>
 #include <vector>
+#include "base/bind.h"
 #include "base/logging.h"
+#include "base/run_loop.h"
+#include "base/synchronization/lock.h"
+#include "base/task/single_thread_task_runner.h"
+#include "base/threading/thread_task_runner_handle.h"
+#include "base/time/time.h"
+#include "base/timer/timer.h"
 #include "net/third_party/quiche/src/quic/platform/api/quic_flags.h"
 #include "net/third_party/quiche/src/quic/platform/api/quic_system_event_loop.h"
 #include "owt/quic/web_transport_factory.h"
@@ -41,6 +55,326 @@ DEFINE_QUIC_COMMAND_LINE_FLAG(std::string,
                               fingerprint,
                               "",
                               "Certificate fingerprint.");
+DEFINE_QUIC_COMMAND_LINE_FLAG(int32_t,
+                              sessions,
+                              0,
+                              "Number of sessions opened by the load "
+                              "generator. 0 opens a single session without "
+                              "reporting.");
+DEFINE_QUIC_COMMAND_LINE_FLAG(int32_t,
+                              connect_rate,
+                              100,
+                              "Sessions opened per second by the load "
+                              "generator.");
+DEFINE_QUIC_COMMAND_LINE_FLAG(bool,
+                              resumption,
+                              false,
+                              "Resume TLS sessions, so handshakes after the "
+                              "first one use 0-RTT if the server accepts it.");
+DEFINE_QUIC_COMMAND_LINE_FLAG(int32_t,
+                              hold_s,
+                              10,
+                              "Seconds all sessions are held after the last "
+                              "one is opened.");
+DEFINE_QUIC_COMMAND_LINE_FLAG(int32_t,
+                              streams,
+                              0,
+                              "Bidirectional streams opened by each session.");
+DEFINE_QUIC_COMMAND_LINE_FLAG(int32_t,
+                              message_size,
+                              1024,
+                              "Bytes written to each stream per 100 ms.");
+DEFINE_QUIC_COMMAND_LINE_FLAG(int32_t,
+                              datagrams,
+                              0,
+                              "Datagrams sent by each session per 100 ms.");
+DEFINE_QUIC_COMMAND_LINE_FLAG(int32_t,
+                              datagram_size,
+                              100,
+                              "Size of datagrams.");
+
+namespace {
+
+// Interval of writing stream data and sending datagrams on held sessions.
+constexpr int64_t kTrafficIntervalMs = 100;
+// Sessions not connected or failed this long after the last one is opened are
+// reported as not completed.
+constexpr int64_t kHandshakeTimeoutSeconds = 30;
+
+// Results shared by all sessions of the load generator. Methods could be
+// called on any thread.
+class LoadGeneratorResults {
+ public:
+  void OnConnected(base::TimeDelta handshake_latency) {
+    base::AutoLock auto_lock(lock_);
+    handshake_latencies_ms_.push_back(handshake_latency.InMillisecondsF());
+  }
+  void OnConnectionFailed() {
+    base::AutoLock auto_lock(lock_);
+    failures_++;
+  }
+  void OnClosedByServer() {
+    base::AutoLock auto_lock(lock_);
+    closed_by_server_++;
+  }
+  size_t completed() {
+    base::AutoLock auto_lock(lock_);
+    return handshake_latencies_ms_.size() + failures_;
+  }
+
+  void Report(size_t attempted, base::TimeDelta connect_duration) {
+    base::AutoLock auto_lock(lock_);
+    std::sort(handshake_latencies_ms_.begin(), handshake_latencies_ms_.end());
+    LOG(INFO) << "Sessions attempted: " << attempted
+              << ", connected: " << handshake_latencies_ms_.size()
+              << ", failed: " << failures_
+              << ", not completed: "
+              << attempted - handshake_latencies_ms_.size() - failures_
+              << ", closed by server: " << closed_by_server_;
+    LOG(INFO) << "Achieved connect rate: "
+              << attempted / std::max(connect_duration.InSecondsF(), 0.001)
+              << " sessions/s";
+    LOG(INFO) << "Handshake latency (ms) p50: " << Percentile(0.5)
+              << ", p90: " << Percentile(0.9) << ", p99: " << Percentile(0.99)
+              << ", p999: " << Percentile(0.999) << ", max: "
+              << (handshake_latencies_ms_.empty()
+                      ? 0
+                      : handshake_latencies_ms_.back());
+  }
+
+ private:
+  double Percentile(double percentile) const {
+    if (handshake_latencies_ms_.empty()) {
+      return 0;
+    }
+    size_t index =
+        static_cast<size_t>(percentile * handshake_latencies_ms_.size());
+    return handshake_latencies_ms_[std::min(
+        index, handshake_latencies_ms_.size() - 1)];
+  }
+
+  base::Lock lock_;
+  std::vector<double> handshake_latencies_ms_;
+  size_t failures_ = 0;
+  size_t closed_by_server_ = 0;
+};
+
+// A session opened by the load generator. All methods except visitor methods
+// run on the main thread.
+class LoadGeneratorSession
+    : public owt::quic::WebTransportClientInterface::Visitor,
+      public owt::quic::WebTransportStreamInterface::Visitor {
+ public:
+  LoadGeneratorSession(
+      std::unique_ptr<owt::quic::WebTransportClientInterface> client,
+      LoadGeneratorResults* results,
+      scoped_refptr<base::SingleThreadTaskRunner> main_runner,
+      base::OnceClosure on_done)
+      : client_(std::move(client)),
+        results_(results),
+        main_runner_(std::move(main_runner)),
+        on_done_(std::move(on_done)) {
+    client_->SetVisitor(this);
+  }
+
+  void Connect() {
+    start_time_ = base::TimeTicks::Now();
+    client_->Connect();
+  }
+
+  void Close() {
+    traffic_timer_.Stop();
+    client_->Close();
+  }
+
+  // Overrides owt::quic::WebTransportClientInterface::Visitor.
+  void OnConnected() override {
+    results_->OnConnected(base::TimeTicks::Now() - start_time_);
+    main_runner_->PostTask(FROM_HERE,
+                           base::BindOnce(&LoadGeneratorSession::StartTraffic,
+                                          base::Unretained(this)));
+    main_runner_->PostTask(FROM_HERE, std::move(on_done_));
+  }
+  void OnConnectionFailed() override {
+    results_->OnConnectionFailed();
+    main_runner_->PostTask(FROM_HERE, std::move(on_done_));
+  }
+  void OnIncomingStream(owt::quic::WebTransportStreamInterface*) override {}
+  void OnDatagramProcessed(owt::quic::MessageStatus) override {}
+  void OnClosed(uint32_t, const char*) override {
+    results_->OnClosedByServer();
+  }
+
+  // Overrides owt::quic::WebTransportStreamInterface::Visitor. Data echoed
+  // by the server is dropped.
+  void OnCanRead() override {}
+  void OnCanWrite() override {}
+  void OnFinRead() override {}
+  void OnDataReceived(const uint8_t*, size_t, bool) override {}
+
+ private:
+  void StartTraffic() {
+    const int stream_count = GetQuicFlag(FLAGS_streams);
+    for (int i = 0; i < stream_count; i++) {
+      owt::quic::WebTransportStreamInterface* stream =
+          client_->CreateBidirectionalStream();
+      if (!stream) {
+        break;
+      }
+      stream->SetVisitor(this);
+      stream->SetPushModeEnabled(true);
+      streams_.push_back(stream);
+    }
+    message_.resize(std::max(0, GetQuicFlag(FLAGS_message_size)));
+    datagram_.resize(std::max(0, GetQuicFlag(FLAGS_datagram_size)));
+    const bool has_stream_traffic = !streams_.empty() && !message_.empty();
+    const bool has_datagram_traffic =
+        GetQuicFlag(FLAGS_datagrams) > 0 && !datagram_.empty();
+    if (!has_stream_traffic && !has_datagram_traffic) {
+      return;
+    }
+    traffic_timer_.Start(FROM_HERE, base::Milliseconds(kTrafficIntervalMs),
+                         base::BindRepeating(&LoadGeneratorSession::SendTraffic,
+                                             base::Unretained(this)));
+  }
+
+  void SendTraffic() {
+    if (!message_.empty()) {
+      for (owt::quic::WebTransportStreamInterface* stream : streams_) {
+        stream->WriteAsync(message_.data(), message_.size());
+      }
+    }
+    if (!datagram_.empty()) {
+      for (int i = 0; i < GetQuicFlag(FLAGS_datagrams); i++) {
+        client_->SendOrQueueDatagram(datagram_.data(), datagram_.size());
+      }
+    }
+  }
+
+  std::unique_ptr<owt::quic::WebTransportClientInterface> client_;
+  LoadGeneratorResults* results_;
+  scoped_refptr<base::SingleThreadTaskRunner> main_runner_;
+  base::OnceClosure on_done_;
+  base::TimeTicks start_time_;
+  std::vector<owt::quic::WebTransportStreamInterface*> streams_;
+  std::vector<uint8_t> message_;
+  std::vector<uint8_t> datagram_;
+  base::RepeatingTimer traffic_timer_;
+};
+
+// Opens sessions at a fixed rate on the main thread.
+class LoadGenerator {
+ public:
+  LoadGenerator(owt::quic::WebTransportFactory* factory,
+                std::string url,
+                owt::quic::WebTransportClientInterface::Parameters parameters,
+                size_t session_count,
+                base::OnceClosure on_finished)
+      : factory_(factory),
+        url_(std::move(url)),
+        parameters_(parameters),
+        session_count_(session_count),
+        completed_sessions_(0),
+        on_finished_(std::move(on_finished)) {}
+
+  void Start() {
+    if (parameters_.enable_session_resumption) {
+      // A priming session establishes the TLS session to be resumed. It's
+      // not counted in results.
+      LOG(INFO) << "Opening a priming session for resumption.";
+      priming_session_ = CreateSession(
+          &priming_results_, base::BindOnce(&LoadGenerator::StartConnecting,
+                                            base::Unretained(this)));
+      priming_session_->Connect();
+      return;
+    }
+    StartConnecting();
+  }
+
+ private:
+  std::unique_ptr<LoadGeneratorSession> CreateSession(
+      LoadGeneratorResults* results,
+      base::OnceClosure on_done) {
+    return std::make_unique<LoadGeneratorSession>(
+        std::unique_ptr<owt::quic::WebTransportClientInterface>(
+            factory_->CreateWebTransportClient(url_.c_str(), parameters_)),
+        results, base::ThreadTaskRunnerHandle::Get(), std::move(on_done));
+  }
+
+  void StartConnecting() {
+    const int rate = std::max(1, GetQuicFlag(FLAGS_connect_rate));
+    connect_start_ = base::TimeTicks::Now();
+    connect_timer_.Start(FROM_HERE, base::Seconds(1) / rate,
+                         base::BindRepeating(&LoadGenerator::ConnectNext,
+                                             base::Unretained(this)));
+  }
+
+  void ConnectNext() {
+    sessions_.push_back(CreateSession(
+        &results_, base::BindOnce(&LoadGenerator::OnSessionDone,
+                                  base::Unretained(this))));
+    sessions_.back()->Connect();
+    if (sessions_.size() >= session_count_) {
+      connect_timer_.Stop();
+      connect_duration_ = base::TimeTicks::Now() - connect_start_;
+      hold_timer_.Start(FROM_HERE, base::Seconds(kHandshakeTimeoutSeconds),
+                        base::BindOnce(&LoadGenerator::StartHolding,
+                                       base::Unretained(this)));
+    }
+  }
+
+  void OnSessionDone() {
+    completed_sessions_++;
+    if (completed_sessions_ == session_count_) {
+      StartHolding();
+    }
+  }
+
+  // Called by the handshake timeout or the last completed session, whichever
+  // comes first.
+  void StartHolding() {
+    if (holding_) {
+      return;
+    }
+    holding_ = true;
+    LOG(INFO) << completed_sessions_
+              << " sessions completed handshakes, holding them for "
+              << GetQuicFlag(FLAGS_hold_s) << " seconds.";
+    hold_timer_.Start(FROM_HERE, base::Seconds(GetQuicFlag(FLAGS_hold_s)),
+                      base::BindOnce(&LoadGenerator::Finish,
+                                     base::Unretained(this)));
+  }
+
+  void Finish() {
+    results_.Report(session_count_, connect_duration_);
+    for (auto& session : sessions_) {
+      session->Close();
+    }
+    if (priming_session_) {
+      priming_session_->Close();
+    }
+    std::move(on_finished_).Run();
+  }
+
+  owt::quic::WebTransportFactory* factory_;
+  const std::string url_;
+  const owt::quic::WebTransportClientInterface::Parameters parameters_;
+  const size_t session_count_;
+  size_t completed_sessions_;
+  base::OnceClosure on_finished_;
+  LoadGeneratorResults results_;
+  LoadGeneratorResults priming_results_;
+  std::unique_ptr<LoadGeneratorSession> priming_session_;
+  std::vector<std::unique_ptr<LoadGeneratorSession>> sessions_;
+  base::TimeTicks connect_start_;
+  base::TimeDelta connect_duration_;
+  bool holding_ = false;
+  base::RepeatingTimer connect_timer_;
+  // Runs the handshake timeout, and then the hold period.
+  base::OneShotTimer hold_timer_;
+};
+
+}  // namespace
 
 int main(int argc, char* argv[]) {
   QuicSystemEventLoop event_loop("web_transport_test_client");
@@ -69,12 +403,23 @@ int main(int argc, char* argv[]) {
   }
   std::unique_ptr<owt::quic::WebTransportFactory> factory_(
       owt::quic::WebTransportFactory::CreateForTesting());
+
+  base::RunLoop run_loop;
+  if (GetQuicFlag(FLAGS_sessions) > 0) {
+    parameters.enable_session_resumption = GetQuicFlag(FLAGS_resumption);
+    LoadGenerator load_generator(factory_.get(), urls[0], parameters,
+                                 GetQuicFlag(FLAGS_sessions),
+                                 run_loop.QuitClosure());
+    load_generator.Start();
+    run_loop.Run();
+    return 0;
+  }
+
   std::unique_ptr<owt::quic::WebTransportClientInterface> client_(
       factory_->CreateWebTransportClient(urls[0].c_str(), parameters));
   WebTransportTestClientVisitor client_visitor;
   client_->SetVisitor(&client_visitor);
   client_->Connect();
 
-  base::RunLoop run_loop;
   run_loop.Run();
-}
\ No newline at end of file
+}
@@ -0,0 +1,212 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "impl/thread_scheduling.h"
+#include <algorithm>
+#include <iterator>
+#include "base/bind.h"
+#include "base/files/file_path.h"
+#include "base/files/file_util.h"
+#include "base/logging.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/strings/string_split.h"
+#include "base/strings/string_util.h"
+#include "base/strings/stringprintf.h"
+#include "base/threading/platform_thread.h"
+#include "build/build_config.h"
+#if defined(OS_LINUX) || defined(OS_CHROMEOS)
+#include <sched.h>
+#elif defined(OS_WIN)
+#include <windows.h>
+#endif
+
+namespace owt {
+namespace quic {
+
+namespace {
+// Guards against huge allocations for malformed CPU lists.
+constexpr uint32_t kMaxCpu = 4095;
+
+// Returns CPUs of NUMA node `node`.
+bool GetNumaNodeCpus(int32_t node, std::vector<uint32_t>* cpus) {
+#if defined(OS_LINUX) || defined(OS_CHROMEOS)
+  std::string list;
+  if (!base::ReadFileToString(
+          base::FilePath(base::StringPrintf(
+              "/sys/devices/system/node/node%d/cpulist", node)),
+          &list)) {
+    return false;
+  }
+  return ThreadScheduling::ParseCpuList(
+      base::TrimWhitespaceASCII(list, base::TRIM_ALL), cpus);
+#else
+  return false;
+#endif
+}
+
+void SetCurrentThreadAffinity(const std::vector<uint32_t>& cpus) {
+#if defined(OS_LINUX) || defined(OS_CHROMEOS)
+  const uint32_t max_cpu = *std::max_element(cpus.begin(), cpus.end());
+  cpu_set_t* set = CPU_ALLOC(max_cpu + 1);
+  CHECK(set);
+  const size_t set_size = CPU_ALLOC_SIZE(max_cpu + 1);
+  CPU_ZERO_S(set_size, set);
+  for (uint32_t cpu : cpus) {
+    CPU_SET_S(cpu, set_size, set);
+  }
+  PLOG_IF(WARNING, sched_setaffinity(0, set_size, set) != 0)
+      << "Failed to set CPU affinity of " << base::PlatformThread::GetName();
+  CPU_FREE(set);
+#elif defined(OS_WIN)
+  DWORD_PTR mask = 0;
+  for (uint32_t cpu : cpus) {
+    if (cpu >= sizeof(mask) * 8) {
+      LOG(WARNING) << "CPU " << cpu
+                   << " is not in the current processor group.";
+      continue;
+    }
+    mask |= static_cast<DWORD_PTR>(1) << cpu;
+  }
+  if (!mask) {
+    return;
+  }
+  PLOG_IF(WARNING, !SetThreadAffinityMask(GetCurrentThread(), mask))
+      << "Failed to set CPU affinity of " << base::PlatformThread::GetName();
+#else
+  LOG(WARNING) << "CPU affinity is not supported on this platform.";
+#endif
+}
+}  // namespace
+
+ThreadScheduling::ThreadScheduling() = default;
+
+ThreadScheduling::ThreadScheduling(const ThreadScheduling&) = default;
+
+ThreadScheduling& ThreadScheduling::operator=(const ThreadScheduling&) =
+    default;
+
+ThreadScheduling::~ThreadScheduling() = default;
+
+void ThreadScheduling::Set(SdkThread thread,
+                           size_t index,
+                           const ThreadSchedulingOptions& options) {
+  Settings& settings = settings_[std::make_pair(thread, index)];
+  settings.cpus.assign(options.cpus, options.cpus + options.cpu_count);
+  settings.numa_node = options.numa_node;
+  settings.priority = options.priority;
+}
+
+const ThreadScheduling::Settings* ThreadScheduling::Find(SdkThread thread,
+                                                         size_t index) const {
+  auto it = settings_.find(std::make_pair(thread, index));
+  return it == settings_.end() ? nullptr : &it->second;
+}
+
+void ThreadScheduling::ApplyTo(SdkThread thread,
+                               size_t index,
+                               base::Thread* target) const {
+  DCHECK(target && target->IsRunning());
+  const Settings* settings = Find(thread, index);
+  if (!settings) {
+    return;
+  }
+  // Resolved here, since reading sysfs may block `target`'s first tasks.
+  std::vector<uint32_t> cpus;
+  LOG_IF(WARNING, !ResolveCpus(*settings, &cpus))
+      << "Unknown CPUs of NUMA node " << settings->numa_node << " for "
+      << target->thread_name();
+  target->task_runner()->PostTask(
+      FROM_HERE, base::BindOnce(&ThreadScheduling::ApplyToCurrentThread,
+                                std::move(cpus), settings->priority));
+}
+
+// static
+bool ThreadScheduling::ResolveCpus(const Settings& settings,
+                                   std::vector<uint32_t>* cpus) {
+  DCHECK(cpus);
+  cpus->clear();
+  std::vector<uint32_t> allowed(settings.cpus);
+  std::sort(allowed.begin(), allowed.end());
+  allowed.erase(std::unique(allowed.begin(), allowed.end()), allowed.end());
+  if (settings.numa_node < 0) {
+    *cpus = std::move(allowed);
+    return true;
+  }
+  std::vector<uint32_t> node_cpus;
+  if (!GetNumaNodeCpus(settings.numa_node, &node_cpus)) {
+    // Falls back to `cpus` alone.
+    *cpus = std::move(allowed);
+    return false;
+  }
+  if (allowed.empty()) {
+    *cpus = std::move(node_cpus);
+    return true;
+  }
+  std::set_intersection(allowed.begin(), allowed.end(), node_cpus.begin(),
+                        node_cpus.end(), std::back_inserter(*cpus));
+  if (cpus->empty()) {
+    LOG(WARNING) << "None of the CPUs is on NUMA node " << settings.numa_node
+                 << ", CPUs of the node are used.";
+    *cpus = std::move(node_cpus);
+  }
+  return true;
+}
+
+// static
+void ThreadScheduling::ApplyToCurrentThread(const std::vector<uint32_t>& cpus,
+                                            ThreadPriority priority) {
+  if (!cpus.empty()) {
+    SetCurrentThreadAffinity(cpus);
+  }
+  switch (priority) {
+    case ThreadPriority::kDefault:
+      break;
+    case ThreadPriority::kHigh:
+      base::PlatformThread::SetCurrentThreadPriority(
+          base::ThreadPriority::DISPLAY);
+      break;
+    case ThreadPriority::kRealtime:
+      base::PlatformThread::SetCurrentThreadPriority(
+          base::ThreadPriority::REALTIME_AUDIO);
+      break;
+  }
+}
+
+// static
+bool ThreadScheduling::ParseCpuList(absl::string_view list,
+                                    std::vector<uint32_t>* cpus) {
+  DCHECK(cpus);
+  std::vector<uint32_t> parsed;
+  for (base::StringPiece range :
+       base::SplitStringPiece(base::StringPiece(list.data(), list.size()), ",",
+                              base::TRIM_WHITESPACE,
+                              base::SPLIT_WANT_NONEMPTY)) {
+    std::vector<base::StringPiece> bounds = base::SplitStringPiece(
+        range, "-", base::TRIM_WHITESPACE, base::SPLIT_WANT_ALL);
+    unsigned first = 0;
+    unsigned last = 0;
+    if (bounds.size() > 2 || !base::StringToUint(bounds[0], &first)) {
+      return false;
+    }
+    last = first;
+    if (bounds.size() == 2 && !base::StringToUint(bounds[1], &last)) {
+      return false;
+    }
+    if (first > last || last > kMaxCpu) {
+      return false;
+    }
+    for (unsigned cpu = first; cpu <= last; cpu++) {
+      parsed.push_back(cpu);
+    }
+  }
+  std::sort(parsed.begin(), parsed.end());
+  parsed.erase(std::unique(parsed.begin(), parsed.end()), parsed.end());
+  cpus->insert(cpus->end(), parsed.begin(), parsed.end());
+  return true;
+}
+
+}  // namespace quic
+}  // namespace owt
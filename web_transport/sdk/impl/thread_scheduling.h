@@ -0,0 +1,67 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef OWT_WEB_TRANSPORT_THREAD_SCHEDULING_H_
+#define OWT_WEB_TRANSPORT_THREAD_SCHEDULING_H_
+
+#include <cstdint>
+#include <map>
+#include <utility>
+#include <vector>
+#include "base/threading/thread.h"
+#include "owt/quic/web_transport_definitions.h"
+#include "third_party/abseil-cpp/absl/strings/string_view.h"
+
+namespace owt {
+namespace quic {
+
+// CPU affinity and priority of SDK threads, set by
+// WebTransportFactory::SetThreadScheduling. It's copied to each server when
+// the server is created, so it's not thread-safe.
+class ThreadScheduling {
+ public:
+  struct Settings {
+    std::vector<uint32_t> cpus;
+    int32_t numa_node = -1;
+    ThreadPriority priority = ThreadPriority::kDefault;
+  };
+
+  ThreadScheduling();
+  ThreadScheduling(const ThreadScheduling&);
+  ThreadScheduling& operator=(const ThreadScheduling&);
+  ~ThreadScheduling();
+
+  void Set(SdkThread thread,
+           size_t index,
+           const ThreadSchedulingOptions& options);
+  // Returns nullptr if nothing is set for the `index`th thread of `thread`.
+  const Settings* Find(SdkThread thread, size_t index) const;
+  // Applies settings of the `index`th thread of `thread` kind to `target`,
+  // which must be running. They're applied by a task posted to `target`, so
+  // they take effect before tasks posted afterwards. No-op if nothing is set.
+  void ApplyTo(SdkThread thread, size_t index, base::Thread* target) const;
+
+  // Returns CPUs `settings` allows, which is empty if all CPUs are allowed.
+  // Returns false if CPUs of its NUMA node are unknown.
+  static bool ResolveCpus(const Settings& settings,
+                          std::vector<uint32_t>* cpus);
+  // Restricts the calling thread to `cpus` unless it's empty, and sets its
+  // priority. Failures are logged.
+  static void ApplyToCurrentThread(const std::vector<uint32_t>& cpus,
+                                   ThreadPriority priority);
+  // Parses a CPU list in the format of Linux's cpulist files, e.g.:
+  // "0-3,8,10-11". CPUs are appended to `cpus` in ascending order.
+  static bool ParseCpuList(absl::string_view list,
+                           std::vector<uint32_t>* cpus);
+
+ private:
+  std::map<std::pair<SdkThread, size_t>, Settings> settings_;
+};
+
+}  // namespace quic
+}  // namespace owt
+
+#endif
@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "owt/web_transport/sdk/impl/thread_scheduling.h"
+#include "base/bind.h"
+#include "base/synchronization/waitable_event.h"
+#include "base/threading/thread.h"
+#include "build/build_config.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#if defined(OS_LINUX) || defined(OS_CHROMEOS)
+#include <sched.h>
+#endif
+
+namespace owt {
+namespace quic {
+namespace test {
+
+TEST(ThreadSchedulingTest, ParseCpuList) {
+  std::vector<uint32_t> cpus;
+  EXPECT_TRUE(ThreadScheduling::ParseCpuList("0-3,8,10-11", &cpus));
+  EXPECT_EQ(cpus, std::vector<uint32_t>({0, 1, 2, 3, 8, 10, 11}));
+  cpus.clear();
+  EXPECT_TRUE(ThreadScheduling::ParseCpuList("", &cpus));
+  EXPECT_TRUE(cpus.empty());
+  EXPECT_FALSE(ThreadScheduling::ParseCpuList("3-1", &cpus));
+  EXPECT_FALSE(ThreadScheduling::ParseCpuList("1-2-3", &cpus));
+  EXPECT_FALSE(ThreadScheduling::ParseCpuList("a", &cpus));
+  EXPECT_FALSE(ThreadScheduling::ParseCpuList("0-100000", &cpus));
+}
+
+TEST(ThreadSchedulingTest, SetAndFind) {
+  ThreadScheduling scheduling;
+  const uint32_t cpus[] = {5, 1, 5};
+  ThreadSchedulingOptions options;
+  options.cpus = cpus;
+  options.cpu_count = 3;
+  options.priority = ThreadPriority::kHigh;
+  scheduling.Set(SdkThread::kIo, 1, options);
+  EXPECT_EQ(scheduling.Find(SdkThread::kIo, 0), nullptr);
+  EXPECT_EQ(scheduling.Find(SdkThread::kEvent, 1), nullptr);
+  const ThreadScheduling::Settings* settings =
+      scheduling.Find(SdkThread::kIo, 1);
+  ASSERT_NE(settings, nullptr);
+  EXPECT_EQ(settings->priority, ThreadPriority::kHigh);
+  std::vector<uint32_t> resolved;
+  EXPECT_TRUE(ThreadScheduling::ResolveCpus(*settings, &resolved));
+  EXPECT_EQ(resolved, std::vector<uint32_t>({1, 5}));
+  // Copies don't share settings.
+  ThreadScheduling copy(scheduling);
+  scheduling.Set(SdkThread::kIo, 1, ThreadSchedulingOptions());
+  EXPECT_EQ(copy.Find(SdkThread::kIo, 1)->cpus,
+            std::vector<uint32_t>({5, 1, 5}));
+}
+
+#if defined(OS_LINUX) || defined(OS_CHROMEOS)
+TEST(ThreadSchedulingTest, AppliesAffinity) {
+  // Picks a CPU this process is allowed to run on.
+  cpu_set_t allowed;
+  ASSERT_EQ(sched_getaffinity(0, sizeof(allowed), &allowed), 0);
+  uint32_t cpu = 0;
+  while (!CPU_ISSET(cpu, &allowed)) {
+    cpu++;
+  }
+  ThreadScheduling scheduling;
+  ThreadSchedulingOptions options;
+  options.cpus = &cpu;
+  options.cpu_count = 1;
+  scheduling.Set(SdkThread::kEvent, 2, options);
+  base::Thread thread("thread_scheduling_test_thread");
+  ASSERT_TRUE(thread.Start());
+  scheduling.ApplyTo(SdkThread::kEvent, 2, &thread);
+  cpu_set_t applied;
+  CPU_ZERO(&applied);
+  base::WaitableEvent done;
+  thread.task_runner()->PostTask(
+      FROM_HERE, base::BindOnce(
+                     [](cpu_set_t* applied, base::WaitableEvent* done) {
+                       sched_getaffinity(0, sizeof(*applied), applied);
+                       done->Signal();
+                     },
+                     &applied, &done));
+  done.Wait();
+  thread.Stop();
+  EXPECT_EQ(CPU_COUNT(&applied), 1);
+  EXPECT_TRUE(CPU_ISSET(cpu, &applied));
+}
+#endif
+
+}  // namespace test
+}  // namespace quic
+}  // namespace owt
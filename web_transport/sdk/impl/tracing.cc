@@ -0,0 +1,136 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "owt/quic/tracing.h"
+#include <atomic>
+#include <string>
+#include "base/bind.h"
+#include "base/files/file_path.h"
+#include "base/files/file_util.h"
+#include "base/logging.h"
+#include "base/memory/ref_counted_memory.h"
+#include "base/synchronization/waitable_event.h"
+#include "base/threading/thread.h"
+#include "base/time/time.h"
+#include "base/trace_event/trace_buffer.h"
+#include "base/trace_event/trace_config.h"
+#include "base/trace_event/trace_event.h"
+#include "base/trace_event/trace_log.h"
+#include "impl/metrics.h"
+#include "impl/tracing.h"
+
+namespace owt {
+namespace quic {
+
+namespace {
+const char kDefaultCategories[] = OWT_TRACE_CATEGORY;
+
+std::atomic<uint64_t> next_flow_id{1};
+
+void RunTracedTask(const char* name,
+                   uint64_t flow_id,
+                   base::TimeTicks post_time,
+                   base::OnceClosure task) {
+  const int64_t queue_wait_us =
+      (base::TimeTicks::Now() - post_time).InMicroseconds();
+  MetricsRegistry::Record(MetricHistogram::kEventQueueDelay, queue_wait_us);
+  // Flow ID is 0 if tracing was disabled when the task was posted.
+  if (flow_id == 0) {
+    std::move(task).Run();
+    return;
+  }
+  TRACE_EVENT_WITH_FLOW1(OWT_TRACE_CATEGORY, name, TRACE_ID_LOCAL(flow_id),
+                         TRACE_EVENT_FLAG_FLOW_IN, "queue_wait_us",
+                         queue_wait_us);
+  std::move(task).Run();
+}
+
+void OnTraceDataCollected(
+    base::trace_event::TraceResultBuffer* buffer,
+    base::WaitableEvent* done,
+    const scoped_refptr<base::RefCountedString>& events,
+    bool has_more_events) {
+  buffer->AddFragment(events->data());
+  if (!has_more_events) {
+    done->Signal();
+  }
+}
+
+void StopAndFlush(base::trace_event::TraceResultBuffer* buffer,
+                  base::WaitableEvent* done) {
+  auto* trace_log = base::trace_event::TraceLog::GetInstance();
+  trace_log->SetDisabled();
+  trace_log->Flush(base::BindRepeating(&OnTraceDataCollected,
+                                       base::Unretained(buffer),
+                                       base::Unretained(done)));
+}
+}  // namespace
+
+bool Tracing::Start(const char* categories) {
+  auto* trace_log = base::trace_event::TraceLog::GetInstance();
+  if (trace_log->IsEnabled()) {
+    return false;
+  }
+  trace_log->SetEnabled(
+      base::trace_event::TraceConfig(
+          categories ? categories : kDefaultCategories, ""),
+      base::trace_event::TraceLog::RECORDING_MODE);
+  return true;
+}
+
+bool Tracing::StopAndWrite(const char* file_path) {
+  if (!file_path || !IsRecording()) {
+    return false;
+  }
+  base::trace_event::TraceResultBuffer buffer;
+  base::trace_event::TraceResultBuffer::SimpleOutput output;
+  buffer.SetOutputCallback(output.GetCallback());
+  buffer.Start();
+  // Flush requires a thread with a task runner, which the calling thread may
+  // not have.
+  base::Thread flush_thread("trace_flush_thread");
+  if (!flush_thread.Start()) {
+    return false;
+  }
+  base::WaitableEvent done;
+  flush_thread.task_runner()->PostTask(
+      FROM_HERE, base::BindOnce(&StopAndFlush, base::Unretained(&buffer),
+                                base::Unretained(&done)));
+  done.Wait();
+  flush_thread.Stop();
+  buffer.Finish();
+  if (!base::WriteFile(base::FilePath::FromUTF8Unsafe(file_path),
+                       output.json_output)) {
+    LOG(ERROR) << "Failed to write trace to " << file_path;
+    return false;
+  }
+  return true;
+}
+
+bool Tracing::IsRecording() {
+  return base::trace_event::TraceLog::GetInstance()->IsEnabled();
+}
+
+void TracingUtilities::PostTask(base::SingleThreadTaskRunner* task_runner,
+                                const base::Location& from_here,
+                                const char* name,
+                                base::OnceClosure task) {
+  bool tracing_enabled = false;
+  TRACE_EVENT_CATEGORY_GROUP_ENABLED(OWT_TRACE_CATEGORY, &tracing_enabled);
+  uint64_t flow_id = 0;
+  if (tracing_enabled) {
+    flow_id = next_flow_id.fetch_add(1, std::memory_order_relaxed);
+    TRACE_EVENT_WITH_FLOW1(OWT_TRACE_CATEGORY, "PostTask",
+                           TRACE_ID_LOCAL(flow_id), TRACE_EVENT_FLAG_FLOW_OUT,
+                           "task", name);
+  }
+  task_runner->PostTask(
+      from_here, base::BindOnce(&RunTracedTask, name, flow_id,
+                                base::TimeTicks::Now(), std::move(task)));
+}
+
+}  // namespace quic
+}  // namespace owt
@@ -0,0 +1,36 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef OWT_WEB_TRANSPORT_TRACING_IMPL_H_
+#define OWT_WEB_TRANSPORT_TRACING_IMPL_H_
+
+#include "base/callback.h"
+#include "base/location.h"
+#include "base/task/single_thread_task_runner.h"
+
+namespace owt {
+namespace quic {
+
+// Trace category of events generated by this SDK. Chromium only accepts
+// built-in categories, so it shares the category of the network stack.
+#define OWT_TRACE_CATEGORY "net"
+
+class TracingUtilities {
+ public:
+  // Posts `task` to `task_runner`. The time it waits in the queue is recorded
+  // as MetricHistogram::kEventQueueDelay. When tracing is enabled, the post
+  // and the task are also connected by a flow event, and the task is recorded
+  // as `name` with its queue wait. `name` must be a string literal.
+  static void PostTask(base::SingleThreadTaskRunner* task_runner,
+                       const base::Location& from_here,
+                       const char* name,
+                       base::OnceClosure task);
+};
+
+}  // namespace quic
+}  // namespace owt
+
+#endif
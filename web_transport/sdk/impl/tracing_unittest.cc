@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "owt/quic/tracing.h"
+#include <string>
+#include "base/bind.h"
+#include "base/files/file_util.h"
+#include "base/files/scoped_temp_dir.h"
+#include "base/synchronization/waitable_event.h"
+#include "base/threading/thread.h"
+#include "owt/web_transport/sdk/impl/tracing.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace owt {
+namespace quic {
+namespace test {
+
+TEST(TracingTest, StopWithoutStartFails) {
+  ASSERT_FALSE(Tracing::IsRecording());
+  base::ScopedTempDir temp_dir;
+  ASSERT_TRUE(temp_dir.CreateUniqueTempDir());
+  EXPECT_FALSE(Tracing::StopAndWrite(
+      temp_dir.GetPath().AppendASCII("trace.json").AsUTF8Unsafe().c_str()));
+}
+
+TEST(TracingTest, RecordsQueueWaitOfPostedTasks) {
+  base::ScopedTempDir temp_dir;
+  ASSERT_TRUE(temp_dir.CreateUniqueTempDir());
+  const base::FilePath trace_path =
+      temp_dir.GetPath().AppendASCII("trace.json");
+  base::Thread event_thread("event_thread");
+  ASSERT_TRUE(event_thread.Start());
+
+  ASSERT_TRUE(Tracing::Start(nullptr));
+  EXPECT_TRUE(Tracing::IsRecording());
+  EXPECT_FALSE(Tracing::Start(nullptr));
+  base::WaitableEvent done;
+  TracingUtilities::PostTask(
+      event_thread.task_runner().get(), FROM_HERE, "TracingTest::Task",
+      base::BindOnce(&base::WaitableEvent::Signal, base::Unretained(&done)));
+  done.Wait();
+  ASSERT_TRUE(Tracing::StopAndWrite(trace_path.AsUTF8Unsafe().c_str()));
+  EXPECT_FALSE(Tracing::IsRecording());
+  event_thread.Stop();
+
+  std::string trace;
+  ASSERT_TRUE(base::ReadFileToString(trace_path, &trace));
+  EXPECT_NE(trace.find("TracingTest::Task"), std::string::npos);
+  EXPECT_NE(trace.find("queue_wait_us"), std::string::npos);
+}
+
+TEST(TracingTest, PostTaskRunsTaskWhenNotRecording) {
+  ASSERT_FALSE(Tracing::IsRecording());
+  base::Thread event_thread("event_thread");
+  ASSERT_TRUE(event_thread.Start());
+  base::WaitableEvent done;
+  TracingUtilities::PostTask(
+      event_thread.task_runner().get(), FROM_HERE, "TracingTest::Task",
+      base::BindOnce(&base::WaitableEvent::Signal, base::Unretained(&done)));
+  done.Wait();
+  event_thread.Stop();
+}
+
+}  // namespace test
+}  // namespace quic
+}  // namespace owt
@@ -0,0 +1,317 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "impl/udp_batch_packet_reader.h"
+
+#if defined(OS_LINUX) || defined(OS_CHROMEOS)
+
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/udp.h>
+#include <string.h>
+#include <algorithm>
+#include "base/check.h"
+#include "base/logging.h"
+#include "base/notreached.h"
+#include "base/posix/eintr_wrapper.h"
+#include "base/task/current_thread.h"
+#include "net/base/net_errors.h"
+#include "net/third_party/quiche/src/quic/core/quic_constants.h"
+#include "net/third_party/quiche/src/quic/core/quic_packets.h"
+
+#ifndef SOL_UDP
+#define SOL_UDP 17
+#endif
+#ifndef UDP_GRO
+#define UDP_GRO 104
+#endif
+#ifndef SO_RXQ_OVFL
+#define SO_RXQ_OVFL 40
+#endif
+
+namespace owt {
+namespace quic {
+
+namespace {
+// Number of messages received by a single recvmmsg call.
+constexpr size_t kMessagesPerRead = 16;
+// Max size of a message coalesced by UDP GRO.
+constexpr size_t kMaxGroMessageSize = 64 * 1024;
+// Room for a UDP_GRO segment size, a SO_RXQ_OVFL drop count, and an IP_TOS
+// or IPV6_TCLASS value.
+constexpr size_t kControlBufferSize = CMSG_SPACE(sizeof(int)) +
+                                      CMSG_SPACE(sizeof(uint32_t)) +
+                                      CMSG_SPACE(sizeof(int));
+// ECN codepoints in the low 2 bits of the TOS or traffic class byte (RFC
+// 3168).
+constexpr uint8_t kEcnMask = 0x03;
+constexpr uint8_t kEcnCe = 0x03;
+}  // namespace
+
+UdpBatchPacketReader::UdpBatchPacketReader(int fd,
+                                           const ::quic::QuicClock* clock)
+    : fd_(fd),
+      clock_(clock),
+      gro_enabled_(false),
+      drop_counting_enabled_(false),
+      ecn_counting_enabled_(false),
+      dropped_packets_(0),
+      ect_packets_(0),
+      ce_packets_(0),
+      buffer_size_(::quic::kMaxIncomingPacketSize),
+      dispatching_index_(kMessagesPerRead),
+      headers_(kMessagesPerRead),
+      iovecs_(kMessagesPerRead),
+      peer_addresses_(kMessagesPerRead),
+      control_buffers_(kMessagesPerRead * kControlBufferSize),
+      read_watcher_(FROM_HERE),
+      write_watcher_(FROM_HERE) {
+  CHECK_GE(fd_, 0);
+  CHECK(clock_);
+}
+
+UdpBatchPacketReader::~UdpBatchPacketReader() {
+  read_watcher_.StopWatchingFileDescriptor();
+  write_watcher_.StopWatchingFileDescriptor();
+}
+
+bool UdpBatchPacketReader::EnableGro() {
+  DCHECK(!receive_buffers_);
+  int enabled = 1;
+  if (setsockopt(fd_, SOL_UDP, UDP_GRO, &enabled, sizeof(enabled)) != 0) {
+    LOG(WARNING) << "UDP GRO is not supported, errno: " << errno;
+    return false;
+  }
+  gro_enabled_ = true;
+  buffer_size_ = kMaxGroMessageSize;
+  return true;
+}
+
+bool UdpBatchPacketReader::EnableDropCounting() {
+  DCHECK(!receive_buffers_);
+  int enabled = 1;
+  if (setsockopt(fd_, SOL_SOCKET, SO_RXQ_OVFL, &enabled, sizeof(enabled)) !=
+      0) {
+    LOG(WARNING) << "SO_RXQ_OVFL is not supported, errno: " << errno;
+    return false;
+  }
+  drop_counting_enabled_ = true;
+  return true;
+}
+
+bool UdpBatchPacketReader::EnableEcnCounting() {
+  DCHECK(!receive_buffers_);
+  int enabled = 1;
+  // The socket is dual stack, IPv4 datagrams report IP_TOS.
+  const bool ipv4 =
+      setsockopt(fd_, IPPROTO_IP, IP_RECVTOS, &enabled, sizeof(enabled)) == 0;
+  const bool ipv6 = setsockopt(fd_, IPPROTO_IPV6, IPV6_RECVTCLASS, &enabled,
+                               sizeof(enabled)) == 0;
+  if (!ipv4 && !ipv6) {
+    LOG(WARNING) << "Receiving ECN codepoints is not supported, errno: "
+                 << errno;
+    return false;
+  }
+  ecn_counting_enabled_ = true;
+  return true;
+}
+
+void UdpBatchPacketReader::SetBufferPlacement(
+    const MemoryPlacement& placement) {
+  DCHECK(!receive_buffers_);
+  buffer_placement_ = placement;
+}
+
+int UdpBatchPacketReader::ReadAndDispatchPackets(
+    size_t max_packets,
+    const ::quic::QuicSocketAddress& self_address,
+    ::quic::ProcessPacketInterface* processor,
+    base::OnceClosure callback) {
+  DCHECK(processor);
+  DCHECK(!read_callback_);
+  if (!receive_buffers_) {
+    receive_buffers_ = std::make_unique<ReceiveBufferRing>(
+        kMessagesPerRead, buffer_size_, buffer_placement_);
+  }
+  size_t packets_dispatched = 0;
+  while (packets_dispatched < max_packets) {
+    // recvmmsg overwrites lengths in headers, so they are reset every time.
+    for (size_t i = 0; i < kMessagesPerRead; i++) {
+      iovecs_[i].iov_base = receive_buffers_->GetWritableBuffer(i)->data();
+      iovecs_[i].iov_len = buffer_size_;
+      struct msghdr& header = headers_[i].msg_hdr;
+      memset(&header, 0, sizeof(header));
+      header.msg_name = &peer_addresses_[i];
+      header.msg_namelen = sizeof(peer_addresses_[i]);
+      header.msg_iov = &iovecs_[i];
+      header.msg_iovlen = 1;
+      if (gro_enabled_ || drop_counting_enabled_ || ecn_counting_enabled_) {
+        header.msg_control = control_buffers_.data() + i * kControlBufferSize;
+        header.msg_controllen = kControlBufferSize;
+      }
+      headers_[i].msg_len = 0;
+    }
+    int result = HANDLE_EINTR(recvmmsg(fd_, headers_.data(), kMessagesPerRead,
+                                       MSG_DONTWAIT, nullptr));
+    if (result < 0) {
+      if (errno == EAGAIN || errno == EWOULDBLOCK) {
+        read_callback_ = std::move(callback);
+        if (!base::CurrentIOThread::Get()->WatchFileDescriptor(
+                fd_, /*persistent=*/false,
+                base::MessagePumpForIO::WATCH_READ, &read_watcher_, this)) {
+          read_callback_.Reset();
+          return net::MapSystemError(errno);
+        }
+        return net::ERR_IO_PENDING;
+      }
+      return net::MapSystemError(errno);
+    }
+    const ::quic::QuicTime receive_time = clock_->Now();
+    for (int i = 0; i < result; i++) {
+      DispatchMessage(i, receive_time, self_address, processor);
+    }
+    // Messages coalesced by GRO are counted as one, so the budget is
+    // measured in syscall results rather than datagrams.
+    packets_dispatched += result;
+  }
+  return net::OK;
+}
+
+void UdpBatchPacketReader::OnFileCanReadWithoutBlocking(int fd) {
+  DCHECK_EQ(fd, fd_);
+  DCHECK(read_callback_);
+  std::move(read_callback_).Run();
+}
+
+std::unique_ptr<::quic::QuicReceivedPacket>
+UdpBatchPacketReader::RetainDispatchedPacket(
+    const ::quic::QuicReceivedPacket& packet) {
+  if (dispatching_index_ == kMessagesPerRead) {
+    NOTREACHED();
+    return packet.Clone();
+  }
+  return receive_buffers_->RetainPacket(dispatching_index_, packet);
+}
+
+void UdpBatchPacketReader::WatchWritable(base::OnceClosure callback) {
+  if (write_callback_) {
+    return;
+  }
+  write_callback_ = std::move(callback);
+  if (!base::CurrentIOThread::Get()->WatchFileDescriptor(
+          fd_, /*persistent=*/false, base::MessagePumpForIO::WATCH_WRITE,
+          &write_watcher_, this)) {
+    LOG(ERROR) << "Failed to watch socket for writing, errno: " << errno;
+    write_callback_.Reset();
+  }
+}
+
+void UdpBatchPacketReader::OnFileCanWriteWithoutBlocking(int fd) {
+  DCHECK_EQ(fd, fd_);
+  DCHECK(write_callback_);
+  std::move(write_callback_).Run();
+}
+
+void UdpBatchPacketReader::DispatchMessage(
+    size_t index,
+    ::quic::QuicTime receive_time,
+    const ::quic::QuicSocketAddress& self_address,
+    ::quic::ProcessPacketInterface* processor) {
+  const struct msghdr& header = headers_[index].msg_hdr;
+  ReadDropCount(header);
+  if (header.msg_flags & (MSG_TRUNC | MSG_CTRUNC)) {
+    LOG(WARNING) << "Dropped a truncated UDP message.";
+    return;
+  }
+  const size_t length = headers_[index].msg_len;
+  const size_t segment_size = GetGroSegmentSize(header);
+  const size_t stride =
+      (segment_size == 0 || segment_size > length) ? length : segment_size;
+  if (stride == 0) {
+    return;
+  }
+  const ::quic::QuicSocketAddress peer_address(peer_addresses_[index]);
+  const char* data = static_cast<const char*>(iovecs_[index].iov_base);
+  // GRO only coalesces datagrams with the same TOS, so every datagram of a
+  // message has the same codepoint.
+  const uint8_t ecn = GetEcnCodepoint(header);
+  dispatching_index_ = index;
+  for (size_t offset = 0; offset < length; offset += stride) {
+    const size_t packet_length = std::min(stride, length - offset);
+    if (ecn == kEcnCe) {
+      ce_packets_++;
+    } else if (ecn != 0) {
+      ect_packets_++;
+    }
+    ::quic::QuicReceivedPacket packet(data + offset, packet_length,
+                                      receive_time, /*owns_buffer=*/false);
+    processor->ProcessPacket(self_address, peer_address, packet);
+  }
+  dispatching_index_ = kMessagesPerRead;
+}
+
+size_t UdpBatchPacketReader::GetGroSegmentSize(
+    const struct msghdr& header) const {
+  if (!gro_enabled_) {
+    return 0;
+  }
+  for (const struct cmsghdr* cmsg =
+           CMSG_FIRSTHDR(const_cast<struct msghdr*>(&header));
+       cmsg != nullptr;
+       cmsg = CMSG_NXTHDR(const_cast<struct msghdr*>(&header),
+                          const_cast<struct cmsghdr*>(cmsg))) {
+    if (cmsg->cmsg_level == SOL_UDP && cmsg->cmsg_type == UDP_GRO) {
+      int segment_size = 0;
+      memcpy(&segment_size, CMSG_DATA(cmsg), sizeof(segment_size));
+      return segment_size > 0 ? segment_size : 0;
+    }
+  }
+  return 0;
+}
+
+void UdpBatchPacketReader::ReadDropCount(const struct msghdr& header) {
+  if (!drop_counting_enabled_) {
+    return;
+  }
+  for (const struct cmsghdr* cmsg =
+           CMSG_FIRSTHDR(const_cast<struct msghdr*>(&header));
+       cmsg != nullptr;
+       cmsg = CMSG_NXTHDR(const_cast<struct msghdr*>(&header),
+                          const_cast<struct cmsghdr*>(cmsg))) {
+    if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SO_RXQ_OVFL) {
+      memcpy(&dropped_packets_, CMSG_DATA(cmsg), sizeof(dropped_packets_));
+      return;
+    }
+  }
+}
+
+uint8_t UdpBatchPacketReader::GetEcnCodepoint(
+    const struct msghdr& header) const {
+  if (!ecn_counting_enabled_) {
+    return 0;
+  }
+  for (const struct cmsghdr* cmsg =
+           CMSG_FIRSTHDR(const_cast<struct msghdr*>(&header));
+       cmsg != nullptr;
+       cmsg = CMSG_NXTHDR(const_cast<struct msghdr*>(&header),
+                          const_cast<struct cmsghdr*>(cmsg))) {
+    // IP_TOS carries a byte, IPV6_TCLASS carries an int.
+    if (cmsg->cmsg_level == IPPROTO_IP && cmsg->cmsg_type == IP_TOS) {
+      return *CMSG_DATA(cmsg) & kEcnMask;
+    }
+    if (cmsg->cmsg_level == IPPROTO_IPV6 && cmsg->cmsg_type == IPV6_TCLASS) {
+      int traffic_class = 0;
+      memcpy(&traffic_class, CMSG_DATA(cmsg), sizeof(traffic_class));
+      return traffic_class & kEcnMask;
+    }
+  }
+  return 0;
+}
+
+}  // namespace quic
+}  // namespace owt
+
+#endif  // defined(OS_LINUX) || defined(OS_CHROMEOS)
@@ -0,0 +1,142 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef OWT_WEB_TRANSPORT_UDP_BATCH_PACKET_READER_H_
+#define OWT_WEB_TRANSPORT_UDP_BATCH_PACKET_READER_H_
+
+#include "build/build_config.h"
+
+#if defined(OS_LINUX) || defined(OS_CHROMEOS)
+
+#include <sys/socket.h>
+#include <memory>
+#include <vector>
+#include "base/callback.h"
+#include "base/message_loop/message_pump_for_io.h"
+#include "net/third_party/quiche/src/quic/core/quic_clock.h"
+#include "net/third_party/quiche/src/quic/core/quic_process_packet_interface.h"
+#include "net/third_party/quiche/src/quic/platform/api/quic_socket_address.h"
+#include "owt/web_transport/sdk/impl/receive_buffer_ring.h"
+
+namespace owt {
+namespace quic {
+
+// Reads datagrams from a non-blocking UDP socket with recvmmsg, so multiple
+// datagrams are received by a single syscall. When UDP GRO is enabled, kernel
+// may coalesce datagrams from the same flow into one buffer, they are split
+// before being dispatched. Each message is received into a slot of a
+// ReceiveBufferRing, so a packet could be retained after dispatching without
+// copying.
+// All methods must be called on the thread which owns the socket, and the
+// thread must run an IO message pump.
+class UdpBatchPacketReader : public base::MessagePumpForIO::FdWatcher {
+ public:
+  // `fd` is not owned, and must outlive this object.
+  UdpBatchPacketReader(int fd, const ::quic::QuicClock* clock);
+  ~UdpBatchPacketReader() override;
+  UdpBatchPacketReader(const UdpBatchPacketReader&) = delete;
+  UdpBatchPacketReader& operator=(const UdpBatchPacketReader&) = delete;
+
+  // Enables UDP GRO on the socket. Returns false if it's not supported by
+  // kernel. Must be called before the first read.
+  bool EnableGro();
+  // Enables SO_RXQ_OVFL on the socket, so the number of datagrams dropped by
+  // kernel is reported along with received ones. Returns false if it's not
+  // supported.
+  bool EnableDropCounting();
+  // Enables IP_RECVTOS and IPV6_RECVTCLASS on the socket, so ECN codepoints
+  // of received datagrams are counted. Returns false if neither is supported.
+  // Must be called before the first read.
+  bool EnableEcnCounting();
+  // Places receive buffers with `placement`, e.g.: on the NUMA node of the
+  // thread reading packets. Must be called before the first read.
+  void SetBufferPlacement(const MemoryPlacement& placement);
+
+  // Reads up to `max_packets` datagrams and passes them to `processor`.
+  // Returns net::OK if `max_packets` datagrams are dispatched and there might
+  // be more, net::ERR_IO_PENDING if the socket has no more data, in which case
+  // `callback` will be called once the socket becomes readable. Otherwise,
+  // returns a net error code.
+  int ReadAndDispatchPackets(size_t max_packets,
+                             const ::quic::QuicSocketAddress& self_address,
+                             ::quic::ProcessPacketInterface* processor,
+                             base::OnceClosure callback);
+
+  // Returns a packet sharing the receive buffer of `packet`, which must be the
+  // packet being dispatched to the processor. The packet could be held after
+  // ReadAndDispatchPackets returns, and destroyed on any thread.
+  std::unique_ptr<::quic::QuicReceivedPacket> RetainDispatchedPacket(
+      const ::quic::QuicReceivedPacket& packet);
+
+  // Calls `callback` once the socket becomes writable. It's used by the owner
+  // of the socket to unblock a packet writer sharing the same socket. Calling
+  // it again before `callback` runs has no effect.
+  void WatchWritable(base::OnceClosure callback);
+
+  // Overrides base::MessagePumpForIO::FdWatcher.
+  void OnFileCanReadWithoutBlocking(int fd) override;
+  void OnFileCanWriteWithoutBlocking(int fd) override;
+
+  // Datagrams dropped by kernel since the socket is created, as reported by
+  // the last received datagram. Always 0 if drop counting is not enabled.
+  uint32_t dropped_packets() const { return dropped_packets_; }
+  // Datagrams received with ECT(0) or ECT(1), and with CE, since ECN counting
+  // is enabled.
+  uint64_t ect_packets() const { return ect_packets_; }
+  uint64_t ce_packets() const { return ce_packets_; }
+  // Receive buffers, nullptr before the first read.
+  const ReceiveBufferRing* receive_buffers() const {
+    return receive_buffers_.get();
+  }
+
+ private:
+  // Dispatches the `index`th message of the last recvmmsg call. A message may
+  // carry multiple datagrams when GRO is enabled.
+  void DispatchMessage(size_t index,
+                       ::quic::QuicTime receive_time,
+                       const ::quic::QuicSocketAddress& self_address,
+                       ::quic::ProcessPacketInterface* processor);
+  // Returns the segment size reported by UDP GRO, or 0 if the message is a
+  // single datagram.
+  size_t GetGroSegmentSize(const struct msghdr& header) const;
+  // Updates `dropped_packets_` if `header` carries a SO_RXQ_OVFL value.
+  void ReadDropCount(const struct msghdr& header);
+  // Returns the ECN codepoint carried by `header`, or 0 (Not-ECT) if there is
+  // none.
+  uint8_t GetEcnCodepoint(const struct msghdr& header) const;
+
+  const int fd_;
+  const ::quic::QuicClock* clock_;  // Not owned.
+  bool gro_enabled_;
+  bool drop_counting_enabled_;
+  bool ecn_counting_enabled_;
+  uint32_t dropped_packets_;
+  uint64_t ect_packets_;
+  uint64_t ce_packets_;
+  // Size of each buffer in the ring. It's larger when GRO is enabled, since
+  // a buffer may hold multiple datagrams.
+  size_t buffer_size_;
+  MemoryPlacement buffer_placement_;
+  // A slot of `buffer_size_` bytes for each message.
+  std::unique_ptr<ReceiveBufferRing> receive_buffers_;
+  // Index of the message being dispatched, or kMessagesPerRead otherwise.
+  size_t dispatching_index_;
+  std::vector<struct mmsghdr> headers_;
+  std::vector<struct iovec> iovecs_;
+  std::vector<struct sockaddr_storage> peer_addresses_;
+  std::vector<char> control_buffers_;
+  base::MessagePumpForIO::FdWatchController read_watcher_;
+  base::OnceClosure read_callback_;
+  base::MessagePumpForIO::FdWatchController write_watcher_;
+  base::OnceClosure write_callback_;
+};
+
+}  // namespace quic
+}  // namespace owt
+
+#endif  // defined(OS_LINUX) || defined(OS_CHROMEOS)
+
+#endif
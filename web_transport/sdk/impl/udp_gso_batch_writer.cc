@@ -0,0 +1,186 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "impl/udp_gso_batch_writer.h"
+
+#if defined(OS_LINUX) || defined(OS_CHROMEOS)
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <vector>
+#include "base/check_op.h"
+#include "net/third_party/quiche/src/quic/core/batch_writer/quic_batch_writer_buffer.h"
+#include "net/third_party/quiche/src/quic/core/quic_linux_socket_utils.h"
+
+namespace owt {
+namespace quic {
+
+namespace {
+// Max number of buffered packets. It's also the max number of messages sent
+// by one sendmmsg call.
+constexpr size_t kMaxBufferedPackets = 64;
+// Max number of segments in a GSO message, defined as UDP_MAX_SEGMENTS by
+// kernel.
+constexpr size_t kMaxGsoSegments = 64;
+// Max payload size of a GSO message, which is limited by the 16 bit UDP length
+// field.
+constexpr size_t kMaxGsoPacketSize = 65535;
+
+// A message to be sent. Multiple packets may be coalesced into one message.
+struct OutgoingMessage {
+  size_t packet_count;
+  // Size of each segment when `packet_count` is greater than 1. The last
+  // segment could be smaller.
+  uint16_t segment_size;
+  // Total size of all segments.
+  size_t size;
+};
+
+bool CanCoalesce(const ::quic::BufferedWrite& last_packet,
+                 const ::quic::BufferedWrite& packet,
+                 const OutgoingMessage& message) {
+  if (message.packet_count >= kMaxGsoSegments ||
+      message.size + packet.buf_len > kMaxGsoPacketSize ||
+      last_packet.self_address != packet.self_address ||
+      last_packet.peer_address != packet.peer_address) {
+    return false;
+  }
+  // Buffered writes are stored contiguously in the batch buffer, GSO sends
+  // them as a single buffer.
+  if (last_packet.buffer + last_packet.buf_len != packet.buffer) {
+    return false;
+  }
+  // All segments except the last one must have the same size.
+  return last_packet.buf_len == message.segment_size &&
+         packet.buf_len <= message.segment_size;
+}
+}  // namespace
+
+UdpGsoBatchWriter::UdpGsoBatchWriter(int fd,
+                                     base::RepeatingClosure on_write_blocked)
+    : ::quic::QuicUdpBatchWriter(
+          std::make_unique<::quic::QuicBatchWriterBuffer>(),
+          fd),
+      gso_enabled_(IsGsoSupported(fd)),
+      on_write_blocked_(std::move(on_write_blocked)) {}
+
+UdpGsoBatchWriter::~UdpGsoBatchWriter() = default;
+
+::quic::WriteResult UdpGsoBatchWriter::WritePacket(
+    const char* buffer,
+    size_t buf_len,
+    const ::quic::QuicIpAddress& self_address,
+    const ::quic::QuicSocketAddress& peer_address,
+    ::quic::PerPacketOptions* options) {
+  return CheckBlocked(::quic::QuicUdpBatchWriter::WritePacket(
+      buffer, buf_len, self_address, peer_address, options));
+}
+
+::quic::WriteResult UdpGsoBatchWriter::Flush() {
+  return CheckBlocked(::quic::QuicUdpBatchWriter::Flush());
+}
+
+// static
+bool UdpGsoBatchWriter::IsGsoSupported(int fd) {
+  int segment_size = 0;
+  socklen_t length = sizeof(segment_size);
+  return getsockopt(fd, SOL_UDP, UDP_SEGMENT, &segment_size, &length) == 0;
+}
+
+UdpGsoBatchWriter::CanBatchResult UdpGsoBatchWriter::CanBatch(
+    const char* /*buffer*/,
+    size_t /*buf_len*/,
+    const ::quic::QuicIpAddress& /*self_address*/,
+    const ::quic::QuicSocketAddress& /*peer_address*/,
+    const ::quic::PerPacketOptions* /*options*/,
+    uint64_t /*release_time*/) const {
+  // Packets to different peers can be sent by the same sendmmsg call, so every
+  // packet can be batched.
+  return CanBatchResult(
+      /*can_batch=*/true,
+      /*must_flush=*/buffered_writes().size() + 1 >= kMaxBufferedPackets);
+}
+
+UdpGsoBatchWriter::FlushImplResult UdpGsoBatchWriter::FlushImpl() {
+  FlushImplResult result = {::quic::WriteResult(::quic::WRITE_STATUS_OK, 0),
+                            /*num_packets_sent=*/0, /*bytes_written=*/0};
+  while (!buffered_writes().empty()) {
+    // Group buffered packets into messages.
+    std::vector<::quic::BufferedWrite> messages;
+    std::vector<OutgoingMessage> message_info;
+    const ::quic::BufferedWrite* last_packet = nullptr;
+    for (const ::quic::BufferedWrite& packet : buffered_writes()) {
+      if (gso_enabled_ && last_packet &&
+          CanCoalesce(*last_packet, packet, message_info.back())) {
+        messages.back().buf_len += packet.buf_len;
+        message_info.back().packet_count++;
+        message_info.back().size += packet.buf_len;
+      } else {
+        messages.emplace_back(packet.buffer, packet.buf_len,
+                              packet.self_address, packet.peer_address);
+        message_info.push_back(
+            {/*packet_count=*/1,
+             /*segment_size=*/static_cast<uint16_t>(packet.buf_len),
+             /*size=*/packet.buf_len});
+      }
+      last_packet = &packet;
+    }
+
+    ::quic::QuicMMsgHdr mhdr(
+        messages.begin(), messages.end(),
+        ::quic::kCmsgSpaceForIp + ::quic::kCmsgSpaceForSegmentSize,
+        [&message_info](::quic::QuicMMsgHdr* mhdr, int i,
+                        const ::quic::BufferedWrite& message) {
+          mhdr->SetIpInNextCmsg(i, message.self_address);
+          if (message_info[i].packet_count > 1) {
+            *mhdr->GetNextCmsgData<uint16_t>(i, SOL_UDP, UDP_SEGMENT) =
+                message_info[i].segment_size;
+          }
+        });
+    int num_messages_sent = 0;
+    result.write_result = ::quic::QuicLinuxSocketUtils::WriteMultiplePackets(
+        fd(), &mhdr, &num_messages_sent);
+    if (result.write_result.status != ::quic::WRITE_STATUS_OK) {
+      break;
+    }
+    if (num_messages_sent == 0) {
+      result.write_result.status = ::quic::WRITE_STATUS_BLOCKED;
+      break;
+    }
+    DCHECK_LE(static_cast<size_t>(num_messages_sent), messages.size());
+    size_t packets_sent = 0;
+    for (int i = 0; i < num_messages_sent; i++) {
+      packets_sent += message_info[i].packet_count;
+      result.bytes_written += messages[i].buf_len;
+    }
+    result.num_packets_sent += packets_sent;
+    batch_buffer().PopBufferedWrite(packets_sent);
+  }
+
+  if (result.num_packets_sent == 0) {
+    return result;
+  }
+  // When packets are left in the buffer, the status of the failed write is
+  // kept, so the caller knows whether the writer is blocked.
+  if (buffered_writes().empty()) {
+    result.write_result.status = ::quic::WRITE_STATUS_OK;
+  }
+  result.write_result.bytes_written = result.bytes_written;
+  return result;
+}
+
+::quic::WriteResult UdpGsoBatchWriter::CheckBlocked(
+    const ::quic::WriteResult& result) {
+  if (::quic::IsWriteBlockedStatus(result.status) && on_write_blocked_) {
+    on_write_blocked_.Run();
+  }
+  return result;
+}
+
+}  // namespace quic
+}  // namespace owt
+
+#endif  // defined(OS_LINUX) || defined(OS_CHROMEOS)
@@ -0,0 +1,68 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef OWT_WEB_TRANSPORT_UDP_GSO_BATCH_WRITER_H_
+#define OWT_WEB_TRANSPORT_UDP_GSO_BATCH_WRITER_H_
+
+#include "build/build_config.h"
+
+#if defined(OS_LINUX) || defined(OS_CHROMEOS)
+
+#include <memory>
+#include "base/callback.h"
+#include "net/third_party/quiche/src/quic/core/batch_writer/quic_batch_writer_base.h"
+
+namespace owt {
+namespace quic {
+
+// A batch writer sends all buffered packets with sendmmsg. Consecutive packets
+// to the same peer are coalesced into a single message with UDP GSO if it's
+// supported by kernel, so a burst of packets for multiple connections is
+// usually sent by one syscall. The socket must be non-blocking.
+class UdpGsoBatchWriter : public ::quic::QuicUdpBatchWriter {
+ public:
+  // `fd` is not owned. `on_write_blocked` is called whenever a write or a
+  // flush is blocked by the socket, so the owner of the socket could watch it
+  // for writability. Nothing else resumes a blocked writer. It could be null.
+  UdpGsoBatchWriter(int fd, base::RepeatingClosure on_write_blocked);
+  ~UdpGsoBatchWriter() override;
+
+  // Overrides ::quic::QuicBatchWriterBase.
+  ::quic::WriteResult WritePacket(const char* buffer,
+                                  size_t buf_len,
+                                  const ::quic::QuicIpAddress& self_address,
+                                  const ::quic::QuicSocketAddress& peer_address,
+                                  ::quic::PerPacketOptions* options) override;
+  ::quic::WriteResult Flush() override;
+
+  // Returns true if UDP GSO is supported for `fd`.
+  static bool IsGsoSupported(int fd);
+
+  bool gso_enabled() const { return gso_enabled_; }
+
+ protected:
+  // Overrides ::quic::QuicBatchWriterBase.
+  CanBatchResult CanBatch(const char* buffer,
+                          size_t buf_len,
+                          const ::quic::QuicIpAddress& self_address,
+                          const ::quic::QuicSocketAddress& peer_address,
+                          const ::quic::PerPacketOptions* options,
+                          uint64_t release_time) const override;
+  FlushImplResult FlushImpl() override;
+
+ private:
+  ::quic::WriteResult CheckBlocked(const ::quic::WriteResult& result);
+
+  const bool gso_enabled_;
+  base::RepeatingClosure on_write_blocked_;
+};
+
+}  // namespace quic
+}  // namespace owt
+
+#endif  // defined(OS_LINUX) || defined(OS_CHROMEOS)
+
+#endif
@@ -0,0 +1,172 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "owt/web_transport/sdk/impl/udp_gso_batch_writer.h"
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+#include "base/bind.h"
+#include "base/check_op.h"
+#include "net/third_party/quiche/src/quic/core/quic_constants.h"
+#include "net/third_party/quiche/src/quic/platform/api/quic_socket_address.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace owt {
+namespace quic {
+namespace test {
+
+namespace {
+const size_t kPacketSize = 1000;
+
+// A UDP socket bound to an ephemeral port on IPv4 loopback. Receiving times
+// out after a second.
+class LoopbackSocket {
+ public:
+  explicit LoopbackSocket(bool non_blocking) {
+    fd_ = socket(AF_INET, SOCK_DGRAM, 0);
+    CHECK_GE(fd_, 0);
+    struct sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    CHECK_EQ(bind(fd_, reinterpret_cast<struct sockaddr*>(&address),
+                  sizeof(address)),
+             0);
+    CHECK_EQ(address_.FromSocket(fd_), 0);
+    if (non_blocking) {
+      CHECK_EQ(fcntl(fd_, F_SETFL, fcntl(fd_, F_GETFL) | O_NONBLOCK), 0);
+    }
+    struct timeval timeout = {/*tv_sec=*/1, /*tv_usec=*/0};
+    CHECK_EQ(
+        setsockopt(fd_, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout)),
+        0);
+  }
+  ~LoopbackSocket() { close(fd_); }
+  LoopbackSocket(const LoopbackSocket&) = delete;
+  LoopbackSocket& operator=(const LoopbackSocket&) = delete;
+
+  // Returns an empty string if nothing is received.
+  std::string Receive() {
+    char buffer[2 * kPacketSize];
+    ssize_t length = recv(fd_, buffer, sizeof(buffer), 0);
+    return length > 0 ? std::string(buffer, length) : std::string();
+  }
+
+  int fd() const { return fd_; }
+  const ::quic::QuicSocketAddress& address() const { return address_; }
+
+ private:
+  int fd_;
+  ::quic::QuicSocketAddress address_;
+};
+
+std::string Packet(size_t index, size_t size = kPacketSize) {
+  return std::string(size, static_cast<char>('a' + index % 26));
+}
+}  // namespace
+
+class UdpGsoBatchWriterTest : public testing::Test {
+ protected:
+  UdpGsoBatchWriterTest()
+      : sender_(/*non_blocking=*/true),
+        blocked_writes_(0),
+        writer_(sender_.fd(),
+                base::BindRepeating(
+                    [](int* blocked_writes) { (*blocked_writes)++; },
+                    &blocked_writes_)) {}
+
+  ::quic::WriteResult Write(const std::string& packet,
+                            const LoopbackSocket& receiver) {
+    return writer_.WritePacket(packet.data(), packet.size(),
+                               sender_.address().host(), receiver.address(),
+                               nullptr);
+  }
+
+  LoopbackSocket sender_;
+  int blocked_writes_;
+  UdpGsoBatchWriter writer_;
+};
+
+TEST_F(UdpGsoBatchWriterTest, SendsBufferedPacketsOnFlush) {
+  LoopbackSocket receiver(/*non_blocking=*/false);
+  std::vector<std::string> packets;
+  for (size_t i = 0; i < 10; i++) {
+    // The last segment of a GSO message could be smaller.
+    packets.push_back(Packet(i, i == 9 ? kPacketSize / 2 : kPacketSize));
+    EXPECT_EQ(Write(packets.back(), receiver).status, ::quic::WRITE_STATUS_OK);
+  }
+  EXPECT_EQ(writer_.batch_buffer().SizeInUse(), 9 * kPacketSize +
+                                                    kPacketSize / 2);
+  const ::quic::WriteResult result = writer_.Flush();
+  EXPECT_EQ(result.status, ::quic::WRITE_STATUS_OK);
+  EXPECT_EQ(static_cast<size_t>(result.bytes_written),
+            9 * kPacketSize + kPacketSize / 2);
+  EXPECT_TRUE(writer_.buffered_writes().empty());
+  // Segments of a GSO message are received as separate datagrams.
+  for (const std::string& packet : packets) {
+    EXPECT_EQ(receiver.Receive(), packet);
+  }
+  EXPECT_EQ(blocked_writes_, 0);
+}
+
+TEST_F(UdpGsoBatchWriterTest, SendsToMultiplePeersInOneFlush) {
+  LoopbackSocket receiver1(/*non_blocking=*/false);
+  LoopbackSocket receiver2(/*non_blocking=*/false);
+  for (size_t i = 0; i < 6; i++) {
+    Write(Packet(i), i % 2 == 0 ? receiver1 : receiver2);
+  }
+  EXPECT_EQ(writer_.Flush().status, ::quic::WRITE_STATUS_OK);
+  for (size_t i = 0; i < 6; i++) {
+    EXPECT_EQ((i % 2 == 0 ? receiver1 : receiver2).Receive(), Packet(i));
+  }
+}
+
+TEST_F(UdpGsoBatchWriterTest, FlushesWhenBufferIsFull) {
+  LoopbackSocket receiver(/*non_blocking=*/false);
+  // 64 packets fill the buffer, the last write flushes them without a Flush()
+  // call.
+  for (size_t i = 0; i < 64; i++) {
+    EXPECT_EQ(Write(Packet(i), receiver).status, ::quic::WRITE_STATUS_OK);
+  }
+  EXPECT_TRUE(writer_.buffered_writes().empty());
+  for (size_t i = 0; i < 64; i++) {
+    EXPECT_EQ(receiver.Receive(), Packet(i));
+  }
+}
+
+TEST_F(UdpGsoBatchWriterTest, SplitsMessagesLargerThanGsoLimit) {
+  LoopbackSocket receiver(/*non_blocking=*/false);
+  // 64 full-size packets exceed the 65535 bytes limit of a GSO message, so
+  // they must be sent as more than one message, otherwise sendmmsg fails.
+  const size_t packet_size = ::quic::kMaxOutgoingPacketSize;
+  ASSERT_GT(64 * packet_size, 65535u);
+  for (size_t i = 0; i < 64; i++) {
+    EXPECT_EQ(Write(Packet(i, packet_size), receiver).status,
+              ::quic::WRITE_STATUS_OK);
+  }
+  EXPECT_TRUE(writer_.buffered_writes().empty());
+  for (size_t i = 0; i < 64; i++) {
+    EXPECT_EQ(receiver.Receive(), Packet(i, packet_size));
+  }
+  EXPECT_EQ(blocked_writes_, 0);
+}
+
+TEST_F(UdpGsoBatchWriterTest, ErrorsAreNotReportedAsBlocked) {
+  // Sending to port 0 fails with EINVAL.
+  const std::string packet = Packet(0);
+  writer_.WritePacket(packet.data(), packet.size(), sender_.address().host(),
+                      ::quic::QuicSocketAddress(sender_.address().host(), 0),
+                      nullptr);
+  EXPECT_EQ(writer_.Flush().status, ::quic::WRITE_STATUS_ERROR);
+  EXPECT_EQ(blocked_writes_, 0);
+}
+
+}  // namespace test
+}  // namespace quic
+}  // namespace owt
@@ -0,0 +1,423 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "impl/udp_packet_io_engine.h"
+#include <algorithm>
+#include <limits>
+#include "base/bind.h"
+#include "base/logging.h"
+#include "base/trace_event/trace_event.h"
+#include "impl/tracing.h"
+#include "net/base/net_errors.h"
+#include "net/quic/address_utils.h"
+#include "net/third_party/quiche/src/quic/core/quic_constants.h"
+#include "net/tools/quic/quic_simple_server_packet_writer.h"
+#include "net/tools/quic/quic_simple_server_socket.h"
+#if defined(OS_LINUX) || defined(OS_CHROMEOS)
+#include <fcntl.h>
+#include <sys/socket.h>
+#include "impl/udp_gso_batch_writer.h"
+#endif
+
+namespace owt {
+namespace quic {
+
+namespace {
+constexpr size_t kMaxReadsPerEvent = 32;
+constexpr size_t kMaxNewConnectionsPerEvent = 32;
+constexpr int kReadBufferSize = 2 * ::quic::kMaxIncomingPacketSize;
+// A read pass longer than this delays alarms and writes on the IO thread.
+constexpr int64_t kTargetReadPassDurationMs = 4;
+#if defined(OS_LINUX) || defined(OS_CHROMEOS)
+// Batched reads are cheaper, so more packets are read before yielding to
+// other tasks.
+constexpr size_t kMaxBatchedReadsPerEvent = 4 * kMaxReadsPerEvent;
+#endif
+// Same as net::CreateQuicSimpleServerSocket's.
+constexpr int kDefaultSocketReceiveBufferSize =
+    ::quic::kDefaultSocketReceiveBuffer;
+constexpr int kDefaultSocketSendBufferSize =
+    20 * ::quic::kMaxOutgoingPacketSize;
+
+size_t DefaultMaxPacketsPerRead() {
+#if defined(OS_LINUX) || defined(OS_CHROMEOS)
+  return kMaxBatchedReadsPerEvent;
+#else
+  return kMaxReadsPerEvent;
+#endif
+}
+
+int OptionOrDefault(size_t option, int default_value) {
+  return option > 0 ? static_cast<int>(std::min<size_t>(
+                          option, std::numeric_limits<int>::max()))
+                    : default_value;
+}
+}  // namespace
+
+UdpPacketIoEngine::UdpPacketIoEngine(const Options& options,
+                                     base::SingleThreadTaskRunner* io_runner,
+                                     const ::quic::QuicClock* clock)
+    : socket_receive_buffer_size_(
+          OptionOrDefault(options.socket_receive_buffer_size,
+                          kDefaultSocketReceiveBufferSize)),
+      socket_send_buffer_size_(OptionOrDefault(options.socket_send_buffer_size,
+                                               kDefaultSocketSendBufferSize)),
+      reuse_port_(options.reuse_port),
+      buffer_placement_(options.buffer_placement),
+      io_runner_(io_runner),
+      clock_(clock),
+      delegate_(nullptr),
+      read_budget_(std::make_unique<ReadBudgetScheduler>(
+          options.max_packets_per_read > 0 ? options.max_packets_per_read
+                                           : DefaultMaxPacketsPerRead(),
+          options.max_new_connections_per_read > 0
+              ? options.max_new_connections_per_read
+              : kMaxNewConnectionsPerEvent,
+          ::quic::QuicTime::Delta::FromMilliseconds(
+              kTargetReadPassDurationMs))),
+      read_buffers_(/*slot_count=*/1,
+                    kReadBufferSize,
+                    options.buffer_placement) {
+  CHECK(io_runner_);
+  CHECK(clock_);
+}
+
+UdpPacketIoEngine::~UdpPacketIoEngine() {
+  Stop();
+}
+
+void UdpPacketIoEngine::SetSocketToAdopt(int fd) {
+#if defined(OS_LINUX) || defined(OS_CHROMEOS)
+  DCHECK_EQ(adopted_socket_fd_, ::quic::kQuicInvalidSocketFd);
+  adopted_socket_fd_ = fd;
+#else
+  NOTREACHED() << "Taking over sockets is only supported on Linux.";
+#endif
+}
+
+bool UdpPacketIoEngine::Bind(uint16_t port) {
+  DCHECK(io_runner_->BelongsToCurrentThread());
+#if defined(OS_LINUX) || defined(OS_CHROMEOS)
+  if (adopted_socket_fd_ != ::quic::kQuicInvalidSocketFd) {
+    return AdoptBatchSocket();
+  }
+  if (CreateBatchSocket(port)) {
+    return true;
+  }
+  LOG(WARNING) << "Failed to create batch socket, fall back to UDPSocket.";
+#endif
+  // Sockets created by net::CreateQuicSimpleServerSocket can't share a port.
+  if (reuse_port_) {
+    return false;
+  }
+  socket_ = net::CreateQuicSimpleServerSocket(
+      net::IPEndPoint{net::IPAddress::IPv6AllZeros(), port}, &server_address_);
+  if (socket_ == nullptr) {
+    return false;
+  }
+  if (socket_->SetReceiveBufferSize(socket_receive_buffer_size_) != net::OK ||
+      socket_->SetSendBufferSize(socket_send_buffer_size_) != net::OK) {
+    LOG(WARNING) << "Failed to set socket buffer sizes.";
+  }
+  return true;
+}
+
+std::unique_ptr<::quic::QuicPacketWriter> UdpPacketIoEngine::CreateWriter(
+    ::quic::QuicDispatcher* dispatcher) {
+  DCHECK(io_runner_->BelongsToCurrentThread());
+#if defined(OS_LINUX) || defined(OS_CHROMEOS)
+  if (batch_reader_) {
+    // Blocked writes are resumed by OnCanWrite().
+    return std::make_unique<UdpGsoBatchWriter>(
+        batch_socket_fd_,
+        base::BindRepeating(&UdpPacketIoEngine::OnWriteBlocked,
+                            weak_factory_.GetWeakPtr()));
+  }
+#endif
+  DCHECK(socket_);
+  return std::make_unique<net::QuicSimpleServerPacketWriter>(socket_.get(),
+                                                             dispatcher);
+}
+
+void UdpPacketIoEngine::StartReading(Delegate* delegate) {
+  DCHECK(io_runner_->BelongsToCurrentThread());
+  DCHECK(delegate);
+  delegate_ = delegate;
+  ScheduleReadPackets();
+}
+
+void UdpPacketIoEngine::Stop() {
+  DCHECK(io_runner_->BelongsToCurrentThread());
+  weak_factory_.InvalidateWeakPtrs();
+  delegate_ = nullptr;
+  socket_.reset();
+#if defined(OS_LINUX) || defined(OS_CHROMEOS)
+  CloseBatchSocket();
+  if (adopted_socket_fd_ != ::quic::kQuicInvalidSocketFd) {
+    ::quic::QuicUdpSocketApi().Destroy(adopted_socket_fd_);
+    adopted_socket_fd_ = ::quic::kQuicInvalidSocketFd;
+  }
+#endif
+}
+
+int UdpPacketIoEngine::DuplicateSocket() const {
+  DCHECK(io_runner_->BelongsToCurrentThread());
+#if defined(OS_LINUX) || defined(OS_CHROMEOS)
+  if (batch_socket_fd_ != ::quic::kQuicInvalidSocketFd) {
+    return fcntl(batch_socket_fd_, F_DUPFD_CLOEXEC, 0);
+  }
+#endif
+  return -1;
+}
+
+uint64_t UdpPacketIoEngine::dropped_packets() const {
+#if defined(OS_LINUX) || defined(OS_CHROMEOS)
+  if (batch_reader_) {
+    return batch_reader_->dropped_packets();
+  }
+#endif
+  return 0;
+}
+
+uint64_t UdpPacketIoEngine::ect_packets() const {
+#if defined(OS_LINUX) || defined(OS_CHROMEOS)
+  if (batch_reader_) {
+    return batch_reader_->ect_packets();
+  }
+#endif
+  return 0;
+}
+
+uint64_t UdpPacketIoEngine::ce_packets() const {
+#if defined(OS_LINUX) || defined(OS_CHROMEOS)
+  if (batch_reader_) {
+    return batch_reader_->ce_packets();
+  }
+#endif
+  return 0;
+}
+
+std::unique_ptr<::quic::QuicReceivedPacket> UdpPacketIoEngine::RetainPacket(
+    const ::quic::QuicReceivedPacket& packet) {
+  DCHECK(io_runner_->BelongsToCurrentThread());
+#if defined(OS_LINUX) || defined(OS_CHROMEOS)
+  if (batch_reader_) {
+    return batch_reader_->RetainDispatchedPacket(packet);
+  }
+#endif
+  return read_buffers_.RetainPacket(0, packet);
+}
+
+void UdpPacketIoEngine::ProcessPacket(
+    const ::quic::QuicSocketAddress& self_address,
+    const ::quic::QuicSocketAddress& peer_address,
+    const ::quic::QuicReceivedPacket& packet) {
+  packets_read_in_pass_++;
+  delegate_->ProcessPacket(self_address, peer_address, packet);
+}
+
+void UdpPacketIoEngine::ScheduleReadPackets() {
+  io_runner_->PostTask(FROM_HERE,
+                       base::BindOnce(&UdpPacketIoEngine::ReadPackets,
+                                      weak_factory_.GetWeakPtr()));
+}
+
+void UdpPacketIoEngine::ReadPackets() {
+  TRACE_EVENT0(OWT_TRACE_CATEGORY, "UdpPacketIoEngine::ReadPackets");
+  read_pass_start_ = clock_->Now();
+  packets_read_in_pass_ = 0;
+  connections_created_before_pass_ = delegate_->NumConnectionsCreated();
+  delegate_->OnReadPassStarted(read_budget_->connection_budget());
+#if defined(OS_LINUX) || defined(OS_CHROMEOS)
+  if (batch_reader_) {
+    ReadPacketBatches();
+    return;
+  }
+#endif
+  const size_t packet_budget = read_budget_->packet_budget();
+  for (size_t i = 0; i < packet_budget; i++) {
+    read_buffer_ = read_buffers_.GetWritableBuffer(0);
+    int result = socket_->RecvFrom(
+        read_buffer_, read_buffer_->size(), &client_address_,
+        base::BindOnce(&UdpPacketIoEngine::OnReadComplete,
+                       base::Unretained(this)));
+    if (result == net::ERR_IO_PENDING) {
+      OnReadPassComplete(/*socket_drained=*/true);
+      return;
+    }
+    ProcessReadPacket(result);
+  }
+  OnReadPassComplete(/*socket_drained=*/false);
+  ScheduleReadPackets();
+}
+
+void UdpPacketIoEngine::OnReadPassComplete(bool socket_drained) {
+  TRACE_EVENT_INSTANT2(OWT_TRACE_CATEGORY,
+                       "UdpPacketIoEngine::ReadPassComplete",
+                       TRACE_EVENT_SCOPE_THREAD, "packets",
+                       packets_read_in_pass_, "socket_drained", socket_drained);
+  ReadBudgetScheduler::PassResult result;
+  result.packets_read = packets_read_in_pass_;
+  result.connections_created =
+      delegate_->NumConnectionsCreated() - connections_created_before_pass_;
+  result.socket_drained = socket_drained;
+  result.chlos_buffered = delegate_->HasChlosBuffered();
+  result.duration = clock_->Now() - read_pass_start_;
+  busy_time_ = busy_time_ + result.duration;
+  const size_t previous_connection_budget = read_budget_->connection_budget();
+  read_budget_->OnPassComplete(result);
+  if (result.chlos_buffered &&
+      read_budget_->connection_budget() < previous_connection_budget) {
+    VLOG(1) << "Holding back new connections on "
+            << server_address_.ToString()
+            << ", budget: " << read_budget_->connection_budget()
+            << ", pass duration: " << result.duration.ToDebuggingValue();
+  }
+}
+
+void UdpPacketIoEngine::OnReadComplete(int result) {
+  ProcessReadPacket(result);
+  ReadPackets();
+}
+
+void UdpPacketIoEngine::ProcessReadPacket(int result) {
+  TRACE_EVENT1(OWT_TRACE_CATEGORY, "UdpPacketIoEngine::ProcessReadPacket",
+               "result", result);
+  if (result == 0)
+    result = net::ERR_CONNECTION_CLOSED;
+  if (result < 0) {
+    OnReadError(result);
+    return;
+  }
+
+  ::quic::QuicReceivedPacket packet(read_buffer_->data(), /*length=*/result,
+                                    clock_->Now(), /*owns_buffer=*/false);
+  ProcessPacket(net::ToQuicSocketAddress(server_address_),
+                net::ToQuicSocketAddress(client_address_), packet);
+}
+
+void UdpPacketIoEngine::OnReadError(int result) {
+  LOG(ERROR) << "UDP read failed: " << net::ErrorToString(result);
+  delegate_->OnReadError(result);
+}
+
+#if defined(OS_LINUX) || defined(OS_CHROMEOS)
+bool UdpPacketIoEngine::CreateBatchSocket(uint16_t port) {
+  ::quic::QuicUdpSocketApi socket_api;
+  ::quic::QuicUdpSocketFd fd = socket_api.Create(
+      AF_INET6, socket_receive_buffer_size_, socket_send_buffer_size_);
+  if (fd == ::quic::kQuicInvalidSocketFd) {
+    return false;
+  }
+  if (reuse_port_) {
+    int reuse_port = 1;
+    if (setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &reuse_port,
+                   sizeof(reuse_port)) != 0) {
+      LOG(ERROR) << "Failed to set SO_REUSEPORT, errno: " << errno;
+      socket_api.Destroy(fd);
+      return false;
+    }
+  }
+  ::quic::QuicSocketAddress address(::quic::QuicIpAddress::Any6(), port);
+  if (!socket_api.Bind(fd, address) || address.FromSocket(fd) != 0) {
+    socket_api.Destroy(fd);
+    return false;
+  }
+  UseBatchSocket(fd, address);
+  return true;
+}
+
+bool UdpPacketIoEngine::AdoptBatchSocket() {
+  ::quic::QuicUdpSocketFd fd = adopted_socket_fd_;
+  adopted_socket_fd_ = ::quic::kQuicInvalidSocketFd;
+  int type = 0;
+  socklen_t type_length = sizeof(type);
+  ::quic::QuicSocketAddress address;
+  // Options set by CreateBatchSocket(), e.g.: packet info and buffer sizes,
+  // belong to the socket, so they are kept when it's passed between
+  // processes. Only the file status flags are checked.
+  if (getsockopt(fd, SOL_SOCKET, SO_TYPE, &type, &type_length) != 0 ||
+      type != SOCK_DGRAM || address.FromSocket(fd) != 0 ||
+      address.port() == 0 ||
+      fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK) != 0) {
+    LOG(ERROR) << "Socket " << fd << " is not a bound UDP socket.";
+    ::quic::QuicUdpSocketApi().Destroy(fd);
+    return false;
+  }
+  UseBatchSocket(fd, address);
+  LOG(INFO) << "Took over socket bound to " << address.ToString() << ".";
+  return true;
+}
+
+void UdpPacketIoEngine::UseBatchSocket(
+    ::quic::QuicUdpSocketFd fd,
+    const ::quic::QuicSocketAddress& address) {
+  server_address_ = net::ToIPEndPoint(address);
+  batch_socket_fd_ = fd;
+  batch_reader_ = std::make_unique<UdpBatchPacketReader>(fd, clock_);
+  batch_reader_->EnableGro();
+  batch_reader_->EnableDropCounting();
+  batch_reader_->EnableEcnCounting();
+  batch_reader_->SetBufferPlacement(buffer_placement_);
+}
+
+void UdpPacketIoEngine::ReadPacketBatches() {
+  TRACE_EVENT0(OWT_TRACE_CATEGORY, "UdpPacketIoEngine::ReadPacketBatches");
+  int result = batch_reader_->ReadAndDispatchPackets(
+      read_budget_->packet_budget(), net::ToQuicSocketAddress(server_address_),
+      this,
+      base::BindOnce(&UdpPacketIoEngine::ReadPackets,
+                     base::Unretained(this)));
+  if (result == net::ERR_IO_PENDING) {
+    OnReadPassComplete(/*socket_drained=*/true);
+    return;
+  }
+  if (result != net::OK) {
+    OnReadError(result);
+    return;
+  }
+  OnReadPassComplete(/*socket_drained=*/false);
+  ScheduleReadPackets();
+}
+
+void UdpPacketIoEngine::OnWriteBlocked() {
+  // The writer is blocked before its connection is added to the dispatcher's
+  // write blocked list, so the socket is watched regardless of
+  // HasPendingWrites().
+  if (batch_reader_) {
+    batch_reader_->WatchWritable(base::BindOnce(
+        &UdpPacketIoEngine::OnCanWrite, base::Unretained(this)));
+  }
+}
+
+void UdpPacketIoEngine::MaybeWatchWritable() {
+  if (!delegate_ || !delegate_->HasPendingWrites()) {
+    return;
+  }
+  OnWriteBlocked();
+}
+
+void UdpPacketIoEngine::OnCanWrite() {
+  if (!delegate_) {
+    return;
+  }
+  delegate_->OnCanWrite();
+  // Writers blocked again re-arm the watcher themselves. Connections which
+  // didn't get a chance to write are still blocked.
+  MaybeWatchWritable();
+}
+
+void UdpPacketIoEngine::CloseBatchSocket() {
+  batch_reader_.reset();
+  if (batch_socket_fd_ != ::quic::kQuicInvalidSocketFd) {
+    ::quic::QuicUdpSocketApi().Destroy(batch_socket_fd_);
+    batch_socket_fd_ = ::quic::kQuicInvalidSocketFd;
+  }
+}
+#endif
+
+}  // namespace quic
+}  // namespace owt
@@ -0,0 +1,205 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef OWT_WEB_TRANSPORT_UDP_PACKET_IO_ENGINE_H_
+#define OWT_WEB_TRANSPORT_UDP_PACKET_IO_ENGINE_H_
+
+#include <memory>
+#include "base/memory/scoped_refptr.h"
+#include "base/memory/weak_ptr.h"
+#include "base/task/single_thread_task_runner.h"
+#include "build/build_config.h"
+#include "net/base/io_buffer.h"
+#include "net/base/ip_endpoint.h"
+#include "net/socket/udp_server_socket.h"
+#include "net/third_party/quiche/src/quic/core/quic_clock.h"
+#include "net/third_party/quiche/src/quic/core/quic_dispatcher.h"
+#include "net/third_party/quiche/src/quic/core/quic_packet_writer.h"
+#include "net/third_party/quiche/src/quic/core/quic_process_packet_interface.h"
+#include "owt/web_transport/sdk/impl/read_budget_scheduler.h"
+#include "owt/web_transport/sdk/impl/receive_buffer_ring.h"
+#if defined(OS_LINUX) || defined(OS_CHROMEOS)
+#include "net/third_party/quiche/src/quic/core/quic_udp_socket.h"
+#include "owt/web_transport/sdk/impl/udp_batch_packet_reader.h"
+#endif
+
+namespace owt {
+namespace quic {
+
+// Owns a server's UDP socket and moves packets between the socket and a
+// dispatcher. On Linux, packets are received with recvmmsg and GRO, and sent
+// with sendmmsg and GSO. Otherwise, it falls back to net::UDPServerSocket.
+// Reads are split into passes whose packet and connection budgets are chosen
+// by a ReadBudgetScheduler, so reading yields to alarms and writes on the same
+// thread. Anything reading and writing QUIC packets on a server socket should
+// be built on this class, so optimizations of packet I/O land in one place.
+// All methods must be called on `io_runner`.
+class UdpPacketIoEngine : public ::quic::ProcessPacketInterface {
+ public:
+  // Receives packets read by the engine. Usually implemented on top of a
+  // ::quic::QuicDispatcher.
+  class Delegate : public ::quic::ProcessPacketInterface {
+   public:
+    ~Delegate() override = default;
+    // Called at the beginning of each read pass. Up to `connection_budget`
+    // connections could be created before reading, e.g.: for buffered CHLOs.
+    virtual void OnReadPassStarted(size_t connection_budget) = 0;
+    // Returns the number of connections created since the delegate is
+    // created.
+    virtual uint64_t NumConnectionsCreated() const = 0;
+    // Returns true if there are CHLOs waiting for new connections.
+    virtual bool HasChlosBuffered() const = 0;
+    // Returns true if writers are blocked by the socket.
+    virtual bool HasPendingWrites() const = 0;
+    // Called when the socket becomes writable after HasPendingWrites()
+    // returned true.
+    virtual void OnCanWrite() = 0;
+    // Called when reading from the socket fails.
+    virtual void OnReadError(int result) = 0;
+  };
+
+  // 0 means default value.
+  struct Options {
+    size_t socket_receive_buffer_size = 0;
+    size_t socket_send_buffer_size = 0;
+    size_t max_packets_per_read = 0;
+    size_t max_new_connections_per_read = 0;
+    // Whether other sockets could be bound to the same port with
+    // SO_REUSEPORT.
+    bool reuse_port = false;
+    // Placement of receive buffers.
+    MemoryPlacement buffer_placement;
+  };
+
+  UdpPacketIoEngine(const Options& options,
+                    base::SingleThreadTaskRunner* io_runner,
+                    const ::quic::QuicClock* clock);
+  ~UdpPacketIoEngine() override;
+  UdpPacketIoEngine(const UdpPacketIoEngine&) = delete;
+  UdpPacketIoEngine& operator=(const UdpPacketIoEngine&) = delete;
+
+  // Makes Bind() take over `fd`, a bound UDP socket duplicated by
+  // DuplicateSocket(), e.g.: in another process, instead of creating a new
+  // socket. The engine owns `fd`. Could be called on any thread before
+  // Bind(). Linux only.
+  void SetSocketToAdopt(int fd);
+  // Binds a UDP socket to `port`, or takes over the socket set by
+  // SetSocketToAdopt(). Returns false if the socket cannot be created.
+  bool Bind(uint16_t port);
+  // Returns a duplicate of the socket owned by the caller, or -1 if the socket
+  // cannot be duplicated. Sockets other than Linux batch sockets are not
+  // supported.
+  int DuplicateSocket() const;
+  // Creates a packet writer for the socket. `dispatcher` is notified when a
+  // blocked writer becomes writable, if the platform socket reports it to
+  // writers directly. Must be called after Bind().
+  std::unique_ptr<::quic::QuicPacketWriter> CreateWriter(
+      ::quic::QuicDispatcher* dispatcher);
+  // Starts reading packets and passing them to `delegate`. `delegate` must
+  // outlive this object or a Stop() call.
+  void StartReading(Delegate* delegate);
+  // Stops reading and closes the socket.
+  void Stop();
+
+  const net::IPEndPoint& server_address() const { return server_address_; }
+  // Statistics of the read loop, e.g.: CHLO backlog and time spent per pass.
+  const ReadBudgetScheduler::Stats& read_stats() const {
+    return read_budget_->stats();
+  }
+  // Total time spent in read passes.
+  ::quic::QuicTime::Delta busy_time() const { return busy_time_; }
+  // Datagrams dropped by kernel, if it's reported by the socket.
+  uint64_t dropped_packets() const;
+  // Datagrams received with ECT(0) or ECT(1), and with CE, if the socket
+  // reports ECN codepoints.
+  uint64_t ect_packets() const;
+  uint64_t ce_packets() const;
+  // Returns a packet sharing the receive buffer of `packet`, which must be the
+  // packet being processed by the delegate. The delegate could hold it after
+  // processing, or pass it to another thread, without copying.
+  std::unique_ptr<::quic::QuicReceivedPacket> RetainPacket(
+      const ::quic::QuicReceivedPacket& packet);
+
+  // Overrides ::quic::ProcessPacketInterface. Packets read from the socket are
+  // counted and passed to the delegate.
+  void ProcessPacket(const ::quic::QuicSocketAddress& self_address,
+                     const ::quic::QuicSocketAddress& peer_address,
+                     const ::quic::QuicReceivedPacket& packet) override;
+
+ private:
+  // Schedules a ReadPackets() call on the next iteration of the event loop.
+  void ScheduleReadPackets();
+  // Creates connections for buffered CHLOs and reads packets within budgets
+  // chosen by `read_budget_`, and then reschedules itself.
+  void ReadPackets();
+  // Reports the result of current read pass to `read_budget_`.
+  void OnReadPassComplete(bool socket_drained);
+  // Called when an asynchronous read from the socket is complete.
+  void OnReadComplete(int result);
+  // Passes the most recently read packet into the delegate.
+  void ProcessReadPacket(int result);
+  void OnReadError(int result);
+#if defined(OS_LINUX) || defined(OS_CHROMEOS)
+  // Creates a non-blocking UDP socket and a batch reader for it. Returns false
+  // if the socket cannot be created.
+  bool CreateBatchSocket(uint16_t port);
+  // Takes over `adopted_socket_fd_`. Returns false if it's not a bound UDP
+  // socket.
+  bool AdoptBatchSocket();
+  // Reads packets from `fd` bound to `address` with a batch reader.
+  void UseBatchSocket(::quic::QuicUdpSocketFd fd,
+                      const ::quic::QuicSocketAddress& address);
+  // Reads packets with `batch_reader_`, and then reschedules itself.
+  void ReadPacketBatches();
+  // Called by the batch writer when the socket blocks a write. Watches the
+  // socket for writing.
+  void OnWriteBlocked();
+  // Watches the socket for writing if the delegate has blocked writers.
+  void MaybeWatchWritable();
+  void OnCanWrite();
+  void CloseBatchSocket();
+#endif
+
+  // Socket buffer sizes and upper bounds of read budgets, defaults are
+  // resolved.
+  const int socket_receive_buffer_size_;
+  const int socket_send_buffer_size_;
+  const bool reuse_port_;
+  const MemoryPlacement buffer_placement_;
+  base::SingleThreadTaskRunner* io_runner_;
+  const ::quic::QuicClock* clock_;  // Not owned.
+  Delegate* delegate_;              // Not owned.
+  std::unique_ptr<ReadBudgetScheduler> read_budget_;
+  // States of current read pass.
+  ::quic::QuicTime read_pass_start_ = ::quic::QuicTime::Zero();
+  size_t packets_read_in_pass_ = 0;
+  uint64_t connections_created_before_pass_ = 0;
+  ::quic::QuicTime::Delta busy_time_ = ::quic::QuicTime::Delta::Zero();
+  std::unique_ptr<net::UDPServerSocket> socket_;
+  net::IPEndPoint server_address_;
+
+  // Results of the potentially asynchronous read operation. `read_buffer_`
+  // is the only slot of `read_buffers_`, it's valid until the next read.
+  ReceiveBufferRing read_buffers_;
+  net::IOBufferWithSize* read_buffer_ = nullptr;
+  net::IPEndPoint client_address_;
+
+#if defined(OS_LINUX) || defined(OS_CHROMEOS)
+  // Receives multiple packets per syscall. When it's created, `socket_` is not
+  // used.
+  ::quic::QuicUdpSocketFd batch_socket_fd_ = ::quic::kQuicInvalidSocketFd;
+  // Set by SetSocketToAdopt(), and taken over by Bind().
+  ::quic::QuicUdpSocketFd adopted_socket_fd_ = ::quic::kQuicInvalidSocketFd;
+  std::unique_ptr<UdpBatchPacketReader> batch_reader_;
+#endif
+
+  base::WeakPtrFactory<UdpPacketIoEngine> weak_factory_{this};
+};
+
+}  // namespace quic
+}  // namespace owt
+
+#endif
@@ -5,9 +5,76 @@
  */
 
 #include "owt/web_transport/sdk/impl/utilities.h"
+#include <algorithm>
+#include <cstring>
+#include "base/check.h"
+#include "base/notreached.h"
+#include "net/quic/platform/impl/quic_mem_slice_impl.h"
+#include "net/third_party/quiche/src/quic/core/quic_buffer_allocator.h"
+#include "net/third_party/quiche/src/quic/core/quic_constants.h"
 
 namespace owt {
 namespace quic {
+
+namespace {
+// A QuicBufferAllocator which never allocates memory. It's created for a single
+// external buffer, and invokes application's release callback when the buffer
+// is deleted by QUIC.
+class ExternalBufferReleaser : public ::quic::QuicBufferAllocator {
+ public:
+  ExternalBufferReleaser(size_t length,
+                         BufferReleaseCallback release,
+                         void* release_context)
+      : length_(length), release_(release), release_context_(release_context) {}
+  ~ExternalBufferReleaser() override = default;
+
+  char* New(size_t size) override {
+    NOTREACHED();
+    return nullptr;
+  }
+  char* New(size_t size, bool flag_enable) override {
+    NOTREACHED();
+    return nullptr;
+  }
+  void Delete(char* buffer) override {
+    if (release_) {
+      release_(reinterpret_cast<uint8_t*>(buffer), length_, release_context_);
+    }
+    delete this;
+  }
+
+ private:
+  size_t length_;
+  BufferReleaseCallback release_;
+  void* release_context_;
+};
+
+// An IOBuffer wrapping an external buffer. It invokes application's release
+// callback when the last reference is released.
+class ExternalIOBuffer : public net::WrappedIOBuffer {
+ public:
+  ExternalIOBuffer(uint8_t* data,
+                   size_t length,
+                   BufferReleaseCallback release,
+                   void* release_context)
+      : net::WrappedIOBuffer(reinterpret_cast<const char*>(data)),
+        length_(length),
+        release_(release),
+        release_context_(release_context) {}
+
+ private:
+  ~ExternalIOBuffer() override {
+    if (release_) {
+      release_(reinterpret_cast<uint8_t*>(data()), length_, release_context_);
+    }
+  }
+
+  size_t length_;
+  BufferReleaseCallback release_;
+  void* release_context_;
+};
+}  // namespace
+
 MessageStatus Utilities::ConvertMessageStatus(
     absl::optional<::quic::MessageStatus> status) {
   if (!status) {
@@ -30,5 +97,168 @@ MessageStatus Utilities::ConvertMessageStatus(
       return MessageStatus::kUnavailable;
   }
 }
+
+::quic::CongestionControlType Utilities::ConvertCongestionControlType(
+    CongestionControlType type) {
+  switch (type) {
+    case CongestionControlType::kCubic:
+      return ::quic::kCubicBytes;
+    case CongestionControlType::kReno:
+      return ::quic::kRenoBytes;
+    case CongestionControlType::kBbrV2:
+      return ::quic::kBBRv2;
+    case CongestionControlType::kDefault:
+    case CongestionControlType::kBbr:
+    default:
+      return ::quic::kBBR;
+  }
+}
+
+::quic::QuicTag Utilities::CongestionControlConnectionOption(
+    CongestionControlType type) {
+  switch (type) {
+    case CongestionControlType::kCubic:
+      return ::quic::kBYTE;
+    case CongestionControlType::kReno:
+      return ::quic::kRENO;
+    case CongestionControlType::kBbrV2:
+      return ::quic::kB2ON;
+    case CongestionControlType::kDefault:
+    case CongestionControlType::kBbr:
+    default:
+      return ::quic::kTBBR;
+  }
+}
+
+::quic::QuicTagVector Utilities::CongestionProfileConnectionOptions(
+    CongestionProfile profile) {
+  switch (profile) {
+    case CongestionProfile::kRealtime:
+      // BBRv2 limits PROBE_RTT cwnd to half of the BDP, and skips PROBE_RTT if
+      // inflight was low enough to measure min RTT recently. k1RTT exits
+      // STARTUP after one round without bandwidth growth instead of three.
+      // B2CL doesn't add ack height to PROBE_BW cwnd, and BSAO keeps ack
+      // aggregation from inflating bandwidth samples.
+      return {::quic::kB2ON, ::quic::k1RTT, ::quic::kB2CL, ::quic::kBSAO};
+    case CongestionProfile::kDefault:
+    default:
+      return {};
+  }
+}
+
+::quic::QuicMemSlice Utilities::CreateMemSliceForExternalBuffer(
+    uint8_t* data,
+    size_t length,
+    BufferReleaseCallback release,
+    void* release_context) {
+  CHECK(data);
+  auto* releaser =
+      new ExternalBufferReleaser(length, release, release_context);
+  ::quic::QuicUniqueBufferPtr buffer(reinterpret_cast<char*>(data),
+                                     ::quic::QuicBufferDeleter(releaser));
+  return ::quic::QuicMemSlice(::quic::QuicBuffer(std::move(buffer), length));
+}
+
+scoped_refptr<net::IOBuffer> Utilities::CreateSharedBuffer(const uint8_t* data,
+                                                           size_t length) {
+  auto buffer = base::MakeRefCounted<net::IOBuffer>(length);
+  if (length > 0) {
+    memcpy(buffer->data(), data, length);
+  }
+  return buffer;
+}
+
+scoped_refptr<net::IOBuffer> Utilities::CreateSharedBufferForExternalBuffer(
+    uint8_t* data,
+    size_t length,
+    BufferReleaseCallback release,
+    void* release_context) {
+  CHECK(data);
+  return base::MakeRefCounted<ExternalIOBuffer>(data, length, release,
+                                                release_context);
+}
+
+::quic::QuicMemSlice Utilities::CreateMemSliceForSharedBuffer(
+    scoped_refptr<net::IOBuffer> buffer,
+    size_t length) {
+  return ::quic::QuicMemSlice(
+      ::quic::QuicMemSliceImpl(std::move(buffer), length));
+}
+
+std::vector<net::IPEndPoint> Utilities::InterleaveAddressFamilies(
+    const net::AddressList& addresses) {
+  std::vector<net::IPEndPoint> result;
+  if (addresses.empty()) {
+    return result;
+  }
+  const net::AddressFamily first_family = addresses.front().GetFamily();
+  std::vector<net::IPEndPoint> preferred;
+  std::vector<net::IPEndPoint> others;
+  for (const net::IPEndPoint& address : addresses) {
+    (address.GetFamily() == first_family ? preferred : others)
+        .push_back(address);
+  }
+  result.reserve(addresses.size());
+  for (size_t i = 0; i < std::max(preferred.size(), others.size()); i++) {
+    if (i < preferred.size()) {
+      result.push_back(preferred[i]);
+    }
+    if (i < others.size()) {
+      result.push_back(others[i]);
+    }
+  }
+  return result;
+}
+
+size_t Utilities::MaxWebTransportDatagramSize(uint64_t largest_message_payload,
+                                              uint64_t session_id) {
+  const uint64_t quarter_stream_id = session_id / 4;
+  // Length of the quarter stream ID as a variable-length integer.
+  uint64_t overhead = quarter_stream_id < (1ull << 6)    ? 1
+                      : quarter_stream_id < (1ull << 14) ? 2
+                      : quarter_stream_id < (1ull << 30) ? 4
+                                                         : 8;
+  // Context ID.
+  overhead += 1;
+  return largest_message_payload > overhead
+             ? largest_message_payload - overhead
+             : 0;
+}
+
+absl::optional<::quic::QuicAckFrequencyFrame>
+Utilities::CreateAckFrequencyFrame(const ::quic::QuicConfig& config,
+                                   uint32_t ack_eliciting_threshold,
+                                   ::quic::QuicTime::Delta max_ack_delay) {
+  // Peers supporting the extension advertise their min_ack_delay.
+  if (ack_eliciting_threshold == 0 || !config.HasReceivedMinAckDelayMs()) {
+    return absl::nullopt;
+  }
+  if (max_ack_delay.IsZero()) {
+    max_ack_delay = ::quic::QuicTime::Delta::FromMilliseconds(
+        ::quic::kDefaultDelayedAckTimeMs);
+  }
+  ::quic::QuicAckFrequencyFrame frame;
+  // Only one frame is sent per connection.
+  frame.sequence_number = 0;
+  frame.packet_tolerance = ack_eliciting_threshold;
+  frame.max_ack_delay =
+      std::max(max_ack_delay, ::quic::QuicTime::Delta::FromMilliseconds(
+                                  config.ReceivedMinAckDelayMs()));
+  return frame;
+}
+
+Utilities::QpackSettings Utilities::GetQpackSettings(
+    bool disable_dynamic_table,
+    uint32_t dynamic_table_capacity,
+    uint32_t blocked_streams) {
+  if (disable_dynamic_table) {
+    return QpackSettings{0, 0};
+  }
+  return QpackSettings{
+      dynamic_table_capacity > 0 ? dynamic_table_capacity
+                                 : ::quic::kDefaultQpackMaxDynamicTableCapacity,
+      blocked_streams > 0 ? blocked_streams
+                          : ::quic::kDefaultMaximumBlockedStreams};
+}
 }  // namespace quic
-}  // namespace owt
\ No newline at end of file
+}  // namespace owt
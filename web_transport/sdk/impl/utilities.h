@@ -7,15 +7,89 @@
 #ifndef OWT_WEB_TRANSPORT_UTILITIES_H_
 #define OWT_WEB_TRANSPORT_UTILITIES_H_
 
+#include <vector>
+#include "absl/types/optional.h"
+#include "base/memory/scoped_refptr.h"
+#include "net/base/address_list.h"
+#include "net/base/io_buffer.h"
+#include "net/base/ip_endpoint.h"
+#include "net/third_party/quiche/src/quic/core/crypto/crypto_protocol.h"
+#include "net/third_party/quiche/src/quic/core/frames/quic_ack_frequency_frame.h"
+#include "net/third_party/quiche/src/quic/core/quic_config.h"
+#include "net/third_party/quiche/src/quic/core/quic_tag.h"
 #include "net/third_party/quiche/src/quic/core/quic_types.h"
+#include "net/third_party/quiche/src/quic/platform/api/quic_mem_slice.h"
 #include "owt/quic/web_transport_definitions.h"
 
 namespace owt {
 namespace quic {
 class Utilities {
  public:
+  // QPACK settings advertised in HTTP/3 SETTINGS.
+  struct QpackSettings {
+    uint64_t max_dynamic_table_capacity;
+    uint64_t max_blocked_streams;
+  };
+
   static MessageStatus ConvertMessageStatus(
       absl::optional<::quic::MessageStatus> status);
+  static ::quic::CongestionControlType ConvertCongestionControlType(
+      CongestionControlType type);
+  // Returns the QUIC connection option which selects `type`.
+  static ::quic::QuicTag CongestionControlConnectionOption(
+      CongestionControlType type);
+  // Returns the QUIC connection options which apply `profile`, including the
+  // one selecting its algorithm. It's empty for kDefault.
+  static ::quic::QuicTagVector CongestionProfileConnectionOptions(
+      CongestionProfile profile);
+  // Wraps a buffer owned by application in a QuicMemSlice without copying.
+  // `release` is called when the QuicMemSlice is destroyed.
+  static ::quic::QuicMemSlice CreateMemSliceForExternalBuffer(
+      uint8_t* data,
+      size_t length,
+      BufferReleaseCallback release,
+      void* release_context);
+  // Creates a reference counted buffer which can be shared by multiple
+  // QuicMemSlices. Data is copied.
+  static scoped_refptr<net::IOBuffer> CreateSharedBuffer(const uint8_t* data,
+                                                         size_t length);
+  // Same as above, but `data` is not copied. `release` is called when the last
+  // reference is released.
+  static scoped_refptr<net::IOBuffer> CreateSharedBufferForExternalBuffer(
+      uint8_t* data,
+      size_t length,
+      BufferReleaseCallback release,
+      void* release_context);
+  // Creates a QuicMemSlice referencing `buffer` without copying.
+  static ::quic::QuicMemSlice CreateMemSliceForSharedBuffer(
+      scoped_refptr<net::IOBuffer> buffer,
+      size_t length);
+  // Orders `addresses` for connection attempts as specified by RFC 8305
+  // section 4: address families are interleaved, starting with the family of
+  // the first address. Order within a family is kept.
+  static std::vector<net::IPEndPoint> InterleaveAddressFamilies(
+      const net::AddressList& addresses);
+  // Returns the largest WebTransport datagram payload which fits in a QUIC
+  // DATAGRAM frame of `largest_message_payload` bytes. HTTP/3 datagrams are
+  // prefixed by the quarter stream ID of the session, and a context ID which
+  // is counted as one byte.
+  static size_t MaxWebTransportDatagramSize(uint64_t largest_message_payload,
+                                            uint64_t session_id);
+  // Returns an ACK_FREQUENCY frame asking the peer to send an ACK after
+  // receiving `ack_eliciting_threshold` ack-eliciting packets, or after
+  // `max_ack_delay`. Zero `max_ack_delay` means QUIC's default delayed ACK
+  // time. Returns nullopt if `ack_eliciting_threshold` is 0, or the peer
+  // doesn't support the ACK frequency extension according to `config`.
+  static absl::optional<::quic::QuicAckFrequencyFrame> CreateAckFrequencyFrame(
+      const ::quic::QuicConfig& config,
+      uint32_t ack_eliciting_threshold,
+      ::quic::QuicTime::Delta max_ack_delay);
+  // Returns the QPACK settings for the QPACK fields of Options or Parameters.
+  // Zero fields mean QUICHE's defaults. A disabled dynamic table is advertised
+  // as zero capacity, so no stream could be blocked either.
+  static QpackSettings GetQpackSettings(bool disable_dynamic_table,
+                                        uint32_t dynamic_table_capacity,
+                                        uint32_t blocked_streams);
 };
 }  // namespace quic
 }  // namespace owt
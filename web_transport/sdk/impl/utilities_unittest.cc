@@ -0,0 +1,157 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "owt/web_transport/sdk/impl/utilities.h"
+#include "net/third_party/quiche/src/quic/core/quic_constants.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace owt {
+namespace quic {
+namespace test {
+
+namespace {
+struct ReleaseRecord {
+  uint8_t* data = nullptr;
+  size_t length = 0;
+  int count = 0;
+};
+
+void RecordRelease(uint8_t* data, size_t length, void* context) {
+  auto* record = static_cast<ReleaseRecord*>(context);
+  record->data = data;
+  record->length = length;
+  record->count++;
+}
+}  // namespace
+
+TEST(UtilitiesTest, ExternalBufferIsNotCopied) {
+  uint8_t data[] = {1, 2, 3, 4};
+  ReleaseRecord record;
+  {
+    ::quic::QuicMemSlice slice = Utilities::CreateMemSliceForExternalBuffer(
+        data, sizeof(data), &RecordRelease, &record);
+    EXPECT_EQ(reinterpret_cast<const char*>(data), slice.data());
+    EXPECT_EQ(sizeof(data), slice.length());
+    EXPECT_EQ(0, record.count);
+  }
+  EXPECT_EQ(1, record.count);
+  EXPECT_EQ(data, record.data);
+  EXPECT_EQ(sizeof(data), record.length);
+}
+
+TEST(UtilitiesTest, ExternalBufferWithoutReleaseCallback) {
+  uint8_t data[] = {1, 2, 3, 4};
+  ::quic::QuicMemSlice slice = Utilities::CreateMemSliceForExternalBuffer(
+      data, sizeof(data), nullptr, nullptr);
+  EXPECT_EQ(sizeof(data), slice.length());
+}
+
+TEST(UtilitiesTest, SharedBufferIsReleasedAfterLastSlice) {
+  uint8_t data[] = {1, 2, 3, 4};
+  ReleaseRecord record;
+  {
+    scoped_refptr<net::IOBuffer> buffer =
+        Utilities::CreateSharedBufferForExternalBuffer(
+            data, sizeof(data), &RecordRelease, &record);
+    ::quic::QuicMemSlice slice1 =
+        Utilities::CreateMemSliceForSharedBuffer(buffer, sizeof(data));
+    ::quic::QuicMemSlice slice2 =
+        Utilities::CreateMemSliceForSharedBuffer(buffer, sizeof(data));
+    buffer.reset();
+    EXPECT_EQ(slice1.data(), slice2.data());
+    EXPECT_EQ(reinterpret_cast<const char*>(data), slice1.data());
+    slice1.Reset();
+    EXPECT_EQ(0, record.count);
+  }
+  EXPECT_EQ(1, record.count);
+  EXPECT_EQ(data, record.data);
+}
+
+TEST(UtilitiesTest, ConvertCongestionControlType) {
+  EXPECT_EQ(::quic::kBBR, Utilities::ConvertCongestionControlType(
+                              CongestionControlType::kDefault));
+  EXPECT_EQ(::quic::kCubicBytes, Utilities::ConvertCongestionControlType(
+                                     CongestionControlType::kCubic));
+  EXPECT_EQ(::quic::kRenoBytes, Utilities::ConvertCongestionControlType(
+                                    CongestionControlType::kReno));
+  EXPECT_EQ(::quic::kBBR, Utilities::ConvertCongestionControlType(
+                              CongestionControlType::kBbr));
+  EXPECT_EQ(::quic::kBBRv2, Utilities::ConvertCongestionControlType(
+                                CongestionControlType::kBbrV2));
+}
+
+TEST(UtilitiesTest, CongestionControlConnectionOption) {
+  EXPECT_EQ(::quic::kBYTE, Utilities::CongestionControlConnectionOption(
+                               CongestionControlType::kCubic));
+  EXPECT_EQ(::quic::kRENO, Utilities::CongestionControlConnectionOption(
+                               CongestionControlType::kReno));
+  EXPECT_EQ(::quic::kTBBR, Utilities::CongestionControlConnectionOption(
+                               CongestionControlType::kBbr));
+  EXPECT_EQ(::quic::kB2ON, Utilities::CongestionControlConnectionOption(
+                               CongestionControlType::kBbrV2));
+}
+
+TEST(UtilitiesTest, CongestionProfileConnectionOptions) {
+  EXPECT_TRUE(
+      Utilities::CongestionProfileConnectionOptions(CongestionProfile::kDefault)
+          .empty());
+  const ::quic::QuicTagVector options =
+      Utilities::CongestionProfileConnectionOptions(
+          CongestionProfile::kRealtime);
+  // Selects BBRv2, and never another algorithm.
+  EXPECT_TRUE(::quic::ContainsQuicTag(options, ::quic::kB2ON));
+  EXPECT_FALSE(::quic::ContainsQuicTag(options, ::quic::kTBBR));
+  EXPECT_FALSE(::quic::ContainsQuicTag(options, ::quic::kBYTE));
+  EXPECT_FALSE(::quic::ContainsQuicTag(options, ::quic::kRENO));
+}
+
+TEST(UtilitiesTest, InterleaveAddressFamilies) {
+  const net::IPEndPoint v6_1(net::IPAddress::IPv6Localhost(), 1);
+  const net::IPEndPoint v6_2(net::IPAddress::IPv6Localhost(), 2);
+  const net::IPEndPoint v4_1(net::IPAddress::IPv4Localhost(), 1);
+  const net::IPEndPoint v4_2(net::IPAddress::IPv4Localhost(), 2);
+  const net::IPEndPoint v4_3(net::IPAddress::IPv4Localhost(), 3);
+  net::AddressList addresses;
+  for (const auto& address : {v6_1, v6_2, v4_1, v4_2, v4_3}) {
+    addresses.push_back(address);
+  }
+  EXPECT_EQ(Utilities::InterleaveAddressFamilies(addresses),
+            std::vector<net::IPEndPoint>({v6_1, v4_1, v6_2, v4_2, v4_3}));
+  EXPECT_TRUE(
+      Utilities::InterleaveAddressFamilies(net::AddressList()).empty());
+}
+
+TEST(UtilitiesTest, MaxWebTransportDatagramSize) {
+  EXPECT_EQ(1198u, Utilities::MaxWebTransportDatagramSize(1200, 0));
+  EXPECT_EQ(1197u, Utilities::MaxWebTransportDatagramSize(1200, 4 * 64));
+  EXPECT_EQ(0u, Utilities::MaxWebTransportDatagramSize(1, 0));
+}
+
+TEST(UtilitiesTest, NoAckFrequencyFrameForPeersWithoutSupport) {
+  ::quic::QuicConfig config;
+  EXPECT_FALSE(Utilities::CreateAckFrequencyFrame(
+      config, 10, ::quic::QuicTime::Delta::FromMilliseconds(50)));
+  EXPECT_FALSE(Utilities::CreateAckFrequencyFrame(
+      config, 0, ::quic::QuicTime::Delta::Zero()));
+}
+
+TEST(UtilitiesTest, GetQpackSettings) {
+  Utilities::QpackSettings settings = Utilities::GetQpackSettings(false, 0, 0);
+  EXPECT_EQ(::quic::kDefaultQpackMaxDynamicTableCapacity,
+            settings.max_dynamic_table_capacity);
+  EXPECT_EQ(::quic::kDefaultMaximumBlockedStreams,
+            settings.max_blocked_streams);
+  settings = Utilities::GetQpackSettings(false, 4096, 8);
+  EXPECT_EQ(4096u, settings.max_dynamic_table_capacity);
+  EXPECT_EQ(8u, settings.max_blocked_streams);
+  settings = Utilities::GetQpackSettings(true, 4096, 8);
+  EXPECT_EQ(0u, settings.max_dynamic_table_capacity);
+  EXPECT_EQ(0u, settings.max_blocked_streams);
+}
+
+}  // namespace test
+}  // namespace quic
+}  // namespace owt
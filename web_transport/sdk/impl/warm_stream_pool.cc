@@ -0,0 +1,130 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "impl/warm_stream_pool.h"
+#include <algorithm>
+#include "base/check.h"
+
+namespace owt {
+namespace quic {
+
+WarmStreamPool::WarmStreamPool(Delegate* delegate)
+    : delegate_(delegate),
+      cleared_(false),
+      enabled_(false),
+      refill_scheduled_(false) {
+  DCHECK(delegate_);
+  for (Streams* pool : {&bidirectional_, &unidirectional_}) {
+    for (auto& slot : pool->slots) {
+      slot.store(nullptr, std::memory_order_relaxed);
+    }
+  }
+}
+
+WarmStreamPool::~WarmStreamPool() = default;
+
+void WarmStreamPool::SetSize(size_t bidirectional, size_t unidirectional) {
+  if (cleared_) {
+    return;
+  }
+  bidirectional_.target_size = std::min(bidirectional, kMaxSize);
+  unidirectional_.target_size = std::min(unidirectional, kMaxSize);
+  enabled_.store(bidirectional > 0 || unidirectional > 0,
+                 std::memory_order_relaxed);
+  RefillAll();
+}
+
+void WarmStreamPool::Refill(bool bidirectional) {
+  Streams& pool = streams(bidirectional);
+  if (cleared_ || pool.target_size == 0) {
+    return;
+  }
+  // The size is checked for every stream, since opening a stream may call back
+  // into the session, and refill the pool.
+  while (size(bidirectional) < pool.target_size) {
+    WebTransportStreamInterface* stream =
+        delegate_->OpenWarmStream(bidirectional);
+    if (!stream) {
+      break;
+    }
+    // Only this thread fills slots, and fewer than `kMaxSize` are filled, so
+    // an empty slot is found. The store publishes the stream to threads
+    // acquiring it.
+    auto slot = std::find_if(
+        pool.slots.begin(), pool.slots.end(),
+        [](const std::atomic<WebTransportStreamInterface*>& slot) {
+          return !slot.load(std::memory_order_relaxed);
+        });
+    DCHECK(slot != pool.slots.end());
+    slot->store(stream, std::memory_order_release);
+  }
+}
+
+void WarmStreamPool::RefillAll() {
+  refill_scheduled_.store(false, std::memory_order_relaxed);
+  Refill(true);
+  Refill(false);
+}
+
+WebTransportStreamInterface* WarmStreamPool::Acquire(bool bidirectional) {
+  Streams& pool = streams(bidirectional);
+  for (auto& slot : pool.slots) {
+    // The load skips empty slots without writing to them.
+    if (!slot.load(std::memory_order_relaxed)) {
+      continue;
+    }
+    WebTransportStreamInterface* stream =
+        slot.exchange(nullptr, std::memory_order_acquire);
+    if (stream) {
+      return stream;
+    }
+  }
+  return nullptr;
+}
+
+bool WarmStreamPool::ScheduleRefill() {
+  if (!enabled_.load(std::memory_order_relaxed)) {
+    return false;
+  }
+  return !refill_scheduled_.exchange(true, std::memory_order_relaxed);
+}
+
+void WarmStreamPool::Remove(WebTransportStreamInterface* stream) {
+  for (Streams* pool : {&bidirectional_, &unidirectional_}) {
+    for (auto& slot : pool->slots) {
+      WebTransportStreamInterface* expected = stream;
+      // Fails if the stream is acquired at the same time.
+      if (slot.compare_exchange_strong(expected, nullptr,
+                                       std::memory_order_relaxed)) {
+        return;
+      }
+    }
+  }
+}
+
+void WarmStreamPool::Clear() {
+  cleared_ = true;
+  enabled_.store(false, std::memory_order_relaxed);
+  bidirectional_.target_size = 0;
+  unidirectional_.target_size = 0;
+  for (Streams* pool : {&bidirectional_, &unidirectional_}) {
+    for (auto& slot : pool->slots) {
+      slot.store(nullptr, std::memory_order_relaxed);
+    }
+  }
+}
+
+size_t WarmStreamPool::size(bool bidirectional) const {
+  const Streams& pool = streams(bidirectional);
+  return std::count_if(
+      pool.slots.begin(), pool.slots.end(),
+      [](const std::atomic<WebTransportStreamInterface*>& slot) {
+        return slot.load(std::memory_order_relaxed) != nullptr;
+      });
+}
+
+}  // namespace quic
+}  // namespace owt
@@ -0,0 +1,89 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef OWT_WEB_TRANSPORT_WARM_STREAM_POOL_H_
+#define OWT_WEB_TRANSPORT_WARM_STREAM_POOL_H_
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include "owt/quic/web_transport_stream_interface.h"
+
+namespace owt {
+namespace quic {
+
+// Outgoing streams opened ahead of time, so a new stream can be taken without
+// waiting for IO thread. Streams are owned by the session which opens them.
+// Except Acquire() and ScheduleRefill(), all methods must be called on IO
+// thread.
+//
+// Each direction has a fixed number of slots. Only IO thread fills an empty
+// slot, and any thread empties a slot by an atomic exchange, so no lock is
+// needed. Streams are not necessarily acquired in the order they're opened.
+class WarmStreamPool {
+ public:
+  class Delegate {
+   public:
+    virtual ~Delegate() = default;
+    // Opens an outgoing stream. Returns nullptr when no more stream can be
+    // opened at this moment, e.g. stream limit is reached.
+    virtual WebTransportStreamInterface* OpenWarmStream(bool bidirectional) = 0;
+  };
+
+  // Max number of streams kept open of each direction.
+  static constexpr size_t kMaxSize = 64;
+
+  explicit WarmStreamPool(Delegate* delegate);
+  ~WarmStreamPool();
+  WarmStreamPool(const WarmStreamPool&) = delete;
+  WarmStreamPool& operator=(const WarmStreamPool&) = delete;
+
+  // Sets the number of streams kept open of each direction, and refills the
+  // pool. Sizes are capped at `kMaxSize`. Extra streams are kept until they're
+  // acquired.
+  void SetSize(size_t bidirectional, size_t unidirectional);
+  // Opens streams until the pool is full or the delegate can't open more.
+  // It's called again when stream limit increases.
+  void Refill(bool bidirectional);
+  void RefillAll();
+  // Returns an opened stream and removes it from the pool. nullptr if the
+  // pool is empty. It's lock-free, and visits each slot at most once.
+  WebTransportStreamInterface* Acquire(bool bidirectional);
+  // Returns true if a refill task should be posted to IO thread, i.e. the pool
+  // is enabled and no refill is scheduled yet. RefillAll() clears the flag.
+  bool ScheduleRefill();
+  // Removes `stream` if it's closed before being acquired.
+  void Remove(WebTransportStreamInterface* stream);
+  // Drops all streams and stops refilling, e.g. when the session is closed.
+  void Clear();
+  size_t size(bool bidirectional) const;
+
+ private:
+  struct Streams {
+    // Only accessed on IO thread.
+    size_t target_size = 0;
+    // nullptr for an empty slot.
+    std::array<std::atomic<WebTransportStreamInterface*>, kMaxSize> slots;
+  };
+  Streams& streams(bool bidirectional) {
+    return bidirectional ? bidirectional_ : unidirectional_;
+  }
+  const Streams& streams(bool bidirectional) const {
+    return bidirectional ? bidirectional_ : unidirectional_;
+  }
+
+  Delegate* delegate_;
+  bool cleared_;
+  std::atomic<bool> enabled_;
+  std::atomic<bool> refill_scheduled_;
+  Streams bidirectional_;
+  Streams unidirectional_;
+};
+
+}  // namespace quic
+}  // namespace owt
+
+#endif
@@ -0,0 +1,164 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "owt/web_transport/sdk/impl/warm_stream_pool.h"
+#include <memory>
+#include <vector>
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace owt {
+namespace quic {
+namespace test {
+
+namespace {
+class FakeStream : public WebTransportStreamInterface {
+ public:
+  explicit FakeStream(uint32_t id) : id_(id) {}
+  uint32_t Id() const override { return id_; }
+  void SetVisitor(Visitor* visitor) override {}
+  size_t Write(const uint8_t* data, size_t length) override { return 0; }
+  void WriteAsync(const uint8_t* data, size_t length) override {}
+  void WriteAsync(uint8_t* data,
+                  size_t length,
+                  BufferReleaseCallback release,
+                  void* release_context) override {}
+  void Writev(const IoVec* iov, size_t iovcnt, bool fin) override {}
+  void WriteFile(int fd, uint64_t offset, uint64_t length, bool fin) override {
+  }
+  void SetWriteCoalescing(size_t threshold, uint32_t delay_ms) override {}
+  void Flush() override {}
+  void SetBufferWatermarks(uint64_t high, uint64_t low) override {}
+  void SetPriority(uint8_t urgency) override {}
+  size_t Read(uint8_t* data, size_t length) override { return 0; }
+  void SetPushModeEnabled(bool enabled) override {}
+  void SetReceiveRing(StreamReceiveRing* ring,
+                      size_t fill_watermark) override {}
+  void ResumeReceive() override {}
+  size_t ReadableBytes() const override { return 0; }
+  void Close() override {}
+  void Reset(uint8_t error_code) override {}
+  void StopSending(uint8_t error_code) override {}
+  void SetSendDeadline(uint32_t timeout_ms, uint8_t error_code) override {}
+  uint64_t BufferedDataBytes() const override { return 0; }
+  bool CanWrite() const override { return true; }
+
+ private:
+  uint32_t id_;
+};
+
+// Opens streams until `limit` streams are opened. Stream IDs are the order
+// they're opened.
+class FakeDelegate : public WarmStreamPool::Delegate {
+ public:
+  WebTransportStreamInterface* OpenWarmStream(bool bidirectional) override {
+    if (streams_.size() >= limit_) {
+      return nullptr;
+    }
+    streams_.push_back(std::make_unique<FakeStream>(
+        static_cast<uint32_t>(streams_.size())));
+    return streams_.back().get();
+  }
+
+  void set_limit(size_t limit) { limit_ = limit; }
+  size_t opened() const { return streams_.size(); }
+  WebTransportStreamInterface* stream(size_t index) const {
+    return streams_[index].get();
+  }
+
+ private:
+  size_t limit_ = 100;
+  std::vector<std::unique_ptr<FakeStream>> streams_;
+};
+}  // namespace
+
+TEST(WarmStreamPoolTest, EmptyByDefault) {
+  FakeDelegate delegate;
+  WarmStreamPool pool(&delegate);
+  pool.RefillAll();
+  EXPECT_EQ(delegate.opened(), 0u);
+  EXPECT_EQ(pool.Acquire(true), nullptr);
+  EXPECT_FALSE(pool.ScheduleRefill());
+}
+
+TEST(WarmStreamPoolTest, OpensStreamsAhead) {
+  FakeDelegate delegate;
+  WarmStreamPool pool(&delegate);
+  pool.SetSize(2, 3);
+  EXPECT_EQ(pool.size(true), 2u);
+  EXPECT_EQ(pool.size(false), 3u);
+  EXPECT_EQ(delegate.opened(), 5u);
+  WebTransportStreamInterface* stream = pool.Acquire(false);
+  ASSERT_NE(stream, nullptr);
+  EXPECT_EQ(stream->Id(), 2u);
+  EXPECT_EQ(pool.size(false), 2u);
+}
+
+TEST(WarmStreamPoolTest, RefillsOnce) {
+  FakeDelegate delegate;
+  WarmStreamPool pool(&delegate);
+  pool.SetSize(2, 0);
+  pool.Acquire(true);
+  pool.Acquire(true);
+  EXPECT_EQ(pool.Acquire(true), nullptr);
+  EXPECT_TRUE(pool.ScheduleRefill());
+  EXPECT_FALSE(pool.ScheduleRefill());
+  pool.RefillAll();
+  EXPECT_EQ(pool.size(true), 2u);
+  EXPECT_TRUE(pool.ScheduleRefill());
+}
+
+TEST(WarmStreamPoolTest, RefillsWhenLimitIncreases) {
+  FakeDelegate delegate;
+  delegate.set_limit(1);
+  WarmStreamPool pool(&delegate);
+  pool.SetSize(3, 0);
+  EXPECT_EQ(pool.size(true), 1u);
+  delegate.set_limit(10);
+  pool.Refill(true);
+  EXPECT_EQ(pool.size(true), 3u);
+}
+
+TEST(WarmStreamPoolTest, CapsSize) {
+  FakeDelegate delegate;
+  delegate.set_limit(2 * WarmStreamPool::kMaxSize);
+  WarmStreamPool pool(&delegate);
+  pool.SetSize(WarmStreamPool::kMaxSize + 1, 0);
+  EXPECT_EQ(pool.size(true), WarmStreamPool::kMaxSize);
+  // Slots of acquired streams are filled again.
+  for (size_t i = 0; i < WarmStreamPool::kMaxSize; i++) {
+    EXPECT_NE(pool.Acquire(true), nullptr);
+  }
+  EXPECT_EQ(pool.Acquire(true), nullptr);
+  pool.RefillAll();
+  EXPECT_EQ(pool.size(true), WarmStreamPool::kMaxSize);
+  EXPECT_EQ(delegate.opened(), 2 * WarmStreamPool::kMaxSize);
+}
+
+TEST(WarmStreamPoolTest, RemovesClosedStream) {
+  FakeDelegate delegate;
+  WarmStreamPool pool(&delegate);
+  pool.SetSize(0, 2);
+  pool.Remove(delegate.stream(0));
+  EXPECT_EQ(pool.size(false), 1u);
+  EXPECT_EQ(pool.Acquire(false), delegate.stream(1));
+  EXPECT_EQ(pool.Acquire(false), nullptr);
+}
+
+TEST(WarmStreamPoolTest, ClearStopsRefilling) {
+  FakeDelegate delegate;
+  WarmStreamPool pool(&delegate);
+  pool.SetSize(1, 1);
+  pool.Clear();
+  EXPECT_EQ(pool.Acquire(true), nullptr);
+  EXPECT_FALSE(pool.ScheduleRefill());
+  pool.SetSize(4, 4);
+  pool.RefillAll();
+  EXPECT_EQ(delegate.opened(), 2u);
+}
+
+}  // namespace test
+}  // namespace quic
+}  // namespace owt
@@ -0,0 +1,279 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "owt/quic/web_transport_coroutines.h"
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <string>
+#include <vector>
+#include "testing/gtest/include/gtest/gtest.h"
+
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L
+
+namespace owt {
+namespace quic {
+namespace test {
+
+namespace {
+// A coroutine starts running when it's called, and destroys itself when it
+// returns.
+struct DetachedTask {
+  struct promise_type {
+    DetachedTask get_return_object() { return {}; }
+    std::suspend_never initial_suspend() noexcept { return {}; }
+    std::suspend_never final_suspend() noexcept { return {}; }
+    void return_void() {}
+    void unhandled_exception() { std::terminate(); }
+  };
+};
+
+// Keeps coroutines to be resumed until RunAll is called.
+class ManualExecutor : public CoroutineExecutor {
+ public:
+  void Post(std::coroutine_handle<> handle) override {
+    handles_.push_back(handle);
+  }
+  size_t RunAll() {
+    size_t count = 0;
+    while (!handles_.empty()) {
+      std::coroutine_handle<> handle = handles_.front();
+      handles_.pop_front();
+      handle.resume();
+      count++;
+    }
+    return count;
+  }
+
+ private:
+  std::deque<std::coroutine_handle<>> handles_;
+};
+
+class FakeStream : public WebTransportStreamInterface {
+ public:
+  uint32_t Id() const override { return 1; }
+  void SetVisitor(Visitor* visitor) override { visitor_ = visitor; }
+  size_t Write(const uint8_t* data, size_t length) override { return 0; }
+  void WriteAsync(const uint8_t* data, size_t length) override {
+    written_.append(reinterpret_cast<const char*>(data), length);
+    write_lengths_.push_back(length);
+  }
+  void WriteAsync(uint8_t* data,
+                  size_t length,
+                  BufferReleaseCallback release,
+                  void* release_context) override {}
+  void Writev(const IoVec* iov, size_t iovcnt, bool fin) override {}
+  void WriteFile(int fd, uint64_t offset, uint64_t length, bool fin) override {
+  }
+  void SetWriteCoalescing(size_t threshold, uint32_t delay_ms) override {}
+  void Flush() override {}
+  void SetBufferWatermarks(uint64_t high, uint64_t low) override {}
+  void SetPriority(uint8_t urgency) override {}
+  size_t Read(uint8_t* data, size_t length) override {
+    const size_t read = std::min(length, readable_.size());
+    memcpy(data, readable_.data(), read);
+    readable_.erase(0, read);
+    return read;
+  }
+  void SetPushModeEnabled(bool enabled) override {}
+  void SetReceiveRing(StreamReceiveRing* ring,
+                      size_t fill_watermark) override {}
+  void ResumeReceive() override {}
+  size_t ReadableBytes() const override { return readable_.size(); }
+  void Close() override {}
+  void Reset(uint8_t error_code) override {}
+  void StopSending(uint8_t error_code) override {}
+  void SetSendDeadline(uint32_t timeout_ms, uint8_t error_code) override {}
+  uint64_t BufferedDataBytes() const override { return 0; }
+  bool CanWrite() const override { return true; }
+
+  void Receive(const std::string& data) {
+    readable_.append(data);
+    visitor_->OnCanRead();
+  }
+  void CompleteWrite(bool success) {
+    const size_t length = write_lengths_.front();
+    write_lengths_.pop_front();
+    visitor_->OnWriteCompleted(length, success);
+  }
+
+  Visitor* visitor() const { return visitor_; }
+  const std::string& written() const { return written_; }
+
+ private:
+  Visitor* visitor_ = nullptr;
+  std::string readable_;
+  std::string written_;
+  std::deque<size_t> write_lengths_;
+};
+
+DetachedTask ReadAll(CoroutineStream* stream, std::string* data, bool* done) {
+  uint8_t buffer[4];
+  while (size_t length = co_await stream->Read(buffer, sizeof(buffer))) {
+    data->append(reinterpret_cast<char*>(buffer), length);
+  }
+  *done = true;
+}
+
+DetachedTask WriteTwice(CoroutineStream* stream, std::vector<bool>* results) {
+  const uint8_t first[] = "ab";
+  const uint8_t second[] = "cd";
+  results->push_back(co_await stream->Write(first, 2));
+  results->push_back(co_await stream->Write(second, 2));
+}
+
+DetachedTask AcceptStreams(CoroutineSession* session,
+                           std::vector<WebTransportStreamInterface*>* streams) {
+  while (WebTransportStreamInterface* stream =
+             co_await session->AcceptStream()) {
+    streams->push_back(stream);
+  }
+  streams->push_back(nullptr);
+}
+}  // namespace
+
+TEST(WebTransportCoroutinesTest, ReadCompletesWhenDataArrives) {
+  ManualExecutor executor;
+  FakeStream fake_stream;
+  std::string data;
+  bool done = false;
+  {
+    CoroutineStream stream(&fake_stream, &executor);
+    EXPECT_EQ(&stream, fake_stream.visitor());
+    ReadAll(&stream, &data, &done);
+    EXPECT_EQ(0u, executor.RunAll());
+    fake_stream.Receive("hello");
+    EXPECT_EQ(1u, executor.RunAll());
+    EXPECT_EQ("hello", data);
+    EXPECT_FALSE(done);
+    stream.OnFinRead();
+    EXPECT_EQ(1u, executor.RunAll());
+    EXPECT_TRUE(done);
+  }
+  EXPECT_EQ(nullptr, fake_stream.visitor());
+}
+
+TEST(WebTransportCoroutinesTest, ClosingStreamCompletesPendingOperations) {
+  ManualExecutor executor;
+  FakeStream fake_stream;
+  CoroutineStream stream(&fake_stream, &executor);
+  std::string data;
+  bool done = false;
+  std::vector<bool> results;
+  ReadAll(&stream, &data, &done);
+  WriteTwice(&stream, &results);
+  stream.OnClosed();
+  executor.RunAll();
+  EXPECT_TRUE(done);
+  EXPECT_EQ(std::vector<bool>({false, false}), results);
+}
+
+TEST(WebTransportCoroutinesTest, WritesCompleteInOrder) {
+  ManualExecutor executor;
+  FakeStream fake_stream;
+  CoroutineStream stream(&fake_stream, &executor);
+  std::vector<bool> results;
+  WriteTwice(&stream, &results);
+  EXPECT_EQ("ab", fake_stream.written());
+  fake_stream.CompleteWrite(true);
+  EXPECT_EQ(1u, executor.RunAll());
+  EXPECT_EQ("abcd", fake_stream.written());
+  fake_stream.CompleteWrite(false);
+  EXPECT_EQ(1u, executor.RunAll());
+  EXPECT_EQ(std::vector<bool>({true, false}), results);
+}
+
+TEST(WebTransportCoroutinesTest, AcceptStreamsUntilConnectionIsClosed) {
+  class FakeSession : public WebTransportSessionInterface {
+   public:
+    const char* ConnectionId() const override { return ""; }
+    void SetVisitor(Visitor* visitor) override {}
+    bool IsSessionReady() const override { return true; }
+    WebTransportStreamInterface* CreateBidirectionalStream() override {
+      return nullptr;
+    }
+    WebTransportStreamInterface* CreateOutgoingUnidirectionalStream()
+        override {
+      return nullptr;
+    }
+    size_t CreateBidirectionalStreams(
+        size_t count,
+        WebTransportStreamInterface** streams) override {
+      return 0;
+    }
+    size_t CreateOutgoingUnidirectionalStreams(
+        size_t count,
+        WebTransportStreamInterface** streams) override {
+      return 0;
+    }
+    void SetWarmStreamPoolSize(size_t bidirectional,
+                               size_t unidirectional) override {}
+    WebTransportStreamInterface* AcquireStream(bool bidirectional) override {
+      return nullptr;
+    }
+    MessageStatus SendOrQueueDatagram(uint8_t* data, size_t length) override {
+      return MessageStatus::kSuccess;
+    }
+    MessageStatus SendOrQueueDatagram(uint8_t* data,
+                                      size_t length,
+                                      BufferReleaseCallback release,
+                                      void* release_context) override {
+      return MessageStatus::kSuccess;
+    }
+    void SendOrQueueDatagramAsync(uint8_t* data, size_t length) override {}
+    void SendOrQueueDatagrams(const Datagram* batch,
+                              size_t count,
+                              MessageStatus* results) override {}
+    void SetDatagramBatchingEnabled(bool enabled) override {}
+    void SetBandwidthEstimateHysteresis(uint32_t percent) override {}
+    void SetMaxDatagramTimeInQueue(uint32_t max_time_ms) override {}
+    void SetDatagramPriority(DatagramPriority priority) override {}
+    void SetDatagramClasses(const DatagramClassOptions* classes,
+                            size_t count) override {}
+    MessageStatus SendOrQueuePrioritizedDatagram(
+        uint8_t* data,
+        size_t length,
+        uint32_t priority_class) override {
+      return MessageStatus::kSuccess;
+    }
+    void SetMaxSendRate(uint64_t bits_per_second) override {}
+    void SetKeepAlive(uint32_t interval_ms,
+                      uint32_t idle_timeout_ms) override {}
+    size_t GetMaxDatagramSize() const override { return 0; }
+    ConnectionStats GetStats() override { return stats_; }
+    MemoryUsage GetMemoryUsage() override { return MemoryUsage(); }
+    void Close(uint32_t code, const char* reason) override {}
+    void SetSendBufferBudget(uint64_t bytes) override {}
+
+   private:
+    ConnectionStats stats_;
+  };
+
+  ManualExecutor executor;
+  FakeSession fake_session;
+  FakeStream first;
+  FakeStream second;
+  CoroutineSession session(&fake_session, &executor);
+  // A stream received before it's awaited is kept.
+  session.OnIncomingStream(&first);
+  std::vector<WebTransportStreamInterface*> streams;
+  AcceptStreams(&session, &streams);
+  EXPECT_EQ(std::vector<WebTransportStreamInterface*>({&first}), streams);
+  session.OnIncomingStream(&second);
+  EXPECT_EQ(1u, executor.RunAll());
+  session.OnConnectionClosed();
+  EXPECT_EQ(1u, executor.RunAll());
+  EXPECT_EQ(
+      std::vector<WebTransportStreamInterface*>({&first, &second, nullptr}),
+      streams);
+}
+
+}  // namespace test
+}  // namespace quic
+}  // namespace owt
+
+#endif
@@ -8,26 +8,70 @@
 #include "impl/web_transport_factory_impl.h"
 #include "base/at_exit.h"
 #include "base/bind.h"
-#include "base/command_line.h"
 #include "base/logging.h"
-#include "base/task/thread_pool/thread_pool_instance.h"
+#include "base/synchronization/waitable_event.h"
 #include "base/threading/thread.h"
+#include "impl/external_task_runner.h"
+#include "impl/process_runtime.h"
 #include "impl/proof_source_owt.h"
+#include "impl/session_ticket_crypter.h"
+#include "impl/utilities.h"
 #include "impl/web_transport_owt_client_impl.h"
 #include "impl/web_transport_owt_server_impl.h"
+#include "net/proxy_resolution/configured_proxy_resolution_service.h"
 #include "net/quic/crypto/proof_source_chromium.h"
 #include "net/quic/platform/impl/quic_chromium_clock.h"
 #include "net/quic/quic_chromium_alarm_factory.h"
 #include "net/quic/quic_chromium_connection_helper.h"
 #include "net/third_party/quiche/src/quic/core/crypto/proof_source.h"
+#include "net/third_party/quiche/src/quic/core/crypto/quic_client_session_cache.h"
 #include "net/third_party/quiche/src/quic/core/crypto/quic_crypto_server_config.h"
 #include "net/third_party/quiche/src/quic/core/quic_types.h"
+#include "net/url_request/url_request_context.h"
+#include "net/url_request/url_request_context_builder.h"
+#include "url/gurl.h"
 
 namespace owt {
 namespace quic {
 
+namespace {
+// Gives `proof_source` a ticket crypter with keys in `options`, if there are
+// any. `ticket_crypter` is set to the crypter, or nullptr when there is no
+// key. Returns false if keys are invalid. `ProofSourceType` is a proof source
+// with SetTicketCrypter, e.g.: net::ProofSourceChromium or ProofSourceOwt.
+template <typename ProofSourceType>
+bool MaybeSetTicketCrypter(const WebTransportServerInterface::Options& options,
+                           ProofSourceType* proof_source,
+                           SessionTicketCrypter** ticket_crypter) {
+  *ticket_crypter = nullptr;
+  if (options.session_ticket_key_count == 0) {
+    return true;
+  }
+  auto crypter = std::make_unique<SessionTicketCrypter>(
+      options.early_data_policy == EarlyDataPolicy::kAcceptSingleUseTickets,
+      ::quic::QuicChromiumClock::GetInstance());
+  if (!crypter->SetKeys(options.session_ticket_keys,
+                        options.session_ticket_key_count)) {
+    LOG(ERROR) << "Invalid session ticket keys.";
+    return false;
+  }
+  *ticket_crypter = crypter.get();
+  proof_source->SetTicketCrypter(std::move(crypter));
+  return true;
+}
+
+// Host resolver, certificate verifier and QUIC parameters of the context are
+// shared by all clients created by a factory. The context is bound to the
+// thread creating it.
+std::unique_ptr<net::URLRequestContext> CreateClientContext() {
+  net::URLRequestContextBuilder builder;
+  builder.set_proxy_resolution_service(
+      net::ConfiguredProxyResolutionService::CreateDirect());
+  return builder.Build();
+}
+}  // namespace
+
 WebTransportFactory* WebTransportFactory::Create() {
-  base::ThreadPoolInstance::CreateAndStartWithDefaultParams("web_transport_thread_pool");
   WebTransportFactoryImpl* factory = new WebTransportFactoryImpl();
   factory->InitializeAtExitManager();
   return factory;
@@ -39,27 +83,79 @@ WebTransportFactory* WebTransportFactory::CreateForTesting() {
 
 WebTransportFactoryImpl::WebTransportFactoryImpl()
     : at_exit_manager_(nullptr),
+      client_session_cache_(std::make_unique<::quic::QuicClientSessionCache>()),
+      proof_verification_cache_(
+          std::make_unique<ProofVerificationCache>(0, base::TimeDelta())),
       io_thread_(std::make_unique<base::Thread>("quic_transport_io_thread")),
       event_thread_(
           std::make_unique<base::Thread>("quic_transport_event_thread")) {
-  io_thread_->StartWithOptions(
-      base::Thread::Options(base::MessagePumpType::IO, 0));
-  event_thread_->StartWithOptions(
-      base::Thread::Options(base::MessagePumpType::IO, 0));
   Init();
 }
 
-WebTransportFactoryImpl::~WebTransportFactoryImpl() = default;
+WebTransportFactoryImpl::~WebTransportFactoryImpl() {
+  // `client_context_` is used on `io_thread_`, so it's destroyed there.
+  std::unique_ptr<net::URLRequestContext> client_context;
+  {
+    base::AutoLock lock(client_context_lock_);
+    client_context = std::move(client_context_);
+  }
+  if (!client_context) {
+    return;
+  }
+  // A client is created, so `io_thread_` is started.
+  base::WaitableEvent done(base::WaitableEvent::ResetPolicy::AUTOMATIC,
+                           base::WaitableEvent::InitialState::NOT_SIGNALED);
+  GetIoThread()->task_runner()->PostTask(
+      FROM_HERE,
+      base::BindOnce(
+          [](std::unique_ptr<net::URLRequestContext> context,
+             base::WaitableEvent* event) {
+            context.reset();
+            event->Signal();
+          },
+          std::move(client_context), &done));
+  done.Wait();
+}
 
 void WebTransportFactoryImpl::InitializeAtExitManager() {
   at_exit_manager_ = std::make_unique<base::AtExitManager>();
 }
 
+void WebTransportFactoryImpl::SetEventExecutor(
+    EventExecutorInterface* executor) {
+  CHECK(executor);
+  base::AutoLock lock(threads_lock_);
+  event_runner_ = base::MakeRefCounted<ExternalTaskRunner>(executor);
+  if (event_thread_) {
+    // Not started yet if no server or client is created.
+    event_thread_->Stop();
+    event_thread_.reset();
+  }
+}
+
 WebTransportServerInterface* WebTransportFactoryImpl::CreateWebTransportServer(
     int port,
     const char* cert_path,
     const char* key_path,
     const char* secret_path) {
+  return CreateWebTransportServer(port, cert_path, key_path, secret_path,
+                                  WebTransportServerInterface::Options());
+}
+
+WebTransportServerInterface* WebTransportFactoryImpl::CreateWebTransportServer(
+    int port,
+    const char* pfx_path,
+    const char* password) {
+  return CreateWebTransportServer(port, pfx_path, password,
+                                  WebTransportServerInterface::Options());
+}
+
+WebTransportServerInterface* WebTransportFactoryImpl::CreateWebTransportServer(
+    int port,
+    const char* cert_path,
+    const char* key_path,
+    const char* secret_path,
+    const WebTransportServerInterface::Options& options) {
   auto proof_source = std::make_unique<net::ProofSourceChromium>();
   if (!proof_source->Initialize(base::FilePath::FromUTF8Unsafe(cert_path),
                                 base::FilePath::FromUTF8Unsafe(key_path),
@@ -67,20 +163,34 @@ WebTransportServerInterface* WebTransportFactoryImpl::CreateWebTransportServer(
     LOG(ERROR) << "Failed to initialize proof source.";
     return nullptr;
   }
-  return CreateWebTransportServerOnIOThread(port, std::move(proof_source));
+  SessionTicketCrypter* ticket_crypter = nullptr;
+  if (!MaybeSetTicketCrypter(options, proof_source.get(), &ticket_crypter)) {
+    return nullptr;
+  }
+  return CreateWebTransportServerOnIOThread(port, std::move(proof_source),
+                                            /*pkcs12_proof_source=*/nullptr,
+                                            ticket_crypter, options);
 }
 
 WebTransportServerInterface* WebTransportFactoryImpl::CreateWebTransportServer(
     int port,
     const char* pfx_path,
-    const char* password) {
+    const char* password,
+    const WebTransportServerInterface::Options& options) {
   auto proof_source = std::make_unique<ProofSourceOwt>();
   if (!proof_source->Initialize(base::FilePath::FromUTF8Unsafe(pfx_path),
                                 std::string(password))) {
     LOG(ERROR) << "Failed to initialize proof source.";
     return nullptr;
   }
-  return CreateWebTransportServerOnIOThread(port, std::move(proof_source));
+  SessionTicketCrypter* ticket_crypter = nullptr;
+  if (!MaybeSetTicketCrypter(options, proof_source.get(), &ticket_crypter)) {
+    return nullptr;
+  }
+  ProofSourceOwt* pkcs12_proof_source = proof_source.get();
+  return CreateWebTransportServerOnIOThread(port, std::move(proof_source),
+                                            pkcs12_proof_source, ticket_crypter,
+                                            options);
 }
 
 WebTransportClientInterface*
@@ -94,7 +204,6 @@ WebTransportClientInterface*
 WebTransportFactoryImpl::CreateWebTransportClient(
     const char* url,
     const WebTransportClientInterface::Parameters& parameters) {
-  WebTransportClientInterface* result(nullptr);
   net::WebTransportParameters param;
   for (size_t i = 0; i < parameters.server_certificate_fingerprints_length;
        i++) {
@@ -105,56 +214,167 @@ WebTransportFactoryImpl::CreateWebTransportClient(
     quic_fingerprint.fingerprint = fingerprint.fingerprint;
     param.server_certificate_fingerprints.push_back(quic_fingerprint);
   }
+  // Nothing is posted to the IO thread until the client connects.
+  const GURL gurl(url);
+  base::Thread* io_thread = GetIoThread();
+  // In inline dispatch mode, IO thread is also the event thread.
+  WebTransportOwtClientImpl* client = new WebTransportOwtClientImpl(
+      gurl, url::Origin::Create(gurl), param, GetClientContext(io_thread),
+      io_thread,
+      parameters.inline_event_dispatch ? io_thread->task_runner()
+                                       : GetEventRunner());
+  client->SetCongestionControl(parameters.congestion_control,
+                               parameters.server_congestion_control,
+                               parameters.congestion_profile);
+  client->SetSessionCache(parameters.enable_session_resumption
+                              ? client_session_cache_.get()
+                              : nullptr);
+  client->SetProofVerificationCache(proof_verification_cache_.get());
+  client->SetPooledSendBuffers(parameters.pooled_send_buffers);
+  client->SetMtuDiscoveryEnabled(parameters.enable_mtu_discovery);
+  client->SetAckFrequencyOptions(parameters.enable_ack_frequency,
+                                 parameters.ack_eliciting_threshold,
+                                 parameters.max_ack_delay_ms);
+  client->SetQpackSettings(
+      Utilities::GetQpackSettings(parameters.disable_qpack_dynamic_table,
+                                  parameters.qpack_dynamic_table_capacity,
+                                  parameters.qpack_blocked_streams));
+  client->SetKeepAliveOptions(parameters.keepalive_interval_ms,
+                              parameters.idle_timeout_ms);
+  client->SetMaxReceiveWindows(parameters.max_stream_receive_window,
+                               parameters.max_session_receive_window);
+  client->SetBatchPacketReads(parameters.batch_packet_reads,
+                              parameters.max_packets_per_read);
+  if (parameters.network_emulation) {
+    client->SetNetworkEmulation(*parameters.network_emulation);
+  }
+  return client;
+}
+
+void WebTransportFactoryImpl::SetThreadScheduling(
+    SdkThread thread,
+    size_t index,
+    const ThreadSchedulingOptions& options) {
+  base::AutoLock lock(threads_lock_);
+  thread_scheduling_.Set(thread, index, options);
+  if (index != 0) {
+    return;
+  }
+  if (thread == SdkThread::kIo && io_thread_->IsRunning()) {
+    thread_scheduling_.ApplyTo(thread, index, io_thread_.get());
+  } else if (thread == SdkThread::kEvent && event_thread_ &&
+             event_thread_->IsRunning()) {
+    thread_scheduling_.ApplyTo(thread, index, event_thread_.get());
+  }
+}
+
+net::URLRequestContext* WebTransportFactoryImpl::GetClientContext(
+    base::Thread* io_thread) {
+  base::AutoLock lock(client_context_lock_);
+  if (client_context_) {
+    return client_context_.get();
+  }
+  // Clients use the context on `io_thread`, so it's created there.
+  scoped_refptr<base::SingleThreadTaskRunner> io_runner =
+      io_thread->task_runner();
+  if (io_runner->BelongsToCurrentThread()) {
+    client_context_ = CreateClientContext();
+    return client_context_.get();
+  }
+  std::unique_ptr<net::URLRequestContext> context;
   base::WaitableEvent done(base::WaitableEvent::ResetPolicy::AUTOMATIC,
                            base::WaitableEvent::InitialState::NOT_SIGNALED);
-  io_thread_->task_runner()->PostTask(
+  io_runner->PostTask(
       FROM_HERE,
       base::BindOnce(
-          [](const char* url, const net::WebTransportParameters& param,
-             base::Thread* io_thread, base::Thread* event_thread,
-             WebTransportClientInterface** result,
+          [](std::unique_ptr<net::URLRequestContext>* context,
              base::WaitableEvent* event) {
-            url::Origin origin = url::Origin::Create(GURL(url));
-            WebTransportClientInterface* client =
-                new WebTransportOwtClientImpl(GURL(std::string(url)), origin,
-                                               param, io_thread, event_thread);
-            *result = client;
+            *context = CreateClientContext();
             event->Signal();
           },
-          base::Unretained(url), param, base::Unretained(io_thread_.get()),
-          base::Unretained(event_thread_.get()), base::Unretained(&result),
-          base::Unretained(&done)));
+          &context, &done));
   done.Wait();
-  return result;
+  client_context_ = std::move(context);
+  return client_context_.get();
 }
 
 void WebTransportFactoryImpl::Init() {
-  base::CommandLine::Init(0, nullptr);
-  base::CommandLine* command_line(base::CommandLine::ForCurrentProcess());
-  command_line->AppendSwitch("--quic_default_to_bbr");
-  Logging::InitLogging();
+  ProcessRuntime::GetInstance()->EnsureInitialized();
+}
+
+base::Thread* WebTransportFactoryImpl::GetIoThread() {
+  ProcessRuntime::GetInstance()->EnsureThreadPoolStarted();
+  base::AutoLock lock(threads_lock_);
+  if (!io_thread_->IsRunning()) {
+    io_thread_->StartWithOptions(
+        base::Thread::Options(base::MessagePumpType::IO, 0));
+    thread_scheduling_.ApplyTo(SdkThread::kIo, 0, io_thread_.get());
+  }
+  return io_thread_.get();
+}
+
+scoped_refptr<base::SingleThreadTaskRunner>
+WebTransportFactoryImpl::GetEventRunner() {
+  base::AutoLock lock(threads_lock_);
+  if (!event_runner_) {
+    DCHECK(event_thread_);
+    event_thread_->StartWithOptions(
+        base::Thread::Options(base::MessagePumpType::IO, 0));
+    thread_scheduling_.ApplyTo(SdkThread::kEvent, 0, event_thread_.get());
+    event_runner_ = event_thread_->task_runner();
+  }
+  return event_runner_;
 }
 
 WebTransportServerInterface*
 WebTransportFactoryImpl::CreateWebTransportServerOnIOThread(
     int port,
-    std::unique_ptr<::quic::ProofSource> proof_source) {
+    std::unique_ptr<::quic::ProofSource> proof_source,
+    ProofSourceOwt* pkcs12_proof_source,
+    SessionTicketCrypter* ticket_crypter,
+    const WebTransportServerInterface::Options& options) {
   WebTransportServerInterface* result(nullptr);
+  // Origins are copied, since `options` only points to them.
+  std::vector<url::Origin> accepted_origins;
+  accepted_origins.reserve(options.accepted_origin_count);
+  for (size_t i = 0; i < options.accepted_origin_count; i++) {
+    GURL origin_url(options.accepted_origins[i]);
+    LOG_IF(WARNING, !origin_url.is_valid())
+        << "Invalid accepted origin " << options.accepted_origins[i];
+    accepted_origins.push_back(url::Origin::Create(origin_url));
+  }
+  base::Thread* io_thread = GetIoThread();
+  ThreadScheduling thread_scheduling;
+  {
+    base::AutoLock lock(threads_lock_);
+    thread_scheduling = thread_scheduling_;
+  }
   base::WaitableEvent done(base::WaitableEvent::ResetPolicy::AUTOMATIC,
                            base::WaitableEvent::InitialState::NOT_SIGNALED);
-  io_thread_->task_runner()->PostTask(
+  io_thread->task_runner()->PostTask(
       FROM_HERE,
       base::BindOnce(
-          [](int port, std::unique_ptr<::quic::ProofSource> proof_source,
-             base::Thread* io_thread, base::Thread* event_thread,
+          [](int port, std::vector<url::Origin> accepted_origins,
+             std::unique_ptr<::quic::ProofSource> proof_source,
+             ProofSourceOwt* pkcs12_proof_source,
+             SessionTicketCrypter* ticket_crypter,
+             const WebTransportServerInterface::Options& options,
+             const ThreadScheduling& thread_scheduling,
+             base::Thread* io_thread,
+             scoped_refptr<base::SingleThreadTaskRunner> event_runner,
              WebTransportServerInterface** result, base::WaitableEvent* event) {
             *result = new WebTransportOwtServerImpl(
-                port, std::vector<url::Origin>(), std::move(proof_source),
-                io_thread, event_thread);
+                port, std::move(accepted_origins), std::move(proof_source),
+                pkcs12_proof_source, ticket_crypter, options,
+                thread_scheduling, io_thread, std::move(event_runner));
             event->Signal();
           },
-          port, std::move(proof_source), base::Unretained(io_thread_.get()),
-          base::Unretained(event_thread_.get()), base::Unretained(&result),
+          port, std::move(accepted_origins), std::move(proof_source),
+          base::Unretained(pkcs12_proof_source),
+          base::Unretained(ticket_crypter),
+          options, std::move(thread_scheduling), base::Unretained(io_thread),
+          GetEventRunner(),
+          base::Unretained(&result),
           base::Unretained(&done)));
   done.Wait();
   return result;
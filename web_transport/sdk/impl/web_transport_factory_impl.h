@@ -10,8 +10,14 @@
 #include <memory>
 #include <string>
 #include <vector>
+#include "base/memory/scoped_refptr.h"
+#include "base/synchronization/lock.h"
+#include "base/task/single_thread_task_runner.h"
+#include "base/thread_annotations.h"
 #include "owt/quic/export.h"
 #include "owt/quic/web_transport_factory.h"
+#include "owt/web_transport/sdk/impl/proof_verification_cache.h"
+#include "owt/web_transport/sdk/impl/thread_scheduling.h"
 
 namespace quic {
 class QuicAlarmFactory;
@@ -21,6 +27,7 @@ class QuicRandom;
 class QuicCompressedCertsCache;
 class QuicCryptoServerConfig;
 class ProofSource;
+class QuicClientSessionCache;
 }  // namespace quic
 
 namespace base {
@@ -28,15 +35,25 @@ class Thread;
 class AtExitManager;
 }  // namespace base
 
+namespace net {
+class URLRequestContext;
+}  // namespace net
+
 namespace owt {
 namespace quic {
 
+class ProofSourceOwt;
+class SessionTicketCrypter;
+
 class OWT_EXPORT WebTransportFactoryImpl : public WebTransportFactory {
  public:
   WebTransportFactoryImpl();
   ~WebTransportFactoryImpl() override;
   void InitializeAtExitManager();
-  // `accepted_origins` is removed at this time because ABI compatible issue.
+  void SetEventExecutor(EventExecutorInterface* executor) override;
+  void SetThreadScheduling(SdkThread thread,
+                           size_t index,
+                           const ThreadSchedulingOptions& options) override;
   WebTransportServerInterface* CreateWebTransportServer(
       int port,
       const char* cert_path,
@@ -46,6 +63,17 @@ class OWT_EXPORT WebTransportFactoryImpl : public WebTransportFactory {
       int port,
       const char* pfx_path,
       const char* password) override;
+  WebTransportServerInterface* CreateWebTransportServer(
+      int port,
+      const char* cert_path,
+      const char* key_path,
+      const char* secret_path,
+      const WebTransportServerInterface::Options& options) override;
+  WebTransportServerInterface* CreateWebTransportServer(
+      int port,
+      const char* pfx_path,
+      const char* password,
+      const WebTransportServerInterface::Options& options) override;
   WebTransportClientInterface* CreateWebTransportClient(
       const char* url) override;
   WebTransportClientInterface* CreateWebTransportClient(
@@ -54,14 +82,43 @@ class OWT_EXPORT WebTransportFactoryImpl : public WebTransportFactory {
 
  private:
   void Init();
+  // Start `io_thread_` and the event thread when the first server or client is
+  // created, so a factory which is never used doesn't run any thread.
+  base::Thread* GetIoThread();
+  scoped_refptr<base::SingleThreadTaskRunner> GetEventRunner();
+  // Creates `client_context_` on `io_thread` if it's not created. Blocks until
+  // it's created.
+  net::URLRequestContext* GetClientContext(base::Thread* io_thread);
 
   WebTransportServerInterface* CreateWebTransportServerOnIOThread(
       int port,
-      std::unique_ptr<::quic::ProofSource> proof_source);
+      std::unique_ptr<::quic::ProofSource> proof_source,
+      ProofSourceOwt* pkcs12_proof_source,
+      SessionTicketCrypter* ticket_crypter,
+      const WebTransportServerInterface::Options& options);
 
   std::unique_ptr<base::AtExitManager> at_exit_manager_;
-  std::unique_ptr<base::Thread> io_thread_;
-  std::unique_ptr<base::Thread> event_thread_;
+  // Shared by clients enabling session resumption, only accessed on
+  // `io_thread_`. It outlives `io_thread_`.
+  std::unique_ptr<::quic::QuicClientSessionCache> client_session_cache_;
+  // Shared by all clients, it outlives `io_thread_`.
+  std::unique_ptr<ProofVerificationCache> proof_verification_cache_;
+  base::Lock threads_lock_;
+  std::unique_ptr<base::Thread> io_thread_ GUARDED_BY(threads_lock_);
+  // Copied to servers when they're created.
+  ThreadScheduling thread_scheduling_ GUARDED_BY(threads_lock_);
+  base::Lock client_context_lock_;
+  // Shared by all clients, which run on `io_thread_`. Created when the first
+  // client is created. It's created and destroyed on `io_thread_`.
+  std::unique_ptr<net::URLRequestContext> client_context_
+      GUARDED_BY(client_context_lock_);
+  // Stopped and reset when an event executor is set.
+  std::unique_ptr<base::Thread> event_thread_ GUARDED_BY(threads_lock_);
+  // Runs visitor callbacks. It's `event_thread_`'s task runner, or an
+  // ExternalTaskRunner. Null until the event thread is started or an event
+  // executor is set.
+  scoped_refptr<base::SingleThreadTaskRunner> event_runner_
+      GUARDED_BY(threads_lock_);
 };
 
 }  // namespace quic
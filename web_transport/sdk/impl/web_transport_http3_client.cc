@@ -18,6 +18,7 @@
 #include "base/metrics/histogram_functions.h"
 #include "base/strings/abseil_string_conversions.h"
 #include "base/threading/thread_task_runner_handle.h"
+#include "base/trace_event/trace_event.h"
 #include "net/base/port_util.h"
 #include "net/base/url_util.h"
 #include "net/proxy_resolution/configured_proxy_resolution_service.h"
@@ -26,6 +27,12 @@
 #include "net/quic/crypto/proof_verifier_chromium.h"
 #include "net/quic/quic_chromium_alarm_factory.h"
 #include "net/spdy/spdy_http_utils.h"
+#include "owt/web_transport/sdk/impl/certificate_compression.h"
+#include "owt/web_transport/sdk/impl/keepalive_pinger.h"
+#include "owt/web_transport/sdk/impl/metrics.h"
+#include "owt/web_transport/sdk/impl/network_emulator.h"
+#include "owt/web_transport/sdk/impl/tracing.h"
+#include "owt/web_transport/sdk/impl/utilities.h"
 #include "net/third_party/quiche/src/quic/core/http/web_transport_http3.h"
 #include "net/third_party/quiche/src/quic/core/quic_connection.h"
 #include "net/third_party/quiche/src/quic/core/quic_utils.h"
@@ -45,6 +52,11 @@ constexpr int kCustomCertificateMaxValidityDays = 14;
 // being closed.
 constexpr base::TimeDelta kMaxCloseTimeout = base::Seconds(2);
 
+// Connection Attempt Delay of RFC 8305. If nothing is received from a server
+// address in this time, the next address is tried while the earlier attempt
+// keeps going.
+constexpr base::TimeDelta kAddressFallbackDelay = base::Milliseconds(300);
+
 std::set<std::string> HostsFromOrigins(std::set<HostPortPair> origins) {
   std::set<std::string> hosts;
   for (const auto& origin : origins) {
@@ -53,11 +65,12 @@ std::set<std::string> HostsFromOrigins(std::set<HostPortPair> origins) {
   return hosts;
 }
 
-std::unique_ptr<::quic::ProofVerifier> CreateProofVerifier(
+std::unique_ptr<::quic::ProofVerifier> CreateUncachedProofVerifier(
     const NetworkIsolationKey& isolation_key,
     URLRequestContext* context,
     const WebTransportParameters& parameters) {
   if (parameters.server_certificate_fingerprints.empty()) {
+    // The context's CertVerifier verifies chains on the thread pool.
     return std::make_unique<ProofVerifierChromium>(
         context->cert_verifier(), context->ct_policy_enforcer(),
         context->transport_security_state(), context->sct_auditing_delegate(),
@@ -80,6 +93,84 @@ std::unique_ptr<::quic::ProofVerifier> CreateProofVerifier(
   return verifier;
 }
 
+// Verifiers created for the same scope accept the same certificates.
+std::string ProofVerifierScope(const NetworkIsolationKey& isolation_key,
+                               const WebTransportParameters& parameters) {
+  if (parameters.server_certificate_fingerprints.empty()) {
+    return "ca:" + isolation_key.ToString();
+  }
+  std::string scope = "fingerprints";
+  for (const ::quic::CertificateFingerprint& fingerprint :
+       parameters.server_certificate_fingerprints) {
+    scope += ":" + fingerprint.algorithm + "/" + fingerprint.fingerprint;
+  }
+  return scope;
+}
+
+std::unique_ptr<::quic::ProofVerifier> CreateProofVerifier(
+    const NetworkIsolationKey& isolation_key,
+    URLRequestContext* context,
+    const WebTransportParameters& parameters,
+    ProofVerificationCache* verification_cache) {
+  std::unique_ptr<::quic::ProofVerifier> verifier =
+      CreateUncachedProofVerifier(isolation_key, context, parameters);
+  if (!verification_cache) {
+    return verifier;
+  }
+  return std::make_unique<CachingProofVerifier>(
+      std::move(verifier), ProofVerifierScope(isolation_key, parameters),
+      verification_cache);
+}
+
+// Forwards all calls to a session cache shared by multiple clients, since
+// QuicCryptoClientConfig owns its session cache.
+class SharedSessionCache : public ::quic::SessionCache {
+ public:
+  explicit SharedSessionCache(::quic::SessionCache* session_cache)
+      : session_cache_(session_cache) {}
+
+  void Insert(const ::quic::QuicServerId& server_id,
+              bssl::UniquePtr<SSL_SESSION> session,
+              const ::quic::TransportParameters& params,
+              const ::quic::ApplicationState* application_state) override {
+    session_cache_->Insert(server_id, std::move(session), params,
+                           application_state);
+  }
+
+  std::unique_ptr<::quic::QuicResumptionState> Lookup(
+      const ::quic::QuicServerId& server_id,
+      ::quic::QuicWallTime now,
+      const SSL_CTX* ctx) override {
+    return session_cache_->Lookup(server_id, now, ctx);
+  }
+
+  void ClearEarlyData(const ::quic::QuicServerId& server_id) override {
+    session_cache_->ClearEarlyData(server_id);
+  }
+
+  void OnNewTokenReceived(const ::quic::QuicServerId& server_id,
+                          absl::string_view token) override {
+    session_cache_->OnNewTokenReceived(server_id, token);
+  }
+
+  void RemoveExpiredEntries(::quic::QuicWallTime now) override {
+    session_cache_->RemoveExpiredEntries(now);
+  }
+
+  void Clear() override { session_cache_->Clear(); }
+
+ private:
+  ::quic::SessionCache* session_cache_;
+};
+
+std::unique_ptr<::quic::SessionCache> CreateSessionCache(
+    ::quic::SessionCache* shared_session_cache) {
+  if (!shared_session_cache) {
+    return nullptr;
+  }
+  return std::make_unique<SharedSessionCache>(shared_session_cache);
+}
+
 // The stream associated with an extended CONNECT request for the WebTransport
 // session.
 class ConnectStream : public ::quic::QuicSpdyClientStream {
@@ -133,7 +224,9 @@ class WebTransportHttp3ClientSession : public ::quic::QuicSpdyClientSession {
                                       server_id,
                                       crypto_config,
                                       push_promise_index),
-        client_(client) {}
+        client_(client),
+        datagrams_before_retransmissions_(false),
+        keepalive_pinger_(this) {}
 
   bool OnSettingsFrame(const ::quic::SettingsFrame& frame) override {
     if (!::quic::QuicSpdyClientSession::OnSettingsFrame(frame)) {
@@ -168,6 +261,52 @@ class WebTransportHttp3ClientSession : public ::quic::QuicSpdyClientSession {
     return stream_ptr;
   }
 
+  void OnCanWrite() override {
+    // Datagrams sent here and data written by QuicSession share packets.
+    ::quic::QuicConnection::ScopedPacketFlusher flusher(connection());
+    if (datagrams_before_retransmissions_ && !datagram_queue()->empty()) {
+      // See Http3ServerSession::OnCanWrite().
+      datagram_queue()->SendDatagrams();
+    }
+    if (client_->HasQueuedDatagrams()) {
+      client_->OnCanSendDatagrams();
+    }
+    ::quic::QuicSpdyClientSession::OnCanWrite();
+  }
+
+  bool WillingAndAbleToWrite() const override {
+    return ::quic::QuicSpdyClientSession::WillingAndAbleToWrite() ||
+           client_->HasQueuedDatagrams();
+  }
+
+  // Returns true if a datagram sent now is not queued by QUIC.
+  bool CanSendDatagramNow() {
+    return datagram_queue()->empty() &&
+           connection()->CanWrite(::quic::HAS_RETRANSMITTABLE_DATA);
+  }
+
+  void OnCongestionWindowChange(::quic::QuicTime now) override {
+    ::quic::QuicSpdyClientSession::OnCongestionWindowChange(now);
+    MaybeSendAckFrequency();
+    MaybeStartKeepAlive();
+    // Congestion window changes on ACKs, which also confirm MTU probes.
+    client_->OnCongestionWindowChange();
+  }
+
+  void set_datagrams_before_retransmissions(bool enabled) {
+    datagrams_before_retransmissions_ = enabled;
+  }
+
+  void set_ack_frequency(uint32_t ack_eliciting_threshold,
+                         ::quic::QuicTime::Delta max_ack_delay) {
+    ack_eliciting_threshold_ = ack_eliciting_threshold;
+    max_ack_delay_ = max_ack_delay;
+  }
+
+  void set_keepalive_interval(base::TimeDelta interval) {
+    keepalive_interval_ = interval;
+  }
+
   void OnDatagramProcessed(
       absl::optional<::quic::MessageStatus> status) override {
     client_->OnDatagramProcessed(
@@ -176,7 +315,94 @@ class WebTransportHttp3ClientSession : public ::quic::QuicSpdyClientSession {
   }
 
  private:
+  // ACK_FREQUENCY frames are only allowed in 1-RTT packets, so the request is
+  // sent on the first congestion event after the handshake is confirmed.
+  void MaybeSendAckFrequency() {
+    if (ack_frequency_sent_ || ack_eliciting_threshold_ == 0 ||
+        GetHandshakeState() != ::quic::HANDSHAKE_CONFIRMED) {
+      return;
+    }
+    ack_frequency_sent_ = true;
+    absl::optional<::quic::QuicAckFrequencyFrame> frame =
+        Utilities::CreateAckFrequencyFrame(*config(), ack_eliciting_threshold_,
+                                           max_ack_delay_);
+    if (frame) {
+      control_frame_manager().WriteOrBufferAckFrequency(*frame);
+    }
+  }
+
+  // PINGs start once the handshake is confirmed, like ACK_FREQUENCY.
+  void MaybeStartKeepAlive() {
+    if (keepalive_started_ || !keepalive_interval_.is_positive() ||
+        GetHandshakeState() != ::quic::HANDSHAKE_CONFIRMED) {
+      return;
+    }
+    keepalive_started_ = true;
+    // The idle timeout is negotiated with the config.
+    keepalive_pinger_.SetKeepAlive(keepalive_interval_, base::TimeDelta());
+  }
+
   WebTransportHttp3Client* client_;
+  bool datagrams_before_retransmissions_;
+  uint32_t ack_eliciting_threshold_ = 0;
+  ::quic::QuicTime::Delta max_ack_delay_ = ::quic::QuicTime::Delta::Zero();
+  bool ack_frequency_sent_ = false;
+  base::TimeDelta keepalive_interval_;
+  bool keepalive_started_ = false;
+  KeepAlivePinger keepalive_pinger_;
+};
+
+// Owns the socket, writer and reader of a path being validated for migration.
+class MigrationPathContext : public ::quic::QuicPathValidationContext {
+ public:
+  MigrationPathContext(const ::quic::QuicSocketAddress& self_address,
+                       const ::quic::QuicSocketAddress& peer_address,
+                       std::unique_ptr<DatagramClientSocket> socket,
+                       std::unique_ptr<QuicChromiumPacketWriter> writer,
+                       std::unique_ptr<QuicChromiumPacketReader> reader)
+      : ::quic::QuicPathValidationContext(self_address, peer_address),
+        socket_(std::move(socket)),
+        writer_(std::move(writer)),
+        reader_(std::move(reader)) {}
+
+  ::quic::QuicPacketWriter* WriterToUse() override { return writer_.get(); }
+
+  std::unique_ptr<DatagramClientSocket> ReleaseSocket() {
+    return std::move(socket_);
+  }
+  std::unique_ptr<QuicChromiumPacketWriter> ReleaseWriter() {
+    return std::move(writer_);
+  }
+  std::unique_ptr<QuicChromiumPacketReader> ReleaseReader() {
+    return std::move(reader_);
+  }
+
+ private:
+  // Declared in this order so that the reader and writer are destroyed before
+  // the socket.
+  std::unique_ptr<DatagramClientSocket> socket_;
+  std::unique_ptr<QuicChromiumPacketWriter> writer_;
+  std::unique_ptr<QuicChromiumPacketReader> reader_;
+};
+
+class MigrationPathDelegate : public ::quic::QuicPathValidator::ResultDelegate {
+ public:
+  explicit MigrationPathDelegate(base::WeakPtr<WebTransportHttp3Client> client)
+      : client_(client) {}
+
+  void OnPathValidationSuccess(
+      std::unique_ptr<::quic::QuicPathValidationContext> context) override {
+    if (client_)
+      client_->OnMigrationPathValidated(std::move(context));
+  }
+  void OnPathValidationFailure(
+      std::unique_ptr<::quic::QuicPathValidationContext> context) override {
+    if (client_)
+      client_->OnMigrationPathValidationFailed(std::move(context));
+  }
+
+ private:
+  base::WeakPtr<WebTransportHttp3Client> client_;
 };
 
 class WebTransportVisitorProxy : public ::quic::WebTransportVisitor {
@@ -217,7 +443,9 @@ WebTransportHttp3Client::WebTransportHttp3Client(
     WebTransportClientVisitor* visitor,
     const NetworkIsolationKey& isolation_key,
     URLRequestContext* context,
-    const WebTransportParameters& parameters)
+    const WebTransportParameters& parameters,
+    ::quic::SessionCache* session_cache,
+    ProofVerificationCache* verification_cache)
     : url_(url),
       origin_(origin),
       isolation_key_(isolation_key),
@@ -236,8 +464,15 @@ WebTransportHttp3Client::WebTransportHttp3Client(
       // (currently, all certificate verification errors result in "TLS
       // handshake error" even when more detailed message is available).  This
       // requires implementing ProofHandler::OnProofVerifyDetailsAvailable.
-      crypto_config_(CreateProofVerifier(isolation_key_, context, parameters),
-                     /* session_cache */ nullptr) {}
+      crypto_config_(CreateProofVerifier(isolation_key_, context, parameters,
+                                         verification_cache),
+                     CreateSessionCache(session_cache)),
+      datagram_classes_(quic_context_->clock()) {
+  // Only decompression is used by clients, no need to cache.
+  if (!ConfigureCertificateCompression(crypto_config_.ssl_ctx(), nullptr)) {
+    DLOG(WARNING) << "Failed to enable certificate compression.";
+  }
+}
 
 WebTransportHttp3Client::~WebTransportHttp3Client() = default;
 
@@ -281,10 +516,175 @@ void WebTransportHttp3Client::Close(
   return session_.get();
 }
 
+void WebTransportHttp3Client::AddConnectionOptions(
+    const ::quic::QuicTagVector& connection_options,
+    const ::quic::QuicTagVector& client_connection_options) {
+  DCHECK(state_ == net::WebTransportState::NEW);
+  connection_options_.insert(connection_options_.end(),
+                             connection_options.begin(),
+                             connection_options.end());
+  client_connection_options_.insert(client_connection_options_.end(),
+                                    client_connection_options.begin(),
+                                    client_connection_options.end());
+}
+
+void WebTransportHttp3Client::UsePooledSendBuffers() {
+  DCHECK(state_ == net::WebTransportState::NEW);
+  send_buffer_pool_ = std::make_unique<PooledBufferAllocator>(
+      base::ThreadTaskRunnerHandle::Get());
+  pooled_helper_ = std::make_unique<PooledBufferConnectionHelper>(
+      quic_context_->clock(), quic_context_->random_generator(),
+      send_buffer_pool_.get());
+}
+
+void WebTransportHttp3Client::SetDatagramQueueOptions(
+    ::quic::QuicTime::Delta max_time_in_queue,
+    bool datagrams_before_retransmissions) {
+  max_datagram_time_in_queue_ = max_time_in_queue;
+  datagrams_before_retransmissions_ = datagrams_before_retransmissions;
+  ApplyDatagramQueueOptions();
+}
+
+void WebTransportHttp3Client::SetMaxSendRate(
+    ::quic::QuicBandwidth max_send_rate) {
+  max_send_rate_ = max_send_rate;
+  if (session_) {
+    session_->connection()->SetMaxPacingRate(max_send_rate_);
+  }
+}
+
+void WebTransportHttp3Client::SetAckFrequencyOptions(
+    bool enabled,
+    uint32_t ack_eliciting_threshold,
+    ::quic::QuicTime::Delta max_ack_delay) {
+  DCHECK(state_ == net::WebTransportState::NEW);
+  ack_frequency_enabled_ = enabled;
+  ack_eliciting_threshold_ = ack_eliciting_threshold;
+  max_ack_delay_ = max_ack_delay;
+}
+
+void WebTransportHttp3Client::SetQpackSettings(
+    const Utilities::QpackSettings& settings) {
+  DCHECK(state_ == net::WebTransportState::NEW);
+  qpack_settings_ = settings;
+}
+
+void WebTransportHttp3Client::SetKeepAliveOptions(
+    base::TimeDelta interval,
+    base::TimeDelta idle_timeout) {
+  DCHECK(state_ == net::WebTransportState::NEW);
+  keepalive_interval_ = interval;
+  idle_timeout_ = idle_timeout;
+}
+
+void WebTransportHttp3Client::SetBatchPacketReads(bool enabled,
+                                                  size_t max_packets_per_read) {
+  DCHECK(state_ == net::WebTransportState::NEW);
+  batch_packet_reads_ = enabled;
+  max_packets_per_read_ = max_packets_per_read;
+}
+
+void WebTransportHttp3Client::SetNetworkEmulation(
+    const NetworkEmulationOptions& options) {
+  DCHECK(state_ == net::WebTransportState::NEW);
+  network_emulation_ = options;
+}
+
+size_t WebTransportHttp3Client::GetMaxDatagramSize() const {
+  if (!session_ || !connect_stream_ || !web_transport_session_) {
+    return 0;
+  }
+  return Utilities::MaxWebTransportDatagramSize(
+      session_->GetCurrentLargestMessagePayload(), connect_stream_->id());
+}
+
+void WebTransportHttp3Client::SetMaxDatagramSizeCallback(
+    base::RepeatingCallback<void(size_t)> callback) {
+  max_datagram_size_callback_ = std::move(callback);
+}
+
+void WebTransportHttp3Client::OnCongestionWindowChange() {
+  if (!max_datagram_size_callback_) {
+    return;
+  }
+  const size_t max_datagram_size = GetMaxDatagramSize();
+  if (max_datagram_size == last_max_datagram_size_) {
+    return;
+  }
+  last_max_datagram_size_ = max_datagram_size;
+  max_datagram_size_callback_.Run(max_datagram_size);
+}
+
+void WebTransportHttp3Client::ApplyDatagramQueueOptions() {
+  if (!session_) {
+    return;
+  }
+  session_->SetMaxDatagramTimeInQueue(max_datagram_time_in_queue_);
+  // All sessions are created by CreateConnection.
+  static_cast<WebTransportHttp3ClientSession*>(session_.get())
+      ->set_datagrams_before_retransmissions(
+          datagrams_before_retransmissions_);
+}
+
+void WebTransportHttp3Client::SetDatagramClasses(
+    const std::vector<DatagramClassOptions>& classes) {
+  datagram_classes_.SetClasses(classes);
+  ReportQueuedDatagramDrops();
+}
+
+absl::optional<::quic::MessageStatus>
+WebTransportHttp3Client::SendOrQueuePrioritizedDatagram(
+    ::quic::QuicMemSlice datagram,
+    uint32_t priority_class) {
+  if (!web_transport_session_) {
+    return ::quic::MESSAGE_STATUS_INTERNAL_ERROR;
+  }
+  // All sessions are created by CreateConnection.
+  auto* session = static_cast<WebTransportHttp3ClientSession*>(session_.get());
+  if (!datagram_classes_.enabled() ||
+      (datagram_classes_.empty() && session->CanSendDatagramNow())) {
+    return web_transport_session_->SendOrQueueDatagram(std::move(datagram));
+  }
+  if (datagram.length() > GetMaxDatagramSize()) {
+    return ::quic::MESSAGE_STATUS_TOO_LARGE;
+  }
+  if (!datagram_classes_.Enqueue(priority_class, std::move(datagram))) {
+    return absl::nullopt;
+  }
+  ReportQueuedDatagramDrops();
+  return ::quic::MESSAGE_STATUS_BLOCKED;
+}
+
+void WebTransportHttp3Client::OnCanSendDatagrams() {
+  if (!web_transport_session_) {
+    return;
+  }
+  auto* session = static_cast<WebTransportHttp3ClientSession*>(session_.get());
+  ::quic::QuicConnection::ScopedPacketFlusher flusher(session->connection());
+  ::quic::QuicMemSlice datagram;
+  // Stops once QUIC's own queue has a datagram, so lower classes don't pass
+  // higher ones waiting there.
+  while (session->CanSendDatagramNow() &&
+         datagram_classes_.Dequeue(&datagram)) {
+    // Status is reported by OnDatagramProcessed.
+    web_transport_session_->SendOrQueueDatagram(std::move(datagram));
+  }
+  ReportQueuedDatagramDrops();
+}
+
+void WebTransportHttp3Client::ReportQueuedDatagramDrops() {
+  for (size_t dropped = datagram_classes_.TakeDroppedCount(); dropped > 0;
+       dropped--) {
+    visitor_->OnDatagramProcessed(absl::nullopt);
+  }
+}
+
 void WebTransportHttp3Client::DoLoop(int rv) {
   do {
     ConnectState connect_state = next_connect_state_;
     next_connect_state_ = CONNECT_STATE_NONE;
+    TRACE_EVENT1(OWT_TRACE_CATEGORY, "WebTransportHttp3Client::DoLoop",
+                 "connect_state", static_cast<int>(connect_state));
     switch (connect_state) {
       case CONNECT_STATE_INIT:
         DCHECK_EQ(rv, OK);
@@ -402,44 +802,85 @@ int WebTransportHttp3Client::DoResolveHostComplete(int rv) {
     return rv;
 
   DCHECK(resolve_host_request_->GetAddressResults());
+  // Results are cached by the host resolver, which is shared by clients of
+  // the same context.
+  server_addresses_ = Utilities::InterleaveAddressFamilies(
+      *resolve_host_request_->GetAddressResults());
+  server_address_index_ = 0;
+  if (server_addresses_.empty())
+    return ERR_NAME_NOT_RESOLVED;
   next_connect_state_ = CONNECT_STATE_CONNECT;
   return OK;
 }
 
 int WebTransportHttp3Client::DoConnect() {
+  int rv = CreatePacketIo(server_addresses_[server_address_index_]);
+  // E.g.: no route to IPv6 addresses.
+  while (rv != OK && server_address_index_ + 1 < server_addresses_.size()) {
+    server_address_index_++;
+    rv = CreatePacketIo(server_addresses_[server_address_index_]);
+  }
+  if (rv != OK)
+    return rv;
+
+  CreateConnection();
+  StartAddressFallbackTimer();
+  next_connect_state_ = CONNECT_STATE_CONNECT_COMPLETE;
+  return ERR_IO_PENDING;
+}
+
+int WebTransportHttp3Client::CreateSocket(
+    const IPEndPoint& server_address,
+    std::unique_ptr<DatagramClientSocket>* out_socket) {
   int rv = OK;
 
   // TODO(vasilvv): consider unifying parts of this code with QuicSocketFactory
   // (which currently has a lot of code specific to QuicChromiumClientSession).
-  socket_ = client_socket_factory_->CreateDatagramClientSocket(
-      DatagramSocket::DEFAULT_BIND, net_log_.net_log(), net_log_.source());
+  std::unique_ptr<DatagramClientSocket> socket =
+      client_socket_factory_->CreateDatagramClientSocket(
+          DatagramSocket::DEFAULT_BIND, net_log_.net_log(), net_log_.source());
   if (quic_context_->params()->enable_socket_recv_optimization)
-    socket_->EnableRecvOptimization();
-  socket_->UseNonBlockingIO();
+    socket->EnableRecvOptimization();
+  socket->UseNonBlockingIO();
 
-  IPEndPoint server_address =
-      *resolve_host_request_->GetAddressResults()->begin();
-  rv = socket_->Connect(server_address);
+  rv = socket->Connect(server_address);
   if (rv != OK)
     return rv;
 
-  rv = socket_->SetReceiveBufferSize(kQuicSocketReceiveBufferSize);
+  rv = socket->SetReceiveBufferSize(kQuicSocketReceiveBufferSize);
   if (rv != OK)
     return rv;
 
-  rv = socket_->SetDoNotFragment();
+  rv = socket->SetDoNotFragment();
   if (rv == ERR_NOT_IMPLEMENTED)
     rv = OK;
   if (rv != OK)
     return rv;
 
-  rv = socket_->SetSendBufferSize(::quic::kMaxOutgoingPacketSize * 20);
+  rv = socket->SetSendBufferSize(::quic::kMaxOutgoingPacketSize * 20);
   if (rv != OK)
     return rv;
 
-  CreateConnection();
-  next_connect_state_ = CONNECT_STATE_CONNECT_COMPLETE;
-  return ERR_IO_PENDING;
+  *out_socket = std::move(socket);
+  return OK;
+}
+
+int WebTransportHttp3Client::CreatePacketIo(const IPEndPoint& server_address) {
+#if defined(OS_LINUX) || defined(OS_CHROMEOS)
+  if (batch_packet_reads_) {
+    batch_packet_io_ = ClientBatchPacketIo::Create(
+        server_address, kQuicSocketReceiveBufferSize,
+        ::quic::kMaxOutgoingPacketSize * 20, max_packets_per_read_,
+        quic_context_->clock(), this);
+    if (batch_packet_io_) {
+      socket_.reset();
+      return OK;
+    }
+    LOG(WARNING) << "Failed to create batch socket, fall back to "
+                    "DatagramClientSocket.";
+  }
+#endif
+  return CreateSocket(server_address, &socket_);
 }
 
 void WebTransportHttp3Client::CreateConnection() {
@@ -448,44 +889,204 @@ void WebTransportHttp3Client::CreateConnection() {
   packet_reader_ = nullptr;
   session_ = nullptr;
 
-  IPEndPoint server_address =
-      *resolve_host_request_->GetAddressResults()->begin();
+  received_packet_ = false;
+  const IPEndPoint& server_address = server_addresses_[server_address_index_];
   ::quic::QuicConnectionId connection_id =
       ::quic::QuicUtils::CreateRandomConnectionId(
           quic_context_->random_generator());
+  ::quic::QuicPacketWriter* writer = nullptr;
+#if defined(OS_LINUX) || defined(OS_CHROMEOS)
+  if (batch_packet_io_)
+    writer = batch_packet_io_->CreateWriter().release();
+#endif
+  if (!writer)
+    writer = new QuicChromiumPacketWriter(socket_.get(), task_runner_);
+  writer = MaybeEmulateNetwork(writer);
   auto connection = std::make_unique<::quic::QuicConnection>(
       connection_id, ::quic::QuicSocketAddress(),
-      ToQuicSocketAddress(server_address), quic_context_->helper(),
-      alarm_factory_.get(),
-      new QuicChromiumPacketWriter(socket_.get(), task_runner_),
+      ToQuicSocketAddress(server_address),
+      pooled_helper_ ? pooled_helper_.get() : quic_context_->helper(),
+      alarm_factory_.get(), writer,
       /* owns_writer */ true, ::quic::Perspective::IS_CLIENT,
       supported_versions_);
   connection_ = connection.get();
   connection->SetMaxPacketLength(quic_context_->params()->max_packet_length);
 
-  session_ = std::make_unique<WebTransportHttp3ClientSession>(
-      InitializeQuicConfig(*quic_context_->params()), supported_versions_,
-      connection.release(),
+  ::quic::QuicConfig config = InitializeQuicConfig(*quic_context_->params());
+  ::quic::QuicTagVector connection_options =
+      quic_context_->params()->connection_options;
+  connection_options.insert(connection_options.end(),
+                            connection_options_.begin(),
+                            connection_options_.end());
+  config.SetConnectionOptionsToSend(connection_options);
+  ::quic::QuicTagVector client_connection_options =
+      quic_context_->params()->client_connection_options;
+  client_connection_options.insert(client_connection_options.end(),
+                                   client_connection_options_.begin(),
+                                   client_connection_options_.end());
+  config.SetClientConnectionOptions(client_connection_options);
+  if (ack_frequency_enabled_) {
+    // Advertising min_ack_delay lets the server send ACK_FREQUENCY frames.
+    config.SetMinAckDelayMs(::quic::kDefaultMinAckDelayTimeMs);
+  }
+  if (idle_timeout_.is_positive()) {
+    config.SetIdleNetworkTimeout(::quic::QuicTime::Delta::FromMicroseconds(
+        idle_timeout_.InMicroseconds()));
+  }
+  auto session = std::make_unique<WebTransportHttp3ClientSession>(
+      config, supported_versions_, connection.release(),
       ::quic::QuicServerId(url_.host(), url_.EffectiveIntPort()),
       &crypto_config_, &push_promise_index_, this);
-
-  packet_reader_ = std::make_unique<QuicChromiumPacketReader>(
-      socket_.get(), quic_context_->clock(), this, kQuicYieldAfterPacketsRead,
-      ::quic::QuicTime::Delta::FromMilliseconds(
-          kQuicYieldAfterDurationMilliseconds),
-      net_log_);
+  session->set_ack_frequency(ack_eliciting_threshold_, max_ack_delay_);
+  session->set_keepalive_interval(keepalive_interval_);
+  // SETTINGS are sent by Initialize().
+  session->set_qpack_maximum_dynamic_table_capacity(
+      qpack_settings_.max_dynamic_table_capacity);
+  session->set_qpack_maximum_blocked_streams(
+      qpack_settings_.max_blocked_streams);
+  session_ = std::move(session);
+  ApplyDatagramQueueOptions();
+  session_->connection()->SetMaxPacingRate(max_send_rate_);
+
+  if (socket_) {
+    packet_reader_ = std::make_unique<QuicChromiumPacketReader>(
+        socket_.get(), quic_context_->clock(), this, kQuicYieldAfterPacketsRead,
+        ::quic::QuicTime::Delta::FromMilliseconds(
+            kQuicYieldAfterDurationMilliseconds),
+        net_log_);
+  }
 
   event_logger_ = std::make_unique<QuicEventLogger>(session_.get(), net_log_);
   connection_->set_debug_visitor(event_logger_.get());
   connection_->set_creator_debug_delegate(event_logger_.get());
 
   session_->Initialize();
-  packet_reader_->StartReading();
+#if defined(OS_LINUX) || defined(OS_CHROMEOS)
+  if (batch_packet_io_)
+    batch_packet_io_->StartReading();
+#endif
+  if (packet_reader_)
+    packet_reader_->StartReading();
 
   DCHECK(session_->WillNegotiateWebTransport());
   session_->CryptoConnect();
 }
 
+::quic::QuicPacketWriter* WebTransportHttp3Client::MaybeEmulateNetwork(
+    ::quic::QuicPacketWriter* writer) {
+  if (!network_emulation_)
+    return writer;
+  return new NetworkEmulatingPacketWriter(writer, *network_emulation_);
+}
+
+void WebTransportHttp3Client::StartAddressFallbackTimer() {
+  if (server_address_index_ + 1 >= server_addresses_.size())
+    return;
+  address_fallback_timer_.Start(
+      FROM_HERE, kAddressFallbackDelay,
+      base::BindOnce(&WebTransportHttp3Client::OnAddressFallbackTimeout,
+                     weak_factory_.GetWeakPtr()));
+}
+
+bool WebTransportHttp3Client::MaybeTryNextAddress() {
+  if (state_ != net::WebTransportState::CONNECTING ||
+      next_connect_state_ != CONNECT_STATE_CONNECT_COMPLETE) {
+    return false;
+  }
+  if (server_address_index_ + 1 >= server_addresses_.size()) {
+    if (connection_->connected())
+      return false;
+    // The current attempt failed, the earlier one may still succeed.
+    if (racing_attempt_ && racing_attempt_->connection->connected()) {
+      SwapRacingAttempt();
+      racing_attempt_.reset();
+      error_.reset();
+      return true;
+    }
+    racing_attempt_.reset();
+    next_connect_state_ = CONNECT_STATE_NONE;
+    SetErrorIfNecessary(ERR_QUIC_PROTOCOL_ERROR);
+    TransitionToState(net::WebTransportState::FAILED);
+    return true;
+  }
+  address_fallback_timer_.Stop();
+  if (connection_->connected()) {
+    // Keep the current attempt racing the next one. At most two attempts are
+    // in flight.
+    AbandonRacingAttempt();
+    racing_attempt_ = std::make_unique<RacingAttempt>();
+    SwapRacingAttempt();
+    server_address_index_ = racing_attempt_->address_index;
+  } else {
+    // Delete the objects in the same order they would be normally deleted by
+    // the destructor.
+    packet_reader_ = nullptr;
+    session_ = nullptr;
+    connection_ = nullptr;
+  }
+  error_.reset();
+  int rv = ERR_FAILED;
+  while (rv != OK && server_address_index_ + 1 < server_addresses_.size()) {
+    server_address_index_++;
+    DVLOG(1) << "Connecting to "
+             << server_addresses_[server_address_index_].ToString();
+    rv = CreatePacketIo(server_addresses_[server_address_index_]);
+  }
+  if (rv != OK) {
+    if (racing_attempt_ && racing_attempt_->connection->connected()) {
+      // Keep waiting for the earlier attempt.
+      SwapRacingAttempt();
+      racing_attempt_.reset();
+      return true;
+    }
+    racing_attempt_.reset();
+    next_connect_state_ = CONNECT_STATE_NONE;
+    SetErrorIfNecessary(rv);
+    TransitionToState(net::WebTransportState::FAILED);
+    return true;
+  }
+  CreateConnection();
+  StartAddressFallbackTimer();
+  return true;
+}
+
+void WebTransportHttp3Client::SwapRacingAttempt() {
+  DCHECK(racing_attempt_);
+  std::swap(server_address_index_, racing_attempt_->address_index);
+  socket_.swap(racing_attempt_->socket);
+#if defined(OS_LINUX) || defined(OS_CHROMEOS)
+  batch_packet_io_.swap(racing_attempt_->batch_packet_io);
+#endif
+  session_.swap(racing_attempt_->session);
+  std::swap(connection_, racing_attempt_->connection);
+  event_logger_.swap(racing_attempt_->event_logger);
+  packet_reader_.swap(racing_attempt_->packet_reader);
+}
+
+void WebTransportHttp3Client::AbandonRacingAttempt() {
+  if (!racing_attempt_)
+    return;
+  std::unique_ptr<RacingAttempt> attempt = std::move(racing_attempt_);
+  if (attempt->connection->connected()) {
+    abandoning_connection_ = true;
+    attempt->connection->CloseConnection(
+        ::quic::QUIC_CONNECTION_CANCELLED,
+        "Connected to another server address",
+        ::quic::ConnectionCloseBehavior::SILENT_CLOSE);
+    abandoning_connection_ = false;
+  }
+}
+
+void WebTransportHttp3Client::DeleteClosedRacingAttempt() {
+  if (racing_attempt_ && !racing_attempt_->connection->connected())
+    racing_attempt_.reset();
+}
+
+void WebTransportHttp3Client::OnAddressFallbackTimeout() {
+  if (!received_packet_)
+    MaybeTryNextAddress();
+}
+
 int WebTransportHttp3Client::DoConnectComplete() {
   if (!connection_->connected()) {
     return ERR_QUIC_PROTOCOL_ERROR;
@@ -494,11 +1095,73 @@ int WebTransportHttp3Client::DoConnectComplete() {
   if (!session_->SupportsWebTransport()) {
     return ERR_METHOD_NOT_SUPPORTED;
   }
+  address_fallback_timer_.Stop();
   safe_to_report_error_details_ = true;
   next_connect_state_ = CONNECT_STATE_SEND_REQUEST;
   return OK;
 }
 
+bool WebTransportHttp3Client::MigrateToNewSocket() {
+  if (state_ != net::WebTransportState::CONNECTED || migrating_ ||
+      !connection_->connected()) {
+    return false;
+  }
+  std::unique_ptr<DatagramClientSocket> socket;
+  if (CreateSocket(server_addresses_[server_address_index_], &socket) != OK)
+    return false;
+  IPEndPoint self_address;
+  if (socket->GetLocalAddress(&self_address) != OK)
+    return false;
+  auto writer =
+      std::make_unique<QuicChromiumPacketWriter>(socket.get(), task_runner_);
+  // Packets received on the new path are processed by the same session.
+  auto reader = std::make_unique<QuicChromiumPacketReader>(
+      socket.get(), quic_context_->clock(), this, kQuicYieldAfterPacketsRead,
+      ::quic::QuicTime::Delta::FromMilliseconds(
+          kQuicYieldAfterDurationMilliseconds),
+      net_log_);
+  reader->StartReading();
+  migrating_ = true;
+  connection_->ValidatePath(
+      std::make_unique<MigrationPathContext>(
+          ToQuicSocketAddress(self_address), connection_->peer_address(),
+          std::move(socket), std::move(writer), std::move(reader)),
+      std::make_unique<MigrationPathDelegate>(weak_factory_.GetWeakPtr()));
+  return true;
+}
+
+void WebTransportHttp3Client::OnMigrationPathValidated(
+    std::unique_ptr<::quic::QuicPathValidationContext> context) {
+  migrating_ = false;
+  auto* path_context = static_cast<MigrationPathContext*>(context.get());
+  std::unique_ptr<::quic::QuicPacketWriter> writer(
+      MaybeEmulateNetwork(path_context->ReleaseWriter().release()));
+  // The connection deletes the old writer, which references `socket_`.
+  if (!connection_->MigratePath(path_context->self_address(),
+                                path_context->peer_address(), writer.get(),
+                                /*owns_writer=*/true)) {
+    DLOG(WARNING) << "Failed to migrate to the validated path.";
+    return;
+  }
+  writer.release();
+  packet_reader_ = path_context->ReleaseReader();
+  socket_ = path_context->ReleaseSocket();
+#if defined(OS_LINUX) || defined(OS_CHROMEOS)
+  // Its writer is deleted by the connection. It may be dispatching packets of
+  // the old path, so it's deleted later.
+  if (batch_packet_io_)
+    task_runner_->DeleteSoon(FROM_HERE, std::move(batch_packet_io_));
+#endif
+  DVLOG(1) << "Migrated to " << path_context->self_address().ToString();
+}
+
+void WebTransportHttp3Client::OnMigrationPathValidationFailed(
+    std::unique_ptr<::quic::QuicPathValidationContext> context) {
+  migrating_ = false;
+  DLOG(WARNING) << "Failed to validate path from "
+                << context->self_address().ToString();
+}
+
 void WebTransportHttp3Client::OnSettingsReceived() {
   DCHECK_EQ(next_connect_state_, CONNECT_STATE_CONNECT_COMPLETE);
   // Wait until the SETTINGS parser is finished, and then send the request.
@@ -576,10 +1239,20 @@ void WebTransportHttp3Client::TransitionToState(WebTransportState next_state) {
   switch (next_state) {
     case net::WebTransportState::CONNECTING:
       DCHECK_EQ(last_state, net::WebTransportState::NEW);
+      TRACE_EVENT_NESTABLE_ASYNC_BEGIN0(OWT_TRACE_CATEGORY,
+                                        "WebTransportHttp3Client::Handshake",
+                                        TRACE_ID_LOCAL(this));
+      connect_start_time_ = base::TimeTicks::Now();
       break;
 
     case net::WebTransportState::CONNECTED:
       DCHECK_EQ(last_state, WebTransportState::CONNECTING);
+      MetricsRegistry::Record(
+          MetricHistogram::kClientHandshakeLatency,
+          (base::TimeTicks::Now() - connect_start_time_).InMicroseconds());
+      TRACE_EVENT_NESTABLE_ASYNC_END1(
+          OWT_TRACE_CATEGORY, "WebTransportHttp3Client::Handshake",
+          TRACE_ID_LOCAL(this), "connected", true);
       visitor_->OnConnected(http_response_info_->headers);
       break;
 
@@ -594,6 +1267,9 @@ void WebTransportHttp3Client::TransitionToState(WebTransportState next_state) {
     case net::WebTransportState::FAILED:
       DCHECK(error_.has_value());
       if (last_state == WebTransportState::CONNECTING) {
+        TRACE_EVENT_NESTABLE_ASYNC_END1(
+            OWT_TRACE_CATEGORY, "WebTransportHttp3Client::Handshake",
+            TRACE_ID_LOCAL(this), "connected", false);
         visitor_->OnConnectionFailed(*error_);
         break;
       }
@@ -628,6 +1304,9 @@ void WebTransportHttp3Client::SetErrorIfNecessary(
 
 void WebTransportHttp3Client::OnSessionReady(
     const spdy::SpdyHeaderBlock& spdy_headers) {
+  TRACE_EVENT_NESTABLE_ASYNC_INSTANT0(OWT_TRACE_CATEGORY,
+                                      "WebTransportHttp3Client::SessionReady",
+                                      TRACE_ID_LOCAL(this));
   session_ready_ = true;
   http_response_info_ = std::make_unique<net::HttpResponseInfo>();
   SpdyHeadersToHttpResponse(spdy_headers, http_response_info_.get());
@@ -638,6 +1317,8 @@ void WebTransportHttp3Client::OnSessionClosed(
     ::quic::WebTransportSessionError error_code,
     const std::string& error_message) {
   close_info_ = WebTransportCloseInfo(error_code, error_message);
+  datagram_classes_.Clear();
+  ReportQueuedDatagramDrops();
   task_runner_->PostTask(
       FROM_HERE,
       base::BindOnce(&WebTransportHttp3Client::TransitionToState,
@@ -653,6 +1334,9 @@ void WebTransportHttp3Client::OnIncomingUnidirectionalStreamAvailable() {
 }
 
 void WebTransportHttp3Client::OnDatagramReceived(absl::string_view datagram) {
+  TRACE_EVENT1(OWT_TRACE_CATEGORY,
+               "WebTransportHttp3Client::OnDatagramReceived", "length",
+               datagram.size());
   visitor_->OnDatagramReceived(base::StringViewToStringPiece(datagram));
 }
 
@@ -666,17 +1350,47 @@ void WebTransportHttp3Client::OnCanCreateNewOutgoingUnidirectionalStream() {
 
 bool WebTransportHttp3Client::OnReadError(int result,
                                           const DatagramClientSocket* socket) {
+  if (racing_attempt_ && socket == racing_attempt_->socket.get()) {
+    // OnConnectionClosed deletes the attempt later.
+    racing_attempt_->connection->CloseConnection(
+        ::quic::QUIC_PACKET_READ_ERROR, ErrorToString(result),
+        ::quic::ConnectionCloseBehavior::SILENT_CLOSE);
+    return false;
+  }
+  // A socket of a path being validated. The validation fails when it times
+  // out.
+  if (socket != socket_.get())
+    return false;
+  HandleReadError(result);
+  return false;
+}
+
+void WebTransportHttp3Client::HandleReadError(int result) {
+  // The network may be changed, try to keep the session on a new socket.
+  if (migrating_ || MigrateToNewSocket())
+    return;
   SetErrorIfNecessary(result);
   connection_->CloseConnection(::quic::QUIC_PACKET_READ_ERROR,
                                ErrorToString(result),
                                ::quic::ConnectionCloseBehavior::SILENT_CLOSE);
-  return false;
 }
 
 bool WebTransportHttp3Client::OnPacket(
     const ::quic::QuicReceivedPacket& packet,
     const ::quic::QuicSocketAddress& local_address,
     const ::quic::QuicSocketAddress& peer_address) {
+  if (racing_attempt_ &&
+      peer_address == ToQuicSocketAddress(
+                          server_addresses_[racing_attempt_->address_index])) {
+    // The earlier attempt wins the race.
+    SwapRacingAttempt();
+  }
+  if (!received_packet_) {
+    received_packet_ = true;
+    // The other attempt lost. Its reader isn't the caller, so it can be
+    // deleted here.
+    AbandonRacingAttempt();
+  }
   session_->ProcessUdpPacket(local_address, peer_address, packet);
   return connection_->connected();
 }
@@ -696,10 +1410,56 @@ void WebTransportHttp3Client::OnWriteUnblocked() {
   connection_->OnCanWrite();
 }
 
+#if defined(OS_LINUX) || defined(OS_CHROMEOS)
+bool WebTransportHttp3Client::OnBatchPacket(
+    const ::quic::QuicReceivedPacket& packet,
+    const ::quic::QuicSocketAddress& self_address,
+    const ::quic::QuicSocketAddress& peer_address) {
+  return OnPacket(packet, self_address, peer_address);
+}
+
+void WebTransportHttp3Client::OnBatchReadError(
+    int result,
+    const ClientBatchPacketIo* packet_io) {
+  if (racing_attempt_ && packet_io == racing_attempt_->batch_packet_io.get()) {
+    // OnConnectionClosed deletes the attempt later.
+    racing_attempt_->connection->CloseConnection(
+        ::quic::QUIC_PACKET_READ_ERROR, ErrorToString(result),
+        ::quic::ConnectionCloseBehavior::SILENT_CLOSE);
+    return;
+  }
+  HandleReadError(result);
+}
+
+void WebTransportHttp3Client::OnBatchWriteUnblocked(
+    const ClientBatchPacketIo* packet_io) {
+  // Batch writers stay blocked until they're marked writable.
+  if (racing_attempt_ && packet_io == racing_attempt_->batch_packet_io.get()) {
+    racing_attempt_->connection->OnBlockedWriterCanWrite();
+    return;
+  }
+  connection_->OnBlockedWriterCanWrite();
+}
+#endif
+
 void WebTransportHttp3Client::OnConnectionClosed(
     ::quic::QuicErrorCode error,
     const std::string& error_details,
     ::quic::ConnectionCloseSource source) {
+  if (abandoning_connection_)
+    return;
+  if (racing_attempt_ && !racing_attempt_->connection->connected() &&
+      connection_->connected()) {
+    // The racing attempt failed, the current one keeps going. The connection
+    // can't be deleted in this callback.
+    task_runner_->PostTask(
+        FROM_HERE,
+        base::BindOnce(&WebTransportHttp3Client::DeleteClosedRacingAttempt,
+                       weak_factory_.GetWeakPtr()));
+    return;
+  }
+  datagram_classes_.Clear();
+  ReportQueuedDatagramDrops();
   if (!retried_with_new_version_ &&
       session_->error() == ::quic::QUIC_INVALID_VERSION) {
     retried_with_new_version_ = true;
@@ -729,6 +1489,22 @@ void WebTransportHttp3Client::OnConnectionClosed(
     return;
   }
 
+  // The server address may be unreachable, e.g. there is no IPv6
+  // connectivity. Try the next one, or wait for the racing attempt, from the
+  // top of the event loop, since the connection can't be replaced in this
+  // callback.
+  if (state_ == net::WebTransportState::CONNECTING && !received_packet_ &&
+      next_connect_state_ == CONNECT_STATE_CONNECT_COMPLETE &&
+      (server_address_index_ + 1 < server_addresses_.size() ||
+       racing_attempt_)) {
+    task_runner_->PostTask(
+        FROM_HERE,
+        base::BindOnce(
+            base::IgnoreResult(&WebTransportHttp3Client::MaybeTryNextAddress),
+            weak_factory_.GetWeakPtr()));
+    return;
+  }
+
   SetErrorIfNecessary(ERR_QUIC_PROTOCOL_ERROR, error, error_details);
 
   if (state_ == net::WebTransportState::CONNECTING) {
@@ -11,7 +11,10 @@
 #ifndef OWT_WEB_TRANSPORT_WEB_TRANSPORT_WEB_TRANSPORT_HTTP3_CLIENT_H_
 #define OWT_WEB_TRANSPORT_WEB_TRANSPORT_WEB_TRANSPORT_HTTP3_CLIENT_H_
 
+#include "base/callback.h"
 #include "base/memory/weak_ptr.h"
+#include "base/time/time.h"
+#include "build/build_config.h"
 #include "net/base/network_isolation_key.h"
 #include "net/dns/host_resolver.h"
 #include "net/log/net_log_with_source.h"
@@ -27,12 +30,23 @@
 #include "net/third_party/quiche/src/quic/core/crypto/quic_crypto_client_config.h"
 #include "net/third_party/quiche/src/quic/core/http/quic_client_push_promise_index.h"
 #include "net/third_party/quiche/src/quic/core/http/quic_spdy_client_session.h"
+#include "net/third_party/quiche/src/quic/core/quic_bandwidth.h"
 #include "net/third_party/quiche/src/quic/core/quic_config.h"
+#include "net/third_party/quiche/src/quic/core/quic_path_validator.h"
 #include "net/third_party/quiche/src/quic/core/quic_versions.h"
 #include "net/third_party/quiche/src/quic/core/web_transport_interface.h"
 #include "net/third_party/quiche/src/quic/quic_transport/web_transport_fingerprint_proof_verifier.h"
+#include "owt/quic/web_transport_definitions.h"
+#include "owt/web_transport/sdk/impl/datagram_class_queue.h"
+#include "owt/web_transport/sdk/impl/pooled_buffer_allocator.h"
+#include "owt/web_transport/sdk/impl/proof_verification_cache.h"
+#include "owt/web_transport/sdk/impl/utilities.h"
+#include "third_party/abseil-cpp/absl/types/optional.h"
 #include "url/gurl.h"
 #include "url/origin.h"
+#if defined(OS_LINUX) || defined(OS_CHROMEOS)
+#include "owt/web_transport/sdk/impl/client_batch_packet_io.h"
+#endif
 
 namespace net {
 
@@ -50,6 +64,9 @@ namespace quic {
 class WebTransportHttp3Client : public net::WebTransportClient,
                                 public ::quic::WebTransportVisitor,
                                 public net::QuicChromiumPacketReader::Visitor,
+#if defined(OS_LINUX) || defined(OS_CHROMEOS)
+                                public ClientBatchPacketIo::Visitor,
+#endif
                                 public net::QuicChromiumPacketWriter::Delegate {
  public:
   explicit WebTransportHttp3Client(
@@ -58,7 +75,9 @@ class WebTransportHttp3Client : public net::WebTransportClient,
       net::WebTransportClientVisitor* visitor,
       const net::NetworkIsolationKey& isolation_key,
       net::URLRequestContext* context,
-      const net::WebTransportParameters& parameters);
+      const net::WebTransportParameters& parameters,
+      ::quic::SessionCache* session_cache,
+      ProofVerificationCache* verification_cache);
   ~WebTransportHttp3Client() override;
 
   net::WebTransportState state() const { return state_; }
@@ -74,12 +93,103 @@ class WebTransportHttp3Client : public net::WebTransportClient,
   // Return a QUIC session. This method is added by owt developers.
   ::quic::QuicSpdyClientSession* quic_session();
 
+  // Adds QUIC connection options sent to the server, and options only applied
+  // to the client. Must be called before Connect(). This method is added by
+  // owt developers.
+  void AddConnectionOptions(
+      const ::quic::QuicTagVector& connection_options,
+      const ::quic::QuicTagVector& client_connection_options);
+
+  // Allocates stream send buffers and datagram copies of the connection from
+  // a PooledBufferAllocator owned by the current thread. Must be called before
+  // Connect(). This method is added by owt developers.
+  void UsePooledSendBuffers();
+
+  // Zero `max_time_in_queue` restores QUIC's default. When
+  // `datagrams_before_retransmissions` is true, queued datagrams are sent
+  // before lost stream data is retransmitted, see
+  // DatagramPriority::kAboveStreams. Options are kept for connections created
+  // later. This method is added by owt developers.
+  void SetDatagramQueueOptions(::quic::QuicTime::Delta max_time_in_queue,
+                               bool datagrams_before_retransmissions);
+
+  // Datagrams sent by SendOrQueuePrioritizedDatagram are queued in `classes`
+  // while the connection is blocked, and sent before stream data once it's
+  // writable. Empty `classes` sends them like SendOrQueueDatagram. Dropped
+  // datagrams are reported as expired. This method is added by owt
+  // developers.
+  void SetDatagramClasses(const std::vector<DatagramClassOptions>& classes);
+  // Returns absl::nullopt if `priority_class` is full. This method is added
+  // by owt developers.
+  absl::optional<::quic::MessageStatus> SendOrQueuePrioritizedDatagram(
+      ::quic::QuicMemSlice datagram,
+      uint32_t priority_class);
+
+  // Caps the pacing rate of the connection. Zero removes the cap. It's kept
+  // for connections created later. This method is added by owt developers.
+  void SetMaxSendRate(::quic::QuicBandwidth max_send_rate);
+
+  // When `enabled` is true, the connection advertises support for the ACK
+  // frequency extension. When `ack_eliciting_threshold` is not 0, the server
+  // is asked to send an ACK after receiving this many ack-eliciting packets,
+  // or after `max_ack_delay`. Must be called before Connect(). This method is
+  // added by owt developers.
+  void SetAckFrequencyOptions(bool enabled,
+                              uint32_t ack_eliciting_threshold,
+                              ::quic::QuicTime::Delta max_ack_delay);
+  // Sets QPACK settings advertised to the server. Must be called before
+  // Connect(). This method is added by owt developers.
+  void SetQpackSettings(const Utilities::QpackSettings& settings);
+  // Non-zero `idle_timeout` is advertised as the connection's idle timeout.
+  // After the handshake is confirmed, a PING is sent after every `interval`
+  // without received packets, see KeepAlivePinger. Must be called before
+  // Connect(). This method is added by owt developers.
+  void SetKeepAliveOptions(base::TimeDelta interval,
+                           base::TimeDelta idle_timeout);
+  // When `enabled` is true, packets are read in batches by a
+  // ClientBatchPacketIo where it's supported, up to `max_packets_per_read`
+  // per pass, or its default if it's 0. Sockets of paths being validated for
+  // migration still use QuicChromiumPacketReader. Must be called before
+  // Connect(). This method is added by owt developers.
+  void SetBatchPacketReads(bool enabled, size_t max_packets_per_read);
+  // Emulates `options` on packets sent by the connection, see
+  // NetworkEmulatingPacketWriter. Probes of paths being validated for
+  // migration are sent as is. Must be called before Connect(). This method
+  // is added by owt developers.
+  void SetNetworkEmulation(const NetworkEmulationOptions& options);
+
+  // Returns the max size of datagrams which fit in a packet of the current
+  // max packet size, or 0 if the WebTransport session is not established.
+  // This method is added by owt developers.
+  size_t GetMaxDatagramSize() const;
+  // `callback` is run when the value returned by GetMaxDatagramSize()
+  // changes. This method is added by owt developers.
+  void SetMaxDatagramSizeCallback(
+      base::RepeatingCallback<void(size_t)> callback);
+
+  // Moves the connection to a new socket connected to the same server address,
+  // e.g. after the default network changes. The new path is validated before
+  // it's used, streams and datagrams are not interrupted. Returns false if the
+  // session is not connected, or a migration is in progress. This method is
+  // added by owt developers.
+  bool MigrateToNewSocket();
+  // Called by the path validator.
+  void OnMigrationPathValidated(
+      std::unique_ptr<::quic::QuicPathValidationContext> context);
+  void OnMigrationPathValidationFailed(
+      std::unique_ptr<::quic::QuicPathValidationContext> context);
+
   void OnSettingsReceived();
   void OnHeadersComplete();
   void OnConnectStreamWriteSideInDataRecvdState();
   void OnConnectStreamAborted();
   void OnCloseTimeout();
   void OnDatagramProcessed(absl::optional<::quic::MessageStatus> status);
+  void OnCongestionWindowChange();
+  // Sends datagrams queued in `datagram_classes_` while the connection can
+  // send.
+  void OnCanSendDatagrams();
+  bool HasQueuedDatagrams() const { return !datagram_classes_.empty(); }
 
   // QuicTransportClientSession::ClientVisitor methods.
   void OnSessionReady(const spdy::SpdyHeaderBlock&) override;
@@ -106,11 +216,36 @@ class WebTransportHttp3Client : public net::WebTransportClient,
   void OnWriteError(int error_code) override;
   void OnWriteUnblocked() override;
 
+#if defined(OS_LINUX) || defined(OS_CHROMEOS)
+  // ClientBatchPacketIo::Visitor methods.
+  bool OnBatchPacket(const ::quic::QuicReceivedPacket& packet,
+                     const ::quic::QuicSocketAddress& self_address,
+                     const ::quic::QuicSocketAddress& peer_address) override;
+  void OnBatchReadError(int result,
+                        const ClientBatchPacketIo* packet_io) override;
+  void OnBatchWriteUnblocked(const ClientBatchPacketIo* packet_io) override;
+#endif
+
   void OnConnectionClosed(::quic::QuicErrorCode error,
                           const std::string& error_details,
                           ::quic::ConnectionCloseSource source);
 
  private:
+  // An earlier connection attempt racing the current one, see
+  // MaybeTryNextAddress. Members are declared in the reverse order of
+  // destruction, the same as the client's.
+  struct RacingAttempt {
+    size_t address_index = 0;
+    std::unique_ptr<net::DatagramClientSocket> socket;
+#if defined(OS_LINUX) || defined(OS_CHROMEOS)
+    std::unique_ptr<ClientBatchPacketIo> batch_packet_io;
+#endif
+    std::unique_ptr<::quic::QuicSpdyClientSession> session;
+    ::quic::QuicConnection* connection = nullptr;  // Owned by `session`.
+    std::unique_ptr<net::QuicEventLogger> event_logger;
+    std::unique_ptr<net::QuicChromiumPacketReader> packet_reader;
+  };
+
   // State of the connection establishment process.
   enum ConnectState {
     CONNECT_STATE_NONE,
@@ -140,7 +275,40 @@ class WebTransportHttp3Client : public net::WebTransportClient,
   // Establishes the QUIC connection.
   int DoConnect();
   int DoConnectComplete();
+  // Creates `socket_` connected to `server_address`.
+  int CreateSocket(const net::IPEndPoint& server_address,
+                   std::unique_ptr<net::DatagramClientSocket>* out_socket);
+  // Creates `batch_packet_io_` connected to `server_address` if batch reads
+  // are enabled. Otherwise, or if it fails, creates `socket_`.
+  int CreatePacketIo(const net::IPEndPoint& server_address);
+  // Tries to keep the session on a new socket after a read error of the
+  // current path, or closes the connection.
+  void HandleReadError(int result);
   void CreateConnection();
+  // Wraps `writer` with a NetworkEmulatingPacketWriter if network emulation
+  // is enabled.
+  ::quic::QuicPacketWriter* MaybeEmulateNetwork(
+      ::quic::QuicPacketWriter* writer);
+  void ApplyDatagramQueueOptions();
+  // Reports datagrams dropped by `datagram_classes_` to `visitor_`.
+  void ReportQueuedDatagramDrops();
+  // Happy Eyeballs (RFC 8305). Starts a timer for trying the next server
+  // address if there is one.
+  void StartAddressFallbackTimer();
+  // Tries the next server address. If the current attempt is still
+  // connecting, it keeps racing the new one as `racing_attempt_`, replacing
+  // an older racing attempt, and the first attempt receiving a packet wins.
+  // If the current attempt failed and no address is left, `racing_attempt_`
+  // takes its place. Returns false if the current attempt is still
+  // connecting and no address is left.
+  bool MaybeTryNextAddress();
+  void OnAddressFallbackTimeout();
+  // Exchanges the current attempt with `racing_attempt_`.
+  void SwapRacingAttempt();
+  // Closes and deletes `racing_attempt_` if there is one.
+  void AbandonRacingAttempt();
+  // Deletes `racing_attempt_` if its connection is closed.
+  void DeleteClosedRacingAttempt();
   // Sends the CONNECT request to establish a WebTransport session.
   int DoSendRequest();
   // Verifies that the connection has succeeded.
@@ -167,7 +335,30 @@ class WebTransportHttp3Client : public net::WebTransportClient,
   ::quic::ParsedQuicVersionVector supported_versions_;
   // TODO(vasilvv): move some of those into QuicContext.
   std::unique_ptr<net::QuicChromiumAlarmFactory> alarm_factory_;
+  // Replaces the context's helper if it's not null. They outlive connections.
+  std::unique_ptr<PooledBufferAllocator> send_buffer_pool_;
+  std::unique_ptr<PooledBufferConnectionHelper> pooled_helper_;
   ::quic::QuicCryptoClientConfig crypto_config_;
+  ::quic::QuicTagVector connection_options_;
+  ::quic::QuicTagVector client_connection_options_;
+  ::quic::QuicTime::Delta max_datagram_time_in_queue_ =
+      ::quic::QuicTime::Delta::Zero();
+  bool datagrams_before_retransmissions_ = false;
+  DatagramClassQueue datagram_classes_;
+  ::quic::QuicBandwidth max_send_rate_ = ::quic::QuicBandwidth::Zero();
+  bool ack_frequency_enabled_ = false;
+  uint32_t ack_eliciting_threshold_ = 0;
+  ::quic::QuicTime::Delta max_ack_delay_ = ::quic::QuicTime::Delta::Zero();
+  Utilities::QpackSettings qpack_settings_ =
+      Utilities::GetQpackSettings(false, 0, 0);
+  base::TimeDelta keepalive_interval_;
+  base::TimeDelta idle_timeout_;
+  bool batch_packet_reads_ = false;
+  size_t max_packets_per_read_ = 0;
+  absl::optional<NetworkEmulationOptions> network_emulation_;
+  base::RepeatingCallback<void(size_t)> max_datagram_size_callback_;
+  // Value passed to the last `max_datagram_size_callback_` run.
+  size_t last_max_datagram_size_ = 0;
 
   net::WebTransportState state_ = net::WebTransportState::NEW;
   ConnectState next_connect_state_ = CONNECT_STATE_NONE;
@@ -180,8 +371,24 @@ class WebTransportHttp3Client : public net::WebTransportClient,
   net::ProxyInfo proxy_info_;
   std::unique_ptr<net::ProxyResolutionRequest> proxy_resolution_request_;
   std::unique_ptr<net::HostResolver::ResolveHostRequest> resolve_host_request_;
+  // Resolved addresses of the server, in the order of connection attempts.
+  std::vector<net::IPEndPoint> server_addresses_;
+  size_t server_address_index_ = 0;
+  // Whether any packet is received from the current server address.
+  bool received_packet_ = false;
+  // Set when closing the connection of an attempt which is abandoned, so it
+  // doesn't fail the client.
+  bool abandoning_connection_ = false;
+  bool migrating_ = false;
+  // Time when the client starts connecting, for handshake latency metrics.
+  base::TimeTicks connect_start_time_;
+  base::OneShotTimer address_fallback_timer_;
 
   std::unique_ptr<net::DatagramClientSocket> socket_;
+#if defined(OS_LINUX) || defined(OS_CHROMEOS)
+  // Replaces `socket_` and `packet_reader_` when batch reads are enabled.
+  std::unique_ptr<ClientBatchPacketIo> batch_packet_io_;
+#endif
   ::quic::QuicConnection* connection_;  // owned by |session_|
   std::unique_ptr<::quic::QuicSpdyClientSession> session_;
   ::quic::QuicSpdyStream* connect_stream_ = nullptr;
@@ -189,6 +396,7 @@ class WebTransportHttp3Client : public net::WebTransportClient,
   std::unique_ptr<net::QuicChromiumPacketReader> packet_reader_;
   std::unique_ptr<net::QuicEventLogger> event_logger_;
   ::quic::QuicClientPushPromiseIndex push_promise_index_;
+  std::unique_ptr<RacingAttempt> racing_attempt_;
 
   absl::optional<net::WebTransportCloseInfo> close_info_;
 
@@ -7,9 +7,11 @@
 #include "impl/web_transport_owt_client_impl.h"
 #include "base/threading/thread.h"
 #include "net/proxy_resolution/configured_proxy_resolution_service.h"
+#include "net/third_party/quiche/src/quic/core/crypto/crypto_protocol.h"
 #include "net/third_party/quiche/src/quic/core/web_transport_interface.h"
 #include "net/url_request/url_request_context.h"
 #include "net/url_request/url_request_context_builder.h"
+#include "owt/web_transport/sdk/impl/tracing.h"
 #include "owt/web_transport/sdk/impl/utilities.h"
 
 namespace owt {
@@ -44,11 +46,47 @@ WebTransportOwtClientImpl::WebTransportOwtClientImpl(
     net::URLRequestContext* context,
     base::Thread* io_thread,
     base::Thread* event_thread)
+    : WebTransportOwtClientImpl(url,
+                                origin,
+                                parameters,
+                                context,
+                                io_thread,
+                                event_thread->task_runner()) {}
+
+WebTransportOwtClientImpl::WebTransportOwtClientImpl(
+    const GURL& url,
+    const url::Origin& origin,
+    const net::WebTransportParameters& parameters,
+    net::URLRequestContext* context,
+    base::Thread* io_thread,
+    scoped_refptr<base::SingleThreadTaskRunner> event_runner)
     : url_(url),
       origin_(origin),
       parameters_(parameters),
-      event_runner_(event_thread->task_runner()),
-      context_(context) {
+      congestion_control_(CongestionControlType::kDefault),
+      server_congestion_control_(CongestionControlType::kDefault),
+      congestion_profile_(CongestionProfile::kDefault),
+      session_cache_(nullptr),
+      proof_verification_cache_(nullptr),
+      pooled_send_buffers_(false),
+      mtu_discovery_enabled_(false),
+      ack_frequency_enabled_(false),
+      ack_eliciting_threshold_(0),
+      max_ack_delay_ms_(0),
+      qpack_settings_(Utilities::GetQpackSettings(false, 0, 0)),
+      keepalive_interval_ms_(0),
+      idle_timeout_ms_(0),
+      max_stream_receive_window_(0),
+      max_session_receive_window_(0),
+      batch_packet_reads_(false),
+      max_packets_per_read_(0),
+      max_datagram_time_in_queue_ms_(0),
+      datagram_priority_(DatagramPriority::kDefault),
+      max_send_rate_bps_(0),
+      max_datagram_size_(0),
+      event_runner_(std::move(event_runner)),
+      context_(context),
+      warm_stream_pool_(this) {
   CHECK(event_runner_);
   if (!io_thread) {
     LOG(INFO) << "Create a new IO stream.";
@@ -69,6 +107,72 @@ WebTransportOwtClientImpl::WebTransportOwtClientImpl(
   }
 }
 
+void WebTransportOwtClientImpl::SetCongestionControl(
+    CongestionControlType congestion_control,
+    CongestionControlType server_congestion_control,
+    CongestionProfile congestion_profile) {
+  congestion_control_ = congestion_control;
+  server_congestion_control_ = server_congestion_control;
+  congestion_profile_ = congestion_profile;
+}
+
+void WebTransportOwtClientImpl::SetSessionCache(
+    ::quic::SessionCache* session_cache) {
+  session_cache_ = session_cache;
+}
+
+void WebTransportOwtClientImpl::SetProofVerificationCache(
+    ProofVerificationCache* verification_cache) {
+  proof_verification_cache_ = verification_cache;
+}
+
+void WebTransportOwtClientImpl::SetPooledSendBuffers(bool pooled_send_buffers) {
+  pooled_send_buffers_ = pooled_send_buffers;
+}
+
+void WebTransportOwtClientImpl::SetMtuDiscoveryEnabled(bool enabled) {
+  mtu_discovery_enabled_ = enabled;
+}
+
+void WebTransportOwtClientImpl::SetAckFrequencyOptions(
+    bool enabled,
+    uint32_t ack_eliciting_threshold,
+    uint32_t max_ack_delay_ms) {
+  ack_frequency_enabled_ = enabled;
+  ack_eliciting_threshold_ = ack_eliciting_threshold;
+  max_ack_delay_ms_ = max_ack_delay_ms;
+}
+
+void WebTransportOwtClientImpl::SetQpackSettings(
+    const Utilities::QpackSettings& settings) {
+  qpack_settings_ = settings;
+}
+
+void WebTransportOwtClientImpl::SetKeepAliveOptions(uint32_t interval_ms,
+                                                    uint32_t idle_timeout_ms) {
+  keepalive_interval_ms_ = interval_ms;
+  idle_timeout_ms_ = idle_timeout_ms;
+}
+
+void WebTransportOwtClientImpl::SetMaxReceiveWindows(
+    uint32_t max_stream_window,
+    uint32_t max_session_window) {
+  max_stream_receive_window_ = max_stream_window;
+  max_session_receive_window_ = max_session_window;
+}
+
+void WebTransportOwtClientImpl::SetBatchPacketReads(
+    bool enabled,
+    uint32_t max_packets_per_read) {
+  batch_packet_reads_ = enabled;
+  max_packets_per_read_ = max_packets_per_read;
+}
+
+void WebTransportOwtClientImpl::SetNetworkEmulation(
+    const NetworkEmulationOptions& options) {
+  network_emulation_ = options;
+}
+
 WebTransportOwtClientImpl::~WebTransportOwtClientImpl() {
   base::WaitableEvent done(base::WaitableEvent::ResetPolicy::AUTOMATIC,
                            base::WaitableEvent::InitialState::NOT_SIGNALED);
@@ -90,28 +194,207 @@ WebTransportOwtClientImpl::~WebTransportOwtClientImpl() {
 }
 
 void WebTransportOwtClientImpl::Connect() {
-  base::WaitableEvent done(base::WaitableEvent::ResetPolicy::AUTOMATIC,
-                           base::WaitableEvent::InitialState::NOT_SIGNALED);
+  // Tasks posted by the destructor run after this one, so `this` is valid.
   task_runner_->PostTask(
       FROM_HERE,
       base::BindOnce(&WebTransportOwtClientImpl::ConnectOnCurrentThread,
-                     base::Unretained(this), &done));
-  done.Wait();
+                     base::Unretained(this)));
 }
 
 void WebTransportOwtClientImpl::Close() {
   LOG(WARNING) << "Close is not implemented.";
 }
 
-void WebTransportOwtClientImpl::ConnectOnCurrentThread(
-    base::WaitableEvent* event) {
+void WebTransportOwtClientImpl::MigrateConnection() {
+  // Tasks posted by the destructor run after this one, so `this` is valid.
+  task_runner_->PostTask(
+      FROM_HERE,
+      base::BindOnce(
+          &WebTransportOwtClientImpl::MigrateConnectionOnCurrentThread,
+          base::Unretained(this)));
+}
+
+void WebTransportOwtClientImpl::MigrateConnectionOnCurrentThread() {
+  if (!client_ || !client_->MigrateToNewSocket()) {
+    LOG(WARNING) << "Connection migration is not started.";
+  }
+}
+
+void WebTransportOwtClientImpl::SetMaxDatagramTimeInQueue(
+    uint32_t max_time_ms) {
+  // Tasks posted by the destructor run after this one, so `this` is valid.
+  task_runner_->PostTask(
+      FROM_HERE,
+      base::BindOnce(
+          &WebTransportOwtClientImpl::SetMaxDatagramTimeInQueueOnCurrentThread,
+          base::Unretained(this), max_time_ms));
+}
+
+void WebTransportOwtClientImpl::SetMaxDatagramTimeInQueueOnCurrentThread(
+    uint32_t max_time_ms) {
+  max_datagram_time_in_queue_ms_ = max_time_ms;
+  UpdateDatagramQueueOptionsOnCurrentThread();
+}
+
+void WebTransportOwtClientImpl::SetDatagramPriority(
+    DatagramPriority priority) {
+  task_runner_->PostTask(
+      FROM_HERE,
+      base::BindOnce(
+          &WebTransportOwtClientImpl::SetDatagramPriorityOnCurrentThread,
+          base::Unretained(this), priority));
+}
+
+void WebTransportOwtClientImpl::SetDatagramPriorityOnCurrentThread(
+    DatagramPriority priority) {
+  datagram_priority_ = priority;
+  UpdateDatagramQueueOptionsOnCurrentThread();
+}
+
+void WebTransportOwtClientImpl::SetDatagramClasses(
+    const DatagramClassOptions* classes,
+    size_t count) {
+  DCHECK(classes || count == 0);
+  task_runner_->PostTask(
+      FROM_HERE,
+      base::BindOnce(
+          &WebTransportOwtClientImpl::SetDatagramClassesOnCurrentThread,
+          base::Unretained(this),
+          std::vector<DatagramClassOptions>(classes, classes + count)));
+}
+
+void WebTransportOwtClientImpl::SetDatagramClassesOnCurrentThread(
+    std::vector<DatagramClassOptions> classes) {
+  datagram_classes_ = std::move(classes);
+  UpdateDatagramQueueOptionsOnCurrentThread();
+}
+
+void WebTransportOwtClientImpl::SetMaxSendRate(uint64_t bits_per_second) {
+  task_runner_->PostTask(
+      FROM_HERE,
+      base::BindOnce(&WebTransportOwtClientImpl::SetMaxSendRateOnCurrentThread,
+                     base::Unretained(this), bits_per_second));
+}
+
+void WebTransportOwtClientImpl::SetMaxSendRateOnCurrentThread(
+    uint64_t bits_per_second) {
+  max_send_rate_bps_ = bits_per_second;
+  if (client_) {
+    client_->SetMaxSendRate(::quic::QuicBandwidth::FromBitsPerSecond(
+        static_cast<int64_t>(max_send_rate_bps_)));
+  }
+}
+
+void WebTransportOwtClientImpl::SetWarmStreamPoolSize(size_t bidirectional,
+                                                      size_t unidirectional) {
+  task_runner_->PostTask(
+      FROM_HERE,
+      base::BindOnce(
+          &WebTransportOwtClientImpl::SetWarmStreamPoolSizeOnCurrentThread,
+          weak_factory_.GetWeakPtr(), bidirectional, unidirectional));
+}
+
+void WebTransportOwtClientImpl::SetWarmStreamPoolSizeOnCurrentThread(
+    size_t bidirectional,
+    size_t unidirectional) {
+  DCHECK(task_runner_->BelongsToCurrentThread());
+  // Streams are opened by OnConnected if the client is not connected yet.
+  warm_stream_pool_.SetSize(bidirectional, unidirectional);
+}
+
+WebTransportStreamInterface* WebTransportOwtClientImpl::AcquireStream(
+    bool bidirectional) {
+  WebTransportStreamInterface* stream =
+      warm_stream_pool_.Acquire(bidirectional);
+  if (warm_stream_pool_.ScheduleRefill()) {
+    task_runner_->PostTask(
+        FROM_HERE,
+        base::BindOnce(
+            &WebTransportOwtClientImpl::RefillWarmStreamPoolOnCurrentThread,
+            weak_factory_.GetWeakPtr()));
+  }
+  return stream;
+}
+
+void WebTransportOwtClientImpl::RefillWarmStreamPoolOnCurrentThread() {
+  DCHECK(task_runner_->BelongsToCurrentThread());
+  warm_stream_pool_.RefillAll();
+}
+
+WebTransportStreamInterface* WebTransportOwtClientImpl::OpenWarmStream(
+    bool bidirectional) {
+  if (!client_ || client_->state() != net::WebTransportState::CONNECTED) {
+    return nullptr;
+  }
+  return CreateOutgoingStreamOnCurrentThread(bidirectional);
+}
+
+void WebTransportOwtClientImpl::OnCanCreateNewOutgoingBidirectionalStream() {
+  warm_stream_pool_.Refill(true);
+}
+
+void WebTransportOwtClientImpl::OnCanCreateNewOutgoingUnidirectionalStream() {
+  warm_stream_pool_.Refill(false);
+}
+
+void WebTransportOwtClientImpl::UpdateDatagramQueueOptionsOnCurrentThread() {
+  if (!client_) {
+    return;
+  }
+  client_->SetDatagramQueueOptions(
+      ::quic::QuicTime::Delta::FromMilliseconds(max_datagram_time_in_queue_ms_),
+      datagram_priority_ == DatagramPriority::kAboveStreams);
+  client_->SetDatagramClasses(datagram_classes_);
+}
+
+void WebTransportOwtClientImpl::ConnectOnCurrentThread() {
   CHECK(context_);
   CHECK(context_->quic_context());
   client_ = std::make_unique<WebTransportHttp3Client>(
       url_, origin_, this, net::NetworkIsolationKey(origin_, origin_), context_,
-      parameters_);
+      parameters_, session_cache_, proof_verification_cache_);
+  if (pooled_send_buffers_) {
+    client_->UsePooledSendBuffers();
+  }
+  client_->SetAckFrequencyOptions(
+      ack_frequency_enabled_, ack_eliciting_threshold_,
+      ::quic::QuicTime::Delta::FromMilliseconds(max_ack_delay_ms_));
+  client_->SetQpackSettings(qpack_settings_);
+  client_->SetKeepAliveOptions(base::Milliseconds(keepalive_interval_ms_),
+                               base::Milliseconds(idle_timeout_ms_));
+  client_->SetBatchPacketReads(batch_packet_reads_, max_packets_per_read_);
+  if (network_emulation_) {
+    client_->SetNetworkEmulation(*network_emulation_);
+  }
+  UpdateDatagramQueueOptionsOnCurrentThread();
+  client_->SetMaxSendRate(::quic::QuicBandwidth::FromBitsPerSecond(
+      static_cast<int64_t>(max_send_rate_bps_)));
+  // `client_` is owned by this object.
+  client_->SetMaxDatagramSizeCallback(
+      base::BindRepeating(&WebTransportOwtClientImpl::OnMaxDatagramSizeChanged,
+                          base::Unretained(this)));
+  ::quic::QuicTagVector connection_options;
+  ::quic::QuicTagVector client_connection_options;
+  if (congestion_profile_ != CongestionProfile::kDefault) {
+    // A profile applies to both directions, with its own algorithm.
+    connection_options =
+        Utilities::CongestionProfileConnectionOptions(congestion_profile_);
+    client_connection_options = connection_options;
+  } else {
+    client_connection_options.push_back(
+        Utilities::CongestionControlConnectionOption(congestion_control_));
+    if (server_congestion_control_ != CongestionControlType::kDefault) {
+      connection_options.push_back(
+          Utilities::CongestionControlConnectionOption(
+              server_congestion_control_));
+    }
+  }
+  if (mtu_discovery_enabled_) {
+    connection_options.push_back(::quic::kMTUH);
+    client_connection_options.push_back(::quic::kMTUH);
+  }
+  client_->AddConnectionOptions(connection_options, client_connection_options);
   client_->Connect();
-  event->Signal();
 }
 
 void WebTransportOwtClientImpl::CloseOnCurrentThread(
@@ -128,18 +411,63 @@ void WebTransportOwtClientImpl::SetVisitor(
 void WebTransportOwtClientImpl::OnConnected(
     scoped_refptr<net::HttpResponseHeaders> response_headers) {
   LOG(INFO) << "OnConnected.";
-  event_runner_->PostTask(
-      FROM_HERE,
+  max_datagram_size_.store(client_->GetMaxDatagramSize(),
+                           std::memory_order_relaxed);
+  if ((max_stream_receive_window_ > 0 || max_session_receive_window_ > 0) &&
+      !receive_window_tuner_) {
+    // Created before any stream is wrapped, including warm streams opened
+    // below.
+    receive_window_tuner_ =
+        std::make_unique<ReceiveWindowTuner>(client_->quic_session());
+    receive_window_tuner_->SetMaxWindows(max_stream_receive_window_,
+                                         max_session_receive_window_);
+  }
+  warm_stream_pool_.RefillAll();
+  if (event_runner_->BelongsToCurrentThread()) {
+    FireEvent(&WebTransportClientInterface::Visitor::OnConnected);
+    return;
+  }
+  TracingUtilities::PostTask(
+      event_runner_.get(), FROM_HERE, "WebTransportOwtClientImpl::OnConnected",
       base::BindOnce(&WebTransportOwtClientImpl::FireEvent,
                      weak_factory_.GetWeakPtr(),
                      &WebTransportClientInterface::Visitor::OnConnected));
 }
 
+size_t WebTransportOwtClientImpl::GetMaxDatagramSize() const {
+  return max_datagram_size_.load(std::memory_order_relaxed);
+}
+
+void WebTransportOwtClientImpl::OnMaxDatagramSizeChanged(
+    size_t max_datagram_size) {
+  DCHECK(task_runner_->BelongsToCurrentThread());
+  max_datagram_size_.store(max_datagram_size, std::memory_order_relaxed);
+  std::function<void(WebTransportClientInterface::Visitor&)> event =
+      [max_datagram_size](WebTransportClientInterface::Visitor& visitor) {
+        visitor.OnMaxDatagramSizeChanged(max_datagram_size);
+      };
+  if (event_runner_->BelongsToCurrentThread()) {
+    FireEvent(std::move(event));
+    return;
+  }
+  TracingUtilities::PostTask(
+      event_runner_.get(), FROM_HERE,
+      "WebTransportOwtClientImpl::OnMaxDatagramSizeChanged",
+      base::BindOnce(&WebTransportOwtClientImpl::FireEvent,
+                     weak_factory_.GetWeakPtr(), std::move(event)));
+}
+
 void WebTransportOwtClientImpl::OnConnectionFailed(
     const net::WebTransportError& error) {
   LOG(INFO) << "OnConnectionFailed.";
-  event_runner_->PostTask(
-      FROM_HERE,
+  warm_stream_pool_.Clear();
+  if (event_runner_->BelongsToCurrentThread()) {
+    FireEvent(&WebTransportClientInterface::Visitor::OnConnectionFailed);
+    return;
+  }
+  TracingUtilities::PostTask(
+      event_runner_.get(), FROM_HERE,
+      "WebTransportOwtClientImpl::OnConnectionFailed",
       base::BindOnce(
           &WebTransportOwtClientImpl::FireEvent, weak_factory_.GetWeakPtr(),
           &WebTransportClientInterface::Visitor::OnConnectionFailed));
@@ -151,6 +479,7 @@ void WebTransportOwtClientImpl::OnError(const net::WebTransportError& error) {
 
 void WebTransportOwtClientImpl::OnClosed(
     const absl::optional<net::WebTransportCloseInfo>& close_info) {
+  warm_stream_pool_.Clear();
   if (!visitor_)
     return;
   bool has_value(close_info.has_value());
@@ -170,6 +499,9 @@ WebTransportOwtClientImpl::CreateOutgoingUnidirectionalStream() {
 
 WebTransportStreamInterface* WebTransportOwtClientImpl::CreateOutgoingStream(
     bool bidirectional) {
+  if (task_runner_->BelongsToCurrentThread()) {
+    return CreateOutgoingStreamOnCurrentThread(bidirectional);
+  }
   base::WaitableEvent done(base::WaitableEvent::ResetPolicy::AUTOMATIC,
                            base::WaitableEvent::InitialState::NOT_SIGNALED);
   WebTransportStreamInterface* stream(nullptr);
@@ -189,6 +521,66 @@ WebTransportStreamInterface* WebTransportOwtClientImpl::CreateOutgoingStream(
   return stream;
 }
 
+size_t WebTransportOwtClientImpl::CreateBidirectionalStreams(
+    size_t count,
+    WebTransportStreamInterface** streams) {
+  return CreateOutgoingStreams(true, count, streams);
+}
+
+size_t WebTransportOwtClientImpl::CreateOutgoingUnidirectionalStreams(
+    size_t count,
+    WebTransportStreamInterface** streams) {
+  return CreateOutgoingStreams(false, count, streams);
+}
+
+size_t WebTransportOwtClientImpl::CreateOutgoingStreams(
+    bool bidirectional,
+    size_t count,
+    WebTransportStreamInterface** streams) {
+  if (count == 0) {
+    return 0;
+  }
+  DCHECK(streams);
+  if (task_runner_->BelongsToCurrentThread()) {
+    return CreateOutgoingStreamsOnCurrentThread(bidirectional, count, streams);
+  }
+  size_t result(0);
+  base::WaitableEvent done(base::WaitableEvent::ResetPolicy::AUTOMATIC,
+                           base::WaitableEvent::InitialState::NOT_SIGNALED);
+  task_runner_->PostTask(
+      FROM_HERE,
+      base::BindOnce(
+          [](WebTransportOwtClientImpl* client, bool bidirectional,
+             size_t count, WebTransportStreamInterface** streams,
+             size_t* result, base::WaitableEvent* event) {
+            *result = client->CreateOutgoingStreamsOnCurrentThread(
+                bidirectional, count, streams);
+            event->Signal();
+          },
+          base::Unretained(this), bidirectional, count,
+          base::Unretained(streams), base::Unretained(&result),
+          base::Unretained(&done)));
+  done.Wait();
+  return result;
+}
+
+size_t WebTransportOwtClientImpl::CreateOutgoingStreamsOnCurrentThread(
+    bool bidirectional,
+    size_t count,
+    WebTransportStreamInterface** streams) {
+  DCHECK(task_runner_->BelongsToCurrentThread());
+  size_t created = 0;
+  for (; created < count; created++) {
+    WebTransportStreamInterface* stream =
+        CreateOutgoingStreamOnCurrentThread(bidirectional);
+    if (!stream) {
+      break;
+    }
+    streams[created] = stream;
+  }
+  return created;
+}
+
 WebTransportStreamInterface*
 WebTransportOwtClientImpl::CreateOutgoingStreamOnCurrentThread(
     bool bidirectional) {
@@ -209,15 +601,25 @@ WebTransportOwtClientImpl::CreateOutgoingStreamOnCurrentThread(
 }
 
 void WebTransportOwtClientImpl::OnIncomingBidirectionalStreamAvailable() {
-  event_runner_->PostTask(
-      FROM_HERE,
+  if (event_runner_->BelongsToCurrentThread()) {
+    OnIncomingStreamAvailable(true);
+    return;
+  }
+  TracingUtilities::PostTask(
+      event_runner_.get(), FROM_HERE,
+      "WebTransportOwtClientImpl::OnIncomingStreamAvailable",
       base::BindOnce(&WebTransportOwtClientImpl::OnIncomingStreamAvailable,
                      weak_factory_.GetWeakPtr(), true));
 }
 
 void WebTransportOwtClientImpl::OnIncomingUnidirectionalStreamAvailable() {
-  event_runner_->PostTask(
-      FROM_HERE,
+  if (event_runner_->BelongsToCurrentThread()) {
+    OnIncomingStreamAvailable(false);
+    return;
+  }
+  TracingUtilities::PostTask(
+      event_runner_.get(), FROM_HERE,
+      "WebTransportOwtClientImpl::OnIncomingStreamAvailable",
       base::BindOnce(&WebTransportOwtClientImpl::OnIncomingStreamAvailable,
                      weak_factory_.GetWeakPtr(), false));
 }
@@ -240,7 +642,10 @@ void WebTransportOwtClientImpl::OnIncomingStreamAvailable(bool bidirectional) {
 void WebTransportOwtClientImpl::OnDatagramProcessed(
     absl::optional<::quic::MessageStatus> status) {
   if (visitor_) {
-    visitor_->OnDatagramProcessed(Utilities::ConvertMessageStatus(status));
+    // `status` has no value if the datagram expired in queue.
+    visitor_->OnDatagramProcessed(status
+                                      ? Utilities::ConvertMessageStatus(status)
+                                      : MessageStatus::kExpired);
   }
 }
 
@@ -251,12 +656,28 @@ WebTransportOwtClientImpl::OwtStreamForNativeStream(
       std::make_unique<WebTransportStreamImpl>(
           stream,
           client_->quic_session()->GetOrCreateStream(stream->GetStreamId()),
-          task_runner_.get(), event_runner_.get());
+          task_runner_.get(), event_runner_.get(), nullptr);
   WebTransportStreamImpl* stream_ptr(stream_impl.get());
-  streams_.push_back(std::move(stream_impl));
+  stream_ptr->SetDelegate(this);
+  stream_ptr->SetReceiveWindowTuner(receive_window_tuner_.get());
+  streams_[stream_ptr->Id()] = std::move(stream_impl);
   return stream_ptr;
 }
 
+void WebTransportOwtClientImpl::OnStreamClosed(uint32_t id) {
+  DCHECK(task_runner_->BelongsToCurrentThread());
+  auto it = streams_.find(id);
+  if (it == streams_.end()) {
+    return;
+  }
+  // Streams could be reset by the server before they're acquired.
+  warm_stream_pool_.Remove(it->second.get());
+  if (receive_window_tuner_) {
+    receive_window_tuner_->OnStreamClosed(id);
+  }
+  streams_.erase(it);
+}
+
 void WebTransportOwtClientImpl::FireEvent(
     std::function<void(WebTransportClientInterface::Visitor&)> func) {
   if (visitor_) {
@@ -275,9 +696,23 @@ MessageStatus WebTransportOwtClientImpl::SendOrQueueDatagram(uint8_t* data,
                         ->GetStreamSendBufferAllocator();
   ::quic::QuicBuffer buffer = ::quic::QuicBuffer::Copy(
       allocator, absl::string_view(reinterpret_cast<char*>(data), length));
+  return SendOrQueueDatagram(::quic::QuicMemSlice(std::move(buffer)));
+}
+
+MessageStatus WebTransportOwtClientImpl::SendOrQueueDatagram(
+    uint8_t* data,
+    size_t length,
+    BufferReleaseCallback release,
+    void* release_context) {
+  return SendOrQueueDatagram(Utilities::CreateMemSliceForExternalBuffer(
+      data, length, release, release_context));
+}
+
+MessageStatus WebTransportOwtClientImpl::SendOrQueueDatagram(
+    ::quic::QuicMemSlice slice) {
   if (task_runner_->BelongsToCurrentThread()) {
-    auto message_result = client_->session()->SendOrQueueDatagram(
-        ::quic::QuicMemSlice(std::move(buffer)));
+    auto message_result =
+        client_->session()->SendOrQueueDatagram(std::move(slice));
     return Utilities::ConvertMessageStatus(message_result);
   }
   MessageStatus result;
@@ -294,11 +729,61 @@ MessageStatus WebTransportOwtClientImpl::SendOrQueueDatagram(uint8_t* data,
             result = Utilities::ConvertMessageStatus(message_result);
             event->Signal();
           },
-          base::Unretained(this), ::quic::QuicMemSlice(std::move(buffer)),
+          base::Unretained(this), std::move(slice), std::ref(result),
+          base::Unretained(&done)));
+  done.Wait();
+  return result;
+}
+
+MessageStatus WebTransportOwtClientImpl::SendOrQueuePrioritizedDatagram(
+    uint8_t* data,
+    size_t length,
+    uint32_t priority_class) {
+  DCHECK(client_ && client_->quic_session() &&
+         client_->quic_session()->connection() &&
+         client_->quic_session()->connection()->helper());
+  auto* allocator = client_->quic_session()
+                        ->connection()
+                        ->helper()
+                        ->GetStreamSendBufferAllocator();
+  ::quic::QuicMemSlice slice(::quic::QuicBuffer::Copy(
+      allocator, absl::string_view(reinterpret_cast<char*>(data), length)));
+  if (task_runner_->BelongsToCurrentThread()) {
+    return SendOrQueuePrioritizedDatagramOnCurrentThread(std::move(slice),
+                                                         priority_class);
+  }
+  MessageStatus result;
+  base::WaitableEvent done(base::WaitableEvent::ResetPolicy::AUTOMATIC,
+                           base::WaitableEvent::InitialState::NOT_SIGNALED);
+  task_runner_->PostTask(
+      FROM_HERE,
+      base::BindOnce(
+          [](WebTransportOwtClientImpl* client, ::quic::QuicMemSlice slice,
+             uint32_t priority_class, MessageStatus& result,
+             base::WaitableEvent* event) {
+            result = client->SendOrQueuePrioritizedDatagramOnCurrentThread(
+                std::move(slice), priority_class);
+            event->Signal();
+          },
+          base::Unretained(this), std::move(slice), priority_class,
           std::ref(result), base::Unretained(&done)));
   done.Wait();
   return result;
 }
 
+MessageStatus
+WebTransportOwtClientImpl::SendOrQueuePrioritizedDatagramOnCurrentThread(
+    ::quic::QuicMemSlice slice,
+    uint32_t priority_class) {
+  DCHECK(task_runner_->BelongsToCurrentThread());
+  absl::optional<::quic::MessageStatus> message_result =
+      client_->SendOrQueuePrioritizedDatagram(std::move(slice),
+                                              priority_class);
+  if (!message_result) {
+    return MessageStatus::kQueueFull;
+  }
+  return Utilities::ConvertMessageStatus(*message_result);
+}
+
 }  // namespace quic
 }  // namespace owt
@@ -7,9 +7,14 @@
 #ifndef OWT_WEB_TRANSPORT_WEB_TRANSPORT_WEB_TRANSPORT_OWT_CLIENT_IMPL_H_
 #define OWT_WEB_TRANSPORT_WEB_TRANSPORT_WEB_TRANSPORT_OWT_CLIENT_IMPL_H_
 
+#include <atomic>
+#include <unordered_map>
+#include <vector>
 #include "base/memory/weak_ptr.h"
 #include "base/threading/thread.h"
 #include "owt/quic/web_transport_client_interface.h"
+#include "owt/web_transport/sdk/impl/receive_window_tuner.h"
+#include "owt/web_transport/sdk/impl/warm_stream_pool.h"
 #include "owt/web_transport/sdk/impl/web_transport_http3_client.h"
 #include "owt/web_transport/sdk/impl/web_transport_stream_impl.h"
 #include "url/gurl.h"
@@ -20,7 +25,9 @@ namespace quic {
 // This class is thread-safe. All calls to //net will be delegated to
 // io_thread_.
 class WebTransportOwtClientImpl : public WebTransportClientInterface,
-                                  public net::WebTransportClientVisitor {
+                                  public net::WebTransportClientVisitor,
+                                  public WebTransportStreamImpl::Delegate,
+                                  public WarmStreamPool::Delegate {
  public:
   WebTransportOwtClientImpl(const GURL& url,
                             const url::Origin& origin,
@@ -39,14 +46,89 @@ class WebTransportOwtClientImpl : public WebTransportClientInterface,
                             net::URLRequestContext* context,
                             base::Thread* io_thread,
                             base::Thread* event_thread);
+  // Visitor methods are called on `event_runner`.
+  WebTransportOwtClientImpl(
+      const GURL& url,
+      const url::Origin& origin,
+      const net::WebTransportParameters& parameters,
+      net::URLRequestContext* context,
+      base::Thread* io_thread,
+      scoped_refptr<base::SingleThreadTaskRunner> event_runner);
   ~WebTransportOwtClientImpl() override;
 
+  // Sets congestion control algorithms used by this client and requested for
+  // the server, or a profile overriding both. Must be called before Connect().
+  void SetCongestionControl(CongestionControlType congestion_control,
+                            CongestionControlType server_congestion_control,
+                            CongestionProfile congestion_profile);
+  // Resumes TLS sessions cached in `session_cache`, and caches new sessions
+  // in it. It could be shared by clients running on the same IO thread, and
+  // must outlive this client. nullptr disables session resumption. Must be
+  // called before Connect().
+  void SetSessionCache(::quic::SessionCache* session_cache);
+  // Skips verifying server certificate chains cached in `verification_cache`,
+  // and caches chains verified. It could be shared by clients, and must
+  // outlive this client. nullptr disables caching. Must be called before
+  // Connect().
+  void SetProofVerificationCache(ProofVerificationCache* verification_cache);
+  // Allocates send buffers from a pool owned by the IO thread. Must be called
+  // before Connect().
+  void SetPooledSendBuffers(bool pooled_send_buffers);
+  // Enables path MTU discovery of the connection and its server. Must be
+  // called before Connect().
+  void SetMtuDiscoveryEnabled(bool enabled);
+  // See WebTransportHttp3Client::SetAckFrequencyOptions. Must be called before
+  // Connect().
+  void SetAckFrequencyOptions(bool enabled,
+                              uint32_t ack_eliciting_threshold,
+                              uint32_t max_ack_delay_ms);
+  // See WebTransportHttp3Client::SetQpackSettings. Must be called before
+  // Connect().
+  void SetQpackSettings(const Utilities::QpackSettings& settings);
+  // See WebTransportHttp3Client::SetKeepAliveOptions. Must be called before
+  // Connect().
+  void SetKeepAliveOptions(uint32_t interval_ms, uint32_t idle_timeout_ms);
+  // Caps of stream and session receive windows grown by ReceiveWindowTuner.
+  // Must be called before Connect().
+  void SetMaxReceiveWindows(uint32_t max_stream_window,
+                            uint32_t max_session_window);
+  // See WebTransportHttp3Client::SetBatchPacketReads. Must be called before
+  // Connect().
+  void SetBatchPacketReads(bool enabled, uint32_t max_packets_per_read);
+  // See WebTransportHttp3Client::SetNetworkEmulation. Must be called before
+  // Connect().
+  void SetNetworkEmulation(const NetworkEmulationOptions& options);
+
   void SetVisitor(WebTransportClientInterface::Visitor* visitor) override;
   void Connect() override;
   void Close() override;
+  void MigrateConnection() override;
+  void SetMaxDatagramTimeInQueue(uint32_t max_time_ms) override;
+  void SetDatagramPriority(DatagramPriority priority) override;
+  void SetDatagramClasses(const DatagramClassOptions* classes,
+                          size_t count) override;
+  void SetMaxSendRate(uint64_t bits_per_second) override;
+  size_t GetMaxDatagramSize() const override;
   WebTransportStreamInterface* CreateBidirectionalStream() override;
   WebTransportStreamInterface* CreateOutgoingUnidirectionalStream() override;
+  size_t CreateBidirectionalStreams(
+      size_t count,
+      WebTransportStreamInterface** streams) override;
+  size_t CreateOutgoingUnidirectionalStreams(
+      size_t count,
+      WebTransportStreamInterface** streams) override;
+  void SetWarmStreamPoolSize(size_t bidirectional,
+                             size_t unidirectional) override;
+  WebTransportStreamInterface* AcquireStream(bool bidirectional) override;
   MessageStatus SendOrQueueDatagram(uint8_t* data, size_t length) override;
+  MessageStatus SendOrQueueDatagram(uint8_t* data,
+                                    size_t length,
+                                    BufferReleaseCallback release,
+                                    void* release_context) override;
+  MessageStatus SendOrQueuePrioritizedDatagram(
+      uint8_t* data,
+      size_t length,
+      uint32_t priority_class) override;
 
  protected:
   // Overrides net::WebTransportClientVisitor.
@@ -59,15 +141,44 @@ class WebTransportOwtClientImpl : public WebTransportClientInterface,
   void OnIncomingBidirectionalStreamAvailable() override;
   void OnIncomingUnidirectionalStreamAvailable() override;
   void OnDatagramReceived(base::StringPiece datagram) override {}
-  void OnCanCreateNewOutgoingBidirectionalStream() override {}
-  void OnCanCreateNewOutgoingUnidirectionalStream() override {}
+  void OnCanCreateNewOutgoingBidirectionalStream() override;
+  void OnCanCreateNewOutgoingUnidirectionalStream() override;
   void OnDatagramProcessed(
       absl::optional<::quic::MessageStatus> status) override;
 
+  // Overrides WebTransportStreamImpl::Delegate.
+  void OnStreamClosed(uint32_t id) override;
+
+  // Overrides WarmStreamPool::Delegate.
+  WebTransportStreamInterface* OpenWarmStream(bool bidirectional) override;
+
  private:
-  void ConnectOnCurrentThread(base::WaitableEvent* event);
+  MessageStatus SendOrQueueDatagram(::quic::QuicMemSlice slice);
+  void ConnectOnCurrentThread();
+  void MigrateConnectionOnCurrentThread();
+  void SetMaxDatagramTimeInQueueOnCurrentThread(uint32_t max_time_ms);
+  void SetDatagramPriorityOnCurrentThread(DatagramPriority priority);
+  void SetDatagramClassesOnCurrentThread(
+      std::vector<DatagramClassOptions> classes);
+  MessageStatus SendOrQueuePrioritizedDatagramOnCurrentThread(
+      ::quic::QuicMemSlice slice,
+      uint32_t priority_class);
+  void SetMaxSendRateOnCurrentThread(uint64_t bits_per_second);
+  void SetWarmStreamPoolSizeOnCurrentThread(size_t bidirectional,
+                                            size_t unidirectional);
+  void RefillWarmStreamPoolOnCurrentThread();
+  // Applies datagram queue options to `client_` if it's created.
+  void UpdateDatagramQueueOptionsOnCurrentThread();
+  void OnMaxDatagramSizeChanged(size_t max_datagram_size);
   void CloseOnCurrentThread(base::WaitableEvent* event);
   WebTransportStreamInterface* CreateOutgoingStream(bool bidirectional);
+  size_t CreateOutgoingStreams(bool bidirectional,
+                               size_t count,
+                               WebTransportStreamInterface** streams);
+  size_t CreateOutgoingStreamsOnCurrentThread(
+      bool bidirectional,
+      size_t count,
+      WebTransportStreamInterface** streams);
   WebTransportStreamInterface* CreateOutgoingStreamOnCurrentThread(
       bool bidirectional);
   void OnIncomingStreamAvailable(bool bidirectional);
@@ -81,14 +192,46 @@ class WebTransportOwtClientImpl : public WebTransportClientInterface,
   GURL url_;
   url::Origin origin_;
   net::WebTransportParameters parameters_;
+  CongestionControlType congestion_control_;
+  CongestionControlType server_congestion_control_;
+  CongestionProfile congestion_profile_;
+  ::quic::SessionCache* session_cache_;               // Not owned.
+  ProofVerificationCache* proof_verification_cache_;  // Not owned.
+  bool pooled_send_buffers_;
+  bool mtu_discovery_enabled_;
+  bool ack_frequency_enabled_;
+  uint32_t ack_eliciting_threshold_;
+  uint32_t max_ack_delay_ms_;
+  Utilities::QpackSettings qpack_settings_;
+  uint32_t keepalive_interval_ms_;
+  uint32_t idle_timeout_ms_;
+  uint32_t max_stream_receive_window_;
+  uint32_t max_session_receive_window_;
+  bool batch_packet_reads_;
+  uint32_t max_packets_per_read_;
+  absl::optional<NetworkEmulationOptions> network_emulation_;
+  // Datagram queue options. Only accessed on IO thread.
+  uint32_t max_datagram_time_in_queue_ms_;
+  DatagramPriority datagram_priority_;
+  std::vector<DatagramClassOptions> datagram_classes_;
+  // Only accessed on IO thread.
+  uint64_t max_send_rate_bps_;
+  // Written on IO thread, read by GetMaxDatagramSize on any thread.
+  std::atomic<size_t> max_datagram_size_;
   scoped_refptr<base::SingleThreadTaskRunner> task_runner_;
   scoped_refptr<base::SingleThreadTaskRunner> event_runner_;
   std::unique_ptr<net::URLRequestContext> context_owned_;
   net::URLRequestContext* context_;
   std::unique_ptr<WebTransportHttp3Client> client_;
   WebTransportClientInterface::Visitor* visitor_;
-  // TODO: Pop from the vector when a stream is closed.
-  std::vector<std::unique_ptr<WebTransportStreamImpl>> streams_;
+  // Created when connected. Streams hold pointers to it, so it's declared
+  // before `streams_`.
+  std::unique_ptr<ReceiveWindowTuner> receive_window_tuner_;
+  // Live streams. Key is stream ID. Only accessed on IO thread.
+  std::unordered_map<uint32_t, std::unique_ptr<WebTransportStreamImpl>>
+      streams_;
+  // Holds streams of `streams_`, so it's cleared before them.
+  WarmStreamPool warm_stream_pool_;
 
   base::WeakPtrFactory<WebTransportOwtClientImpl> weak_factory_{this};
 };
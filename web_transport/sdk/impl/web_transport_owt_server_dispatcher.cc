@@ -14,17 +14,89 @@
 
 #include "impl/web_transport_owt_server_dispatcher.h"
 #include <memory>
+#include "base/trace_event/trace_event.h"
+#include "impl/address_token_crypter.h"
+#include "impl/async_logger.h"
 #include "impl/http3_server_session.h"
+#include "impl/qlog_writer.h"
+#include "impl/routable_connection_id_generator.h"
+#include "impl/server_stats_counters.h"
+#include "impl/tracing.h"
 #include "net/third_party/quiche/src/quic/core/quic_connection.h"
+#include "net/third_party/quiche/src/quic/core/crypto/crypto_utils.h"
+#include "net/third_party/quiche/src/quic/core/quic_constants.h"
+#include "net/third_party/quiche/src/quic/core/quic_data_writer.h"
 #include "net/third_party/quiche/src/quic/core/quic_dispatcher.h"
 #include "net/third_party/quiche/src/quic/core/quic_types.h"
 #include "net/third_party/quiche/src/quic/core/quic_versions.h"
+#include "third_party/boringssl/src/include/openssl/aead.h"
 
 namespace owt {
 namespace quic {
 
 using namespace ::quic;
 
+namespace {
+// Window of measuring the rate of Initial packets without valid tokens.
+constexpr int64_t kChloRateWindowUs = 1000 * 1000;
+constexpr size_t kRetryIntegrityTagLength = 16;
+
+// Serializes a RETRY packet (RFC 9000 section 17.2.5) sent to a client which
+// chose `original_connection_id` and `client_connection_id`. The integrity tag
+// is computed as specified by RFC 9001 section 5.8. Returns an empty string
+// on failure.
+std::string SerializeRetryPacket(const ParsedQuicVersion& version,
+                                 const QuicConnectionId& client_connection_id,
+                                 const QuicConnectionId& retry_connection_id,
+                                 const QuicConnectionId& original_connection_id,
+                                 absl::string_view token,
+                                 uint8_t unused_bits) {
+  std::string packet(1 + sizeof(QuicVersionLabel) + 1 +
+                         client_connection_id.length() + 1 +
+                         retry_connection_id.length() + token.size() +
+                         kRetryIntegrityTagLength,
+                     '\0');
+  QuicDataWriter writer(packet.size(), &packet[0]);
+  // Long header form, fixed bit and the RETRY packet type.
+  if (!writer.WriteUInt8(0xf0 | (unused_bits & 0x0f)) ||
+      !writer.WriteUInt32(CreateQuicVersionLabel(version)) ||
+      !writer.WriteLengthPrefixedConnectionId(client_connection_id) ||
+      !writer.WriteLengthPrefixedConnectionId(retry_connection_id) ||
+      !writer.WriteStringPiece(token)) {
+    return std::string();
+  }
+  const size_t tag_offset = writer.length();
+  // The pseudo packet is the original connection ID followed by the packet
+  // without its tag.
+  std::string pseudo_packet(1 + original_connection_id.length(), '\0');
+  QuicDataWriter pseudo_writer(pseudo_packet.size(), &pseudo_packet[0]);
+  if (!pseudo_writer.WriteLengthPrefixedConnectionId(original_connection_id)) {
+    return std::string();
+  }
+  pseudo_packet.append(packet.data(), tag_offset);
+  absl::string_view key;
+  absl::string_view nonce;
+  if (!CryptoUtils::GetRetryIntegrityKeysForVersion(version, &key, &nonce)) {
+    return std::string();
+  }
+  bssl::ScopedEVP_AEAD_CTX context;
+  size_t tag_length = 0;
+  if (!EVP_AEAD_CTX_init(context.get(), EVP_aead_aes_128_gcm(),
+                         reinterpret_cast<const uint8_t*>(key.data()),
+                         key.size(), kRetryIntegrityTagLength, nullptr) ||
+      !EVP_AEAD_CTX_seal(
+          context.get(), reinterpret_cast<uint8_t*>(&packet[tag_offset]),
+          &tag_length, kRetryIntegrityTagLength,
+          reinterpret_cast<const uint8_t*>(nonce.data()), nonce.size(),
+          nullptr, 0, reinterpret_cast<const uint8_t*>(pseudo_packet.data()),
+          pseudo_packet.size()) ||
+      tag_length != kRetryIntegrityTagLength) {
+    return std::string();
+  }
+  return packet;
+}
+}  // namespace
+
 WebTransportOwtServerDispatcher::WebTransportOwtServerDispatcher(
     const QuicConfig* config,
     const QuicCryptoServerConfig* crypto_config,
@@ -33,7 +105,7 @@ WebTransportOwtServerDispatcher::WebTransportOwtServerDispatcher(
     std::unique_ptr<QuicCryptoServerStreamBase::Helper> session_helper,
     std::unique_ptr<QuicAlarmFactory> alarm_factory,
     uint8_t expected_server_connection_id_length,
-    std::vector<url::Origin> accepted_origins,
+    const std::vector<url::Origin>& accepted_origins,
     WebTransportServerBackend* backend,
     base::SingleThreadTaskRunner* task_runner,
     base::SingleThreadTaskRunner* event_runner)
@@ -44,7 +116,29 @@ WebTransportOwtServerDispatcher::WebTransportOwtServerDispatcher(
                      std::move(session_helper),
                      std::move(alarm_factory),
                      expected_server_connection_id_length),
-      accepted_origins_(accepted_origins),
+      origin_allowlist_(accepted_origins),
+      expected_server_connection_id_length_(
+          expected_server_connection_id_length),
+      connection_id_generator_(nullptr),
+      issued_connection_ids_(nullptr),
+      worker_index_(0),
+      qlog_writer_(nullptr),
+      stats_counters_(nullptr),
+      congestion_control_(::quic::kBBR),
+      mtu_discovery_enabled_(false),
+      cpu_accounting_enabled_(false),
+      ack_eliciting_threshold_(0),
+      max_ack_delay_(QuicTime::Delta::Zero()),
+      qpack_settings_(Utilities::GetQpackSettings(false, 0, 0)),
+      reject_new_connections_(false),
+      draining_(false),
+      suppress_stateless_resets_until_(QuicTime::Zero()),
+      address_token_crypter_(nullptr),
+      retry_chlo_rate_threshold_(0),
+      chlo_window_start_(QuicTime::Zero()),
+      chlos_in_window_(0),
+      chlos_in_last_window_(0),
+      num_sessions_created_(0),
       visitor_(nullptr),
       backend_(backend),
       runner_(task_runner),
@@ -62,22 +156,268 @@ std::unique_ptr<QuicSession> WebTransportOwtServerDispatcher::CreateQuicSession(
     const QuicSocketAddress& peer_address,
     absl::string_view /*alpn*/,
     const ParsedQuicVersion& version,
-    const ParsedClientHello& /*parsed_chlo*/) {
+    const ParsedClientHello& parsed_chlo) {
+  TRACE_EVENT0(OWT_TRACE_CATEGORY,
+               "WebTransportOwtServerDispatcher::CreateQuicSession");
   auto connection = std::make_unique<QuicConnection>(
       server_connection_id, self_address, peer_address, helper(),
       alarm_factory(), writer(), /*owns_writer=*/false, Perspective::IS_SERVER,
       ParsedQuicVersionVector{version});
+  // A CHLO with a valid token follows a RETRY which chose
+  // `server_connection_id`.
+  QuicConnectionId original_connection_id;
+  const bool retried =
+      address_token_crypter_ && !parsed_chlo.retry_token.empty() &&
+      address_token_crypter_->ValidateToken(parsed_chlo.retry_token,
+                                            peer_address.host(),
+                                            server_connection_id,
+                                            &original_connection_id);
+  if (retried) {
+    // Sent in transport parameters, which authenticate the RETRY. Initial
+    // keys are derived from `server_connection_id` after a RETRY, so they're
+    // installed again.
+    connection->SetOriginalDestinationConnectionId(original_connection_id);
+    connection->InstallInitialCrypters(server_connection_id);
+  }
+  // Congestion control requested by the client is applied when config is
+  // negotiated.
+  connection->sent_packet_manager().SetSendAlgorithm(congestion_control_);
+  if (mtu_discovery_enabled_) {
+    // Probes are sent after the handshake. The target is capped by the
+    // writer's max packet size.
+    connection->SetMtuDiscoveryTarget(
+        ::quic::kMtuDiscoveryTargetPacketSizeHigh);
+  }
   auto session = std::make_unique<Http3ServerSession>(
       config(), GetSupportedVersions(), connection.release(), this,
       session_helper(), crypto_config(), compressed_certs_cache(), backend_,
       runner_, event_runner_);
+  // SETTINGS are sent by Initialize().
+  session->set_qpack_maximum_dynamic_table_capacity(
+      qpack_settings_.max_dynamic_table_capacity);
+  session->set_qpack_maximum_blocked_streams(
+      qpack_settings_.max_blocked_streams);
+  if (cpu_accounting_enabled_) {
+    session->EnableCpuAccounting();
+  }
+  if (retried) {
+    session->config()->SetRetrySourceConnectionIdToSend(server_connection_id);
+  }
   session->Initialize();
-  DLOG(INFO) << "Create a new session for " << peer_address.ToString();
+  session->SetStatsCounters(stats_counters_);
+  session->SetIssuedConnectionIdTable(issued_connection_ids_, worker_index_);
+  session->SetOriginAllowlist(&origin_allowlist_);
+  session->SetAckFrequency(ack_eliciting_threshold_, max_ack_delay_);
+  if (keepalive_interval_.is_positive()) {
+    // The idle timeout is negotiated with the server's config.
+    session->SetKeepAlive(keepalive_interval_, base::TimeDelta());
+  }
+  if (qlog_writer_) {
+    session->SetConnectionLogger(
+        qlog_writer_->MaybeCreateLogger(session->connection()));
+  }
+  // Ended when the WebTransport session is ready.
+  TRACE_EVENT_NESTABLE_ASYNC_BEGIN0(OWT_TRACE_CATEGORY,
+                                    "WebTransportServerSession::Handshake",
+                                    TRACE_ID_LOCAL(session->connection()));
+  num_sessions_created_++;
+  OWT_ASYNC_DLOG(INFO) << "Create a new session for " << peer_address.ToString();
   return session;
 }
 
+QuicConnectionId WebTransportOwtServerDispatcher::GenerateNewServerConnectionId(
+    ParsedQuicVersion version,
+    const QuicConnectionId& connection_id) const {
+  if (!connection_id_generator_) {
+    return QuicDispatcher::GenerateNewServerConnectionId(version,
+                                                         connection_id);
+  }
+  DCHECK_EQ(connection_id_generator_->connection_id_length(),
+            expected_server_connection_id_length_);
+  return connection_id_generator_->GenerateConnectionId(worker_index_,
+                                                        connection_id);
+}
+
+QuicDispatcher::QuicPacketFate WebTransportOwtServerDispatcher::ValidityChecks(
+    const ReceivedPacketInfo& packet_info) {
+  if (!packet_info.version_flag) {
+    // Otherwise, they are answered with stateless resets by QUIC.
+    if (helper()->GetClock()->ApproximateNow() <
+        suppress_stateless_resets_until_) {
+      return kFateDrop;
+    }
+    return QuicDispatcher::ValidityChecks(packet_info);
+  }
+  if (draining_) {
+    return kFateDrop;
+  }
+  // A rejected client gets a handshake failure instead of a RETRY, since
+  // rejection sheds load of clients whose addresses are valid.
+  if (reject_new_connections_) {
+    if (stats_counters_) {
+      stats_counters_->OnConnectionRejected();
+    }
+    return kFateTimeWait;
+  }
+  if (retry_chlo_rate_threshold_ > 0 &&
+      packet_info.form == IETF_QUIC_LONG_HEADER_PACKET &&
+      packet_info.long_packet_type == INITIAL &&
+      packet_info.version.HasRetryIntegrityTag()) {
+    if (packet_info.retry_token.has_value() &&
+        !packet_info.retry_token->empty()) {
+      QuicConnectionId original_connection_id;
+      if (address_token_crypter_->ValidateToken(
+              *packet_info.retry_token, packet_info.peer_address.host(),
+              packet_info.destination_connection_id,
+              &original_connection_id)) {
+        return QuicDispatcher::ValidityChecks(packet_info);
+      }
+      // Expired, forged, or from a NEW_TOKEN frame, which is treated like no
+      // token.
+      if (stats_counters_) {
+        stats_counters_->OnInvalidRetryToken();
+      }
+    }
+    // Initial packets are padded, so RETRY packets don't amplify traffic to
+    // spoofed addresses. Smaller ones are dropped by QuicDispatcher.
+    if (packet_info.packet.length() >= kMinClientInitialPacketLength &&
+        ShouldSendRetry()) {
+      SendRetry(packet_info);
+      return kFateDrop;
+    }
+  }
+  return QuicDispatcher::ValidityChecks(packet_info);
+}
+
+bool WebTransportOwtServerDispatcher::ShouldSendRetry() {
+  const QuicTime now = helper()->GetClock()->ApproximateNow();
+  const int64_t elapsed_us = (now - chlo_window_start_).ToMicroseconds();
+  if (elapsed_us >= kChloRateWindowUs) {
+    chlos_in_last_window_ =
+        elapsed_us < 2 * kChloRateWindowUs ? chlos_in_window_ : 0;
+    chlos_in_window_ = 0;
+    chlo_window_start_ = now;
+  }
+  chlos_in_window_++;
+  // The last window is weighted by how much of it still overlaps the sliding
+  // window ending now.
+  const int64_t overlap_us =
+      kChloRateWindowUs - (now - chlo_window_start_).ToMicroseconds();
+  const uint64_t rate =
+      uint64_t{chlos_in_last_window_} * overlap_us / kChloRateWindowUs +
+      chlos_in_window_;
+  return rate >= retry_chlo_rate_threshold_;
+}
+
+void WebTransportOwtServerDispatcher::SendRetry(
+    const ReceivedPacketInfo& packet_info) {
+  // The connection ID is routed to this worker like the ones of sessions.
+  const QuicConnectionId retry_connection_id = GenerateNewServerConnectionId(
+      packet_info.version, packet_info.destination_connection_id);
+  const std::string token = address_token_crypter_->MintToken(
+      packet_info.peer_address.host(), packet_info.destination_connection_id,
+      retry_connection_id);
+  if (token.empty()) {
+    return;
+  }
+  const std::string packet = SerializeRetryPacket(
+      packet_info.version, packet_info.source_connection_id,
+      retry_connection_id, packet_info.destination_connection_id, token,
+      static_cast<uint8_t>(helper()->GetRandomGenerator()->RandUint64()));
+  // Like stateless resets, RETRY packets are not retransmitted. A client
+  // whose RETRY is lost, or not written because the socket is blocked, sends
+  // its Initial again.
+  if (packet.empty() || writer()->IsWriteBlocked()) {
+    return;
+  }
+  const WriteResult result = writer()->WritePacket(
+      packet.data(), packet.size(), packet_info.self_address.host(),
+      packet_info.peer_address, nullptr);
+  if (writer()->IsBatchMode()) {
+    writer()->Flush();
+  }
+  if (stats_counters_ && result.status == WRITE_STATUS_OK) {
+    stats_counters_->OnRetrySent();
+  }
+}
+
 void WebTransportOwtServerDispatcher::SetVisitor(Visitor* visitor) {
   visitor_ = visitor;
 }
+
+void WebTransportOwtServerDispatcher::SetConnectionIdGenerator(
+    const RoutableConnectionIdGenerator* generator,
+    IssuedConnectionIdTable* issued_ids,
+    uint8_t worker_index) {
+  connection_id_generator_ = generator;
+  issued_connection_ids_ = issued_ids;
+  worker_index_ = worker_index;
+}
+
+void WebTransportOwtServerDispatcher::SetQlogWriter(QlogWriter* writer) {
+  qlog_writer_ = writer;
+}
+
+void WebTransportOwtServerDispatcher::SetStatsCounters(
+    ServerStatsCounters* counters) {
+  stats_counters_ = counters;
+}
+
+void WebTransportOwtServerDispatcher::SetCongestionControl(
+    ::quic::CongestionControlType congestion_control) {
+  congestion_control_ = congestion_control;
+}
+
+void WebTransportOwtServerDispatcher::SetMtuDiscoveryEnabled(bool enabled) {
+  mtu_discovery_enabled_ = enabled;
+}
+
+void WebTransportOwtServerDispatcher::SetKeepAliveInterval(
+    base::TimeDelta interval) {
+  keepalive_interval_ = interval;
+}
+
+void WebTransportOwtServerDispatcher::SetCpuAccountingEnabled(bool enabled) {
+  cpu_accounting_enabled_ = enabled;
+}
+
+void WebTransportOwtServerDispatcher::SetAckFrequency(
+    uint32_t ack_eliciting_threshold,
+    QuicTime::Delta max_ack_delay) {
+  ack_eliciting_threshold_ = ack_eliciting_threshold;
+  max_ack_delay_ = max_ack_delay;
+}
+
+void WebTransportOwtServerDispatcher::SetQpackSettings(
+    const Utilities::QpackSettings& settings) {
+  qpack_settings_ = settings;
+}
+
+void WebTransportOwtServerDispatcher::SetRejectNewConnections(bool reject) {
+  reject_new_connections_ = reject;
+}
+
+void WebTransportOwtServerDispatcher::SetRetryPolicy(
+    AddressTokenCrypter* crypter,
+    uint32_t chlo_rate_threshold) {
+  DCHECK(crypter || chlo_rate_threshold == 0);
+  address_token_crypter_ = crypter;
+  retry_chlo_rate_threshold_ = chlo_rate_threshold;
+}
+
+void WebTransportOwtServerDispatcher::StartDraining() {
+  draining_ = true;
+  // Connections not established yet are closed by SendHttp3GoAway.
+  PerformActionOnActiveSessions([](QuicSession* session) {
+    static_cast<Http3ServerSession*>(session)->SendHttp3GoAway(
+        QUIC_PEER_GOING_AWAY, "Server is draining.");
+  });
+}
+
+void WebTransportOwtServerDispatcher::SuppressStatelessResets(
+    QuicTime::Delta duration) {
+  suppress_stateless_resets_until_ =
+      helper()->GetClock()->ApproximateNow() + duration;
+}
 }  // namespace quic
-}  // namespace owt
\ No newline at end of file
+}  // namespace owt
@@ -16,12 +16,20 @@
 #define OWT_WEB_TRANSPORT_WEB_TRANSPORT_WEB_TRANSPORT_OWT_SERVER_DISPATCHER_H_
 
 #include "base/task/single_thread_task_runner.h"
+#include "base/time/time.h"
 #include "net/third_party/quiche/src/quic/core/quic_dispatcher.h"
+#include "owt/web_transport/sdk/impl/origin_allowlist.h"
+#include "owt/web_transport/sdk/impl/utilities.h"
 #include "url/origin.h"
 
 namespace owt {
 namespace quic {
 
+class AddressTokenCrypter;
+class QlogWriter;
+class IssuedConnectionIdTable;
+class RoutableConnectionIdGenerator;
+class ServerStatsCounters;
 class WebTransportSessionInterface;
 class WebTransportServerBackend;
 
@@ -41,11 +49,67 @@ class WebTransportOwtServerDispatcher : public ::quic::QuicDispatcher {
           session_helper,
       std::unique_ptr<::quic::QuicAlarmFactory> alarm_factory,
       uint8_t expected_server_connection_id_length,
-      std::vector<url::Origin> accepted_origins,
+      // WebTransport requests from other origins are rejected. All origins are
+      // accepted if it's empty.
+      const std::vector<url::Origin>& accepted_origins,
       WebTransportServerBackend* backend,
       base::SingleThreadTaskRunner* task_runner,
       base::SingleThreadTaskRunner* event_runner);
   void SetVisitor(Visitor* visitor);
+  // Server connection IDs will be generated by `generator` and be owned by
+  // `worker_index`. Connection IDs are generated only when the length of the
+  // client chosen one is different from
+  // `expected_server_connection_id_length`. Connection IDs issued later by
+  // sessions are added to `issued_ids`. Both could be nullptr, and they must
+  // outlive this dispatcher.
+  void SetConnectionIdGenerator(const RoutableConnectionIdGenerator* generator,
+                                IssuedConnectionIdTable* issued_ids,
+                                uint8_t worker_index);
+  // New connections sampled by `writer` are logged. `writer` could be nullptr,
+  // and it must outlive this dispatcher.
+  void SetQlogWriter(QlogWriter* writer);
+  // Peer migrations of connections are counted by `counters`. It could be
+  // nullptr, and it must outlive this dispatcher.
+  void SetStatsCounters(ServerStatsCounters* counters);
+  // Sets the congestion control algorithm of new connections. A client could
+  // override it with connection options.
+  void SetCongestionControl(::quic::CongestionControlType congestion_control);
+  // Enables path MTU discovery of new connections.
+  void SetMtuDiscoveryEnabled(bool enabled);
+  // See Http3ServerSession::SetAckFrequency.
+  void SetAckFrequency(uint32_t ack_eliciting_threshold,
+                       ::quic::QuicTime::Delta max_ack_delay);
+  // See Http3ServerSession::SetKeepAlive. Zero `interval` disables keepalive
+  // PINGs of new sessions.
+  void SetKeepAliveInterval(base::TimeDelta interval);
+  // Enables CPU accounting of new sessions, see
+  // Http3ServerSession::EnableCpuAccounting.
+  void SetCpuAccountingEnabled(bool enabled);
+  // Sets QPACK settings advertised by new sessions.
+  void SetQpackSettings(const Utilities::QpackSettings& settings);
+  // While `reject` is true, packets starting new connections are answered
+  // with a stateless CONNECTION_CLOSE, and counted by stats counters.
+  // Established connections and CHLOs already buffered are not affected.
+  void SetRejectNewConnections(bool reject);
+  // Once `chlo_rate_threshold` Initial packets without a valid token arrive
+  // per second, they're answered with RETRY packets carrying tokens minted by
+  // `crypter`, so only clients proving their addresses get handshakes. Below
+  // the threshold, new connections take 1-RTT handshakes as usual. Invalid
+  // tokens are counted and treated like no token. 0 disables RETRY. `crypter`
+  // must outlive this dispatcher.
+  void SetRetryPolicy(AddressTokenCrypter* crypter,
+                      uint32_t chlo_rate_threshold);
+  // Sends HTTP/3 GOAWAY on all connections, and drops packets starting new
+  // connections from now on. They are dropped silently instead of being
+  // rejected, so their retransmissions could reach another process which took
+  // over the socket.
+  void StartDraining();
+  // For `duration` from now, packets of unknown connections without version
+  // are dropped instead of answered with stateless resets, e.g.: after taking
+  // over a socket from another process still serving connections on it.
+  void SuppressStatelessResets(::quic::QuicTime::Delta duration);
+  // Number of sessions created since this dispatcher is constructed.
+  uint64_t num_sessions_created() const { return num_sessions_created_; }
 
   ~WebTransportOwtServerDispatcher() override;
 
@@ -58,9 +122,44 @@ class WebTransportOwtServerDispatcher : public ::quic::QuicDispatcher {
       absl::string_view alpn,
       const ::quic::ParsedQuicVersion& version,
       const ::quic::ParsedClientHello& parsed_chlo) override;
+  ::quic::QuicConnectionId GenerateNewServerConnectionId(
+      ::quic::ParsedQuicVersion version,
+      const ::quic::QuicConnectionId& connection_id) const override;
+  ::quic::QuicDispatcher::QuicPacketFate ValidityChecks(
+      const ::quic::ReceivedPacketInfo& packet_info) override;
 
  private:
-  std::vector<url::Origin> accepted_origins_;
+  // Returns true if the Initial packet just received should be answered with
+  // RETRY, and counts it into the CHLO rate.
+  bool ShouldSendRetry();
+  void SendRetry(const ::quic::ReceivedPacketInfo& packet_info);
+
+  // Shared by all sessions created by this dispatcher.
+  const OriginAllowlist origin_allowlist_;
+  const uint8_t expected_server_connection_id_length_;
+  const RoutableConnectionIdGenerator* connection_id_generator_;
+  IssuedConnectionIdTable* issued_connection_ids_;
+  uint8_t worker_index_;
+  QlogWriter* qlog_writer_;
+  ServerStatsCounters* stats_counters_;
+  ::quic::CongestionControlType congestion_control_;
+  bool mtu_discovery_enabled_;
+  bool cpu_accounting_enabled_;
+  base::TimeDelta keepalive_interval_;
+  uint32_t ack_eliciting_threshold_;
+  ::quic::QuicTime::Delta max_ack_delay_;
+  Utilities::QpackSettings qpack_settings_;
+  bool reject_new_connections_;
+  bool draining_;
+  ::quic::QuicTime suppress_stateless_resets_until_;
+  AddressTokenCrypter* address_token_crypter_;
+  uint32_t retry_chlo_rate_threshold_;
+  // Initial packets without a valid token received in the current one second
+  // window and the last one. The rate is estimated over a sliding window.
+  ::quic::QuicTime chlo_window_start_;
+  uint32_t chlos_in_window_;
+  uint32_t chlos_in_last_window_;
+  uint64_t num_sessions_created_;
   Visitor* visitor_;
   WebTransportServerBackend* backend_;
   base::SingleThreadTaskRunner* runner_;
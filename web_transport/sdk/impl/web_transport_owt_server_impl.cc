@@ -13,185 +13,578 @@
 // with modifications.
 
 #include "impl/web_transport_owt_server_impl.h"
+#include <algorithm>
+#include "base/barrier_closure.h"
 #include "base/bind.h"
-#include "base/threading/thread.h"
-#include "base/threading/thread_task_runner_handle.h"
-#include "impl/http3_server_session.h"
-#include "impl/web_transport_owt_server_dispatcher.h"
-#include "net/base/net_errors.h"
-#include "net/quic/address_utils.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/synchronization/waitable_event.h"
+#include "build/build_config.h"
+#include "impl/async_proof_source.h"
+#include "impl/server_stats_counters.h"
+#include "impl/session_cpu_account.h"
+#include "impl/utilities.h"
 #include "net/quic/platform/impl/quic_chromium_clock.h"
-#include "net/quic/quic_chromium_alarm_factory.h"
-#include "net/quic/quic_chromium_connection_helper.h"
-#include "net/third_party/quiche/src/quic/core/quic_crypto_server_stream_base.h"
-#include "net/third_party/quiche/src/quic/platform/api/quic_default_proof_providers.h"
-#include "net/third_party/quiche/src/quic/platform/api/quic_system_event_loop.h"
-#include "net/third_party/quiche/src/quic/quic_transport/quic_transport_protocol.h"
-#include "net/third_party/quiche/src/quic/tools/quic_transport_simple_server_dispatcher.h"
-#include "net/tools/quic/quic_simple_server_packet_writer.h"
-#include "net/tools/quic/quic_simple_server_socket.h"
+#include "net/third_party/quiche/src/quic/core/crypto/quic_random.h"
+#include "net/third_party/quiche/src/quic/core/quic_constants.h"
+#include "third_party/boringssl/src/include/openssl/ssl.h"
+#if defined(OS_LINUX) || defined(OS_CHROMEOS)
+#include <unistd.h>
+#endif
 
 namespace owt {
 namespace quic {
 
-constexpr char kSourceAddressTokenSecret[] = "owt";
-constexpr size_t kMaxReadsPerEvent = 32;
-constexpr size_t kMaxNewConnectionsPerEvent = 32;
-constexpr int kReadBufferSize = 2 * ::quic::kMaxIncomingPacketSize;
+// Worker index is encoded in one byte of server connection IDs.
+constexpr size_t kMaxIoThreadCount = 255;
+constexpr size_t kMaxEventThreadCount = 64;
+constexpr size_t kMaxSigningThreadCount = 64;
+static_assert(WebTransportServerInterface::kSessionTicketKeyLength ==
+                  SessionTicketCrypter::kKeyLength,
+              "Session ticket key length mismatch.");
+static_assert(WebTransportServerInterface::kAddressTokenKeyLength ==
+                  AddressTokenCrypter::kKeyLength,
+              "Address token key length mismatch.");
+// Length of server connection IDs used for routing packets to workers when
+// there is no ConnectionIdRoutingConfig. It's different from the length of
+// client chosen connection IDs, so the dispatcher always replaces them.
+constexpr uint8_t kDefaultRoutableConnectionIdLength =
+    ::quic::kQuicDefaultConnectionIdLength + 1;
 
-class WebTransportOwtServerImplSessionHelper
-    : public ::quic::QuicCryptoServerStreamBase::Helper {
- public:
-  bool CanAcceptClientHello(const ::quic::CryptoHandshakeMessage& /*message*/,
-                            const ::quic::QuicSocketAddress& /*client_address*/,
-                            const ::quic::QuicSocketAddress& /*peer_address*/,
-                            const ::quic::QuicSocketAddress& /*self_address*/,
-                            std::string* /*error_details*/) const override {
-    return true;
+namespace {
+// Secret of source address tokens minted by QUICHE, e.g.: for NEW_TOKEN
+// frames. It's the first address token key, so servers sharing keys accept
+// each other's tokens, or a random secret if there is no key.
+std::string GetSourceAddressTokenSecret(
+    const WebTransportServerInterface::Options& options) {
+  if (options.address_token_keys && options.address_token_key_count > 0) {
+    return std::string(
+        reinterpret_cast<const char*>(options.address_token_keys),
+        AddressTokenCrypter::kKeyLength);
   }
-};
+  std::string secret(AddressTokenCrypter::kKeyLength, '\0');
+  ::quic::QuicRandom::GetInstance()->RandBytes(&secret[0], secret.size());
+  return secret;
+}
+
+// Moves private key operations of `proof_source` to signing threads if
+// they're enabled by `options`.
+std::unique_ptr<::quic::ProofSource> MaybeOffloadSigning(
+    std::unique_ptr<::quic::ProofSource> proof_source,
+    const WebTransportServerInterface::Options& options,
+    const ThreadScheduling* thread_scheduling) {
+  if (options.signing_thread_count == 0) {
+    return proof_source;
+  }
+  return std::make_unique<AsyncProofSource>(
+      std::move(proof_source),
+      std::min(options.signing_thread_count, kMaxSigningThreadCount),
+      thread_scheduling);
+}
+}  // namespace
 
 WebTransportOwtServerImpl::WebTransportOwtServerImpl(
     int port,
     std::vector<url::Origin> accepted_origins,
     std::unique_ptr<::quic::ProofSource> proof_source,
+    ProofSourceOwt* pkcs12_proof_source,
+    SessionTicketCrypter* ticket_crypter,
+    const WebTransportServerInterface::Options& options,
+    const ThreadScheduling& thread_scheduling,
     base::Thread* io_thread,
-    base::Thread* event_thread)
+    scoped_refptr<base::SingleThreadTaskRunner> event_runner)
     : port_(port),
+      options_(options),
+      network_emulation_(options.network_emulation
+                             ? absl::make_optional(*options.network_emulation)
+                             : absl::nullopt),
+      thread_scheduling_(thread_scheduling),
       version_manager_({::quic::ParsedQuicVersion::RFCv1(),
                         ::quic::ParsedQuicVersion::Draft29()}),
-      clock_(::quic::QuicChromiumClock::GetInstance()),
-      crypto_config_(kSourceAddressTokenSecret,
+      compressed_certificate_cache_(options.compressed_certificate_cache_size),
+      crypto_config_(GetSourceAddressTokenSecret(options),
                      ::quic::QuicRandom::GetInstance(),
-                     std::move(proof_source),
+                     MaybeOffloadSigning(std::move(proof_source),
+                                         options,
+                                         &thread_scheduling_),
                      ::quic::KeyExchangeSource::Default()),
-      dispatcher_(nullptr),
-      socket_(nullptr),
-      backend_(std::make_unique<WebTransportServerBackend>(
-          io_thread->task_runner().get(),
-          event_thread->task_runner().get())),
+      ticket_crypter_(ticket_crypter),
+      address_token_crypter_(::quic::QuicChromiumClock::GetInstance()),
+      pkcs12_proof_source_(pkcs12_proof_source),
+      accepted_origins_(std::move(accepted_origins)),
       task_runner_(io_thread->task_runner()),
-      event_runner_(event_thread->task_runner()),
-      read_buffer_(
-          base::MakeRefCounted<net::IOBufferWithSize>(kReadBufferSize)) {
-  CHECK(backend_);
+      event_threads_(std::make_unique<EventThreadPool>(
+          std::move(event_runner),
+          options.inline_event_dispatch
+              ? 1
+              : std::min(options.event_thread_count, kMaxEventThreadCount),
+          &thread_scheduling_)),
+      io_thread_count_(1),
+      takeover_grace_period_ms_(0),
+      visitor_(nullptr),
+      server_send_buffer_budget_(0),
+      session_send_buffer_budget_(0) {
   CHECK(task_runner_);
-  CHECK(event_runner_);
-  dispatcher_ = std::make_unique<WebTransportOwtServerDispatcher>(
-      &config_, &crypto_config_, &version_manager_,
-      std::make_unique<net::QuicChromiumConnectionHelper>(
-          clock_, ::quic::QuicRandom::GetInstance()),
-      std::make_unique<WebTransportOwtServerImplSessionHelper>(),
-      std::make_unique<net::QuicChromiumAlarmFactory>(task_runner_.get(),
-                                                      clock_),
-      ::quic::kQuicDefaultConnectionIdLength, accepted_origins, backend_.get(),
-      task_runner_.get(), event_runner_.get());
-  dispatcher_->SetVisitor(this);
+  InitializeConfig();
+  if (options_.address_token_key_count > 0 &&
+      !address_token_crypter_.SetKeys(options_.address_token_keys,
+                                      options_.address_token_key_count)) {
+    LOG(ERROR) << "Invalid address token keys, a random key is used.";
+  }
+  // Sessions are resumable only if there is a ticket crypter.
+  const bool accept_early_data =
+      ticket_crypter_ && options_.early_data_policy != EarlyDataPolicy::kReject;
+  SSL_CTX_set_early_data_enabled(crypto_config_.ssl_ctx(), accept_early_data);
+  if (!ConfigureCertificateCompression(crypto_config_.ssl_ctx(),
+                                       &compressed_certificate_cache_)) {
+    LOG(WARNING) << "Failed to enable certificate compression.";
+  }
 }
 
 WebTransportOwtServerImpl::~WebTransportOwtServerImpl() {
+  DestroyWorkers();
+#if defined(OS_LINUX) || defined(OS_CHROMEOS)
+  // Sockets set by SetListeningSockets() but not taken over by workers.
+  for (int fd : listening_sockets_) {
+    close(fd);
+  }
+#endif
+}
+
+void WebTransportOwtServerImpl::InitializeConfig() {
+  if (options_.initial_stream_flow_control_window > 0) {
+    config_.SetInitialStreamFlowControlWindowToSend(
+        std::max<::quic::QuicByteCount>(
+            options_.initial_stream_flow_control_window,
+            ::quic::kMinimumFlowControlSendWindow));
+  }
+  if (options_.initial_session_flow_control_window > 0) {
+    config_.SetInitialSessionFlowControlWindowToSend(
+        std::max<::quic::QuicByteCount>(
+            options_.initial_session_flow_control_window,
+            ::quic::kMinimumFlowControlSendWindow));
+  }
+  if (options_.max_incoming_bidirectional_streams > 0) {
+    config_.SetMaxBidirectionalStreamsToSend(
+        options_.max_incoming_bidirectional_streams);
+  }
+  if (options_.max_incoming_unidirectional_streams > 0) {
+    config_.SetMaxUnidirectionalStreamsToSend(
+        options_.max_incoming_unidirectional_streams);
+  }
+  if (options_.idle_timeout_ms > 0) {
+    config_.SetIdleNetworkTimeout(
+        ::quic::QuicTime::Delta::FromMilliseconds(options_.idle_timeout_ms));
+  }
+  if (options_.enable_ack_frequency) {
+    // Advertising min_ack_delay lets peers send ACK_FREQUENCY frames.
+    config_.SetMinAckDelayMs(::quic::kDefaultMinAckDelayTimeMs);
+  }
+}
+
+// static
+void WebTransportOwtServerImpl::RunAndWait(base::SingleThreadTaskRunner* runner,
+                                           base::OnceClosure task) {
+  if (runner->BelongsToCurrentThread()) {
+    std::move(task).Run();
+    return;
+  }
   base::WaitableEvent done(base::WaitableEvent::ResetPolicy::AUTOMATIC,
                            base::WaitableEvent::InitialState::NOT_SIGNALED);
-  task_runner_->PostTask(
-      FROM_HERE,
-      base::BindOnce(
-          [](WebTransportOwtServerImpl* server, base::WaitableEvent* done) {
-            server->weak_factory_.InvalidateWeakPtrs();
-            server->socket_.reset();
-            server->dispatcher_.reset();
-            done->Signal();
-          },
-          base::Unretained(this), &done));
+  runner->PostTask(FROM_HERE, base::BindOnce(
+                                  [](base::OnceClosure task,
+                                     base::WaitableEvent* done) {
+                                    std::move(task).Run();
+                                    done->Signal();
+                                  },
+                                  std::move(task), &done));
   done.Wait();
 }
 
 int WebTransportOwtServerImpl::Start() {
-  base::WaitableEvent done(base::WaitableEvent::ResetPolicy::AUTOMATIC,
-                           base::WaitableEvent::InitialState::NOT_SIGNALED);
-  task_runner_->PostTask(
-      FROM_HERE,
-      base::BindOnce(&WebTransportOwtServerImpl::StartOnCurrentThread,
-                     base::Unretained(this), &done));
-  done.Wait();
-  if (socket_) {
+  DCHECK(workers_.empty()) << "Server is already started.";
+  CreateWorkers();
+  // The first worker may bind to a random port when `port_` is 0. Other
+  // workers share the port it gets.
+  uint16_t port = port_;
+  bool success = true;
+  for (auto& worker : workers_) {
+    bool started = false;
+    RunAndWait(worker->io_runner(),
+               base::BindOnce(
+                   [](WebTransportOwtServerWorker* worker, uint16_t port,
+                      bool* started) {
+                     *started = worker->StartOnCurrentThread(port);
+                   },
+                   base::Unretained(worker.get()), port,
+                   base::Unretained(&started)));
+    if (!started) {
+      success = false;
+      break;
+    }
+    port = worker->server_address().port();
+  }
+  if (success) {
+    server_address_ = workers_.front()->server_address();
     LOG(INFO) << "WebTransport server is listening "
-              << server_address_.ToString();
+              << server_address_.ToString() << " with " << workers_.size()
+              << " IO thread(s).";
     return EXIT_SUCCESS;
   } else {
+    DestroyWorkers();
     LOG(ERROR) << "Failed to start QUIC transport server.";
     return EXIT_FAILURE;
   }
 }
 
-void WebTransportOwtServerImpl::StartOnCurrentThread(
-    base::WaitableEvent* done) {
-  socket_ = net::CreateQuicSimpleServerSocket(
-      net::IPEndPoint{net::IPAddress::IPv6AllZeros(), port_}, &server_address_);
-  if (socket_ == nullptr) {
-    done->Signal();
-    return;
+void WebTransportOwtServerImpl::CreateWorkers() {
+  size_t worker_count = listening_sockets_.empty() ? io_thread_count_
+                                                    : listening_sockets_.size();
+#if !defined(OS_LINUX) && !defined(OS_CHROMEOS)
+  if (worker_count > 1) {
+    LOG(WARNING) << "Multiple IO threads are only supported on Linux.";
+    worker_count = 1;
+  }
+#endif
+  io_thread_count_ = worker_count;
+  if (worker_count > 1 && !connection_id_generator_) {
+    RoutableConnectionIdGenerator::Config config;
+    config.connection_id_length = kDefaultRoutableConnectionIdLength;
+    connection_id_generator_ = RoutableConnectionIdGenerator::Create(config);
+    CHECK(connection_id_generator_);
+  }
+  if (worker_count > 1 && !issued_connection_ids_) {
+    issued_connection_ids_ = std::make_unique<IssuedConnectionIdTable>();
   }
+  std::vector<WebTransportOwtServerWorker*> workers;
+  for (size_t i = 0; i < worker_count; i++) {
+    base::SingleThreadTaskRunner* io_runner = task_runner_.get();
+    if (i > 0) {
+      auto io_thread = std::make_unique<base::Thread>(
+          "web_transport_io_thread_" + base::NumberToString(i));
+      io_thread->StartWithOptions(
+          base::Thread::Options(base::MessagePumpType::IO, 0));
+      thread_scheduling_.ApplyTo(SdkThread::kIo, i, io_thread.get());
+      io_runner = io_thread->task_runner().get();
+      io_threads_.push_back(std::move(io_thread));
+    }
+    auto worker = std::make_unique<WebTransportOwtServerWorker>(
+        static_cast<uint8_t>(i), worker_count, &config_, &crypto_config_,
+        &version_manager_, accepted_origins_, connection_id_generator_.get(),
+        issued_connection_ids_.get(), qlog_writer_.get(), options_,
+        GetBufferPlacement(i), io_runner, event_threads_.get());
+    worker->backend()->SetVisitor(visitor_);
+    if (i < listening_sockets_.size()) {
+      worker->SetSocketToAdopt(listening_sockets_[i],
+                               base::Milliseconds(takeover_grace_period_ms_));
+    }
+    if (network_emulation_) {
+      worker->SetNetworkEmulation(*network_emulation_);
+    }
+    worker->SetAddressTokenCrypter(&address_token_crypter_);
+    SetSendBufferBudgetForWorker(worker.get());
+    workers.push_back(worker.get());
+    workers_.push_back(std::move(worker));
+  }
+  for (auto& worker : workers_) {
+    worker->SetWorkers(workers);
+  }
+  // Owned by workers now.
+  listening_sockets_.clear();
+}
 
-  dispatcher_->InitializeWithWriter(
-      new net::QuicSimpleServerPacketWriter(socket_.get(), dispatcher_.get()));
-  ScheduleReadPackets();
-  done->Signal();
-  return;
+MemoryPlacement WebTransportOwtServerImpl::GetBufferPlacement(
+    size_t index) const {
+  MemoryPlacement placement;
+  placement.huge_pages = options_.huge_page_buffers;
+  if (options_.numa_local_buffers) {
+    const ThreadScheduling::Settings* settings =
+        thread_scheduling_.Find(SdkThread::kIo, index);
+    if (settings) {
+      placement.numa_node = settings->numa_node;
+    }
+  }
+  return placement;
 }
 
-void WebTransportOwtServerImpl::Stop() {}
+void WebTransportOwtServerImpl::DestroyWorkers() {
+  // All workers are stopped before any of them is destroyed, because packets
+  // forwarded by a running worker may still be in other workers' task queues.
+  for (auto& worker : workers_) {
+    RunAndWait(worker->io_runner(),
+               base::BindOnce(&WebTransportOwtServerWorker::StopOnCurrentThread,
+                              base::Unretained(worker.get())));
+  }
+  for (auto& worker : workers_) {
+    base::SingleThreadTaskRunner* io_runner = worker->io_runner();
+    RunAndWait(io_runner,
+               base::BindOnce(
+                   [](std::unique_ptr<WebTransportOwtServerWorker> worker) {},
+                   std::move(worker)));
+  }
+  workers_.clear();
+  io_threads_.clear();
+}
+
+base::OnceClosure WebTransportOwtServerImpl::CreateEndedCallback() const {
+  return base::BindOnce(
+      [](scoped_refptr<base::SingleThreadTaskRunner> event_runner,
+         WebTransportServerInterface::Visitor* visitor) {
+        if (!visitor) {
+          return;
+        }
+        event_runner->PostTask(
+            FROM_HERE,
+            base::BindOnce(&WebTransportServerInterface::Visitor::OnEnded,
+                           base::Unretained(visitor)));
+      },
+      base::WrapRefCounted(event_threads_->default_runner()), visitor_);
+}
+
+void WebTransportOwtServerImpl::Stop() {
+  for (auto& worker : workers_) {
+    RunAndWait(worker->io_runner(),
+               base::BindOnce(&WebTransportOwtServerWorker::StopOnCurrentThread,
+                              base::Unretained(worker.get())));
+  }
+  CreateEndedCallback().Run();
+}
+
+void WebTransportOwtServerImpl::Drain(uint32_t timeout_ms) {
+  DCHECK(!workers_.empty()) << "Server is not started.";
+  // Called by the last worker drained.
+  base::RepeatingClosure done =
+      base::BarrierClosure(workers_.size(), CreateEndedCallback());
+  for (auto& worker : workers_) {
+    worker->io_runner()->PostTask(
+        FROM_HERE,
+        base::BindOnce(&WebTransportOwtServerWorker::DrainOnCurrentThread,
+                       base::Unretained(worker.get()),
+                       base::Milliseconds(timeout_ms), done));
+  }
+}
 
 void WebTransportOwtServerImpl::SetVisitor(
     WebTransportServerInterface::Visitor* visitor) {
-  backend_->SetVisitor(visitor);
+  visitor_ = visitor;
+  for (auto& worker : workers_) {
+    worker->backend()->SetVisitor(visitor);
+  }
 }
 
-void WebTransportOwtServerImpl::ScheduleReadPackets() {
-  task_runner_->PostTask(FROM_HERE,
-                         base::BindOnce(&WebTransportOwtServerImpl::ReadPackets,
-                                        weak_factory_.GetWeakPtr()));
+void WebTransportOwtServerImpl::SetIoThreadCount(size_t count) {
+  DCHECK(workers_.empty()) << "IO thread count must be set before Start().";
+  if (count == 0 || count > kMaxIoThreadCount) {
+    LOG(ERROR) << "Invalid IO thread count " << count << ".";
+    return;
+  }
+  io_thread_count_ = count;
 }
 
-void WebTransportOwtServerImpl::ReadPackets() {
-  dispatcher_->ProcessBufferedChlos(kMaxNewConnectionsPerEvent);
-  for (size_t i = 0; i < kMaxReadsPerEvent; i++) {
-    int result = socket_->RecvFrom(
-        read_buffer_.get(), read_buffer_->size(), &client_address_,
-        base::BindOnce(&WebTransportOwtServerImpl::OnReadComplete,
-                       base::Unretained(this)));
-    if (result == net::ERR_IO_PENDING) {
-      return;
-    }
-    ProcessReadPacket(result);
+bool WebTransportOwtServerImpl::SetConnectionIdRouting(
+    const ConnectionIdRoutingConfig& config) {
+  DCHECK(workers_.empty())
+      << "Connection ID routing must be set before Start().";
+  // The dispatcher only replaces client chosen connection IDs whose length is
+  // different from the length of server connection IDs.
+  if (config.connection_id_length == ::quic::kQuicDefaultConnectionIdLength) {
+    LOG(ERROR) << "Routable connection IDs cannot be "
+               << static_cast<int>(::quic::kQuicDefaultConnectionIdLength)
+               << " bytes.";
+    return false;
+  }
+  RoutableConnectionIdGenerator::Config generator_config;
+  generator_config.config_id = config.config_id;
+  if (config.server_id) {
+    generator_config.server_id.assign(
+        reinterpret_cast<const char*>(config.server_id),
+        config.server_id_length);
+  }
+  if (config.key) {
+    generator_config.key.assign(reinterpret_cast<const char*>(config.key), 16);
+  }
+  generator_config.connection_id_length = config.connection_id_length;
+  std::unique_ptr<RoutableConnectionIdGenerator> generator =
+      RoutableConnectionIdGenerator::Create(generator_config);
+  if (!generator) {
+    return false;
+  }
+  connection_id_generator_ = std::move(generator);
+  return true;
+}
+
+bool WebTransportOwtServerImpl::EnableQlog(const QlogOptions& options) {
+  DCHECK(workers_.empty()) << "Qlog must be enabled before Start().";
+  std::unique_ptr<QlogWriter> writer = QlogWriter::Create(options);
+  if (!writer) {
+    return false;
+  }
+  qlog_writer_ = std::move(writer);
+  return true;
+}
+
+size_t WebTransportOwtServerImpl::GetListeningSockets(int* fds,
+                                                      size_t max_count) {
+  const size_t count = std::min(max_count, workers_.size());
+  DCHECK(fds || count == 0);
+  for (size_t i = 0; i < count; i++) {
+    WebTransportOwtServerWorker* worker = workers_[i].get();
+    RunAndWait(worker->io_runner(),
+               base::BindOnce(
+                   [](WebTransportOwtServerWorker* worker, int* fd) {
+                     *fd = worker->DuplicateSocketOnCurrentThread();
+                   },
+                   base::Unretained(worker), base::Unretained(&fds[i])));
+  }
+  return workers_.size();
+}
+
+bool WebTransportOwtServerImpl::SetListeningSockets(const int* fds,
+                                                    size_t count,
+                                                    uint32_t grace_period_ms) {
+  DCHECK(workers_.empty()) << "Listening sockets must be set before Start().";
+#if defined(OS_LINUX) || defined(OS_CHROMEOS)
+  if (!fds || count == 0 || count > kMaxIoThreadCount) {
+    LOG(ERROR) << "Invalid number of listening sockets " << count << ".";
+    return false;
+  }
+  listening_sockets_.assign(fds, fds + count);
+  takeover_grace_period_ms_ = grace_period_ms;
+  return true;
+#else
+  LOG(ERROR) << "Taking over sockets is only supported on Linux.";
+  return false;
+#endif
+}
+
+void WebTransportOwtServerImpl::SetSendBufferBudget(uint64_t server_budget,
+                                                    uint64_t session_budget) {
+  server_send_buffer_budget_ = server_budget;
+  session_send_buffer_budget_ = session_budget;
+  for (auto& worker : workers_) {
+    SetSendBufferBudgetForWorker(worker.get());
+  }
+}
+
+bool WebTransportOwtServerImpl::SetSessionTicketKeys(const uint8_t* keys,
+                                                     size_t key_count) {
+  if (!ticket_crypter_) {
+    return false;
+  }
+  return ticket_crypter_->SetKeys(keys, key_count);
+}
+
+bool WebTransportOwtServerImpl::SetAddressTokenKeys(const uint8_t* keys,
+                                                    size_t key_count) {
+  return address_token_crypter_.SetKeys(keys, key_count);
+}
+
+bool WebTransportOwtServerImpl::ReloadCertificate(const char* pfx_path,
+                                                  const char* password) {
+  if (!pkcs12_proof_source_ || !pfx_path || !password) {
+    return false;
   }
-  ScheduleReadPackets();
+  return pkcs12_proof_source_->Initialize(
+      base::FilePath::FromUTF8Unsafe(pfx_path), std::string(password));
 }
 
-void WebTransportOwtServerImpl::OnReadComplete(int result) {
-  ProcessReadPacket(result);
-  ReadPackets();
+ServerStats WebTransportOwtServerImpl::GetServerStats() {
+  ServerStats total = {};
+  for (auto& worker : workers_) {
+    ServerStats stats;
+    worker->stats_counters().Read(&stats);
+    ServerStatsCounters::Accumulate(stats, &total);
+  }
+  return total;
+}
+
+size_t WebTransportOwtServerImpl::GetIoThreadStats(ServerStats* stats,
+                                                   size_t max_count) {
+  const size_t count = std::min(max_count, workers_.size());
+  DCHECK(stats || count == 0);
+  for (size_t i = 0; i < count; i++) {
+    workers_[i]->stats_counters().Read(&stats[i]);
+  }
+  return workers_.size();
 }
 
-void WebTransportOwtServerImpl::ProcessReadPacket(int result) {
-  if (result == 0)
-    result = net::ERR_CONNECTION_CLOSED;
-  if (result < 0) {
-    LOG(ERROR) << "WebTransportOwtServer read failed: "
-               << net::ErrorToString(result);
-    dispatcher_->Shutdown();
+MemoryUsage WebTransportOwtServerImpl::GetMemoryUsage() {
+  MemoryUsage total = {};
+  for (const auto& worker : workers_) {
+    MemoryUsage usage;
+    worker->stats_counters().ReadMemoryUsage(&usage);
+    ServerStatsCounters::Accumulate(usage, &total);
+  }
+  return total;
+}
+
+size_t WebTransportOwtServerImpl::GetTopSessionsByCpu(SessionCpuUsage* sessions,
+                                                      size_t max_count) {
+  DCHECK(sessions || max_count == 0);
+  std::vector<SessionCpuUsage> top_sessions;
+  for (const auto& worker : workers_) {
+    worker->AppendTopSessionsByCpu(&top_sessions);
+  }
+  SessionCpuAccount::KeepTop(&top_sessions, max_count);
+  std::copy(top_sessions.begin(), top_sessions.end(), sessions);
+  return top_sessions.size();
+}
+
+void WebTransportOwtServerImpl::SetSendBufferBudgetForWorker(
+    WebTransportOwtServerWorker* worker) {
+  // Each worker has its own budget, server budget is split evenly.
+  uint64_t worker_budget = server_send_buffer_budget_;
+  if (worker_budget > 0 && io_thread_count_ > 1) {
+    worker_budget = (worker_budget + io_thread_count_ - 1) / io_thread_count_;
+  }
+  worker->io_runner()->PostTask(
+      FROM_HERE,
+      base::BindOnce(&WebTransportServerBackend::SetSendBufferBudget,
+                     base::Unretained(worker->backend()), worker_budget,
+                     session_send_buffer_budget_));
+}
+
+void WebTransportOwtServerImpl::Broadcast(const BroadcastTarget* targets,
+                                          size_t count,
+                                          const uint8_t* data,
+                                          size_t length) {
+  if (count == 0) {
     return;
   }
+  Broadcast(targets, count, Utilities::CreateSharedBuffer(data, length),
+            length);
+}
 
-  ::quic::QuicReceivedPacket packet(read_buffer_->data(), /*length=*/result,
-                                    clock_->Now(), /*owns_buffer=*/false);
-  dispatcher_->ProcessPacket(net::ToQuicSocketAddress(server_address_),
-                             net::ToQuicSocketAddress(client_address_), packet);
+void WebTransportOwtServerImpl::Broadcast(const BroadcastTarget* targets,
+                                          size_t count,
+                                          uint8_t* data,
+                                          size_t length,
+                                          BufferReleaseCallback release,
+                                          void* release_context) {
+  Broadcast(targets, count,
+            Utilities::CreateSharedBufferForExternalBuffer(
+                data, length, release, release_context),
+            length);
 }
 
-void WebTransportOwtServerImpl::OnSession(
-    WebTransportSessionInterface* session) {
-  LOG(INFO) << "On HTTP session, connection ID: " << session->ConnectionId();
+void WebTransportOwtServerImpl::Broadcast(const BroadcastTarget* targets,
+                                          size_t count,
+                                          scoped_refptr<net::IOBuffer> payload,
+                                          size_t length) {
+  std::vector<BroadcastTarget> target_list(targets, targets + count);
+  // Sessions are not grouped by worker here, each worker skips sessions it
+  // doesn't own.
+  for (auto& worker : workers_) {
+    if (worker->io_runner()->BelongsToCurrentThread()) {
+      worker->backend()->Broadcast(target_list, payload, length);
+      continue;
+    }
+    worker->io_runner()->PostTask(
+        FROM_HERE,
+        base::BindOnce(&WebTransportServerBackend::Broadcast,
+                       base::Unretained(worker->backend()), target_list,
+                       payload, length));
+  }
 }
 
 }  // namespace quic
-}  // namespace owt
\ No newline at end of file
+}  // namespace owt
@@ -15,81 +15,155 @@
 #ifndef OWT_WEB_TRANSPORT_WEB_TRANSPORT_WEB_TRANSPORT_OWT_SERVER_IMPL_H_
 #define OWT_WEB_TRANSPORT_WEB_TRANSPORT_WEB_TRANSPORT_OWT_SERVER_IMPL_H_
 
+#include <memory>
 #include <string>
 #include <vector>
+#include "base/callback.h"
 #include "base/memory/scoped_refptr.h"
 #include "base/task/single_thread_task_runner.h"
+#include "base/threading/thread.h"
 #include "net/base/io_buffer.h"
 #include "net/base/ip_endpoint.h"
-#include "net/quic/platform/impl/quic_chromium_clock.h"
-#include "net/socket/udp_server_socket.h"
 #include "net/third_party/quiche/src/quic/core/crypto/quic_crypto_server_config.h"
 #include "net/third_party/quiche/src/quic/core/quic_config.h"
 #include "net/third_party/quiche/src/quic/core/quic_version_manager.h"
-#include "net/third_party/quiche/src/quic/tools/quic_transport_simple_server_dispatcher.h"
 #include "owt/quic/web_transport_server_interface.h"
-#include "owt/web_transport/sdk/impl/web_transport_owt_server_dispatcher.h"
-#include "owt/web_transport/sdk/impl/web_transport_server_backend.h"
+#include "owt/web_transport/sdk/impl/address_token_crypter.h"
+#include "owt/web_transport/sdk/impl/certificate_compression.h"
+#include "owt/web_transport/sdk/impl/event_thread_pool.h"
+#include "owt/web_transport/sdk/impl/issued_connection_id_table.h"
+#include "owt/web_transport/sdk/impl/placed_memory.h"
+#include "owt/web_transport/sdk/impl/proof_source_owt.h"
+#include "owt/web_transport/sdk/impl/qlog_writer.h"
+#include "owt/web_transport/sdk/impl/routable_connection_id_generator.h"
+#include "owt/web_transport/sdk/impl/session_ticket_crypter.h"
+#include "owt/web_transport/sdk/impl/thread_scheduling.h"
+#include "owt/web_transport/sdk/impl/web_transport_owt_server_worker.h"
+#include "third_party/abseil-cpp/absl/types/optional.h"
 #include "url/origin.h"
 
 namespace owt {
 namespace quic {
 // An HTTP/3 server accepts WebTransport connections. HTTP/2 fallback is not
-// supported.
-class WebTransportOwtServerImpl
-    : public WebTransportServerInterface,
-      public WebTransportOwtServerDispatcher::Visitor {
+// supported. Connections are processed by one or more workers, each of them
+// runs on its own IO thread.
+class WebTransportOwtServerImpl : public WebTransportServerInterface {
  public:
   WebTransportOwtServerImpl() = delete;
+  // Threads started by the server are scheduled by `thread_scheduling`. The
+  // factory's threads are not affected.
   explicit WebTransportOwtServerImpl(
       int port,
       std::vector<url::Origin> accepted_origins,
       std::unique_ptr<::quic::ProofSource> proof_source,
+      ProofSourceOwt* pkcs12_proof_source,
+      SessionTicketCrypter* ticket_crypter,
+      const WebTransportServerInterface::Options& options,
+      const ThreadScheduling& thread_scheduling,
       base::Thread* io_thread,
-      base::Thread* event_thread);
+      scoped_refptr<base::SingleThreadTaskRunner> event_runner);
   ~WebTransportOwtServerImpl() override;
   WebTransportOwtServerImpl& operator=(WebTransportOwtServerImpl&) = delete;
   int Start() override;
   void Stop() override;
+  void Drain(uint32_t timeout_ms) override;
   void SetVisitor(WebTransportServerInterface::Visitor* visitor) override;
-
- protected:
-  // Implements WebTransportOwtServerDispatcher::Visitor.
-  void OnSession(WebTransportSessionInterface* session) override;
+  void SetIoThreadCount(size_t count) override;
+  bool SetConnectionIdRouting(const ConnectionIdRoutingConfig& config) override;
+  bool EnableQlog(const QlogOptions& options) override;
+  size_t GetListeningSockets(int* fds, size_t max_count) override;
+  bool SetListeningSockets(const int* fds,
+                           size_t count,
+                           uint32_t grace_period_ms) override;
+  void SetSendBufferBudget(uint64_t server_budget,
+                           uint64_t session_budget) override;
+  bool SetSessionTicketKeys(const uint8_t* keys, size_t key_count) override;
+  bool SetAddressTokenKeys(const uint8_t* keys, size_t key_count) override;
+  bool ReloadCertificate(const char* pfx_path, const char* password) override;
+  ServerStats GetServerStats() override;
+  size_t GetIoThreadStats(ServerStats* stats, size_t max_count) override;
+  MemoryUsage GetMemoryUsage() override;
+  size_t GetTopSessionsByCpu(SessionCpuUsage* sessions,
+                             size_t max_count) override;
+  void Broadcast(const BroadcastTarget* targets,
+                 size_t count,
+                 const uint8_t* data,
+                 size_t length) override;
+  void Broadcast(const BroadcastTarget* targets,
+                 size_t count,
+                 uint8_t* data,
+                 size_t length,
+                 BufferReleaseCallback release,
+                 void* release_context) override;
 
  private:
-  // Schedules a ReadPackets() call on the next iteration of the event loop.
-  void ScheduleReadPackets();
-  // Reads a fixed number of packets and then reschedules itself.
-  void ReadPackets();
-  // Called when an asynchronous read from the socket is complete.
-  void OnReadComplete(int result);
-  // Passes the most recently read packet into the dispatcher.
-  void ProcessReadPacket(int result);
-
-  void StartOnCurrentThread(base::WaitableEvent* done);
+  // Applies QUIC related `options_` to `config_`.
+  void InitializeConfig();
+  // Runs `task` on `runner` and waits for its completion.
+  static void RunAndWait(base::SingleThreadTaskRunner* runner,
+                         base::OnceClosure task);
+  // Creates workers and IO threads for them.
+  void CreateWorkers();
+  // Placement of buffers of the `index`th IO thread.
+  MemoryPlacement GetBufferPlacement(size_t index) const;
+  // Stops workers and destroys them on their IO threads.
+  void DestroyWorkers();
+  // Returns a closure calling the visitor's OnEnded on the event thread.
+  base::OnceClosure CreateEndedCallback() const;
+  void SetSendBufferBudgetForWorker(WebTransportOwtServerWorker* worker);
+  void Broadcast(const BroadcastTarget* targets,
+                 size_t count,
+                 scoped_refptr<net::IOBuffer> payload,
+                 size_t length);
 
- private:
   const uint16_t port_;
+  const WebTransportServerInterface::Options options_;
+  // Copied from `options_`, whose pointer is only valid during construction.
+  const absl::optional<NetworkEmulationOptions> network_emulation_;
+  // Must be initialized before `crypto_config_`, whose proof source may start
+  // signing threads.
+  const ThreadScheduling thread_scheduling_;
   ::quic::QuicVersionManager version_manager_;
-  ::quic::QuicChromiumClock* clock_;  // Not owned.
   ::quic::QuicConfig config_;
+  // Must outlive `crypto_config_`, which owns the SSL_CTX using it.
+  CompressedCertificateCache compressed_certificate_cache_;
   ::quic::QuicCryptoServerConfig crypto_config_;
-
-  std::unique_ptr<WebTransportOwtServerDispatcher> dispatcher_;
-  std::unique_ptr<net::UDPServerSocket> socket_;
-  net::IPEndPoint server_address_;
-  std::unique_ptr<WebTransportServerBackend> backend_;
+  // Owned by the proof source of `crypto_config_`. It's nullptr if session
+  // resumption is disabled.
+  SessionTicketCrypter* ticket_crypter_;
+  // Shared by all workers.
+  AddressTokenCrypter address_token_crypter_;
+  // `proof_source` or the one wrapped by it, if the server is created with a
+  // PKCS12 file. Otherwise, it's nullptr.
+  ProofSourceOwt* pkcs12_proof_source_;
+  std::vector<url::Origin> accepted_origins_;
   scoped_refptr<base::SingleThreadTaskRunner> task_runner_;
-  scoped_refptr<base::SingleThreadTaskRunner> event_runner_;
-
-  // Results of the potentially asynchronous read operation.
-  scoped_refptr<net::IOBufferWithSize> read_buffer_;
-  net::IPEndPoint client_address_;
+  // Shared by all workers. Its first thread is the factory's event thread.
+  std::unique_ptr<EventThreadPool> event_threads_;
+  size_t io_thread_count_;
+  // Shared by all workers. When it's not set and there are multiple workers, a
+  // generator with default config is created.
+  std::unique_ptr<RoutableConnectionIdGenerator> connection_id_generator_;
+  // Shared by all workers when there are multiple workers.
+  std::unique_ptr<IssuedConnectionIdTable> issued_connection_ids_;
+  // Shared by all workers. It's nullptr if qlog is not enabled.
+  std::unique_ptr<QlogWriter> qlog_writer_;
+  // IO threads created by this server. The first worker runs on the factory's
+  // IO thread, so it's not in this list.
+  std::vector<std::unique_ptr<base::Thread>> io_threads_;
+  // Created by Start(). Immutable after that.
+  std::vector<std::unique_ptr<WebTransportOwtServerWorker>> workers_;
+  net::IPEndPoint server_address_;
+  // Sockets taken over by workers created by Start(), one for each of them.
+  std::vector<int> listening_sockets_;
+  uint32_t takeover_grace_period_ms_;
 
-  base::WeakPtrFactory<WebTransportOwtServerImpl> weak_factory_{this};
+  // Settings applied to workers created by Start().
+  WebTransportServerInterface::Visitor* visitor_;
+  uint64_t server_send_buffer_budget_;
+  uint64_t session_send_buffer_budget_;
 };
 }  // namespace quic
 }  // namespace owt
 
-#endif
\ No newline at end of file
+#endif
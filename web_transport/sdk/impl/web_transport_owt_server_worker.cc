@@ -0,0 +1,522 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+// Copyright 2018 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Most classes in this file and its implementations are borrowed from
+// Chromium/net/tools/quic/quic_transport_simple_server.cc
+// with modifications.
+
+#include "impl/web_transport_owt_server_worker.h"
+#include <algorithm>
+#include <cinttypes>
+#include <utility>
+#include "base/bind.h"
+#include "base/logging.h"
+#include "base/strings/stringprintf.h"
+#include "base/trace_event/memory_allocator_dump.h"
+#include "base/trace_event/memory_dump_manager.h"
+#include "base/trace_event/process_memory_dump.h"
+#include "impl/metrics.h"
+#include "impl/network_emulator.h"
+#include "impl/utilities.h"
+#include "net/quic/quic_chromium_alarm_factory.h"
+#include "net/quic/quic_chromium_connection_helper.h"
+#include "net/third_party/quiche/src/quic/core/quic_crypto_server_stream_base.h"
+#include "net/third_party/quiche/src/quic/core/quic_types.h"
+
+namespace owt {
+namespace quic {
+
+namespace {
+// Interval of updating rates and sampled values of server stats.
+constexpr int64_t kStatsIntervalMs = 1000;
+// Interval of probing queue delays of IO and event threads for load shedding.
+constexpr int64_t kLoadProbeIntervalMs = 100;
+// Interval of checking whether all connections are closed when draining.
+constexpr int64_t kDrainCheckIntervalMs = 100;
+// Offset of destination connection ID in a long header packet. It's after the
+// first byte, 4 bytes version and 1 byte connection ID length.
+constexpr size_t kLongHeaderConnectionIdOffset = 6;
+
+class WebTransportOwtServerImplSessionHelper
+    : public ::quic::QuicCryptoServerStreamBase::Helper {
+ public:
+  bool CanAcceptClientHello(const ::quic::CryptoHandshakeMessage& /*message*/,
+                            const ::quic::QuicSocketAddress& /*client_address*/,
+                            const ::quic::QuicSocketAddress& /*peer_address*/,
+                            const ::quic::QuicSocketAddress& /*self_address*/,
+                            std::string* /*error_details*/) const override {
+    return true;
+  }
+};
+}  // namespace
+
+WebTransportOwtServerWorker::WebTransportOwtServerWorker(
+    uint8_t index,
+    size_t worker_count,
+    const ::quic::QuicConfig* config,
+    const ::quic::QuicCryptoServerConfig* crypto_config,
+    ::quic::QuicVersionManager* version_manager,
+    std::vector<url::Origin> accepted_origins,
+    const RoutableConnectionIdGenerator* connection_id_generator,
+    IssuedConnectionIdTable* issued_connection_ids,
+    QlogWriter* qlog_writer,
+    const WebTransportServerInterface::Options& options,
+    const MemoryPlacement& buffer_placement,
+    base::SingleThreadTaskRunner* io_runner,
+    const EventThreadPool* event_threads)
+    : index_(index),
+      worker_count_(worker_count),
+      config_(config),
+      crypto_config_(crypto_config),
+      version_manager_(version_manager),
+      clock_(::quic::QuicChromiumClock::GetInstance()),
+      accepted_origins_(std::move(accepted_origins)),
+      connection_id_generator_(connection_id_generator),
+      issued_connection_ids_(issued_connection_ids),
+      qlog_writer_(qlog_writer),
+      congestion_control_(options.congestion_control),
+      mtu_discovery_enabled_(options.enable_mtu_discovery),
+      ack_eliciting_threshold_(options.ack_eliciting_threshold),
+      max_ack_delay_ms_(options.max_ack_delay_ms),
+      qpack_settings_(
+          Utilities::GetQpackSettings(options.disable_qpack_dynamic_table,
+                                      options.qpack_dynamic_table_capacity,
+                                      options.qpack_blocked_streams)),
+      overload_queue_delay_ms_(options.overload_queue_delay_ms),
+      top_sessions_by_cpu_(options.top_sessions_by_cpu),
+      keepalive_interval_ms_(options.keepalive_interval_ms),
+      retry_chlo_rate_threshold_(static_cast<uint32_t>(
+          (uint64_t{options.retry_chlo_rate_threshold} + worker_count - 1) /
+          worker_count)),
+      address_token_crypter_(nullptr),
+      io_runner_(io_runner),
+      event_threads_(event_threads),
+      send_buffer_pool_(options.pooled_send_buffers
+                            ? std::make_unique<PooledBufferAllocator>(
+                                  io_runner,
+                                  buffer_placement)
+                            : nullptr),
+      backend_(std::make_unique<WebTransportServerBackend>(
+          io_runner,
+          event_threads,
+          options.inline_event_dispatch,
+          send_buffer_pool_.get())) {
+  CHECK_LT(index_, worker_count_);
+  CHECK(config_);
+  CHECK(crypto_config_);
+  CHECK(version_manager_);
+  CHECK(worker_count_ == 1 ||
+        (connection_id_generator_ && issued_connection_ids_));
+  CHECK(io_runner_);
+  CHECK(event_threads_);
+  UdpPacketIoEngine::Options engine_options;
+  engine_options.socket_receive_buffer_size =
+      options.socket_receive_buffer_size;
+  engine_options.socket_send_buffer_size = options.socket_send_buffer_size;
+  engine_options.max_packets_per_read = options.max_packets_per_read;
+  engine_options.max_new_connections_per_read =
+      options.max_new_connections_per_read;
+  engine_options.reuse_port = worker_count_ > 1;
+  engine_options.buffer_placement = buffer_placement;
+  engine_ =
+      std::make_unique<UdpPacketIoEngine>(engine_options, io_runner_, clock_);
+}
+
+WebTransportOwtServerWorker::~WebTransportOwtServerWorker() {
+  StopOnCurrentThread();
+}
+
+void WebTransportOwtServerWorker::SetWorkers(
+    std::vector<WebTransportOwtServerWorker*> workers) {
+  DCHECK_EQ(workers.size(), worker_count_);
+  workers_ = std::move(workers);
+}
+
+void WebTransportOwtServerWorker::SetSocketToAdopt(
+    int fd,
+    base::TimeDelta grace_period) {
+  DCHECK(!dispatcher_);
+  engine_->SetSocketToAdopt(fd);
+  takeover_grace_period_ = grace_period;
+}
+
+void WebTransportOwtServerWorker::SetNetworkEmulation(
+    const NetworkEmulationOptions& options) {
+  DCHECK(!dispatcher_);
+  network_emulation_ = options;
+}
+
+void WebTransportOwtServerWorker::SetAddressTokenCrypter(
+    AddressTokenCrypter* crypter) {
+  DCHECK(!dispatcher_);
+  address_token_crypter_ = crypter;
+}
+
+bool WebTransportOwtServerWorker::StartOnCurrentThread(uint16_t port) {
+  DCHECK(io_runner_->BelongsToCurrentThread());
+  DCHECK(!dispatcher_);
+  if (!engine_->Bind(port)) {
+    return false;
+  }
+  std::unique_ptr<::quic::QuicConnectionHelperInterface> helper;
+  if (send_buffer_pool_) {
+    helper = std::make_unique<PooledBufferConnectionHelper>(
+        clock_, ::quic::QuicRandom::GetInstance(), send_buffer_pool_.get());
+  } else {
+    helper = std::make_unique<net::QuicChromiumConnectionHelper>(
+        clock_, ::quic::QuicRandom::GetInstance());
+  }
+  dispatcher_ = std::make_unique<WebTransportOwtServerDispatcher>(
+      config_, crypto_config_, version_manager_, std::move(helper),
+      std::make_unique<WebTransportOwtServerImplSessionHelper>(),
+      std::make_unique<net::QuicChromiumAlarmFactory>(io_runner_, clock_),
+      connection_id_generator_
+          ? connection_id_generator_->connection_id_length()
+          : ::quic::kQuicDefaultConnectionIdLength,
+      accepted_origins_, backend_.get(), io_runner_,
+      event_threads_->default_runner());
+  dispatcher_->SetVisitor(this);
+  dispatcher_->SetConnectionIdGenerator(connection_id_generator_,
+                                        issued_connection_ids_, index_);
+  dispatcher_->SetQlogWriter(qlog_writer_);
+  dispatcher_->SetStatsCounters(&stats_counters_);
+  dispatcher_->SetCongestionControl(
+      Utilities::ConvertCongestionControlType(congestion_control_));
+  dispatcher_->SetMtuDiscoveryEnabled(mtu_discovery_enabled_);
+  dispatcher_->SetAckFrequency(
+      ack_eliciting_threshold_,
+      ::quic::QuicTime::Delta::FromMilliseconds(max_ack_delay_ms_));
+  dispatcher_->SetQpackSettings(qpack_settings_);
+  dispatcher_->SetCpuAccountingEnabled(top_sessions_by_cpu_ > 0);
+  dispatcher_->SetKeepAliveInterval(base::Milliseconds(keepalive_interval_ms_));
+  dispatcher_->SetRetryPolicy(
+      address_token_crypter_,
+      address_token_crypter_ ? retry_chlo_rate_threshold_ : 0);
+  ::quic::QuicPacketWriter* writer =
+      engine_->CreateWriter(dispatcher_.get()).release();
+  if (network_emulation_) {
+    writer = new NetworkEmulatingPacketWriter(writer, *network_emulation_);
+  }
+  dispatcher_->InitializeWithWriter(
+      new StatsRecordingPacketWriter(writer, &stats_counters_));
+  if (takeover_grace_period_.is_positive()) {
+    dispatcher_->SuppressStatelessResets(
+        ::quic::QuicTime::Delta::FromMicroseconds(
+            takeover_grace_period_.InMicroseconds()));
+  }
+  engine_->StartReading(this);
+  StartStatsTimer();
+  if (overload_queue_delay_ms_ > 0) {
+    std::vector<base::SingleThreadTaskRunner*> runners = {io_runner_};
+    for (size_t i = 0; i < event_threads_->size(); i++) {
+      runners.push_back(event_threads_->runner(i));
+    }
+    load_monitor_ = std::make_unique<LoadMonitor>(
+        std::move(runners), base::Milliseconds(overload_queue_delay_ms_),
+        base::Milliseconds(kLoadProbeIntervalMs), io_runner_, this);
+    load_monitor_->Start();
+  }
+  base::trace_event::MemoryDumpManager::GetInstance()->RegisterDumpProvider(
+      this, "OwtWebTransportServerWorker", io_runner_);
+  memory_dump_provider_registered_ = true;
+  return true;
+}
+
+void WebTransportOwtServerWorker::StopOnCurrentThread() {
+  DCHECK(io_runner_->BelongsToCurrentThread());
+  stats_timer_.Stop();
+  drain_timer_.Stop();
+  load_monitor_.reset();
+  if (memory_dump_provider_registered_) {
+    base::trace_event::MemoryDumpManager::GetInstance()
+        ->UnregisterDumpProvider(this);
+    memory_dump_provider_registered_ = false;
+  }
+  PublishMemoryUsage(MemoryUsage());
+  // Stop() ends a pending drain, and reports it itself.
+  drain_done_.Reset();
+  drain_deadline_ = base::TimeTicks();
+  if (dispatcher_) {
+    // Sends CONNECTION_CLOSE to clients. Sessions held by `backend_` are
+    // closed, and detached when the dispatcher destroys native sessions.
+    dispatcher_->Shutdown();
+  }
+  // Writers of the dispatcher send packets to the engine's socket.
+  dispatcher_.reset();
+  engine_->Stop();
+}
+
+void WebTransportOwtServerWorker::DrainOnCurrentThread(
+    base::TimeDelta timeout,
+    base::OnceClosure done) {
+  DCHECK(io_runner_->BelongsToCurrentThread());
+  DCHECK(!drain_done_);
+  drain_done_ = std::move(done);
+  if (!dispatcher_) {
+    CheckDrained();
+    return;
+  }
+  LOG(INFO) << "Draining " << dispatcher_->NumSessions()
+            << " connection(s) of IO thread " << static_cast<int>(index_)
+            << ".";
+  dispatcher_->StartDraining();
+  drain_deadline_ = base::TimeTicks::Now() + timeout;
+  // The timer is stopped before the worker is destroyed.
+  drain_timer_.Start(
+      FROM_HERE, base::Milliseconds(kDrainCheckIntervalMs),
+      base::BindRepeating(&WebTransportOwtServerWorker::CheckDrained,
+                          base::Unretained(this)));
+}
+
+void WebTransportOwtServerWorker::CheckDrained() {
+  if (dispatcher_ && dispatcher_->NumSessions() > 0 &&
+      base::TimeTicks::Now() < drain_deadline_) {
+    return;
+  }
+  if (dispatcher_ && dispatcher_->NumSessions() > 0) {
+    LOG(WARNING) << "Closing " << dispatcher_->NumSessions()
+                 << " connection(s) not drained in time.";
+  }
+  // StopOnCurrentThread() resets drain states, so the worker could be drained
+  // again after it's restarted.
+  base::OnceClosure done = std::move(drain_done_);
+  StopOnCurrentThread();
+  std::move(done).Run();
+}
+
+int WebTransportOwtServerWorker::DuplicateSocketOnCurrentThread() const {
+  DCHECK(io_runner_->BelongsToCurrentThread());
+  return engine_->DuplicateSocket();
+}
+
+void WebTransportOwtServerWorker::ProcessForwardedPacket(
+    const ::quic::QuicSocketAddress& self_address,
+    const ::quic::QuicSocketAddress& peer_address,
+    std::unique_ptr<::quic::QuicReceivedPacket> packet) {
+  DCHECK(io_runner_->BelongsToCurrentThread());
+  // The worker may be stopped after the packet is forwarded.
+  if (!dispatcher_) {
+    return;
+  }
+  dispatcher_->ProcessPacket(self_address, peer_address, *packet);
+}
+
+void WebTransportOwtServerWorker::ProcessPacket(
+    const ::quic::QuicSocketAddress& self_address,
+    const ::quic::QuicSocketAddress& peer_address,
+    const ::quic::QuicReceivedPacket& packet) {
+  stats_counters_.OnPacketReceived(packet.length());
+  const size_t owner = GetOwnerIndex(packet);
+  if (owner == index_) {
+    dispatcher_->ProcessPacket(self_address, peer_address, packet);
+    return;
+  }
+  // The owner gets the packet without copying, its receive buffer is reused
+  // after the owner processed it.
+  WebTransportOwtServerWorker* worker = workers_[owner];
+  worker->io_runner()->PostTask(
+      FROM_HERE,
+      base::BindOnce(&WebTransportOwtServerWorker::ProcessForwardedPacket,
+                     base::Unretained(worker), self_address, peer_address,
+                     engine_->RetainPacket(packet)));
+}
+
+void WebTransportOwtServerWorker::OnSession(
+    WebTransportSessionInterface* session) {
+  LOG(INFO) << "On HTTP session, connection ID: " << session->ConnectionId();
+}
+
+size_t WebTransportOwtServerWorker::GetOwnerIndex(
+    const ::quic::QuicReceivedPacket& packet) const {
+  if (worker_count_ <= 1 || packet.length() == 0) {
+    return index_;
+  }
+  const uint8_t* data = reinterpret_cast<const uint8_t*>(packet.data());
+  const size_t connection_id_length =
+      connection_id_generator_->connection_id_length();
+  size_t offset;
+  if (data[0] & ::quic::FLAGS_LONG_HEADER) {
+    // Connection IDs chosen by clients are handled by the worker receiving
+    // them, so only IDs with the length of server connection IDs are checked.
+    if (packet.length() <= kLongHeaderConnectionIdOffset ||
+        data[kLongHeaderConnectionIdOffset - 1] != connection_id_length) {
+      return index_;
+    }
+    offset = kLongHeaderConnectionIdOffset;
+  } else {
+    offset = 1;
+  }
+  if (packet.length() < offset + connection_id_length) {
+    return index_;
+  }
+  // IDs issued after the handshake are looked up first, since they could
+  // happen to look like generated ones.
+  absl::optional<uint8_t> owner = issued_connection_ids_->GetWorkerIndex(
+      packet.data() + offset, connection_id_length);
+  if (!owner) {
+    owner = connection_id_generator_->GetWorkerIndex(packet.data() + offset,
+                                                     connection_id_length);
+  }
+  return (owner && *owner < worker_count_) ? *owner : index_;
+}
+
+void WebTransportOwtServerWorker::OnReadPassStarted(size_t connection_budget) {
+  dispatcher_->ProcessBufferedChlos(connection_budget);
+}
+
+uint64_t WebTransportOwtServerWorker::NumConnectionsCreated() const {
+  return dispatcher_->num_sessions_created();
+}
+
+bool WebTransportOwtServerWorker::HasChlosBuffered() const {
+  return dispatcher_->HasChlosBuffered();
+}
+
+bool WebTransportOwtServerWorker::HasPendingWrites() const {
+  return dispatcher_->HasPendingWrites();
+}
+
+void WebTransportOwtServerWorker::OnCanWrite() {
+  dispatcher_->writer()->SetWritable();
+  dispatcher_->OnCanWrite();
+}
+
+void WebTransportOwtServerWorker::OnOverloadChanged(bool overloaded) {
+  LOG(WARNING) << "IO thread " << static_cast<int>(index_)
+               << (overloaded ? " is overloaded, max queue delay: "
+                              : " recovered from overload, max queue delay: ")
+               << load_monitor_->max_queue_delay().InMilliseconds() << " ms.";
+  if (overloaded) {
+    stats_counters_.OnOverload();
+  }
+  dispatcher_->SetRejectNewConnections(overloaded);
+  backend_->SetOverloaded(overloaded);
+}
+
+void WebTransportOwtServerWorker::OnReadError(int result) {
+  dispatcher_->Shutdown();
+}
+
+const ReadBudgetScheduler::Stats& WebTransportOwtServerWorker::read_stats()
+    const {
+  return engine_->read_stats();
+}
+
+void WebTransportOwtServerWorker::StartStatsTimer() {
+  stats_interval_start_ = clock_->Now();
+  busy_time_before_interval_ = engine_->busy_time();
+  sessions_created_before_interval_ = dispatcher_->num_sessions_created();
+  // The timer is stopped before the worker is destroyed.
+  stats_timer_.Start(
+      FROM_HERE, base::Milliseconds(kStatsIntervalMs),
+      base::BindRepeating(&WebTransportOwtServerWorker::UpdateStats,
+                          base::Unretained(this)));
+}
+
+void WebTransportOwtServerWorker::UpdateStats() {
+  const ::quic::QuicTime now = clock_->Now();
+  const int64_t elapsed_us = (now - stats_interval_start_).ToMicroseconds();
+  if (elapsed_us <= 0) {
+    return;
+  }
+  const uint64_t sessions_created = dispatcher_->num_sessions_created();
+  const uint64_t handshakes_per_second =
+      (sessions_created - sessions_created_before_interval_) * 1000000 /
+      elapsed_us;
+  const ::quic::QuicTime::Delta busy_time = engine_->busy_time();
+  const uint64_t loop_utilization_percent = std::min<uint64_t>(
+      100, (busy_time - busy_time_before_interval_).ToMicroseconds() * 100 /
+               elapsed_us);
+  stats_counters_.SetSessions(dispatcher_->NumSessions(), sessions_created);
+  stats_counters_.SetChloBacklogPasses(read_stats().chlo_backlog_passes);
+  stats_counters_.SetRates(handshakes_per_second, loop_utilization_percent);
+  stats_counters_.SetEcnCounts(engine_->ect_packets(), engine_->ce_packets());
+  if (load_monitor_) {
+    stats_counters_.SetMaxQueueDelay(
+        load_monitor_->max_queue_delay().InMilliseconds());
+  }
+  if (engine_->dropped_packets() > kernel_dropped_packets_) {
+    stats_counters_.OnPacketsDropped(engine_->dropped_packets() -
+                                     kernel_dropped_packets_);
+    kernel_dropped_packets_ = engine_->dropped_packets();
+  }
+  PublishMemoryUsage(backend_->GetMemoryUsage());
+  if (top_sessions_by_cpu_ > 0) {
+    std::vector<SessionCpuUsage> top_sessions;
+    backend_->CollectCpuUsage(index_, top_sessions_by_cpu_, &top_sessions);
+    base::AutoLock lock(top_sessions_lock_);
+    top_sessions_.swap(top_sessions);
+  }
+  stats_interval_start_ = now;
+  busy_time_before_interval_ = busy_time;
+  sessions_created_before_interval_ = sessions_created;
+}
+
+void WebTransportOwtServerWorker::AppendTopSessionsByCpu(
+    std::vector<SessionCpuUsage>* sessions) const {
+  base::AutoLock lock(top_sessions_lock_);
+  sessions->insert(sessions->end(), top_sessions_.begin(), top_sessions_.end());
+}
+
+void WebTransportOwtServerWorker::PublishMemoryUsage(const MemoryUsage& usage) {
+  stats_counters_.SetMemoryUsage(usage);
+  const MemoryUsage& last = published_memory_usage_;
+  // Unsigned differences wrap around to negative deltas.
+  const std::pair<MetricGauge, uint64_t> deltas[] = {
+      {MetricGauge::kServerMemoryBytes, usage.total_bytes - last.total_bytes},
+      {MetricGauge::kServerStreamSendBufferBytes,
+       usage.stream_send_buffer_bytes - last.stream_send_buffer_bytes},
+      {MetricGauge::kServerStreamReceiveBufferBytes,
+       usage.stream_receive_buffer_bytes - last.stream_receive_buffer_bytes},
+      {MetricGauge::kServerDatagramBufferBytes,
+       usage.datagram_buffer_bytes - last.datagram_buffer_bytes}};
+  for (const auto& delta : deltas) {
+    if (delta.second != 0) {
+      MetricsRegistry::AddToGauge(delta.first,
+                                  static_cast<int64_t>(delta.second));
+    }
+  }
+  published_memory_usage_ = usage;
+}
+
+bool WebTransportOwtServerWorker::OnMemoryDump(
+    const base::trace_event::MemoryDumpArgs& args,
+    base::trace_event::ProcessMemoryDump* pmd) {
+  DCHECK(io_runner_->BelongsToCurrentThread());
+  using base::trace_event::MemoryAllocatorDump;
+  const MemoryUsage usage = backend_->GetMemoryUsage();
+  MemoryAllocatorDump* dump = pmd->CreateAllocatorDump(base::StringPrintf(
+      "owt_quic/web_transport_server/worker_%u_0x%" PRIXPTR, index_,
+      reinterpret_cast<uintptr_t>(this)));
+  dump->AddScalar(MemoryAllocatorDump::kNameSize,
+                  MemoryAllocatorDump::kUnitsBytes, usage.total_bytes);
+  dump->AddScalar(MemoryAllocatorDump::kNameObjectCount,
+                  MemoryAllocatorDump::kUnitsObjects, usage.sessions);
+  dump->AddScalar("streams", MemoryAllocatorDump::kUnitsObjects,
+                  usage.streams);
+  dump->AddScalar("stream_send_buffers", MemoryAllocatorDump::kUnitsBytes,
+                  usage.stream_send_buffer_bytes);
+  dump->AddScalar("stream_receive_buffers", MemoryAllocatorDump::kUnitsBytes,
+                  usage.stream_receive_buffer_bytes);
+  dump->AddScalar("datagram_buffers", MemoryAllocatorDump::kUnitsBytes,
+                  usage.datagram_buffer_bytes);
+  dump->AddScalar("queued_datagrams", MemoryAllocatorDump::kUnitsObjects,
+                  usage.queued_datagrams);
+  if (send_buffer_pool_) {
+    dump->AddScalar("send_buffer_pool", MemoryAllocatorDump::kUnitsBytes,
+                    send_buffer_pool_->cached_bytes());
+    dump->AddScalar("send_buffer_slabs", MemoryAllocatorDump::kUnitsBytes,
+                    send_buffer_pool_->slab_bytes());
+  }
+  return true;
+}
+
+}  // namespace quic
+}  // namespace owt
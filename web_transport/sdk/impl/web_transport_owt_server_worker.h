@@ -0,0 +1,234 @@
+/*
+ * Copyright (C) 2021 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef OWT_WEB_TRANSPORT_WEB_TRANSPORT_OWT_SERVER_WORKER_H_
+#define OWT_WEB_TRANSPORT_WEB_TRANSPORT_OWT_SERVER_WORKER_H_
+
+#include <memory>
+#include <vector>
+#include "base/callback.h"
+#include "base/memory/scoped_refptr.h"
+#include "base/synchronization/lock.h"
+#include "base/thread_annotations.h"
+#include "base/task/single_thread_task_runner.h"
+#include "base/time/time.h"
+#include "base/timer/timer.h"
+#include "base/trace_event/memory_dump_provider.h"
+#include "net/base/ip_endpoint.h"
+#include "net/quic/platform/impl/quic_chromium_clock.h"
+#include "net/third_party/quiche/src/quic/core/crypto/quic_crypto_server_config.h"
+#include "net/third_party/quiche/src/quic/core/quic_config.h"
+#include "net/third_party/quiche/src/quic/core/quic_process_packet_interface.h"
+#include "net/third_party/quiche/src/quic/core/quic_version_manager.h"
+#include "owt/quic/web_transport_definitions.h"
+#include "owt/quic/web_transport_server_interface.h"
+#include "owt/web_transport/sdk/impl/address_token_crypter.h"
+#include "owt/web_transport/sdk/impl/event_thread_pool.h"
+#include "owt/web_transport/sdk/impl/issued_connection_id_table.h"
+#include "owt/web_transport/sdk/impl/load_monitor.h"
+#include "owt/web_transport/sdk/impl/placed_memory.h"
+#include "owt/web_transport/sdk/impl/pooled_buffer_allocator.h"
+#include "owt/web_transport/sdk/impl/qlog_writer.h"
+#include "owt/web_transport/sdk/impl/read_budget_scheduler.h"
+#include "owt/web_transport/sdk/impl/routable_connection_id_generator.h"
+#include "owt/web_transport/sdk/impl/server_stats_counters.h"
+#include "owt/web_transport/sdk/impl/udp_packet_io_engine.h"
+#include "owt/web_transport/sdk/impl/web_transport_owt_server_dispatcher.h"
+#include "owt/web_transport/sdk/impl/web_transport_server_backend.h"
+#include "third_party/abseil-cpp/absl/types/optional.h"
+#include "url/origin.h"
+
+namespace owt {
+namespace quic {
+
+// A worker owns a packet I/O engine, a dispatcher and a backend, and processes
+// all connections it accepts on its IO thread. When a server has multiple workers,
+// each of them binds a socket to the same port with SO_REUSEPORT, and server
+// connection IDs carry the index of worker which owns the connection. Packets
+// received by a worker but belonging to another one are forwarded to the
+// owner, so migrated connections stay on the same thread. Except the
+// constructor, all methods must be called on `io_runner`.
+class WebTransportOwtServerWorker
+    : public UdpPacketIoEngine::Delegate,
+      public WebTransportOwtServerDispatcher::Visitor,
+      public LoadMonitor::Delegate,
+      public base::trace_event::MemoryDumpProvider {
+ public:
+  WebTransportOwtServerWorker(
+      uint8_t index,
+      size_t worker_count,
+      const ::quic::QuicConfig* config,
+      const ::quic::QuicCryptoServerConfig* crypto_config,
+      ::quic::QuicVersionManager* version_manager,
+      std::vector<url::Origin> accepted_origins,
+      const RoutableConnectionIdGenerator* connection_id_generator,
+      IssuedConnectionIdTable* issued_connection_ids,
+      QlogWriter* qlog_writer,
+      const WebTransportServerInterface::Options& options,
+      const MemoryPlacement& buffer_placement,
+      base::SingleThreadTaskRunner* io_runner,
+      const EventThreadPool* event_threads);
+  ~WebTransportOwtServerWorker() override;
+  WebTransportOwtServerWorker(const WebTransportOwtServerWorker&) = delete;
+  WebTransportOwtServerWorker& operator=(const WebTransportOwtServerWorker&) =
+      delete;
+
+  // `workers` are all workers of the server, including this one, ordered by
+  // index. They must outlive this worker.
+  void SetWorkers(std::vector<WebTransportOwtServerWorker*> workers);
+  // Makes StartOnCurrentThread() take over `fd` instead of binding a new
+  // socket. For `grace_period` after the worker starts, packets of unknown
+  // connections are not answered with stateless resets, since they may belong
+  // to connections of the process `fd` is taken from. The worker owns `fd`.
+  // Like SetWorkers(), it's called before the worker starts.
+  void SetSocketToAdopt(int fd, base::TimeDelta grace_period);
+  // Emulates `options` on packets sent by this worker. Like SetWorkers(),
+  // it's called before the worker starts.
+  void SetNetworkEmulation(const NetworkEmulationOptions& options);
+  // Mints and validates tokens of RETRY packets, see Options::
+  // retry_chlo_rate_threshold. It must outlive this worker. Like SetWorkers(),
+  // it's called before the worker starts.
+  void SetAddressTokenCrypter(AddressTokenCrypter* crypter);
+  // Binds a UDP socket to `port` and starts reading packets. Returns false if
+  // the socket cannot be created.
+  bool StartOnCurrentThread(uint16_t port);
+  // Closes all connections and the socket. A pending drain is cancelled
+  // without calling its `done`.
+  void StopOnCurrentThread();
+  // Stops accepting new connections and asks clients to go away. Once all
+  // connections are closed, or after `timeout`, the worker is stopped and
+  // `done` is called.
+  void DrainOnCurrentThread(base::TimeDelta timeout, base::OnceClosure done);
+  // Returns a duplicate of the socket owned by the caller, or -1.
+  int DuplicateSocketOnCurrentThread() const;
+  // Processes a packet received by another worker.
+  void ProcessForwardedPacket(
+      const ::quic::QuicSocketAddress& self_address,
+      const ::quic::QuicSocketAddress& peer_address,
+      std::unique_ptr<::quic::QuicReceivedPacket> packet);
+
+  WebTransportServerBackend* backend() const { return backend_.get(); }
+  base::SingleThreadTaskRunner* io_runner() const { return io_runner_; }
+  const net::IPEndPoint& server_address() const {
+    return engine_->server_address();
+  }
+  // Statistics of the read loop, e.g.: CHLO backlog and time spent per pass.
+  const ReadBudgetScheduler::Stats& read_stats() const;
+  // Counters published by this worker. Unlike other methods, it could be
+  // called on any thread.
+  const ServerStatsCounters& stats_counters() const { return stats_counters_; }
+  // Appends sessions with the most CPU time published by the last stats
+  // update to `sessions`. It could be called on any thread.
+  void AppendTopSessionsByCpu(std::vector<SessionCpuUsage>* sessions) const;
+
+  // Overrides ::quic::ProcessPacketInterface. Packets are dispatched, or
+  // forwarded to the worker owning the connection.
+  void ProcessPacket(const ::quic::QuicSocketAddress& self_address,
+                     const ::quic::QuicSocketAddress& peer_address,
+                     const ::quic::QuicReceivedPacket& packet) override;
+
+  // Overrides UdpPacketIoEngine::Delegate.
+  void OnReadPassStarted(size_t connection_budget) override;
+  uint64_t NumConnectionsCreated() const override;
+  bool HasChlosBuffered() const override;
+  bool HasPendingWrites() const override;
+  void OnCanWrite() override;
+  // The dispatcher is shut down.
+  void OnReadError(int result) override;
+
+  // Overrides LoadMonitor::Delegate. New connections are rejected and
+  // sessions shed datagrams while the worker is overloaded.
+  void OnOverloadChanged(bool overloaded) override;
+
+  // Overrides base::trace_event::MemoryDumpProvider.
+  bool OnMemoryDump(const base::trace_event::MemoryDumpArgs& args,
+                    base::trace_event::ProcessMemoryDump* pmd) override;
+
+ protected:
+  // Overrides WebTransportOwtServerDispatcher::Visitor.
+  void OnSession(WebTransportSessionInterface* session) override;
+
+ private:
+  // Returns the index of worker owning the connection `packet` belongs to, or
+  // `index_` if it's unknown.
+  size_t GetOwnerIndex(const ::quic::QuicReceivedPacket& packet) const;
+  // Starts updating `stats_counters_` every second.
+  void StartStatsTimer();
+  // Publishes sampled values and rates of the last interval to
+  // `stats_counters_`.
+  void UpdateStats();
+  // Stops the worker if draining is complete or timed out.
+  void CheckDrained();
+  // Publishes `usage` to `stats_counters_` and metrics gauges.
+  void PublishMemoryUsage(const MemoryUsage& usage);
+
+  const uint8_t index_;
+  const size_t worker_count_;
+  const ::quic::QuicConfig* config_;                        // Not owned.
+  const ::quic::QuicCryptoServerConfig* crypto_config_;     // Not owned.
+  ::quic::QuicVersionManager* version_manager_;             // Not owned.
+  ::quic::QuicChromiumClock* clock_;                        // Not owned.
+  std::vector<url::Origin> accepted_origins_;
+  // Generates server connection IDs. Required when there are multiple
+  // workers, otherwise it could be nullptr. Not owned.
+  const RoutableConnectionIdGenerator* connection_id_generator_;
+  // Owners of connection IDs issued after the handshake. Required when there
+  // are multiple workers. Not owned.
+  IssuedConnectionIdTable* issued_connection_ids_;
+  // Writes qlog of sampled connections. It could be nullptr. Not owned.
+  QlogWriter* qlog_writer_;
+  std::vector<WebTransportOwtServerWorker*> workers_;
+  const CongestionControlType congestion_control_;
+  const bool mtu_discovery_enabled_;
+  const uint32_t ack_eliciting_threshold_;
+  const uint32_t max_ack_delay_ms_;
+  const Utilities::QpackSettings qpack_settings_;
+  const uint32_t overload_queue_delay_ms_;
+  const size_t top_sessions_by_cpu_;
+  const uint32_t keepalive_interval_ms_;
+  // This worker's share of Options::retry_chlo_rate_threshold.
+  const uint32_t retry_chlo_rate_threshold_;
+  AddressTokenCrypter* address_token_crypter_;  // Not owned.
+  base::SingleThreadTaskRunner* io_runner_;
+  const EventThreadPool* event_threads_;  // Not owned.
+  // Allocates send buffers of connections when pooled send buffers are
+  // enabled, otherwise it's nullptr. Buffers could be deleted when sessions
+  // held by `backend_` are destroyed, so it outlives `backend_`.
+  std::unique_ptr<PooledBufferAllocator> send_buffer_pool_;
+  // Must outlive `dispatcher_`, since sessions created by `dispatcher_` are
+  // held by `backend_`.
+  std::unique_ptr<WebTransportServerBackend> backend_;
+  std::unique_ptr<WebTransportOwtServerDispatcher> dispatcher_;
+  std::unique_ptr<UdpPacketIoEngine> engine_;
+  ServerStatsCounters stats_counters_;
+  // Probes `io_runner_` and event threads when load shedding is enabled,
+  // otherwise it's nullptr.
+  std::unique_ptr<LoadMonitor> load_monitor_;
+  base::RepeatingTimer stats_timer_;
+  absl::optional<NetworkEmulationOptions> network_emulation_;
+  // States of draining.
+  base::TimeDelta takeover_grace_period_;
+  base::RepeatingTimer drain_timer_;
+  base::TimeTicks drain_deadline_;
+  base::OnceClosure drain_done_;
+  // States of current stats interval.
+  ::quic::QuicTime stats_interval_start_ = ::quic::QuicTime::Zero();
+  ::quic::QuicTime::Delta busy_time_before_interval_ =
+      ::quic::QuicTime::Delta::Zero();
+  uint64_t sessions_created_before_interval_ = 0;
+  uint64_t kernel_dropped_packets_ = 0;
+  // Published by UpdateStats() when CPU accounting is enabled.
+  mutable base::Lock top_sessions_lock_;
+  std::vector<SessionCpuUsage> top_sessions_ GUARDED_BY(top_sessions_lock_);
+  // Last memory usage added to metrics gauges.
+  MemoryUsage published_memory_usage_ = {};
+  bool memory_dump_provider_registered_ = false;
+};
+
+}  // namespace quic
+}  // namespace owt
+
+#endif
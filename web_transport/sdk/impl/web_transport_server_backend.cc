@@ -5,6 +5,13 @@
  */
 
 #include "impl/web_transport_server_backend.h"
+#include "base/strings/string_util.h"
+#include "base/trace_event/trace_event.h"
+#include "impl/async_logger.h"
+#include "impl/http3_server_session.h"
+#include "impl/metrics.h"
+#include "impl/tracing.h"
+#include "impl/utilities.h"
 #include "impl/web_transport_server_session.h"
 
 namespace owt {
@@ -12,13 +19,22 @@ namespace quic {
 
 WebTransportServerBackend::WebTransportServerBackend(
     base::SingleThreadTaskRunner* io_runner,
-    base::SingleThreadTaskRunner* event_runner)
-    : visitor_(nullptr), io_runner_(io_runner), event_runner_(event_runner) {
+    const EventThreadPool* event_threads,
+    bool inline_event_dispatch,
+    ::quic::QuicBufferAllocator* send_buffer_allocator)
+    : visitor_(nullptr),
+      send_buffer_budget_(nullptr, this),
+      session_send_buffer_budget_(0),
+      overloaded_(false),
+      io_runner_(io_runner),
+      event_threads_(event_threads),
+      inline_event_dispatch_(inline_event_dispatch),
+      send_buffer_allocator_(send_buffer_allocator) {
   // Construction of WebTransportServerBackend is not required to be ran on IO
   // thread.
   io_thread_checker_.DetachFromThread();
   DCHECK(io_runner);
-  DCHECK(event_runner);
+  DCHECK(event_threads);
 }
 
 WebTransportServerBackend::~WebTransportServerBackend() {}
@@ -28,26 +44,157 @@ void WebTransportServerBackend::SetVisitor(
   visitor_ = visitor;
 }
 
+void WebTransportServerBackend::SetSendBufferBudget(uint64_t server_budget,
+                                                    uint64_t session_budget) {
+  DCHECK(io_thread_checker_.CalledOnValidThread());
+  session_send_buffer_budget_ = session_budget;
+  send_buffer_budget_.SetLimit(server_budget);
+}
+
+void WebTransportServerBackend::Broadcast(
+    const std::vector<BroadcastTarget>& targets,
+    scoped_refptr<net::IOBuffer> payload,
+    size_t length) {
+  DCHECK(io_thread_checker_.CalledOnValidThread());
+  for (const auto& target : targets) {
+    DCHECK(target.session);
+    // A server may have multiple backends, sessions owned by other backends
+    // are skipped. They belong to other IO threads, and may be destroyed, so
+    // `target.session` is only dereferenced after it's found here.
+    auto connection_id = session_connection_ids_.find(target.session);
+    if (connection_id == session_connection_ids_.end()) {
+      continue;
+    }
+    auto it = sessions_.find(connection_id->second);
+    if (it == sessions_.end()) {
+      continue;
+    }
+    WebTransportServerSession* session = nullptr;
+    for (const auto& candidate : it->second) {
+      if (candidate.second.get() == target.session) {
+        session = candidate.second.get();
+        break;
+      }
+    }
+    if (!session) {
+      continue;
+    }
+    // Slices share the same buffer.
+    ::quic::QuicMemSlice slice =
+        Utilities::CreateMemSliceForSharedBuffer(payload, length);
+    if (target.datagram) {
+      session->SendOrQueueDatagramOnCurrentThread(std::move(slice));
+    } else {
+      session->WriteToStreamOnCurrentThread(target.stream_id,
+                                            std::move(slice));
+    }
+  }
+}
+
+void WebTransportServerBackend::OnSendBufferBudgetAvailable() {
+  DCHECK(io_thread_checker_.CalledOnValidThread());
+  for (auto& connection : sessions_) {
+    for (auto& session : connection.second) {
+      session.second->OnSendBufferBudgetAvailable();
+    }
+  }
+}
+
+void WebTransportServerBackend::SetOverloaded(bool overloaded) {
+  DCHECK(io_thread_checker_.CalledOnValidThread());
+  overloaded_ = overloaded;
+  for (auto& connection : sessions_) {
+    for (auto& session : connection.second) {
+      session.second->SetOverloadedOnCurrentThread(overloaded);
+    }
+  }
+  if (visitor_) {
+    visitor_->OnOverload(overloaded);
+  }
+}
+
+MemoryUsage WebTransportServerBackend::GetMemoryUsage() const {
+  DCHECK(io_thread_checker_.CalledOnValidThread());
+  MemoryUsage usage = {};
+  for (const auto& connection : sessions_) {
+    for (const auto& session : connection.second) {
+      session.second->AddMemoryUsageOnCurrentThread(&usage);
+    }
+  }
+  return usage;
+}
+
+void WebTransportServerBackend::CollectCpuUsage(
+    uint32_t io_thread_index,
+    size_t count,
+    std::vector<SessionCpuUsage>* usages) {
+  DCHECK(io_thread_checker_.CalledOnValidThread());
+  usages->clear();
+  for (const auto& connection : sessions_) {
+    // Sessions on the same connection share its account.
+    SessionCpuAccount* account = nullptr;
+    for (const auto& session : connection.second) {
+      if (!session.second->session_closed()) {
+        account = session.second->cpu_account();
+        break;
+      }
+    }
+    if (!account) {
+      continue;
+    }
+    account->TakeRecentTime();
+    SessionCpuUsage usage = {};
+    base::strlcpy(usage.connection_id, connection.first.c_str(),
+                  sizeof(usage.connection_id));
+    usage.io_thread_index = io_thread_index;
+    account->FillUsage(&usage);
+    usages->push_back(usage);
+  }
+  SessionCpuAccount::KeepTop(usages, count);
+}
+
 void WebTransportServerBackend::OnSessionReady(
     ::quic::WebTransportHttp3* session,
     ::quic::QuicSpdySession* http3_session) {
   // This method is expected to be called on IO thread(io_runner_).
   DCHECK(io_thread_checker_.CalledOnValidThread());
-  LOG(INFO) << "On session ready " << session->id();
+  TRACE_EVENT_NESTABLE_ASYNC_END0(OWT_TRACE_CATEGORY,
+                                  "WebTransportServerSession::Handshake",
+                                  TRACE_ID_LOCAL(http3_session->connection()));
+  TRACE_EVENT0(OWT_TRACE_CATEGORY, "WebTransportServerBackend::OnSessionReady");
+  OWT_ASYNC_LOG(INFO) << "On session ready " << session->id();
+  // All QUIC sessions of this backend are created by its dispatcher.
+  MetricsRegistry::Record(
+      MetricHistogram::kServerHandshakeLatency,
+      (base::TimeTicks::Now() -
+       static_cast<Http3ServerSession*>(http3_session)->creation_time())
+          .InMicroseconds());
+  const std::string connection_id = http3_session->connection_id().ToString();
+  // Sessions over the same connection share its event thread, so their events
+  // are delivered in order.
+  base::SingleThreadTaskRunner* event_runner =
+      inline_event_dispatch_ ? io_runner_
+                             : event_threads_->GetTaskRunner(connection_id);
   std::unique_ptr<WebTransportServerSession> wt_session =
-      std::make_unique<WebTransportServerSession>(session, http3_session,
-                                                  io_runner_, event_runner_);
+      std::make_unique<WebTransportServerSession>(
+          session, http3_session, io_runner_, event_runner,
+          &send_buffer_budget_, send_buffer_allocator_);
+  wt_session->SetSendBufferBudget(session_send_buffer_budget_);
+  wt_session->SetOverloadedOnCurrentThread(overloaded_);
   WebTransportServerSession* session_ptr = wt_session.get();
-  if (sessions_.count(http3_session->connection_id().ToString()) > 0) {
-    LOG(WARNING) << "Session with the same connection ID exits, the old one "
-                    "will be terminated. Only one WebTransport session for a "
-                    "QUIC connection is supported.";
+  std::unique_ptr<WebTransportServerSession>& slot =
+      sessions_[connection_id][session->id()];
+  if (slot) {
+    OWT_ASYNC_LOG(WARNING) << "Session " << session->id()
+                           << " already exists on connection, replacing it.";
+    session_connection_ids_.erase(slot.get());
   }
-  sessions_[http3_session->connection_id().ToString()] = std::move(wt_session);
+  slot = std::move(wt_session);
+  session_connection_ids_[session_ptr] = connection_id;
   if (visitor_) {
     visitor_->OnSession(session_ptr);
   } else {
-    LOG(INFO) << "No visitor for backend.";
+    OWT_ASYNC_LOG(INFO) << "No visitor for backend.";
   }
 }
 
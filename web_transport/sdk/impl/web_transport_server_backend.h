@@ -7,8 +7,17 @@
 #ifndef OWT_QUIC_WEB_TRANSPORT_WEB_TRANSPORT_SERVER_BACKEND_H_
 #define OWT_QUIC_WEB_TRANSPORT_WEB_TRANSPORT_SERVER_BACKEND_H_
 
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "base/memory/scoped_refptr.h"
 #include "base/threading/thread_checker.h"
+#include "impl/event_thread_pool.h"
+#include "impl/send_buffer_budget.h"
 #include "impl/web_transport_server_session.h"
+#include "net/base/io_buffer.h"
 #include "net/third_party/quiche/src/quic/core/http/web_transport_http3.h"
 #include "net/third_party/quiche/src/quic/core/web_transport_interface.h"
 #include "owt/quic/web_transport_server_interface.h"
@@ -26,27 +35,71 @@ class WebTransportSessionVisitor {
 };
 
 // Handle WebTransport requests and responses.
-class WebTransportServerBackend : public WebTransportSessionVisitor {
+class WebTransportServerBackend : public WebTransportSessionVisitor,
+                                  public SendBufferBudget::Delegate {
  public:
-  explicit WebTransportServerBackend(
-      base::SingleThreadTaskRunner* io_runner,
-      base::SingleThreadTaskRunner* event_runner);
+  // Each session's visitor callbacks run on the thread of `event_threads` it
+  // is pinned to by connection ID, or on `io_runner` if
+  // `inline_event_dispatch` is true. `event_threads` must outlive this
+  // backend. Sessions copy datagrams from `send_buffer_allocator`, see
+  // WebTransportServerSession.
+  WebTransportServerBackend(base::SingleThreadTaskRunner* io_runner,
+                            const EventThreadPool* event_threads,
+                            bool inline_event_dispatch,
+                            ::quic::QuicBufferAllocator* send_buffer_allocator);
   ~WebTransportServerBackend() override;
 
   void SetVisitor(WebTransportServerInterface::Visitor* visitor);
+  // `session_budget` applies to sessions created after this call. Must be
+  // called on IO thread.
+  void SetSendBufferBudget(uint64_t server_budget, uint64_t session_budget);
+  // Sends `payload` to `targets` created by this backend. Other targets are
+  // ignored. Must be called on IO thread.
+  void Broadcast(const std::vector<BroadcastTarget>& targets,
+                 scoped_refptr<net::IOBuffer> payload,
+                 size_t length);
+  // Applies `overloaded` to all sessions, including sessions created later,
+  // and notifies the visitor. Must be called on IO thread.
+  void SetOverloaded(bool overloaded);
+  // Returns memory held by all sessions of this backend. Must be called on IO
+  // thread.
+  MemoryUsage GetMemoryUsage() const;
+  // Replaces `usages` with CPU usage of the `count` connections with the most
+  // recent time, which is the time since the last call. Connections without
+  // open sessions are skipped. Must be called on IO thread.
+  void CollectCpuUsage(uint32_t io_thread_index,
+                       size_t count,
+                       std::vector<SessionCpuUsage>* usages);
 
   // Overrides WebTransportSessionVisitor.
   void OnSessionReady(::quic::WebTransportHttp3* session,
                       ::quic::QuicSpdySession* http3_session) override;
   void OnSessionClosed(::quic::WebTransportSessionId id) override {}
 
+  // Overrides SendBufferBudget::Delegate.
+  void OnSendBufferBudgetAvailable() override;
+
  private:
   WebTransportServerInterface::Visitor* visitor_;
-  // Key is HTTP/3 QUIC stream connection ID.
-  std::unordered_map<std::string, std::unique_ptr<WebTransportServerSession>>
-      sessions_;
+  // Budget shared by all sessions. Must outlive `sessions_`.
+  SendBufferBudget send_buffer_budget_;
+  uint64_t session_send_buffer_budget_;
+  bool overloaded_;
+  // WebTransport sessions keyed by session ID, grouped by their QUIC
+  // connection's ID. A connection carries multiple sessions when a client
+  // pools them, e.g.: several WebTransport objects of a web page.
+  using SessionMap =
+      std::map<::quic::WebTransportSessionId,
+               std::unique_ptr<WebTransportServerSession>>;
+  std::unordered_map<std::string, SessionMap> sessions_;
+  // Connection IDs of sessions in `sessions_`, cached when they are created,
+  // so Broadcast finds a target without calling into it.
+  std::unordered_map<const WebTransportSessionInterface*, std::string>
+      session_connection_ids_;
   base::SingleThreadTaskRunner* io_runner_;
-  base::SingleThreadTaskRunner* event_runner_;
+  const EventThreadPool* event_threads_;
+  const bool inline_event_dispatch_;
+  ::quic::QuicBufferAllocator* const send_buffer_allocator_;  // Not owned.
   base::ThreadChecker io_thread_checker_;
 };
 }  // namespace quic
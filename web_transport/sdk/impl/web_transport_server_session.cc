@@ -14,17 +14,38 @@
 
 #include "impl/web_transport_server_session.h"
 #include <vector>
+#include "base/no_destructor.h"
 #include "base/strings/string_util.h"
+#include "base/trace_event/trace_event.h"
+#include "impl/metrics.h"
+#include "impl/server_stats_counters.h"
+#include "impl/tracing.h"
 #include "impl/web_transport_stream_impl.h"
 #include "net/third_party/quiche/src/quic/core/http/quic_server_initiated_spdy_stream.h"
 #include "net/third_party/quiche/src/quic/core/http/quic_spdy_stream.h"
+#include "net/third_party/quiche/src/quic/core/quic_bandwidth.h"
+#include "net/third_party/quiche/src/quic/core/quic_connection.h"
+#include "net/third_party/quiche/src/quic/core/quic_simple_buffer_allocator.h"
 #include "owt/web_transport/sdk/impl/utilities.h"
 
 namespace owt {
 namespace quic {
 
+namespace {
+// Max number of datagram batches kept for reuse.
+constexpr size_t kMaxPooledDatagramBatches = 4;
+// Interval of publishing connection stats.
+constexpr base::TimeDelta kStatsPublishInterval = base::Milliseconds(100);
+
+::quic::QuicBufferAllocator* DefaultSendBufferAllocator() {
+  static base::NoDestructor<::quic::SimpleBufferAllocator> allocator;
+  return allocator.get();
+}
+}  // namespace
+
 // Copied from net/quic/dedicated_web_transport_http3_client.cc.
-class WebTransportVisitorProxy : public ::quic::WebTransportVisitor {
+class WebTransportVisitorProxy : public ::quic::WebTransportVisitor,
+                                 public PooledObject {
  public:
   explicit WebTransportVisitorProxy(::quic::WebTransportVisitor* visitor)
       : visitor_(visitor) {}
@@ -60,25 +81,70 @@ WebTransportServerSession::WebTransportServerSession(
     ::quic::WebTransportHttp3* session,
     ::quic::QuicSpdySession* http3_session,
     base::SingleThreadTaskRunner* io_runner,
-    base::SingleThreadTaskRunner* event_runner)
+    base::SingleThreadTaskRunner* event_runner,
+    SendBufferBudget* server_budget,
+    ::quic::QuicBufferAllocator* send_buffer_allocator)
     : session_(session),
       http3_session_(http3_session),
+      session_id_(session->id()),
+      send_buffer_allocator_(send_buffer_allocator
+                                 ? send_buffer_allocator
+                                 : DefaultSendBufferAllocator()),
       io_runner_(io_runner),
       event_runner_(event_runner),
-      visitor_(nullptr) {
+      connection_id_(http3_session->connection_id().ToString()),
+      // All QUIC sessions created by WebTransportOwtServerDispatcher are
+      // Http3ServerSessions.
+      cpu_account_(
+          static_cast<Http3ServerSession*>(http3_session)->cpu_account()),
+      send_buffer_budget_(server_budget, this),
+      warm_stream_pool_(this),
+      visitor_(nullptr),
+      session_closed_(false),
+      stats_publish_scheduled_(false),
+      datagrams_dropped_(0),
+      bandwidth_estimate_hysteresis_percent_(0),
+      last_reported_bandwidth_(0),
+      datagram_batching_enabled_(false),
+      datagram_flush_scheduled_(false),
+      datagram_priority_(DatagramPriority::kDefault),
+      datagram_classes_(http3_session->connection()->clock()),
+      overloaded_(false),
+      max_datagram_size_(Utilities::MaxWebTransportDatagramSize(
+          http3_session->GetCurrentLargestMessagePayload(),
+          session->id())),
+      liveness_guard_(base::MakeRefCounted<LivenessGuard>()) {
   CHECK(session_);
   CHECK(http3_session_);
   CHECK(io_runner_);
   CHECK(event_runner_);
+  io_weak_this_ = weak_factory_.GetWeakPtr();
   session_->SetVisitor(std::make_unique<WebTransportVisitorProxy>(this));
+  // All QUIC sessions created by WebTransportOwtServerDispatcher are
+  // Http3ServerSessions.
+  static_cast<Http3ServerSession*>(http3_session_)->AddObserver(this);
+  PublishStatsOnCurrentThread();
 }
 
-WebTransportServerSession::~WebTransportServerSession() {}
+WebTransportServerSession::~WebTransportServerSession() {
+  // Waits for a delivery running on event thread.
+  liveness_guard_->Invalidate();
+}
 
 WebTransportStreamInterface*
 WebTransportServerSession::CreateBidirectionalStream() {
+  return CreateOutgoingStream(true);
+}
+
+WebTransportStreamInterface*
+WebTransportServerSession::CreateOutgoingUnidirectionalStream() {
+  return CreateOutgoingStream(false);
+}
+
+WebTransportStreamInterface* WebTransportServerSession::CreateOutgoingStream(
+    bool bidirectional) {
   if (io_runner_->BelongsToCurrentThread()) {
-    return CreateBidirectionalStreamOnCurrentThread();
+    return CreateOutgoingStreamOnCurrentThread(bidirectional);
   }
   WebTransportStreamInterface* result(nullptr);
   base::WaitableEvent done(base::WaitableEvent::ResetPolicy::AUTOMATIC,
@@ -87,11 +153,13 @@ WebTransportServerSession::CreateBidirectionalStream() {
       FROM_HERE,
       base::BindOnce(
           [](WebTransportServerSession* session,
-             WebTransportStreamInterface** result, base::WaitableEvent* event) {
-            *result = session->CreateBidirectionalStreamOnCurrentThread();
+             WebTransportStreamInterface** result, bool bidirectional,
+             base::WaitableEvent* event) {
+            *result =
+                session->CreateOutgoingStreamOnCurrentThread(bidirectional);
             event->Signal();
           },
-          base::Unretained(this), base::Unretained(&result),
+          base::Unretained(this), base::Unretained(&result), bidirectional,
           base::Unretained(&done)));
   done.Wait();
   return result;
@@ -99,15 +167,27 @@ WebTransportServerSession::CreateBidirectionalStream() {
 
 MessageStatus WebTransportServerSession::SendOrQueueDatagram(uint8_t* data,
                                                              size_t length) {
-  DCHECK(http3_session_ && http3_session_->connection() &&
-         http3_session_->connection()->helper());
-  auto* allocator =
-      http3_session_->connection()->helper()->GetStreamSendBufferAllocator();
   ::quic::QuicBuffer buffer = ::quic::QuicBuffer::Copy(
-      allocator, absl::string_view(reinterpret_cast<char*>(data), length));
+      send_buffer_allocator_,
+      absl::string_view(reinterpret_cast<char*>(data), length));
+  return SendOrQueueDatagram(::quic::QuicMemSlice(std::move(buffer)));
+}
+
+MessageStatus WebTransportServerSession::SendOrQueueDatagram(
+    uint8_t* data,
+    size_t length,
+    BufferReleaseCallback release,
+    void* release_context) {
+  return SendOrQueueDatagram(Utilities::CreateMemSliceForExternalBuffer(
+      data, length, release, release_context));
+}
+
+MessageStatus WebTransportServerSession::SendOrQueueDatagram(
+    ::quic::QuicMemSlice slice) {
+  TRACE_EVENT1(OWT_TRACE_CATEGORY, "WebTransportServerSession::SendDatagram",
+               "length", slice.length());
   if (io_runner_->BelongsToCurrentThread()) {
-    auto message_result =
-        session_->SendOrQueueDatagram(::quic::QuicMemSlice(std::move(buffer)));
+    auto message_result = SendDatagramOnCurrentThread(std::move(slice));
     return Utilities::ConvertMessageStatus(message_result);
   }
   MessageStatus result;
@@ -119,39 +199,596 @@ MessageStatus WebTransportServerSession::SendOrQueueDatagram(uint8_t* data,
           [](WebTransportServerSession* session, ::quic::QuicMemSlice slice,
              MessageStatus& result, base::WaitableEvent* event) {
             result = Utilities::ConvertMessageStatus(
-                session->session_->SendOrQueueDatagram(std::move(slice)));
+                session->SendDatagramOnCurrentThread(std::move(slice)));
+            event->Signal();
+          },
+          base::Unretained(this), std::move(slice), std::ref(result),
+          base::Unretained(&done)));
+  done.Wait();
+  return result;
+}
+
+void WebTransportServerSession::SendOrQueueDatagramAsync(uint8_t* data,
+                                                         size_t length) {
+  ::quic::QuicMemSlice slice(::quic::QuicBuffer::Copy(
+      send_buffer_allocator_,
+      absl::string_view(reinterpret_cast<char*>(data), length)));
+  if (io_runner_->BelongsToCurrentThread()) {
+    SendOrQueueDatagramOnCurrentThread(std::move(slice));
+    return;
+  }
+  io_runner_->PostTask(
+      FROM_HERE,
+      base::BindOnce(
+          &WebTransportServerSession::SendOrQueueDatagramOnCurrentThread,
+          weak_factory_.GetWeakPtr(), std::move(slice)));
+}
+
+void WebTransportServerSession::SendOrQueueDatagramOnCurrentThread(
+    ::quic::QuicMemSlice slice) {
+  DCHECK(io_runner_->BelongsToCurrentThread());
+  SessionCpuAccount::ScopedIoTimer timer(cpu_account_.get());
+  TRACE_EVENT1(OWT_TRACE_CATEGORY,
+               "WebTransportServerSession::SendDatagramAsync", "length",
+               slice.length());
+  if (session_closed_) {
+    return;
+  }
+  SendDatagramOnCurrentThread(std::move(slice));
+}
+
+::quic::MessageStatus WebTransportServerSession::SendDatagramOnCurrentThread(
+    ::quic::QuicMemSlice slice) {
+  DCHECK(io_runner_->BelongsToCurrentThread());
+  if (session_closed_) {
+    return ::quic::MESSAGE_STATUS_INTERNAL_ERROR;
+  }
+  static_cast<Http3ServerSession*>(http3_session_)->OnSendingDatagram(this);
+  return session_->SendOrQueueDatagram(std::move(slice));
+}
+
+void WebTransportServerSession::WriteToStreamOnCurrentThread(
+    uint32_t stream_id,
+    ::quic::QuicMemSlice slice) {
+  DCHECK(io_runner_->BelongsToCurrentThread());
+  SessionCpuAccount::ScopedIoTimer timer(cpu_account_.get());
+  auto it = streams_.find(stream_id);
+  if (it == streams_.end()) {
+    LOG(WARNING) << "Stream " << stream_id << " doesn't exist.";
+    return;
+  }
+  it->second->WriteMemSliceAsync(std::move(slice), false);
+}
+
+void WebTransportServerSession::OnDatagramProcessed(
+    absl::optional<::quic::MessageStatus> status) {
+  DCHECK(io_runner_->BelongsToCurrentThread());
+  if (!status || *status != ::quic::MESSAGE_STATUS_SUCCESS) {
+    datagrams_dropped_++;
+    MetricsRegistry::Increment(MetricCounter::kDatagramsDropped);
+  }
+  if (visitor_) {
+    visitor_->OnDatagramProcessed(status
+                                      ? Utilities::ConvertMessageStatus(status)
+                                      : MessageStatus::kExpired);
+  }
+}
+
+void WebTransportServerSession::SetBandwidthEstimateHysteresis(
+    uint32_t percent) {
+  if (io_runner_->BelongsToCurrentThread()) {
+    return SetBandwidthEstimateHysteresisOnCurrentThread(percent);
+  }
+  io_runner_->PostTask(
+      FROM_HERE,
+      base::BindOnce(&WebTransportServerSession::
+                         SetBandwidthEstimateHysteresisOnCurrentThread,
+                     base::Unretained(this), percent));
+}
+
+void WebTransportServerSession::SetMaxDatagramTimeInQueue(
+    uint32_t max_time_ms) {
+  if (io_runner_->BelongsToCurrentThread()) {
+    return SetMaxDatagramTimeInQueueOnCurrentThread(max_time_ms);
+  }
+  io_runner_->PostTask(
+      FROM_HERE,
+      base::BindOnce(
+          &WebTransportServerSession::SetMaxDatagramTimeInQueueOnCurrentThread,
+          weak_factory_.GetWeakPtr(), max_time_ms));
+}
+
+void WebTransportServerSession::SetMaxDatagramTimeInQueueOnCurrentThread(
+    uint32_t max_time_ms) {
+  DCHECK(io_runner_->BelongsToCurrentThread());
+  if (session_closed_) {
+    return;
+  }
+  // Only the option being set is applied, so sessions pooled over one
+  // connection don't overwrite each other's other option.
+  http3_session_->SetMaxDatagramTimeInQueue(
+      ::quic::QuicTime::Delta::FromMilliseconds(max_time_ms));
+}
+
+void WebTransportServerSession::SetDatagramPriority(
+    DatagramPriority priority) {
+  if (io_runner_->BelongsToCurrentThread()) {
+    return SetDatagramPriorityOnCurrentThread(priority);
+  }
+  io_runner_->PostTask(
+      FROM_HERE,
+      base::BindOnce(
+          &WebTransportServerSession::SetDatagramPriorityOnCurrentThread,
+          weak_factory_.GetWeakPtr(), priority));
+}
+
+void WebTransportServerSession::SetDatagramPriorityOnCurrentThread(
+    DatagramPriority priority) {
+  DCHECK(io_runner_->BelongsToCurrentThread());
+  datagram_priority_ = priority;
+  if (session_closed_) {
+    return;
+  }
+  static_cast<Http3ServerSession*>(http3_session_)
+      ->set_datagrams_before_retransmissions(
+          priority == DatagramPriority::kAboveStreams);
+}
+
+void WebTransportServerSession::SetDatagramClasses(
+    const DatagramClassOptions* classes,
+    size_t count) {
+  DCHECK(classes || count == 0);
+  std::vector<DatagramClassOptions> class_options(classes, classes + count);
+  if (io_runner_->BelongsToCurrentThread()) {
+    return SetDatagramClassesOnCurrentThread(std::move(class_options));
+  }
+  io_runner_->PostTask(
+      FROM_HERE,
+      base::BindOnce(
+          &WebTransportServerSession::SetDatagramClassesOnCurrentThread,
+          weak_factory_.GetWeakPtr(), std::move(class_options)));
+}
+
+void WebTransportServerSession::SetDatagramClassesOnCurrentThread(
+    std::vector<DatagramClassOptions> classes) {
+  DCHECK(io_runner_->BelongsToCurrentThread());
+  datagram_classes_.SetClasses(classes);
+  ReportQueuedDatagramDropsOnCurrentThread();
+}
+
+MessageStatus WebTransportServerSession::SendOrQueuePrioritizedDatagram(
+    uint8_t* data,
+    size_t length,
+    uint32_t priority_class) {
+  ::quic::QuicMemSlice slice(::quic::QuicBuffer::Copy(
+      send_buffer_allocator_,
+      absl::string_view(reinterpret_cast<char*>(data), length)));
+  if (io_runner_->BelongsToCurrentThread()) {
+    return SendOrQueuePrioritizedDatagramOnCurrentThread(std::move(slice),
+                                                         priority_class);
+  }
+  MessageStatus result;
+  base::WaitableEvent done(base::WaitableEvent::ResetPolicy::AUTOMATIC,
+                           base::WaitableEvent::InitialState::NOT_SIGNALED);
+  io_runner_->PostTask(
+      FROM_HERE,
+      base::BindOnce(
+          [](WebTransportServerSession* session, ::quic::QuicMemSlice slice,
+             uint32_t priority_class, MessageStatus& result,
+             base::WaitableEvent* event) {
+            result = session->SendOrQueuePrioritizedDatagramOnCurrentThread(
+                std::move(slice), priority_class);
             event->Signal();
           },
-          base::Unretained(this), ::quic::QuicMemSlice(std::move(buffer)),
+          base::Unretained(this), std::move(slice), priority_class,
           std::ref(result), base::Unretained(&done)));
   done.Wait();
   return result;
 }
 
+MessageStatus
+WebTransportServerSession::SendOrQueuePrioritizedDatagramOnCurrentThread(
+    ::quic::QuicMemSlice slice,
+    uint32_t priority_class) {
+  DCHECK(io_runner_->BelongsToCurrentThread());
+  SessionCpuAccount::ScopedIoTimer timer(cpu_account_.get());
+  TRACE_EVENT2(OWT_TRACE_CATEGORY,
+               "WebTransportServerSession::SendPrioritizedDatagram", "length",
+               slice.length(), "class", priority_class);
+  if (session_closed_) {
+    return MessageStatus::kUnavailable;
+  }
+  auto* http3_session = static_cast<Http3ServerSession*>(http3_session_);
+  if (!datagram_classes_.enabled() ||
+      (datagram_classes_.empty() && http3_session->CanSendDatagramNow())) {
+    return Utilities::ConvertMessageStatus(
+        SendDatagramOnCurrentThread(std::move(slice)));
+  }
+  // Report oversized datagrams now, rather than after they're queued.
+  if (slice.length() > max_datagram_size_) {
+    return MessageStatus::kTooLarge;
+  }
+  if (!datagram_classes_.Enqueue(priority_class, std::move(slice))) {
+    return MessageStatus::kQueueFull;
+  }
+  ReportQueuedDatagramDropsOnCurrentThread();
+  return MessageStatus::kBlocked;
+}
+
+void WebTransportServerSession::ReportQueuedDatagramDropsOnCurrentThread() {
+  DCHECK(io_runner_->BelongsToCurrentThread());
+  for (size_t dropped = datagram_classes_.TakeDroppedCount(); dropped > 0;
+       dropped--) {
+    OnDatagramProcessed(absl::nullopt);
+  }
+}
+
+void WebTransportServerSession::OnCanSendDatagrams() {
+  DCHECK(io_runner_->BelongsToCurrentThread());
+  if (session_closed_) {
+    return;
+  }
+  SessionCpuAccount::ScopedIoTimer timer(cpu_account_.get());
+  auto* http3_session = static_cast<Http3ServerSession*>(http3_session_);
+  ::quic::QuicConnection::ScopedPacketFlusher flusher(
+      http3_session_->connection());
+  ::quic::QuicMemSlice slice;
+  // Stops once QUIC's own queue has a datagram, so lower classes don't pass
+  // higher ones waiting there.
+  while (http3_session->CanSendDatagramNow() &&
+         datagram_classes_.Dequeue(&slice)) {
+    // Status is reported by OnDatagramProcessed.
+    SendDatagramOnCurrentThread(std::move(slice));
+  }
+  ReportQueuedDatagramDropsOnCurrentThread();
+}
+
+void WebTransportServerSession::OnSessionDestroyed() {
+  DCHECK(io_runner_->BelongsToCurrentThread());
+  if (!session_closed_) {
+    OnSessionClosed(0, "Connection is destroyed.");
+  }
+  session_ = nullptr;
+  http3_session_ = nullptr;
+}
+
+bool WebTransportServerSession::HasQueuedDatagrams() const {
+  return !session_closed_ && !datagram_classes_.empty();
+}
+
+void WebTransportServerSession::SetOverloadedOnCurrentThread(
+    bool overloaded) {
+  DCHECK(io_runner_->BelongsToCurrentThread());
+  overloaded_ = overloaded;
+}
+
+void WebTransportServerSession::SetMaxSendRate(uint64_t bits_per_second) {
+  if (io_runner_->BelongsToCurrentThread()) {
+    return SetMaxSendRateOnCurrentThread(bits_per_second);
+  }
+  io_runner_->PostTask(
+      FROM_HERE,
+      base::BindOnce(&WebTransportServerSession::SetMaxSendRateOnCurrentThread,
+                     weak_factory_.GetWeakPtr(), bits_per_second));
+}
+
+void WebTransportServerSession::SetMaxSendRateOnCurrentThread(
+    uint64_t bits_per_second) {
+  DCHECK(io_runner_->BelongsToCurrentThread());
+  if (session_closed_) {
+    return;
+  }
+  // A zero max pacing rate means no cap.
+  http3_session_->connection()->SetMaxPacingRate(
+      ::quic::QuicBandwidth::FromBitsPerSecond(
+          static_cast<int64_t>(bits_per_second)));
+}
+
+void WebTransportServerSession::SetKeepAlive(uint32_t interval_ms,
+                                             uint32_t idle_timeout_ms) {
+  if (io_runner_->BelongsToCurrentThread()) {
+    return SetKeepAliveOnCurrentThread(interval_ms, idle_timeout_ms);
+  }
+  io_runner_->PostTask(
+      FROM_HERE,
+      base::BindOnce(&WebTransportServerSession::SetKeepAliveOnCurrentThread,
+                     weak_factory_.GetWeakPtr(), interval_ms,
+                     idle_timeout_ms));
+}
+
+void WebTransportServerSession::SetKeepAliveOnCurrentThread(
+    uint32_t interval_ms,
+    uint32_t idle_timeout_ms) {
+  DCHECK(io_runner_->BelongsToCurrentThread());
+  if (session_closed_) {
+    return;
+  }
+  static_cast<Http3ServerSession*>(http3_session_)
+      ->SetKeepAlive(base::Milliseconds(interval_ms),
+                     base::Milliseconds(idle_timeout_ms));
+}
+
+void WebTransportServerSession::SetWarmStreamPoolSize(size_t bidirectional,
+                                                      size_t unidirectional) {
+  if (io_runner_->BelongsToCurrentThread()) {
+    return SetWarmStreamPoolSizeOnCurrentThread(bidirectional, unidirectional);
+  }
+  io_runner_->PostTask(
+      FROM_HERE,
+      base::BindOnce(
+          &WebTransportServerSession::SetWarmStreamPoolSizeOnCurrentThread,
+          weak_factory_.GetWeakPtr(), bidirectional, unidirectional));
+}
+
+void WebTransportServerSession::SetWarmStreamPoolSizeOnCurrentThread(
+    size_t bidirectional,
+    size_t unidirectional) {
+  DCHECK(io_runner_->BelongsToCurrentThread());
+  warm_stream_pool_.SetSize(bidirectional, unidirectional);
+}
+
+WebTransportStreamInterface* WebTransportServerSession::AcquireStream(
+    bool bidirectional) {
+  WebTransportStreamInterface* stream =
+      warm_stream_pool_.Acquire(bidirectional);
+  if (warm_stream_pool_.ScheduleRefill()) {
+    // Refill after the caller's current task, so streams are not opened while
+    // the caller is writing to the acquired one.
+    io_runner_->PostTask(
+        FROM_HERE,
+        base::BindOnce(
+            &WebTransportServerSession::RefillWarmStreamPoolOnCurrentThread,
+            weak_factory_.GetWeakPtr()));
+  }
+  return stream;
+}
+
+void WebTransportServerSession::RefillWarmStreamPoolOnCurrentThread() {
+  DCHECK(io_runner_->BelongsToCurrentThread());
+  warm_stream_pool_.RefillAll();
+}
+
+WebTransportStreamInterface* WebTransportServerSession::OpenWarmStream(
+    bool bidirectional) {
+  if (session_closed_) {
+    return nullptr;
+  }
+  return CreateOutgoingStreamOnCurrentThread(bidirectional);
+}
+
+void WebTransportServerSession::OnCanCreateNewOutgoingBidirectionalStream() {
+  warm_stream_pool_.Refill(true);
+}
+
+void WebTransportServerSession::OnCanCreateNewOutgoingUnidirectionalStream() {
+  warm_stream_pool_.Refill(false);
+}
+
+size_t WebTransportServerSession::GetMaxDatagramSize() const {
+  return max_datagram_size_.load(std::memory_order_relaxed);
+}
+
+void WebTransportServerSession::UpdateMaxDatagramSizeOnCurrentThread() {
+  DCHECK(io_runner_->BelongsToCurrentThread());
+  if (session_closed_) {
+    return;
+  }
+  const size_t max_datagram_size = Utilities::MaxWebTransportDatagramSize(
+      http3_session_->GetCurrentLargestMessagePayload(), session_->id());
+  if (max_datagram_size == max_datagram_size_.load(std::memory_order_relaxed)) {
+    return;
+  }
+  max_datagram_size_.store(max_datagram_size, std::memory_order_relaxed);
+  if (visitor_) {
+    visitor_->OnMaxDatagramSizeChanged(max_datagram_size);
+  }
+}
+
+void WebTransportServerSession::SetBandwidthEstimateHysteresisOnCurrentThread(
+    uint32_t percent) {
+  DCHECK(io_runner_->BelongsToCurrentThread());
+  bandwidth_estimate_hysteresis_percent_ = percent;
+  // Report current estimate on next congestion window change.
+  last_reported_bandwidth_ = 0;
+}
+
+void WebTransportServerSession::OnCongestionWindowChange() {
+  DCHECK(io_runner_->BelongsToCurrentThread());
+  // Congestion window changes on ACKs, which also confirm MTU probes.
+  UpdateMaxDatagramSizeOnCurrentThread();
+  if (bandwidth_estimate_hysteresis_percent_ == 0 || session_closed_ ||
+      !visitor_) {
+    return;
+  }
+  const ::quic::QuicSentPacketManager& sent_packet_manager =
+      http3_session_->connection()->sent_packet_manager();
+  const uint64_t bandwidth =
+      sent_packet_manager.BandwidthEstimate().ToBitsPerSecond();
+  if (bandwidth == 0) {
+    return;
+  }
+  if (last_reported_bandwidth_ != 0) {
+    const uint64_t delta = bandwidth > last_reported_bandwidth_
+                               ? bandwidth - last_reported_bandwidth_
+                               : last_reported_bandwidth_ - bandwidth;
+    if (delta * 100 <
+        last_reported_bandwidth_ * bandwidth_estimate_hysteresis_percent_) {
+      return;
+    }
+  }
+  last_reported_bandwidth_ = bandwidth;
+  visitor_->OnBandwidthEstimateUpdated(
+      bandwidth,
+      sent_packet_manager.GetRttStats()->smoothed_rtt().ToMicroseconds());
+}
+
+void WebTransportServerSession::SendOrQueueDatagrams(const Datagram* batch,
+                                                     size_t count,
+                                                     MessageStatus* results) {
+  if (count == 0) {
+    return;
+  }
+  DCHECK(batch);
+  // Datagrams are copied on caller's thread, so the IO thread only needs to
+  // hand them to the session.
+  std::vector<::quic::QuicMemSlice> slices;
+  slices.reserve(count);
+  for (size_t i = 0; i < count; i++) {
+    slices.emplace_back(::quic::QuicBuffer::Copy(
+        send_buffer_allocator_,
+        absl::string_view(reinterpret_cast<const char*>(batch[i].data),
+                          batch[i].length)));
+  }
+  if (io_runner_->BelongsToCurrentThread()) {
+    SendOrQueueDatagramsOnCurrentThread(std::move(slices), results);
+    return;
+  }
+  base::WaitableEvent done(base::WaitableEvent::ResetPolicy::AUTOMATIC,
+                           base::WaitableEvent::InitialState::NOT_SIGNALED);
+  io_runner_->PostTask(
+      FROM_HERE,
+      base::BindOnce(
+          [](WebTransportServerSession* session,
+             std::vector<::quic::QuicMemSlice> slices, MessageStatus* results,
+             base::WaitableEvent* event) {
+            session->SendOrQueueDatagramsOnCurrentThread(std::move(slices),
+                                                         results);
+            event->Signal();
+          },
+          base::Unretained(this), std::move(slices), base::Unretained(results),
+          base::Unretained(&done)));
+  done.Wait();
+}
+
+void WebTransportServerSession::SendOrQueueDatagramsOnCurrentThread(
+    std::vector<::quic::QuicMemSlice> slices,
+    MessageStatus* results) {
+  DCHECK(io_runner_->BelongsToCurrentThread());
+  SessionCpuAccount::ScopedIoTimer timer(cpu_account_.get());
+  TRACE_EVENT1(OWT_TRACE_CATEGORY, "WebTransportServerSession::SendDatagrams",
+               "count", slices.size());
+  if (session_closed_) {
+    for (size_t i = 0; results && i < slices.size(); i++) {
+      results[i] = MessageStatus::kUnavailable;
+    }
+    return;
+  }
+  // Bundle datagrams into as few packets as possible.
+  ::quic::QuicConnection::ScopedPacketFlusher flusher(
+      http3_session_->connection());
+  for (size_t i = 0; i < slices.size(); i++) {
+    MessageStatus status = Utilities::ConvertMessageStatus(
+        SendDatagramOnCurrentThread(std::move(slices[i])));
+    if (results) {
+      results[i] = status;
+    }
+  }
+}
+
+size_t WebTransportServerSession::CreateBidirectionalStreams(
+    size_t count,
+    WebTransportStreamInterface** streams) {
+  return CreateOutgoingStreams(true, count, streams);
+}
+
+size_t WebTransportServerSession::CreateOutgoingUnidirectionalStreams(
+    size_t count,
+    WebTransportStreamInterface** streams) {
+  return CreateOutgoingStreams(false, count, streams);
+}
+
+size_t WebTransportServerSession::CreateOutgoingStreams(
+    bool bidirectional,
+    size_t count,
+    WebTransportStreamInterface** streams) {
+  if (count == 0) {
+    return 0;
+  }
+  DCHECK(streams);
+  if (io_runner_->BelongsToCurrentThread()) {
+    return CreateOutgoingStreamsOnCurrentThread(bidirectional, count, streams);
+  }
+  size_t result(0);
+  base::WaitableEvent done(base::WaitableEvent::ResetPolicy::AUTOMATIC,
+                           base::WaitableEvent::InitialState::NOT_SIGNALED);
+  io_runner_->PostTask(
+      FROM_HERE,
+      base::BindOnce(
+          [](WebTransportServerSession* session, bool bidirectional,
+             size_t count, WebTransportStreamInterface** streams,
+             size_t* result, base::WaitableEvent* event) {
+            *result = session->CreateOutgoingStreamsOnCurrentThread(
+                bidirectional, count, streams);
+            event->Signal();
+          },
+          base::Unretained(this), bidirectional, count,
+          base::Unretained(streams), base::Unretained(&result),
+          base::Unretained(&done)));
+  done.Wait();
+  return result;
+}
+
+size_t WebTransportServerSession::CreateOutgoingStreamsOnCurrentThread(
+    bool bidirectional,
+    size_t count,
+    WebTransportStreamInterface** streams) {
+  DCHECK(io_runner_->BelongsToCurrentThread());
+  size_t created = 0;
+  for (; created < count; created++) {
+    WebTransportStreamInterface* stream =
+        CreateOutgoingStreamOnCurrentThread(bidirectional);
+    if (!stream) {
+      break;
+    }
+    streams[created] = stream;
+  }
+  return created;
+}
+
 WebTransportStreamInterface*
-WebTransportServerSession::CreateBidirectionalStreamOnCurrentThread() {
-  ::quic::WebTransportStream* wt_stream =
-      session_->OpenOutgoingBidirectionalStream();
-  std::unique_ptr<WebTransportStreamImpl> stream =
+WebTransportServerSession::CreateOutgoingStreamOnCurrentThread(
+    bool bidirectional) {
+  DCHECK(io_runner_->BelongsToCurrentThread());
+  if (session_closed_) {
+    return nullptr;
+  }
+  ::quic::WebTransportStream* wt_stream(nullptr);
+  if (bidirectional) {
+    if (!session_->CanOpenNextOutgoingBidirectionalStream()) {
+      return nullptr;
+    }
+    wt_stream = session_->OpenOutgoingBidirectionalStream();
+  } else {
+    if (!session_->CanOpenNextOutgoingUnidirectionalStream()) {
+      return nullptr;
+    }
+    wt_stream = session_->OpenOutgoingUnidirectionalStream();
+  }
+  if (!wt_stream) {
+    return nullptr;
+  }
+  return OwtStreamForNativeStream(wt_stream);
+}
+
+WebTransportStreamImpl* WebTransportServerSession::OwtStreamForNativeStream(
+    ::quic::WebTransportStream* stream) {
+  std::unique_ptr<WebTransportStreamImpl> wt_stream =
       std::make_unique<WebTransportStreamImpl>(
-          wt_stream,
-          http3_session_->GetOrCreateStream(wt_stream->GetStreamId()),
-          io_runner_, event_runner_);
-  WebTransportStreamInterface* stream_ptr(stream.get());
-  streams_.push_back(std::move(stream));
+          stream, http3_session_->GetOrCreateStream(stream->GetStreamId()),
+          io_runner_, event_runner_, &send_buffer_budget_);
+  WebTransportStreamImpl* stream_ptr = wt_stream.get();
+  stream_ptr->SetDelegate(this);
+  stream_ptr->SetCpuAccount(cpu_account_.get());
+  streams_[stream_ptr->Id()] = std::move(wt_stream);
   return stream_ptr;
 }
 
 uint64_t WebTransportServerSession::SessionId() const {
-  return session_->id();
+  return session_id_;
 }
 
 const char* WebTransportServerSession::ConnectionId() const {
-  const std::string& session_id_str =
-      http3_session_->connection_id().ToString();
-  char* id = new char[session_id_str.size() + 1];
-  strcpy(id, session_id_str.c_str());
-  return id;
+  return connection_id_.c_str();
 }
 
 bool WebTransportServerSession::IsSessionReady() const {
@@ -164,10 +801,112 @@ void WebTransportServerSession::SetVisitor(
   visitor_ = visitor;
 }
 
-const ConnectionStats& WebTransportServerSession::GetStats() {
-  const auto& stats = http3_session_->connection()->GetStats();
-  stats_.estimated_bandwidth = stats.estimated_bandwidth.ToBitsPerSecond();
-  return stats_;
+ConnectionStats WebTransportServerSession::GetStats() {
+  if (io_runner_->BelongsToCurrentThread() && !session_closed_) {
+    // Refresh stats since it's cheap on IO thread.
+    PublishStatsOnCurrentThread();
+  }
+  ConnectionStats stats;
+  stats_snapshot_.Read(&stats);
+  return stats;
+}
+
+MemoryUsage WebTransportServerSession::GetMemoryUsage() {
+  MemoryUsage usage = {};
+  if (io_runner_->BelongsToCurrentThread()) {
+    AddMemoryUsageOnCurrentThread(&usage);
+    return usage;
+  }
+  base::WaitableEvent done(base::WaitableEvent::ResetPolicy::AUTOMATIC,
+                           base::WaitableEvent::InitialState::NOT_SIGNALED);
+  io_runner_->PostTask(
+      FROM_HERE,
+      base::BindOnce(
+          [](WebTransportServerSession* session, MemoryUsage* usage,
+             base::WaitableEvent* event) {
+            session->AddMemoryUsageOnCurrentThread(usage);
+            event->Signal();
+          },
+          base::Unretained(this), base::Unretained(&usage),
+          base::Unretained(&done)));
+  done.Wait();
+  return usage;
+}
+
+void WebTransportServerSession::AddMemoryUsageOnCurrentThread(
+    MemoryUsage* usage) const {
+  DCHECK(io_runner_->BelongsToCurrentThread());
+  MemoryUsage session_usage = {};
+  session_usage.sessions = 1;
+  session_usage.object_bytes = sizeof(*this);
+  for (const auto& stream : streams_) {
+    stream.second->AddMemoryUsageOnCurrentThread(&session_usage);
+  }
+  if (received_datagrams_) {
+    session_usage.datagram_buffer_bytes +=
+        received_datagrams_->buffer.capacity();
+  }
+  for (const auto& batch : datagram_batch_pool_) {
+    session_usage.datagram_buffer_bytes += batch->buffer.capacity();
+  }
+  if (!session_closed_) {
+    session_usage.object_bytes +=
+        sizeof(Http3ServerSession) + sizeof(::quic::QuicConnection);
+    session_usage.queued_datagrams =
+        static_cast<Http3ServerSession*>(http3_session_)->QueuedDatagramCount();
+  }
+  session_usage.queued_datagrams += datagram_classes_.size();
+  session_usage.datagram_buffer_bytes += datagram_classes_.bytes();
+  session_usage.total_bytes = session_usage.stream_send_buffer_bytes +
+                              session_usage.stream_receive_buffer_bytes +
+                              session_usage.datagram_buffer_bytes +
+                              session_usage.object_bytes;
+  ServerStatsCounters::Accumulate(session_usage, usage);
+}
+
+void WebTransportServerSession::PublishStatsOnCurrentThread() {
+  DCHECK(io_runner_->BelongsToCurrentThread());
+  if (session_closed_) {
+    return;
+  }
+  ::quic::QuicConnection* connection = http3_session_->connection();
+  const ::quic::QuicConnectionStats& connection_stats = connection->GetStats();
+  const ::quic::QuicSentPacketManager& sent_packet_manager =
+      connection->sent_packet_manager();
+  ConnectionStats stats = {};
+  stats.estimated_bandwidth =
+      connection_stats.estimated_bandwidth.ToBitsPerSecond();
+  stats.buffered_send_bytes = send_buffer_budget_.usage();
+  stats.smoothed_rtt_us = connection_stats.srtt_us;
+  stats.min_rtt_us = connection_stats.min_rtt_us;
+  stats.congestion_window = sent_packet_manager.GetCongestionWindowInBytes();
+  stats.bytes_in_flight = sent_packet_manager.GetBytesInFlight();
+  stats.packets_sent = connection_stats.packets_sent;
+  stats.packets_lost = connection_stats.packets_lost;
+  stats.packets_retransmitted = connection_stats.packets_retransmitted;
+  stats.pacing_rate = sent_packet_manager.GetSendAlgorithm()
+                          ->PacingRate(sent_packet_manager.GetBytesInFlight())
+                          .ToBitsPerSecond();
+  stats.datagrams_dropped = datagrams_dropped_;
+  stats.peer_migrations =
+      static_cast<Http3ServerSession*>(http3_session_)->peer_migrations();
+  stats_snapshot_.Publish(stats);
+  if (stats_publish_scheduled_) {
+    return;
+  }
+  stats_publish_scheduled_ = true;
+  io_runner_->PostDelayedTask(
+      FROM_HERE,
+      base::BindOnce(
+          [](base::WeakPtr<WebTransportServerSession> session) {
+            if (!session) {
+              return;
+            }
+            session->stats_publish_scheduled_ = false;
+            session->PublishStatsOnCurrentThread();
+          },
+          weak_factory_.GetWeakPtr()),
+      kStatsPublishInterval);
 }
 
 void WebTransportServerSession::Close(uint32_t code, const char* reason) {
@@ -181,6 +920,9 @@ void WebTransportServerSession::Close(uint32_t code, const char* reason) {
 }
 
 void WebTransportServerSession::CloseOnCurrentThread(uint32_t code, const char* reason){
+  if (session_closed_) {
+    return;
+  }
   if (reason == nullptr) {
     return session_->CloseSession(code, reason);
   }
@@ -192,6 +934,30 @@ void WebTransportServerSession::CloseOnCurrentThread(uint32_t code, const char*
   return session_->CloseSession(code, reason_str);
 }
 
+void WebTransportServerSession::SetSendBufferBudget(uint64_t bytes) {
+  if (io_runner_->BelongsToCurrentThread()) {
+    return SetSendBufferBudgetOnCurrentThread(bytes);
+  }
+  io_runner_->PostTask(
+      FROM_HERE,
+      base::BindOnce(
+          &WebTransportServerSession::SetSendBufferBudgetOnCurrentThread,
+          base::Unretained(this), bytes));
+}
+
+void WebTransportServerSession::SetSendBufferBudgetOnCurrentThread(
+    uint64_t bytes) {
+  DCHECK(io_runner_->BelongsToCurrentThread());
+  send_buffer_budget_.SetLimit(bytes);
+}
+
+void WebTransportServerSession::OnSendBufferBudgetAvailable() {
+  DCHECK(io_runner_->BelongsToCurrentThread());
+  for (auto& stream : streams_) {
+    stream.second->OnSendBufferBudgetAvailable();
+  }
+}
+
 void WebTransportServerSession::OnIncomingBidirectionalStreamAvailable() {
   auto* stream = session_->AcceptIncomingBidirectionalStream();
   AcceptIncomingStream(stream);
@@ -205,33 +971,166 @@ void WebTransportServerSession::OnIncomingUnidirectionalStreamAvailable() {
 void WebTransportServerSession::OnSessionClosed(
     ::quic::WebTransportSessionError error_code,
     const std::string& error_message) {
+  session_closed_ = true;
+  warm_stream_pool_.Clear();
+  datagram_classes_.Clear();
+  ReportQueuedDatagramDropsOnCurrentThread();
   for (auto& stream : streams_) {
-    stream->OnSessionClosed();
+    stream.second->OnSessionClosed();
   }
   if (visitor_) {
     visitor_->OnConnectionClosed();
   }
 }
 
+void WebTransportServerSession::OnStreamClosed(uint32_t id) {
+  DCHECK(io_runner_->BelongsToCurrentThread());
+  auto it = streams_.find(id);
+  if (it == streams_.end()) {
+    return;
+  }
+  // Streams could be reset by the peer before they're acquired.
+  warm_stream_pool_.Remove(it->second.get());
+  streams_.erase(it);
+}
+
 void WebTransportServerSession::AcceptIncomingStream(
     ::quic::WebTransportStream* stream) {
-  std::unique_ptr<WebTransportStreamImpl> wt_stream =
-      std::make_unique<WebTransportStreamImpl>(
-          stream, http3_session_->GetOrCreateStream(stream->GetStreamId()),
-          io_runner_, event_runner_);
-  WebTransportStreamInterface* stream_ptr = wt_stream.get();
-  streams_.push_back(std::move(wt_stream));
+  WebTransportStreamInterface* stream_ptr = OwtStreamForNativeStream(stream);
   if (visitor_) {
     visitor_->OnIncomingStream(stream_ptr);
   }
 }
 
+void WebTransportServerSession::SetDatagramBatchingEnabled(bool enabled) {
+  if (io_runner_->BelongsToCurrentThread()) {
+    return SetDatagramBatchingEnabledOnCurrentThread(enabled);
+  }
+  io_runner_->PostTask(
+      FROM_HERE,
+      base::BindOnce(
+          &WebTransportServerSession::SetDatagramBatchingEnabledOnCurrentThread,
+          base::Unretained(this), enabled));
+}
+
+void WebTransportServerSession::SetDatagramBatchingEnabledOnCurrentThread(
+    bool enabled) {
+  DCHECK(io_runner_->BelongsToCurrentThread());
+  datagram_batching_enabled_ = enabled;
+}
+
 void WebTransportServerSession::OnDatagramReceived(absl::string_view datagram) {
+  TRACE_EVENT1(OWT_TRACE_CATEGORY,
+               "WebTransportServerSession::OnDatagramReceived", "length",
+               datagram.size());
+  // Datagrams are unreliable, dropping them sheds load of event threads
+  // without breaking streams.
+  if (overloaded_ && datagram_priority_ != DatagramPriority::kAboveStreams) {
+    ServerStatsCounters* counters =
+        static_cast<Http3ServerSession*>(http3_session_)->stats_counters();
+    if (counters) {
+      counters->OnDatagramShed();
+    }
+    return;
+  }
+  if (datagram_batching_enabled_) {
+    if (!received_datagrams_) {
+      if (datagram_batch_pool_.empty()) {
+        received_datagrams_ = std::make_unique<ReceivedDatagramBatch>();
+      } else {
+        received_datagrams_ = std::move(datagram_batch_pool_.back());
+        datagram_batch_pool_.pop_back();
+      }
+    }
+    received_datagrams_->buffer.insert(received_datagrams_->buffer.end(),
+                                       datagram.begin(), datagram.end());
+    received_datagrams_->lengths.push_back(datagram.size());
+    // Datagrams are received when processing packets read from socket. A task
+    // posted to IO thread runs after the current round of packet reading.
+    if (!datagram_flush_scheduled_) {
+      datagram_flush_scheduled_ = true;
+      io_runner_->PostTask(
+          FROM_HERE,
+          base::BindOnce(&WebTransportServerSession::FlushReceivedDatagrams,
+                         weak_factory_.GetWeakPtr()));
+    }
+    return;
+  }
   if (visitor_) {
     visitor_->OnDatagramReceived(
         reinterpret_cast<const uint8_t*>(datagram.data()), datagram.size());
   }
 }
 
+void WebTransportServerSession::FlushReceivedDatagrams() {
+  DCHECK(io_runner_->BelongsToCurrentThread());
+  SessionCpuAccount::ScopedIoTimer timer(cpu_account_.get());
+  TRACE_EVENT0(OWT_TRACE_CATEGORY,
+               "WebTransportServerSession::FlushReceivedDatagrams");
+  datagram_flush_scheduled_ = false;
+  if (!received_datagrams_) {
+    return;
+  }
+  // Data pointers are resolved after all datagrams are appended, since
+  // appending may reallocate the buffer.
+  ReceivedDatagramBatch* batch = received_datagrams_.get();
+  size_t offset = 0;
+  for (size_t length : batch->lengths) {
+    batch->datagrams.push_back(Datagram{batch->buffer.data() + offset, length});
+    offset += length;
+  }
+  if (event_runner_->BelongsToCurrentThread()) {
+    // Inline dispatch, the batch is recycled after visitor returns.
+    if (visitor_) {
+      visitor_->OnDatagramsReceived(batch->datagrams.data(),
+                                    batch->datagrams.size());
+    }
+    RecycleDatagramBatch(std::move(received_datagrams_));
+    return;
+  }
+  // The session may be destroyed before the task runs, the batch is dropped
+  // then.
+  TracingUtilities::PostTask(
+      event_runner_, FROM_HERE,
+      "WebTransportServerSession::DeliverReceivedDatagrams",
+      base::BindOnce(
+          [](scoped_refptr<LivenessGuard> guard,
+             WebTransportServerSession* session,
+             std::unique_ptr<ReceivedDatagramBatch> batch) {
+            guard->RunIfAlive(base::BindOnce(
+                &WebTransportServerSession::DeliverReceivedDatagrams,
+                base::Unretained(session), std::move(batch)));
+          },
+          liveness_guard_, base::Unretained(this),
+          std::move(received_datagrams_)));
+}
+
+void WebTransportServerSession::DeliverReceivedDatagrams(
+    std::unique_ptr<ReceivedDatagramBatch> batch) {
+  DCHECK(event_runner_->BelongsToCurrentThread());
+  if (visitor_) {
+    SessionCpuAccount::ScopedEventTimer timer(cpu_account_.get());
+    visitor_->OnDatagramsReceived(batch->datagrams.data(),
+                                  batch->datagrams.size());
+  }
+  io_runner_->PostTask(
+      FROM_HERE,
+      base::BindOnce(&WebTransportServerSession::RecycleDatagramBatch,
+                     io_weak_this_, std::move(batch)));
+}
+
+void WebTransportServerSession::RecycleDatagramBatch(
+    std::unique_ptr<ReceivedDatagramBatch> batch) {
+  DCHECK(io_runner_->BelongsToCurrentThread());
+  if (datagram_batch_pool_.size() >= kMaxPooledDatagramBatches) {
+    return;
+  }
+  // Capacity is kept, so buffers don't need to grow again.
+  batch->buffer.clear();
+  batch->lengths.clear();
+  batch->datagrams.clear();
+  datagram_batch_pool_.push_back(std::move(batch));
+}
+
 }  // namespace quic
 }  // namespace owt
\ No newline at end of file
@@ -11,26 +11,48 @@
 #ifndef OWT_QUIC_WEB_TRANSPORT_WEB_TRANSPORT_SERVER_SESSION_H_
 #define OWT_QUIC_WEB_TRANSPORT_WEB_TRANSPORT_SERVER_SESSION_H_
 
+#include <atomic>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "base/memory/weak_ptr.h"
 #include "base/task/single_thread_task_runner.h"
+#include "impl/connection_stats_snapshot.h"
+#include "impl/datagram_class_queue.h"
 #include "impl/http3_server_session.h"
+#include "impl/liveness_guard.h"
+#include "impl/object_pool.h"
+#include "impl/send_buffer_budget.h"
+#include "impl/session_cpu_account.h"
+#include "impl/warm_stream_pool.h"
+#include "impl/web_transport_stream_impl.h"
 #include "net/third_party/quiche/src/quic/core/http/web_transport_http3.h"
 #include "owt/quic/web_transport_session_interface.h"
 
 namespace owt {
 namespace quic {
 
-class WebTransportStreamImpl;
-
 // A proxy of ::quic::WebTransportHttp3. WebTransport over HTTP/2 is not
-// supported.
+// supported. Sessions are pooled like their streams.
 class WebTransportServerSession : public WebTransportSessionInterface,
-                                  public ::quic::WebTransportVisitor {
+                                  public ::quic::WebTransportVisitor,
+                                  public SendBufferBudget::Delegate,
+                                  public Http3ServerSession::Observer,
+                                  public WebTransportStreamImpl::Delegate,
+                                  public WarmStreamPool::Delegate,
+                                  public PooledObject {
  public:
+  // `server_budget` is the send buffer budget of the server, it could be
+  // nullptr. Datagrams are copied from `send_buffer_allocator` on the
+  // caller's thread. It must outlive this session, nullptr uses a
+  // ::quic::SimpleBufferAllocator.
   explicit WebTransportServerSession(
       ::quic::WebTransportHttp3* session,
       ::quic::QuicSpdySession* http3_session,
       base::SingleThreadTaskRunner* io_runner,
-      base::SingleThreadTaskRunner* event_runner);
+      base::SingleThreadTaskRunner* event_runner,
+      SendBufferBudget* server_budget,
+      ::quic::QuicBufferAllocator* send_buffer_allocator);
   ~WebTransportServerSession() override;
 
   // This method is going to replace ConnectionId();
@@ -41,10 +63,42 @@ class WebTransportServerSession : public WebTransportSessionInterface,
   void SetVisitor(WebTransportSessionInterface::Visitor* visitor) override;
   bool IsSessionReady() const override;
   WebTransportStreamInterface* CreateBidirectionalStream() override;
+  WebTransportStreamInterface* CreateOutgoingUnidirectionalStream() override;
+  size_t CreateBidirectionalStreams(
+      size_t count,
+      WebTransportStreamInterface** streams) override;
+  size_t CreateOutgoingUnidirectionalStreams(
+      size_t count,
+      WebTransportStreamInterface** streams) override;
+  void SetWarmStreamPoolSize(size_t bidirectional,
+                             size_t unidirectional) override;
+  WebTransportStreamInterface* AcquireStream(bool bidirectional) override;
   MessageStatus SendOrQueueDatagram(uint8_t* data, size_t length) override;
-  // TODO: This method is not implemented.
-  const ConnectionStats& GetStats() override;
+  MessageStatus SendOrQueueDatagram(uint8_t* data,
+                                    size_t length,
+                                    BufferReleaseCallback release,
+                                    void* release_context) override;
+  void SendOrQueueDatagramAsync(uint8_t* data, size_t length) override;
+  void SendOrQueueDatagrams(const Datagram* batch,
+                            size_t count,
+                            MessageStatus* results) override;
+  void SetDatagramBatchingEnabled(bool enabled) override;
+  void SetBandwidthEstimateHysteresis(uint32_t percent) override;
+  void SetMaxDatagramTimeInQueue(uint32_t max_time_ms) override;
+  void SetDatagramPriority(DatagramPriority priority) override;
+  void SetDatagramClasses(const DatagramClassOptions* classes,
+                          size_t count) override;
+  MessageStatus SendOrQueuePrioritizedDatagram(
+      uint8_t* data,
+      size_t length,
+      uint32_t priority_class) override;
+  void SetMaxSendRate(uint64_t bits_per_second) override;
+  void SetKeepAlive(uint32_t interval_ms, uint32_t idle_timeout_ms) override;
+  size_t GetMaxDatagramSize() const override;
+  ConnectionStats GetStats() override;
+  MemoryUsage GetMemoryUsage() override;
   void Close(uint32_t code, const char* reason) override;
+  void SetSendBufferBudget(uint64_t bytes) override;
 
   // Overrides ::quic::WebTransportVisitor.
   void OnSessionReady(const spdy::SpdyHeaderBlock& headers) override {}
@@ -53,24 +107,160 @@ class WebTransportServerSession : public WebTransportSessionInterface,
   void OnIncomingBidirectionalStreamAvailable() override;
   void OnIncomingUnidirectionalStreamAvailable() override;
   void OnDatagramReceived(absl::string_view datagram) override;
-  void OnCanCreateNewOutgoingUnidirectionalStream() override {}
-  void OnCanCreateNewOutgoingBidirectionalStream() override {}
+  void OnCanCreateNewOutgoingUnidirectionalStream() override;
+  void OnCanCreateNewOutgoingBidirectionalStream() override;
+
+  // Overrides SendBufferBudget::Delegate.
+  void OnSendBufferBudgetAvailable() override;
+
+  // Overrides Http3ServerSession::Observer.
+  void OnDatagramProcessed(
+      absl::optional<::quic::MessageStatus> status) override;
+  void OnCongestionWindowChange() override;
+  void OnCanSendDatagrams() override;
+  bool HasQueuedDatagrams() const override;
+  // The session is closed if it's not, and stops using the native sessions.
+  void OnSessionDestroyed() override;
+
+  // Overrides WebTransportStreamImpl::Delegate.
+  void OnStreamClosed(uint32_t id) override;
+
+  // Overrides WarmStreamPool::Delegate.
+  WebTransportStreamInterface* OpenWarmStream(bool bidirectional) override;
 
   void AcceptIncomingStream(::quic::WebTransportStream* stream);
 
+  // While `overloaded` is true, received datagrams are dropped unless
+  // datagrams of this session are prioritized over streams.
+  void SetOverloadedOnCurrentThread(bool overloaded);
+
+  // Thread time of this session's connection, shared by other sessions on
+  // it. nullptr if CPU accounting is not enabled.
+  SessionCpuAccount* cpu_account() const { return cpu_account_.get(); }
+  bool session_closed() const { return session_closed_; }
+
+  // Adds memory held by this session and its streams to `usage`.
+  void AddMemoryUsageOnCurrentThread(MemoryUsage* usage) const;
+
+  // Status is reported by Visitor::OnDatagramProcessed.
+  void SendOrQueueDatagramOnCurrentThread(::quic::QuicMemSlice slice);
+  // Writes `slice` to stream `stream_id`. `slice` is dropped if the stream
+  // doesn't exist.
+  void WriteToStreamOnCurrentThread(uint32_t stream_id,
+                                    ::quic::QuicMemSlice slice);
+
  protected:
-  WebTransportStreamInterface* CreateBidirectionalStreamOnCurrentThread();
+  WebTransportStreamInterface* CreateOutgoingStreamOnCurrentThread(
+      bool bidirectional);
 
  private:
+  WebTransportStreamInterface* CreateOutgoingStream(bool bidirectional);
+  size_t CreateOutgoingStreams(bool bidirectional,
+                               size_t count,
+                               WebTransportStreamInterface** streams);
+  size_t CreateOutgoingStreamsOnCurrentThread(
+      bool bidirectional,
+      size_t count,
+      WebTransportStreamInterface** streams);
+  // Creates a WebTransportStreamImpl for `stream` and takes its ownership.
+  WebTransportStreamImpl* OwtStreamForNativeStream(
+      ::quic::WebTransportStream* stream);
+
+  // Received datagrams stored in a single buffer.
+  struct ReceivedDatagramBatch {
+    std::vector<uint8_t> buffer;
+    std::vector<size_t> lengths;
+    std::vector<Datagram> datagrams;
+  };
+
+  MessageStatus SendOrQueueDatagram(::quic::QuicMemSlice slice);
+  // All datagrams of this session are sent by this method, so their status is
+  // reported to this session even if other sessions share the connection.
+  ::quic::MessageStatus SendDatagramOnCurrentThread(::quic::QuicMemSlice slice);
+  void SendOrQueueDatagramsOnCurrentThread(
+      std::vector<::quic::QuicMemSlice> slices,
+      MessageStatus* results);
   void CloseOnCurrentThread(uint32_t code, const char* reason);
+  void SetSendBufferBudgetOnCurrentThread(uint64_t bytes);
+  void SetDatagramBatchingEnabledOnCurrentThread(bool enabled);
+  // Publishes connection stats to `stats_snapshot_`, and schedules next
+  // publish.
+  void PublishStatsOnCurrentThread();
+  void SetBandwidthEstimateHysteresisOnCurrentThread(uint32_t percent);
+  void SetMaxDatagramTimeInQueueOnCurrentThread(uint32_t max_time_ms);
+  void SetDatagramPriorityOnCurrentThread(DatagramPriority priority);
+  void SetDatagramClassesOnCurrentThread(
+      std::vector<DatagramClassOptions> classes);
+  MessageStatus SendOrQueuePrioritizedDatagramOnCurrentThread(
+      ::quic::QuicMemSlice slice,
+      uint32_t priority_class);
+  // Reports datagrams dropped by `datagram_classes_` as expired.
+  void ReportQueuedDatagramDropsOnCurrentThread();
+  void SetMaxSendRateOnCurrentThread(uint64_t bits_per_second);
+  void SetKeepAliveOnCurrentThread(uint32_t interval_ms,
+                                   uint32_t idle_timeout_ms);
+  void SetWarmStreamPoolSizeOnCurrentThread(size_t bidirectional,
+                                            size_t unidirectional);
+  void RefillWarmStreamPoolOnCurrentThread();
+  // Updates `max_datagram_size_`, and notifies visitor if it changes.
+  void UpdateMaxDatagramSizeOnCurrentThread();
+  // Hands `received_datagrams_` to event thread.
+  void FlushReceivedDatagrams();
+  // Runs on event thread while `liveness_guard_` is held.
+  void DeliverReceivedDatagrams(std::unique_ptr<ReceivedDatagramBatch> batch);
+  // Returns `batch` to `datagram_batch_pool_`.
+  void RecycleDatagramBatch(std::unique_ptr<ReceivedDatagramBatch> batch);
 
+  // Both are nullptr after OnSessionDestroyed().
   ::quic::WebTransportHttp3* session_;
   ::quic::QuicSpdySession* http3_session_;
+  const uint64_t session_id_;
+  // Outlives the connection, so methods called on other threads don't access
+  // the connection's helper. Not owned.
+  ::quic::QuicBufferAllocator* const send_buffer_allocator_;
   base::SingleThreadTaskRunner* io_runner_;
   base::SingleThreadTaskRunner* event_runner_;
-  std::vector<std::unique_ptr<WebTransportStreamImpl>> streams_;
+  // String representation of connection ID. It's computed once, so
+  // ConnectionId() doesn't allocate.
+  const std::string connection_id_;
+  // Keeps the account after the connection is destroyed, since visitor
+  // callbacks may still run on event thread.
+  const scoped_refptr<SessionCpuAccount> cpu_account_;
+  // Must outlive `streams_`.
+  SendBufferBudget send_buffer_budget_;
+  // Live streams. Key is stream ID.
+  std::unordered_map<uint32_t, std::unique_ptr<WebTransportStreamImpl>>
+      streams_;
+  // Holds streams of `streams_`, so it's cleared before them.
+  WarmStreamPool warm_stream_pool_;
   WebTransportSessionInterface::Visitor* visitor_;
-  ConnectionStats stats_;
+  ConnectionStatsSnapshot stats_snapshot_;
+  // Following members are only accessed on IO thread.
+  // `http3_session_` should not be accessed after session is closed.
+  bool session_closed_;
+  bool stats_publish_scheduled_;
+  uint64_t datagrams_dropped_;
+  uint32_t bandwidth_estimate_hysteresis_percent_;
+  // Bandwidth estimate reported by last OnBandwidthEstimateUpdated call.
+  uint64_t last_reported_bandwidth_;
+  bool datagram_batching_enabled_;
+  bool datagram_flush_scheduled_;
+  // Also decides whether received datagrams are shed under overload.
+  DatagramPriority datagram_priority_;
+  // Datagrams sent by SendOrQueuePrioritizedDatagram while the connection is
+  // blocked.
+  DatagramClassQueue datagram_classes_;
+  bool overloaded_;
+  // Written on IO thread, read by GetMaxDatagramSize on any thread.
+  std::atomic<size_t> max_datagram_size_;
+  std::unique_ptr<ReceivedDatagramBatch> received_datagrams_;
+  std::vector<std::unique_ptr<ReceivedDatagramBatch>> datagram_batch_pool_;
+  // Invalidated by the destructor, so event thread tasks skip a destroyed
+  // session. WeakPtrs of `weak_factory_` are only dereferenced on IO thread.
+  const scoped_refptr<LivenessGuard> liveness_guard_;
+  // Created on IO thread, so event thread can post tasks to IO thread with it.
+  base::WeakPtr<WebTransportServerSession> io_weak_this_;
+  base::WeakPtrFactory<WebTransportServerSession> weak_factory_{this};
 };
 }  // namespace quic
 }  // namespace owt
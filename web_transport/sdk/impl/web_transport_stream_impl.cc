@@ -13,71 +13,245 @@
 // with modifications.
 
 #include "impl/web_transport_stream_impl.h"
+#include <algorithm>
+#include <cstring>
 #include "base/logging.h"
+#include "base/numerics/safe_conversions.h"
 #include "base/synchronization/waitable_event.h"
+#include "base/task/task_runner_util.h"
+#include "base/task/thread_pool.h"
+#include "base/trace_event/trace_event.h"
+#include "impl/async_logger.h"
+#include "impl/metrics.h"
+#include "impl/tracing.h"
 #include "net/third_party/quiche/src/quic/core/http/web_transport_stream_adapter.h"
+#include "net/third_party/quiche/src/quic/core/quic_connection.h"
+#include "net/third_party/quiche/src/quic/core/quic_session.h"
+#include "owt/web_transport/sdk/impl/utilities.h"
+#if defined(OS_WIN)
+#include <io.h>
+#include <windows.h>
+#else
+#include <unistd.h>
+#include "base/posix/eintr_wrapper.h"
+#endif
 
 namespace owt {
 namespace quic {
 
+namespace {
+// Size of data read from a file passed to WriteFile at a time. QUIC stream
+// stops accepting data once it buffers more than its threshold, so it's also
+// roughly the data of a file in memory.
+const size_t kFileChunkSize = 64 * 1024;
+
+// Reads exactly `length` bytes at `offset` of `fd`. Returns false on errors or
+// end of file.
+bool ReadFileAt(int fd, uint64_t offset, char* data, size_t length) {
+  while (length > 0) {
+#if defined(OS_WIN)
+    HANDLE handle = reinterpret_cast<HANDLE>(_get_osfhandle(fd));
+    OVERLAPPED overlapped = {};
+    overlapped.Offset = static_cast<DWORD>(offset);
+    overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+    DWORD bytes_read = 0;
+    if (handle == INVALID_HANDLE_VALUE ||
+        !::ReadFile(handle, data, base::saturated_cast<DWORD>(length),
+                    &bytes_read, &overlapped)) {
+      return false;
+    }
+#else
+    const ssize_t bytes_read = HANDLE_EINTR(
+        pread(fd, data, length, static_cast<off_t>(offset)));
+    if (bytes_read < 0) {
+      return false;
+    }
+#endif
+    if (bytes_read == 0) {
+      return false;
+    }
+    offset += bytes_read;
+    data += bytes_read;
+    length -= bytes_read;
+  }
+  return true;
+}
+}  // namespace
+
+// A duplicate of a file descriptor passed to WriteFile. Reads in progress hold
+// references, so it's closed after the last read even if the write is dropped
+// while a chunk is being read.
+class WebTransportStreamImpl::FileSource
+    : public base::RefCountedThreadSafe<FileSource> {
+ public:
+  // Returns nullptr if `fd` can't be duplicated.
+  static scoped_refptr<FileSource> Duplicate(int fd) {
+#if defined(OS_WIN)
+    const int duplicate = _dup(fd);
+#else
+    const int duplicate = HANDLE_EINTR(dup(fd));
+#endif
+    if (duplicate < 0) {
+      return nullptr;
+    }
+    return base::WrapRefCounted(new FileSource(duplicate));
+  }
+
+  // Reads `length` bytes at `offset` into `chunk`. Runs on a task runner which
+  // may block.
+  static bool ReadChunk(scoped_refptr<FileSource> file,
+                        uint64_t offset,
+                        scoped_refptr<net::IOBuffer> chunk,
+                        size_t length) {
+    return ReadFileAt(file->fd_, offset, chunk->data(), length);
+  }
+
+ private:
+  friend class base::RefCountedThreadSafe<FileSource>;
+
+  explicit FileSource(int fd) : fd_(fd) {}
+  ~FileSource() {
+#if defined(OS_WIN)
+    _close(fd_);
+#else
+    IGNORE_EINTR(close(fd_));
+#endif
+  }
+
+  const int fd_;
+};
+
+// Forwards events to WebTransportStreamImpl. It's owned by the QUIC stream, so
+// it may outlive the WebTransportStreamImpl.
 class WebTransportStreamVisitorAdapter
-    : public ::quic::WebTransportStreamVisitor {
+    : public ::quic::WebTransportStreamVisitor,
+      public PooledObject {
  public:
   explicit WebTransportStreamVisitorAdapter(
-      ::quic::WebTransportStreamVisitor* visitor)
-      : visitor_(visitor) {}
-  void OnCanRead() override { visitor_->OnCanRead(); }
-  void OnCanWrite() override { visitor_->OnCanWrite(); }
+      base::WeakPtr<WebTransportStreamImpl> stream)
+      : stream_(stream) {}
+  // The QUIC stream is destroyed after both directions are finished.
+  ~WebTransportStreamVisitorAdapter() override {
+    if (stream_) {
+      stream_->OnQuicStreamDestroyed();
+    }
+  }
+  void OnCanRead() override {
+    if (stream_) {
+      stream_->OnCanRead();
+    }
+  }
+  void OnCanWrite() override {
+    if (stream_) {
+      stream_->OnCanWrite();
+    }
+  }
   void OnResetStreamReceived(::quic::WebTransportStreamError error) override {
-    LOG(INFO)<<"OnResetStream received.";
-    if (visitor_) {
-      visitor_->OnResetStreamReceived(error);
+    OWT_ASYNC_LOG(INFO) << "OnResetStream received.";
+    if (stream_) {
+      stream_->OnResetStreamReceived(error);
     }
   }
   void OnStopSendingReceived(::quic::WebTransportStreamError error) override {
-    if (visitor_) {
-      visitor_->OnStopSendingReceived(error);
+    if (stream_) {
+      stream_->OnStopSendingReceived(error);
+    }
+  }
+  void OnWriteSideInDataRecvdState() override {
+    if (stream_) {
+      stream_->OnWriteSideInDataRecvdState();
     }
   }
-  void OnWriteSideInDataRecvdState() override {}
 
  private:
-  ::quic::WebTransportStreamVisitor* visitor_;
+  base::WeakPtr<WebTransportStreamImpl> stream_;
 };
 
 WebTransportStreamImpl::WebTransportStreamImpl(
     ::quic::WebTransportStream* stream,
     ::quic::QuicStream* quic_stream,
     base::SingleThreadTaskRunner* io_runner,
-    base::SingleThreadTaskRunner* event_runner)
+    base::SingleThreadTaskRunner* event_runner,
+    SendBufferBudget* send_buffer_budget)
     : stream_(stream),
       quic_stream_(quic_stream),
+      id_(0),
       io_runner_(io_runner),
       event_runner_(event_runner),
       visitor_(nullptr),
-      write_side_closed_(false) {
+      delegate_(nullptr),
+      cpu_account_(nullptr),
+      receive_window_tuner_(nullptr),
+      write_side_closed_(false),
+      write_side_acknowledged_(false),
+      send_deadline_id_(0),
+      pending_write_bytes_(0),
+      pending_file_writes_(0),
+      next_file_write_id_(0),
+      fin_pending_(false),
+      push_mode_enabled_(false),
+      fin_delivered_(false),
+      receive_ring_(nullptr),
+      receive_ring_watermark_(0),
+      coalescing_threshold_(0),
+      coalescing_flush_scheduled_(false),
+      flush_requested_(false),
+      high_watermark_(0),
+      low_watermark_(0),
+      above_high_watermark_(false),
+      send_buffer_budget_(send_buffer_budget),
+      budget_reported_bytes_(0),
+      cached_readable_bytes_(0),
+      cached_buffered_data_bytes_(0),
+      cached_can_write_(false) {
   CHECK(stream_);
   CHECK(quic_stream_);
   CHECK(io_runner_);
   CHECK(event_runner_);
-  stream_->SetVisitor(std::make_unique<WebTransportStreamVisitorAdapter>(this));
+  id_ = stream_->GetStreamId();
+  stream_->SetVisitor(std::make_unique<WebTransportStreamVisitorAdapter>(
+      weak_factory_.GetWeakPtr()));
+  UpdateCachedStateOnCurrentThread();
+  MetricsRegistry::Increment(MetricCounter::kStreamsOpened);
 }
 
-WebTransportStreamImpl::~WebTransportStreamImpl() {}
+WebTransportStreamImpl::~WebTransportStreamImpl() {
+  MetricsRegistry::Increment(MetricCounter::kStreamsClosed);
+  if (send_buffer_budget_) {
+    send_buffer_budget_->Remove(budget_reported_bytes_);
+  }
+}
 
 uint32_t WebTransportStreamImpl::Id() const {
-  return stream_->GetStreamId();
+  return id_;
+}
+
+void WebTransportStreamImpl::SetDelegate(Delegate* delegate) {
+  delegate_ = delegate;
+}
+
+void WebTransportStreamImpl::SetCpuAccount(SessionCpuAccount* account) {
+  cpu_account_ = account;
+}
+
+void WebTransportStreamImpl::SetReceiveWindowTuner(ReceiveWindowTuner* tuner) {
+  receive_window_tuner_ = tuner;
+}
+
+void WebTransportStreamImpl::OnBytesConsumed(size_t bytes) {
+  DCHECK(io_runner_->BelongsToCurrentThread());
+  if (receive_window_tuner_ && quic_stream_) {
+    receive_window_tuner_->OnBytesConsumed(quic_stream_, bytes);
+  }
 }
 
 size_t WebTransportStreamImpl::Write(const uint8_t* data, size_t length) {
   DCHECK_EQ(sizeof(uint8_t), sizeof(char));
+  TRACE_EVENT1(OWT_TRACE_CATEGORY, "WebTransportStreamImpl::Write", "length",
+               length);
   CHECK(io_runner_);
   if (io_runner_->BelongsToCurrentThread()) {
-    if (write_side_closed_) {
-      return 0;
-    }
-    return stream_->Write(
-        absl::string_view(reinterpret_cast<const char*>(data), length));
+    return WriteOnCurrentThread(data, length) ? length : 0;
   }
   bool result = false;
   base::WaitableEvent done(base::WaitableEvent::ResetPolicy::AUTOMATIC,
@@ -87,16 +261,11 @@ size_t WebTransportStreamImpl::Write(const uint8_t* data, size_t length) {
       base::BindOnce(
           [](base::WeakPtr<WebTransportStreamImpl> stream, const uint8_t* data,
              size_t& length, bool& result, base::WaitableEvent* event) {
-            if (!stream || stream->write_side_closed_) {
+            if (!stream) {
               event->Signal();
               return;
             }
-            if (stream->stream_->CanWrite()) {
-              result = stream->stream_->Write(absl::string_view(
-                  reinterpret_cast<const char*>(data), length));
-            } else {
-              result = false;
-            }
+            result = stream->WriteOnCurrentThread(data, length);
             event->Signal();
           },
           weak_factory_.GetWeakPtr(), base::Unretained(data), std::ref(length),
@@ -105,6 +274,476 @@ size_t WebTransportStreamImpl::Write(const uint8_t* data, size_t length) {
   return result ? length : 0;
 }
 
+bool WebTransportStreamImpl::WriteOnCurrentThread(const uint8_t* data,
+                                                  size_t length) {
+  DCHECK(io_runner_->BelongsToCurrentThread());
+  SessionCpuAccount::ScopedIoTimer timer(cpu_account_);
+  // Data queued by WriteAsync must be written first.
+  if (fin_pending_ || !CanWrite()) {
+    return false;
+  }
+  if (coalescing_threshold_ > 0) {
+    ::quic::QuicBuffer buffer = ::quic::QuicBuffer::Copy(
+        GetSendBufferAllocator(),
+        absl::string_view(reinterpret_cast<const char*>(data), length));
+    EnqueuePendingWriteOnCurrentThread(
+        ::quic::QuicMemSlice(std::move(buffer)), false);
+    return true;
+  }
+  bool result = stream_->Write(
+      absl::string_view(reinterpret_cast<const char*>(data), length));
+  UpdateCachedStateOnCurrentThread();
+  return result;
+}
+
+::quic::QuicBufferAllocator* WebTransportStreamImpl::GetSendBufferAllocator()
+    const {
+  DCHECK(quic_stream_->session() && quic_stream_->session()->connection() &&
+         quic_stream_->session()->connection()->helper());
+  return quic_stream_->session()
+      ->connection()
+      ->helper()
+      ->GetStreamSendBufferAllocator();
+}
+
+void WebTransportStreamImpl::WriteAsync(const uint8_t* data, size_t length) {
+  DCHECK_EQ(sizeof(uint8_t), sizeof(char));
+  ::quic::QuicBuffer buffer = ::quic::QuicBuffer::Copy(
+      GetSendBufferAllocator(),
+      absl::string_view(reinterpret_cast<const char*>(data), length));
+  WriteMemSliceAsync(::quic::QuicMemSlice(std::move(buffer)), false);
+}
+
+void WebTransportStreamImpl::WriteAsync(uint8_t* data,
+                                        size_t length,
+                                        BufferReleaseCallback release,
+                                        void* release_context) {
+  WriteMemSliceAsync(Utilities::CreateMemSliceForExternalBuffer(
+                         data, length, release, release_context),
+                     false);
+}
+
+void WebTransportStreamImpl::Writev(const IoVec* iov, size_t iovcnt, bool fin) {
+  size_t total_length = 0;
+  for (size_t i = 0; i < iovcnt; i++) {
+    total_length += iov[i].length;
+  }
+  if (total_length == 0) {
+    WriteMemSliceAsync(::quic::QuicMemSlice(), fin);
+    return;
+  }
+  // Gather all pieces into a single buffer, so they are handed to QUIC stream
+  // as a single write.
+  ::quic::QuicBuffer buffer(GetSendBufferAllocator(), total_length);
+  char* dest = buffer.data();
+  for (size_t i = 0; i < iovcnt; i++) {
+    if (iov[i].length == 0) {
+      continue;
+    }
+    memcpy(dest, iov[i].data, iov[i].length);
+    dest += iov[i].length;
+  }
+  WriteMemSliceAsync(::quic::QuicMemSlice(std::move(buffer)), fin);
+}
+
+void WebTransportStreamImpl::WriteFile(int fd,
+                                       uint64_t offset,
+                                       uint64_t length,
+                                       bool fin) {
+  if (io_runner_->BelongsToCurrentThread()) {
+    WriteFileOnCurrentThread(fd, offset, length, fin);
+    return;
+  }
+  io_runner_->PostTask(
+      FROM_HERE,
+      base::BindOnce(&WebTransportStreamImpl::WriteFileOnCurrentThread,
+                     weak_factory_.GetWeakPtr(), fd, offset, length, fin));
+}
+
+void WebTransportStreamImpl::WriteFileOnCurrentThread(int fd,
+                                                      uint64_t offset,
+                                                      uint64_t length,
+                                                      bool fin) {
+  DCHECK(io_runner_->BelongsToCurrentThread());
+  SessionCpuAccount::ScopedIoTimer timer(cpu_account_);
+  TRACE_EVENT1(OWT_TRACE_CATEGORY, "WebTransportStreamImpl::WriteFile",
+               "length", length);
+  if (write_side_closed_ || fin_pending_ || fd < 0) {
+    if (visitor_) {
+      visitor_->OnWriteCompleted(static_cast<size_t>(length), false);
+    }
+    return;
+  }
+  if (length == 0) {
+    if (visitor_) {
+      visitor_->OnWriteCompleted(0, true);
+    }
+  } else {
+    scoped_refptr<FileSource> file = FileSource::Duplicate(fd);
+    if (!file) {
+      LOG(ERROR) << "Failed to duplicate file " << fd << ".";
+      if (visitor_) {
+        visitor_->OnWriteCompleted(static_cast<size_t>(length), false);
+      }
+      return;
+    }
+    if (!file_task_runner_) {
+      file_task_runner_ = base::ThreadPool::CreateSequencedTaskRunner(
+          {base::MayBlock(), base::TaskPriority::USER_BLOCKING});
+    }
+    PendingWrite write{::quic::QuicMemSlice(), true};
+    write.file = std::move(file);
+    write.file_write_id = next_file_write_id_++;
+    write.file_offset = offset;
+    write.file_remaining = length;
+    write.file_length = length;
+    pending_file_writes_++;
+    pending_writes_.push_back(std::move(write));
+    // The first chunk is read while earlier writes are flushed.
+    ReadFileChunkOnCurrentThread(&pending_writes_.back());
+    MaybeFlushPendingWritesOnCurrentThread();
+  }
+  if (fin) {
+    SendFinOnCurrentThread();
+  }
+}
+
+void WebTransportStreamImpl::ReadFileChunkOnCurrentThread(
+    PendingWrite* write) {
+  DCHECK(io_runner_->BelongsToCurrentThread());
+  if (write->file_chunk || write->file_read_pending ||
+      write->file_remaining == 0) {
+    return;
+  }
+  const size_t length = static_cast<size_t>(
+      std::min<uint64_t>(write->file_remaining, kFileChunkSize));
+  auto chunk = base::MakeRefCounted<net::IOBuffer>(length);
+  write->file_read_pending = true;
+  base::PostTaskAndReplyWithResult(
+      file_task_runner_.get(), FROM_HERE,
+      base::BindOnce(&FileSource::ReadChunk, write->file, write->file_offset,
+                     chunk, length),
+      base::BindOnce(&WebTransportStreamImpl::OnFileChunkRead,
+                     weak_factory_.GetWeakPtr(), write->file_write_id,
+                     chunk));
+}
+
+void WebTransportStreamImpl::OnFileChunkRead(
+    uint64_t file_write_id,
+    scoped_refptr<net::IOBuffer> chunk,
+    bool success) {
+  DCHECK(io_runner_->BelongsToCurrentThread());
+  auto it = std::find_if(pending_writes_.begin(), pending_writes_.end(),
+                         [file_write_id](const PendingWrite& write) {
+                           return write.file &&
+                                  write.file_write_id == file_write_id;
+                         });
+  if (it == pending_writes_.end()) {
+    // Dropped while the chunk was being read.
+    return;
+  }
+  it->file_read_pending = false;
+  if (!success) {
+    LOG(ERROR) << "Failed to read file at " << it->file_offset << ".";
+    // The peer must not take truncated data as complete. Resetting drops
+    // pending writes, which completes this one with failure.
+    ResetOnCurrentThread(0);
+    return;
+  }
+  it->file_chunk = std::move(chunk);
+  FlushPendingWritesOnCurrentThread();
+}
+
+bool WebTransportStreamImpl::WriteFileChunkOnCurrentThread(
+    PendingWrite* write) {
+  DCHECK(io_runner_->BelongsToCurrentThread());
+  DCHECK_GT(write->file_remaining, 0u);
+  DCHECK(write->file_chunk);
+  const size_t length = static_cast<size_t>(
+      std::min<uint64_t>(write->file_remaining, kFileChunkSize));
+  ::quic::QuicMemSlice slice = Utilities::CreateMemSliceForSharedBuffer(
+      std::move(write->file_chunk), length);
+  ::quic::QuicConsumedData consumed = quic_stream_->WriteMemSlices(
+      absl::MakeSpan(&slice, 1), /*fin=*/false);
+  if (consumed.bytes_consumed != length) {
+    return false;
+  }
+  write->file_offset += length;
+  write->file_remaining -= length;
+  return true;
+}
+
+void WebTransportStreamImpl::WriteMemSliceAsync(::quic::QuicMemSlice slice,
+                                                bool fin) {
+  if (io_runner_->BelongsToCurrentThread()) {
+    WriteAsyncOnCurrentThread(std::move(slice), fin);
+    return;
+  }
+  io_runner_->PostTask(
+      FROM_HERE,
+      base::BindOnce(&WebTransportStreamImpl::WriteAsyncOnCurrentThread,
+                     weak_factory_.GetWeakPtr(), std::move(slice), fin));
+}
+
+void WebTransportStreamImpl::WriteAsyncOnCurrentThread(
+    ::quic::QuicMemSlice slice,
+    bool fin) {
+  DCHECK(io_runner_->BelongsToCurrentThread());
+  SessionCpuAccount::ScopedIoTimer timer(cpu_account_);
+  TRACE_EVENT1(OWT_TRACE_CATEGORY, "WebTransportStreamImpl::WriteAsync",
+               "length", slice.length());
+  // Writes are refused when the budget is exceeded, so a stalled client cannot
+  // make the server buffer unlimited data.
+  if (write_side_closed_ || fin_pending_ ||
+      (!slice.empty() && IsSendBufferBudgetExceeded())) {
+    if (visitor_) {
+      visitor_->OnWriteCompleted(slice.length(), false);
+    }
+    return;
+  }
+  if (slice.empty()) {
+    if (visitor_) {
+      visitor_->OnWriteCompleted(0, true);
+    }
+  } else {
+    EnqueuePendingWriteOnCurrentThread(std::move(slice), true);
+  }
+  if (fin) {
+    SendFinOnCurrentThread();
+  }
+}
+
+void WebTransportStreamImpl::EnqueuePendingWriteOnCurrentThread(
+    ::quic::QuicMemSlice slice,
+    bool notify_completion) {
+  DCHECK(io_runner_->BelongsToCurrentThread());
+  pending_write_bytes_ += slice.length();
+  pending_writes_.push_back(PendingWrite{std::move(slice), notify_completion});
+  MaybeFlushPendingWritesOnCurrentThread();
+}
+
+void WebTransportStreamImpl::MaybeFlushPendingWritesOnCurrentThread() {
+  DCHECK(io_runner_->BelongsToCurrentThread());
+  if (coalescing_threshold_ == 0 || flush_requested_ || fin_pending_ ||
+      pending_file_writes_ > 0 ||
+      pending_write_bytes_ >= coalescing_threshold_) {
+    FlushPendingWritesOnCurrentThread();
+    return;
+  }
+  // Data is kept for coalescing. Schedule a flush if it's not scheduled yet.
+  if (pending_writes_.empty() || coalescing_delay_.is_zero() ||
+      coalescing_flush_scheduled_) {
+    return;
+  }
+  coalescing_flush_scheduled_ = true;
+  io_runner_->PostDelayedTask(
+      FROM_HERE,
+      base::BindOnce(&WebTransportStreamImpl::OnCoalescingDelayExpired,
+                     weak_factory_.GetWeakPtr()),
+      coalescing_delay_);
+}
+
+void WebTransportStreamImpl::OnCoalescingDelayExpired() {
+  DCHECK(io_runner_->BelongsToCurrentThread());
+  coalescing_flush_scheduled_ = false;
+  if (pending_writes_.empty()) {
+    return;
+  }
+  flush_requested_ = true;
+  FlushPendingWritesOnCurrentThread();
+}
+
+void WebTransportStreamImpl::SetWriteCoalescing(size_t threshold,
+                                                uint32_t delay_ms) {
+  if (io_runner_->BelongsToCurrentThread()) {
+    SetWriteCoalescingOnCurrentThread(threshold, delay_ms);
+    return;
+  }
+  io_runner_->PostTask(
+      FROM_HERE,
+      base::BindOnce(&WebTransportStreamImpl::SetWriteCoalescingOnCurrentThread,
+                     weak_factory_.GetWeakPtr(), threshold, delay_ms));
+}
+
+void WebTransportStreamImpl::SetWriteCoalescingOnCurrentThread(
+    size_t threshold,
+    uint32_t delay_ms) {
+  DCHECK(io_runner_->BelongsToCurrentThread());
+  coalescing_threshold_ = threshold;
+  coalescing_delay_ = base::Milliseconds(delay_ms);
+  MaybeFlushPendingWritesOnCurrentThread();
+}
+
+void WebTransportStreamImpl::Flush() {
+  if (io_runner_->BelongsToCurrentThread()) {
+    FlushOnCurrentThread();
+    return;
+  }
+  io_runner_->PostTask(
+      FROM_HERE, base::BindOnce(&WebTransportStreamImpl::FlushOnCurrentThread,
+                                weak_factory_.GetWeakPtr()));
+}
+
+void WebTransportStreamImpl::FlushOnCurrentThread() {
+  DCHECK(io_runner_->BelongsToCurrentThread());
+  if (pending_writes_.empty()) {
+    return;
+  }
+  flush_requested_ = true;
+  FlushPendingWritesOnCurrentThread();
+}
+
+void WebTransportStreamImpl::SetPriority(uint8_t urgency) {
+  if (io_runner_->BelongsToCurrentThread()) {
+    SetPriorityOnCurrentThread(urgency);
+    return;
+  }
+  io_runner_->PostTask(
+      FROM_HERE,
+      base::BindOnce(&WebTransportStreamImpl::SetPriorityOnCurrentThread,
+                     weak_factory_.GetWeakPtr(), urgency));
+}
+
+void WebTransportStreamImpl::SetPriorityOnCurrentThread(uint8_t urgency) {
+  DCHECK(io_runner_->BelongsToCurrentThread());
+  if (write_side_closed_) {
+    return;
+  }
+  spdy::SpdyPriority priority = std::min<spdy::SpdyPriority>(
+      static_cast<spdy::SpdyPriority>(urgency), spdy::kV3LowestPriority);
+  // QuicStream::SetPriority also updates the session's write blocked list.
+  quic_stream_->SetPriority(spdy::SpdyStreamPrecedence(priority));
+}
+
+void WebTransportStreamImpl::SetBufferWatermarks(uint64_t high,
+                                                 uint64_t low) {
+  if (io_runner_->BelongsToCurrentThread()) {
+    SetBufferWatermarksOnCurrentThread(high, low);
+    return;
+  }
+  io_runner_->PostTask(
+      FROM_HERE,
+      base::BindOnce(
+          &WebTransportStreamImpl::SetBufferWatermarksOnCurrentThread,
+          weak_factory_.GetWeakPtr(), high, low));
+}
+
+void WebTransportStreamImpl::SetBufferWatermarksOnCurrentThread(uint64_t high,
+                                                                uint64_t low) {
+  DCHECK(io_runner_->BelongsToCurrentThread());
+  DCHECK(high == 0 || low < high);
+  high_watermark_ = high;
+  low_watermark_ = std::min(low, high);
+  UpdateCachedStateOnCurrentThread();
+}
+
+void WebTransportStreamImpl::CheckBufferWatermarksOnCurrentThread() {
+  DCHECK(io_runner_->BelongsToCurrentThread());
+  if (high_watermark_ == 0) {
+    if (above_high_watermark_) {
+      above_high_watermark_ = false;
+      if (visitor_) {
+        visitor_->OnBufferLow();
+      }
+    }
+    return;
+  }
+  const uint64_t buffered = BufferedDataBytes();
+  if (!above_high_watermark_ && buffered >= high_watermark_) {
+    above_high_watermark_ = true;
+    if (visitor_) {
+      visitor_->OnBufferHigh();
+    }
+  } else if (above_high_watermark_ && buffered <= low_watermark_) {
+    above_high_watermark_ = false;
+    if (visitor_) {
+      visitor_->OnBufferLow();
+    }
+  }
+}
+
+void WebTransportStreamImpl::FlushPendingWritesOnCurrentThread() {
+  DCHECK(io_runner_->BelongsToCurrentThread());
+  SessionCpuAccount::ScopedIoTimer timer(cpu_account_);
+  if (!pending_writes_.empty() && !write_side_closed_) {
+    // Bundle all writes into as few packets as possible.
+    ::quic::QuicConnection::ScopedPacketFlusher flusher(
+        quic_stream_->session()->connection());
+    while (!pending_writes_.empty() && !write_side_closed_ &&
+           stream_->CanWrite()) {
+      if (pending_writes_.front().file) {
+        PendingWrite& file_write = pending_writes_.front();
+        if (!file_write.file_chunk) {
+          // Writing continues once the chunk is read.
+          ReadFileChunkOnCurrentThread(&file_write);
+          break;
+        }
+        if (!WriteFileChunkOnCurrentThread(&file_write)) {
+          // Resetting drops pending writes, which completes this one with
+          // failure.
+          ResetOnCurrentThread(0);
+          break;
+        }
+        if (file_write.file_remaining > 0) {
+          ReadFileChunkOnCurrentThread(&file_write);
+          continue;
+        }
+        const size_t length = static_cast<size_t>(file_write.file_length);
+        pending_writes_.pop_front();
+        pending_file_writes_--;
+        if (visitor_) {
+          visitor_->OnWriteCompleted(length, true);
+        }
+        continue;
+      }
+      PendingWrite write = std::move(pending_writes_.front());
+      pending_writes_.pop_front();
+      const size_t length = write.slice.length();
+      pending_write_bytes_ -= length;
+      // Write to `quic_stream_` directly, so the slice is moved into stream's
+      // send buffer without copying.
+      ::quic::QuicConsumedData consumed = quic_stream_->WriteMemSlices(
+          absl::MakeSpan(&write.slice, 1), /*fin=*/false);
+      if (visitor_ && write.notify_completion) {
+        visitor_->OnWriteCompleted(length, consumed.bytes_consumed == length);
+      }
+    }
+  }
+  if (pending_writes_.empty()) {
+    flush_requested_ = false;
+  }
+  if (pending_writes_.empty() && fin_pending_) {
+    fin_pending_ = false;
+    SendFinOnCurrentThread();
+  }
+  UpdateCachedStateOnCurrentThread();
+}
+
+void WebTransportStreamImpl::DropPendingWritesOnCurrentThread() {
+  DCHECK(io_runner_->BelongsToCurrentThread());
+  fin_pending_ = false;
+  flush_requested_ = false;
+  while (!pending_writes_.empty()) {
+    const PendingWrite& write = pending_writes_.front();
+    const bool is_file = write.file != nullptr;
+    const size_t length = is_file ? static_cast<size_t>(write.file_length)
+                                  : write.slice.length();
+    const bool notify_completion = write.notify_completion;
+    pending_writes_.pop_front();
+    if (is_file) {
+      pending_file_writes_--;
+    } else {
+      pending_write_bytes_ -= length;
+    }
+    if (visitor_ && notify_completion) {
+      visitor_->OnWriteCompleted(length, false);
+    }
+  }
+  UpdateSendBufferBudgetOnCurrentThread();
+  cached_buffered_data_bytes_.store(0, std::memory_order_release);
+  cached_can_write_.store(false, std::memory_order_release);
+}
+
 void WebTransportStreamImpl::SetVisitor(
     owt::quic::WebTransportStreamInterface::Visitor* visitor) {
   visitor_ = visitor;
@@ -112,9 +751,14 @@ void WebTransportStreamImpl::SetVisitor(
 
 size_t WebTransportStreamImpl::Read(uint8_t* data, size_t length) {
   DCHECK_EQ(sizeof(uint8_t), sizeof(char));
+  TRACE_EVENT1(OWT_TRACE_CATEGORY, "WebTransportStreamImpl::Read", "length",
+               length);
   if (io_runner_->BelongsToCurrentThread()) {
     auto read_result = stream_->Read(reinterpret_cast<char*>(data), length);
+    OnBytesConsumed(read_result.bytes_read);
     // TODO: FIN is not handled.
+    cached_readable_bytes_.store(stream_->ReadableBytes(),
+                                 std::memory_order_release);
     return read_result.bytes_read;
   }
   size_t result = 0;
@@ -129,10 +773,7 @@ size_t WebTransportStreamImpl::Read(uint8_t* data, size_t length) {
               event->Signal();
               return;
             }
-            auto read_result =
-                stream->stream_->Read(reinterpret_cast<char*>(data), length);
-            // TODO: FIN is not handled.
-            result = read_result.bytes_read;
+            result = stream->Read(data, length);
             event->Signal();
           },
           weak_factory_.GetWeakPtr(), base::Unretained(data), std::ref(length),
@@ -141,35 +782,143 @@ size_t WebTransportStreamImpl::Read(uint8_t* data, size_t length) {
   return result;
 }
 
+void WebTransportStreamImpl::SetPushModeEnabled(bool enabled) {
+  if (io_runner_->BelongsToCurrentThread()) {
+    SetPushModeEnabledOnCurrentThread(enabled);
+    return;
+  }
+  io_runner_->PostTask(
+      FROM_HERE,
+      base::BindOnce(&WebTransportStreamImpl::SetPushModeEnabledOnCurrentThread,
+                     weak_factory_.GetWeakPtr(), enabled));
+}
+
+void WebTransportStreamImpl::SetPushModeEnabledOnCurrentThread(bool enabled) {
+  DCHECK(io_runner_->BelongsToCurrentThread());
+  push_mode_enabled_ = enabled;
+  if (push_mode_enabled_) {
+    DeliverReadableDataOnCurrentThread();
+  }
+}
+
+void WebTransportStreamImpl::DeliverReadableDataOnCurrentThread() {
+  DCHECK(io_runner_->BelongsToCurrentThread());
+  TRACE_EVENT0(OWT_TRACE_CATEGORY,
+               "WebTransportStreamImpl::DeliverReadableData");
+  while (push_mode_enabled_ && visitor_ && !fin_delivered_) {
+    const size_t readable = stream_->ReadableBytes();
+    if (read_buffer_.size() < readable) {
+      read_buffer_.resize(readable);
+    }
+    auto read_result =
+        stream_->Read(reinterpret_cast<char*>(read_buffer_.data()), readable);
+    if (read_result.bytes_read == 0 && !read_result.fin) {
+      break;
+    }
+    OnBytesConsumed(read_result.bytes_read);
+    fin_delivered_ = read_result.fin;
+    visitor_->OnDataReceived(read_buffer_.data(), read_result.bytes_read,
+                             read_result.fin);
+    if (fin_delivered_) {
+      visitor_->OnFinRead();
+    }
+  }
+  cached_readable_bytes_.store(stream_->ReadableBytes(),
+                               std::memory_order_release);
+}
+
+void WebTransportStreamImpl::SetReceiveRing(StreamReceiveRing* ring,
+                                            size_t fill_watermark) {
+  if (io_runner_->BelongsToCurrentThread()) {
+    SetReceiveRingOnCurrentThread(ring, fill_watermark);
+    return;
+  }
+  io_runner_->PostTask(
+      FROM_HERE,
+      base::BindOnce(&WebTransportStreamImpl::SetReceiveRingOnCurrentThread,
+                     weak_factory_.GetWeakPtr(), base::Unretained(ring),
+                     fill_watermark));
+}
+
+void WebTransportStreamImpl::SetReceiveRingOnCurrentThread(
+    StreamReceiveRing* ring,
+    size_t fill_watermark) {
+  DCHECK(io_runner_->BelongsToCurrentThread());
+  DCHECK(!ring || ring->capacity() > 0);
+  receive_ring_ = ring;
+  // A watermark above the capacity could never be reached.
+  receive_ring_watermark_ =
+      ring ? std::clamp<size_t>(fill_watermark, 1, ring->capacity()) : 0;
+  FillReceiveRingOnCurrentThread();
+}
+
+void WebTransportStreamImpl::ResumeReceive() {
+  if (io_runner_->BelongsToCurrentThread()) {
+    FillReceiveRingOnCurrentThread();
+    return;
+  }
+  io_runner_->PostTask(
+      FROM_HERE,
+      base::BindOnce(&WebTransportStreamImpl::FillReceiveRingOnCurrentThread,
+                     weak_factory_.GetWeakPtr()));
+}
+
+void WebTransportStreamImpl::FillReceiveRingOnCurrentThread() {
+  DCHECK(io_runner_->BelongsToCurrentThread());
+  if (!receive_ring_ || !stream_ || fin_delivered_) {
+    return;
+  }
+  TRACE_EVENT0(OWT_TRACE_CATEGORY, "WebTransportStreamImpl::FillReceiveRing");
+  // The consumer may read concurrently, so the fill level is computed from
+  // what's written here, which is an upper bound of it.
+  const size_t filled_before = receive_ring_->ReadableBytes();
+  size_t written = 0;
+  while (!fin_delivered_) {
+    size_t region_length = 0;
+    uint8_t* region = receive_ring_->GetWriteRegion(&region_length);
+    const size_t readable = stream_->ReadableBytes();
+    if (readable > 0 && region_length == 0) {
+      if (receive_ring_->MarkProducerBlocked()) {
+        break;
+      }
+      continue;
+    }
+    // Data is read straight into the ring. Reading 0 bytes picks up a FIN
+    // without data.
+    auto read_result = stream_->Read(reinterpret_cast<char*>(region),
+                                     std::min(region_length, readable));
+    if (read_result.bytes_read == 0 && !read_result.fin) {
+      break;
+    }
+    receive_ring_->CommitWrite(read_result.bytes_read);
+    OnBytesConsumed(read_result.bytes_read);
+    written += read_result.bytes_read;
+    fin_delivered_ = read_result.fin;
+  }
+  cached_readable_bytes_.store(stream_->ReadableBytes(),
+                               std::memory_order_release);
+  if (!visitor_) {
+    return;
+  }
+  if (filled_before < receive_ring_watermark_ &&
+      filled_before + written >= receive_ring_watermark_) {
+    visitor_->OnCanRead();
+  }
+  if (fin_delivered_) {
+    visitor_->OnFinRead();
+  }
+}
+
 size_t WebTransportStreamImpl::ReadableBytes() const {
   if (io_runner_->BelongsToCurrentThread()) {
     return stream_->ReadableBytes();
   }
-  size_t result = 0;
-  base::WaitableEvent done(base::WaitableEvent::ResetPolicy::AUTOMATIC,
-                           base::WaitableEvent::InitialState::NOT_SIGNALED);
-  io_runner_->PostTask(FROM_HERE,
-                       base::BindOnce(
-                           [](base::WeakPtr<WebTransportStreamImpl> stream,
-                              size_t& result, base::WaitableEvent* event) {
-                             if (!stream) {
-                               event->Signal();
-                               return;
-                             }
-                             result = stream->stream_->ReadableBytes();
-                             event->Signal();
-                           },
-                           weak_factory_.GetWeakPtr(), std::ref(result),
-                           base::Unretained(&done)));
-  done.Wait();
-  return result;
+  return cached_readable_bytes_.load(std::memory_order_acquire);
 }
 
 void WebTransportStreamImpl::Close() {
   if (io_runner_->BelongsToCurrentThread()) {
-    if (!stream_->SendFin()) {
-      LOG(ERROR) << "Failed to send FIN.";
-    }
+    SendFinOnCurrentThread();
     return;
   }
   base::WaitableEvent done(base::WaitableEvent::ResetPolicy::AUTOMATIC,
@@ -182,70 +931,202 @@ void WebTransportStreamImpl::Close() {
                          event->Signal();
                          return;
                        }
-                       if (!stream->stream_->SendFin()) {
-                         LOG(ERROR) << "Failed to send FIN.";
-                       }
+                       stream->SendFinOnCurrentThread();
                        event->Signal();
                      },
                      weak_factory_.GetWeakPtr(), base::Unretained(&done)));
   done.Wait();
 }
 
+void WebTransportStreamImpl::SendFinOnCurrentThread() {
+  DCHECK(io_runner_->BelongsToCurrentThread());
+  if (!pending_writes_.empty()) {
+    // FIN is sent after all pending writes are flushed.
+    fin_pending_ = true;
+    FlushPendingWritesOnCurrentThread();
+    return;
+  }
+  if (!stream_->SendFin()) {
+    LOG(ERROR) << "Failed to send FIN.";
+  }
+  UpdateCachedStateOnCurrentThread();
+}
+
+void WebTransportStreamImpl::Reset(uint8_t error_code) {
+  if (io_runner_->BelongsToCurrentThread()) {
+    ResetOnCurrentThread(error_code);
+    return;
+  }
+  io_runner_->PostTask(
+      FROM_HERE, base::BindOnce(&WebTransportStreamImpl::ResetOnCurrentThread,
+                                weak_factory_.GetWeakPtr(), error_code));
+}
+
+void WebTransportStreamImpl::ResetOnCurrentThread(uint8_t error_code) {
+  DCHECK(io_runner_->BelongsToCurrentThread());
+  if (!stream_ || write_side_closed_) {
+    return;
+  }
+  write_side_closed_ = true;
+  DropPendingWritesOnCurrentThread();
+  stream_->ResetWithUserCode(error_code);
+  UpdateCachedStateOnCurrentThread();
+}
+
+void WebTransportStreamImpl::StopSending(uint8_t error_code) {
+  if (io_runner_->BelongsToCurrentThread()) {
+    StopSendingOnCurrentThread(error_code);
+    return;
+  }
+  io_runner_->PostTask(
+      FROM_HERE,
+      base::BindOnce(&WebTransportStreamImpl::StopSendingOnCurrentThread,
+                     weak_factory_.GetWeakPtr(), error_code));
+}
+
+void WebTransportStreamImpl::StopSendingOnCurrentThread(uint8_t error_code) {
+  DCHECK(io_runner_->BelongsToCurrentThread());
+  if (!stream_) {
+    return;
+  }
+  stream_->SendStopSending(error_code);
+  UpdateCachedStateOnCurrentThread();
+}
+
+void WebTransportStreamImpl::SetSendDeadline(uint32_t timeout_ms,
+                                             uint8_t error_code) {
+  if (io_runner_->BelongsToCurrentThread()) {
+    SetSendDeadlineOnCurrentThread(timeout_ms, error_code);
+    return;
+  }
+  io_runner_->PostTask(
+      FROM_HERE,
+      base::BindOnce(&WebTransportStreamImpl::SetSendDeadlineOnCurrentThread,
+                     weak_factory_.GetWeakPtr(), timeout_ms, error_code));
+}
+
+void WebTransportStreamImpl::SetSendDeadlineOnCurrentThread(
+    uint32_t timeout_ms,
+    uint8_t error_code) {
+  DCHECK(io_runner_->BelongsToCurrentThread());
+  send_deadline_id_++;
+  if (timeout_ms == 0 || write_side_closed_ || write_side_acknowledged_) {
+    return;
+  }
+  io_runner_->PostDelayedTask(
+      FROM_HERE,
+      base::BindOnce(&WebTransportStreamImpl::OnSendDeadlineExpired,
+                     weak_factory_.GetWeakPtr(), send_deadline_id_,
+                     error_code),
+      base::Milliseconds(timeout_ms));
+}
+
+void WebTransportStreamImpl::OnSendDeadlineExpired(uint64_t deadline_id,
+                                                   uint8_t error_code) {
+  DCHECK(io_runner_->BelongsToCurrentThread());
+  if (deadline_id != send_deadline_id_ || !stream_ || write_side_closed_ ||
+      write_side_acknowledged_) {
+    return;
+  }
+  // Posted tasks are not covered by the session's timers.
+  SessionCpuAccount::ScopedIoTimer timer(cpu_account_);
+  TRACE_EVENT1(OWT_TRACE_CATEGORY,
+               "WebTransportStreamImpl::OnSendDeadlineExpired", "buffered",
+               BufferedDataBytes());
+  // Resetting stops retransmission of data not acknowledged yet.
+  ResetOnCurrentThread(error_code);
+  if (visitor_) {
+    visitor_->OnSendDeadlineExpired();
+  }
+}
+
 uint64_t WebTransportStreamImpl::BufferedDataBytes() const {
   if (io_runner_->BelongsToCurrentThread()) {
-    return quic_stream_->BufferedDataBytes();
+    return quic_stream_->BufferedDataBytes() + pending_write_bytes_;
   }
-  uint64_t result = 0;
-  base::WaitableEvent done(base::WaitableEvent::ResetPolicy::AUTOMATIC,
-                           base::WaitableEvent::InitialState::NOT_SIGNALED);
-  io_runner_->PostTask(FROM_HERE,
-                       base::BindOnce(
-                           [](base::WeakPtr<WebTransportStreamImpl> stream,
-                              uint64_t& result, base::WaitableEvent* event) {
-                             if (!stream) {
-                               event->Signal();
-                               return;
-                             }
-                             result = stream->quic_stream_->BufferedDataBytes();
-                             event->Signal();
-                           },
-                           weak_factory_.GetWeakPtr(), std::ref(result),
-                           base::Unretained(&done)));
-  done.Wait();
-  return result;
+  return cached_buffered_data_bytes_.load(std::memory_order_acquire);
+}
+
+void WebTransportStreamImpl::AddMemoryUsageOnCurrentThread(
+    MemoryUsage* usage) const {
+  DCHECK(io_runner_->BelongsToCurrentThread());
+  usage->streams++;
+  usage->object_bytes += sizeof(*this);
+  usage->stream_send_buffer_bytes += pending_write_bytes_;
+  if (!quic_stream_) {
+    return;
+  }
+  // The most derived type of `quic_stream_` is unknown, so only its base is
+  // counted.
+  usage->object_bytes += sizeof(::quic::QuicStream);
+  usage->stream_send_buffer_bytes += quic_stream_->BufferedDataBytes();
+  usage->stream_receive_buffer_bytes += stream_->ReadableBytes();
 }
 
 bool WebTransportStreamImpl::CanWrite() const {
   if (io_runner_->BelongsToCurrentThread()) {
-    return stream_->CanWrite();
+    // Pending writes kept for coalescing don't block new writes.
+    return !write_side_closed_ && !above_high_watermark_ &&
+           !IsSendBufferBudgetExceeded() &&
+           (pending_writes_.empty() || coalescing_threshold_ > 0) &&
+           stream_->CanWrite();
   }
-  bool result = false;
-  base::WaitableEvent done(base::WaitableEvent::ResetPolicy::AUTOMATIC,
-                           base::WaitableEvent::InitialState::NOT_SIGNALED);
-  io_runner_->PostTask(FROM_HERE,
-                       base::BindOnce(
-                           [](base::WeakPtr<WebTransportStreamImpl> stream,
-                              bool& result, base::WaitableEvent* event) {
-                             if (!stream) {
-                               event->Signal();
-                               return;
-                             }
-                             result = stream->stream_->CanWrite();
-                             event->Signal();
-                           },
-                           weak_factory_.GetWeakPtr(), std::ref(result),
-                           base::Unretained(&done)));
-  done.Wait();
-  return result;
+  return cached_can_write_.load(std::memory_order_acquire);
+}
+
+bool WebTransportStreamImpl::IsSendBufferBudgetExceeded() const {
+  DCHECK(io_runner_->BelongsToCurrentThread());
+  return send_buffer_budget_ && send_buffer_budget_->IsExceeded();
+}
+
+void WebTransportStreamImpl::UpdateSendBufferBudgetOnCurrentThread() {
+  DCHECK(io_runner_->BelongsToCurrentThread());
+  if (!send_buffer_budget_) {
+    return;
+  }
+  // Data buffered by `quic_stream_` is released after the write side is
+  // closed.
+  const uint64_t buffered = write_side_closed_ ? 0 : BufferedDataBytes();
+  if (buffered > budget_reported_bytes_) {
+    send_buffer_budget_->Add(buffered - budget_reported_bytes_);
+  } else {
+    send_buffer_budget_->Remove(budget_reported_bytes_ - buffered);
+  }
+  budget_reported_bytes_ = buffered;
+}
+
+void WebTransportStreamImpl::UpdateCachedStateOnCurrentThread() {
+  DCHECK(io_runner_->BelongsToCurrentThread());
+  UpdateSendBufferBudgetOnCurrentThread();
+  CheckBufferWatermarksOnCurrentThread();
+  cached_readable_bytes_.store(ReadableBytes(), std::memory_order_release);
+  cached_buffered_data_bytes_.store(BufferedDataBytes(),
+                                    std::memory_order_release);
+  cached_can_write_.store(CanWrite(), std::memory_order_release);
 }
 
 void WebTransportStreamImpl::OnCanRead() {
+  cached_readable_bytes_.store(stream_->ReadableBytes(),
+                               std::memory_order_release);
+  if (receive_ring_) {
+    FillReceiveRingOnCurrentThread();
+    return;
+  }
+  if (push_mode_enabled_) {
+    DeliverReadableDataOnCurrentThread();
+    return;
+  }
   if (visitor_) {
     visitor_->OnCanRead();
   }
 }
 
 void WebTransportStreamImpl::OnCanWrite() {
+  MaybeFlushPendingWritesOnCurrentThread();
+  UpdateCachedStateOnCurrentThread();
+  if (!CanWrite()) {
+    return;
+  }
   if (visitor_) {
     visitor_->OnCanWrite();
   }
@@ -254,13 +1135,56 @@ void WebTransportStreamImpl::OnCanWrite() {
 void WebTransportStreamImpl::OnResetStreamReceived(
     ::quic::WebTransportStreamError error) {
   write_side_closed_ = true;
+  DropPendingWritesOnCurrentThread();
+  if (visitor_) {
+    visitor_->OnResetStreamReceived(error);
+  }
+}
+
+void WebTransportStreamImpl::OnWriteSideInDataRecvdState() {
+  // All data is acknowledged by remote side.
+  write_side_acknowledged_ = true;
+  UpdateCachedStateOnCurrentThread();
 }
 
 void WebTransportStreamImpl::OnStopSendingReceived(
-    ::quic::WebTransportStreamError error) {}
+    ::quic::WebTransportStreamError error) {
+  // QUIC stream resets its write side in response.
+  write_side_closed_ = true;
+  DropPendingWritesOnCurrentThread();
+  UpdateCachedStateOnCurrentThread();
+  if (visitor_) {
+    visitor_->OnStopSendingReceived(error);
+  }
+}
+
+void WebTransportStreamImpl::OnSendBufferBudgetAvailable() {
+  DCHECK(io_runner_->BelongsToCurrentThread());
+  cached_can_write_.store(CanWrite(), std::memory_order_release);
+  if (visitor_ && CanWrite()) {
+    visitor_->OnCanWrite();
+  }
+}
+
+void WebTransportStreamImpl::OnQuicStreamDestroyed() {
+  DCHECK(io_runner_->BelongsToCurrentThread());
+  write_side_closed_ = true;
+  DropPendingWritesOnCurrentThread();
+  stream_ = nullptr;
+  quic_stream_ = nullptr;
+  cached_readable_bytes_.store(0, std::memory_order_release);
+  if (visitor_) {
+    visitor_->OnClosed();
+  }
+  // `this` may be deleted by `delegate_`.
+  if (delegate_) {
+    delegate_->OnStreamClosed(id_);
+  }
+}
 
 void WebTransportStreamImpl::OnSessionClosed() {
   write_side_closed_ = true;
+  DropPendingWritesOnCurrentThread();
 }
 
 }  // namespace quic
@@ -15,26 +15,49 @@
 #ifndef OWT_QUIC_WEB_TRANSPORT_WEB_TRANSPORT_STREAM_IMPL_H_
 #define OWT_QUIC_WEB_TRANSPORT_WEB_TRANSPORT_STREAM_IMPL_H_
 
+#include <atomic>
+#include <deque>
+#include <vector>
+#include "base/memory/scoped_refptr.h"
 #include "base/memory/weak_ptr.h"
+#include "base/task/sequenced_task_runner.h"
 #include "base/task/single_thread_task_runner.h"
+#include "base/time/time.h"
 #include "base/threading/thread_checker.h"
 #include "impl/http3_server_stream.h"
+#include "impl/object_pool.h"
+#include "impl/receive_window_tuner.h"
+#include "impl/send_buffer_budget.h"
+#include "impl/session_cpu_account.h"
+#include "net/base/io_buffer.h"
 #include "net/third_party/quiche/src/quic/core/http/quic_spdy_stream.h"
 #include "net/third_party/quiche/src/quic/core/web_transport_interface.h"
+#include "net/third_party/quiche/src/quic/platform/api/quic_mem_slice.h"
 #include "owt/quic/web_transport_stream_interface.h"
 
 namespace owt {
 namespace quic {
 
 // WebTransportStreamImpl is a proxy for ::quic::WebTransportStream. All calls
-// to ::quic::WebTransportStream run in runner_.
+// to ::quic::WebTransportStream run in runner_. Streams are created at high
+// rates, so they are pooled.
 class WebTransportStreamImpl : public WebTransportStreamInterface,
-                               public ::quic::WebTransportStreamVisitor {
+                               public ::quic::WebTransportStreamVisitor,
+                               public PooledObject {
  public:
+  class Delegate {
+   public:
+    virtual ~Delegate() = default;
+    // Called on IO thread when both directions of the stream are finished,
+    // and the QUIC stream is destroyed. Delegate may delete the stream.
+    virtual void OnStreamClosed(uint32_t id) = 0;
+  };
+
   explicit WebTransportStreamImpl(::quic::WebTransportStream* stream,
                                   ::quic::QuicStream* quic_stream,
                                   base::SingleThreadTaskRunner* io_runner,
-                                  base::SingleThreadTaskRunner* event_runner);
+                                  base::SingleThreadTaskRunner* event_runner,
+                                  SendBufferBudget* send_buffer_budget);
   ~WebTransportStreamImpl() override;
 
   // Overrides WebTransportStreamInterface.
@@ -42,34 +65,194 @@ class WebTransportStreamImpl : public WebTransportStreamInterface,
       owt::quic::WebTransportStreamInterface::Visitor* visitor) override;
   uint32_t Id() const override;
   size_t Write(const uint8_t* data, size_t length) override;
+  void WriteAsync(const uint8_t* data, size_t length) override;
+  void WriteAsync(uint8_t* data,
+                  size_t length,
+                  BufferReleaseCallback release,
+                  void* release_context) override;
+  void Writev(const IoVec* iov, size_t iovcnt, bool fin) override;
+  void WriteFile(int fd, uint64_t offset, uint64_t length, bool fin) override;
+  void SetWriteCoalescing(size_t threshold, uint32_t delay_ms) override;
+  void Flush() override;
+  void SetPriority(uint8_t urgency) override;
+  void SetBufferWatermarks(uint64_t high, uint64_t low) override;
   size_t Read(uint8_t* data, size_t length) override;
+  void SetPushModeEnabled(bool enabled) override;
+  void SetReceiveRing(StreamReceiveRing* ring, size_t fill_watermark) override;
+  void ResumeReceive() override;
   size_t ReadableBytes() const override;
   void Close() override;
+  void Reset(uint8_t error_code) override;
+  void StopSending(uint8_t error_code) override;
+  void SetSendDeadline(uint32_t timeout_ms, uint8_t error_code) override;
   uint64_t BufferedDataBytes() const override;
   bool CanWrite() const override;
 
+  // Same as WriteAsync, but takes a QuicMemSlice, which may share its buffer
+  // with other slices.
+  void WriteMemSliceAsync(::quic::QuicMemSlice slice, bool fin);
+  // `delegate` could be nullptr.
+  void SetDelegate(Delegate* delegate);
+  // Writes are accounted to `account`, which could be nullptr, and it must
+  // outlive this stream.
+  void SetCpuAccount(SessionCpuAccount* account);
+  // Reports data read from this stream to `tuner`, which could be nullptr,
+  // and it must outlive this stream.
+  void SetReceiveWindowTuner(ReceiveWindowTuner* tuner);
   void OnSessionClosed();
+  // Called when the QUIC stream associated is destroyed.
+  void OnQuicStreamDestroyed();
+  // Called by session when its send buffer budget is available again.
+  void OnSendBufferBudgetAvailable();
+  // Adds memory held by this stream to `usage`. Called on IO thread.
+  void AddMemoryUsageOnCurrentThread(MemoryUsage* usage) const;
 
   // Overrides ::quic::WebTransportStreamVisitor.
   void OnCanRead() override;
   void OnCanWrite() override;
   void OnResetStreamReceived(::quic::WebTransportStreamError error) override;
   void OnStopSendingReceived(::quic::WebTransportStreamError error) override;
-  void OnWriteSideInDataRecvdState() override {}
+  void OnWriteSideInDataRecvdState() override;
 
  private:
+  class FileSource;
+  struct PendingWrite {
+    ::quic::QuicMemSlice slice;
+    // Whether Visitor::OnWriteCompleted should be called for this write. It's
+    // false for data written by Write().
+    bool notify_completion;
+    // Set for WriteFile. `slice` is empty, data is read from `file` in chunks
+    // on `file_task_runner_`, and written when the stream is writable.
+    scoped_refptr<FileSource> file;
+    // Identifies the write in replies of reads.
+    uint64_t file_write_id = 0;
+    uint64_t file_offset = 0;
+    uint64_t file_remaining = 0;
+    uint64_t file_length = 0;
+    // The chunk at `file_offset` once it's read, or nullptr.
+    scoped_refptr<net::IOBuffer> file_chunk;
+    bool file_read_pending = false;
+  };
+
   void OnCanReadOnCurrentThread();
+  // Called after `bytes` are read from `stream_`.
+  void OnBytesConsumed(size_t bytes);
   void OnCanWriteOnCurrentThread();
+  bool WriteOnCurrentThread(const uint8_t* data, size_t length);
+  ::quic::QuicBufferAllocator* GetSendBufferAllocator() const;
+  void WriteAsyncOnCurrentThread(::quic::QuicMemSlice slice, bool fin);
+  void EnqueuePendingWriteOnCurrentThread(::quic::QuicMemSlice slice,
+                                          bool notify_completion);
+  void WriteFileOnCurrentThread(int fd,
+                                uint64_t offset,
+                                uint64_t length,
+                                bool fin);
+  // Starts reading the next chunk of `write` on `file_task_runner_`, unless
+  // it's read or being read.
+  void ReadFileChunkOnCurrentThread(PendingWrite* write);
+  void OnFileChunkRead(uint64_t file_write_id,
+                       scoped_refptr<net::IOBuffer> chunk,
+                       bool success);
+  // Writes the chunk read for `write` to the QUIC stream. Returns false if the
+  // QUIC stream doesn't take all of it.
+  bool WriteFileChunkOnCurrentThread(PendingWrite* write);
+  // Flushes pending writes unless they are kept for coalescing.
+  void MaybeFlushPendingWritesOnCurrentThread();
+  void OnCoalescingDelayExpired();
+  void SetWriteCoalescingOnCurrentThread(size_t threshold, uint32_t delay_ms);
+  void FlushOnCurrentThread();
+  void SetPriorityOnCurrentThread(uint8_t urgency);
+  void SetBufferWatermarksOnCurrentThread(uint64_t high, uint64_t low);
+  // Fires OnBufferHigh or OnBufferLow if buffered data crosses watermarks.
+  void CheckBufferWatermarksOnCurrentThread();
+  // Writes data in `pending_writes_` until the stream is blocked.
+  void FlushPendingWritesOnCurrentThread();
+  // Drops all data in `pending_writes_`. Called when write side is closed.
+  void DropPendingWritesOnCurrentThread();
+  void SendFinOnCurrentThread();
+  void ResetOnCurrentThread(uint8_t error_code);
+  void StopSendingOnCurrentThread(uint8_t error_code);
+  void SetSendDeadlineOnCurrentThread(uint32_t timeout_ms, uint8_t error_code);
+  void OnSendDeadlineExpired(uint64_t deadline_id, uint8_t error_code);
+  // Reports changes of buffered data to `send_buffer_budget_`.
+  void UpdateSendBufferBudgetOnCurrentThread();
+  bool IsSendBufferBudgetExceeded() const;
+  // Publishes stream state to `cached_*` members.
+  void UpdateCachedStateOnCurrentThread();
+  void SetPushModeEnabledOnCurrentThread(bool enabled);
+  // Reads all readable data and delivers it to `visitor_`.
+  void DeliverReadableDataOnCurrentThread();
+  void SetReceiveRingOnCurrentThread(StreamReceiveRing* ring,
+                                     size_t fill_watermark);
+  // Copies readable data into `receive_ring_` until it's full.
+  void FillReceiveRingOnCurrentThread();
 
   ::quic::WebTransportStream* stream_;
   // `stream_` is supposed to be an instance of `WebTransportStreamAdapter`,
   // which holds a pointer to `QuicStream`. However, the `QuicStream` associated
   // is not public, so we maintain a pointer to `QuicStream` here.
   ::quic::QuicStream* quic_stream_;
+  // Stream ID is kept, since `stream_` is destroyed before this object.
+  uint32_t id_;
   base::SingleThreadTaskRunner* io_runner_;
   base::SingleThreadTaskRunner* event_runner_;
   owt::quic::WebTransportStreamInterface::Visitor* visitor_;
+  Delegate* delegate_;
+  SessionCpuAccount* cpu_account_;
+  ReceiveWindowTuner* receive_window_tuner_;
   bool write_side_closed_;
+  // All data and FIN are acknowledged by remote side.
+  bool write_side_acknowledged_;
+  // Increased by every SetSendDeadline, so tasks of replaced deadlines are
+  // ignored. Only accessed on IO thread.
+  uint64_t send_deadline_id_;
+  // Data queued by WriteAsync or kept for coalescing, but not accepted by
+  // `stream_` yet. Only accessed on IO thread.
+  std::deque<PendingWrite> pending_writes_;
+  // Bytes of slices in `pending_writes_`. Data of files is not in memory, so
+  // it's not counted.
+  uint64_t pending_write_bytes_;
+  // Number of WriteFile writes in `pending_writes_`. They are never kept for
+  // coalescing.
+  size_t pending_file_writes_;
+  uint64_t next_file_write_id_;
+  // Reads files for WriteFile, since reads may block. Created by the first
+  // WriteFile.
+  scoped_refptr<base::SequencedTaskRunner> file_task_runner_;
+  // Close() is called when there are pending writes. FIN will be sent after
+  // all pending writes are flushed.
+  bool fin_pending_;
+  // Write coalescing settings. Coalescing is disabled when
+  // `coalescing_threshold_` is 0. Only accessed on IO thread.
+  size_t coalescing_threshold_;
+  base::TimeDelta coalescing_delay_;
+  bool coalescing_flush_scheduled_;
+  // Flush() is called or coalescing delay expired, pending writes should be
+  // written regardless of coalescing threshold.
+  bool flush_requested_;
+  // Watermarks of buffered data. Only accessed on IO thread.
+  uint64_t high_watermark_;
+  uint64_t low_watermark_;
+  bool above_high_watermark_;
+  // Budget of the session this stream belongs to. It could be nullptr, and it
+  // outlives this stream. Only accessed on IO thread.
+  SendBufferBudget* send_buffer_budget_;
+  // Bytes added to `send_buffer_budget_` by this stream.
+  uint64_t budget_reported_bytes_;
+  // Only accessed on IO thread.
+  bool push_mode_enabled_;
+  bool fin_delivered_;
+  // A buffer reused for reading data in push mode.
+  std::vector<uint8_t> read_buffer_;
+  // Registered by SetReceiveRing, owned by the application. Only accessed on
+  // IO thread.
+  StreamReceiveRing* receive_ring_;
+  size_t receive_ring_watermark_;
+  // Stream state published by IO thread. ReadableBytes, BufferedDataBytes and
+  // CanWrite called on other threads return these values without blocking.
+  std::atomic<size_t> cached_readable_bytes_;
+  std::atomic<uint64_t> cached_buffered_data_bytes_;
+  std::atomic<bool> cached_can_write_;
   base::WeakPtrFactory<WebTransportStreamImpl> weak_factory_{this};
 };
 }  // namespace quic